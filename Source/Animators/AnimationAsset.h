@@ -43,6 +43,8 @@ namespace Enigma::Animators
         Engine::FactoryDesc& factoryDesc() { return m_factoryDesc; }
 
         virtual float getAnimationLengthInSecond() = 0;
+        /** approximate data size in bytes, used by repository retention cache budget */
+        virtual size_t footprintBytes() const { return sizeof(AnimationAsset); }
 
     protected:
         AnimationAssetId m_id;
@@ -9,6 +9,7 @@
 #include "Frameworks/CommandBus.h"
 #include "Frameworks/QueryDispatcher.h"
 #include "Frameworks/EventPublisher.h"
+#include "Frameworks/AssetRetentionCache.h"
 #include "Platforms/MemoryMacro.h"
 #include "Platforms/PlatformLayer.h"
 #include <cassert>
@@ -20,6 +21,8 @@ DEFINE_RTTI(Animators, AnimationAssetRepository, ISystemService);
 
 using error = std::error_code;
 
+static const std::string RETENTION_CATEGORY = "animation";
+
 AnimationAssetRepository::AnimationAssetRepository(ServiceManager* srv_manager, const std::shared_ptr<AnimationAssetStoreMapper>& store_mapper) : ISystemService(srv_manager)
 {
     m_storeMapper = store_mapper;
@@ -55,6 +58,7 @@ ServiceResult AnimationAssetRepository::onInit()
 ServiceResult AnimationAssetRepository::onTerm()
 {
     assert(m_storeMapper);
+    if (m_retentionCache) m_retentionCache->releaseCategory(RETENTION_CATEGORY);
     QueryDispatcher::unsubscribe(typeid(QueryAnimationAsset), m_queryAnimationAsset);
     m_queryAnimationAsset = nullptr;
     QueryDispatcher::unsubscribe(typeid(RequestAnimationAssetCreation), m_requestAnimationAssetCreation);
@@ -90,13 +94,29 @@ std::shared_ptr<AnimationAsset> AnimationAssetRepository::queryAnimationAsset(co
     if (!hasAnimationAsset(id)) return nullptr;
     std::lock_guard lock(m_animationAssetLock);
     const auto& it = m_animationAssets.find(id);
-    if ((it != m_animationAssets.end()) && (!it->second.expired())) return it->second.lock();
+    if (it != m_animationAssets.end())
+    {
+        if (auto animation = it->second.lock())
+        {
+            if (m_retentionCache)
+            {
+                m_retentionCache->recordHit(RETENTION_CATEGORY);
+                retainAnimationAsset(id, animation);
+            }
+            return animation;
+        }
+    }
     assert(m_factory);
     const auto dto = m_storeMapper->queryAnimationAsset(id);
     assert(dto.has_value());
     auto animation = m_factory->constitute(id, dto.value(), true);
     assert(animation);
     m_animationAssets.insert_or_assign(id, animation);
+    if (m_retentionCache)
+    {
+        m_retentionCache->recordMiss(RETENTION_CATEGORY);
+        retainAnimationAsset(id, animation);
+    }
     return animation;
 }
 
@@ -105,6 +125,7 @@ void AnimationAssetRepository::removeAnimationAsset(const AnimationAssetId& id)
     if (!hasAnimationAsset(id)) return;
     std::lock_guard locker{ m_animationAssetLock };
     m_animationAssets.erase(id);
+    if (m_retentionCache) m_retentionCache->release(RETENTION_CATEGORY, id.name());
     error er = m_storeMapper->removeAnimationAsset(id);
     if (er)
     {
@@ -195,6 +216,13 @@ void AnimationAssetRepository::putAnimationAsset(const ICommandPtr& c)
     putAnimationAsset(cmd->id(), cmd->animation());
 }
 
+void AnimationAssetRepository::retainAnimationAsset(const AnimationAssetId& id, const std::shared_ptr<AnimationAsset>& asset)
+{
+    if ((!m_retentionCache) || (!asset)) return;
+    if (m_retentionCache->touch(RETENTION_CATEGORY, id.name())) return;
+    m_retentionCache->retain(RETENTION_CATEGORY, id.name(), asset, asset->footprintBytes());
+}
+
 void AnimationAssetRepository::dumpRetainedAnimation()
 {
     Platforms::Debug::Printf("dump retained animation asset\n");
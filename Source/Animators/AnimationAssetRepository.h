@@ -15,6 +15,11 @@
 #include "AnimatorFactoryDelegate.h"
 #include <mutex>
 
+namespace Enigma::Frameworks
+{
+    class AssetRetentionCache;
+}
+
 namespace Enigma::Animators
 {
     class AnimationAssetStoreMapper;
@@ -36,6 +41,9 @@ namespace Enigma::Animators
 
         void registerAnimationAssetFactory(const std::string& rtti_name, const AnimationAssetCreator& creator, const AnimationAssetConstitutor& constitutor);
 
+        /** optional, loaded animation assets are retained in cache (by footprint bytes) after all owners released */
+        void retentionCache(const std::shared_ptr<Frameworks::AssetRetentionCache>& cache) { m_retentionCache = cache; }
+
         bool hasAnimationAsset(const AnimationAssetId& id);
         std::shared_ptr<AnimationAsset> queryAnimationAsset(const AnimationAssetId& id);
         void removeAnimationAsset(const AnimationAssetId& id);
@@ -48,6 +56,7 @@ namespace Enigma::Animators
         void removeAnimationAsset(const Frameworks::ICommandPtr& c);
         void putAnimationAsset(const Frameworks::ICommandPtr& c);
 
+        void retainAnimationAsset(const AnimationAssetId& id, const std::shared_ptr<AnimationAsset>& asset);
         void dumpRetainedAnimation();
 
     protected:
@@ -56,6 +65,7 @@ namespace Enigma::Animators
         //! ADR: 在 repository 中，map 是存放已生成 asset 的 cache, 不擁有asset, 所以改用 weak_ptr
         std::unordered_map<AnimationAssetId, std::weak_ptr<AnimationAsset>, AnimationAssetId::hash> m_animationAssets;
         std::recursive_mutex m_animationAssetLock;
+        std::shared_ptr<Frameworks::AssetRetentionCache> m_retentionCache;
 
         Frameworks::QuerySubscriberPtr m_queryAnimationAsset;
         Frameworks::QuerySubscriberPtr m_requestAnimationAssetCreation;
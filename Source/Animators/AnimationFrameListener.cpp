@@ -2,6 +2,7 @@
 #include "AnimatorErrors.h"
 #include "AnimatorCommands.h"
 #include "Frameworks/CommandBus.h"
+#include "Frameworks/FrameProfiler.h"
 #include "GameEngine/TimerService.h"
 #include <cassert>
 
@@ -19,6 +20,8 @@ AnimationFrameListener::AnimationFrameListener(ServiceManager* manager, const st
     m_repository = repository;
     m_timer = timer;
     m_needTick = false;
+    declareReadAccess(Engine::TimerService::GAME_TIMER_RESOURCE);
+    declareWriteAccess(ANIMATION_RESOURCE);
 }
 
 AnimationFrameListener::~AnimationFrameListener()
@@ -91,6 +94,7 @@ error AnimationFrameListener::removeListeningAnimator(const AnimatorId& animator
 bool AnimationFrameListener::updateAnimator(const std::unique_ptr<Timer>& timer)
 {
     if (!timer) return false;
+    PROFILE_ZONE("AnimationFrameListener::updateAnimator");
 
     bool all_res = false;
     ListeningList::iterator iter = m_listeningAnimators.begin();
@@ -24,6 +24,10 @@ namespace Enigma::Animators
     class AnimationFrameListener : public Frameworks::ISystemService
     {
         DECLARE_EN_RTTI;
+    public:
+        /// concurrent tick 時宣告的資源名稱, listening animators 及被更新的 primitives
+        static constexpr const char* ANIMATION_RESOURCE = "Animation";
+
     public:
         AnimationFrameListener(Frameworks::ServiceManager* manager, const std::shared_ptr<AnimatorRepository>& repository, const std::shared_ptr<Engine::TimerService>& timer);
         AnimationFrameListener(const AnimationFrameListener&) = delete;
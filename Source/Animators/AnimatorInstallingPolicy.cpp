@@ -13,7 +13,9 @@ error AnimatorInstallingPolicy::install(Frameworks::ServiceManager* service_mana
     assert(service_manager);
     auto repository = std::make_shared<AnimatorRepository>(service_manager, m_animatorStore);
     service_manager->registerSystemService(repository);
-    service_manager->registerSystemService(std::make_shared<AnimationAssetRepository>(service_manager, m_animationAssetStore));
+    auto asset_repository = std::make_shared<AnimationAssetRepository>(service_manager, m_animationAssetStore);
+    if (auto cache = service_manager->assetRetentionCache()) asset_repository->retentionCache(cache);
+    service_manager->registerSystemService(asset_repository);
     auto timer = service_manager->getSystemServiceAs<Engine::TimerService>();
     service_manager->registerSystemService(std::make_shared<AnimationFrameListener>(service_manager, repository, timer));
     return ErrorCode::ok;
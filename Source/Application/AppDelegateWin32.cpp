@@ -4,11 +4,14 @@
 #include "../GraphicAPIDx11/GraphicAPIDx11.h"
 #include "Controllers/GraphicMain.h"
 #include "FileSystem/FileSystem.h"
+#include "FileSystem/StdMountPath.h"
+#include "GraphicKernel/ShaderBinaryCache.h"
 #include "Renderer/RendererCommands.h"
 #include "Frameworks/CommandBus.h"
 #include "InputHandlers/MouseKeyButtons.h"
 #include <memory>
 #include <chrono>
+#include <filesystem>
 
 #define WM_MOUSEWHEEL_LEGACY 0x020A
 
@@ -87,6 +90,7 @@ void AppDelegate::initialize(Graphics::IGraphicAPI::APIVersion /*api_ver*/, Grap
     m_graphicMain->installFrameworks();
 
     menew Devices::GraphicAPIDx11(useAsyncDevice);
+    initializeShaderBinaryCache();
 
     // 這兩個函式從建構子搬來，因為，在建構子裡，子類別的virtual function table 還沒成立
     // 而Create 會 call 很多window message，這樣的 m_instance 並不會導到子類別的函式上
@@ -98,6 +102,18 @@ void AppDelegate::initialize(Graphics::IGraphicAPI::APIVersion /*api_ver*/, Grap
     installEngine();
 }
 
+void AppDelegate::initializeShaderBinaryCache()
+{
+    // compiled shader binary 存在執行目錄下, 第二次啟動不用重新 compile
+    auto cache_path = std::filesystem::current_path() / "ShaderCache";
+    std::error_code er;
+    std::filesystem::create_directories(cache_path, er);
+    if (er) return;
+    const std::string& path_id = Graphics::ShaderBinaryCache::getDefaultCachePathID();
+    FileSystem::FileSystem::instance()->addMountPath(std::make_shared<FileSystem::StdMountPath>(cache_path.string(), path_id));
+    Graphics::IGraphicAPI::instance()->setShaderBinaryCache(std::make_shared<Graphics::ShaderBinaryCache>(path_id));
+}
+
 void AppDelegate::registerMediaMountPaths(const std::string& media_path)
 {
     /*if (media_path.length() > 0)
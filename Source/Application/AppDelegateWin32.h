@@ -30,6 +30,8 @@ namespace Enigma::Application
         virtual void initialize(Graphics::IGraphicAPI::APIVersion api_ver, Graphics::IGraphicAPI::AsyncType useAsyncDevice,
             const std::string& log_filename = "");
         virtual void initializeMountPaths() {};
+        /** 預設把 compiled shader binary cache 掛在執行目錄的 ShaderCache 下, 不要 cache 的 app 可以覆寫成空的 */
+        virtual void initializeShaderBinaryCache();
 
         virtual void installEngine() = 0;
         virtual void registerMediaMountPaths(const std::string& media_path);
@@ -0,0 +1,197 @@
+﻿#include "AssetBlockCodec.h"
+#include "zlib.h"
+#include <cstring>
+#include <cstdint>
+
+using namespace Enigma::AssetPackage;
+
+static constexpr size_t LZ4_MIN_MATCH = 4;
+static constexpr size_t LZ4_LAST_LITERALS = 5;      // 最後 5 bytes 一定是 literal
+static constexpr size_t LZ4_MF_LIMIT = 12;          // 最後一個 match 要在結尾 12 bytes 之前開始
+static constexpr size_t LZ4_MAX_DISTANCE = 65535;
+static constexpr unsigned LZ4_HASH_LOG = 12;
+
+static inline std::uint32_t read32(const unsigned char* p)
+{
+    std::uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline unsigned hash4(std::uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+static inline unsigned char* writeLength(unsigned char* op, size_t length)
+{
+    while (length >= 255)
+    {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = static_cast<unsigned char>(length);
+    return op;
+}
+
+std::vector<unsigned char> AssetBlockCodec::compressBlock(AssetCodec codec, const unsigned char* src, size_t src_size)
+{
+    std::vector<unsigned char> dst;
+    if (src_size == 0) return dst;
+    if (codec == AssetCodec::lz4)
+    {
+        dst.resize(lz4CompressBound(src_size));
+        const size_t comp_size = lz4Compress(src, src_size, dst.data(), dst.size());
+        dst.resize(comp_size < src_size ? comp_size : 0);
+        return dst;
+    }
+    uLongf comp_size = compressBound(static_cast<uLong>(src_size));
+    dst.resize(comp_size);
+    if (compress(dst.data(), &comp_size, src, static_cast<uLong>(src_size)) != Z_OK) comp_size = 0;
+    dst.resize(comp_size < src_size ? comp_size : 0);
+    return dst;
+}
+
+bool AssetBlockCodec::decompressBlock(AssetCodec codec, const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_size)
+{
+    if (codec == AssetCodec::lz4) return lz4Decompress(src, src_size, dst, dst_size);
+    uLongf out_size = static_cast<uLongf>(dst_size);
+    if (uncompress(dst, &out_size, src, static_cast<uLong>(src_size)) != Z_OK) return false;
+    return out_size == dst_size;
+}
+
+bool AssetBlockCodec::decompressStoredBlock(AssetCodec codec, unsigned int stored_entry, const unsigned char* src, unsigned char* dst, size_t dst_size)
+{
+    const size_t src_size = stored_entry & ~STORED_RAW_FLAG;
+    if ((stored_entry & STORED_RAW_FLAG) == 0) return decompressBlock(codec, src, src_size, dst, dst_size);
+    if (src_size != dst_size) return false;
+    memcpy(dst, src, dst_size);
+    return true;
+}
+
+size_t AssetBlockCodec::lz4CompressBound(size_t src_size)
+{
+    return src_size + src_size / 255 + 16;
+}
+
+size_t AssetBlockCodec::lz4Compress(const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_capacity)
+{
+    if (dst_capacity < lz4CompressBound(src_size)) return 0;
+    std::vector<std::uint32_t> hash_table(static_cast<size_t>(1) << LZ4_HASH_LOG, 0);
+    const unsigned char* ip = src;
+    const unsigned char* anchor = src;
+    const unsigned char* const iend = src + src_size;
+    unsigned char* op = dst;
+    if (src_size > LZ4_MF_LIMIT)
+    {
+        const unsigned char* const mflimit = iend - LZ4_MF_LIMIT;
+        const unsigned char* const match_limit = iend - LZ4_LAST_LITERALS;
+        ip++;
+        while (ip < mflimit)
+        {
+            const std::uint32_t sequence = read32(ip);
+            const unsigned h = hash4(sequence);
+            const unsigned char* ref = src + hash_table[h];
+            hash_table[h] = static_cast<std::uint32_t>(ip - src);
+            if ((ref >= ip) || (static_cast<size_t>(ip - ref) > LZ4_MAX_DISTANCE) || (read32(ref) != sequence))
+            {
+                ip++;
+                continue;
+            }
+            // 往回延伸 match
+            while ((ip > anchor) && (ref > src) && (ip[-1] == ref[-1]))
+            {
+                ip--;
+                ref--;
+            }
+            const size_t literal_length = static_cast<size_t>(ip - anchor);
+            const unsigned char* match_end = ip + LZ4_MIN_MATCH;
+            const unsigned char* ref_end = ref + LZ4_MIN_MATCH;
+            while ((match_end < match_limit) && (*match_end == *ref_end))
+            {
+                match_end++;
+                ref_end++;
+            }
+            const size_t match_length = static_cast<size_t>(match_end - ip) - LZ4_MIN_MATCH;
+
+            unsigned char* token = op++;
+            *token = static_cast<unsigned char>((literal_length >= 15 ? 15 : literal_length) << 4);
+            if (literal_length >= 15) op = writeLength(op, literal_length - 15);
+            memcpy(op, anchor, literal_length);
+            op += literal_length;
+            const size_t distance = static_cast<size_t>(ip - ref);
+            *op++ = static_cast<unsigned char>(distance & 0xff);
+            *op++ = static_cast<unsigned char>(distance >> 8);
+            *token |= static_cast<unsigned char>(match_length >= 15 ? 15 : match_length);
+            if (match_length >= 15) op = writeLength(op, match_length - 15);
+
+            ip = match_end;
+            anchor = ip;
+            if (ip < mflimit) hash_table[hash4(read32(ip - 2))] = static_cast<std::uint32_t>(ip - 2 - src);
+        }
+    }
+    const size_t last_literals = static_cast<size_t>(iend - anchor);
+    *op++ = static_cast<unsigned char>((last_literals >= 15 ? 15 : last_literals) << 4);
+    if (last_literals >= 15) op = writeLength(op, last_literals - 15);
+    memcpy(op, anchor, last_literals);
+    op += last_literals;
+    return static_cast<size_t>(op - dst);
+}
+
+bool AssetBlockCodec::lz4Decompress(const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_size)
+{
+    const unsigned char* ip = src;
+    const unsigned char* const iend = src + src_size;
+    unsigned char* op = dst;
+    unsigned char* const oend = dst + dst_size;
+    while (ip < iend)
+    {
+        const unsigned token = *ip++;
+        size_t literal_length = token >> 4;
+        if (literal_length == 15)
+        {
+            unsigned char s;
+            do
+            {
+                if (ip >= iend) return false;
+                s = *ip++;
+                literal_length += s;
+            } while (s == 255);
+        }
+        if ((static_cast<size_t>(iend - ip) < literal_length) || (static_cast<size_t>(oend - op) < literal_length)) return false;
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+        if (ip == iend) break;  // 最後一個 sequence 只有 literal
+
+        if (iend - ip < 2) return false;
+        const size_t distance = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if ((distance == 0) || (distance > static_cast<size_t>(op - dst))) return false;
+        size_t match_length = token & 0x0f;
+        if (match_length == 15)
+        {
+            unsigned char s;
+            do
+            {
+                if (ip >= iend) return false;
+                s = *ip++;
+                match_length += s;
+            } while (s == 255);
+        }
+        match_length += LZ4_MIN_MATCH;
+        if (static_cast<size_t>(oend - op) < match_length) return false;
+        const unsigned char* match = op - distance;
+        if (distance >= match_length)
+        {
+            memcpy(op, match, match_length);
+            op += match_length;
+        }
+        else
+        {
+            // 重疊的 match (ex. 連續相同 byte), 只能逐 byte 複製
+            for (size_t i = 0; i < match_length; i++) *op++ = *match++;
+        }
+    }
+    return op == oend;
+}
@@ -0,0 +1,46 @@
+﻿/*********************************************************************
+ * \file   AssetBlockCodec.h
+ * \brief  per block compression codecs of asset bundle, zlib & lz4 block format
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef ASSET_BLOCK_CODEC_H
+#define ASSET_BLOCK_CODEC_H
+
+#include <vector>
+#include <cstddef>
+
+namespace Enigma::AssetPackage
+{
+    /** asset 在 bundle 裡的壓縮方式, 存在 header data 的 m_codec */
+    enum class AssetCodec : unsigned int
+    {
+        zlibWhole = 0,  ///< 舊格式, 整個 asset 一個 zlib stream, 沒有 block table
+        zlib = 1,       ///< 固定大小 block, 各自 zlib 壓縮
+        lz4 = 2,        ///< 固定大小 block, lz4 block format, 解壓縮快很多
+    };
+
+    class AssetBlockCodec
+    {
+    public:
+        /** block table 中 compressed size 的最高位元, 表示這個 block 壓不小, 直接存原始資料 */
+        static constexpr unsigned int STORED_RAW_FLAG = 0x80000000;
+
+    public:
+        /** 回傳壓縮後的資料, 壓不小 (或失敗) 時回傳空的 buffer, 呼叫端改存原始資料 */
+        static std::vector<unsigned char> compressBlock(AssetCodec codec, const unsigned char* src, size_t src_size);
+        /** dst_size 必須剛好是原始 block 大小 */
+        static bool decompressBlock(AssetCodec codec, const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_size);
+        /** stored_entry 是 block table 的項目, 原始資料的 block 直接複製 */
+        static bool decompressStoredBlock(AssetCodec codec, unsigned int stored_entry, const unsigned char* src, unsigned char* dst, size_t dst_size);
+
+        static size_t lz4CompressBound(size_t src_size);
+        /** lz4 block format (沒有 frame header), 回傳壓縮後大小, 0 表示 dst 不夠 */
+        static size_t lz4Compress(const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_capacity);
+        /** 有邊界檢查, 輸出大小不符或資料錯誤回傳 false */
+        static bool lz4Decompress(const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_size);
+    };
+}
+
+#endif // ASSET_BLOCK_CODEC_H
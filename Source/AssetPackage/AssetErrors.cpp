@@ -28,6 +28,9 @@ std::string ErrorCategory::message(int err) const
     case ErrorCode::emptyNameList: return "Empty name list";
     case ErrorCode::duplicatedKey: return "Duplicated asset key";
     case ErrorCode::notExistedKey: return "Not existed asset key";
+    case ErrorCode::invalidPackageFormat: return "Invalid package format";
+    case ErrorCode::pendingJournal: return "Package journal not checkpointed";
+    case ErrorCode::indexBuildFail: return "Asset index build fail";
     }
     return "Unknown";
 }
@@ -34,6 +34,9 @@ namespace Enigma::AssetPackage
         emptyNameList,
         duplicatedKey,
         notExistedKey,
+        invalidPackageFormat,
+        pendingJournal,
+        indexBuildFail,
     };
     class ErrorCategory : public std::error_category
     {
@@ -0,0 +1,100 @@
+﻿#include "AssetFreeExtentList.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::AssetPackage;
+
+AssetFreeExtentList::AssetFreeExtentList() : m_totalFreeBytes(0)
+{
+}
+
+AssetFreeExtentList::~AssetFreeExtentList()
+{
+    clear();
+}
+
+void AssetFreeExtentList::clear()
+{
+    m_extentsByOffset.clear();
+    m_extentsBySize.clear();
+    m_totalFreeBytes = 0;
+}
+
+void AssetFreeExtentList::rebuild(std::vector<Extent> used_extents, unsigned int bundle_size)
+{
+    clear();
+    std::sort(used_extents.begin(), used_extents.end(),
+        [](const Extent& a, const Extent& b) { return a.m_offset < b.m_offset; });
+    unsigned int cursor = 0;
+    for (const auto& used : used_extents)
+    {
+        if (used.m_offset > cursor) insertExtent(cursor, used.m_offset - cursor);
+        cursor = std::max(cursor, used.m_offset + used.m_size);
+    }
+    if (bundle_size > cursor) insertExtent(cursor, bundle_size - cursor);
+}
+
+unsigned int AssetFreeExtentList::allocate(unsigned int size, unsigned int& bundle_size)
+{
+    assert(size > 0);
+    auto fit = m_extentsBySize.lower_bound({ size, 0 });
+    if (fit != m_extentsBySize.end())
+    {
+        const unsigned int offset = fit->second;
+        const unsigned int extent_size = fit->first;
+        eraseExtent(m_extentsByOffset.find(offset));
+        if (extent_size > size) insertExtent(offset + size, extent_size - size);
+        return offset;
+    }
+    // 沒有夠大的空洞, 如果檔尾是空洞就從那裡開始往後長
+    unsigned int offset = bundle_size;
+    if (!m_extentsByOffset.empty())
+    {
+        auto last = std::prev(m_extentsByOffset.end());
+        if (last->first + last->second == bundle_size)
+        {
+            offset = last->first;
+            eraseExtent(last);
+        }
+    }
+    bundle_size = offset + size;
+    return offset;
+}
+
+void AssetFreeExtentList::release(unsigned int offset, unsigned int size)
+{
+    if (size == 0) return;
+    auto next = m_extentsByOffset.lower_bound(offset);
+    if (next != m_extentsByOffset.begin())
+    {
+        auto prev = std::prev(next);
+        assert(prev->first + prev->second <= offset);
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            eraseExtent(prev);
+        }
+    }
+    if ((next != m_extentsByOffset.end()) && (offset + size == next->first))
+    {
+        size += next->second;
+        eraseExtent(next);
+    }
+    insertExtent(offset, size);
+}
+
+void AssetFreeExtentList::insertExtent(unsigned int offset, unsigned int size)
+{
+    m_extentsByOffset.emplace(offset, size);
+    m_extentsBySize.emplace(size, offset);
+    m_totalFreeBytes += size;
+}
+
+void AssetFreeExtentList::eraseExtent(std::map<unsigned int, unsigned int>::iterator it)
+{
+    assert(it != m_extentsByOffset.end());
+    m_totalFreeBytes -= it->second;
+    m_extentsBySize.erase({ it->second, it->first });
+    m_extentsByOffset.erase(it);
+}
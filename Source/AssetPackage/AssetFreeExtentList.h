@@ -0,0 +1,58 @@
+﻿/*********************************************************************
+ * \file   AssetFreeExtentList.h
+ * \brief  free extents (holes) of asset bundle file, best fit allocation
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef ASSET_FREE_EXTENT_LIST_H
+#define ASSET_FREE_EXTENT_LIST_H
+
+#include <map>
+#include <set>
+#include <vector>
+#include <utility>
+
+namespace Enigma::AssetPackage
+{
+    /** bundle 中 asset 移除後留下的空洞, 相鄰的空洞會合併; 新 asset 優先放進最小且夠大的空洞 */
+    class AssetFreeExtentList
+    {
+    public:
+        struct Extent
+        {
+            unsigned int m_offset;
+            unsigned int m_size;
+        };
+    public:
+        AssetFreeExtentList();
+        AssetFreeExtentList(const AssetFreeExtentList&) = delete;
+        AssetFreeExtentList(AssetFreeExtentList&&) = delete;
+        ~AssetFreeExtentList();
+
+        AssetFreeExtentList& operator=(const AssetFreeExtentList&) = delete;
+        AssetFreeExtentList& operator=(AssetFreeExtentList&&) = delete;
+
+        void clear();
+        /** 由使用中的 extents 推算空洞, [0, bundle_size) 中沒被用到的都是空洞 */
+        void rebuild(std::vector<Extent> used_extents, unsigned int bundle_size);
+
+        /** 回傳配置的 offset; 沒有夠大的空洞時接在檔尾 (尾端的空洞會一起用掉), bundle_size 跟著變大 */
+        unsigned int allocate(unsigned int size, unsigned int& bundle_size);
+        void release(unsigned int offset, unsigned int size);
+
+        size_t getExtentCount() const { return m_extentsByOffset.size(); }
+        unsigned long long getTotalFreeBytes() const { return m_totalFreeBytes; }
+
+    private:
+        void insertExtent(unsigned int offset, unsigned int size);
+        void eraseExtent(std::map<unsigned int, unsigned int>::iterator it);
+
+    private:
+        std::map<unsigned int, unsigned int> m_extentsByOffset;  ///< offset -> size
+        std::set<std::pair<unsigned int, unsigned int>> m_extentsBySize;  ///< (size, offset)
+        unsigned long long m_totalFreeBytes;
+    };
+}
+
+#endif // ASSET_FREE_EXTENT_LIST_H
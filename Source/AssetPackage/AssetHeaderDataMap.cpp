@@ -1,6 +1,7 @@
 ﻿#include "AssetHeaderDataMap.h"
 #include <cassert>
 #include <vector>
+#include <algorithm>
 
 using namespace Enigma::AssetPackage;
 
@@ -35,15 +36,25 @@ bool AssetHeaderDataMap::hasAssetKey(const std::string& name) const
     return (find_iter != m_headerDataMap.end());
 }
 
-void AssetHeaderDataMap::repackContentOffsets(const unsigned content_size, const unsigned base_offset)
+error AssetHeaderDataMap::updateContentOffset(const std::string& name, unsigned int offset)
 {
-    for (auto& kv : m_headerDataMap)
+    auto find_iter = m_headerDataMap.find(name);
+    if (find_iter == m_headerDataMap.end()) return ErrorCode::notExistedKey;
+    find_iter->second.m_offset = offset;
+    return ErrorCode::ok;
+}
+
+std::vector<AssetHeaderDataMap::AssetHeaderData> AssetHeaderDataMap::getHeaderDatasSortedByOffset() const
+{
+    std::vector<AssetHeaderData> headers;
+    headers.reserve(m_headerDataMap.size());
+    for (const auto& kv : m_headerDataMap)
     {
-        if (kv.second.m_offset >= base_offset)
-        {
-            kv.second.m_offset -= content_size;
-        }
+        headers.emplace_back(kv.second);
     }
+    std::sort(headers.begin(), headers.end(),
+        [](const AssetHeaderData& a, const AssetHeaderData& b) { return a.m_offset < b.m_offset; });
+    return headers;
 }
 
 std::optional<AssetHeaderDataMap::AssetHeaderData> AssetHeaderDataMap::tryGetHeaderData(const std::string& name)
@@ -56,11 +67,10 @@ std::optional<AssetHeaderDataMap::AssetHeaderData> AssetHeaderDataMap::tryGetHea
 size_t AssetHeaderDataMap::calcHeaderDataMapBytes() const
 {
     size_t sum = 0;
-    for (auto kv : m_headerDataMap)
+    for (const auto& kv : m_headerDataMap)
     {
-        sum += (kv.first.length() + 1); // name 的長度加起來
+        sum += calcHeaderDataBytes(kv.second);
     }
-    sum += (getTotalDataCount() * sizeof(unsigned int) * 5);  // 5個uint * 總數量
     return sum;
 }
 
@@ -73,26 +83,15 @@ std::vector<char> AssetHeaderDataMap::exportToByteBuffer() const
     buff.resize(size, 0);
 
     size_t index = 0;
-    for (auto kv : m_headerDataMap)
+    for (const auto& kv : m_headerDataMap)
     {
-        assert(index + kv.second.m_name.length() + 1 + sizeof(unsigned int) * 5 <= size);
-        memcpy(&buff[index], kv.second.m_name.c_str(), kv.second.m_name.length());
-        index += (kv.second.m_name.length() + 1);
-        memcpy(&buff[index], &(kv.second.m_version), sizeof(unsigned int));
-        index += sizeof(unsigned int);
-        memcpy(&buff[index], &(kv.second.m_size), sizeof(unsigned int));
-        index += sizeof(unsigned int);
-        memcpy(&buff[index], &(kv.second.m_orgSize), sizeof(unsigned int));
-        index += sizeof(unsigned int);
-        memcpy(&buff[index], &(kv.second.m_offset), sizeof(unsigned int));
-        index += sizeof(unsigned int);
-        memcpy(&buff[index], &(kv.second.m_crc), sizeof(unsigned int));
-        index += sizeof(unsigned int);
+        assert(index + calcHeaderDataBytes(kv.second) <= size);
+        writeHeaderData(kv.second, buff, index);
     }
     return buff;
 }
 
-std::error_code AssetHeaderDataMap::importFromByteBuffer(const std::vector<char>& buff)
+std::error_code AssetHeaderDataMap::importFromByteBuffer(const std::vector<char>& buff, bool has_codec_field)
 {
     if (buff.empty()) return ErrorCode::emptyBuffer;
     m_headerDataMap.clear();
@@ -101,20 +100,74 @@ std::error_code AssetHeaderDataMap::importFromByteBuffer(const std::vector<char>
     while (index < size)
     {
         AssetHeaderData header{};
-        header.m_name = std::string{ &buff[index] };
-        index += (header.m_name.length() + 1);
-        memcpy(&header.m_version, &buff[index], sizeof(unsigned int));
-        index += sizeof(unsigned int);
-        memcpy(&header.m_size, &buff[index], sizeof(unsigned int));
-        index += sizeof(unsigned int);
-        memcpy(&header.m_orgSize, &buff[index], sizeof(unsigned int));
-        index += sizeof(unsigned int);
-        memcpy(&header.m_offset, &buff[index], sizeof(unsigned int));
-        index += sizeof(unsigned int);
-        memcpy(&header.m_crc, &buff[index], sizeof(unsigned int));
-        index += sizeof(unsigned int);
-
+        readHeaderData(buff, index, has_codec_field, header);
         insertHeaderData(header);
     }
     return ErrorCode::ok;
 }
+
+std::vector<char> AssetHeaderDataMap::exportHeaderData(const AssetHeaderData& header)
+{
+    std::vector<char> buff;
+    buff.resize(calcHeaderDataBytes(header), 0);
+    size_t index = 0;
+    writeHeaderData(header, buff, index);
+    return buff;
+}
+
+std::optional<AssetHeaderDataMap::AssetHeaderData> AssetHeaderDataMap::importHeaderData(const std::vector<char>& buff)
+{
+    if (buff.empty()) return std::nullopt;
+    // name 要有結尾的 0, 後面接 6 個 uint
+    auto name_end = std::find(buff.begin(), buff.end(), '\0');
+    if (name_end == buff.end()) return std::nullopt;
+    if (static_cast<size_t>(buff.end() - name_end) != 1 + sizeof(unsigned int) * 6) return std::nullopt;
+    AssetHeaderData header{};
+    size_t index = 0;
+    readHeaderData(buff, index, true, header);
+    return header;
+}
+
+size_t AssetHeaderDataMap::calcHeaderDataBytes(const AssetHeaderData& header)
+{
+    return header.m_name.length() + 1 + sizeof(unsigned int) * 6;  // name 加結尾 0, 6個uint
+}
+
+void AssetHeaderDataMap::writeHeaderData(const AssetHeaderData& header, std::vector<char>& buff, size_t& index)
+{
+    memcpy(&buff[index], header.m_name.c_str(), header.m_name.length());
+    index += (header.m_name.length() + 1);
+    memcpy(&buff[index], &(header.m_version), sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    memcpy(&buff[index], &(header.m_size), sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    memcpy(&buff[index], &(header.m_orgSize), sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    memcpy(&buff[index], &(header.m_offset), sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    memcpy(&buff[index], &(header.m_crc), sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    memcpy(&buff[index], &(header.m_codec), sizeof(unsigned int));
+    index += sizeof(unsigned int);
+}
+
+void AssetHeaderDataMap::readHeaderData(const std::vector<char>& buff, size_t& index, bool has_codec_field, AssetHeaderData& header)
+{
+    header.m_name = std::string{ &buff[index] };
+    index += (header.m_name.length() + 1);
+    memcpy(&header.m_version, &buff[index], sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    memcpy(&header.m_size, &buff[index], sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    memcpy(&header.m_orgSize, &buff[index], sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    memcpy(&header.m_offset, &buff[index], sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    memcpy(&header.m_crc, &buff[index], sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    if (has_codec_field)
+    {
+        memcpy(&header.m_codec, &buff[index], sizeof(unsigned int));
+        index += sizeof(unsigned int);
+    }
+}
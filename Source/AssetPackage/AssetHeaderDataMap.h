@@ -12,6 +12,7 @@
 #include <string>
 #include <unordered_map>
 #include <optional>
+#include <vector>
 
 namespace Enigma::AssetPackage
 {
@@ -27,8 +28,9 @@ namespace Enigma::AssetPackage
             unsigned int m_orgSize;
             unsigned int m_offset;
             unsigned int m_crc;
+            unsigned int m_codec;  ///< AssetCodec, 舊格式的 header 沒有這欄, 讀進來是 zlibWhole
             AssetHeaderData() : m_name{ "" },
-                m_version{ 0 }, m_size{ 0 }, m_orgSize{ 0 }, m_offset{ 0 }, m_crc{ 0 } {};
+                m_version{ 0 }, m_size{ 0 }, m_orgSize{ 0 }, m_offset{ 0 }, m_crc{ 0 }, m_codec{ 0 } {};
         };
     public:
         AssetHeaderDataMap();
@@ -44,7 +46,8 @@ namespace Enigma::AssetPackage
 
         bool hasAssetKey(const std::string& name) const;
 
-        void repackContentOffsets(const unsigned int content_size, const unsigned int base_offset);
+        error updateContentOffset(const std::string& name, unsigned int offset);
+        std::vector<AssetHeaderData> getHeaderDatasSortedByOffset() const;
 
         std::optional<AssetHeaderData> tryGetHeaderData(const std::string& name);
 
@@ -53,7 +56,17 @@ namespace Enigma::AssetPackage
         size_t getTotalDataCount() const { return m_headerDataMap.size(); };
 
         std::vector<char> exportToByteBuffer() const;
-        std::error_code importFromByteBuffer(const std::vector<char>& buff);
+        /** has_codec_field : 舊格式 (format tag 1) 每筆只有 5 個 uint */
+        std::error_code importFromByteBuffer(const std::vector<char>& buff, bool has_codec_field = true);
+
+        /** 單筆 header data, 給 header journal 用 */
+        static std::vector<char> exportHeaderData(const AssetHeaderData& header);
+        static std::optional<AssetHeaderData> importHeaderData(const std::vector<char>& buff);
+
+    private:
+        static size_t calcHeaderDataBytes(const AssetHeaderData& header);
+        static void writeHeaderData(const AssetHeaderData& header, std::vector<char>& buff, size_t& index);
+        static void readHeaderData(const std::vector<char>& buff, size_t& index, bool has_codec_field, AssetHeaderData& header);
 
     private:
         std::unordered_map<std::string, AssetHeaderData> m_headerDataMap;
@@ -0,0 +1,80 @@
+﻿#include "AssetMappedFile.h"
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Enigma::AssetPackage;
+
+AssetMappedFile::AssetMappedFile() : m_data(nullptr), m_size(0), m_mappingHandle(nullptr)
+{
+}
+
+#if defined(_WIN32)
+
+AssetMappedFile::~AssetMappedFile()
+{
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mappingHandle) CloseHandle(m_mappingHandle);
+}
+
+std::unique_ptr<AssetMappedFile> AssetMappedFile::map(const std::string& file_path)
+{
+    HANDLE file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER file_size;
+    if ((!GetFileSizeEx(file, &file_size)) || (file_size.QuadPart == 0))
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+    // mapping object 會保留檔案的參考, file handle 可以先關
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return nullptr;
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    std::unique_ptr<AssetMappedFile> mapped{ new AssetMappedFile() };
+    mapped->m_data = static_cast<const unsigned char*>(view);
+    mapped->m_size = static_cast<size_t>(file_size.QuadPart);
+    mapped->m_mappingHandle = mapping;
+    return mapped;
+}
+
+#else
+
+AssetMappedFile::~AssetMappedFile()
+{
+    if (m_data) munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+std::unique_ptr<AssetMappedFile> AssetMappedFile::map(const std::string& file_path)
+{
+    const int fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat attrib;
+    if ((fstat(fd, &attrib) != 0) || (attrib.st_size <= 0))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    const size_t file_size = static_cast<size_t>(attrib.st_size);
+    void* view = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mapping 建立後 fd 就不需要了
+    ::close(fd);
+    if (view == MAP_FAILED) return nullptr;
+    std::unique_ptr<AssetMappedFile> mapped{ new AssetMappedFile() };
+    mapped->m_data = static_cast<const unsigned char*>(view);
+    mapped->m_size = file_size;
+    return mapped;
+}
+
+#endif
@@ -0,0 +1,43 @@
+﻿/*********************************************************************
+ * \file   AssetMappedFile.h
+ * \brief  read-only memory mapping of package files
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef ASSET_MAPPED_FILE_H
+#define ASSET_MAPPED_FILE_H
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+namespace Enigma::AssetPackage
+{
+    /** AssetPackage 不依賴 FileSystem, 自己包一份 mapping; win32 用 file mapping object, 其他平台用 mmap, 空檔案無法 map */
+    class AssetMappedFile
+    {
+    public:
+        AssetMappedFile(const AssetMappedFile&) = delete;
+        AssetMappedFile(AssetMappedFile&&) = delete;
+        ~AssetMappedFile();
+        AssetMappedFile& operator=(const AssetMappedFile&) = delete;
+        AssetMappedFile& operator=(AssetMappedFile&&) = delete;
+
+        /** 失敗回傳 nullptr */
+        static std::unique_ptr<AssetMappedFile> map(const std::string& file_path);
+
+        const unsigned char* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        AssetMappedFile();
+
+    private:
+        const unsigned char* m_data;
+        size_t m_size;
+        void* m_mappingHandle;
+    };
+}
+
+#endif // ASSET_MAPPED_FILE_H
@@ -2,19 +2,21 @@
 #include "AssetPackageFile.h"
 #include "AssetNameList.h"
 #include "AssetHeaderDataMap.h"
+#include "AssetFreeExtentList.h"
+#include "AssetPackageFormat.h"
 #include "AssetErrors.h"
 #include "zlib.h"
 #include <cassert>
 #include <ctime>
 #include <vector>
+#include <atomic>
+#include <algorithm>
+#include <climits>
+#include <filesystem>
 #include "sys/stat.h"
 
 using namespace Enigma::AssetPackage;
 
-constexpr unsigned int PACKAGE_FORMAT_TAG = 0x01;
-constexpr char PACKAGE_HEADER_FILE_EXT[] = ".eph";
-constexpr char PACKAGE_BUNDLE_FILE_EXT[] = ".epb";
-
 using AssetHeaderData = AssetHeaderDataMap::AssetHeaderData;
 
 unsigned int GetFileVersionWithModifyTime(const std::string& file_path)
@@ -34,7 +36,7 @@ unsigned int GetFileVersionWithModifyTime(const std::string& file_path)
     return ver;
 }
 
-time_t GetTimeStampFromFileVersion(unsigned int ver)
+time_t Enigma::AssetPackage::timeStampFromFileVersion(unsigned int ver)
 {
     struct tm clock;
     memset(&clock, 0, sizeof(struct tm));
@@ -57,10 +59,17 @@ AssetPackageFile::AssetPackageFile()
     m_assetCount = 0;
     m_nameList = nullptr;
     m_headerDataMap = nullptr;
+    m_freeExtents = nullptr;
+    m_bundleSize = 0;
+    m_journalRecordCount = 0;
 }
 
 AssetPackageFile::~AssetPackageFile()
 {
+    if ((m_journalRecordCount > 0) && (m_headerFile.is_open()) && (m_nameList) && (m_headerDataMap))
+    {
+        saveHeaderFile();
+    }
     if (m_nameList)
     {
         m_nameList = nullptr;
@@ -77,6 +86,10 @@ AssetPackageFile::~AssetPackageFile()
     {
         m_bundleFile.close();
     }
+    if (m_journalFile.is_open())
+    {
+        m_journalFile.close();
+    }
 }
 
 AssetPackageFile* AssetPackageFile::createNewPackage(const std::string& basefilename)
@@ -95,16 +108,20 @@ error AssetPackageFile::createNewPackageImp(const std::string& basefilename)
 
     m_nameList = std::make_unique<AssetNameList>();
     m_headerDataMap = std::make_unique<AssetHeaderDataMap>();
+    m_freeExtents = std::make_unique<AssetFreeExtentList>();
     m_baseFilename = basefilename;
 
     std::string header_filename = m_baseFilename + PACKAGE_HEADER_FILE_EXT;
     std::string bundle_filename = m_baseFilename + PACKAGE_BUNDLE_FILE_EXT;
+    std::string journal_filename = m_baseFilename + PACKAGE_JOURNAL_FILE_EXT;
 
     m_headerFile.open(header_filename.c_str(), std::fstream::in | std::fstream::out
         | std::fstream::binary | std::fstream::trunc);
     m_bundleFile.open(bundle_filename.c_str(), std::fstream::in | std::fstream::out
         | std::fstream::binary | std::fstream::trunc);
-    if ((!m_headerFile) || (!m_bundleFile))
+    m_journalFile.open(journal_filename.c_str(), std::fstream::in | std::fstream::out
+        | std::fstream::binary | std::fstream::trunc);
+    if ((!m_headerFile) || (!m_bundleFile) || (!m_journalFile))
     {
         return ErrorCode::fileOpenFail;
     }
@@ -132,6 +149,7 @@ error AssetPackageFile::openPackageImp(const std::string& basefilename)
 
     std::string header_filename = m_baseFilename + PACKAGE_HEADER_FILE_EXT;
     std::string bundle_filename = m_baseFilename + PACKAGE_BUNDLE_FILE_EXT;
+    std::string journal_filename = m_baseFilename + PACKAGE_JOURNAL_FILE_EXT;
 
     m_headerFile.open(header_filename.c_str(), std::fstream::in | std::fstream::out | std::fstream::binary);
     m_bundleFile.open(bundle_filename.c_str(), std::fstream::in | std::fstream::out | std::fstream::binary);
@@ -139,13 +157,24 @@ error AssetPackageFile::openPackageImp(const std::string& basefilename)
     {
         return ErrorCode::fileOpenFail;
     }
+    // 舊的 package 沒有 journal file
+    m_journalFile.open(journal_filename.c_str(), std::fstream::in | std::fstream::out | std::fstream::binary);
+    if (!m_journalFile)
+    {
+        m_journalFile.clear();
+        m_journalFile.open(journal_filename.c_str(), std::fstream::in | std::fstream::out
+            | std::fstream::binary | std::fstream::trunc);
+        if (!m_journalFile) return ErrorCode::fileOpenFail;
+    }
 
     readHeaderFile();
+    replayJournalFile();
+    rebuildFreeExtents();
 
     return ErrorCode::ok;
 }
 
-error AssetPackageFile::addAssetFile(const std::string& file_path, const std::string& asset_key, unsigned int version)
+error AssetPackageFile::addAssetFile(const std::string& file_path, const std::string& asset_key, unsigned int version, AssetCodec codec)
 {
     assert(m_headerFile);
     assert(m_bundleFile);
@@ -171,13 +200,13 @@ error AssetPackageFile::addAssetFile(const std::string& file_path, const std::st
         asset_file.close();
         return ErrorCode::fileReadFail;
     }
-    error add_result = addAssetMemory(buff, asset_key, asset_ver);
+    error add_result = addAssetMemory(buff, asset_key, asset_ver, codec);
 
     asset_file.close();
     return add_result;
 }
 
-error AssetPackageFile::addAssetMemory(const std::vector<char>& buff, const std::string& asset_key, unsigned int version)
+error AssetPackageFile::addAssetMemory(const std::vector<char>& buff, const std::string& asset_key, unsigned int version, AssetCodec codec)
 {
     assert(m_headerFile);
     assert(m_bundleFile);
@@ -189,26 +218,35 @@ error AssetPackageFile::addAssetMemory(const std::vector<char>& buff, const std:
     {
         return ErrorCode::emptyKey;
     }
-    unsigned long comp_length = compressBound((uLong)buff.size());
-    std::vector<unsigned char> comp_buff;
-    comp_buff.resize(comp_length, 0);
-    int comp_result = compress((unsigned char*)&comp_buff[0], &comp_length, (const unsigned char*)&buff[0], (uLong)buff.size());
-    if (comp_result != Z_OK)
+    std::vector<char> comp_buff;
+    unsigned long comp_length = 0;
+    if (codec == AssetCodec::zlibWhole)
+    {
+        comp_length = compressBound((uLong)buff.size());
+        comp_buff.resize(comp_length, 0);
+        int comp_result = compress((unsigned char*)&comp_buff[0], &comp_length, (const unsigned char*)&buff[0], (uLong)buff.size());
+        if (comp_result != Z_OK)
+        {
+            return ErrorCode::compressFail;
+        }
+    }
+    else
     {
-        return ErrorCode::compressFail;
+        auto blocks = compressAssetBlocks(buff, codec);
+        if (!blocks) return ErrorCode::compressFail;
+        comp_buff = std::move(blocks.value());
+        comp_length = (unsigned long)comp_buff.size();
     }
 
     std::lock_guard<std::mutex> locker{ m_bundleFileLocker };
 
-    m_bundleFile.seekp(0, std::fstream::end);
-    unsigned int bundle_offset = (unsigned int)m_bundleFile.tellp();
     AssetHeaderData header_data;
     header_data.m_name = asset_key;
-    header_data.m_offset = bundle_offset;
     header_data.m_orgSize = (unsigned int)buff.size();
     header_data.m_size = comp_length;
     header_data.m_version = version;
     header_data.m_crc = 0;
+    header_data.m_codec = static_cast<unsigned int>(codec);
 
     error er = m_nameList->appendAssetName(asset_key);
     if (er) return er;
@@ -219,13 +257,28 @@ error AssetPackageFile::addAssetMemory(const std::vector<char>& buff, const std:
         m_nameList->removeAssetName(asset_key);
         return er;
     }
+    // 優先填進移除 asset 留下的空洞, 沒有夠大的才接在檔尾
+    const unsigned int bundle_offset = m_freeExtents->allocate(comp_length, m_bundleSize);
+    er = m_headerDataMap->updateContentOffset(asset_key, bundle_offset);
+    assert(!er);
+    header_data.m_offset = bundle_offset;
 
+    m_bundleFile.seekp(bundle_offset);
     m_bundleFile.write((const char*)&comp_buff[0], comp_length);
     m_bundleFile.flush();
+    if (!m_bundleFile)
+    {
+        m_bundleFile.clear();
+        m_freeExtents->release(bundle_offset, comp_length);
+        m_headerDataMap->removeHeaderData(asset_key);
+        m_nameList->removeAssetName(asset_key);
+        return ErrorCode::fileWriteFail;
+    }
 
     m_assetCount++;
 
-    saveHeaderFile();
+    // 資料寫完才記 journal, 中途 crash 只會留下一個空洞
+    appendJournalRecord(JOURNAL_ADD_ASSET, AssetHeaderDataMap::exportHeaderData(header_data));
 
     return ErrorCode::ok;
 }
@@ -272,6 +325,10 @@ std::optional<std::vector<char>> AssetPackageFile::tryRetrieveAssetToMemory(cons
 
     auto header_data = tryGetAssetHeaderData(asset_key);
     if (!header_data) return std::nullopt;
+    if (header_data->m_codec != static_cast<unsigned int>(AssetCodec::zlibWhole))
+    {
+        return decompressAssetRange(header_data.value(), 0, asset_orig_size);
+    }
 
     auto [comp_buff, read_bytes] = readBundleContent(header_data->m_offset, header_data->m_size);
 
@@ -288,6 +345,24 @@ std::optional<std::vector<char>> AssetPackageFile::tryRetrieveAssetToMemory(cons
     return buff;
 }
 
+std::optional<std::vector<char>> AssetPackageFile::tryRetrieveAssetRange(const std::string& asset_key, unsigned int offset, unsigned int size)
+{
+    assert(m_bundleFile);
+
+    if (asset_key.empty()) return std::nullopt;
+    auto header_data = tryGetAssetHeaderData(asset_key);
+    if (!header_data) return std::nullopt;
+    if (header_data->m_codec != static_cast<unsigned int>(AssetCodec::zlibWhole))
+    {
+        return decompressAssetRange(header_data.value(), offset, size);
+    }
+    // 舊格式只能整個解壓縮再切
+    auto buff = tryRetrieveAssetToMemory(asset_key);
+    if ((!buff) || (offset >= buff->size())) return std::nullopt;
+    const size_t read_bytes = std::min<size_t>(size, buff->size() - offset);
+    return std::vector<char>(buff->begin() + offset, buff->begin() + offset + read_bytes);
+}
+
 unsigned int AssetPackageFile::getAssetOriginalSize(const std::string& asset_key)
 {
     assert(m_headerDataMap);
@@ -308,7 +383,7 @@ time_t AssetPackageFile::getAssetTimeStamp(const std::string& asset_key)
     if (!header_data) return 0;
 
     unsigned int ver = header_data->m_version;
-    return GetTimeStampFromFileVersion(ver);
+    return timeStampFromFileVersion(ver);
 }
 
 error AssetPackageFile::removeAsset(const std::string& asset_key)
@@ -318,23 +393,82 @@ error AssetPackageFile::removeAsset(const std::string& asset_key)
     if (!m_nameList) return ErrorCode::invalidNameList;
     auto header_data = tryGetAssetHeaderData(asset_key);
     if (!header_data) return ErrorCode::invalidHeaderData;
-    unsigned int content_size = header_data->m_size;
-    unsigned int content_offset = header_data->m_offset;
 
-    error er = repackBundleContent(content_size, content_offset);
-    if (er) return er;
+    std::lock_guard<std::mutex> locker{ m_bundleFileLocker };
 
     // 前面都檢查過可以移除，所以這後面的 error 都做 assert
-    er = m_nameList->removeAssetName(asset_key);
+    error er = m_nameList->removeAssetName(asset_key);
     assert(!er);
-    m_headerDataMap->repackContentOffsets(content_size, content_offset);
     er = m_headerDataMap->removeHeaderData(asset_key);
     assert(!er);
+    m_freeExtents->release(header_data->m_offset, header_data->m_size);
+    if (m_assetCount > 0) m_assetCount--;
+
+    appendJournalRecord(JOURNAL_REMOVE_ASSET, std::vector<char>(asset_key.begin(), asset_key.end()));
+
+    return ErrorCode::ok;
+}
+
+error AssetPackageFile::compact()
+{
+    assert(m_bundleFile);
+    if (!m_headerDataMap) return ErrorCode::invalidHeaderData;
+    {
+        std::lock_guard<std::mutex> locker{ m_bundleFileLocker };
+
+        std::vector<AssetHeaderData> headers = m_headerDataMap->getHeaderDatasSortedByOffset();
+        unsigned int write_offset = 0;
+        std::vector<char> buff;
+        for (const auto& header : headers)
+        {
+            if (header.m_offset != write_offset)
+            {
+                // 只會往前搬, 整個 asset 讀完再寫, 不會蓋掉還沒搬的資料
+                assert(header.m_offset > write_offset);
+                buff.resize(header.m_size);
+                m_bundleFile.seekg(header.m_offset);
+                m_bundleFile.read(&buff[0], header.m_size);
+                if (!m_bundleFile) return ErrorCode::fileReadFail;
+                m_bundleFile.seekp(write_offset);
+                m_bundleFile.write(&buff[0], header.m_size);
+                if (!m_bundleFile) return ErrorCode::fileWriteFail;
+                error er = m_headerDataMap->updateContentOffset(header.m_name, write_offset);
+                assert(!er);
+            }
+            write_offset += header.m_size;
+        }
+        m_bundleFile.flush();
+
+        // fstream 沒辦法把檔案變短, 先關掉再截斷
+        std::string bundle_filename = m_baseFilename + PACKAGE_BUNDLE_FILE_EXT;
+        m_bundleFile.close();
+        std::error_code resize_error;
+        std::filesystem::resize_file(bundle_filename, write_offset, resize_error);
+        m_bundleFile.open(bundle_filename.c_str(), std::fstream::in | std::fstream::out | std::fstream::binary);
+        if (!m_bundleFile) return ErrorCode::fileOpenFail;
+        if (resize_error)
+        {
+            m_bundleFile.seekp(0, std::fstream::end);
+            m_bundleSize = (unsigned int)m_bundleFile.tellp();
+        }
+        else
+        {
+            m_bundleSize = write_offset;
+        }
+        m_freeExtents->clear();
+        if (m_bundleSize > write_offset) m_freeExtents->release(write_offset, m_bundleSize - write_offset);
+    }
     saveHeaderFile();
 
     return ErrorCode::ok;
 }
 
+unsigned long long AssetPackageFile::getFreeBytes() const
+{
+    if (!m_freeExtents) return 0;
+    return m_freeExtents->getTotalFreeBytes();
+}
+
 std::optional<AssetHeaderDataMap::AssetHeaderData> AssetPackageFile::tryGetAssetHeaderData(
     const std::string& asset_key) const
 {
@@ -355,8 +489,15 @@ void AssetPackageFile::resetPackage()
     m_formatTag = PACKAGE_FORMAT_TAG;
     m_fileVersion = 0;
     m_assetCount = 0;
+    if (m_journalFile)
+    {
+        m_journalFile.close();
+    }
     m_nameList = nullptr;
     m_headerDataMap = nullptr;
+    m_freeExtents = nullptr;
+    m_bundleSize = 0;
+    m_journalRecordCount = 0;
 }
 
 void AssetPackageFile::saveHeaderFile()
@@ -364,6 +505,8 @@ void AssetPackageFile::saveHeaderFile()
     assert(m_headerFile);
     std::lock_guard<std::mutex> locker{ m_headerFileLocker };
     m_headerFile.seekp(0);
+    // 舊格式的 package 存檔時一併升級, 舊 asset 的 codec 仍是 zlibWhole
+    m_formatTag = PACKAGE_FORMAT_TAG;
 
     //m_headerFile << m_formatTag << m_fileVersion << m_assetCount;
     m_headerFile.write((const char*)&m_formatTag, sizeof(m_formatTag));
@@ -389,6 +532,16 @@ void AssetPackageFile::saveHeaderFile()
     }
 
     m_headerFile.flush();
+
+    // header file 已包含所有變更, journal 可以清掉
+    if (m_journalFile.is_open())
+    {
+        m_journalFile.close();
+        std::string journal_filename = m_baseFilename + PACKAGE_JOURNAL_FILE_EXT;
+        m_journalFile.open(journal_filename.c_str(), std::fstream::in | std::fstream::out
+            | std::fstream::binary | std::fstream::trunc);
+    }
+    m_journalRecordCount = 0;
 }
 
 void AssetPackageFile::readHeaderFile()
@@ -422,7 +575,103 @@ void AssetPackageFile::readHeaderFile()
         m_headerFile.read(&header_buff[0], header_byte_size);
     }
     m_headerDataMap = std::make_unique<AssetHeaderDataMap>();
-    m_headerDataMap->importFromByteBuffer(header_buff);
+    m_headerDataMap->importFromByteBuffer(header_buff, m_formatTag != PACKAGE_FORMAT_TAG_WHOLE_ZLIB);
+}
+
+void AssetPackageFile::appendJournalRecord(unsigned int record_type, const std::vector<char>& payload)
+{
+    assert(m_journalFile);
+    {
+        std::lock_guard<std::mutex> locker{ m_headerFileLocker };
+        const unsigned int payload_size = (unsigned int)payload.size();
+        m_journalFile.seekp(0, std::fstream::end);
+        m_journalFile.write((const char*)&record_type, sizeof(record_type));
+        m_journalFile.write((const char*)&payload_size, sizeof(payload_size));
+        if (payload_size > 0)
+        {
+            m_journalFile.write(&payload[0], payload_size);
+        }
+        m_journalFile.flush();
+        m_journalRecordCount++;
+    }
+    if (m_journalRecordCount >= JOURNAL_CHECKPOINT_RECORDS)
+    {
+        saveHeaderFile();
+    }
+}
+
+void AssetPackageFile::replayJournalFile()
+{
+    assert(m_journalFile);
+    assert(m_nameList);
+    assert(m_headerDataMap);
+    std::lock_guard<std::mutex> locker{ m_headerFileLocker };
+    m_journalFile.seekg(0, std::fstream::end);
+    const auto journal_size = m_journalFile.tellg();
+    m_journalFile.seekg(0);
+    m_journalRecordCount = 0;
+    std::streamoff valid_size = 0;
+    std::vector<char> payload;
+    while (m_journalFile.tellg() + static_cast<std::streamoff>(sizeof(unsigned int) * 2) <= journal_size)
+    {
+        unsigned int record_type;
+        unsigned int payload_size;
+        m_journalFile.read((char*)&record_type, sizeof(record_type));
+        m_journalFile.read((char*)&payload_size, sizeof(payload_size));
+        if ((!m_journalFile) || (m_journalFile.tellg() + static_cast<std::streamoff>(payload_size) > journal_size)) break;
+        payload.resize(payload_size);
+        if (payload_size > 0)
+        {
+            m_journalFile.read(&payload[0], payload_size);
+        }
+        // 上次 checkpoint 寫完 header 但沒清掉 journal 時會重播到已經套用過的 record, 依序重播結果仍然一致
+        if (record_type == JOURNAL_ADD_ASSET)
+        {
+            auto header_data = AssetHeaderDataMap::importHeaderData(payload);
+            if (!header_data) break;
+            if ((!m_nameList->appendAssetName(header_data->m_name)) && (!m_headerDataMap->insertHeaderData(header_data.value())))
+            {
+                m_assetCount++;
+            }
+        }
+        else if (record_type == JOURNAL_REMOVE_ASSET)
+        {
+            const std::string asset_key(payload.begin(), payload.end());
+            m_nameList->removeAssetName(asset_key);
+            if ((!m_headerDataMap->removeHeaderData(asset_key)) && (m_assetCount > 0)) m_assetCount--;
+        }
+        else
+        {
+            break;
+        }
+        m_journalRecordCount++;
+        valid_size = m_journalFile.tellg();
+    }
+    // 寫一半的 record (包含它的 record header) 之後的資料不要了, 新的 record 接在最後一筆完整的 record 後面
+    m_journalFile.clear();
+    if (valid_size != journal_size)
+    {
+        std::string journal_filename = m_baseFilename + PACKAGE_JOURNAL_FILE_EXT;
+        m_journalFile.close();
+        std::error_code resize_error;
+        std::filesystem::resize_file(journal_filename, static_cast<std::uintmax_t>(valid_size), resize_error);
+        m_journalFile.open(journal_filename.c_str(), std::fstream::in | std::fstream::out | std::fstream::binary);
+    }
+}
+
+void AssetPackageFile::rebuildFreeExtents()
+{
+    assert(m_bundleFile);
+    assert(m_headerDataMap);
+    m_bundleFile.seekg(0, std::fstream::end);
+    m_bundleSize = (unsigned int)m_bundleFile.tellg();
+    std::vector<AssetFreeExtentList::Extent> used_extents;
+    for (const auto& header : m_headerDataMap->getHeaderDatasSortedByOffset())
+    {
+        used_extents.push_back({ header.m_offset, header.m_size });
+    }
+    m_freeExtents = std::make_unique<AssetFreeExtentList>();
+    m_freeExtents->rebuild(std::move(used_extents), m_bundleSize);
 }
 
 std::tuple<std::vector<char>, unsigned int> AssetPackageFile::readBundleContent(unsigned int offset,
@@ -437,27 +686,145 @@ std::tuple<std::vector<char>, unsigned int> AssetPackageFile::readBundleContent(
     return { out_buff, (unsigned int)m_bundleFile.tellg() - offset };
 }
 
-error AssetPackageFile::repackBundleContent(const unsigned int content_size, const unsigned int base_offset)
+std::optional<std::vector<char>> AssetPackageFile::compressAssetBlocks(const std::vector<char>& buff, AssetCodec codec)
 {
-    assert(m_bundleFile);
+    assert(!buff.empty());
+    const size_t block_count = (buff.size() + ASSET_BLOCK_SIZE - 1) / ASSET_BLOCK_SIZE;
+    std::vector<std::vector<unsigned char>> comp_blocks(block_count);
+    auto compress_blocks = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            const size_t raw_offset = i * ASSET_BLOCK_SIZE;
+            const size_t raw_size = std::min<size_t>(ASSET_BLOCK_SIZE, buff.size() - raw_offset);
+            comp_blocks[i] = AssetBlockCodec::compressBlock(codec, reinterpret_cast<const unsigned char*>(&buff[raw_offset]), raw_size);
+        }
+    };
+    if (block_count >= PARALLEL_BLOCK_COUNT)
+    {
+        parallelFor(block_count, compress_blocks);
+    }
+    else
+    {
+        compress_blocks(0, block_count);
+    }
 
-    std::lock_guard<std::mutex> locker{ m_bundleFileLocker };
+    std::vector<unsigned int> table(2 + block_count);
+    table[0] = ASSET_BLOCK_SIZE;
+    table[1] = static_cast<unsigned int>(block_count);
+    size_t total_size = table.size() * sizeof(unsigned int);
+    for (size_t i = 0; i < block_count; i++)
+    {
+        const size_t raw_size = std::min<size_t>(ASSET_BLOCK_SIZE, buff.size() - i * ASSET_BLOCK_SIZE);
+        // 壓不小的 block 直接存原始資料
+        const bool is_raw = comp_blocks[i].empty();
+        const size_t stored_size = is_raw ? raw_size : comp_blocks[i].size();
+        table[2 + i] = static_cast<unsigned int>(stored_size) | (is_raw ? AssetBlockCodec::STORED_RAW_FLAG : 0);
+        total_size += stored_size;
+    }
+    if (total_size > UINT_MAX) return std::nullopt;
 
-    m_bundleFile.seekp(0, std::fstream::end);
-    auto bundle_org_size = m_bundleFile.tellp();
-    if (bundle_org_size == 0) return ErrorCode::fileSizeError;
-    std::vector<char> file_buff;
-    file_buff.resize(bundle_org_size, 0);
-    m_bundleFile.seekg(0);
-    m_bundleFile.read(&file_buff[0], bundle_org_size);
-    auto read_bytes = m_bundleFile.tellg();
-    if (read_bytes != bundle_org_size) return ErrorCode::readSizeCheck;
-
-    file_buff.erase(file_buff.begin() + base_offset, file_buff.begin() + base_offset + content_size);
-    m_bundleFile.seekp(0);
-    m_bundleFile.write(&file_buff[0], file_buff.size());
-    m_bundleFile.flush();
-    return ErrorCode::ok;
+    std::vector<char> out_buff(total_size);
+    memcpy(&out_buff[0], table.data(), table.size() * sizeof(unsigned int));
+    size_t index = table.size() * sizeof(unsigned int);
+    for (size_t i = 0; i < block_count; i++)
+    {
+        if (comp_blocks[i].empty())
+        {
+            const size_t raw_offset = i * ASSET_BLOCK_SIZE;
+            const size_t raw_size = std::min<size_t>(ASSET_BLOCK_SIZE, buff.size() - raw_offset);
+            memcpy(&out_buff[index], &buff[raw_offset], raw_size);
+            index += raw_size;
+        }
+        else
+        {
+            memcpy(&out_buff[index], comp_blocks[i].data(), comp_blocks[i].size());
+            index += comp_blocks[i].size();
+        }
+    }
+    return out_buff;
+}
+
+std::optional<std::vector<char>> AssetPackageFile::decompressAssetRange(const AssetHeaderData& header_data, unsigned int offset, unsigned int size)
+{
+    const unsigned int asset_size = header_data.m_orgSize;
+    if ((offset >= asset_size) || (size == 0)) return std::nullopt;
+    size = std::min(size, asset_size - offset);
+
+    auto [table_head, head_bytes] = readBundleContent(header_data.m_offset, BLOCK_TABLE_HEAD_SIZE);
+    if (head_bytes != BLOCK_TABLE_HEAD_SIZE) return std::nullopt;
+    unsigned int block_size;
+    unsigned int block_count;
+    memcpy(&block_size, &table_head[0], sizeof(unsigned int));
+    memcpy(&block_count, &table_head[sizeof(unsigned int)], sizeof(unsigned int));
+    if ((block_size == 0) || (block_count != (asset_size + block_size - 1) / block_size)) return std::nullopt;
+    const unsigned int table_bytes = block_count * sizeof(unsigned int);
+    auto [table_buff, table_read_bytes] = readBundleContent(header_data.m_offset + BLOCK_TABLE_HEAD_SIZE, table_bytes);
+    if (table_read_bytes != table_bytes) return std::nullopt;
+    std::vector<unsigned int> stored_sizes(block_count);
+    memcpy(stored_sizes.data(), &table_buff[0], table_bytes);
+
+    const unsigned int first_block = offset / block_size;
+    const unsigned int last_block = (offset + size - 1) / block_size;
+    // 碰到的 block 在 bundle 中是連續的, 一次讀進來
+    std::vector<size_t> comp_offsets(last_block - first_block + 2, 0);
+    size_t comp_begin = 0;
+    for (unsigned int i = 0; i < first_block; i++)
+    {
+        comp_begin += stored_sizes[i] & ~AssetBlockCodec::STORED_RAW_FLAG;
+    }
+    for (unsigned int i = first_block; i <= last_block; i++)
+    {
+        comp_offsets[i - first_block + 1] = comp_offsets[i - first_block] + (stored_sizes[i] & ~AssetBlockCodec::STORED_RAW_FLAG);
+    }
+    const size_t comp_length = comp_offsets.back();
+    if (BLOCK_TABLE_HEAD_SIZE + table_bytes + comp_begin + comp_length > header_data.m_size) return std::nullopt;
+    auto [comp_buff, comp_read_bytes] = readBundleContent(static_cast<unsigned int>(header_data.m_offset + BLOCK_TABLE_HEAD_SIZE + table_bytes + comp_begin),
+        static_cast<unsigned int>(comp_length));
+    if (comp_read_bytes != comp_length) return std::nullopt;
+
+    const size_t raw_begin = static_cast<size_t>(first_block) * block_size;
+    const size_t raw_end = std::min<size_t>(asset_size, static_cast<size_t>(last_block + 1) * block_size);
+    std::vector<char> raw_buff(raw_end - raw_begin);
+    const AssetCodec codec = static_cast<AssetCodec>(header_data.m_codec);
+    std::atomic<bool> is_failed{ false };
+    auto decompress_blocks = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            const size_t block = first_block + i;
+            const size_t raw_offset = block * block_size - raw_begin;
+            const size_t raw_size = std::min<size_t>(block_size, asset_size - block * block_size);
+            const unsigned char* src = reinterpret_cast<const unsigned char*>(&comp_buff[comp_offsets[i]]);
+            unsigned char* dst = reinterpret_cast<unsigned char*>(&raw_buff[raw_offset]);
+            if (!AssetBlockCodec::decompressStoredBlock(codec, stored_sizes[block], src, dst, raw_size))
+            {
+                is_failed = true;
+            }
+        }
+    };
+    const size_t touched_count = last_block - first_block + 1;
+    if (touched_count >= PARALLEL_BLOCK_COUNT)
+    {
+        parallelFor(touched_count, decompress_blocks);
+    }
+    else
+    {
+        decompress_blocks(0, touched_count);
+    }
+    if (is_failed) return std::nullopt;
+    if ((offset == raw_begin) && (size == raw_buff.size())) return raw_buff;
+    return std::vector<char>(raw_buff.begin() + (offset - raw_begin), raw_buff.begin() + (offset - raw_begin) + size);
+}
+
+void AssetPackageFile::parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& task)
+{
+    if (m_parallelFor)
+    {
+        m_parallelFor(count, task);
+        return;
+    }
+    task(0, count);
 }
 
 #undef _CRT_SECURE_NO_WARNINGS
@@ -13,18 +13,29 @@
 #include <string>
 #include <fstream>
 #include "AssetHeaderDataMap.h"
+#include "AssetBlockCodec.h"
 #include <mutex>
+#include <functional>
 
 namespace Enigma::AssetPackage
 {
     class AssetNameList;
     class AssetHashTable;
+    class AssetFreeExtentList;
 
     using error = std::error_code;
     class AssetPackageFile
     {
     public:
         constexpr static unsigned int VERSION_USE_FILE_TIME = 0;
+        /// asset 切成固定大小的 block 各自壓縮, 部分讀取時只解壓縮碰到的 block
+        constexpr static unsigned int ASSET_BLOCK_SIZE = 64 * 1024;
+        /// block 數達到這個數量才平行壓縮/解壓縮
+        constexpr static unsigned int PARALLEL_BLOCK_COUNT = 8;
+        /** 平行執行 [0, count) 的函式, 由使用端注入 (ex. 包 WorkerThreadPool::parallelFor), library 本身不依賴 thread pool */
+        using ParallelForFunction = std::function<void(size_t count, const std::function<void(size_t begin, size_t end)>& task)>;
+        /// journal 累積這麼多筆就寫回完整的 header file
+        constexpr static unsigned int JOURNAL_CHECKPOINT_RECORDS = 1024;
     public:
         AssetPackageFile(const AssetPackageFile&) = delete;
         AssetPackageFile(AssetPackageFile&&) = delete;
@@ -36,14 +47,23 @@ namespace Enigma::AssetPackage
         static AssetPackageFile* createNewPackage(const std::string& basefilename);
         static AssetPackageFile* openPackage(const std::string& basefilename);
 
-        error addAssetFile(const std::string& file_path, const std::string& asset_key, unsigned int version);
-        error addAssetMemory(const std::vector<char>& buff, const std::string& asset_key, unsigned int version);
+        /** 沒有注入時在呼叫端 thread 依序處理 */
+        void setParallelFor(const ParallelForFunction& parallel_for) { m_parallelFor = parallel_for; }
+
+        error addAssetFile(const std::string& file_path, const std::string& asset_key, unsigned int version, AssetCodec codec = AssetCodec::zlib);
+        error addAssetMemory(const std::vector<char>& buff, const std::string& asset_key, unsigned int version, AssetCodec codec = AssetCodec::zlib);
         error tryRetrieveAssetToFile(const std::string& file_path, const std::string& asset_key);
         std::optional<std::vector<char>> tryRetrieveAssetToMemory(const std::string& asset_key);
+        /** 只解壓縮 [offset, offset + size) 碰到的 block, 超出 asset 的部分截掉 */
+        std::optional<std::vector<char>> tryRetrieveAssetRange(const std::string& asset_key, unsigned int offset, unsigned int size);
         unsigned int getAssetOriginalSize(const std::string& asset_key);
         time_t getAssetTimeStamp(const std::string& asset_key);
 
+        /** 只把 asset 佔的空間標記為空洞, 之後加入的 asset 會重複使用 */
         error removeAsset(const std::string& asset_key);
+        /** 離線操作 : 把所有 asset 往前搬移填滿空洞, 截短 bundle file, 並寫回完整的 header file */
+        error compact();
+        unsigned long long getFreeBytes() const;
 
         const std::unique_ptr<AssetNameList>& getAssetNameList() { return m_nameList; };
         std::optional<AssetHeaderDataMap::AssetHeaderData> tryGetAssetHeaderData(const std::string& asset_key) const;
@@ -53,11 +73,18 @@ namespace Enigma::AssetPackage
         error openPackageImp(const std::string& basefilename);
         void resetPackage();
 
+        /** 寫入完整的 header file, 並清空 journal */
         void saveHeaderFile();
         void readHeaderFile();
+        void appendJournalRecord(unsigned int record_type, const std::vector<char>& payload);
+        void replayJournalFile();
+        void rebuildFreeExtents();
 
         std::tuple<std::vector<char>, unsigned int> readBundleContent(unsigned int offset, unsigned int content_size);
-        error repackBundleContent(const unsigned int content_size, const unsigned int base_offset);
+        /** block table (block size, block count, 每個 block 的壓縮大小) + 各 block 資料 */
+        std::optional<std::vector<char>> compressAssetBlocks(const std::vector<char>& buff, AssetCodec codec);
+        std::optional<std::vector<char>> decompressAssetRange(const AssetHeaderDataMap::AssetHeaderData& header_data, unsigned int offset, unsigned int size);
+        void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& task);
 
     private:
         unsigned int m_formatTag;
@@ -65,13 +92,19 @@ namespace Enigma::AssetPackage
         unsigned int m_assetCount;
         std::unique_ptr<AssetNameList> m_nameList;
         std::unique_ptr<AssetHeaderDataMap> m_headerDataMap;
+        std::unique_ptr<AssetFreeExtentList> m_freeExtents;
+        unsigned int m_bundleSize;
+        unsigned int m_journalRecordCount;
 
         std::string m_baseFilename;
         std::fstream m_headerFile;
         std::fstream m_bundleFile;
+        std::fstream m_journalFile;
 
         std::mutex m_headerFileLocker;
         std::mutex m_bundleFileLocker;
+
+        ParallelForFunction m_parallelFor;
     };
 
     using AssetPackageFilePtr = std::shared_ptr<AssetPackageFile>;
@@ -0,0 +1,36 @@
+﻿/*********************************************************************
+ * \file   AssetPackageFormat.h
+ * \brief  on-disk constants shared by package writer & read-only reader,
+ *          library internal
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef ASSET_PACKAGE_FORMAT_H
+#define ASSET_PACKAGE_FORMAT_H
+
+#include <ctime>
+
+namespace Enigma::AssetPackage
+{
+    /// format tag 2 : header data 多了 codec 欄位, asset 可以是 block 壓縮
+    constexpr unsigned int PACKAGE_FORMAT_TAG = 0x02;
+    constexpr unsigned int PACKAGE_FORMAT_TAG_WHOLE_ZLIB = 0x01;
+    constexpr unsigned int BLOCK_TABLE_HEAD_SIZE = sizeof(unsigned int) * 2;
+    constexpr char PACKAGE_HEADER_FILE_EXT[] = ".eph";
+    constexpr char PACKAGE_BUNDLE_FILE_EXT[] = ".epb";
+    constexpr char PACKAGE_JOURNAL_FILE_EXT[] = ".epj";
+    constexpr char PACKAGE_INDEX_FILE_EXT[] = ".epi";
+
+    /// journal record : type, payload size, payload; 最後一筆寫一半 (crash) 的會被忽略
+    constexpr unsigned int JOURNAL_ADD_ASSET = 1;  ///< payload 是單筆 header data
+    constexpr unsigned int JOURNAL_REMOVE_ASSET = 2;  ///< payload 是 asset key
+
+    /// index file : magic, header fingerprint (u64), perfect hash, 每個 slot 的 header record offset
+    constexpr unsigned int PACKAGE_INDEX_MAGIC = 0x31495045;  // "EPI1"
+
+    /** asset version 是壓縮過的修改時間, 定義在 AssetPackageFile.cpp */
+    time_t timeStampFromFileVersion(unsigned int ver);
+}
+
+#endif // ASSET_PACKAGE_FORMAT_H
@@ -0,0 +1,328 @@
+﻿#include "AssetPackageReader.h"
+#include "AssetPackageFormat.h"
+#include "AssetMappedFile.h"
+#include "AssetErrors.h"
+#include "zlib.h"
+#include <filesystem>
+#include <fstream>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+using namespace Enigma::AssetPackage;
+
+using AssetHeaderData = AssetHeaderDataMap::AssetHeaderData;
+
+AssetPackageReader::AssetPackageReader() : m_formatTag(PACKAGE_FORMAT_TAG), m_recordsBegin(0), m_recordsEnd(0),
+    m_headerFingerprint(0), m_isPrebuiltIndex(false)
+{
+}
+
+AssetPackageReader::~AssetPackageReader()
+{
+    m_recordOffsets.clear();
+    m_bundleFile = nullptr;
+    m_headerFile = nullptr;
+}
+
+AssetPackageReader* AssetPackageReader::openPackage(const std::string& basefilename)
+{
+    error er;
+    return openPackage(basefilename, er);
+}
+
+AssetPackageReader* AssetPackageReader::openPackage(const std::string& basefilename, error& er)
+{
+    AssetPackageReader* package = new AssetPackageReader();
+    er = package->openPackageImp(basefilename);
+    if (er)
+    {
+        delete package;
+        return nullptr;
+    }
+    return package;
+}
+
+error AssetPackageReader::openPackageImp(const std::string& basefilename)
+{
+    if (basefilename.empty()) return ErrorCode::emptyFileName;
+    m_baseFilename = basefilename;
+
+    // journal 裡的變更還沒寫進 header, 照 header 讀會拿到舊的 offset
+    std::error_code journal_error;
+    const auto journal_size = std::filesystem::file_size(m_baseFilename + PACKAGE_JOURNAL_FILE_EXT, journal_error);
+    if ((!journal_error) && (journal_size > 0)) return ErrorCode::pendingJournal;
+
+    m_headerFile = AssetMappedFile::map(m_baseFilename + PACKAGE_HEADER_FILE_EXT);
+    if (!m_headerFile) return ErrorCode::fileOpenFail;
+    error er = parseHeader();
+    if (er) return er;
+    if (m_recordsEnd > m_recordsBegin)
+    {
+        m_bundleFile = AssetMappedFile::map(m_baseFilename + PACKAGE_BUNDLE_FILE_EXT);
+        if (!m_bundleFile) return ErrorCode::fileOpenFail;
+    }
+
+    if (!loadIndexFile())
+    {
+        m_isPrebuiltIndex = true;
+        return ErrorCode::ok;
+    }
+    return buildIndex();
+}
+
+error AssetPackageReader::parseHeader()
+{
+    const char* data = reinterpret_cast<const char*>(m_headerFile->data());
+    const size_t size = m_headerFile->size();
+    // format tag, file version, asset count, name list size
+    size_t index = sizeof(unsigned int) * 3;
+    if (size < index + sizeof(unsigned int)) return ErrorCode::invalidPackageFormat;
+    memcpy(&m_formatTag, data, sizeof(unsigned int));
+    if ((m_formatTag != PACKAGE_FORMAT_TAG) && (m_formatTag != PACKAGE_FORMAT_TAG_WHOLE_ZLIB)) return ErrorCode::invalidPackageFormat;
+    unsigned int name_list_byte_size;
+    memcpy(&name_list_byte_size, data + index, sizeof(unsigned int));
+    index += sizeof(unsigned int) + name_list_byte_size;
+    if (size < index + sizeof(unsigned int)) return ErrorCode::invalidPackageFormat;
+    unsigned int header_byte_size;
+    memcpy(&header_byte_size, data + index, sizeof(unsigned int));
+    index += sizeof(unsigned int);
+    if (size < index + header_byte_size) return ErrorCode::invalidPackageFormat;
+    m_recordsBegin = index;
+    m_recordsEnd = index + header_byte_size;
+    m_headerFingerprint = AssetPerfectHashIndex::hashKey(std::string_view(data, m_recordsEnd));
+    return ErrorCode::ok;
+}
+
+error AssetPackageReader::loadIndexFile()
+{
+    std::ifstream index_file{ m_baseFilename + PACKAGE_INDEX_FILE_EXT, std::fstream::in | std::fstream::binary };
+    if (index_file.fail()) return ErrorCode::fileOpenFail;
+    std::vector<char> buff{ std::istreambuf_iterator<char>(index_file), std::istreambuf_iterator<char>() };
+    constexpr size_t stamp_size = sizeof(unsigned int) + sizeof(std::uint64_t);
+    if (buff.size() < stamp_size) return ErrorCode::invalidPackageFormat;
+    unsigned int magic;
+    std::uint64_t fingerprint;
+    memcpy(&magic, &buff[0], sizeof(unsigned int));
+    memcpy(&fingerprint, &buff[sizeof(unsigned int)], sizeof(std::uint64_t));
+    // header 改過之後舊的 index 就不能用
+    if ((magic != PACKAGE_INDEX_MAGIC) || (fingerprint != m_headerFingerprint)) return ErrorCode::invalidPackageFormat;
+    auto index = AssetPerfectHashIndex::importFromBytes(&buff[stamp_size], buff.size() - stamp_size);
+    if (!index) return ErrorCode::invalidPackageFormat;
+    const size_t offsets_begin = stamp_size + index->second;
+    const size_t key_count = index->first.getKeyCount();
+    if (buff.size() != offsets_begin + key_count * sizeof(unsigned int)) return ErrorCode::invalidPackageFormat;
+    std::vector<unsigned int> record_offsets(key_count);
+    if (key_count > 0)
+    {
+        memcpy(record_offsets.data(), &buff[offsets_begin], key_count * sizeof(unsigned int));
+    }
+    for (unsigned int offset : record_offsets)
+    {
+        if ((offset < m_recordsBegin) || (offset >= m_recordsEnd)) return ErrorCode::invalidPackageFormat;
+    }
+    m_index = std::move(index->first);
+    m_recordOffsets = std::move(record_offsets);
+    return ErrorCode::ok;
+}
+
+error AssetPackageReader::buildIndex()
+{
+    const char* data = reinterpret_cast<const char*>(m_headerFile->data());
+    const size_t uint_count = (m_formatTag == PACKAGE_FORMAT_TAG_WHOLE_ZLIB) ? 5 : 6;
+    std::vector<std::string_view> keys;
+    std::vector<unsigned int> offsets;
+    size_t index = m_recordsBegin;
+    while (index < m_recordsEnd)
+    {
+        const char* name_end = static_cast<const char*>(memchr(data + index, '\0', m_recordsEnd - index));
+        if (!name_end) return ErrorCode::invalidHeaderData;
+        const size_t record_end = static_cast<size_t>(name_end - data) + 1 + sizeof(unsigned int) * uint_count;
+        if (record_end > m_recordsEnd) return ErrorCode::invalidHeaderData;
+        keys.emplace_back(data + index, static_cast<size_t>(name_end - (data + index)));
+        offsets.push_back(static_cast<unsigned int>(index));
+        index = record_end;
+    }
+    auto perfect_hash = AssetPerfectHashIndex::build(keys);
+    if (!perfect_hash) return ErrorCode::indexBuildFail;
+    m_index = std::move(perfect_hash.value());
+    m_recordOffsets.assign(keys.size(), 0);
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        m_recordOffsets[m_index.slotOf(keys[i])] = offsets[i];
+    }
+    m_isPrebuiltIndex = false;
+    return ErrorCode::ok;
+}
+
+error AssetPackageReader::saveIndexFile() const
+{
+    std::ofstream index_file{ m_baseFilename + PACKAGE_INDEX_FILE_EXT, std::fstream::out | std::fstream::binary | std::fstream::trunc };
+    if (index_file.fail()) return ErrorCode::fileOpenFail;
+    const std::vector<char> index_buff = m_index.exportToByteBuffer();
+    index_file.write((const char*)&PACKAGE_INDEX_MAGIC, sizeof(PACKAGE_INDEX_MAGIC));
+    index_file.write((const char*)&m_headerFingerprint, sizeof(m_headerFingerprint));
+    index_file.write(&index_buff[0], index_buff.size());
+    if (!m_recordOffsets.empty())
+    {
+        index_file.write((const char*)m_recordOffsets.data(), m_recordOffsets.size() * sizeof(unsigned int));
+    }
+    index_file.flush();
+    if (!index_file) return ErrorCode::fileWriteFail;
+    return ErrorCode::ok;
+}
+
+bool AssetPackageReader::hasAsset(const std::string_view& asset_key) const
+{
+    return findRecord(asset_key) != nullptr;
+}
+
+std::optional<AssetHeaderData> AssetPackageReader::tryGetAssetHeaderData(const std::string_view& asset_key) const
+{
+    const char* record = findRecord(asset_key);
+    if (!record) return std::nullopt;
+    const AssetRecord asset = readRecord(record);
+    AssetHeaderData header;
+    header.m_name = std::string(asset_key);
+    header.m_version = asset.m_version;
+    header.m_size = asset.m_size;
+    header.m_orgSize = asset.m_orgSize;
+    header.m_offset = asset.m_offset;
+    header.m_codec = static_cast<unsigned int>(asset.m_codec);
+    return header;
+}
+
+unsigned int AssetPackageReader::getAssetOriginalSize(const std::string_view& asset_key) const
+{
+    const char* record = findRecord(asset_key);
+    if (!record) return 0;
+    return readRecord(record).m_orgSize;
+}
+
+time_t AssetPackageReader::getAssetTimeStamp(const std::string_view& asset_key) const
+{
+    const char* record = findRecord(asset_key);
+    if (!record) return 0;
+    return timeStampFromFileVersion(readRecord(record).m_version);
+}
+
+std::optional<std::vector<char>> AssetPackageReader::tryRetrieveAssetToMemory(const std::string_view& asset_key) const
+{
+    const char* record = findRecord(asset_key);
+    if (!record) return std::nullopt;
+    const AssetRecord asset = readRecord(record);
+    return decompressAssetRange(asset, 0, asset.m_orgSize);
+}
+
+std::optional<std::vector<char>> AssetPackageReader::tryRetrieveAssetRange(const std::string_view& asset_key, unsigned int offset, unsigned int size) const
+{
+    const char* record = findRecord(asset_key);
+    if (!record) return std::nullopt;
+    return decompressAssetRange(readRecord(record), offset, size);
+}
+
+const char* AssetPackageReader::findRecord(const std::string_view& asset_key) const
+{
+    if ((asset_key.empty()) || (m_recordOffsets.empty())) return nullptr;
+    const char* data = reinterpret_cast<const char*>(m_headerFile->data());
+    const unsigned int record_offset = m_recordOffsets[m_index.slotOf(asset_key)];
+    // 不在 package 裡的 key 也會落在某個 slot, 要比對名稱
+    if (record_offset + asset_key.size() >= m_recordsEnd) return nullptr;
+    const char* record = data + record_offset;
+    if ((memcmp(record, asset_key.data(), asset_key.size()) != 0) || (record[asset_key.size()] != '\0')) return nullptr;
+    return record;
+}
+
+AssetPackageReader::AssetRecord AssetPackageReader::readRecord(const char* record) const
+{
+    // name, version, size, orgSize, offset, crc, codec; index 建立時已確認 record 完整
+    const char* values = record + strlen(record) + 1;
+    AssetRecord asset;
+    memcpy(&asset.m_version, values, sizeof(unsigned int));
+    memcpy(&asset.m_size, values + sizeof(unsigned int), sizeof(unsigned int));
+    memcpy(&asset.m_orgSize, values + sizeof(unsigned int) * 2, sizeof(unsigned int));
+    memcpy(&asset.m_offset, values + sizeof(unsigned int) * 3, sizeof(unsigned int));
+    asset.m_codec = AssetCodec::zlibWhole;
+    if (m_formatTag != PACKAGE_FORMAT_TAG_WHOLE_ZLIB)
+    {
+        unsigned int codec;
+        memcpy(&codec, values + sizeof(unsigned int) * 5, sizeof(unsigned int));
+        asset.m_codec = static_cast<AssetCodec>(codec);
+    }
+    return asset;
+}
+
+std::optional<std::vector<char>> AssetPackageReader::decompressAssetRange(const AssetRecord& record, unsigned int offset, unsigned int size) const
+{
+    const unsigned int asset_size = record.m_orgSize;
+    if ((offset >= asset_size) || (size == 0)) return std::nullopt;
+    size = std::min(size, asset_size - offset);
+    if ((!m_bundleFile) || (static_cast<size_t>(record.m_offset) + record.m_size > m_bundleFile->size())) return std::nullopt;
+    const unsigned char* stored = m_bundleFile->data() + record.m_offset;
+
+    if (record.m_codec == AssetCodec::zlibWhole)
+    {
+        uLongf out_length = asset_size;
+        std::vector<char> buff(asset_size);
+        if (uncompress(reinterpret_cast<unsigned char*>(&buff[0]), &out_length, stored, record.m_size) != Z_OK) return std::nullopt;
+        if (out_length != asset_size) return std::nullopt;
+        if ((offset == 0) && (size == asset_size)) return buff;
+        return std::vector<char>(buff.begin() + offset, buff.begin() + offset + size);
+    }
+
+    if (record.m_size < BLOCK_TABLE_HEAD_SIZE) return std::nullopt;
+    unsigned int block_size;
+    unsigned int block_count;
+    memcpy(&block_size, stored, sizeof(unsigned int));
+    memcpy(&block_count, stored + sizeof(unsigned int), sizeof(unsigned int));
+    if ((block_size == 0) || (block_count != (asset_size + block_size - 1) / block_size)) return std::nullopt;
+    const size_t table_bytes = static_cast<size_t>(block_count) * sizeof(unsigned int);
+    if (BLOCK_TABLE_HEAD_SIZE + table_bytes > record.m_size) return std::nullopt;
+    std::vector<unsigned int> stored_sizes(block_count);
+    memcpy(stored_sizes.data(), stored + BLOCK_TABLE_HEAD_SIZE, table_bytes);
+
+    const unsigned int first_block = offset / block_size;
+    const unsigned int last_block = (offset + size - 1) / block_size;
+    std::vector<size_t> comp_offsets(last_block - first_block + 2, 0);
+    size_t comp_begin = BLOCK_TABLE_HEAD_SIZE + table_bytes;
+    for (unsigned int i = 0; i < first_block; i++)
+    {
+        comp_begin += stored_sizes[i] & ~AssetBlockCodec::STORED_RAW_FLAG;
+    }
+    for (unsigned int i = first_block; i <= last_block; i++)
+    {
+        comp_offsets[i - first_block + 1] = comp_offsets[i - first_block] + (stored_sizes[i] & ~AssetBlockCodec::STORED_RAW_FLAG);
+    }
+    if (comp_begin + comp_offsets.back() > record.m_size) return std::nullopt;
+
+    const size_t raw_begin = static_cast<size_t>(first_block) * block_size;
+    const size_t raw_end = std::min<size_t>(asset_size, static_cast<size_t>(last_block + 1) * block_size);
+    std::vector<char> raw_buff(raw_end - raw_begin);
+    std::atomic<bool> is_failed{ false };
+    auto decompress_blocks = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            const size_t block = first_block + i;
+            const size_t raw_size = std::min<size_t>(block_size, asset_size - block * block_size);
+            unsigned char* dst = reinterpret_cast<unsigned char*>(&raw_buff[block * block_size - raw_begin]);
+            if (!AssetBlockCodec::decompressStoredBlock(record.m_codec, stored_sizes[block], stored + comp_begin + comp_offsets[i], dst, raw_size))
+            {
+                is_failed = true;
+            }
+        }
+    };
+    const size_t touched_count = last_block - first_block + 1;
+    if ((m_parallelFor) && (touched_count >= PARALLEL_BLOCK_COUNT))
+    {
+        m_parallelFor(touched_count, decompress_blocks);
+    }
+    else
+    {
+        decompress_blocks(0, touched_count);
+    }
+    if (is_failed) return std::nullopt;
+    if ((offset == raw_begin) && (size == raw_buff.size())) return raw_buff;
+    return std::vector<char>(raw_buff.begin() + (offset - raw_begin), raw_buff.begin() + (offset - raw_begin) + size);
+}
@@ -0,0 +1,107 @@
+﻿/*********************************************************************
+ * \file   AssetPackageReader.h
+ * \brief  read-only asset package, memory mapped files & perfect hash index,
+ *          lock-free concurrent retrieval
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef ASSET_PACKAGE_READER_H
+#define ASSET_PACKAGE_READER_H
+
+#include "AssetHeaderDataMap.h"
+#include "AssetBlockCodec.h"
+#include "AssetPerfectHashIndex.h"
+#include <string>
+#include <string_view>
+#include <memory>
+#include <functional>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+namespace Enigma::AssetPackage
+{
+    class AssetMappedFile;
+
+    using error = std::error_code;
+    /** header & bundle 整個 map 進來, 開檔後的查詢與讀取都不上鎖, 可以多個 thread 同時讀.
+     只讀 checkpoint 過的 header, journal 還有資料時 (AssetPackageFile 還沒關) 開不起來 */
+    class AssetPackageReader
+    {
+    public:
+        /** 同 AssetPackageFile::ParallelForFunction */
+        using ParallelForFunction = std::function<void(size_t count, const std::function<void(size_t begin, size_t end)>& task)>;
+        /// 碰到的 block 數達到這個數量才平行解壓縮
+        constexpr static unsigned int PARALLEL_BLOCK_COUNT = 8;
+    public:
+        AssetPackageReader(const AssetPackageReader&) = delete;
+        AssetPackageReader(AssetPackageReader&&) = delete;
+        ~AssetPackageReader();
+        AssetPackageReader& operator=(const AssetPackageReader&) = delete;
+        AssetPackageReader& operator=(AssetPackageReader&&) = delete;
+
+        /** 有對得上 header 的 index file 就直接用, 否則在記憶體裡建 index; 失敗回傳 nullptr */
+        static AssetPackageReader* openPackage(const std::string& basefilename);
+        /** 同上, 失敗時帶回原因 */
+        static AssetPackageReader* openPackage(const std::string& basefilename, error& er);
+
+        const std::string& getBaseFilename() const { return m_baseFilename; }
+        bool isUsingPrebuiltIndex() const { return m_isPrebuiltIndex; }
+        /** 要在分享給其他 thread 之前設定; 沒有設定時, 大 asset 在呼叫的 thread 上解壓縮 */
+        void setParallelFor(const ParallelForFunction& parallel_for) { m_parallelFor = parallel_for; }
+
+        /** 把目前的 index 存成 index file, 之後開檔不用重建 */
+        error saveIndexFile() const;
+
+        size_t getAssetCount() const { return m_recordOffsets.size(); }
+        bool hasAsset(const std::string_view& asset_key) const;
+        std::optional<AssetHeaderDataMap::AssetHeaderData> tryGetAssetHeaderData(const std::string_view& asset_key) const;
+        unsigned int getAssetOriginalSize(const std::string_view& asset_key) const;
+        time_t getAssetTimeStamp(const std::string_view& asset_key) const;
+
+        std::optional<std::vector<char>> tryRetrieveAssetToMemory(const std::string_view& asset_key) const;
+        /** 只解壓縮 [offset, offset + size) 碰到的 block, 超出 asset 的部分截掉 */
+        std::optional<std::vector<char>> tryRetrieveAssetRange(const std::string_view& asset_key, unsigned int offset, unsigned int size) const;
+
+    private:
+        struct AssetRecord
+        {
+            unsigned int m_size;
+            unsigned int m_orgSize;
+            unsigned int m_offset;
+            unsigned int m_version;
+            AssetCodec m_codec;
+        };
+
+    private:
+        AssetPackageReader();
+        error openPackageImp(const std::string& basefilename);
+        error parseHeader();
+        error loadIndexFile();
+        error buildIndex();
+
+        /** 找不到回傳 nullptr, 指向 header mapping 中的 record (name 開頭) */
+        const char* findRecord(const std::string_view& asset_key) const;
+        AssetRecord readRecord(const char* record) const;
+        std::optional<std::vector<char>> decompressAssetRange(const AssetRecord& record, unsigned int offset, unsigned int size) const;
+
+    private:
+        std::string m_baseFilename;
+        std::unique_ptr<AssetMappedFile> m_headerFile;
+        std::unique_ptr<AssetMappedFile> m_bundleFile;
+        unsigned int m_formatTag;
+        size_t m_recordsBegin;
+        size_t m_recordsEnd;
+        std::uint64_t m_headerFingerprint;
+
+        AssetPerfectHashIndex m_index;
+        /// slot -> record 在 header file 中的 offset
+        std::vector<unsigned int> m_recordOffsets;
+        bool m_isPrebuiltIndex;
+
+        ParallelForFunction m_parallelFor;
+    };
+}
+
+#endif // ASSET_PACKAGE_READER_H
@@ -0,0 +1,125 @@
+﻿#include "AssetPerfectHashIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+using namespace Enigma::AssetPackage;
+
+static inline std::uint64_t mix64(std::uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+AssetPerfectHashIndex::AssetPerfectHashIndex() : m_keyCount(0)
+{
+}
+
+AssetPerfectHashIndex::~AssetPerfectHashIndex()
+{
+}
+
+std::optional<AssetPerfectHashIndex> AssetPerfectHashIndex::build(const std::vector<std::string_view>& keys)
+{
+    AssetPerfectHashIndex index;
+    index.m_keyCount = static_cast<unsigned int>(keys.size());
+    if (keys.empty()) return index;
+    const unsigned int bucket_count = (index.m_keyCount + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET;
+    index.m_seeds.assign(bucket_count, 0);
+
+    std::vector<std::vector<std::uint64_t>> buckets(bucket_count);
+    for (const auto& key : keys)
+    {
+        const std::uint64_t hash = hashKey(key);
+        buckets[(hash >> 32) % bucket_count].push_back(hash);
+    }
+    // 大的 bucket 先放, 空 slot 多的時候比較容易找到 seed
+    std::vector<unsigned int> order(bucket_count);
+    for (unsigned int i = 0; i < bucket_count; i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&buckets](unsigned int a, unsigned int b) { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<unsigned char> occupied(index.m_keyCount, 0);
+    std::vector<unsigned int> slots;
+    for (unsigned int bucket : order)
+    {
+        const auto& hashes = buckets[bucket];
+        if (hashes.empty()) break;
+        bool is_placed = false;
+        for (unsigned int seed = 0; (seed < MAX_SEED) && (!is_placed); seed++)
+        {
+            slots.clear();
+            for (std::uint64_t hash : hashes)
+            {
+                const unsigned int slot = slotOfHash(hash, seed, index.m_keyCount);
+                if ((occupied[slot]) || (std::find(slots.begin(), slots.end(), slot) != slots.end())) break;
+                slots.push_back(slot);
+            }
+            if (slots.size() != hashes.size()) continue;
+            for (unsigned int slot : slots) occupied[slot] = 1;
+            index.m_seeds[bucket] = seed;
+            is_placed = true;
+        }
+        if (!is_placed) return std::nullopt;
+    }
+    return index;
+}
+
+unsigned int AssetPerfectHashIndex::slotOf(std::string_view key) const
+{
+    assert(m_keyCount > 0);
+    const std::uint64_t hash = hashKey(key);
+    const unsigned int seed = m_seeds[(hash >> 32) % m_seeds.size()];
+    return slotOfHash(hash, seed, m_keyCount);
+}
+
+std::vector<char> AssetPerfectHashIndex::exportToByteBuffer() const
+{
+    const unsigned int bucket_count = static_cast<unsigned int>(m_seeds.size());
+    std::vector<char> buff(sizeof(unsigned int) * (2 + m_seeds.size()));
+    memcpy(&buff[0], &m_keyCount, sizeof(unsigned int));
+    memcpy(&buff[sizeof(unsigned int)], &bucket_count, sizeof(unsigned int));
+    if (bucket_count > 0)
+    {
+        memcpy(&buff[sizeof(unsigned int) * 2], m_seeds.data(), sizeof(unsigned int) * bucket_count);
+    }
+    return buff;
+}
+
+std::optional<std::pair<AssetPerfectHashIndex, size_t>> AssetPerfectHashIndex::importFromBytes(const char* data, size_t size)
+{
+    if (size < sizeof(unsigned int) * 2) return std::nullopt;
+    AssetPerfectHashIndex index;
+    unsigned int bucket_count;
+    memcpy(&index.m_keyCount, data, sizeof(unsigned int));
+    memcpy(&bucket_count, data + sizeof(unsigned int), sizeof(unsigned int));
+    if (bucket_count != (index.m_keyCount + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET) return std::nullopt;
+    const size_t read_bytes = sizeof(unsigned int) * (2 + static_cast<size_t>(bucket_count));
+    if (size < read_bytes) return std::nullopt;
+    index.m_seeds.resize(bucket_count);
+    if (bucket_count > 0)
+    {
+        memcpy(index.m_seeds.data(), data + sizeof(unsigned int) * 2, sizeof(unsigned int) * bucket_count);
+    }
+    return std::make_pair(std::move(index), read_bytes);
+}
+
+std::uint64_t AssetPerfectHashIndex::hashKey(std::string_view key)
+{
+    // FNV-1a 再 mix, 高 32 bits 選 bucket, 整個 hash 配 seed 算 slot
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : key)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return mix64(hash);
+}
+
+unsigned int AssetPerfectHashIndex::slotOfHash(std::uint64_t hash, unsigned int seed, unsigned int slot_count)
+{
+    return static_cast<unsigned int>(mix64(hash ^ (static_cast<std::uint64_t>(seed) * 0x9e3779b97f4a7c15ull)) % slot_count);
+}
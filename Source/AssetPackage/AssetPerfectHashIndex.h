@@ -0,0 +1,58 @@
+﻿/*********************************************************************
+ * \file   AssetPerfectHashIndex.h
+ * \brief  minimal perfect hash over asset keys (hash & displace)
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef ASSET_PERFECT_HASH_INDEX_H
+#define ASSET_PERFECT_HASH_INDEX_H
+
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+
+namespace Enigma::AssetPackage
+{
+    /** n 個 key 對應到 [0, n) 不重複的 slot. key 先分到 bucket, 每個 bucket 找一個 seed 讓 bucket 內的 key 都落在空的 slot;
+     查詢只要算一次 hash 加一次 mix, 不在 build 時的 key 也會得到某個 slot, 呼叫端要自己比對 key */
+    class AssetPerfectHashIndex
+    {
+    public:
+        /// 平均每個 bucket 的 key 數, 越大 seed 越難找, 越小 seed table 越大
+        static constexpr unsigned int KEYS_PER_BUCKET = 4;
+        static constexpr unsigned int MAX_SEED = 1u << 24;
+
+    public:
+        AssetPerfectHashIndex();
+        AssetPerfectHashIndex(const AssetPerfectHashIndex&) = delete;
+        AssetPerfectHashIndex(AssetPerfectHashIndex&&) = default;
+        ~AssetPerfectHashIndex();
+        AssetPerfectHashIndex& operator=(const AssetPerfectHashIndex&) = delete;
+        AssetPerfectHashIndex& operator=(AssetPerfectHashIndex&&) = default;
+
+        /** keys 不可重複, 找不到 seed (64 bit hash 相撞) 時回傳 nullopt */
+        static std::optional<AssetPerfectHashIndex> build(const std::vector<std::string_view>& keys);
+
+        unsigned int slotOf(std::string_view key) const;
+        unsigned int getKeyCount() const { return m_keyCount; }
+
+        /** key count, bucket count, seeds */
+        std::vector<char> exportToByteBuffer() const;
+        /** 回傳讀取的 bytes 數, 資料不完整時回傳 nullopt */
+        static std::optional<std::pair<AssetPerfectHashIndex, size_t>> importFromBytes(const char* data, size_t size);
+
+        static std::uint64_t hashKey(std::string_view key);
+
+    private:
+        static unsigned int slotOfHash(std::uint64_t hash, unsigned int seed, unsigned int slot_count);
+
+    private:
+        unsigned int m_keyCount;
+        std::vector<unsigned int> m_seeds;
+    };
+}
+
+#endif // ASSET_PERFECT_HASH_INDEX_H
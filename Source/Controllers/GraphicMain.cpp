@@ -2,6 +2,8 @@
 #include "Frameworks/EventPublisher.h"
 #include "Frameworks/CommandBus.h"
 #include "Frameworks/QueryDispatcher.h"
+#include "Frameworks/FrameProfiler.h"
+#include "Frameworks/WorkerThreadPool.h"
 #include "Platforms/MemoryMacro.h"
 #include "ControllerErrors.h"
 #include "ControllerEvents.h"
@@ -11,17 +13,24 @@
 using namespace Enigma::Controllers;
 GraphicMain* GraphicMain::m_instance = nullptr;
 
+static constexpr float SERVICE_FRAME_BUDGET_MILLISECONDS = 8.0f;
+
 GraphicMain::GraphicMain()
 {
     assert(!m_instance);
     m_instance = this;
     m_serviceManager = menew Frameworks::ServiceManager();
+    m_serviceManager->frameBudget(SERVICE_FRAME_BUDGET_MILLISECONDS);
+    // render engine 安裝前就要有, installing policy 從 service manager 取得 pool
+    m_workers = std::make_shared<Frameworks::WorkerThreadPool>();
+    m_serviceManager->enableConcurrentTicking(m_workers);
 }
 
 GraphicMain::~GraphicMain()
 {
     m_instance = nullptr;
     delete m_serviceManager;
+    m_workers = nullptr;
 }
 
 GraphicMain* GraphicMain::instance()
@@ -33,6 +42,7 @@ GraphicMain* GraphicMain::instance()
 error GraphicMain::installFrameworks()
 {
     assert(m_serviceManager);
+    PROFILE_THREAD_NAME("MainThread");
     m_serviceManager->registerSystemService(std::make_shared<Frameworks::EventPublisher>(m_serviceManager));
     m_serviceManager->registerSystemService(std::make_shared <Frameworks::CommandBus>(m_serviceManager));
     m_serviceManager->registerSystemService(std::make_shared<Frameworks::QueryDispatcher>(m_serviceManager));
@@ -83,5 +93,6 @@ void GraphicMain::frameUpdate()
     {
         m_serviceManager->runOnce();
     }
+    PROFILE_FRAME_END();
 }
 
@@ -12,6 +12,12 @@
 #include "InstallingPolicyList.h"
 #include <system_error>
 #include <cassert>
+#include <memory>
+
+namespace Enigma::Frameworks
+{
+    class WorkerThreadPool;
+}
 
 namespace Enigma::Controllers
 {
@@ -41,6 +47,8 @@ namespace Enigma::Controllers
         void frameUpdate();
 
         Frameworks::ServiceManager* getServiceManager() { return m_serviceManager; };
+        /** service 的 concurrent tick 及 service 內的平行工作 (culling, broadphase, texture streaming) 共用的 pool */
+        const std::shared_ptr<Frameworks::WorkerThreadPool>& workerThreadPool() const { return m_workers; }
 
         template <class T>
         std::shared_ptr<T> getSystemServiceAs()
@@ -53,6 +61,7 @@ namespace Enigma::Controllers
         static GraphicMain* m_instance;
 
         Frameworks::ServiceManager* m_serviceManager;
+        std::shared_ptr<Frameworks::WorkerThreadPool> m_workers;
 
         InstallingPolicyList m_policies;
     };
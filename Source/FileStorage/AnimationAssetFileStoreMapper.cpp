@@ -7,10 +7,9 @@
 
 using namespace Enigma::FileStorage;
 
-AnimationAssetFileStoreMapper::AnimationAssetFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : AnimationAssetStoreMapper()
+AnimationAssetFileStoreMapper::AnimationAssetFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : AnimationAssetStoreMapper(), m_gateways(gateway), m_journal(mapper_filename)
 {
     m_mapper_filename = mapper_filename;
-    m_gateway = gateway;
     m_has_connected = false;
 }
 
@@ -24,23 +23,25 @@ std::error_code AnimationAssetFileStoreMapper::connect()
 {
     if (m_has_connected) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_file_map_lock };
+    if (m_has_connected) return FileSystem::ErrorCode::ok;
     m_filename_map.clear();
-    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::read | FileSystem::binary);
-    if (!mapper_file)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    const auto file_size = mapper_file->size();
-    if (file_size == 0)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto content = mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
+    auto content = m_journal.readMapperFile();
     if (!content) return FileSystem::ErrorCode::readFail;
-    deserializeMapperFile(std::string(content->begin(), content->end()));
+    deserializeMapperFile(content.value());
+    auto er = m_journal.replay([this](bool is_put, const std::string& record)
+        {
+            auto rec = parseMapperRecord(record);
+            if (!rec) return;
+            if (is_put)
+            {
+                m_filename_map.insert_or_assign(rec->first, rec->second);
+            }
+            else
+            {
+                m_filename_map.erase(rec->first);
+            }
+        });
+    if (er) return er;
     m_has_connected = true;
     return FileSystem::ErrorCode::ok;
 }
@@ -48,21 +49,25 @@ std::error_code AnimationAssetFileStoreMapper::connect()
 std::error_code AnimationAssetFileStoreMapper::disconnect()
 {
     std::lock_guard locker{ m_file_map_lock };
+    // compact 失敗, journal 還在, 下次 connect 仍可 replay; 狀態照樣清掉, 把錯誤回報出去
+    std::error_code er;
+    if ((m_has_connected) && (m_journal.recordCount() > 0)) er = m_journal.compact(serializeMapperFile());
     m_filename_map.clear();
     m_has_connected = false;
+    if (er) return er;
     return FileSystem::ErrorCode::ok;
 }
 
 bool AnimationAssetFileStoreMapper::hasAnimationAsset(const Animators::AnimationAssetId& id)
 {
     if (!m_has_connected) connect();
-    std::lock_guard locker{ m_file_map_lock };
+    std::shared_lock locker{ m_file_map_lock };
     return m_filename_map.find(id) != m_filename_map.end();
 }
 
 std::optional<Enigma::Engine::GenericDto> AnimationAssetFileStoreMapper::queryAnimationAsset(const Animators::AnimationAssetId& id)
 {
-    std::lock_guard locker{ m_file_map_lock };
+    std::shared_lock locker{ m_file_map_lock };
     auto it = m_filename_map.find(id);
     if (it == m_filename_map.end()) return std::nullopt;
     return deserializeDataTransferObject(it->second);
@@ -72,10 +77,10 @@ std::error_code AnimationAssetFileStoreMapper::putAnimationAsset(const Animators
 {
     auto filename = extractFilename(id, dto.getRtti());
     std::lock_guard locker{ m_file_map_lock };
-    m_filename_map.insert_or_assign(id, filename);
-    auto er = serializeMapperFile();
+    auto er = serializeDataTransferObject(filename, dto);
     if (er) return er;
-    er = serializeDataTransferObject(filename, dto);
+    m_filename_map.insert_or_assign(id, filename);
+    er = journalRecord(true, formatMapperRecord(id, filename));
     if (er) return er;
     return Animators::ErrorCode::ok;
 }
@@ -83,42 +88,57 @@ std::error_code AnimationAssetFileStoreMapper::putAnimationAsset(const Animators
 std::error_code AnimationAssetFileStoreMapper::removeAnimationAsset(const Animators::AnimationAssetId& id)
 {
     std::lock_guard locker{ m_file_map_lock };
-    m_filename_map.erase(id);
-    auto er = serializeMapperFile();
+    auto it = m_filename_map.find(id);
+    if (it == m_filename_map.end()) return Animators::ErrorCode::ok;
+    const auto record = formatMapperRecord(it->first, it->second);
+    m_filename_map.erase(it);
+    auto er = journalRecord(false, record);
     if (er) return er;
     return Animators::ErrorCode::ok;
 }
 
-std::error_code AnimationAssetFileStoreMapper::serializeMapperFile()
+std::string AnimationAssetFileStoreMapper::serializeMapperFile() const
 {
-    std::lock_guard locker{ m_file_map_lock };
     std::string mapper_file_content;
     for (auto& rec : m_filename_map)
     {
-        mapper_file_content += rec.first.name() + "," + rec.second + "\n";
+        mapper_file_content += formatMapperRecord(rec.first, rec.second) + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    const auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
-    return FileSystem::ErrorCode::ok;
+    return mapper_file_content;
 }
 
 void AnimationAssetFileStoreMapper::deserializeMapperFile(const std::string& mapper_file_content)
 {
     if (mapper_file_content.empty()) return;
-    std::lock_guard locker{ m_file_map_lock };
     auto lines = split_token(mapper_file_content, "\n\r");
     for (auto& line : lines)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 2) continue;
-        Animators::AnimationAssetId id{ tokens[0] };
-        m_filename_map.insert_or_assign(id, tokens[1]);
+        auto rec = parseMapperRecord(line);
+        if (!rec) continue;
+        m_filename_map.insert_or_assign(rec->first, rec->second);
     }
 }
 
+std::string AnimationAssetFileStoreMapper::formatMapperRecord(const Animators::AnimationAssetId& id, const std::string& filename)
+{
+    return id.name() + "," + filename;
+}
+
+std::optional<std::pair<Enigma::Animators::AnimationAssetId, std::string>> AnimationAssetFileStoreMapper::parseMapperRecord(const std::string& line)
+{
+    auto tokens = split_token(line, ",");
+    if (tokens.size() != 2) return std::nullopt;
+    return std::make_pair(Animators::AnimationAssetId{ tokens[0] }, tokens[1]);
+}
+
+std::error_code AnimationAssetFileStoreMapper::journalRecord(bool is_put, const std::string& record)
+{
+    auto er = is_put ? m_journal.appendPut(record) : m_journal.appendRemove(record);
+    if (er) return er;
+    if (m_journal.needCompaction()) return m_journal.compact(serializeMapperFile());
+    return FileSystem::ErrorCode::ok;
+}
+
 std::string AnimationAssetFileStoreMapper::extractFilename(const Animators::AnimationAssetId& id, const Engine::FactoryDesc& factory_desc)
 {
     if (!factory_desc.deferredFilename().empty()) return factory_desc.deferredFilename();
@@ -128,10 +148,11 @@ std::string AnimationAssetFileStoreMapper::extractFilename(const Animators::Anim
 
 std::error_code AnimationAssetFileStoreMapper::serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     FileSystem::IFilePtr dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::write | FileSystem::binary);
     if (!dto_file) return FileSystem::ErrorCode::fileOpenError;
-    auto content = m_gateway->serialize({ dto });
+    auto content = gateway->serialize({ dto });
     auto write_size = dto_file->write(0, { content.begin(), content.end() });
     FileSystem::FileSystem::instance()->closeFile(dto_file);
     if (write_size != content.size()) return FileSystem::ErrorCode::writeFail;
@@ -140,13 +161,14 @@ std::error_code AnimationAssetFileStoreMapper::serializeDataTransferObject(const
 
 Enigma::Engine::GenericDto AnimationAssetFileStoreMapper::deserializeDataTransferObject(const std::string& filename)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     auto dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::read | FileSystem::binary);
     auto file_size = dto_file->size();
-    auto content = dto_file->read(0, file_size);
+    auto content = dto_file->view(0, file_size);
     assert(content.has_value());
     FileSystem::FileSystem::instance()->closeFile(dto_file);
-    const auto dtos = m_gateway->deserialize(std::string(content.value().begin(), content.value().end()));
+    const auto dtos = gateway->deserializeBuffer(content->chars(), content->size());
     assert(!dtos.empty());
     return dtos[0];
 }
@@ -9,10 +9,13 @@
 #define ANIMATOR_FILE_STORE_MAPPER_H
 
 #include "GameEngine/GenericDto.h"
-#include "Gateways/DtoGateway.h"
+#include "Gateways/DtoGatewaySelector.h"
 #include "Animators/AnimatorStoreMapper.h"
 #include "Animators/AnimatorId.h"
+#include "MapperFileJournal.h"
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
 
 namespace Enigma::FileStorage
 {
@@ -36,19 +39,24 @@ namespace Enigma::FileStorage
         virtual std::uint64_t nextSequenceNumber() override;
 
     protected:
-        std::error_code serializeMapperFile();
+        std::string serializeMapperFile() const;
         void deserializeMapperFile(const std::string& mapper_file_content);
+        static std::string formatMapperRecord(const Animators::AnimatorId& id, const std::string& filename);
+        static std::optional<std::pair<Animators::AnimatorId, std::string>> parseMapperRecord(const std::string& line);
+        std::error_code journalRecord(bool is_put, const std::string& record);
         std::string extractFilename(const Animators::AnimatorId& id, const Engine::FactoryDesc& factory_desc);
 
         std::error_code serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto);
         Engine::GenericDto deserializeDataTransferObject(const std::string& filename);
 
     protected:
-        bool m_has_connected;
-        std::shared_ptr<Gateways::IDtoGateway> m_gateway;
+        std::atomic_bool m_has_connected;
+        Gateways::DtoGatewaySelector m_gateways;
         std::string m_mapper_filename;
+        MapperFileJournal m_journal;
         std::unordered_map<Animators::AnimatorId, std::string, Animators::AnimatorId::hash> m_filename_map;
-        mutable std::recursive_mutex m_file_map_lock;
+        //! ADR: query 拿 shared lock 讀檔, put 拿 exclusive lock 寫檔; query 之間仍可平行
+        mutable std::shared_mutex m_file_map_lock;
         std::uint64_t m_sequence_number;
     };
 }
@@ -21,6 +21,7 @@ std::error_code EffectMaterialSourceFileStoreMapper::connect()
 {
     if (m_has_connected) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_fileMapLock };
+    if (m_has_connected) return FileSystem::ErrorCode::ok;
     m_filename_map.clear();
     FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::read | FileSystem::binary);
     if (!mapper_file)
@@ -34,10 +35,10 @@ std::error_code EffectMaterialSourceFileStoreMapper::connect()
         m_has_connected = true;
         return FileSystem::ErrorCode::ok;
     }
-    auto content = mapper_file->read(0, file_size);
+    auto content = mapper_file->view(0, file_size);
     FileSystem::FileSystem::instance()->closeFile(mapper_file);
     if (!content) return FileSystem::ErrorCode::readFail;
-    deserializeMapperFile(std::string(content->begin(), content->end()));
+    deserializeMapperFile(std::string(content->asStringView()));
     m_has_connected = true;
     return FileSystem::ErrorCode::ok;
 }
@@ -53,22 +54,25 @@ std::error_code EffectMaterialSourceFileStoreMapper::disconnect()
 bool EffectMaterialSourceFileStoreMapper::hasEffectMaterial(const EffectMaterialId& id)
 {
     if (!m_has_connected) connect();
-    std::lock_guard locker{ m_fileMapLock };
+    std::shared_lock locker{ m_fileMapLock };
     return m_filename_map.find(id) != m_filename_map.end();
 }
 
 std::optional<EffectCompilingProfile> EffectMaterialSourceFileStoreMapper::queryEffectMaterial(const EffectMaterialId& id)
 {
-    std::lock_guard locker{ m_fileMapLock };
-    auto it = m_filename_map.find(id);
-    if (it == m_filename_map.end()) return std::nullopt;
-    return deserializeEffectCompilingProfile(it->second);
+    std::string filename;
+    {
+        std::shared_lock locker{ m_fileMapLock };
+        auto it = m_filename_map.find(id);
+        if (it == m_filename_map.end()) return std::nullopt;
+        filename = it->second;
+    }
+    return deserializeEffectCompilingProfile(filename);
 }
 
 void EffectMaterialSourceFileStoreMapper::deserializeMapperFile(const std::string& mapper_file_content)
 {
     if (mapper_file_content.empty()) return;
-    std::lock_guard locker{ m_fileMapLock };
     auto lines = split_token(mapper_file_content, "\n\r");
     for (auto& line : lines)
     {
@@ -81,11 +85,12 @@ void EffectMaterialSourceFileStoreMapper::deserializeMapperFile(const std::strin
 
 std::optional<EffectCompilingProfile> EffectMaterialSourceFileStoreMapper::deserializeEffectCompilingProfile(const std::string& filename)
 {
-    m_gateway.cleanup();
     auto efx_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::read | FileSystem::binary);
     auto file_size = efx_file->size();
-    auto content = efx_file->read(0, file_size);
+    auto content = efx_file->view(0, file_size);
     assert(content.has_value());
     FileSystem::FileSystem::instance()->closeFile(efx_file);
-    return m_gateway.Deserialize(std::string(content.value().begin(), content.value().end()));
+    // gateway 有解析中的狀態, 每次 query 用自己的 gateway, 才能同時解析
+    Gateways::EffectProfileJsonGateway gateway;
+    return gateway.Deserialize(std::string(content->asStringView()));
 }
@@ -11,6 +11,9 @@
 #include "GameEngine/EffectMaterialSourceStoreMapper.h"
 #include "GameEngine/EffectCompilingProfile.h"
 #include "Gateways/EffectProfileJsonGateway.h"
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
 
 namespace Enigma::FileStorage
 {
@@ -31,11 +34,11 @@ namespace Enigma::FileStorage
         std::optional<Engine::EffectCompilingProfile> deserializeEffectCompilingProfile(const std::string& filename);
 
     protected:
-        bool m_has_connected;
-        Gateways::EffectProfileJsonGateway m_gateway;
+        std::atomic_bool m_has_connected;
         std::string m_mapper_filename;
         std::unordered_map<Engine::EffectMaterialId, std::string, Engine::EffectMaterialId::hash> m_filename_map;
-        mutable std::recursive_mutex m_fileMapLock;
+        //! ADR: lock 只保護 id -> filename 的查詢, 讀檔跟 deserialize 都在 lock 之外
+        mutable std::shared_mutex m_fileMapLock;
     };
 }
 
@@ -6,10 +6,9 @@
 
 using namespace Enigma::FileStorage;
 
-GeometryDataFileStoreMapper::GeometryDataFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : Geometries::GeometryDataStoreMapper()
+GeometryDataFileStoreMapper::GeometryDataFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : Geometries::GeometryDataStoreMapper(), m_gateways(gateway), m_journal(mapper_filename)
 {
     m_mapper_filename = mapper_filename;
-    m_gateway = gateway;
     m_has_connected = false;
 }
 
@@ -23,23 +22,19 @@ std::error_code GeometryDataFileStoreMapper::connect()
 {
     if (m_has_connected) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_fileMapLock };
+    if (m_has_connected) return FileSystem::ErrorCode::ok;
     m_filename_map.clear();
-    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::read | FileSystem::binary);
-    if (!mapper_file)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto file_size = mapper_file->size();
-    if (file_size == 0)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto content = mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
+    auto content = m_journal.readMapperFile();
     if (!content) return FileSystem::ErrorCode::readFail;
-    deserializeMapperFile(std::string(content->begin(), content->end()));
+    deserializeMapperFile(content.value());
+    auto er = m_journal.replay([this](bool is_put, const std::string& record)
+        {
+            auto rec = parseMapperRecord(record);
+            if (!rec) return;
+            if (is_put) m_filename_map.insert_or_assign(rec->first, rec->second);
+            else m_filename_map.erase(rec->first);
+        });
+    if (er) return er;
     m_has_connected = true;
     return FileSystem::ErrorCode::ok;
 }
@@ -47,21 +42,25 @@ std::error_code GeometryDataFileStoreMapper::connect()
 std::error_code GeometryDataFileStoreMapper::disconnect()
 {
     std::lock_guard locker{ m_fileMapLock };
+    // compact 失敗, journal 還在, 下次 connect 仍可 replay; 狀態照樣清掉, 把錯誤回報出去
+    std::error_code er;
+    if ((m_has_connected) && (m_journal.recordCount() > 0)) er = m_journal.compact(serializeMapperFile());
     m_filename_map.clear();
     m_has_connected = false;
+    if (er) return er;
     return FileSystem::ErrorCode::ok;
 }
 
 bool GeometryDataFileStoreMapper::hasGeometry(const Geometries::GeometryId& id)
 {
     if (!m_has_connected) connect();
-    std::lock_guard locker{ m_fileMapLock };
+    std::shared_lock locker{ m_fileMapLock };
     return m_filename_map.find(id) != m_filename_map.end();
 }
 
 std::optional<Enigma::Engine::GenericDto> GeometryDataFileStoreMapper::queryGeometry(const Geometries::GeometryId& id)
 {
-    std::lock_guard locker{ m_fileMapLock };
+    std::shared_lock locker{ m_fileMapLock };
     auto it = m_filename_map.find(id);
     if (it == m_filename_map.end()) return std::nullopt;
     return deserializeDataTransferObject(it->second);
@@ -70,8 +69,11 @@ std::optional<Enigma::Engine::GenericDto> GeometryDataFileStoreMapper::queryGeom
 std::error_code GeometryDataFileStoreMapper::removeGeometry(const Geometries::GeometryId& id)
 {
     std::lock_guard locker{ m_fileMapLock };
-    m_filename_map.erase(id);
-    auto er = serializeMapperFile();
+    auto it = m_filename_map.find(id);
+    if (it == m_filename_map.end()) return Engine::ErrorCode::ok;
+    const auto record = formatMapperRecord(it->first, it->second);
+    m_filename_map.erase(it);
+    auto er = journalRecord(false, record);
     if (er) return er;
     return Engine::ErrorCode::ok;
 }
@@ -80,44 +82,56 @@ std::error_code GeometryDataFileStoreMapper::putGeometry(const Geometries::Geome
 {
     auto filename = extractFilename(id, dto.getRtti());
     std::lock_guard locker{ m_fileMapLock };
-    m_filename_map.insert_or_assign(id, filename);
-    auto er = serializeMapperFile();
+    auto er = serializeDataTransferObject(filename, dto);
     if (er) return er;
-    er = serializeDataTransferObject(filename, dto);
+    m_filename_map.insert_or_assign(id, filename);
+    er = journalRecord(true, formatMapperRecord(id, filename));
     if (er) return er;
     return Engine::ErrorCode::ok;
 }
 
-std::error_code GeometryDataFileStoreMapper::serializeMapperFile()
+std::string GeometryDataFileStoreMapper::serializeMapperFile() const
 {
-    std::lock_guard locker{ m_fileMapLock };
     std::string mapper_file_content;
     for (auto& rec : m_filename_map)
     {
-        mapper_file_content += rec.first.name() + "," + rec.second + "\n";
+        mapper_file_content += formatMapperRecord(rec.first, rec.second) + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
-    return FileSystem::ErrorCode::ok;
+    return mapper_file_content;
 }
 
 void GeometryDataFileStoreMapper::deserializeMapperFile(const std::string& mapper_file_content)
 {
     if (mapper_file_content.empty()) return;
-    std::lock_guard locker{ m_fileMapLock };
     auto lines = split_token(mapper_file_content, "\n\r");
     for (auto& line : lines)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 2) continue;
-        Geometries::GeometryId id{ tokens[0] };
-        m_filename_map.insert_or_assign(id, tokens[1]);
+        auto rec = parseMapperRecord(line);
+        if (!rec) continue;
+        m_filename_map.insert_or_assign(rec->first, rec->second);
     }
 }
 
+std::string GeometryDataFileStoreMapper::formatMapperRecord(const Geometries::GeometryId& id, const std::string& filename)
+{
+    return id.name() + "," + filename;
+}
+
+std::optional<std::pair<Enigma::Geometries::GeometryId, std::string>> GeometryDataFileStoreMapper::parseMapperRecord(const std::string& line)
+{
+    auto tokens = split_token(line, ",");
+    if (tokens.size() != 2) return std::nullopt;
+    return std::make_pair(Geometries::GeometryId{ tokens[0] }, tokens[1]);
+}
+
+std::error_code GeometryDataFileStoreMapper::journalRecord(bool is_put, const std::string& record)
+{
+    auto er = is_put ? m_journal.appendPut(record) : m_journal.appendRemove(record);
+    if (er) return er;
+    if (m_journal.needCompaction()) return m_journal.compact(serializeMapperFile());
+    return FileSystem::ErrorCode::ok;
+}
+
 std::string GeometryDataFileStoreMapper::extractFilename(const Geometries::GeometryId& id, const Engine::FactoryDesc& factory_desc)
 {
     if (!factory_desc.deferredFilename().empty()) return factory_desc.deferredFilename();
@@ -127,10 +141,11 @@ std::string GeometryDataFileStoreMapper::extractFilename(const Geometries::Geome
 
 std::error_code GeometryDataFileStoreMapper::serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     FileSystem::IFilePtr dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::write | FileSystem::binary);
     if (!dto_file) return FileSystem::ErrorCode::fileOpenError;
-    auto content = m_gateway->serialize({ dto });
+    auto content = gateway->serialize({ dto });
     auto write_size = dto_file->write(0, { content.begin(), content.end() });
     FileSystem::FileSystem::instance()->closeFile(dto_file);
     if (write_size != content.size()) return FileSystem::ErrorCode::writeFail;
@@ -139,13 +154,14 @@ std::error_code GeometryDataFileStoreMapper::serializeDataTransferObject(const s
 
 Enigma::Engine::GenericDto GeometryDataFileStoreMapper::deserializeDataTransferObject(const std::string& filename)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     auto dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::read | FileSystem::binary);
     auto file_size = dto_file->size();
-    auto content = dto_file->read(0, file_size);
+    auto content = dto_file->view(0, file_size);
     assert(content.has_value());
     FileSystem::FileSystem::instance()->closeFile(dto_file);
-    const auto dtos = m_gateway->deserialize(std::string(content.value().begin(), content.value().end()));
+    const auto dtos = gateway->deserializeBuffer(content->chars(), content->size());
     assert(!dtos.empty());
     return dtos[0];
 }
@@ -9,10 +9,13 @@
 #define GEOMETRY_DATA_FILE_STORE_MAPPER_H
 
 #include "GameEngine/FactoryDesc.h"
-#include "Gateways/DtoGateway.h"
+#include "Gateways/DtoGatewaySelector.h"
 #include "Geometries/GeometryDataStoreMapper.h"
 #include "Geometries/GeometryId.h"
+#include "MapperFileJournal.h"
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
 
 namespace Enigma::FileStorage
 {
@@ -35,19 +38,24 @@ namespace Enigma::FileStorage
         virtual std::error_code putGeometry(const Geometries::GeometryId& id, const Engine::GenericDto& dto) override;
 
     protected:
-        std::error_code serializeMapperFile();
+        std::string serializeMapperFile() const;
         void deserializeMapperFile(const std::string& mapper_file_content);
+        static std::string formatMapperRecord(const Geometries::GeometryId& id, const std::string& filename);
+        static std::optional<std::pair<Geometries::GeometryId, std::string>> parseMapperRecord(const std::string& line);
+        std::error_code journalRecord(bool is_put, const std::string& record);
         std::string extractFilename(const Geometries::GeometryId& id, const Engine::FactoryDesc& factory_desc);
 
         std::error_code serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto);
         Engine::GenericDto deserializeDataTransferObject(const std::string& filename);
 
     protected:
-        bool m_has_connected;
-        std::shared_ptr<Gateways::IDtoGateway> m_gateway;
+        std::atomic_bool m_has_connected;
+        Gateways::DtoGatewaySelector m_gateways;
         std::string m_mapper_filename;
+        MapperFileJournal m_journal;
         std::unordered_map<Geometries::GeometryId, std::string, Geometries::GeometryId::hash> m_filename_map;
-        mutable std::recursive_mutex m_fileMapLock;
+        //! ADR: query 拿 shared lock 讀檔, put 拿 exclusive lock 寫檔; query 之間仍可平行
+        mutable std::shared_mutex m_fileMapLock;
     };
 }
 
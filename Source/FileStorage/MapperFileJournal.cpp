@@ -0,0 +1,131 @@
+﻿#include "MapperFileJournal.h"
+#include "FileSystem/FileSystem.h"
+#include "FileSystem/FileSystemErrors.h"
+#include "Frameworks/TokenVector.h"
+
+using namespace Enigma::FileStorage;
+
+static constexpr char PUT_MARK = '+';
+static constexpr char REMOVE_MARK = '-';
+
+static std::string makeJournalFilename(const std::string& mapper_filename)
+{
+    // filename 格式是 "name@PathId", 副檔名要加在 '@' 之前
+    const auto at_pos = mapper_filename.find('@');
+    if (at_pos == std::string::npos) return mapper_filename + ".journal";
+    return mapper_filename.substr(0, at_pos) + ".journal" + mapper_filename.substr(at_pos);
+}
+
+MapperFileJournal::MapperFileJournal(const std::string& mapper_filename, unsigned compact_threshold)
+    : m_mapperFilename(mapper_filename), m_journalFilename(makeJournalFilename(mapper_filename)), m_compactThreshold(compact_threshold), m_recordCount(0)
+{
+}
+
+MapperFileJournal::~MapperFileJournal()
+{
+}
+
+std::optional<std::string> MapperFileJournal::readMapperFile() const
+{
+    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapperFilename, FileSystem::read | FileSystem::binary);
+    if (!mapper_file) return std::string{};
+    auto file_size = mapper_file->size();
+    if (file_size == 0)
+    {
+        FileSystem::FileSystem::instance()->closeFile(mapper_file);
+        return std::string{};
+    }
+    auto content = mapper_file->view(0, file_size);
+    FileSystem::FileSystem::instance()->closeFile(mapper_file);
+    if (!content) return std::nullopt;
+    return std::string(content->asStringView());
+}
+
+std::error_code MapperFileJournal::replay(const RecordReplayer& replayer)
+{
+    m_recordCount = 0;
+    FileSystem::IFilePtr journal_file = FileSystem::FileSystem::instance()->openFile(m_journalFilename, FileSystem::read | FileSystem::binary);
+    if (!journal_file) return FileSystem::ErrorCode::ok;
+    auto file_size = journal_file->size();
+    if (file_size == 0)
+    {
+        FileSystem::FileSystem::instance()->closeFile(journal_file);
+        return FileSystem::ErrorCode::ok;
+    }
+    auto content = journal_file->view(0, file_size);
+    FileSystem::FileSystem::instance()->closeFile(journal_file);
+    if (!content) return FileSystem::ErrorCode::readFail;
+    // 每筆紀錄都以換行結尾, 最後一行沒有換行是寫到一半中斷的紀錄, 略過;
+    // 並把它從 journal 截掉, 免得之後附加的紀錄接在它後面
+    const auto text = content->asStringView();
+    const auto last_line_end = text.find_last_of('\n');
+    const std::string complete_records = last_line_end == std::string_view::npos ? std::string{} : std::string(text.substr(0, last_line_end + 1));
+    const bool has_torn_record = complete_records.size() != text.size();
+    // view 可能是 mmap, 要先放掉才能截檔
+    content.reset();
+    if (has_torn_record)
+    {
+        auto er = rewriteJournal(complete_records);
+        if (er) return er;
+    }
+    auto lines = split_token(complete_records, "\n\r");
+    for (auto& line : lines)
+    {
+        if (line.size() < 2) continue;
+        if ((line[0] != PUT_MARK) && (line[0] != REMOVE_MARK)) continue;
+        replayer(line[0] == PUT_MARK, line.substr(1));
+        m_recordCount++;
+    }
+    return FileSystem::ErrorCode::ok;
+}
+
+std::error_code MapperFileJournal::appendPut(const std::string& record)
+{
+    return appendLine(PUT_MARK + record + "\n");
+}
+
+std::error_code MapperFileJournal::appendRemove(const std::string& record)
+{
+    return appendLine(REMOVE_MARK + record + "\n");
+}
+
+std::error_code MapperFileJournal::compact(const std::string& mapper_file_content)
+{
+    // 先寫完整的 mapper file, 再清 journal; 中間中斷的話, 重播 journal 的結果還是一樣
+    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapperFilename, FileSystem::write | FileSystem::binary);
+    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
+    size_t write_size = 0;
+    if (!mapper_file_content.empty()) write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
+    FileSystem::FileSystem::instance()->closeFile(mapper_file);
+    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
+
+    auto er = rewriteJournal("");
+    if (er) return er;
+    m_recordCount = 0;
+    return FileSystem::ErrorCode::ok;
+}
+
+std::error_code MapperFileJournal::rewriteJournal(const std::string& journal_content)
+{
+    // write only 開檔會清空內容
+    auto journal_file = FileSystem::FileSystem::instance()->openFile(m_journalFilename, FileSystem::write | FileSystem::binary);
+    if (!journal_file) return FileSystem::ErrorCode::fileOpenError;
+    size_t write_size = 0;
+    if (!journal_content.empty()) write_size = journal_file->write(0, { journal_content.begin(), journal_content.end() });
+    FileSystem::FileSystem::instance()->closeFile(journal_file);
+    if (write_size != journal_content.size()) return FileSystem::ErrorCode::writeFail;
+    return FileSystem::ErrorCode::ok;
+}
+
+std::error_code MapperFileJournal::appendLine(const std::string& line)
+{
+    auto journal_file = FileSystem::FileSystem::instance()->openFile(m_journalFilename, FileSystem::read | FileSystem::write | FileSystem::binary);
+    if (!journal_file) journal_file = FileSystem::FileSystem::instance()->openFile(m_journalFilename, FileSystem::write | FileSystem::binary);
+    if (!journal_file) return FileSystem::ErrorCode::fileOpenError;
+    const size_t offset = journal_file->size();
+    auto write_size = journal_file->write(offset, { line.begin(), line.end() });
+    FileSystem::FileSystem::instance()->closeFile(journal_file);
+    if (write_size != line.size()) return FileSystem::ErrorCode::writeFail;
+    m_recordCount++;
+    return FileSystem::ErrorCode::ok;
+}
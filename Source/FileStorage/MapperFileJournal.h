@@ -0,0 +1,64 @@
+﻿/*********************************************************************
+ * \file   MapperFileJournal.h
+ * \brief  append-only journal of mapper file, put / remove 只附加一筆紀錄,
+ *          累積足夠筆數後才 compact (重寫整個 mapper file)
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef MAPPER_FILE_JOURNAL_H
+#define MAPPER_FILE_JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <optional>
+#include <system_error>
+
+namespace Enigma::FileStorage
+{
+    /** journal file 是 mapper filename + ".journal", 每行是 '+' 或 '-' 加上一筆 mapper record.
+     connect 時先讀 mapper file, 再依序 replay journal. 沒有自己的 lock, 由 mapper 的 map lock 保護 */
+    class MapperFileJournal
+    {
+    public:
+        static constexpr unsigned DEFAULT_COMPACT_THRESHOLD = 64;
+        using RecordReplayer = std::function<void(bool is_put, const std::string& record)>;
+
+    public:
+        MapperFileJournal(const std::string& mapper_filename, unsigned compact_threshold = DEFAULT_COMPACT_THRESHOLD);
+        MapperFileJournal(const MapperFileJournal&) = delete;
+        MapperFileJournal(MapperFileJournal&&) = delete;
+        ~MapperFileJournal();
+        MapperFileJournal& operator=(const MapperFileJournal&) = delete;
+        MapperFileJournal& operator=(MapperFileJournal&&) = delete;
+
+        const std::string& mapperFilename() const { return m_mapperFilename; }
+        const std::string& journalFilename() const { return m_journalFilename; }
+
+        /** read whole mapper file, empty string if file not existed */
+        std::optional<std::string> readMapperFile() const;
+        /** replay journal records in order */
+        std::error_code replay(const RecordReplayer& replayer);
+
+        std::error_code appendPut(const std::string& record);
+        std::error_code appendRemove(const std::string& record);
+
+        unsigned recordCount() const { return m_recordCount; }
+        bool needCompaction() const { return m_recordCount >= m_compactThreshold; }
+        /** rewrite mapper file with whole content, then clear journal */
+        std::error_code compact(const std::string& mapper_file_content);
+
+    protected:
+        std::error_code appendLine(const std::string& line);
+        std::error_code rewriteJournal(const std::string& journal_content);
+
+    protected:
+        std::string m_mapperFilename;
+        std::string m_journalFilename;
+        unsigned m_compactThreshold;
+        unsigned m_recordCount;
+    };
+}
+
+#endif // MAPPER_FILE_JOURNAL_H
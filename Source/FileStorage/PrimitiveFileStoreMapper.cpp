@@ -3,13 +3,13 @@
 #include "FileSystem/FileSystemErrors.h"
 #include "Primitives/PrimitiveErrors.h"
 #include "Frameworks/TokenVector.h"
+#include <algorithm>
 
 using namespace Enigma::FileStorage;
 
-PrimitiveFileStoreMapper::PrimitiveFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway)
+PrimitiveFileStoreMapper::PrimitiveFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : m_gateways(gateway), m_journal(mapper_filename)
 {
     m_mapper_filename = mapper_filename;
-    m_gateway = gateway;
     m_has_connected = false;
     m_sequence_number = 0;
 }
@@ -24,23 +24,26 @@ std::error_code PrimitiveFileStoreMapper::connect()
 {
     if (m_has_connected) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_fileMapLock };
+    if (m_has_connected) return FileSystem::ErrorCode::ok;
     m_filename_map.clear();
-    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::read | FileSystem::binary);
-    if (!mapper_file)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto file_size = mapper_file->size();
-    if (file_size == 0)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto content = mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
+    auto content = m_journal.readMapperFile();
     if (!content) return FileSystem::ErrorCode::readFail;
-    deserializeMapperFile(std::string(content->begin(), content->end()));
+    deserializeMapperFile(content.value());
+    auto er = m_journal.replay([this](bool is_put, const std::string& record)
+        {
+            auto rec = parseMapperRecord(record);
+            if (!rec) return;
+            if (is_put)
+            {
+                m_filename_map.insert_or_assign(rec->first, rec->second);
+                m_sequence_number = std::max<std::uint64_t>(m_sequence_number, rec->first.sequence());
+            }
+            else
+            {
+                m_filename_map.erase(rec->first);
+            }
+        });
+    if (er) return er;
     m_has_connected = true;
     return FileSystem::ErrorCode::ok;
 }
@@ -48,21 +51,25 @@ std::error_code PrimitiveFileStoreMapper::connect()
 std::error_code PrimitiveFileStoreMapper::disconnect()
 {
     std::lock_guard locker{ m_fileMapLock };
+    // compact 失敗, journal 還在, 下次 connect 仍可 replay; 狀態照樣清掉, 把錯誤回報出去
+    std::error_code er;
+    if ((m_has_connected) && (m_journal.recordCount() > 0)) er = m_journal.compact(serializeMapperFile());
     m_filename_map.clear();
     m_has_connected = false;
+    if (er) return er;
     return FileSystem::ErrorCode::ok;
 }
 
 bool PrimitiveFileStoreMapper::hasPrimitive(const Primitives::PrimitiveId& id)
 {
     if (!m_has_connected) connect();
-    std::lock_guard locker{ m_fileMapLock };
+    std::shared_lock locker{ m_fileMapLock };
     return m_filename_map.find(id) != m_filename_map.end();
 }
 
 std::optional<Enigma::Engine::GenericDto> PrimitiveFileStoreMapper::queryPrimitive(const Primitives::PrimitiveId& id)
 {
-    std::lock_guard locker{ m_fileMapLock };
+    std::shared_lock locker{ m_fileMapLock };
     auto it = m_filename_map.find(id);
     if (it == m_filename_map.end()) return std::nullopt;
     return deserializeDataTransferObject(it->second);
@@ -71,8 +78,11 @@ std::optional<Enigma::Engine::GenericDto> PrimitiveFileStoreMapper::queryPrimiti
 std::error_code PrimitiveFileStoreMapper::removePrimitive(const Primitives::PrimitiveId& id)
 {
     std::lock_guard locker{ m_fileMapLock };
-    m_filename_map.erase(id);
-    auto er = serializeMapperFile();
+    auto it = m_filename_map.find(id);
+    if (it == m_filename_map.end()) return Primitives::ErrorCode::ok;
+    const auto record = formatMapperRecord(it->first, it->second);
+    m_filename_map.erase(it);
+    auto er = journalRecord(false, record);
     if (er) return er;
     return Primitives::ErrorCode::ok;
 }
@@ -81,10 +91,10 @@ std::error_code PrimitiveFileStoreMapper::putPrimitive(const Primitives::Primiti
 {
     auto filename = extractFilename(id, dto.getRtti());
     std::lock_guard locker{ m_fileMapLock };
-    m_filename_map.insert_or_assign(id, filename);
-    auto er = serializeMapperFile();
+    auto er = serializeDataTransferObject(filename, dto);
     if (er) return er;
-    er = serializeDataTransferObject(filename, dto);
+    m_filename_map.insert_or_assign(id, filename);
+    er = journalRecord(true, formatMapperRecord(id, filename));
     if (er) return er;
     return Primitives::ErrorCode::ok;
 }
@@ -95,34 +105,46 @@ std::uint64_t PrimitiveFileStoreMapper::nextSequenceNumber()
     return ++m_sequence_number;
 }
 
+std::string PrimitiveFileStoreMapper::serializeMapperFile() const
+{
+    std::string mapper_file_content = std::to_string(m_sequence_number) + "\n";
+    for (auto& rec : m_filename_map)
+    {
+        mapper_file_content += formatMapperRecord(rec.first, rec.second) + "\n";
+    }
+    return mapper_file_content;
+}
+
 void PrimitiveFileStoreMapper::deserializeMapperFile(const std::string& mapper_file_content)
 {
     if (mapper_file_content.empty()) return;
-    std::lock_guard locker{ m_fileMapLock };
     auto lines = split_token(mapper_file_content, "\n\r");
-    m_sequence_number = std::stoul(lines[0]);
+    m_sequence_number = std::stoull(lines[0]);
     for (auto& line : lines)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 4) continue; // then, skip first line
-        Primitives::PrimitiveId id{ tokens[0], std::stoull(tokens[1]), Frameworks::Rtti::fromName(tokens[2]) };
-        m_filename_map.insert_or_assign(id, tokens[3]);
+        auto rec = parseMapperRecord(line);
+        if (!rec) continue; // then, skip first line
+        m_filename_map.insert_or_assign(rec->first, rec->second);
     }
 }
 
-std::error_code PrimitiveFileStoreMapper::serializeMapperFile()
+std::string PrimitiveFileStoreMapper::formatMapperRecord(const Primitives::PrimitiveId& id, const std::string& filename)
 {
-    std::lock_guard locker{ m_fileMapLock };
-    std::string mapper_file_content = std::to_string(m_sequence_number) + "\n";
-    for (auto& rec : m_filename_map)
-    {
-        mapper_file_content += rec.first.name() + "," + std::to_string(rec.first.sequence()) + "," + rec.first.rtti().getName() + "," + rec.second + "\n";
-    }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
+    return id.name() + "," + std::to_string(id.sequence()) + "," + id.rtti().getName() + "," + filename;
+}
+
+std::optional<std::pair<Enigma::Primitives::PrimitiveId, std::string>> PrimitiveFileStoreMapper::parseMapperRecord(const std::string& line)
+{
+    auto tokens = split_token(line, ",");
+    if (tokens.size() != 4) return std::nullopt;
+    return std::make_pair(Primitives::PrimitiveId{ tokens[0], std::stoull(tokens[1]), Frameworks::Rtti::fromName(tokens[2]) }, tokens[3]);
+}
+
+std::error_code PrimitiveFileStoreMapper::journalRecord(bool is_put, const std::string& record)
+{
+    auto er = is_put ? m_journal.appendPut(record) : m_journal.appendRemove(record);
+    if (er) return er;
+    if (m_journal.needCompaction()) return m_journal.compact(serializeMapperFile());
     return FileSystem::ErrorCode::ok;
 }
 
@@ -135,10 +157,11 @@ std::string PrimitiveFileStoreMapper::extractFilename(const Primitives::Primitiv
 
 std::error_code PrimitiveFileStoreMapper::serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     FileSystem::IFilePtr dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::write | FileSystem::binary);
     if (!dto_file) return FileSystem::ErrorCode::fileOpenError;
-    auto content = m_gateway->serialize({ dto });
+    auto content = gateway->serialize({ dto });
     auto write_size = dto_file->write(0, { content.begin(), content.end() });
     FileSystem::FileSystem::instance()->closeFile(dto_file);
     if (write_size != content.size()) return FileSystem::ErrorCode::writeFail;
@@ -147,13 +170,14 @@ std::error_code PrimitiveFileStoreMapper::serializeDataTransferObject(const std:
 
 Enigma::Engine::GenericDto PrimitiveFileStoreMapper::deserializeDataTransferObject(const std::string& filename)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     auto dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::read | FileSystem::binary);
     auto file_size = dto_file->size();
-    auto content = dto_file->read(0, file_size);
+    auto content = dto_file->view(0, file_size);
     assert(content.has_value());
     FileSystem::FileSystem::instance()->closeFile(dto_file);
-    const auto dtos = m_gateway->deserialize(std::string(content.value().begin(), content.value().end()));
+    const auto dtos = gateway->deserializeBuffer(content->chars(), content->size());
     assert(!dtos.empty());
     return dtos[0];
 }
@@ -9,9 +9,8 @@
 
 using namespace Enigma::FileStorage;
 
-SceneGraphFileStoreMapper::SpatialFileMap::SpatialFileMap(const std::string& filename, const std::string& asset_prefix, const std::shared_ptr<Gateways::IDtoGateway>& gateway)
+SceneGraphFileStoreMapper::SpatialFileMap::SpatialFileMap(const std::string& filename, const std::string& asset_prefix, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : m_gateways(gateway), m_journal(filename)
 {
-    m_gateway = gateway;
     m_filename = filename;
     m_assetPrefix = asset_prefix;
 }
@@ -25,34 +24,37 @@ std::error_code SceneGraphFileStoreMapper::SpatialFileMap::connect()
 {
     std::lock_guard locker{ m_lock };
     m_map.clear();
-    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_filename, FileSystem::read | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::ok;
-    auto file_size = mapper_file->size();
-    if (file_size == 0) return FileSystem::ErrorCode::ok;
-    auto content = mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
+    auto content = m_journal.readMapperFile();
     if (!content) return FileSystem::ErrorCode::readFail;
-    const std::string mapper_content{ content->begin(), content->end() };
-    deserializeMapperFile(mapper_content);
-    return FileSystem::ErrorCode::ok;
+    deserializeMapperFile(content.value());
+    return m_journal.replay([this](bool is_put, const std::string& record)
+        {
+            auto rec = parseMapperRecord(record);
+            if (!rec) return;
+            if (is_put) m_map.insert_or_assign(rec->first, rec->second);
+            else m_map.erase(rec->first);
+        });
 }
 
 std::error_code SceneGraphFileStoreMapper::SpatialFileMap::disconnect()
 {
     std::lock_guard locker{ m_lock };
+    std::error_code er;
+    if (m_journal.recordCount() > 0) er = m_journal.compact(serializeMapperFile());
     m_map.clear();
+    if (er) return er;
     return FileSystem::ErrorCode::ok;
 }
 
 bool SceneGraphFileStoreMapper::SpatialFileMap::has(const SceneGraph::SpatialId& id)
 {
-    std::lock_guard locker{ m_lock };
+    std::shared_lock locker{ m_lock };
     return m_map.find(id) != m_map.end();
 }
 
 std::optional<Enigma::Engine::GenericDto> SceneGraphFileStoreMapper::SpatialFileMap::query(const SceneGraph::SpatialId& id)
 {
-    std::lock_guard locker{ m_lock };
+    std::shared_lock locker{ m_lock };
     auto it = m_map.find(id);
     if (it == m_map.end()) return std::nullopt;
     return deserializeDataTransferObjects(it->second);
@@ -61,8 +63,11 @@ std::optional<Enigma::Engine::GenericDto> SceneGraphFileStoreMapper::SpatialFile
 std::error_code SceneGraphFileStoreMapper::SpatialFileMap::remove(const SceneGraph::SpatialId& id)
 {
     std::lock_guard locker{ m_lock };
-    m_map.erase(id);
-    auto er = serializeMapperFile();
+    auto it = m_map.find(id);
+    if (it == m_map.end()) return SceneGraph::ErrorCode::ok;
+    const auto record = formatMapperRecord(it->first, it->second);
+    m_map.erase(it);
+    auto er = journalRecord(false, record);
     if (er) return er;
     return SceneGraph::ErrorCode::ok;
 }
@@ -71,10 +76,10 @@ std::error_code SceneGraphFileStoreMapper::SpatialFileMap::put(const SceneGraph:
 {
     auto filename = extractFilename(id, dto.getRtti());
     std::lock_guard locker{ m_lock };
-    m_map.insert_or_assign(id, filename);
-    auto er = serializeMapperFile();
+    auto er = serializeDataTransferObjects(filename, dto);
     if (er) return er;
-    er = serializeDataTransferObjects(filename, dto);
+    m_map.insert_or_assign(id, filename);
+    er = journalRecord(true, formatMapperRecord(id, filename));
     if (er) return er;
     return SceneGraph::ErrorCode::ok;
 }
@@ -85,40 +90,54 @@ void SceneGraphFileStoreMapper::SpatialFileMap::deserializeMapperFile(const std:
     auto lines = split_token(content, "\n\r");
     for (auto& line : lines)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 3) continue;
-        SceneGraph::SpatialId id{ tokens[0], Frameworks::Rtti::fromName(tokens[1]) };
-        m_map.insert_or_assign(id, tokens[2]);
+        auto rec = parseMapperRecord(line);
+        if (!rec) continue;
+        m_map.insert_or_assign(rec->first, rec->second);
     }
 }
 
+std::string SceneGraphFileStoreMapper::SpatialFileMap::formatMapperRecord(const SceneGraph::SpatialId& id, const std::string& filename)
+{
+    return id.name() + "," + id.rtti().getName() + "," + filename;
+}
+
+std::optional<std::pair<Enigma::SceneGraph::SpatialId, std::string>> SceneGraphFileStoreMapper::SpatialFileMap::parseMapperRecord(const std::string& line)
+{
+    auto tokens = split_token(line, ",");
+    if (tokens.size() != 3) return std::nullopt;
+    return std::make_pair(SceneGraph::SpatialId{ tokens[0], Frameworks::Rtti::fromName(tokens[1]) }, tokens[2]);
+}
+
+std::error_code SceneGraphFileStoreMapper::SpatialFileMap::journalRecord(bool is_put, const std::string& record)
+{
+    auto er = is_put ? m_journal.appendPut(record) : m_journal.appendRemove(record);
+    if (er) return er;
+    if (m_journal.needCompaction()) return m_journal.compact(serializeMapperFile());
+    return FileSystem::ErrorCode::ok;
+}
+
 Enigma::Engine::GenericDto SceneGraphFileStoreMapper::SpatialFileMap::deserializeDataTransferObjects(const std::string& filename)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     auto dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::read | FileSystem::binary);
     auto file_size = dto_file->size();
-    auto content = dto_file->read(0, file_size);
+    auto content = dto_file->view(0, file_size);
     assert(content.has_value());
     FileSystem::FileSystem::instance()->closeFile(dto_file);
-    const auto dtos = m_gateway->deserialize(std::string(content.value().begin(), content.value().end()));
+    const auto dtos = gateway->deserializeBuffer(content->chars(), content->size());
     assert(!dtos.empty());
     return dtos[0];
 }
 
-std::error_code SceneGraphFileStoreMapper::SpatialFileMap::serializeMapperFile()
+std::string SceneGraphFileStoreMapper::SpatialFileMap::serializeMapperFile() const
 {
-    std::lock_guard locker{ m_lock };
     std::string mapper_file_content;
     for (auto& rec : m_map)
     {
-        mapper_file_content += rec.first.name() + "," + rec.first.rtti().getName() + "," + rec.second + "\n";
+        mapper_file_content += formatMapperRecord(rec.first, rec.second) + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_filename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
-    return FileSystem::ErrorCode::ok;
+    return mapper_file_content;
 }
 
 std::string SceneGraphFileStoreMapper::SpatialFileMap::extractFilename(const SceneGraph::SpatialId& id, const Engine::FactoryDesc& factory_desc)
@@ -149,10 +168,11 @@ std::string SceneGraphFileStoreMapper::SpatialFileMap::extractFilename(const Sce
 
 std::error_code SceneGraphFileStoreMapper::SpatialFileMap::serializeDataTransferObjects(const std::string& filename, const Engine::GenericDto& dto)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     FileSystem::IFilePtr dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::write | FileSystem::binary);
     if (!dto_file) return FileSystem::ErrorCode::fileOpenError;
-    auto content = m_gateway->serialize({ dto });
+    auto content = gateway->serialize({ dto });
     auto write_size = dto_file->write(0, { content.begin(), content.end() });
     FileSystem::FileSystem::instance()->closeFile(dto_file);
     if (write_size != content.size()) return FileSystem::ErrorCode::writeFail;
@@ -171,6 +191,8 @@ SceneGraphFileStoreMapper::~SceneGraphFileStoreMapper()
 
 std::error_code SceneGraphFileStoreMapper::connect()
 {
+    if (m_hasConnected) return FileSystem::ErrorCode::ok;
+    std::lock_guard locker{ m_connectLock };
     if (m_hasConnected) return FileSystem::ErrorCode::ok;
     auto er = m_spatialMap.connect();
     if (er) return er;
@@ -181,9 +203,12 @@ std::error_code SceneGraphFileStoreMapper::connect()
 
 std::error_code SceneGraphFileStoreMapper::disconnect()
 {
-    m_spatialMap.disconnect();
-    m_laziedMap.disconnect();
+    std::lock_guard locker{ m_connectLock };
+    auto er_spatial = m_spatialMap.disconnect();
+    auto er_lazied = m_laziedMap.disconnect();
     m_hasConnected = false;
+    if (er_spatial) return er_spatial;
+    if (er_lazied) return er_lazied;
     return FileSystem::ErrorCode::ok;
 }
 
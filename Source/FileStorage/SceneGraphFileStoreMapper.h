@@ -9,10 +9,13 @@
 #define SCENE_GRAPH_FILE_STORE_MAPPER_H
 
 #include "GameEngine/FactoryDesc.h"
-#include "Gateways/DtoGateway.h"
+#include "Gateways/DtoGatewaySelector.h"
 #include "SceneGraph/SceneGraphStoreMapper.h"
 #include "SceneGraph/Camera.h"
+#include "MapperFileJournal.h"
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
 
 namespace Enigma::FileStorage
 {
@@ -43,16 +46,21 @@ namespace Enigma::FileStorage
             void deserializeMapperFile(const std::string& content);
             Engine::GenericDto deserializeDataTransferObjects(const std::string& filename);
 
-            std::error_code serializeMapperFile();
+            std::string serializeMapperFile() const;
+            static std::string formatMapperRecord(const SceneGraph::SpatialId& id, const std::string& filename);
+            static std::optional<std::pair<SceneGraph::SpatialId, std::string>> parseMapperRecord(const std::string& line);
+            std::error_code journalRecord(bool is_put, const std::string& record);
             std::string extractFilename(const SceneGraph::SpatialId& id, const Engine::FactoryDesc& factory_desc);
 
             std::error_code serializeDataTransferObjects(const std::string& filename, const Engine::GenericDto& dto);
 
         protected:
-            std::shared_ptr<Gateways::IDtoGateway> m_gateway;
+            Gateways::DtoGatewaySelector m_gateways;
             std::string m_filename;
+            MapperFileJournal m_journal;
             std::unordered_map<SceneGraph::SpatialId, std::string, SceneGraph::SpatialId::hash> m_map;
-            mutable std::recursive_mutex m_lock;
+            //! ADR: query 拿 shared lock 讀檔, put 拿 exclusive lock 寫檔; query 之間仍可平行
+            mutable std::shared_mutex m_lock;
             std::string m_assetPrefix;
         };
     public:
@@ -82,7 +90,8 @@ namespace Enigma::FileStorage
         virtual std::error_code putLaziedContent(const SceneGraph::SpatialId& id, const Engine::GenericDto& dto) override;
 
     protected:
-        bool m_hasConnected;
+        std::atomic_bool m_hasConnected;
+        std::mutex m_connectLock;
         SpatialFileMap m_spatialMap;
         SpatialFileMap m_laziedMap;
     };
@@ -7,10 +7,9 @@
 
 using namespace Enigma::FileStorage;
 
-TextureFileStoreMapper::TextureFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : Engine::TextureStoreMapper()
+TextureFileStoreMapper::TextureFileStoreMapper(const std::string& mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway) : Engine::TextureStoreMapper(), m_gateways(gateway), m_journal(mapper_filename)
 {
     m_mapper_filename = mapper_filename;
-    m_gateway = gateway;
     m_has_connected = false;
 }
 
@@ -24,23 +23,25 @@ std::error_code TextureFileStoreMapper::connect()
 {
     if (m_has_connected) return FileSystem::ErrorCode::ok;
     std::lock_guard locker{ m_fileMapLock };
+    if (m_has_connected) return FileSystem::ErrorCode::ok;
     m_filename_map.clear();
-    FileSystem::IFilePtr mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::read | FileSystem::binary);
-    if (!mapper_file)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto file_size = mapper_file->size();
-    if (file_size == 0)
-    {
-        m_has_connected = true;
-        return FileSystem::ErrorCode::ok;
-    }
-    auto content = mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
+    auto content = m_journal.readMapperFile();
     if (!content) return FileSystem::ErrorCode::readFail;
-    deserializeMapperFile(std::string(content->begin(), content->end()));
+    deserializeMapperFile(content.value());
+    auto er = m_journal.replay([this](bool is_put, const std::string& record)
+        {
+            auto rec = parseMapperRecord(record);
+            if (!rec) return;
+            if (is_put)
+            {
+                m_filename_map.insert_or_assign(rec->first, rec->second);
+            }
+            else
+            {
+                m_filename_map.erase(rec->first);
+            }
+        });
+    if (er) return er;
     m_has_connected = true;
     return FileSystem::ErrorCode::ok;
 }
@@ -48,21 +49,25 @@ std::error_code TextureFileStoreMapper::connect()
 std::error_code TextureFileStoreMapper::disconnect()
 {
     std::lock_guard locker{ m_fileMapLock };
+    // compact 失敗, journal 還在, 下次 connect 仍可 replay; 狀態照樣清掉, 把錯誤回報出去
+    std::error_code er;
+    if ((m_has_connected) && (m_journal.recordCount() > 0)) er = m_journal.compact(serializeMapperFile());
     m_filename_map.clear();
     m_has_connected = false;
+    if (er) return er;
     return FileSystem::ErrorCode::ok;
 }
 
 bool TextureFileStoreMapper::hasTexture(const Engine::TextureId& id)
 {
     if (!m_has_connected) connect();
-    std::lock_guard locker{ m_fileMapLock };
+    std::shared_lock locker{ m_fileMapLock };
     return m_filename_map.find(id) != m_filename_map.end();
 }
 
 std::optional<Enigma::Engine::GenericDto> TextureFileStoreMapper::queryTexture(const Engine::TextureId& id)
 {
-    std::lock_guard locker{ m_fileMapLock };
+    std::shared_lock locker{ m_fileMapLock };
     auto it = m_filename_map.find(id);
     if (it == m_filename_map.end()) return std::nullopt;
     return deserializeDataTransferObject(it->second);
@@ -72,10 +77,10 @@ std::error_code TextureFileStoreMapper::putTexture(const Engine::TextureId& id,
 {
     auto filename = extractFilename(id, dto.getRtti());
     std::lock_guard locker{ m_fileMapLock };
-    m_filename_map.insert_or_assign(id, filename);
-    auto er = serializeMapperFile();
+    auto er = serializeDataTransferObject(filename, dto);
     if (er) return er;
-    er = serializeDataTransferObject(filename, dto);
+    m_filename_map.insert_or_assign(id, filename);
+    er = journalRecord(true, formatMapperRecord(id, filename));
     if (er) return er;
     return Engine::ErrorCode::ok;
 }
@@ -83,48 +88,64 @@ std::error_code TextureFileStoreMapper::putTexture(const Engine::TextureId& id,
 std::error_code TextureFileStoreMapper::removeTexture(const Engine::TextureId& id)
 {
     std::lock_guard locker{ m_fileMapLock };
-    m_filename_map.erase(id);
-    auto er = serializeMapperFile();
+    auto it = m_filename_map.find(id);
+    if (it == m_filename_map.end()) return Engine::ErrorCode::ok;
+    const auto record = formatMapperRecord(it->first, it->second);
+    m_filename_map.erase(it);
+    auto er = journalRecord(false, record);
     if (er) return er;
     return Engine::ErrorCode::ok;
 }
 
-std::error_code TextureFileStoreMapper::serializeMapperFile()
+std::string TextureFileStoreMapper::serializeMapperFile() const
 {
-    std::lock_guard locker{ m_fileMapLock };
-    std::string mapper_file_content = "";
+    std::string mapper_file_content;
     for (auto& rec : m_filename_map)
     {
-        mapper_file_content += rec.first.name() + "," + rec.second + "\n";
+        mapper_file_content += formatMapperRecord(rec.first, rec.second) + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_mapper_filename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
-    return FileSystem::ErrorCode::ok;
+    return mapper_file_content;
 }
 
 void TextureFileStoreMapper::deserializeMapperFile(const std::string& mapper_file_content)
 {
     if (mapper_file_content.empty()) return;
-    std::lock_guard locker{ m_fileMapLock };
     auto lines = split_token(mapper_file_content, "\n\r");
     for (auto& line : lines)
     {
-        auto tokens = split_token(line, ",");
-        if (tokens.size() != 2) continue;
-        Engine::TextureId id{ tokens[0] };
-        m_filename_map.insert_or_assign(id, tokens[1]);
+        auto rec = parseMapperRecord(line);
+        if (!rec) continue;
+        m_filename_map.insert_or_assign(rec->first, rec->second);
     }
 }
 
+std::string TextureFileStoreMapper::formatMapperRecord(const Engine::TextureId& id, const std::string& filename)
+{
+    return id.name() + "," + filename;
+}
+
+std::optional<std::pair<Enigma::Engine::TextureId, std::string>> TextureFileStoreMapper::parseMapperRecord(const std::string& line)
+{
+    auto tokens = split_token(line, ",");
+    if (tokens.size() != 2) return std::nullopt;
+    return std::make_pair(Engine::TextureId{ tokens[0] }, tokens[1]);
+}
+
+std::error_code TextureFileStoreMapper::journalRecord(bool is_put, const std::string& record)
+{
+    auto er = is_put ? m_journal.appendPut(record) : m_journal.appendRemove(record);
+    if (er) return er;
+    if (m_journal.needCompaction()) return m_journal.compact(serializeMapperFile());
+    return FileSystem::ErrorCode::ok;
+}
+
 std::error_code TextureFileStoreMapper::serializeDataTransferObject(const std::string& filename, const Engine::GenericDto& dto)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     FileSystem::IFilePtr dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::write | FileSystem::binary);
     if (!dto_file) return FileSystem::ErrorCode::fileOpenError;
-    auto content = m_gateway->serialize({ dto });
+    auto content = gateway->serialize({ dto });
     auto write_size = dto_file->write(0, { content.begin(), content.end() });
     FileSystem::FileSystem::instance()->closeFile(dto_file);
     if (write_size != content.size()) return FileSystem::ErrorCode::writeFail;
@@ -133,13 +154,14 @@ std::error_code TextureFileStoreMapper::serializeDataTransferObject(const std::s
 
 Enigma::Engine::GenericDto TextureFileStoreMapper::deserializeDataTransferObject(const std::string& filename)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     auto dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::read | FileSystem::binary);
     auto file_size = dto_file->size();
-    auto content = dto_file->read(0, file_size);
+    auto content = dto_file->view(0, file_size);
     assert(content.has_value());
     FileSystem::FileSystem::instance()->closeFile(dto_file);
-    const auto dtos = m_gateway->deserialize(std::string(content.value().begin(), content.value().end()));
+    const auto dtos = gateway->deserializeBuffer(content->chars(), content->size());
     assert(!dtos.empty());
     return dtos[0];
 }
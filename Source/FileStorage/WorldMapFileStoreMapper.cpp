@@ -8,7 +8,7 @@ using namespace Enigma::FileStorage;
 using namespace Enigma::WorldMap;
 
 WorldMapFileStoreMapper::WorldMapFileStoreMapper(const std::string& world_mapper_filename, const std::string& quad_root_mapper_filename, const std::shared_ptr<Gateways::IDtoGateway>& gateway)
-    : m_gateway(gateway), m_worldMapperFilename(world_mapper_filename), m_quadRootMapperFilename(quad_root_mapper_filename)
+    : m_gateways(gateway), m_worldMapperFilename(world_mapper_filename), m_worldMapJournal(world_mapper_filename), m_quadRootMapperFilename(quad_root_mapper_filename), m_quadRootJournal(quad_root_mapper_filename)
 {
     m_hasConnected = false;
 }
@@ -22,36 +22,45 @@ WorldMapFileStoreMapper::~WorldMapFileStoreMapper()
 
 std::error_code WorldMapFileStoreMapper::connect()
 {
+    if (m_hasConnected) return FileSystem::ErrorCode::ok;
+    std::lock_guard locker{ m_connectLock };
     if (m_hasConnected) return FileSystem::ErrorCode::ok;
     auto er = connectWorldMapperFile();
-    if (!er) return er;
+    if (er) return er;
     er = connectQuadRootMapperFile();
-    if (!er) return er;
+    if (er) return er;
     m_hasConnected = true;
     return FileSystem::ErrorCode::ok;
 }
 
 std::error_code WorldMapFileStoreMapper::disconnect()
 {
+    std::lock_guard connect_locker{ m_connectLock };
     std::lock_guard locker{ m_worldMapLock };
+    std::error_code er_world;
+    if (m_worldMapJournal.recordCount() > 0) er_world = m_worldMapJournal.compact(serializeWorldMapperFile());
     m_worldFilenameMap.clear();
     std::lock_guard locker2{ m_quadTreeRootLock };
+    std::error_code er_quad_root;
+    if (m_quadRootJournal.recordCount() > 0) er_quad_root = m_quadRootJournal.compact(serializeQuadRootMapperFile());
     m_quadRootFilenameMap.clear();
     m_hasConnected = false;
+    if (er_world) return er_world;
+    if (er_quad_root) return er_quad_root;
     return FileSystem::ErrorCode::ok;
 }
 
 bool WorldMapFileStoreMapper::hasQuadTreeRoot(const QuadTreeRootId& id)
 {
     if (!m_hasConnected) connect();
-    std::lock_guard locker{ m_quadTreeRootLock };
+    std::shared_lock locker{ m_quadTreeRootLock };
     return m_quadRootFilenameMap.find(id) != m_quadRootFilenameMap.end();
 }
 
 std::optional<Enigma::Engine::GenericDto> WorldMapFileStoreMapper::queryQuadTreeRoot(const WorldMap::QuadTreeRootId& id)
 {
     if (!m_hasConnected) connect();
-    std::lock_guard locker{ m_quadTreeRootLock };
+    std::shared_lock locker{ m_quadTreeRootLock };
     auto it = m_quadRootFilenameMap.find(id);
     if (it == m_quadRootFilenameMap.end()) return std::nullopt;
     return deserializeDataTransferObjects(it->second);
@@ -63,8 +72,9 @@ std::error_code WorldMapFileStoreMapper::removeQuadTreeRoot(const WorldMap::Quad
     std::lock_guard locker{ m_quadTreeRootLock };
     auto it = m_quadRootFilenameMap.find(id);
     if (it == m_quadRootFilenameMap.end()) return FileSystem::ErrorCode::ok;
+    const auto record = it->first.name() + "," + it->second;
     m_quadRootFilenameMap.erase(it);
-    auto er = serializeQuadRootMapperFile();
+    auto er = journalQuadRootRecord(false, record);
     if (er) return er;
     return FileSystem::ErrorCode::ok;
 }
@@ -73,10 +83,10 @@ std::error_code WorldMapFileStoreMapper::putQuadTreeRoot(const WorldMap::QuadTre
 {
     auto filename = extractQuadRootFilename(id, dto.getRtti());
     std::lock_guard locker{ m_quadTreeRootLock };
-    m_quadRootFilenameMap.insert_or_assign(id, filename);
-    auto er = serializeQuadRootMapperFile();
+    auto er = serializeDataTransferObjects(filename, dto);
     if (er) return er;
-    er = serializeDataTransferObjects(filename, dto);
+    m_quadRootFilenameMap.insert_or_assign(id, filename);
+    er = journalQuadRootRecord(true, id.name() + "," + filename);
     if (er) return er;
     return FileSystem::ErrorCode::ok;
 }
@@ -84,14 +94,14 @@ std::error_code WorldMapFileStoreMapper::putQuadTreeRoot(const WorldMap::QuadTre
 bool WorldMapFileStoreMapper::hasWorldMap(const WorldMap::WorldMapId& id)
 {
     if (!m_hasConnected) connect();
-    std::lock_guard locker{ m_worldMapLock };
+    std::shared_lock locker{ m_worldMapLock };
     return m_worldFilenameMap.find(id) != m_worldFilenameMap.end();
 }
 
 std::optional<Enigma::Engine::GenericDto> WorldMapFileStoreMapper::queryWorldMap(const WorldMap::WorldMapId& id)
 {
     if (!m_hasConnected) connect();
-    std::lock_guard locker{ m_worldMapLock };
+    std::shared_lock locker{ m_worldMapLock };
     auto it = m_worldFilenameMap.find(id);
     if (it == m_worldFilenameMap.end()) return std::nullopt;
     return deserializeDataTransferObjects(it->second);
@@ -103,8 +113,9 @@ std::error_code WorldMapFileStoreMapper::removeWorldMap(const WorldMap::WorldMap
     std::lock_guard locker{ m_worldMapLock };
     auto it = m_worldFilenameMap.find(id);
     if (it == m_worldFilenameMap.end()) return FileSystem::ErrorCode::ok;
+    const auto record = it->first.name() + "," + it->second;
     m_worldFilenameMap.erase(it);
-    auto er = serializeWorldMapperFile();
+    auto er = journalWorldMapRecord(false, record);
     if (er) return er;
     return FileSystem::ErrorCode::ok;
 }
@@ -113,10 +124,10 @@ std::error_code WorldMapFileStoreMapper::putWorldMap(const WorldMap::WorldMapId&
 {
     auto filename = extractWorldFilename(id, dto.getRtti());
     std::lock_guard locker{ m_worldMapLock };
-    m_worldFilenameMap.insert_or_assign(id, filename);
-    auto er = serializeWorldMapperFile();
+    auto er = serializeDataTransferObjects(filename, dto);
     if (er) return er;
-    er = serializeDataTransferObjects(filename, dto);
+    m_worldFilenameMap.insert_or_assign(id, filename);
+    er = journalWorldMapRecord(true, id.name() + "," + filename);
     if (er) return er;
     return FileSystem::ErrorCode::ok;
 }
@@ -125,36 +136,39 @@ std::error_code WorldMapFileStoreMapper::connectWorldMapperFile()
 {
     std::lock_guard locker{ m_worldMapLock };
     m_worldFilenameMap.clear();
-    FileSystem::IFilePtr world_mapper_file = FileSystem::FileSystem::instance()->openFile(m_worldMapperFilename, FileSystem::read | FileSystem::binary);
-    if (!world_mapper_file) return FileSystem::ErrorCode::ok;
-    auto file_size = world_mapper_file->size();
-    if (file_size == 0) return FileSystem::ErrorCode::ok;
-    auto content = world_mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(world_mapper_file);
+    auto content = m_worldMapJournal.readMapperFile();
     if (!content) return FileSystem::ErrorCode::readFail;
-    auto er = deserializeWorldMapperFile(std::string(content->begin(), content->end()));
-    return er;
+    auto er = deserializeWorldMapperFile(content.value());
+    if (er) return er;
+    return m_worldMapJournal.replay([this](bool is_put, const std::string& record)
+        {
+            auto tokens = split_token(record, ",");
+            if (tokens.size() != 2) return;
+            if (is_put) m_worldFilenameMap.insert_or_assign(WorldMapId{ tokens[0] }, tokens[1]);
+            else m_worldFilenameMap.erase(WorldMapId{ tokens[0] });
+        });
 }
 
 std::error_code WorldMapFileStoreMapper::connectQuadRootMapperFile()
 {
     std::lock_guard locker{ m_quadTreeRootLock };
     m_quadRootFilenameMap.clear();
-    FileSystem::IFilePtr quad_root_mapper_file = FileSystem::FileSystem::instance()->openFile(m_quadRootMapperFilename, FileSystem::read | FileSystem::binary);
-    if (!quad_root_mapper_file) return FileSystem::ErrorCode::ok;
-    auto file_size = quad_root_mapper_file->size();
-    if (file_size == 0) return FileSystem::ErrorCode::ok;
-    auto content = quad_root_mapper_file->read(0, file_size);
-    FileSystem::FileSystem::instance()->closeFile(quad_root_mapper_file);
+    auto content = m_quadRootJournal.readMapperFile();
     if (!content) return FileSystem::ErrorCode::readFail;
-    auto er = deserializeQuadRootMapperFile(std::string(content->begin(), content->end()));
-    return er;
+    auto er = deserializeQuadRootMapperFile(content.value());
+    if (er) return er;
+    return m_quadRootJournal.replay([this](bool is_put, const std::string& record)
+        {
+            auto tokens = split_token(record, ",");
+            if (tokens.size() != 2) return;
+            if (is_put) m_quadRootFilenameMap.insert_or_assign(QuadTreeRootId{ tokens[0] }, tokens[1]);
+            else m_quadRootFilenameMap.erase(QuadTreeRootId{ tokens[0] });
+        });
 }
 
 std::error_code WorldMapFileStoreMapper::deserializeWorldMapperFile(const std::string& content)
 {
     if (content.empty()) return FileSystem::ErrorCode::ok;
-    std::lock_guard locker{ m_worldMapLock };
     auto lines = split_token(content, "\n\r");
     for (auto& line : lines)
     {
@@ -169,7 +183,6 @@ std::error_code WorldMapFileStoreMapper::deserializeWorldMapperFile(const std::s
 std::error_code WorldMapFileStoreMapper::deserializeQuadRootMapperFile(const std::string& content)
 {
     if (content.empty()) return FileSystem::ErrorCode::ok;
-    std::lock_guard locker{ m_quadTreeRootLock };
     auto lines = split_token(content, "\n\r");
     for (auto& line : lines)
     {
@@ -181,57 +194,63 @@ std::error_code WorldMapFileStoreMapper::deserializeQuadRootMapperFile(const std
     return FileSystem::ErrorCode::ok;
 }
 
-std::error_code WorldMapFileStoreMapper::serializeWorldMapperFile()
+std::string WorldMapFileStoreMapper::serializeWorldMapperFile() const
 {
-    std::lock_guard locker{ m_worldMapLock };
     std::string mapper_file_content;
     for (auto& rec : m_worldFilenameMap)
     {
         mapper_file_content += rec.first.name() + "," + rec.second + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_worldMapperFilename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
-    return FileSystem::ErrorCode::ok;
+    return mapper_file_content;
 }
 
-std::error_code WorldMapFileStoreMapper::serializeQuadRootMapperFile()
+std::string WorldMapFileStoreMapper::serializeQuadRootMapperFile() const
 {
-    std::lock_guard locker{ m_quadTreeRootLock };
     std::string mapper_file_content;
     for (auto& rec : m_quadRootFilenameMap)
     {
         mapper_file_content += rec.first.name() + "," + rec.second + "\n";
     }
-    auto mapper_file = FileSystem::FileSystem::instance()->openFile(m_quadRootMapperFilename, FileSystem::write | FileSystem::binary);
-    if (!mapper_file) return FileSystem::ErrorCode::fileOpenError;
-    auto write_size = mapper_file->write(0, { mapper_file_content.begin(), mapper_file_content.end() });
-    FileSystem::FileSystem::instance()->closeFile(mapper_file);
-    if (write_size != mapper_file_content.size()) return FileSystem::ErrorCode::writeFail;
+    return mapper_file_content;
+}
+
+std::error_code WorldMapFileStoreMapper::journalWorldMapRecord(bool is_put, const std::string& record)
+{
+    auto er = is_put ? m_worldMapJournal.appendPut(record) : m_worldMapJournal.appendRemove(record);
+    if (er) return er;
+    if (m_worldMapJournal.needCompaction()) return m_worldMapJournal.compact(serializeWorldMapperFile());
+    return FileSystem::ErrorCode::ok;
+}
+
+std::error_code WorldMapFileStoreMapper::journalQuadRootRecord(bool is_put, const std::string& record)
+{
+    auto er = is_put ? m_quadRootJournal.appendPut(record) : m_quadRootJournal.appendRemove(record);
+    if (er) return er;
+    if (m_quadRootJournal.needCompaction()) return m_quadRootJournal.compact(serializeQuadRootMapperFile());
     return FileSystem::ErrorCode::ok;
 }
 
 Enigma::Engine::GenericDto WorldMapFileStoreMapper::deserializeDataTransferObjects(const std::string& filename)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     auto dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::read | FileSystem::binary);
     auto file_size = dto_file->size();
-    auto content = dto_file->read(0, file_size);
+    auto content = dto_file->view(0, file_size);
     assert(content.has_value());
     FileSystem::FileSystem::instance()->closeFile(dto_file);
-    auto dtos = m_gateway->deserialize({ std::string(content->begin(), content->end()) });
+    auto dtos = gateway->deserializeBuffer(content->chars(), content->size());
     assert(!dtos.empty());
     return dtos[0];
 }
 
 std::error_code WorldMapFileStoreMapper::serializeDataTransferObjects(const std::string& filename, const Engine::GenericDto& dto)
 {
-    assert(m_gateway);
+    const auto& gateway = m_gateways.selectGateway(filename);
+    assert(gateway);
     FileSystem::IFilePtr dto_file = FileSystem::FileSystem::instance()->openFile(filename, FileSystem::write | FileSystem::binary);
     if (!dto_file) return FileSystem::ErrorCode::fileOpenError;
-    auto content = m_gateway->serialize({ dto });
+    auto content = gateway->serialize({ dto });
     auto write_size = dto_file->write(0, { content.begin(), content.end() });
     FileSystem::FileSystem::instance()->closeFile(dto_file);
     if (write_size != content.size()) return FileSystem::ErrorCode::writeFail;
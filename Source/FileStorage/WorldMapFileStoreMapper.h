@@ -11,7 +11,11 @@
 #include "WorldMap/WorldMapStoreMapper.h"
 #include "WorldMap/WorldMapId.h"
 #include "WorldMap/QuadTreeRootId.h"
-#include "Gateways/DtoGateway.h"
+#include "Gateways/DtoGatewaySelector.h"
+#include "MapperFileJournal.h"
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
 
 namespace Enigma::FileStorage
 {
@@ -40,8 +44,10 @@ namespace Enigma::FileStorage
 
         std::error_code deserializeWorldMapperFile(const std::string& content);
         std::error_code deserializeQuadRootMapperFile(const std::string& content);
-        std::error_code serializeWorldMapperFile();
-        std::error_code serializeQuadRootMapperFile();
+        std::string serializeWorldMapperFile() const;
+        std::string serializeQuadRootMapperFile() const;
+        std::error_code journalWorldMapRecord(bool is_put, const std::string& record);
+        std::error_code journalQuadRootRecord(bool is_put, const std::string& record);
 
         Engine::GenericDto deserializeDataTransferObjects(const std::string& filename);
         std::error_code serializeDataTransferObjects(const std::string& filename, const Engine::GenericDto& dto);
@@ -50,16 +56,20 @@ namespace Enigma::FileStorage
         std::string extractQuadRootFilename(const WorldMap::QuadTreeRootId& id, const Engine::FactoryDesc& factory_desc);
 
     protected:
-        bool m_hasConnected;
-        std::shared_ptr<Gateways::IDtoGateway> m_gateway;
+        std::atomic_bool m_hasConnected;
+        std::mutex m_connectLock;
+        Gateways::DtoGatewaySelector m_gateways;
 
+        //! ADR: query 拿 shared lock 讀檔, put 拿 exclusive lock 寫檔; query 之間仍可平行
         std::string m_worldMapperFilename;
+        MapperFileJournal m_worldMapJournal;
         std::unordered_map<WorldMap::WorldMapId, std::string, WorldMap::WorldMapId::hash> m_worldFilenameMap;
-        std::recursive_mutex m_worldMapLock;
+        std::shared_mutex m_worldMapLock;
 
         std::string m_quadRootMapperFilename;
+        MapperFileJournal m_quadRootJournal;
         std::unordered_map<WorldMap::QuadTreeRootId, std::string, WorldMap::QuadTreeRootId::hash> m_quadRootFilenameMap;
-        std::recursive_mutex m_quadTreeRootLock;
+        std::shared_mutex m_quadTreeRootLock;
     };
 }
 
@@ -5,6 +5,7 @@
 #include "StdioFile.h"
 #include "StdMountPath.h"
 #include "Platforms/PlatformLayerUtilities.h"
+#include "FileSystemErrors.h"
 #include <cassert>
 #include <iostream>
 #include <future>
@@ -20,10 +21,13 @@ FileSystem::FileSystem()
 {
     assert(!m_instance);
     m_instance = this;
+    m_ioThreadPool = std::make_unique<IoThreadPool>(DEFAULT_IO_THREAD_COUNT);
 }
 
 FileSystem::~FileSystem()
 {
+    // 先等 I/O thread 結束, 排隊中的 request 會收到取消通知, 再關檔案
+    m_ioThreadPool = nullptr;
     cleanup();
     m_instance = nullptr;
 }
@@ -62,7 +66,16 @@ IFilePtr FileSystem::openFile(const std::string& filename, const ReadWriteOption
 FutureFile FileSystem::asyncOpenFile(const std::string& filename,
     const ReadWriteOption& rw_options, const std::string& path_id)
 {
-    return std::async(std::launch::async, [=]() -> IFilePtr { return this->openFile(filename, rw_options, path_id); });
+    auto promise = std::make_shared<std::promise<IFilePtr>>();
+    FutureFile f = promise->get_future();
+    if (IoThreadPool::isIoThread())
+    {
+        promise->set_value(openFile(filename, rw_options, path_id));
+        return f;
+    }
+    pushOpenRequest([=]() { return this->openFile(filename, rw_options, path_id); },
+        [promise](const IFilePtr& file, error) { promise->set_value(file); }, IoThreadPool::Priority::Normal);
+    return f;
 }
 
 IFilePtr FileSystem::openFile(const Filename& filename, const ReadWriteOption& rw_options)
@@ -75,6 +88,32 @@ FutureFile FileSystem::asyncOpenFile(const Filename& filename, const ReadWriteOp
     return asyncOpenFile(filename.getSubPathFileName(), rw_options, filename.getMountPathId());
 }
 
+IoThreadPool::RequestId FileSystem::asyncOpenFile(const Filename& filename, const ReadWriteOption& rw_options, const OpenCompletion& on_opened, IoThreadPool::Priority priority)
+{
+    return pushOpenRequest([=]() { return this->openFile(filename, rw_options); }, on_opened, priority);
+}
+
+IoThreadPool::RequestId FileSystem::pushOpenRequest(const std::function<IFilePtr()>& opener, const OpenCompletion& on_opened, IoThreadPool::Priority priority)
+{
+    auto open_work = [=]()
+    {
+        IFilePtr file = opener();
+        if (on_opened) on_opened(file, file ? error{} : make_error_code(ErrorCode::fileOpenError));
+    };
+    return m_ioThreadPool->pushRequest(priority, open_work, [on_opened]() { if (on_opened) on_opened(nullptr, ErrorCode::ioRequestCancelled); });
+}
+
+bool FileSystem::cancelIoRequest(IoThreadPool::RequestId id)
+{
+    return m_ioThreadPool->cancelRequest(id);
+}
+
+IoThreadPool* FileSystem::ioThreadPool()
+{
+    if (!m_instance) return nullptr;
+    return m_instance->m_ioThreadPool.get();
+}
+
 IFilePtr FileSystem::openStdioFile(const std::string& filepath, const std::string& filename,
     const ReadWriteOption& rw_option)
 {
@@ -16,11 +16,19 @@
 #include <list>
 #include <mutex>
 #include <filesystem>
+#include <memory>
+#include <functional>
 
 namespace Enigma::FileSystem
 {
     class FileSystem
     {
+    public:
+        /// I/O 大多在等硬碟, 幾條 thread 就夠了; world streaming 的大量請求是排隊而不是開 thread
+        static constexpr unsigned DEFAULT_IO_THREAD_COUNT = 4;
+        /** 在 I/O thread 上呼叫, 失敗或取消時 file 為 nullptr */
+        using OpenCompletion = std::function<void(const IFilePtr& file, error er)>;
+
     public:
         ~FileSystem();
 
@@ -32,6 +40,7 @@ namespace Enigma::FileSystem
         @param rw_options option bits
         @param path_id  像是變數名稱之類的字串，例如 "EXECUTABLE_PATH", "RESOURCE_PATH" */
         IFilePtr openFile(const std::string& filename, const ReadWriteOption& rw_options, const std::string& path_id);
+        /** 在 I/O thread 上呼叫時同步開檔, 回傳已完成的 future (見 IoThreadPool::isIoThread) */
         FutureFile asyncOpenFile(const std::string& filename, const ReadWriteOption& rw_options, const std::string& path_id);
 
         /** Open File
@@ -39,6 +48,13 @@ namespace Enigma::FileSystem
         @param filename  filename object */
         IFilePtr openFile(const Filename& filename, const ReadWriteOption& rw_options);
         FutureFile asyncOpenFile(const Filename& filename, const ReadWriteOption& rw_options);
+        IoThreadPool::RequestId asyncOpenFile(const Filename& filename, const ReadWriteOption& rw_options, const OpenCompletion& on_opened,
+            IoThreadPool::Priority priority = IoThreadPool::Priority::Normal);
+
+        /** 取消還沒開始的 async open/read/write, completion 會收到 ioRequestCancelled */
+        bool cancelIoRequest(IoThreadPool::RequestId id);
+        /** file system 還沒建立時為 nullptr, async 操作會直接同步執行 */
+        static IoThreadPool* ioThreadPool();
 
         void closeFile(const IFilePtr& file);
 
@@ -58,6 +74,8 @@ namespace Enigma::FileSystem
         void closeAllOpenedFiles();
         void removeAllMountPaths();
 
+        IoThreadPool::RequestId pushOpenRequest(const std::function<IFilePtr()>& opener, const OpenCompletion& on_opened, IoThreadPool::Priority priority);
+
         IFilePtr openStdioFile(const std::string& filepath, const std::string& filename, const ReadWriteOption& rw_option);
 
         IFilePtr openMountedFile(const IMountPathPtr& path, const std::string& filename, const ReadWriteOption& rw_option);
@@ -66,6 +84,8 @@ namespace Enigma::FileSystem
     private:
         static FileSystem* m_instance;
 
+        std::unique_ptr<IoThreadPool> m_ioThreadPool;
+
         using FileObjectList = std::list<IFilePtr>;
         using MountPathList = std::list<IMountPathPtr>;
 
@@ -24,6 +24,7 @@ std::string ErrorCategory::message(int err) const
     case ErrorCode::readFail: return "Read fail";
     case ErrorCode::writeFail: return "Write fail";
     case ErrorCode::retrieveContentFail: return "Retrieve content fail";
+    case ErrorCode::ioRequestCancelled: return "I/O request cancelled";
     }
     return "Unknown";
 }
@@ -30,6 +30,7 @@ namespace Enigma::FileSystem
         readFail,
         writeFail,
         retrieveContentFail,
+        ioRequestCancelled,
     };
     class ErrorCategory : public std::error_category
     {
@@ -0,0 +1,54 @@
+﻿/*********************************************************************
+ * \file   FileView.h
+ * \brief  read-only view of file content, zero-copy
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef FILE_VIEW_H
+#define FILE_VIEW_H
+
+#include <memory>
+#include <vector>
+#include <string_view>
+#include <cstddef>
+
+namespace Enigma::FileSystem
+{
+    /** 指向檔案內容的唯讀 view, owner 保持底層的記憶體 (mmap 區段, package 的 cache buffer...) 存活,
+     所以 view 可以比 IFile 物件活得久 (關檔後還能繼續 parse) */
+    class FileView
+    {
+    public:
+        FileView() : m_data(nullptr), m_size(0) {}
+        FileView(const std::shared_ptr<const void>& owner, const unsigned char* data, size_t size) : m_owner(owner), m_data(data), m_size(size) {}
+
+        /** 沒有 mmap / 共用 buffer 的 file 用 read() 的結果包成 view */
+        static FileView fromBuffer(std::vector<unsigned char>&& buffer)
+        {
+            auto owner = std::make_shared<const std::vector<unsigned char>>(std::move(buffer));
+            return FileView(owner, owner->data(), owner->size());
+        }
+
+        const unsigned char* data() const { return m_data; }
+        const char* chars() const { return reinterpret_cast<const char*>(m_data); }
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        std::string_view asStringView() const { return std::string_view(chars(), m_size); }
+        /** offset, size 超出範圍會被截掉 */
+        FileView subView(size_t offset, size_t size) const
+        {
+            if (offset > m_size) offset = m_size;
+            if (size > m_size - offset) size = m_size - offset;
+            return FileView(m_owner, m_data + offset, size);
+        }
+
+    private:
+        std::shared_ptr<const void> m_owner;
+        const unsigned char* m_data;
+        size_t m_size;
+    };
+}
+
+#endif // FILE_VIEW_H
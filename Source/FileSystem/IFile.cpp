@@ -1,5 +1,6 @@
 ﻿#include "IFile.h"
 #include "FileSystemErrors.h"
+#include "FileSystem.h"
 
 using namespace Enigma::FileSystem;
 
@@ -12,14 +13,71 @@ IFile::~IFile()
 {
 }
 
+std::optional<FileView> IFile::view(size_t offset, size_t size_request)
+{
+    auto buffer = read(offset, size_request);
+    if (!buffer) return std::nullopt;
+    return FileView::fromBuffer(std::move(buffer.value()));
+}
+
 IFile::FutureRead IFile::asyncRead(size_t offset, size_t size_request)
 {
-    return std::async(std::launch::async, &IFile::read, this, offset, size_request);
+    auto promise = std::make_shared<std::promise<std::optional<std::vector<unsigned char>>>>();
+    FutureRead f = promise->get_future();
+    if (IoThreadPool::isIoThread())
+    {
+        promise->set_value(read(offset, size_request));
+        return f;
+    }
+    asyncRead(offset, size_request, [promise](std::optional<std::vector<unsigned char>> buffer, error) { promise->set_value(std::move(buffer)); });
+    return f;
+}
+
+IoThreadPool::RequestId IFile::asyncRead(size_t offset, size_t size_request, const ReadCompletion& on_read, IoThreadPool::Priority priority)
+{
+    auto read_work = [=]()
+    {
+        auto buffer = read(offset, size_request);
+        const error er = buffer ? error{} : lastError();
+        if (on_read) on_read(std::move(buffer), er);
+    };
+    IoThreadPool* pool = FileSystem::ioThreadPool();
+    if (!pool)
+    {
+        read_work();
+        return IoThreadPool::INVALID_REQUEST;
+    }
+    return pool->pushRequest(priority, read_work, [on_read]() { if (on_read) on_read(std::nullopt, ErrorCode::ioRequestCancelled); });
 }
 
 IFile::FutureWrite IFile::asyncWrite(size_t offset, const std::vector<unsigned char>& in_buff)
 {
-    return std::async(std::launch::async, &IFile::write, this, offset, in_buff);
+    auto promise = std::make_shared<std::promise<size_t>>();
+    FutureWrite f = promise->get_future();
+    if (IoThreadPool::isIoThread())
+    {
+        promise->set_value(write(offset, in_buff));
+        return f;
+    }
+    asyncWrite(offset, in_buff, [promise](size_t write_bytes, error) { promise->set_value(write_bytes); });
+    return f;
+}
+
+IoThreadPool::RequestId IFile::asyncWrite(size_t offset, const std::vector<unsigned char>& in_buff, const WriteCompletion& on_written, IoThreadPool::Priority priority)
+{
+    auto write_work = [=]()
+    {
+        const size_t write_bytes = write(offset, in_buff);
+        const error er = write_bytes ? error{} : lastError();
+        if (on_written) on_written(write_bytes, er);
+    };
+    IoThreadPool* pool = FileSystem::ioThreadPool();
+    if (!pool)
+    {
+        write_work();
+        return IoThreadPool::INVALID_REQUEST;
+    }
+    return pool->pushRequest(priority, write_work, [on_written]() { if (on_written) on_written(0, ErrorCode::ioRequestCancelled); });
 }
 
 error IFile::makeErrorCode(ErrorCode error_code)
@@ -8,10 +8,13 @@
 #ifndef _FILE_INTERFACE_H
 #define _FILE_INTERFACE_H
 
+#include "IoThreadPool.h"
+#include "FileView.h"
 #include <string>
 #include <future>
 #include <optional>
 #include <vector>
+#include <system_error>
 
 namespace Enigma::FileSystem
 {
@@ -22,6 +25,9 @@ namespace Enigma::FileSystem
     public:
         using FutureRead = std::future<std::optional<std::vector<unsigned char>>>;
         using FutureWrite = std::future<size_t>;
+        /** 在 I/O thread 上呼叫, 取消時 buffer 為 nullopt, error 為 ioRequestCancelled */
+        using ReadCompletion = std::function<void(std::optional<std::vector<unsigned char>> buffer, error er)>;
+        using WriteCompletion = std::function<void(size_t write_bytes, error er)>;
     public:
         IFile();
         IFile(const IFile&) = delete;
@@ -33,9 +39,18 @@ namespace Enigma::FileSystem
         virtual std::string getFullPath() = 0;
 
         virtual std::optional<std::vector<unsigned char>> read(size_t offset, size_t size_request) = 0;
+        /** 唯讀 view, 可以 mmap 或共用 cache buffer 的 file 不複製內容; 預設用 read() 包成 view */
+        virtual std::optional<FileView> view(size_t offset, size_t size_request);
+        /** 在 I/O thread 上呼叫時同步讀完, 回傳已完成的 future (見 IoThreadPool::isIoThread) */
         virtual FutureRead asyncRead(size_t offset, size_t size_request);
+        /** 排進 file system 的 I/O thread pool, 完成時呼叫 on_read; 呼叫端要保持 file 物件存活到完成 */
+        virtual IoThreadPool::RequestId asyncRead(size_t offset, size_t size_request, const ReadCompletion& on_read,
+            IoThreadPool::Priority priority = IoThreadPool::Priority::Normal);
         virtual size_t  write(size_t offset, const std::vector<unsigned char>& in_buff) = 0;
+        /** 在 I/O thread 上呼叫時同步寫完, 回傳已完成的 future */
         virtual FutureWrite asyncWrite(size_t offset, const std::vector<unsigned char>& in_buff);
+        virtual IoThreadPool::RequestId asyncWrite(size_t offset, const std::vector<unsigned char>& in_buff, const WriteCompletion& on_written,
+            IoThreadPool::Priority priority = IoThreadPool::Priority::Normal);
 
         virtual size_t size() = 0;
         /** 檔案時間 (最後修改時間) \n 一個長整數，用ctime, localtime函式去取得其他格式的時間表示法 */
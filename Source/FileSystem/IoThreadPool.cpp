@@ -0,0 +1,183 @@
+﻿#include "IoThreadPool.h"
+#include "Platforms/ProfileZone.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::FileSystem;
+
+static thread_local bool s_isIoThread = false;
+
+IoThreadPool::IoThreadPool(unsigned thread_count) : m_lastRequestId(INVALID_REQUEST), m_isExiting(false)
+{
+    if (thread_count == 0) thread_count = 1;
+    m_threads.reserve(thread_count);
+    for (unsigned i = 0; i < thread_count; i++)
+    {
+        m_threads.emplace_back([this]() { threadProcedure(); });
+    }
+}
+
+IoThreadPool::~IoThreadPool()
+{
+    std::vector<CancelHandler> cancelled;
+    {
+        std::lock_guard locker{ m_queueLock };
+        m_isExiting = true;
+        for (auto& queue : m_queues)
+        {
+            for (auto& request : queue)
+            {
+                if (request.m_onCancelled) cancelled.emplace_back(std::move(request.m_onCancelled));
+            }
+            queue.clear();
+        }
+    }
+    m_queueCondition.notify_all();
+    for (auto& t : m_threads)
+    {
+        if (t.joinable()) t.join();
+    }
+    m_threads.clear();
+    for (auto& on_cancelled : cancelled)
+    {
+        on_cancelled();
+    }
+}
+
+IoThreadPool::RequestId IoThreadPool::pushRequest(Priority priority, const Work& work, const CancelHandler& on_cancelled)
+{
+    assert(priority < Priority::Count);
+    RequestId id;
+    {
+        std::lock_guard locker{ m_queueLock };
+        if (m_isExiting)
+        {
+            id = INVALID_REQUEST;
+        }
+        else
+        {
+            id = ++m_lastRequestId;
+            m_queues[static_cast<size_t>(priority)].push_back(Request{ id, work, on_cancelled });
+        }
+    }
+    if (id == INVALID_REQUEST)
+    {
+        if (on_cancelled) on_cancelled();
+        return id;
+    }
+    m_queueCondition.notify_one();
+    return id;
+}
+
+bool IoThreadPool::cancelRequest(RequestId id)
+{
+    if (id == INVALID_REQUEST) return false;
+    CancelHandler on_cancelled;
+    {
+        std::lock_guard locker{ m_queueLock };
+        bool is_found = false;
+        for (auto& queue : m_queues)
+        {
+            auto it = std::find_if(queue.begin(), queue.end(), [id](const Request& r) { return r.m_id == id; });
+            if (it == queue.end()) continue;
+            on_cancelled = std::move(it->m_onCancelled);
+            queue.erase(it);
+            is_found = true;
+            break;
+        }
+        if (!is_found) return false;
+    }
+    // cancel handler 可能再排新的 request, 不能拿著鎖呼叫
+    if (on_cancelled) on_cancelled();
+    return true;
+}
+
+void IoThreadPool::parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& task, size_t min_range)
+{
+    if (count == 0) return;
+    if (min_range == 0) min_range = 1;
+    const size_t max_ranges = static_cast<size_t>(threadCount()) + 1;  // I/O threads + calling thread
+    const size_t range_count = std::max<size_t>(1, std::min(max_ranges, count / min_range));
+    const size_t range_size = (count + range_count - 1) / range_count;
+    if (range_count == 1)
+    {
+        task(0, count);
+        return;
+    }
+    // helper request 可能在 parallelFor 回傳後才被排到, 所以狀態要 shared; 搶不到 range 的 helper 不碰 task
+    struct SharedRanges
+    {
+        std::atomic<size_t> m_next{ 0 };
+        size_t m_doneCount{ 0 };
+        std::mutex m_doneLock;
+        std::condition_variable m_doneCondition;
+    };
+    auto ranges = std::make_shared<SharedRanges>();
+    auto run_ranges = [ranges, &task, count, range_count, range_size]()
+    {
+        for (size_t index = ranges->m_next.fetch_add(1); index < range_count; index = ranges->m_next.fetch_add(1))
+        {
+            const size_t begin = index * range_size;
+            if (begin < count) task(begin, std::min(count, begin + range_size));
+            std::lock_guard locker{ ranges->m_doneLock };
+            if (++ranges->m_doneCount == range_count) ranges->m_doneCondition.notify_all();
+        }
+    };
+    std::vector<RequestId> helpers;
+    helpers.reserve(range_count - 1);
+    for (size_t i = 1; i < range_count; i++)
+    {
+        helpers.emplace_back(pushRequest(Priority::High, run_ranges));
+    }
+    run_ranges();
+    {
+        std::unique_lock locker{ ranges->m_doneLock };
+        ranges->m_doneCondition.wait(locker, [&ranges, range_count]() { return ranges->m_doneCount == range_count; });
+    }
+    // 還在排隊的 helper 已經沒事做了
+    for (auto id : helpers)
+    {
+        if (id != INVALID_REQUEST) cancelRequest(id);
+    }
+}
+
+bool IoThreadPool::isIoThread()
+{
+    return s_isIoThread;
+}
+
+size_t IoThreadPool::pendingCount()
+{
+    std::lock_guard locker{ m_queueLock };
+    size_t count = 0;
+    for (const auto& queue : m_queues)
+    {
+        count += queue.size();
+    }
+    return count;
+}
+
+void IoThreadPool::threadProcedure()
+{
+    PROFILE_THREAD_NAME("IoThread");
+    s_isIoThread = true;
+    while (true)
+    {
+        Work work;
+        {
+            std::unique_lock locker{ m_queueLock };
+            m_queueCondition.wait(locker, [this]()
+                { return m_isExiting || std::any_of(m_queues.begin(), m_queues.end(), [](const auto& q) { return !q.empty(); }); });
+            if (m_isExiting) return;
+            auto queue = std::find_if(m_queues.begin(), m_queues.end(), [](const auto& q) { return !q.empty(); });
+            work = std::move(queue->front().m_work);
+            queue->pop_front();
+        }
+        // work 完成後自己呼叫 completion callback, callback 裡可以再排下一個 request (ex. open -> read)
+        if (work)
+        {
+            PROFILE_ZONE("IoThreadPool::work");
+            work();
+        }
+    }
+}
@@ -0,0 +1,77 @@
+﻿/*********************************************************************
+ * \file   IoThreadPool.h
+ * \brief  fixed size I/O worker pool, request queue with priorities & cancellation
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef IO_THREAD_POOL_H
+#define IO_THREAD_POOL_H
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+
+namespace Enigma::FileSystem
+{
+    /** 檔案的 open/read/write 都排進這裡, 不再每個操作開一條 std::async thread.
+     完成時由 request 自己的 callback 通知 (在 I/O thread 上呼叫); 還沒開始的 request 可以取消,
+     取消時 (包含 pool 結束時還在排隊的) 會呼叫 cancel handler */
+    class IoThreadPool
+    {
+    public:
+        enum class Priority { High = 0, Normal, Low, Count };
+        using RequestId = std::uint64_t;
+        static constexpr RequestId INVALID_REQUEST = 0;
+        using Work = std::function<void()>;
+        using CancelHandler = std::function<void()>;
+
+    public:
+        explicit IoThreadPool(unsigned thread_count);
+        IoThreadPool(const IoThreadPool&) = delete;
+        IoThreadPool(IoThreadPool&&) = delete;
+        ~IoThreadPool();
+        IoThreadPool& operator=(const IoThreadPool&) = delete;
+        IoThreadPool& operator=(IoThreadPool&&) = delete;
+
+        RequestId pushRequest(Priority priority, const Work& work, const CancelHandler& on_cancelled = nullptr);
+        /** 只能取消還在排隊的 request, 已經在執行或已完成的回傳 false */
+        bool cancelRequest(RequestId id);
+        /** 把 [0, count) 切段, 由 I/O threads 跟呼叫端一起做完才回傳; 呼叫端自己也會搶 range 做,
+         所以在 I/O thread 上呼叫 (或 pool 忙碌) 也不會卡死 */
+        void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& task, size_t min_range = 1);
+
+        unsigned threadCount() const { return static_cast<unsigned>(m_threads.size()); }
+        size_t pendingCount();
+
+        /** 目前的 thread 是不是 (任一個) pool 的 I/O thread; 在 I/O thread 上等 I/O 結果的 future,
+         I/O threads 都在等的時候就沒人能完成它, 所以回傳 future 的 API 在 I/O thread 上改成同步執行 */
+        static bool isIoThread();
+
+    protected:
+        struct Request
+        {
+            RequestId m_id;
+            Work m_work;
+            CancelHandler m_onCancelled;
+        };
+        void threadProcedure();
+
+    protected:
+        std::vector<std::thread> m_threads;
+        std::array<std::deque<Request>, static_cast<size_t>(Priority::Count)> m_queues;
+        std::mutex m_queueLock;
+        std::condition_variable m_queueCondition;
+        RequestId m_lastRequestId;
+        bool m_isExiting;
+    };
+}
+
+#endif // IO_THREAD_POOL_H
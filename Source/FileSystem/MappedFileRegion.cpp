@@ -0,0 +1,81 @@
+﻿#include "MappedFileRegion.h"
+#include "Platforms/PlatformConfig.h"
+#if TARGET_PLATFORM == PLATFORM_WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Enigma::FileSystem;
+
+MappedFileRegion::MappedFileRegion() : m_data(nullptr), m_size(0), m_mappingHandle(nullptr)
+{
+}
+
+#if TARGET_PLATFORM == PLATFORM_WIN32
+
+MappedFileRegion::~MappedFileRegion()
+{
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mappingHandle) CloseHandle(m_mappingHandle);
+}
+
+std::shared_ptr<MappedFileRegion> MappedFileRegion::map(const std::string& full_path)
+{
+    HANDLE file = CreateFileA(full_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER file_size;
+    if ((!GetFileSizeEx(file, &file_size)) || (file_size.QuadPart == 0))
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+    // mapping object 會保留檔案的參考, file handle 可以先關
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return nullptr;
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    std::shared_ptr<MappedFileRegion> region{ new MappedFileRegion() };
+    region->m_data = static_cast<const unsigned char*>(view);
+    region->m_size = static_cast<size_t>(file_size.QuadPart);
+    region->m_mappingHandle = mapping;
+    return region;
+}
+
+#else
+
+MappedFileRegion::~MappedFileRegion()
+{
+    if (m_data) munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+std::shared_ptr<MappedFileRegion> MappedFileRegion::map(const std::string& full_path)
+{
+    const int fd = ::open(full_path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat attrib;
+    if ((fstat(fd, &attrib) != 0) || (attrib.st_size <= 0))
+    {
+        ::close(fd);
+        return nullptr;
+    }
+    const size_t file_size = static_cast<size_t>(attrib.st_size);
+    void* view = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mapping 建立後 fd 就不需要了
+    ::close(fd);
+    if (view == MAP_FAILED) return nullptr;
+    std::shared_ptr<MappedFileRegion> region{ new MappedFileRegion() };
+    region->m_data = static_cast<const unsigned char*>(view);
+    region->m_size = file_size;
+    return region;
+}
+
+#endif
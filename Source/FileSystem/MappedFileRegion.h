@@ -0,0 +1,43 @@
+﻿/*********************************************************************
+ * \file   MappedFileRegion.h
+ * \brief  read-only memory mapping of a whole file
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef MAPPED_FILE_REGION_H
+#define MAPPED_FILE_REGION_H
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+namespace Enigma::FileSystem
+{
+    /** win32 用 file mapping object, 其他平台用 mmap; 空檔案無法 map */
+    class MappedFileRegion
+    {
+    public:
+        MappedFileRegion(const MappedFileRegion&) = delete;
+        MappedFileRegion(MappedFileRegion&&) = delete;
+        ~MappedFileRegion();
+        MappedFileRegion& operator=(const MappedFileRegion&) = delete;
+        MappedFileRegion& operator=(MappedFileRegion&&) = delete;
+
+        /** 失敗回傳 nullptr, 呼叫端改用一般 read */
+        static std::shared_ptr<MappedFileRegion> map(const std::string& full_path);
+
+        const unsigned char* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        MappedFileRegion();
+
+    private:
+        const unsigned char* m_data;
+        size_t m_size;
+        void* m_mappingHandle;
+    };
+}
+
+#endif // MAPPED_FILE_REGION_H
@@ -3,6 +3,7 @@
 #include "Platforms/PlatformLayerUtilities.h"
 #include "FileSystemErrors.h"
 #include <cassert>
+#include <algorithm>
 
 using namespace Enigma::FileSystem;
 
@@ -36,18 +37,64 @@ std::optional<std::vector<unsigned char>> PackageContent::read(size_t offset, si
         makeErrorCode(ErrorCode::zeroReadSize);
         return std::nullopt;
     }
-    if (m_cacheBuffer.empty())
+    if (((!m_cacheBuffer) || (m_cacheBuffer->empty())) && (isExisted()) && ((offset != 0) || (size_request < m_size)))
+    {
+        // 部分讀取不快取整個 asset, 只解壓縮碰到的 block
+        if (offset >= m_size)
+        {
+            makeErrorCode(ErrorCode::readOffsetError);
+            return std::nullopt;
+        }
+        auto buff = m_packageFile.lock()->tryRetrieveAssetRange(m_keyName, static_cast<unsigned int>(offset), static_cast<unsigned int>(std::min(size_request, m_size - offset)));
+        if (!buff)
+        {
+            makeErrorCode(ErrorCode::retrieveContentFail);
+            return std::nullopt;
+        }
+        return std::vector<unsigned char>(buff->cbegin(), buff->cend());
+    }
+    if ((!m_cacheBuffer) || (m_cacheBuffer->empty()))
     {
         ErrorCode er = RetrieveAssetContent();
         if (makeErrorCode(er)) return std::nullopt;
     }
-    if (m_cacheBuffer.empty())
+    if ((!m_cacheBuffer) || (m_cacheBuffer->empty()))
+    {
+        return std::nullopt;
+    }
+    if (offset > m_size)
     {
+        makeErrorCode(ErrorCode::readOffsetError);
         return std::nullopt;
     }
     size_t read_bytes = size_request;
     if (offset + size_request > m_size) read_bytes = m_size - offset;
-    return std::vector<unsigned char>(m_cacheBuffer.cbegin() + offset, m_cacheBuffer.cbegin() + offset + read_bytes);
+    return std::vector<unsigned char>(m_cacheBuffer->cbegin() + offset, m_cacheBuffer->cbegin() + offset + read_bytes);
+}
+
+std::optional<FileView> PackageContent::view(size_t offset, size_t size_request)
+{
+    if (!IsValidContent()) return std::nullopt;
+    if (size_request == 0)
+    {
+        makeErrorCode(ErrorCode::zeroReadSize);
+        return std::nullopt;
+    }
+    if ((!m_cacheBuffer) || (m_cacheBuffer->empty()))
+    {
+        ErrorCode er = RetrieveAssetContent();
+        if (makeErrorCode(er)) return std::nullopt;
+    }
+    if ((!m_cacheBuffer) || (m_cacheBuffer->empty()))
+    {
+        return std::nullopt;
+    }
+    if (offset > m_size)
+    {
+        makeErrorCode(ErrorCode::readOffsetError);
+        return std::nullopt;
+    }
+    return FileView(m_cacheBuffer, reinterpret_cast<const unsigned char*>(m_cacheBuffer->data()), m_size).subView(offset, size_request);
 }
 
 size_t PackageContent::write(size_t, const std::vector<unsigned char>&)
@@ -88,7 +135,7 @@ error PackageContent::close()
 {
     if (!IsValidContent()) return lastError();
     m_size = 0;
-    m_cacheBuffer.clear();
+    m_cacheBuffer = nullptr;
     m_packageFile.reset();
     return ErrorCode::ok;
 }
@@ -120,7 +167,7 @@ ErrorCode PackageContent::RetrieveAssetContent()
     {
         return ErrorCode::retrieveContentFail;
     }
-    m_cacheBuffer = buff.value();
-    m_size = m_cacheBuffer.size();
+    m_cacheBuffer = std::make_shared<const std::vector<char>>(std::move(buff.value()));
+    m_size = m_cacheBuffer->size();
     return ErrorCode::ok;
 }
\ No newline at end of file
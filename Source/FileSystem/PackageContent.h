@@ -29,6 +29,8 @@ namespace Enigma::FileSystem
         virtual std::string getFullPath() override { return m_fullPath; };
 
         virtual std::optional<std::vector<unsigned char>> read(size_t offset, size_t size_request) override;
+        /** view 共用解壓後的 cache buffer, 不複製 */
+        virtual std::optional<FileView> view(size_t offset, size_t size_request) override;
         virtual size_t  write(size_t offset, const std::vector<unsigned char>& in_buff) override;
 
         virtual size_t size() override;
@@ -50,7 +52,8 @@ namespace Enigma::FileSystem
         std::string m_keyName;
         std::string m_fullPath;
 
-        std::vector<char> m_cacheBuffer;
+        /// 給出去的 view 會共用這個 buffer, close 之後 view 仍然有效
+        std::shared_ptr<const std::vector<char>> m_cacheBuffer;
         size_t m_size;
     };
 }
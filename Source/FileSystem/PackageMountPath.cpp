@@ -1,6 +1,7 @@
 ﻿#include "PackageMountPath.h"
 #include "AssetPackage/AssetPackageFile.h"
 #include "PackageContent.h"
+#include "FileSystem.h"
 #include "Platforms/MemoryMacro.h"
 #include <cassert>
 
@@ -14,6 +15,11 @@ PackageMountPath::PackageMountPath(const std::shared_ptr<AssetPackage::AssetPack
     assert(package);
     m_assetPackage = package;
     m_packageFilename = m_assetPackage->getBaseFilename();
+    m_assetPackage->setParallelFor([](size_t count, const auto& task)
+        {
+            if (auto pool = FileSystem::ioThreadPool()) pool->parallelFor(count, task);
+            else task(0, count);
+        });
 }
 
 PackageMountPath::~PackageMountPath()
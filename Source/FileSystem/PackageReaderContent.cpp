@@ -0,0 +1,132 @@
+﻿#include "PackageReaderContent.h"
+#include "AssetPackage/AssetPackageReader.h"
+#include "FileSystemErrors.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::FileSystem;
+
+PackageReaderContent::PackageReaderContent(const std::shared_ptr<AssetPackage::AssetPackageReader>& pack, const std::string& key_name)
+    : IFile(), m_packageReader(pack), m_keyName(key_name), m_size(0)
+{
+    if (pack)
+    {
+        m_fullPath = pack->getBaseFilename() + "/" + m_keyName;
+    }
+}
+
+PackageReaderContent::~PackageReaderContent()
+{
+    m_cacheBuffer = nullptr;
+}
+
+std::optional<std::vector<unsigned char>> PackageReaderContent::read(size_t offset, size_t size_request)
+{
+    if (!isValidContent()) return std::nullopt;
+    if (size_request == 0)
+    {
+        makeErrorCode(ErrorCode::zeroReadSize);
+        return std::nullopt;
+    }
+    if (!isExisted()) return std::nullopt;
+    if (offset >= m_size)
+    {
+        makeErrorCode(ErrorCode::readOffsetError);
+        return std::nullopt;
+    }
+    const size_t read_bytes = std::min(size_request, m_size - offset);
+    if (m_cacheBuffer)
+    {
+        return std::vector<unsigned char>(m_cacheBuffer->cbegin() + offset, m_cacheBuffer->cbegin() + offset + read_bytes);
+    }
+    auto buff = m_packageReader.lock()->tryRetrieveAssetRange(m_keyName, static_cast<unsigned int>(offset), static_cast<unsigned int>(read_bytes));
+    if (!buff)
+    {
+        makeErrorCode(ErrorCode::retrieveContentFail);
+        return std::nullopt;
+    }
+    return std::vector<unsigned char>(buff->cbegin(), buff->cend());
+}
+
+std::optional<FileView> PackageReaderContent::view(size_t offset, size_t size_request)
+{
+    if (!isValidContent()) return std::nullopt;
+    if (size_request == 0)
+    {
+        makeErrorCode(ErrorCode::zeroReadSize);
+        return std::nullopt;
+    }
+    if (!isExisted()) return std::nullopt;
+    if (offset > m_size)
+    {
+        makeErrorCode(ErrorCode::readOffsetError);
+        return std::nullopt;
+    }
+    if (!m_cacheBuffer)
+    {
+        auto buff = m_packageReader.lock()->tryRetrieveAssetToMemory(m_keyName);
+        if (!buff)
+        {
+            makeErrorCode(ErrorCode::retrieveContentFail);
+            return std::nullopt;
+        }
+        m_cacheBuffer = std::make_shared<const std::vector<char>>(std::move(buff.value()));
+    }
+    return FileView(m_cacheBuffer, reinterpret_cast<const unsigned char*>(m_cacheBuffer->data()), m_cacheBuffer->size()).subView(offset, size_request);
+}
+
+size_t PackageReaderContent::write(size_t, const std::vector<unsigned char>&)
+{
+    assert(!"Write not supported on package content");
+    return 0;
+}
+
+size_t PackageReaderContent::size()
+{
+    isExisted();
+    return m_size;
+}
+
+time_t PackageReaderContent::filetime()
+{
+    if (!isValidContent()) return 0;
+    return m_packageReader.lock()->getAssetTimeStamp(m_keyName);
+}
+
+bool PackageReaderContent::isExisted()
+{
+    if (!isValidContent()) return false;
+    if (m_size != 0) return true;
+    m_size = m_packageReader.lock()->getAssetOriginalSize(m_keyName);
+    if (m_size == 0) makeErrorCode(ErrorCode::zeroSizeContent);
+    return m_size != 0;
+}
+
+error PackageReaderContent::open()
+{
+    if (!isExisted()) return lastError();
+    return ErrorCode::ok;
+}
+
+error PackageReaderContent::close()
+{
+    m_size = 0;
+    m_cacheBuffer = nullptr;
+    m_packageReader.reset();
+    return ErrorCode::ok;
+}
+
+bool PackageReaderContent::isValidContent()
+{
+    if (m_packageReader.expired())
+    {
+        makeErrorCode(ErrorCode::expiredPackage);
+        return false;
+    }
+    if (m_keyName.length() == 0)
+    {
+        makeErrorCode(ErrorCode::emptyAssetKey);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+﻿/*********************************************************************
+ * \file   PackageReaderContent.h
+ * \brief  asset content of read-only (memory mapped) package
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef PACKAGE_READER_CONTENT_H
+#define PACKAGE_READER_CONTENT_H
+
+#include "IFile.h"
+
+namespace Enigma::AssetPackage
+{
+    class AssetPackageReader;
+}
+
+namespace Enigma::FileSystem
+{
+    class PackageReaderContent : public IFile
+    {
+    public:
+        PackageReaderContent(const std::shared_ptr<AssetPackage::AssetPackageReader>& pack, const std::string& key_name);
+        PackageReaderContent(const PackageReaderContent&) = delete;
+        PackageReaderContent(PackageReaderContent&&) = delete;
+        virtual ~PackageReaderContent() override;
+        PackageReaderContent& operator=(const PackageReaderContent&) = delete;
+        PackageReaderContent& operator=(PackageReaderContent&&) = delete;
+
+        virtual std::string getFullPath() override { return m_fullPath; };
+
+        /** 每次只解壓縮要讀的範圍, 不快取 */
+        virtual std::optional<std::vector<unsigned char>> read(size_t offset, size_t size_request) override;
+        /** 第一次 view 時解壓縮整個 asset, 之後的 view 共用這份 buffer */
+        virtual std::optional<FileView> view(size_t offset, size_t size_request) override;
+        virtual size_t  write(size_t offset, const std::vector<unsigned char>& in_buff) override;
+
+        virtual size_t size() override;
+
+        virtual time_t filetime() override;
+
+        virtual bool isExisted() override;
+        virtual bool isWritable() override { return false; };
+
+    protected:
+        virtual error open() override;
+        virtual error close() override;
+
+        bool isValidContent();
+
+    private:
+        std::weak_ptr<AssetPackage::AssetPackageReader> m_packageReader;
+        std::string m_keyName;
+        std::string m_fullPath;
+
+        std::shared_ptr<const std::vector<char>> m_cacheBuffer;
+        size_t m_size;
+    };
+}
+
+#endif // PACKAGE_READER_CONTENT_H
@@ -0,0 +1,56 @@
+﻿#include "PackageReaderMountPath.h"
+#include "AssetPackage/AssetPackageReader.h"
+#include "PackageReaderContent.h"
+#include "FileSystem.h"
+#include "Platforms/MemoryMacro.h"
+#include <cassert>
+
+#undef CreateFile
+
+using namespace Enigma::FileSystem;
+
+PackageReaderMountPath::PackageReaderMountPath(const std::shared_ptr<AssetPackage::AssetPackageReader>& package, const std::string& path_id)
+    : IMountPath(path_id)
+{
+    assert(package);
+    m_assetPackage = package;
+    m_packageFilename = m_assetPackage->getBaseFilename();
+    m_assetPackage->setParallelFor([](size_t count, const auto& task)
+        {
+            if (auto pool = FileSystem::ioThreadPool()) pool->parallelFor(count, task);
+            else task(0, count);
+        });
+}
+
+PackageReaderMountPath::~PackageReaderMountPath()
+{
+    m_assetPackage = nullptr;
+}
+
+IFile* PackageReaderMountPath::createFile(const std::string& filename, const ReadWriteOption& rw_option)
+{
+    if ((!m_assetPackage) || (filename.length() == 0)) return nullptr;
+    if ((rw_option & ReadWriteOptionWrite).any()) return nullptr;  // must readonly
+    IFile* file = menew PackageReaderContent(m_assetPackage, filename);
+    return file;
+}
+
+bool PackageReaderMountPath::equalMountPath(IMountPath* path)
+{
+    assert(path);
+    if (!equalPathId(path->getPathId())) return false;
+    PackageReaderMountPath* pkg_path = dynamic_cast<PackageReaderMountPath*>(path);
+    if (!pkg_path) return false;
+    if (pkg_path->m_packageFilename != m_packageFilename) return false;
+    return true;
+}
+
+bool PackageReaderMountPath::equalMountPath(const std::filesystem::path& path)
+{
+    return m_packageFilename == path.string();
+}
+
+bool PackageReaderMountPath::equalMountPath(const std::string& path)
+{
+    return m_packageFilename == path;
+}
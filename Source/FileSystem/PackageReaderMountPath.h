@@ -0,0 +1,44 @@
+﻿/*********************************************************************
+ * \file   PackageReaderMountPath.h
+ * \brief  mount path of read-only (memory mapped) asset package
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef PACKAGE_READER_MOUNT_PATH_H
+#define PACKAGE_READER_MOUNT_PATH_H
+
+#include "IMountPath.h"
+#include <memory>
+
+namespace Enigma::AssetPackage
+{
+    class AssetPackageReader;
+}
+namespace Enigma::FileSystem
+{
+    /** 發佈後的 package 用這個掛載, 多個 thread 讀取不會互相鎖住; 要修改 package 時用 PackageMountPath */
+    class PackageReaderMountPath : public IMountPath
+    {
+    public:
+        /** Search Path \n
+        @param package 唯讀封裝檔物件
+        @param path_id 像是變數名稱之類的字串，例如 "EXECUTABLE_PATH", "RESOURCE_PATH"
+        */
+        PackageReaderMountPath(const std::shared_ptr<AssetPackage::AssetPackageReader>& package, const std::string& path_id);
+
+        virtual ~PackageReaderMountPath() override;
+
+        virtual IFile* createFile(const std::string& filename, const ReadWriteOption& rw_option) override;
+
+        virtual bool equalMountPath(IMountPath* path) override;
+        virtual bool equalMountPath(const std::filesystem::path& path) override;
+        virtual bool equalMountPath(const std::string& path) override;
+
+    protected:
+        std::shared_ptr<AssetPackage::AssetPackageReader> m_assetPackage;
+        std::string m_packageFilename;
+    };
+}
+
+#endif // PACKAGE_READER_MOUNT_PATH_H
@@ -2,6 +2,7 @@
 #include "StdioFile.h"
 #include "Platforms/PlatformLayerUtilities.h"
 #include "FileSystemErrors.h"
+#include "MappedFileRegion.h"
 #include <cassert>
 #include <iostream>
 #include "sys/stat.h"
@@ -46,14 +47,21 @@ std::optional<std::vector<unsigned char>> StdioFile::read(size_t offset, size_t
         return std::nullopt;
     }
 
-    m_file.seekg(0, std::fstream::end);
-    size_t file_length = (size_t)m_file.tellg();
+    auto length = fileLength();
+    if (!length)
+    {
+        makeErrorCode(ErrorCode::fileStatusError);
+        return std::nullopt;
+    }
+    size_t file_length = length.value();
     if (offset > file_length)
     {
         makeErrorCode(ErrorCode::readOffsetError);
         return std::nullopt;
     }
     if (offset + size_request > file_length) size_request = file_length - offset;
+    // 空檔案 (或 offset 在檔尾) 回傳空的 buffer, mmap 失敗的 view 也走這裡
+    if (size_request == 0) return std::vector<unsigned char>{};
 
     m_file.seekg(offset);
     if (!m_file)
@@ -74,6 +82,24 @@ std::optional<std::vector<unsigned char>> StdioFile::read(size_t offset, size_t
     return out_buff;
 }
 
+std::optional<FileView> StdioFile::view(size_t offset, size_t size_request)
+{
+    if ((m_isWritable) || (!m_file.is_open())) return IFile::view(offset, size_request);
+    if (size_request == 0)
+    {
+        makeErrorCode(ErrorCode::zeroReadSize);
+        return std::nullopt;
+    }
+    if (!m_mappedRegion) m_mappedRegion = MappedFileRegion::map(m_fullPath);
+    if (!m_mappedRegion) return IFile::view(offset, size_request);
+    if (offset > m_mappedRegion->size())
+    {
+        makeErrorCode(ErrorCode::readOffsetError);
+        return std::nullopt;
+    }
+    return FileView(m_mappedRegion, m_mappedRegion->data(), m_mappedRegion->size()).subView(offset, size_request);
+}
+
 size_t StdioFile::write(size_t offset, const std::vector<unsigned char>& in_buff)
 {
     Debug::Printf("Write File in thread %d\n", std::this_thread::get_id());
@@ -119,13 +145,23 @@ size_t StdioFile::size()
         makeErrorCode(ErrorCode::fileStatusError);
         return 0;
     }
-    m_file.seekg(0, std::fstream::end);
-    if (!m_file)
+    auto length = fileLength();
+    if (!length)
     {
         makeErrorCode(ErrorCode::fileStatusError);
         return 0;
     }
-    return (size_t)m_file.tellg();
+    return length.value();
+}
+
+std::optional<size_t> StdioFile::fileLength()
+{
+    if ((!m_isWritable) && (m_readOnlyLength)) return m_readOnlyLength;
+    m_file.seekg(0, std::fstream::end);
+    if (!m_file) return std::nullopt;
+    const size_t length = (size_t)m_file.tellg();
+    if (!m_isWritable) m_readOnlyLength = length;
+    return length;
 }
 
 time_t StdioFile::filetime()
@@ -197,6 +233,9 @@ error StdioFile::close()
 {
     if (!m_file) return ErrorCode::fileStatusError;
     m_file.close();
+    // 已經給出去的 view 各自抓著 mapping, 這裡只放掉 file 自己的參考
+    m_mappedRegion = nullptr;
+    m_readOnlyLength = std::nullopt;
     return ErrorCode::ok;
 }
 
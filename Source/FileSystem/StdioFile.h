@@ -13,9 +13,12 @@
 #include "IFile.h"
 #include "ReadWriteOption.h"
 #include <fstream>
+#include <memory>
 
 namespace Enigma::FileSystem
 {
+    class MappedFileRegion;
+
     class StdioFile : public IFile
     {
     public:
@@ -30,6 +33,8 @@ namespace Enigma::FileSystem
         virtual std::string getFullPath() override { return m_fullPath; };
 
         virtual std::optional<std::vector<unsigned char>> read(size_t offset, size_t size_request) override;
+        /** 唯讀開啟的檔案整個 mmap (第一次呼叫時建立), 寫入模式退回 read */
+        virtual std::optional<FileView> view(size_t offset, size_t size_request) override;
         virtual size_t  write(size_t offset, const std::vector<unsigned char>& in_buff) override;
 
         virtual size_t size() override;
@@ -45,12 +50,18 @@ namespace Enigma::FileSystem
         virtual error open() override;
         virtual error close() override;
 
+    private:
+        /** 唯讀檔案的長度不會變, 記下來省掉每次 read 的 seek to end */
+        std::optional<size_t> fileLength();
+
     private:
         std::fstream m_file;
         std::string m_fullPath;
         ReadWriteOption m_rwOption;
         time_t m_fileTime;
         bool m_isWritable;
+        std::optional<size_t> m_readOnlyLength;
+        std::shared_ptr<MappedFileRegion> m_mappedRegion;
     };
 }
 #undef _CRT_SECURE_NO_WARNINGS
@@ -0,0 +1,252 @@
+﻿#include "AssetRetentionCache.h"
+#include <cassert>
+
+using namespace Enigma::Frameworks;
+
+AssetRetentionCache::AssetRetentionCache(size_t budget_bytes) : m_budget(budget_bytes)
+{
+}
+
+AssetRetentionCache::~AssetRetentionCache()
+{
+    m_entryMap.clear();
+    m_entries.clear();
+    m_pinnedKeys.clear();
+}
+
+void AssetRetentionCache::budget(size_t budget_bytes)
+{
+    std::list<std::shared_ptr<void>> evicted;
+    {
+        std::lock_guard locker{ m_lock };
+        m_budget = budget_bytes;
+        evictToBudget("", evicted);
+    }
+}
+
+size_t AssetRetentionCache::budget() const
+{
+    std::lock_guard locker{ m_lock };
+    return m_budget;
+}
+
+void AssetRetentionCache::categoryBudget(const std::string& category, size_t budget_bytes)
+{
+    std::list<std::shared_ptr<void>> evicted;
+    {
+        std::lock_guard locker{ m_lock };
+        if (budget_bytes == 0)
+        {
+            m_categoryBudgets.erase(category);
+            return;
+        }
+        m_categoryBudgets.insert_or_assign(category, budget_bytes);
+        evictToBudget(category, evicted);
+    }
+}
+
+size_t AssetRetentionCache::categoryBudget(const std::string& category) const
+{
+    std::lock_guard locker{ m_lock };
+    const auto it = m_categoryBudgets.find(category);
+    if (it == m_categoryBudgets.end()) return 0;
+    return it->second;
+}
+
+void AssetRetentionCache::retain(const std::string& category, const std::string& key, const std::shared_ptr<void>& asset, size_t bytes)
+{
+    if (!asset) return;
+    // 被釋放的 asset 可能觸發 repository 的其他動作, 要在 unlock 之後才解構
+    std::list<std::shared_ptr<void>> evicted;
+    {
+        std::lock_guard locker{ m_lock };
+        Key entry_key{ category, key };
+        auto& category_stat = m_categoryStatistics[category];
+        if (const auto it = m_entryMap.find(entry_key); it != m_entryMap.end())
+        {
+            Entry& entry = *it->second;
+            category_stat.m_retainedBytes = category_stat.m_retainedBytes - entry.m_bytes + bytes;
+            m_totalStatistics.m_retainedBytes = m_totalStatistics.m_retainedBytes - entry.m_bytes + bytes;
+            evicted.emplace_back(std::move(entry.m_asset));
+            entry.m_asset = asset;
+            entry.m_bytes = bytes;
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+        }
+        else
+        {
+            m_entries.push_front(Entry{ entry_key, asset, bytes });
+            m_entryMap.emplace(std::move(entry_key), m_entries.begin());
+            category_stat.m_retainedCount++;
+            category_stat.m_retainedBytes += bytes;
+            m_totalStatistics.m_retainedCount++;
+            m_totalStatistics.m_retainedBytes += bytes;
+        }
+        evictToBudget(category, evicted);
+    }
+}
+
+bool AssetRetentionCache::touch(const std::string& category, const std::string& key)
+{
+    std::lock_guard locker{ m_lock };
+    const auto it = m_entryMap.find(Key{ category, key });
+    if (it == m_entryMap.end()) return false;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return true;
+}
+
+void AssetRetentionCache::release(const std::string& category, const std::string& key)
+{
+    std::list<std::shared_ptr<void>> evicted;
+    {
+        std::lock_guard locker{ m_lock };
+        const auto it = m_entryMap.find(Key{ category, key });
+        if (it == m_entryMap.end()) return;
+        auto entry_it = it->second;
+        auto& category_stat = m_categoryStatistics[category];
+        category_stat.m_retainedCount--;
+        category_stat.m_retainedBytes -= entry_it->m_bytes;
+        m_totalStatistics.m_retainedCount--;
+        m_totalStatistics.m_retainedBytes -= entry_it->m_bytes;
+        evicted.emplace_back(std::move(entry_it->m_asset));
+        m_entryMap.erase(it);
+        m_entries.erase(entry_it);
+    }
+}
+
+bool AssetRetentionCache::isRetained(const std::string& category, const std::string& key) const
+{
+    std::lock_guard locker{ m_lock };
+    return m_entryMap.find(Key{ category, key }) != m_entryMap.end();
+}
+
+void AssetRetentionCache::pin(const std::string& category, const std::string& key)
+{
+    std::lock_guard locker{ m_lock };
+    m_pinnedKeys.insert(Key{ category, key });
+}
+
+void AssetRetentionCache::unpin(const std::string& category, const std::string& key)
+{
+    std::list<std::shared_ptr<void>> evicted;
+    {
+        std::lock_guard locker{ m_lock };
+        m_pinnedKeys.erase(Key{ category, key });
+        evictToBudget(category, evicted);
+    }
+}
+
+bool AssetRetentionCache::isPinned(const std::string& category, const std::string& key) const
+{
+    std::lock_guard locker{ m_lock };
+    return m_pinnedKeys.find(Key{ category, key }) != m_pinnedKeys.end();
+}
+
+void AssetRetentionCache::recordHit(const std::string& category)
+{
+    std::lock_guard locker{ m_lock };
+    m_categoryStatistics[category].m_hits++;
+    m_totalStatistics.m_hits++;
+}
+
+void AssetRetentionCache::recordMiss(const std::string& category)
+{
+    std::lock_guard locker{ m_lock };
+    m_categoryStatistics[category].m_misses++;
+    m_totalStatistics.m_misses++;
+}
+
+AssetRetentionCache::Statistics AssetRetentionCache::statistics() const
+{
+    std::lock_guard locker{ m_lock };
+    return m_totalStatistics;
+}
+
+AssetRetentionCache::Statistics AssetRetentionCache::statistics(const std::string& category) const
+{
+    std::lock_guard locker{ m_lock };
+    const auto it = m_categoryStatistics.find(category);
+    if (it == m_categoryStatistics.end()) return Statistics{};
+    return it->second;
+}
+
+void AssetRetentionCache::resetStatistics()
+{
+    std::lock_guard locker{ m_lock };
+    // retained count/bytes 是目前狀態, 不歸零
+    for (auto& [category, stat] : m_categoryStatistics)
+    {
+        stat.m_hits = stat.m_misses = stat.m_evictions = 0;
+    }
+    m_totalStatistics.m_hits = m_totalStatistics.m_misses = m_totalStatistics.m_evictions = 0;
+}
+
+void AssetRetentionCache::clear()
+{
+    std::list<std::shared_ptr<void>> evicted;
+    {
+        std::lock_guard locker{ m_lock };
+        auto it = m_entries.begin();
+        while (it != m_entries.end())
+        {
+            auto current = it++;
+            if (m_pinnedKeys.find(current->m_key) != m_pinnedKeys.end()) continue;
+            evictEntry(current, evicted);
+        }
+    }
+}
+
+void AssetRetentionCache::releaseCategory(const std::string& category)
+{
+    std::list<std::shared_ptr<void>> evicted;
+    {
+        std::lock_guard locker{ m_lock };
+        auto it = m_entries.begin();
+        while (it != m_entries.end())
+        {
+            auto current = it++;
+            if (current->m_key.m_category != category) continue;
+            evictEntry(current, evicted);
+        }
+    }
+}
+
+void AssetRetentionCache::evictToBudget(const std::string& category, std::list<std::shared_ptr<void>>& evicted)
+{
+    // 先處理 category 預算, 再處理總預算, 都從最久沒用的 (list 尾端) 開始
+    if (const auto budget_it = m_categoryBudgets.find(category); budget_it != m_categoryBudgets.end())
+    {
+        const auto& category_stat = m_categoryStatistics[category];
+        auto it = m_entries.end();
+        while ((category_stat.m_retainedBytes > budget_it->second) && (it != m_entries.begin()))
+        {
+            auto current = --it;
+            if (current->m_key.m_category != category) continue;
+            if (m_pinnedKeys.find(current->m_key) != m_pinnedKeys.end()) continue;
+            it = std::next(current);
+            evictEntry(current, evicted);
+        }
+    }
+    auto it = m_entries.end();
+    while ((m_totalStatistics.m_retainedBytes > m_budget) && (it != m_entries.begin()))
+    {
+        auto current = --it;
+        if (m_pinnedKeys.find(current->m_key) != m_pinnedKeys.end()) continue;
+        it = std::next(current);
+        evictEntry(current, evicted);
+    }
+}
+
+void AssetRetentionCache::evictEntry(EntryList::iterator it, std::list<std::shared_ptr<void>>& evicted)
+{
+    assert(it != m_entries.end());
+    auto& category_stat = m_categoryStatistics[it->m_key.m_category];
+    category_stat.m_retainedCount--;
+    category_stat.m_retainedBytes -= it->m_bytes;
+    category_stat.m_evictions++;
+    m_totalStatistics.m_retainedCount--;
+    m_totalStatistics.m_retainedBytes -= it->m_bytes;
+    m_totalStatistics.m_evictions++;
+    evicted.emplace_back(std::move(it->m_asset));
+    m_entryMap.erase(it->m_key);
+    m_entries.erase(it);
+}
@@ -0,0 +1,117 @@
+﻿/*********************************************************************
+ * \file   AssetRetentionCache.h
+ * \brief  repository 共用的 retention cache, 依 byte size 預算保留最近使用的 asset (LRU),
+ *          避免 lazy 區域 dehydrate 後馬上又要從檔案重新讀取
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _ASSET_RETENTION_CACHE_H
+#define _ASSET_RETENTION_CACHE_H
+
+#include <memory>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <cstdint>
+
+namespace Enigma::Frameworks
+{
+    /** asset 以 (category, key) 識別, category 通常是 asset 種類 (geometry, primitive, texture...),
+     key 是 asset id 的字串. cache 持有 shared_ptr, 超過預算時從最久沒用的開始釋放, pinned 的不釋放 */
+    class AssetRetentionCache
+    {
+    public:
+        struct Statistics
+        {
+            std::uint64_t m_hits = 0;
+            std::uint64_t m_misses = 0;
+            std::uint64_t m_evictions = 0;
+            size_t m_retainedCount = 0;
+            size_t m_retainedBytes = 0;
+        };
+
+    public:
+        AssetRetentionCache(size_t budget_bytes);
+        AssetRetentionCache(const AssetRetentionCache&) = delete;
+        AssetRetentionCache(AssetRetentionCache&&) = delete;
+        ~AssetRetentionCache();
+        AssetRetentionCache& operator=(const AssetRetentionCache&) = delete;
+        AssetRetentionCache& operator=(AssetRetentionCache&&) = delete;
+
+        /** total budget, shrinking budget evicts immediately */
+        void budget(size_t budget_bytes);
+        size_t budget() const;
+        /** per category budget, 0 means only limited by total budget */
+        void categoryBudget(const std::string& category, size_t budget_bytes);
+        size_t categoryBudget(const std::string& category) const;
+
+        /** retain asset (or refresh its size & recency), then evict down to budget */
+        void retain(const std::string& category, const std::string& key, const std::shared_ptr<void>& asset, size_t bytes);
+        /** mark as most recently used, return false if not retained */
+        bool touch(const std::string& category, const std::string& key);
+        /** drop asset from cache, ex. asset removed from repository */
+        void release(const std::string& category, const std::string& key);
+        bool isRetained(const std::string& category, const std::string& key) const;
+
+        /** pinned asset is never evicted, pin can be set before asset is retained */
+        void pin(const std::string& category, const std::string& key);
+        void unpin(const std::string& category, const std::string& key);
+        bool isPinned(const std::string& category, const std::string& key) const;
+
+        /** repository 在自己的 map 找到 / 找不到 asset 時記錄, cache 本身不做查詢 */
+        void recordHit(const std::string& category);
+        void recordMiss(const std::string& category);
+
+        Statistics statistics() const;
+        Statistics statistics(const std::string& category) const;
+        void resetStatistics();
+
+        /** release all unpinned assets */
+        void clear();
+        /** release all assets of category, including pinned ones (pin marks are kept), ex. repository terminated */
+        void releaseCategory(const std::string& category);
+
+    protected:
+        struct Key
+        {
+            std::string m_category;
+            std::string m_key;
+            bool operator==(const Key& other) const { return m_category == other.m_category && m_key == other.m_key; }
+        };
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const
+            {
+                const size_t h = std::hash<std::string>()(key.m_category);
+                return h ^ (std::hash<std::string>()(key.m_key) + 0x9e3779b9 + (h << 6) + (h >> 2));
+            }
+        };
+        struct Entry
+        {
+            Key m_key;
+            std::shared_ptr<void> m_asset;
+            size_t m_bytes;
+        };
+        using EntryList = std::list<Entry>;
+
+        /** collect evicted assets, caller destroys them after unlocking */
+        void evictToBudget(const std::string& category, std::list<std::shared_ptr<void>>& evicted);
+        void evictEntry(EntryList::iterator it, std::list<std::shared_ptr<void>>& evicted);
+
+    protected:
+        mutable std::mutex m_lock;
+        size_t m_budget;
+        std::unordered_map<std::string, size_t> m_categoryBudgets;
+        /// front 是最近使用的
+        EntryList m_entries;
+        std::unordered_map<Key, EntryList::iterator, KeyHash> m_entryMap;
+        std::unordered_set<Key, KeyHash> m_pinnedKeys;
+        std::unordered_map<std::string, Statistics> m_categoryStatistics;
+        Statistics m_totalStatistics;
+    };
+}
+
+#endif // _ASSET_RETENTION_CACHE_H
@@ -1,4 +1,5 @@
 ﻿#include "CommandBus.h"
+#include "FrameProfiler.h"
 #include <cassert>
 
 using namespace Enigma::Frameworks;
@@ -80,6 +81,7 @@ void CommandBus::enqueue(const ICommandPtr& c)
     assert(m_thisBus);
     if (!c) return;
     if (m_thisBus->m_isSuspended) return;
+    PROFILE_COUNTER(Command, 1);
 
     m_thisBus->m_commandListLock.lock();
     m_thisBus->m_commands.emplace_back(c);
@@ -91,6 +93,7 @@ void CommandBus::invoke(const ICommandPtr& c)
 {
     assert(m_thisBus);
     if (!c) return;
+    PROFILE_COUNTER(Command, 1);
     auto subscribers = m_thisBus->m_subscribers.find(std::type_index{ c->typeInfo() });
     if (subscribers == m_thisBus->m_subscribers.end()) return;
     m_thisBus->invokeHandler(c, subscribers->second);
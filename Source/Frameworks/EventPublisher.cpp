@@ -1,4 +1,5 @@
 ﻿#include "EventPublisher.h"
+#include "FrameProfiler.h"
 #include <cassert>
 
 using namespace Enigma::Frameworks;
@@ -76,6 +77,7 @@ void EventPublisher::enqueue(const IEventPtr& e)
     assert(m_thisPublisher);
     if (!e) return;
     if (m_thisPublisher->m_isSuspended) return;
+    PROFILE_COUNTER(Event, 1);
 
     m_thisPublisher->m_eventListLock.lock();
     m_thisPublisher->m_events.emplace_back(e);
@@ -87,6 +89,7 @@ void EventPublisher::publish(const IEventPtr& e)
 {
     assert(m_thisPublisher);
     if (!e) return;
+    PROFILE_COUNTER(Event, 1);
     auto subscribers = m_thisPublisher->m_subscribers.find(std::type_index{ e->typeInfo() });
     if (subscribers == m_thisPublisher->m_subscribers.end()) return;
     m_thisPublisher->invokeHandlers(e, subscribers->second);
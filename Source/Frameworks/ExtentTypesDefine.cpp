@@ -2,5 +2,8 @@
 
 future_error make_future_err(std::error_code er)
 {
-    return std::async([=]() { return er; });
+    // 已經有結果, 不需要另開 thread
+    std::promise<std::error_code> promise;
+    promise.set_value(er);
+    return promise.get_future();
 }
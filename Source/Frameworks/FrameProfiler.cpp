@@ -0,0 +1,191 @@
+﻿#include "FrameProfiler.h"
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
+#include <string_view>
+#include <fstream>
+#include <cstdio>
+
+using namespace Enigma::Frameworks;
+using Enigma::Platforms::ProfileZone;
+
+static constexpr size_t MAX_CAPTURED_ZONES = 1024 * 1024;
+static const char* counterNames[]{ "DrawCall", "Bind", "Event", "Command" };
+
+namespace
+{
+    struct CapturedFrame
+    {
+        std::int64_t m_endNanoseconds;
+        FrameProfiler::CounterValues m_counters;
+    };
+
+    std::array<std::atomic<std::int64_t>, static_cast<size_t>(FrameProfiler::Counter::Count)> s_counters{};
+
+    std::mutex s_frameLock;
+    FrameProfiler::FrameStatistics s_lastFrame;
+    std::uint64_t s_frameIndex = 0;
+    std::int64_t s_lastFrameEndNanoseconds = 0;
+    unsigned s_captureRemainingFrames = 0;
+    std::vector<ProfileZone::Record> s_capturedZones;
+    std::vector<CapturedFrame> s_capturedFrames;
+    std::unordered_map<std::uint32_t, std::string> s_capturedThreadNames;
+
+    void appendJsonString(std::string& json, const char* s)
+    {
+        json.push_back('"');
+        for (; *s; ++s)
+        {
+            if ((*s == '"') || (*s == '\\')) json.push_back('\\');
+            if (static_cast<unsigned char>(*s) < 0x20) continue;
+            json.push_back(*s);
+        }
+        json.push_back('"');
+    }
+}
+
+void FrameProfiler::setEnabled(bool is_enabled)
+{
+    ProfileZone::setEnabled(is_enabled);
+}
+
+bool FrameProfiler::isEnabled()
+{
+    return ProfileZone::isEnabled();
+}
+
+void FrameProfiler::addCounter(Counter counter, std::int64_t value)
+{
+    if (!ProfileZone::isEnabled()) return;
+    s_counters[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+void FrameProfiler::endFrame()
+{
+    const std::int64_t frame_end = ProfileZone::nowNanoseconds();
+    std::vector<ProfileZone::Record> zones;
+    std::unordered_map<std::uint32_t, std::string> thread_names;
+    ProfileZone::collect(zones, thread_names);
+
+    FrameStatistics frame;
+    for (size_t i = 0; i < frame.m_counters.size(); i++)
+    {
+        frame.m_counters[i] = s_counters[i].exchange(0, std::memory_order_relaxed);
+    }
+    std::unordered_map<std::string_view, ZoneStatistics> zone_statistics;
+    for (auto& zone : zones)
+    {
+        auto& statistics = zone_statistics[zone.m_name];
+        const double milliseconds = static_cast<double>(zone.m_endNanoseconds - zone.m_beginNanoseconds) / 1000000.0;
+        statistics.m_callCount++;
+        statistics.m_totalMilliseconds += milliseconds;
+        statistics.m_maxMilliseconds = std::max(statistics.m_maxMilliseconds, milliseconds);
+    }
+    frame.m_zones.reserve(zone_statistics.size());
+    for (auto& [name, statistics] : zone_statistics)
+    {
+        statistics.m_name = name;
+        frame.m_zones.emplace_back(std::move(statistics));
+    }
+    std::sort(frame.m_zones.begin(), frame.m_zones.end(),
+        [](const ZoneStatistics& a, const ZoneStatistics& b) { return a.m_totalMilliseconds > b.m_totalMilliseconds; });
+
+    std::lock_guard locker{ s_frameLock };
+    frame.m_frameIndex = s_frameIndex++;
+    frame.m_frameMilliseconds = s_lastFrameEndNanoseconds > 0 ? static_cast<double>(frame_end - s_lastFrameEndNanoseconds) / 1000000.0 : 0.0;
+    s_lastFrameEndNanoseconds = frame_end;
+    if (s_captureRemainingFrames > 0)
+    {
+        s_captureRemainingFrames--;
+        const size_t room = MAX_CAPTURED_ZONES - std::min(MAX_CAPTURED_ZONES, s_capturedZones.size());
+        s_capturedZones.insert(s_capturedZones.end(), zones.begin(), zones.begin() + static_cast<std::ptrdiff_t>(std::min(room, zones.size())));
+        s_capturedFrames.push_back(CapturedFrame{ frame_end, frame.m_counters });
+        for (auto& [index, name] : thread_names)
+        {
+            s_capturedThreadNames.insert_or_assign(index, name);
+        }
+    }
+    s_lastFrame = std::move(frame);
+}
+
+FrameProfiler::FrameStatistics FrameProfiler::lastFrameStatistics()
+{
+    std::lock_guard locker{ s_frameLock };
+    return s_lastFrame;
+}
+
+void FrameProfiler::beginCapture(unsigned frame_count)
+{
+    std::lock_guard locker{ s_frameLock };
+    s_capturedZones.clear();
+    s_capturedFrames.clear();
+    s_capturedThreadNames.clear();
+    s_captureRemainingFrames = frame_count;
+}
+
+bool FrameProfiler::isCapturing()
+{
+    std::lock_guard locker{ s_frameLock };
+    return s_captureRemainingFrames > 0;
+}
+
+std::string FrameProfiler::exportChromeTrace()
+{
+    std::lock_guard locker{ s_frameLock };
+    std::string json;
+    json.reserve(s_capturedZones.size() * 96 + s_capturedFrames.size() * 256 + 256);
+    json += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char text[256];
+    bool is_first = true;
+    auto begin_event = [&json, &is_first]()
+    {
+        if (!is_first) json.push_back(',');
+        json += "\n{";
+        is_first = false;
+    };
+    for (auto& [index, name] : s_capturedThreadNames)
+    {
+        begin_event();
+        snprintf(text, sizeof(text), "\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", index);
+        json += text;
+        appendJsonString(json, name.c_str());
+        json += "}}";
+    }
+    // chrome trace 的時間單位是 microsecond
+    for (auto& captured : s_capturedZones)
+    {
+        begin_event();
+        json += "\"ph\":\"X\",\"pid\":0,\"name\":";
+        appendJsonString(json, captured.m_name);
+        snprintf(text, sizeof(text), ",\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", captured.m_threadIndex,
+            static_cast<double>(captured.m_beginNanoseconds) / 1000.0,
+            static_cast<double>(captured.m_endNanoseconds - captured.m_beginNanoseconds) / 1000.0);
+        json += text;
+    }
+    for (auto& frame : s_capturedFrames)
+    {
+        const double ts = static_cast<double>(frame.m_endNanoseconds) / 1000.0;
+        begin_event();
+        snprintf(text, sizeof(text), "\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"name\":\"Frame\",\"ts\":%.3f}", ts);
+        json += text;
+        for (size_t i = 0; i < frame.m_counters.size(); i++)
+        {
+            begin_event();
+            snprintf(text, sizeof(text), "\"ph\":\"C\",\"pid\":0,\"name\":\"%s\",\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+                counterNames[i], ts, static_cast<long long>(frame.m_counters[i]));
+            json += text;
+        }
+    }
+    json += "\n]}\n";
+    return json;
+}
+
+bool FrameProfiler::writeChromeTrace(const std::string& filepath)
+{
+    std::ofstream file(filepath, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file) return false;
+    const std::string json = exportChromeTrace();
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,78 @@
+﻿/*********************************************************************
+ * \file   FrameProfiler.h
+ * \brief  frame profiler, scoped zones & counters, per-frame statistics,
+ *          capture to chrome trace (chrome://tracing, perfetto) json
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _FRAME_PROFILER_H
+#define _FRAME_PROFILER_H
+
+#include "Platforms/ProfileZone.h"
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+namespace Enigma::Frameworks
+{
+    /** zone 由 Platforms::ProfileZone 記錄在各 thread 自己的 buffer, endFrame 時收集成這個 frame 的統計;
+     capture 中的 frame 會保留每個 zone 與 counter, 可以匯出成 chrome trace */
+    class FrameProfiler
+    {
+    public:
+        enum class Counter
+        {
+            DrawCall,
+            Bind,
+            Event,
+            Command,
+            Count
+        };
+        using CounterValues = std::array<std::int64_t, static_cast<size_t>(Counter::Count)>;
+
+        struct ZoneStatistics
+        {
+            std::string m_name;
+            unsigned m_callCount = 0;
+            double m_totalMilliseconds = 0.0;
+            double m_maxMilliseconds = 0.0;
+        };
+        struct FrameStatistics
+        {
+            std::uint64_t m_frameIndex = 0;
+            double m_frameMilliseconds = 0.0;
+            std::vector<ZoneStatistics> m_zones;  ///< sorted by total time, descending
+            CounterValues m_counters{};
+        };
+
+    public:
+        /** zone 與 counter 一起開關 */
+        static void setEnabled(bool is_enabled);
+        static bool isEnabled();
+
+        static void addCounter(Counter counter, std::int64_t value);
+
+        /** 主迴圈每個 frame 結束時呼叫 */
+        static void endFrame();
+        static FrameStatistics lastFrameStatistics();
+
+        /** 錄接下來的 frame_count 個 frame */
+        static void beginCapture(unsigned frame_count);
+        static bool isCapturing();
+        static std::string exportChromeTrace();
+        static bool writeChromeTrace(const std::string& filepath);
+    };
+}
+
+/// PROFILE_ZONE, PROFILE_THREAD_NAME 在 Platforms/ProfileZone.h
+#if defined(ENABLE_FRAME_PROFILER)
+#define PROFILE_COUNTER(counter, value) Enigma::Frameworks::FrameProfiler::addCounter(Enigma::Frameworks::FrameProfiler::Counter::counter, (value))
+#define PROFILE_FRAME_END() Enigma::Frameworks::FrameProfiler::endFrame()
+#else
+#define PROFILE_COUNTER(counter, value) ((void)0)
+#define PROFILE_FRAME_END() ((void)0)
+#endif
+
+#endif // _FRAME_PROFILER_H
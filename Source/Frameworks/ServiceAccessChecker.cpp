@@ -0,0 +1,106 @@
+﻿#include "ServiceAccessChecker.h"
+#include "SystemService.h"
+#include <mutex>
+#include <algorithm>
+
+using namespace Enigma::Frameworks;
+
+namespace
+{
+    struct AccessRecord
+    {
+        std::string m_resource;
+        const ISystemService* m_service;
+        ServiceAccessChecker::Access m_access;
+    };
+
+    thread_local const ISystemService* s_tickingService = nullptr;
+
+    std::mutex s_checkerLock;
+    bool s_isInWave = false;
+    std::vector<AccessRecord> s_waveAccesses;
+    std::vector<ServiceAccessChecker::Violation> s_violations;
+
+    /// 同樣的違規只記一次, 每個 frame 都會重複發生
+    void addViolation(ServiceAccessChecker::Violation::Kind kind, const std::string& resource, const std::string& service, const std::string& other_service)
+    {
+        const bool is_recorded = std::any_of(s_violations.begin(), s_violations.end(), [&](const ServiceAccessChecker::Violation& v)
+            { return (v.m_kind == kind) && (v.m_resource == resource) && (v.m_service == service) && (v.m_otherService == other_service); });
+        if (is_recorded) return;
+        s_violations.push_back({ kind, resource, service, other_service });
+    }
+}
+
+ServiceAccessChecker::TickScope::TickScope(const ISystemService* service) : m_previousService(s_tickingService)
+{
+    s_tickingService = service;
+}
+
+ServiceAccessChecker::TickScope::~TickScope()
+{
+    s_tickingService = m_previousService;
+}
+
+void ServiceAccessChecker::recordAccess(const char* resource, Access access)
+{
+    const ISystemService* service = s_tickingService;
+    if ((!service) || (!resource)) return;
+    const bool is_declared = access == Access::Write ? service->isWriteDeclared(resource) : service->isReadDeclared(resource);
+
+    std::lock_guard locker{ s_checkerLock };
+    if (!is_declared)
+    {
+        addViolation(Violation::Kind::Undeclared, resource, service->typeInfo().getName(), std::string());
+    }
+    if (!s_isInWave) return;
+    const bool is_duplicated = std::any_of(s_waveAccesses.begin(), s_waveAccesses.end(), [&](const AccessRecord& rec)
+        { return (rec.m_service == service) && (rec.m_access == access) && (rec.m_resource == resource); });
+    if (!is_duplicated) s_waveAccesses.push_back({ resource, service, access });
+}
+
+void ServiceAccessChecker::beginWave()
+{
+    std::lock_guard locker{ s_checkerLock };
+    s_isInWave = true;
+    s_waveAccesses.clear();
+}
+
+void ServiceAccessChecker::endWave()
+{
+    std::lock_guard locker{ s_checkerLock };
+    s_isInWave = false;
+    for (size_t i = 0; i < s_waveAccesses.size(); i++)
+    {
+        for (size_t j = i + 1; j < s_waveAccesses.size(); j++)
+        {
+            const AccessRecord& a = s_waveAccesses[i];
+            const AccessRecord& b = s_waveAccesses[j];
+            if ((a.m_service == b.m_service) || (a.m_resource != b.m_resource)) continue;
+            if ((a.m_access == Access::Read) && (b.m_access == Access::Read)) continue;
+            // 名稱排序, 兩個 service 的先後不同也只記一次
+            std::string first = a.m_service->typeInfo().getName();
+            std::string second = b.m_service->typeInfo().getName();
+            if (second < first) std::swap(first, second);
+            addViolation(Violation::Kind::Race, a.m_resource, first, second);
+        }
+    }
+    s_waveAccesses.clear();
+}
+
+std::vector<ServiceAccessChecker::Violation> ServiceAccessChecker::violations()
+{
+    std::lock_guard locker{ s_checkerLock };
+    return s_violations;
+}
+
+size_t ServiceAccessChecker::violationCount()
+{
+    std::lock_guard locker{ s_checkerLock };
+    return s_violations.size();
+}
+
+void ServiceAccessChecker::clearViolations()
+{
+    std::lock_guard locker{ s_checkerLock };
+    s_violations.clear();
+}
@@ -0,0 +1,84 @@
+﻿/*********************************************************************
+ * \file   ServiceAccessChecker.h
+ * \brief  race checker of services ticking concurrently, compare recorded
+ *          resource accesses with declared accesses
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _SERVICE_ACCESS_CHECKER_H
+#define _SERVICE_ACCESS_CHECKER_H
+
+#include <string>
+#include <vector>
+
+/// debug build 預設開啟; 沒有定義 ENABLE_SERVICE_ACCESS_CHECK 時, SERVICE_ 存取巨集都不產生程式碼
+#if defined(_DEBUG) && !defined(DISABLE_SERVICE_ACCESS_CHECK) && !defined(ENABLE_SERVICE_ACCESS_CHECK)
+#define ENABLE_SERVICE_ACCESS_CHECK
+#endif
+
+namespace Enigma::Frameworks
+{
+    class ISystemService;
+
+    /** service manager 同時 tick 的 service 分成幾個 wave, 同一個 wave 裡的 service 彼此沒有先後順序;
+     共用資源的存取點用 SERVICE_READ_ACCESS / SERVICE_WRITE_ACCESS 記錄, 檢查出
+     (1) tick 中存取了沒有宣告的資源, (2) 同一個 wave 裡不同 service 對同一個資源有寫入 */
+    class ServiceAccessChecker
+    {
+    public:
+        enum class Access
+        {
+            Read,
+            Write,
+        };
+        struct Violation
+        {
+            enum class Kind
+            {
+                Undeclared,
+                Race,
+            };
+            Kind m_kind;
+            std::string m_resource;
+            std::string m_service;
+            std::string m_otherService;  ///< race 的另一個 service
+        };
+
+        /** service manager 在 worker thread 上 tick 一個 service 期間設定 */
+        class TickScope
+        {
+        public:
+            explicit TickScope(const ISystemService* service);
+            TickScope(const TickScope&) = delete;
+            TickScope(TickScope&&) = delete;
+            ~TickScope();
+            TickScope& operator=(const TickScope&) = delete;
+            TickScope& operator=(TickScope&&) = delete;
+
+        private:
+            const ISystemService* m_previousService;
+        };
+
+    public:
+        /** 不在 tick scope 裡的存取 (main thread 依序執行的程式) 不記錄 */
+        static void recordAccess(const char* resource, Access access);
+
+        static void beginWave();
+        static void endWave();
+
+        static std::vector<Violation> violations();
+        static size_t violationCount();
+        static void clearViolations();
+    };
+}
+
+#if defined(ENABLE_SERVICE_ACCESS_CHECK)
+#define SERVICE_READ_ACCESS(resource) Enigma::Frameworks::ServiceAccessChecker::recordAccess((resource), Enigma::Frameworks::ServiceAccessChecker::Access::Read)
+#define SERVICE_WRITE_ACCESS(resource) Enigma::Frameworks::ServiceAccessChecker::recordAccess((resource), Enigma::Frameworks::ServiceAccessChecker::Access::Write)
+#else
+#define SERVICE_READ_ACCESS(resource) ((void)0)
+#define SERVICE_WRITE_ACCESS(resource) ((void)0)
+#endif
+
+#endif // _SERVICE_ACCESS_CHECKER_H
@@ -2,12 +2,22 @@
 #include "SystemService.h"
 #include "SystemServiceEvents.h"
 #include "EventPublisher.h"
+#include "FrameProfiler.h"
+#include "ServiceAccessChecker.h"
+#include "WorkerThreadPool.h"
+#include <algorithm>
 
 using namespace Enigma::Frameworks;
 
+using milliseconds_float = std::chrono::duration<float, std::milli>;
+
+static constexpr float TICK_AVERAGE_WEIGHT = 0.125f;
+static constexpr float FRAME_AVERAGE_WEIGHT = 0.0625f;
+
 ServiceManager::ServiceManager()
 {
     m_minServiceState = ServiceState::Invalid;
+    m_frameBudgetMilliseconds = 0.0f;
 }
 
 ServiceManager::~ServiceManager()
@@ -21,6 +31,7 @@ void ServiceManager::registerSystemService(const std::shared_ptr<ISystemService>
     rec.m_state = ServiceState::PreInit;
     rec.m_service = service;
     rec.m_isRegistered = true;
+    rec.m_tickStatistics.m_name = service->typeInfo().getName();
     m_services.emplace_back(rec);
     m_mapServices[service->typeIndex()] = service;
     m_minServiceState = ServiceState::PreInit;
@@ -78,6 +89,15 @@ void ServiceManager::shutdownSystemService(const Rtti& service_type)
 void ServiceManager::runOnce()
 {
     if (m_services.empty()) return;
+    PROFILE_ZONE("ServiceManager::runOnce");
+
+    const auto frame_begin = clock_type::now();
+    const auto frame_deadline = m_frameBudgetMilliseconds > 0.0f
+        ? frame_begin + std::chrono::duration_cast<clock_type::duration>(milliseconds_float(m_frameBudgetMilliseconds))
+        : clock_type::time_point::max();
+    m_frameTimeStatistics.m_deferredServiceCount = 0;
+    m_backgroundServices.clear();
+    m_concurrentServices.clear();
 
     ServiceState tempMinState = ServiceState::Deleted;
 
@@ -87,6 +107,20 @@ void ServiceManager::runOnce()
         if (!((*iterService).m_service)) continue;
         if (((*iterService).m_service)->isSuspended()) continue;
 
+        if (isConcurrentTick(*iterService))
+        {
+            if (isTickAllowed(*iterService, frame_deadline, clock_type::now()))
+            {
+                m_concurrentServices.push_back(iterService);
+            }
+            else
+            {
+                deferService(*iterService);
+                if (tempMinState > (*iterService).m_state) tempMinState = (*iterService).m_state;
+            }
+            continue;
+        }
+
         ServiceResult result = ServiceResult::Complete;
         switch ((*iterService).m_state)
         {
@@ -94,7 +128,24 @@ void ServiceManager::runOnce()
         {
             if ((*iterService).m_service->isNeedTick())
             {
-                result = (*iterService).m_service->onTick();
+                if ((*iterService).m_service->tickPriority() == ServicePriority::Background)
+                {
+                    // critical, normal 都 tick 完, 再用剩下的 budget
+                    m_backgroundServices.push_back(iterService);
+                    continue;
+                }
+                // 沒有宣告存取的 service 跟所有 service 都衝突, 先把排在它前面的 concurrent service tick 完,
+                // 維持註冊順序
+                if (!m_concurrentServices.empty()) tickConcurrentServices(frame_deadline, tempMinState);
+                if (isTickAllowed(*iterService, frame_deadline, clock_type::now()))
+                {
+                    result = tickService(*iterService, frame_deadline);
+                }
+                else
+                {
+                    deferService(*iterService);
+                    result = ServiceResult::Pendding;
+                }
             }
             else
             {
@@ -136,6 +187,35 @@ void ServiceManager::runOnce()
         if (tempMinState > (*iterService).m_state) tempMinState = (*iterService).m_state;
     }
 
+    // 最後一個沒有宣告存取的 service 之後的 concurrent service
+    if (!m_concurrentServices.empty()) tickConcurrentServices(frame_deadline, tempMinState);
+
+    // 延後最久的 background service 先 tick
+    std::stable_sort(m_backgroundServices.begin(), m_backgroundServices.end(),
+        [](const SystemServiceList::iterator& a, const SystemServiceList::iterator& b)
+        { return a->m_tickStatistics.m_deferredFrames > b->m_tickStatistics.m_deferredFrames; });
+    for (auto& iterService : m_backgroundServices)
+    {
+        ServiceResult result = ServiceResult::Pendding;
+        if (isTickAllowed(*iterService, frame_deadline, clock_type::now()))
+        {
+            result = tickService(*iterService, frame_deadline);
+        }
+        else
+        {
+            deferService(*iterService);
+        }
+        if (result == ServiceResult::Complete)
+        {
+            unsigned int state = static_cast<unsigned int>((*iterService).m_state);
+            state++;
+            (*iterService).m_state = static_cast<ServiceState>(state);
+        }
+        if (tempMinState > (*iterService).m_state) tempMinState = (*iterService).m_state;
+    }
+    m_backgroundServices.clear();
+    updateFrameTime(frame_begin);
+
     if (tempMinState != m_minServiceState)
     {
         if ((m_minServiceState <= ServiceState::Initializing)
@@ -246,6 +326,189 @@ ServiceManager::ServiceState ServiceManager::checkServiceState(const Rtti& servi
     return ServiceState::Invalid;
 }
 
+void ServiceManager::enableConcurrentTicking(const std::shared_ptr<WorkerThreadPool>& workers)
+{
+    m_workers = workers;
+}
+
+void ServiceManager::disableConcurrentTicking()
+{
+    m_workers.reset();
+}
+
+std::vector<ServiceManager::ServiceTickStatistics> ServiceManager::serviceTickStatistics() const
+{
+    std::vector<ServiceTickStatistics> statistics;
+    for (const auto& rec : m_services)
+    {
+        if (!rec.m_service) continue;
+        statistics.emplace_back(rec.m_tickStatistics);
+        statistics.back().m_priority = rec.m_service->tickPriority();
+    }
+    return statistics;
+}
+
+void ServiceManager::resetSchedulingStatistics()
+{
+    for (auto& rec : m_services)
+    {
+        const std::string name = rec.m_tickStatistics.m_name;
+        rec.m_tickStatistics = ServiceTickStatistics{};
+        rec.m_tickStatistics.m_name = name;
+    }
+    m_frameTimeStatistics = FrameTimeStatistics{};
+    m_lastFrameBegin = std::nullopt;
+}
+
+bool ServiceManager::isTickAllowed(const ServiceStateRecord& rec, clock_type::time_point frame_deadline, clock_type::time_point now) const
+{
+    const ServicePriority priority = rec.m_service->tickPriority();
+    if (priority == ServicePriority::Critical) return true;
+    if (frame_deadline == clock_type::time_point::max()) return true;
+    const unsigned max_deferred_frames = priority == ServicePriority::Normal ? MAX_NORMAL_DEFERRED_FRAMES : MAX_BACKGROUND_DEFERRED_FRAMES;
+    if (rec.m_tickStatistics.m_deferredFrames >= max_deferred_frames) return true;
+    const auto min_time_slice = std::chrono::duration_cast<clock_type::duration>(milliseconds_float(MIN_TIME_SLICE_MILLISECONDS));
+    // 會檢查 time slice 的 service, 只要還有一個最小 slice 的 budget 就可以 tick
+    if (rec.m_tickStatistics.m_isTimeSliced) return now + min_time_slice <= frame_deadline;
+    // 用量測的平均 tick 時間估計, 放得進剩下的 budget 才 tick
+    const auto estimated = std::chrono::duration_cast<clock_type::duration>(milliseconds_float(rec.m_tickStatistics.m_averageTickMilliseconds));
+    return now + estimated <= frame_deadline;
+}
+
+ServiceResult ServiceManager::tickService(ServiceStateRecord& rec, clock_type::time_point frame_deadline)
+{
+    const auto tick_begin = clock_type::now();
+    if ((rec.m_service->tickPriority() == ServicePriority::Critical) || (frame_deadline == clock_type::time_point::max()))
+    {
+        rec.m_service->m_timeSliceDeadline = clock_type::time_point::max();
+    }
+    else
+    {
+        // 被強制 tick 的 service 即使 budget 已經用完, 也給最小的 time slice
+        rec.m_service->m_timeSliceDeadline = (std::max)(frame_deadline,
+            tick_begin + std::chrono::duration_cast<clock_type::duration>(milliseconds_float(MIN_TIME_SLICE_MILLISECONDS)));
+    }
+    ServiceResult result;
+    {
+        PROFILE_ZONE(rec.m_service->typeInfo().getName().c_str());
+        result = rec.m_service->onTick();
+    }
+    const auto tick_end = clock_type::now();
+    const float tick_milliseconds = milliseconds_float(tick_end - tick_begin).count();
+
+    ServiceTickStatistics& statistics = rec.m_tickStatistics;
+    const auto deadline = rec.m_service->m_timeSliceDeadline;
+    if ((deadline != clock_type::time_point::max()) && (tick_end >= deadline))
+    {
+        statistics.m_isTimeSliced = milliseconds_float(tick_end - deadline).count() <= MIN_TIME_SLICE_MILLISECONDS;
+    }
+    statistics.m_lastTickMilliseconds = tick_milliseconds;
+    statistics.m_averageTickMilliseconds = statistics.m_tickCount == 0 ? tick_milliseconds
+        : statistics.m_averageTickMilliseconds + (tick_milliseconds - statistics.m_averageTickMilliseconds) * TICK_AVERAGE_WEIGHT;
+    statistics.m_maxTickMilliseconds = (std::max)(statistics.m_maxTickMilliseconds, tick_milliseconds);
+    statistics.m_deferredFrames = 0;
+    statistics.m_tickCount++;
+    return result;
+}
+
+bool ServiceManager::isConcurrentTick(const ServiceStateRecord& rec) const
+{
+    if (m_workers.expired()) return false;
+    if (rec.m_state != ServiceState::Running) return false;
+    if (!rec.m_service->isNeedTick()) return false;
+    if (rec.m_service->tickPriority() == ServicePriority::Background) return false;
+    return rec.m_service->hasDeclaredAccess();
+}
+
+void ServiceManager::tickConcurrentServices(clock_type::time_point frame_deadline, ServiceState& min_state)
+{
+    PROFILE_ZONE("ServiceManager::tickConcurrentServices");
+    const size_t count = m_concurrentServices.size();
+    // 跟前面的 service 衝突就排到它之後的 wave, 同一個 wave 的 service 彼此不衝突
+    m_concurrentWaves.assign(count, 0);
+    unsigned wave_count = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t j = 0; j < i; j++)
+        {
+            if ((m_concurrentWaves[j] >= m_concurrentWaves[i])
+                && (m_concurrentServices[i]->m_service->isAccessConflict(*m_concurrentServices[j]->m_service)))
+            {
+                m_concurrentWaves[i] = m_concurrentWaves[j] + 1;
+            }
+        }
+        wave_count = (std::max)(wave_count, m_concurrentWaves[i] + 1);
+    }
+
+    m_concurrentResults.assign(count, ServiceResult::Pendding);
+    const auto workers = m_workers.lock();
+    auto tick_wave_members = [this, frame_deadline](size_t begin, size_t end)
+    {
+        for (size_t k = begin; k < end; k++)
+        {
+            const size_t index = m_waveMembers[k];
+            ServiceAccessChecker::TickScope scope(m_concurrentServices[index]->m_service.get());
+            m_concurrentResults[index] = tickService(*m_concurrentServices[index], frame_deadline);
+        }
+    };
+    for (unsigned wave = 0; wave < wave_count; wave++)
+    {
+        m_waveMembers.clear();
+        for (size_t i = 0; i < count; i++)
+        {
+            if (m_concurrentWaves[i] == wave) m_waveMembers.push_back(i);
+        }
+        ServiceAccessChecker::beginWave();
+        if ((workers) && (m_waveMembers.size() > 1))
+        {
+            workers->parallelFor(m_waveMembers.size(), tick_wave_members);
+        }
+        else
+        {
+            tick_wave_members(0, m_waveMembers.size());
+        }
+        ServiceAccessChecker::endWave();
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        ServiceStateRecord& rec = *m_concurrentServices[i];
+        if (m_concurrentResults[i] == ServiceResult::Complete)
+        {
+            unsigned int state = static_cast<unsigned int>(rec.m_state);
+            state++;
+            rec.m_state = static_cast<ServiceState>(state);
+        }
+        if (min_state > rec.m_state) min_state = rec.m_state;
+    }
+    m_concurrentServices.clear();
+}
+
+void ServiceManager::deferService(ServiceStateRecord& rec)
+{
+    rec.m_tickStatistics.m_deferredFrames++;
+    rec.m_tickStatistics.m_deferredCount++;
+    m_frameTimeStatistics.m_deferredServiceCount++;
+}
+
+void ServiceManager::updateFrameTime(clock_type::time_point frame_begin)
+{
+    FrameTimeStatistics& statistics = m_frameTimeStatistics;
+    statistics.m_serviceMilliseconds = milliseconds_float(clock_type::now() - frame_begin).count();
+    if (m_lastFrameBegin)
+    {
+        const float frame_milliseconds = milliseconds_float(frame_begin - m_lastFrameBegin.value()).count();
+        statistics.m_isStutter = (statistics.m_frameCount > 0) && (frame_milliseconds > statistics.m_averageFrameMilliseconds * STUTTER_RATIO);
+        if (statistics.m_isStutter) statistics.m_stutterCount++;
+        statistics.m_averageFrameMilliseconds = statistics.m_frameCount == 0 ? frame_milliseconds
+            : statistics.m_averageFrameMilliseconds + (frame_milliseconds - statistics.m_averageFrameMilliseconds) * FRAME_AVERAGE_WEIGHT;
+        statistics.m_maxFrameMilliseconds = (std::max)(statistics.m_maxFrameMilliseconds, frame_milliseconds);
+        statistics.m_frameMilliseconds = frame_milliseconds;
+        statistics.m_frameCount++;
+    }
+    m_lastFrameBegin = frame_begin;
+}
+
 std::shared_ptr<ISystemService> ServiceManager::getSystemService(const Rtti& service_type)
 {
     auto service = tryGetSystemService(service_type);
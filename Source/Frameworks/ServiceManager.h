@@ -14,10 +14,21 @@
 #include <optional>
 #include <unordered_map>
 #include <memory>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
 
 namespace Enigma::Frameworks
 {
-    /** service manager */
+    class WorkerThreadPool;
+    class AssetRetentionCache;
+
+    /** service manager \n
+     running 的 service 依 tick priority 排程: critical 每個 frame 都 tick, normal 在 frame budget 用完時延後,
+     background 用剩下的 budget 輪流 tick (延後最久的先), 延後太多 frame 的 service 一定會 tick 一次 \n
+     enable concurrent ticking 後, 宣告了存取資源的 critical / normal service 在 worker thread 上同時 tick;
+     彼此衝突的依註冊順序分到不同的 wave, 沒有宣告的 service 仍在 main thread 上 tick, 並維持跟前後 service 的註冊順序 */
     class ServiceManager
     {
     public:
@@ -34,6 +45,38 @@ namespace Enigma::Frameworks
             Deleted,
         };
 
+        struct ServiceTickStatistics
+        {
+            std::string m_name;
+            ServicePriority m_priority = ServicePriority::Critical;
+            float m_lastTickMilliseconds = 0.0f;
+            float m_averageTickMilliseconds = 0.0f;
+            float m_maxTickMilliseconds = 0.0f;
+            unsigned m_deferredFrames = 0;  ///< 目前連續延後的 frame 數
+            bool m_isTimeSliced = false;  ///< 上次用完 time slice 時有準時停下來, 量到的 tick 時間只是 slice 長度
+            std::uint64_t m_tickCount = 0;
+            std::uint64_t m_deferredCount = 0;
+        };
+        struct FrameTimeStatistics
+        {
+            std::uint64_t m_frameCount = 0;
+            float m_frameMilliseconds = 0.0f;  ///< 上一次 runOnce 到這一次的間隔
+            float m_averageFrameMilliseconds = 0.0f;
+            float m_maxFrameMilliseconds = 0.0f;
+            float m_serviceMilliseconds = 0.0f;  ///< 這次 runOnce 花的時間
+            unsigned m_deferredServiceCount = 0;  ///< 這個 frame 延後的 service 數
+            bool m_isStutter = false;  ///< frame time 超過平均的 STUTTER_RATIO 倍
+            std::uint64_t m_stutterCount = 0;
+        };
+
+        static constexpr float STUTTER_RATIO = 2.0f;
+        /// normal service 最多延後的 frame 數
+        static constexpr unsigned MAX_NORMAL_DEFERRED_FRAMES = 2;
+        /// background service 最多延後的 frame 數
+        static constexpr unsigned MAX_BACKGROUND_DEFERRED_FRAMES = 8;
+        /// 延後太久被強制 tick 的 service 至少有這麼長的 time slice
+        static constexpr float MIN_TIME_SLICE_MILLISECONDS = 0.5f;
+
     public:
         ServiceManager();
         ServiceManager(const ServiceManager&) = delete;
@@ -57,6 +100,24 @@ namespace Enigma::Frameworks
 
         ServiceState checkServiceState(const Rtti& service_type);
 
+        /// 有宣告存取資源的 service 在 workers 上同時 tick
+        void enableConcurrentTicking(const std::shared_ptr<WorkerThreadPool>& workers);
+        void disableConcurrentTicking();
+        /// concurrent tick 的 workers, service 內的平行工作也用這個 pool; 沒有啟用時是 nullptr
+        std::shared_ptr<WorkerThreadPool> workerThreadPool() const { return m_workers.lock(); }
+
+        /// 各 repository 共用的 retention cache, 由安裝 engine 的一方持有; 沒有設定時是 nullptr
+        void assetRetentionCache(const std::shared_ptr<AssetRetentionCache>& cache) { m_retentionCache = cache; }
+        std::shared_ptr<AssetRetentionCache> assetRetentionCache() const { return m_retentionCache.lock(); }
+
+        /// runOnce 中 service tick 可用的時間, 0 表示不限制
+        void frameBudget(float milliseconds) { m_frameBudgetMilliseconds = milliseconds; }
+        float frameBudget() const { return m_frameBudgetMilliseconds; }
+
+        const FrameTimeStatistics& frameTimeStatistics() const { return m_frameTimeStatistics; }
+        std::vector<ServiceTickStatistics> serviceTickStatistics() const;
+        void resetSchedulingStatistics();
+
         std::shared_ptr<ISystemService> getSystemService(const Rtti& service_type);
         std::optional<std::shared_ptr<ISystemService>> tryGetSystemService(const Rtti& service_type);
 
@@ -73,10 +134,22 @@ namespace Enigma::Frameworks
             ServiceState m_state;
             std::shared_ptr<ISystemService> m_service;
             bool m_isRegistered;
+            ServiceTickStatistics m_tickStatistics;
         };
 
         typedef std::list<ServiceStateRecord> SystemServiceList;
 
+        using clock_type = std::chrono::steady_clock;
+
+        /// critical 一定 tick, 其他的看剩下的 budget 及已經延後的 frame 數
+        bool isTickAllowed(const ServiceStateRecord& rec, clock_type::time_point frame_deadline, clock_type::time_point now) const;
+        ServiceResult tickService(ServiceStateRecord& rec, clock_type::time_point deadline);
+        void deferService(ServiceStateRecord& rec);
+        void updateFrameTime(clock_type::time_point frame_begin);
+        bool isConcurrentTick(const ServiceStateRecord& rec) const;
+        /// 依 wave tick 收集到的 concurrent service, 更新 state 及 min state
+        void tickConcurrentServices(clock_type::time_point frame_deadline, ServiceState& min_state);
+
     protected:
         typedef std::unordered_map<const Rtti*, std::shared_ptr<ISystemService>> SystemServiceMap;  ///< mapping by rtti type_index
 
@@ -84,6 +157,17 @@ namespace Enigma::Frameworks
         SystemServiceMap m_mapServices;
 
         ServiceState m_minServiceState;  ///< minimun service state
+
+        float m_frameBudgetMilliseconds;
+        std::vector<SystemServiceList::iterator> m_backgroundServices;  ///< 這個 frame 要排程的 background service
+        std::weak_ptr<WorkerThreadPool> m_workers;
+        std::weak_ptr<AssetRetentionCache> m_retentionCache;
+        std::vector<SystemServiceList::iterator> m_concurrentServices;
+        std::vector<unsigned> m_concurrentWaves;
+        std::vector<ServiceResult> m_concurrentResults;
+        std::vector<size_t> m_waveMembers;
+        std::optional<clock_type::time_point> m_lastFrameBegin;
+        FrameTimeStatistics m_frameTimeStatistics;
     };
 };
 
@@ -1,5 +1,6 @@
 ﻿#include "SystemService.h"
 //#include "ServiceManager.h"
+#include <algorithm>
 
 using namespace Enigma::Frameworks;
 
@@ -10,6 +11,8 @@ ISystemService::ISystemService(ServiceManager* manager)
     m_serviceManager = manager;
     m_needTick = true;
     m_isSuspended = false;
+    m_tickPriority = ServicePriority::Critical;
+    m_timeSliceDeadline = std::chrono::steady_clock::time_point::max();
 }
 
 ISystemService::~ISystemService()
@@ -37,3 +40,39 @@ ServiceResult ISystemService::onTick()
     return ServiceResult::Pendding;
 }
 
+void ISystemService::declareReadAccess(const std::string& resource)
+{
+    if (isReadDeclared(resource)) return;
+    m_readResources.emplace_back(resource);
+}
+
+void ISystemService::declareWriteAccess(const std::string& resource)
+{
+    if (isWriteDeclared(resource)) return;
+    m_writeResources.emplace_back(resource);
+}
+
+bool ISystemService::isReadDeclared(const std::string& resource) const
+{
+    return (std::find(m_readResources.begin(), m_readResources.end(), resource) != m_readResources.end())
+        || (isWriteDeclared(resource));
+}
+
+bool ISystemService::isWriteDeclared(const std::string& resource) const
+{
+    return std::find(m_writeResources.begin(), m_writeResources.end(), resource) != m_writeResources.end();
+}
+
+bool ISystemService::isAccessConflict(const ISystemService& other) const
+{
+    for (const auto& resource : m_writeResources)
+    {
+        if (other.isReadDeclared(resource)) return true;
+    }
+    for (const auto& resource : other.m_writeResources)
+    {
+        if (isReadDeclared(resource)) return true;
+    }
+    return false;
+}
+
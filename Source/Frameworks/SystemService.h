@@ -9,6 +9,9 @@
 #define _SYSTEM_SERVICE_H
 
 #include "Rtti.h"
+#include <chrono>
+#include <string>
+#include <vector>
 
 namespace Enigma::Frameworks
 {
@@ -21,6 +24,14 @@ namespace Enigma::Frameworks
         Complete,
     };
 
+    /** tick 排程的優先權, 由 ServiceManager 依 frame budget 排程 */
+    enum class ServicePriority
+    {
+        Critical,  ///< 每個 frame 都 tick, 不受 budget 限制
+        Normal,  ///< budget 用完時延後, 最多延後幾個 frame
+        Background,  ///< 用剩下的 budget 輪流 tick, 工作量大的要自己檢查 time slice, 做不完留到下個 frame
+    };
+
     /** system service interface */
     class ISystemService
     {
@@ -48,6 +59,23 @@ namespace Enigma::Frameworks
         virtual ServiceResult onTick();
         inline bool isNeedTick() const { return m_needTick; };
 
+        /// tick priority
+        inline ServicePriority tickPriority() const { return m_tickPriority; };
+        inline void tickPriority(ServicePriority priority) { m_tickPriority = priority; };
+        /// time slice of current tick, set by service manager before onTick
+        inline const std::chrono::steady_clock::time_point& timeSliceDeadline() const { return m_timeSliceDeadline; };
+        inline bool isTimeSliceExpired() const { return std::chrono::steady_clock::now() >= m_timeSliceDeadline; };
+
+        /** 宣告 tick 時會讀寫的共用資源 (或群組名稱); 有宣告的 service 由 service manager 跟沒有衝突的 service
+         同時在 worker thread 上 tick, 沒有宣告的 service 視為跟所有 service 衝突, 在 main thread 上依序 tick */
+        void declareReadAccess(const std::string& resource);
+        void declareWriteAccess(const std::string& resource);
+        inline bool hasDeclaredAccess() const { return !m_readResources.empty() || !m_writeResources.empty(); };
+        bool isReadDeclared(const std::string& resource) const;
+        bool isWriteDeclared(const std::string& resource) const;
+        /// 有一方寫入對方讀寫的資源
+        bool isAccessConflict(const ISystemService& other) const;
+
         /// suspend
         inline void suspend() { m_isSuspended = true; };
         /// resume
@@ -57,9 +85,14 @@ namespace Enigma::Frameworks
 
 
     protected:
+        friend class ServiceManager;
         ServiceManager* m_serviceManager;
         bool m_needTick;
         bool m_isSuspended;
+        ServicePriority m_tickPriority;
+        std::chrono::steady_clock::time_point m_timeSliceDeadline;
+        std::vector<std::string> m_readResources;
+        std::vector<std::string> m_writeResources;
     };
 };
 
@@ -0,0 +1,114 @@
+﻿#include "WorkerThreadPool.h"
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::Frameworks;
+
+WorkerThreadPool::WorkerThreadPool(unsigned thread_count) : m_isExiting(false)
+{
+    if (thread_count == 0)
+    {
+        const unsigned hardware_count = std::thread::hardware_concurrency();
+        thread_count = hardware_count > 1 ? hardware_count - 1 : 1;
+    }
+    m_threads.reserve(thread_count);
+    for (unsigned i = 0; i < thread_count; i++)
+    {
+        m_threads.emplace_back([this]() { threadProcedure(); });
+    }
+}
+
+WorkerThreadPool::~WorkerThreadPool()
+{
+    {
+        std::lock_guard locker{ m_taskLock };
+        m_isExiting = true;
+    }
+    m_taskCondition.notify_all();
+    for (auto& t : m_threads)
+    {
+        if (t.joinable()) t.join();
+    }
+    m_threads.clear();
+    m_tasks.clear();
+}
+
+std::future<void> WorkerThreadPool::pushTask(const std::function<void()>& task)
+{
+    std::packaged_task<void()> tp{ task };
+    std::future<void> f = tp.get_future();
+    {
+        std::lock_guard locker{ m_taskLock };
+        m_tasks.emplace_back(std::move(tp));
+    }
+    m_taskCondition.notify_one();
+    return f;
+}
+
+void WorkerThreadPool::parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& task, size_t min_range)
+{
+    if (count == 0) return;
+    if (min_range == 0) min_range = 1;
+    const size_t max_ranges = static_cast<size_t>(threadCount()) + 1;  // workers + calling thread
+    const size_t range_count = std::max<size_t>(1, std::min(max_ranges, count / min_range));
+    const size_t range_size = (count + range_count - 1) / range_count;
+    if (range_count == 1)
+    {
+        task(0, count);
+        return;
+    }
+    std::vector<std::future<void>> futures;
+    futures.reserve(range_count - 1);
+    for (size_t begin = range_size; begin < count; begin += range_size)
+    {
+        const size_t end = std::min(count, begin + range_size);
+        futures.emplace_back(pushTask([&task, begin, end]() { task(begin, end); }));
+    }
+    task(0, std::min(count, range_size));
+    for (auto& f : futures)
+    {
+        waitFor(f);
+    }
+}
+
+void WorkerThreadPool::waitFor(std::future<void>& f)
+{
+    assert(f.valid());
+    while (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        if (!tryRunPendingTask()) std::this_thread::yield();
+    }
+    f.get();
+}
+
+void WorkerThreadPool::threadProcedure()
+{
+    PROFILE_THREAD_NAME("WorkerThread");
+    while (true)
+    {
+        std::packaged_task<void()> t;
+        {
+            std::unique_lock locker{ m_taskLock };
+            m_taskCondition.wait(locker, [this]() { return m_isExiting || !m_tasks.empty(); });
+            if (m_isExiting) return;
+            t = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        PROFILE_ZONE("WorkerThreadPool::task");
+        t();
+    }
+}
+
+bool WorkerThreadPool::tryRunPendingTask()
+{
+    std::packaged_task<void()> t;
+    {
+        std::lock_guard locker{ m_taskLock };
+        if (m_tasks.empty()) return false;
+        t = std::move(m_tasks.front());
+        m_tasks.pop_front();
+    }
+    t();
+    return true;
+}
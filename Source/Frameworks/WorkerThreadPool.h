@@ -0,0 +1,56 @@
+﻿/*********************************************************************
+ * \file   WorkerThreadPool.h
+ * \brief  fixed size worker thread pool, for cpu bound jobs (culling, rasterizing, ...)
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _WORKER_THREAD_POOL_H
+#define _WORKER_THREAD_POOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <future>
+#include <functional>
+#include <atomic>
+
+namespace Enigma::Frameworks
+{
+    class WorkerThreadPool
+    {
+    public:
+        /** thread_count = 0, use hardware concurrency - 1 (at least 1) */
+        WorkerThreadPool(unsigned thread_count = 0);
+        WorkerThreadPool(const WorkerThreadPool&) = delete;
+        WorkerThreadPool(WorkerThreadPool&&) = delete;
+        ~WorkerThreadPool();
+        WorkerThreadPool& operator=(const WorkerThreadPool&) = delete;
+        WorkerThreadPool& operator=(WorkerThreadPool&&) = delete;
+
+        unsigned threadCount() const { return static_cast<unsigned>(m_threads.size()); }
+
+        std::future<void> pushTask(const std::function<void()>& task);
+        /** split [0, count) into ranges, run on workers and calling thread, return when all done.
+         @remark calling thread helps running pending tasks while waiting, so it's safe to call from a worker */
+        void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& task, size_t min_range = 1);
+
+        /** wait for future, and help running pending tasks meanwhile */
+        void waitFor(std::future<void>& f);
+
+    protected:
+        void threadProcedure();
+        bool tryRunPendingTask();
+
+    protected:
+        std::vector<std::thread> m_threads;
+        std::mutex m_taskLock;
+        std::condition_variable m_taskCondition;
+        std::deque<std::packaged_task<void()>> m_tasks;
+        std::atomic_bool m_isExiting;
+    };
+}
+
+#endif // _WORKER_THREAD_POOL_H
@@ -34,7 +34,7 @@ error GameSceneInstallingPolicy::install(Frameworks::ServiceManager* service_man
     assert(service_manager);
     auto scene_graph_repository = service_manager->getSystemServiceAs<SceneGraph::SceneGraphRepository>();
     auto camera_service = service_manager->getSystemServiceAs<GameCameraService>();
-    auto scene_service = std::make_shared<GameSceneService>(service_manager, scene_graph_repository, camera_service);
+    auto scene_service = std::make_shared<GameSceneService>(service_manager, scene_graph_repository, camera_service, m_cullingConfig);
     service_manager->registerSystemService(scene_service);
     return error();
 }
@@ -11,6 +11,7 @@
 #include "GameEngine/InstallingPolicy.h"
 #include "SceneGraph/SpatialId.h"
 #include "GameEngine/GenericDto.h"
+#include "GameSceneService.h"
 
 namespace Enigma::GameCommon
 {
@@ -31,10 +32,13 @@ namespace Enigma::GameCommon
     class GameSceneInstallingPolicy : public Engine::InstallingPolicy
     {
     public:
-        GameSceneInstallingPolicy() = default;
+        GameSceneInstallingPolicy(const GameSceneCullingConfig& culling_config = GameSceneCullingConfig{}) : m_cullingConfig(culling_config) {}
 
         virtual error install(Frameworks::ServiceManager* service_manager) override;
         virtual error shutdown(Frameworks::ServiceManager* service_manager) override;
+
+    protected:
+        GameSceneCullingConfig m_cullingConfig;
     };
     class AnimatedPawnInstallingPolicy : public Engine::InstallingPolicy
     {
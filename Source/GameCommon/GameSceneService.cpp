@@ -7,6 +7,7 @@
 #include "Platforms/MemoryMacro.h"
 #include "Frameworks/EventPublisher.h"
 #include "Frameworks/CommandBus.h"
+#include "Frameworks/ServiceManager.h"
 #include "GameCameraEvents.h"
 #include "GameSceneEvents.h"
 #include "GameSceneCommands.h"
@@ -14,20 +15,25 @@
 #include "SceneGraph/NodalSceneGraph.h"
 #include "SceneGraph/PortalSceneGraph.h"
 #include "SceneGraph/SceneGraphQueries.h"
+#include "SceneGraph/OcclusionCuller.h"
 
 using namespace Enigma::GameCommon;
 using namespace Enigma::Frameworks;
 using namespace Enigma::SceneGraph;
 using namespace Enigma::MathLib;
 
+static constexpr float BROADPHASE_FAT_MARGIN = 0.1f;
+
 DEFINE_RTTI(GameCommon, GameSceneService, ISystemService);
 
 GameSceneService::GameSceneService(ServiceManager* mngr, const std::shared_ptr<SceneGraphRepository>& scene_graph_repository,
-    const std::shared_ptr<GameCameraService>& camera_service) : ISystemService(mngr)
+    const std::shared_ptr<GameCameraService>& camera_service, const GameSceneCullingConfig& culling_config) : ISystemService(mngr)
 {
     m_sceneGraphRepository = scene_graph_repository;
     m_cameraService = camera_service;
+    m_cullingConfig = culling_config;
     m_needTick = true;
+    declareWriteAccess(SCENE_CULLER_RESOURCE);
     m_culler = nullptr;
 }
 
@@ -55,6 +61,7 @@ ServiceResult GameSceneService::onInit()
 
 ServiceResult GameSceneService::onTick()
 {
+    SERVICE_WRITE_ACCESS(SCENE_CULLER_RESOURCE);
     if (m_culler)
     {
         m_culler->ComputeVisibleSet(m_sceneGraph->root());
@@ -104,6 +111,7 @@ void GameSceneService::createNodalSceneRoot(const SceneGraph::SpatialId& scene_r
         EventPublisher::enqueue(std::make_shared<CreateNodalSceneRootFailed>(scene_root_id, er));
         return;
     }
+    createSceneBroadphase();
     if ((!m_cameraService.expired()) && m_cameraService.lock()->primaryCamera())
     {
         createSceneCuller(m_cameraService.lock()->primaryCamera());
@@ -131,6 +139,7 @@ void GameSceneService::createPortalSceneRoot(const SceneGraph::SpatialId& scene_
         EventPublisher::enqueue(std::make_shared<CreatePortalSceneRootFailed>(scene_root_id, er));
         return;
     }
+    createSceneBroadphase();
     if ((!m_cameraService.expired()) && m_cameraService.lock()->primaryCamera())
     {
         createSceneCuller(m_cameraService.lock()->primaryCamera());
@@ -140,14 +149,29 @@ void GameSceneService::createPortalSceneRoot(const SceneGraph::SpatialId& scene_
 
 void GameSceneService::destroyRootScene()
 {
+    m_broadphase = nullptr;
     if (m_sceneGraph) m_sceneGraph->destroyRoot();
 }
 
+void GameSceneService::createSceneBroadphase()
+{
+    assert(m_sceneGraph);
+    // 之後 attach 到 root 的 pawn 由 broadphase 自己的 event handler 加入
+    m_broadphase = std::make_unique<SceneBroadphase>(BROADPHASE_FAT_MARGIN, getServiceManager()->workerThreadPool());
+    m_broadphase->bindSceneRoot(m_sceneGraph->root());
+}
+
 void GameSceneService::createSceneCuller(const std::shared_ptr<Camera>& camera)
 {
     SAFE_DELETE(m_culler);
     m_culler = menew Culler(camera);
     m_culler->EnableOuterClipping(true);
+    m_culler->enableParallelCulling(getServiceManager()->workerThreadPool());
+    if (m_cullingConfig.m_enableOcclusionCulling)
+    {
+        m_culler->occlusionCuller(std::make_shared<OcclusionCuller>(m_cullingConfig.m_occlusionBufferWidth,
+            m_cullingConfig.m_occlusionBufferHeight, getServiceManager()->workerThreadPool()));
+    }
 }
 
 void GameSceneService::destroySceneCuller()
@@ -16,7 +16,9 @@
 #include "SceneGraph/Culler.h"
 #include "Frameworks/EventSubscriber.h"
 #include "Frameworks/CommandSubscriber.h"
+#include "Frameworks/ServiceAccessChecker.h"
 #include "SceneGraph/SceneGraph.h"
+#include "SceneGraph/SceneBroadphase.h"
 
 namespace Enigma::GameCommon
 {
@@ -24,12 +26,23 @@ namespace Enigma::GameCommon
 
     class GameCameraService;
 
+    struct GameSceneCullingConfig
+    {
+        bool m_enableOcclusionCulling = true;  ///< frustum culling 後再用標記為 occluder 的物件做 occlusion culling
+        unsigned m_occlusionBufferWidth = 256;
+        unsigned m_occlusionBufferHeight = 128;
+    };
+
     class GameSceneService : public Frameworks::ISystemService
     {
         DECLARE_EN_RTTI;
+    public:
+        /// concurrent tick 時宣告的資源名稱, scene culler 及其 visible set
+        static constexpr const char* SCENE_CULLER_RESOURCE = "SceneCuller";
+
     public:
         GameSceneService(Frameworks::ServiceManager* mngr, const std::shared_ptr<SceneGraph::SceneGraphRepository>& scene_graph_repository,
-            const std::shared_ptr<GameCameraService>& camera_service);
+            const std::shared_ptr<GameCameraService>& camera_service, const GameSceneCullingConfig& culling_config = GameSceneCullingConfig{});
         GameSceneService(const GameSceneService&) = delete;
         GameSceneService(GameSceneService&&) = delete;
         virtual ~GameSceneService() override;
@@ -52,19 +65,25 @@ namespace Enigma::GameCommon
         /** destroy culler */
         void destroySceneCuller();
         /** get scene culler */
-        SceneGraph::Culler* getSceneCuller() { return m_culler; };
+        SceneGraph::Culler* getSceneCuller() { SERVICE_READ_ACCESS(SCENE_CULLER_RESOURCE); return m_culler; };
+
+        /** picking, line-of-sight & proximity queries over scene pawns, scene root 建立後才有 */
+        SceneGraph::SceneBroadphase* getSceneBroadphase() { return m_broadphase.get(); }
 
     protected:
         void onGameCameraCreated(const Frameworks::IEventPtr& e);
         void onGameCameraUpdated(const Frameworks::IEventPtr& e);
         void createSceneRoot(const Frameworks::ICommandPtr& c);
         void attachSceneRootChild(const Frameworks::ICommandPtr& c);
+        void createSceneBroadphase();
 
     protected:
         std::weak_ptr<SceneGraph::SceneGraphRepository> m_sceneGraphRepository;
         std::weak_ptr<GameCameraService> m_cameraService;
+        GameSceneCullingConfig m_cullingConfig;
         std::unique_ptr<SceneGraph::SceneGraph> m_sceneGraph;
         SceneGraph::Culler* m_culler;
+        std::unique_ptr<SceneGraph::SceneBroadphase> m_broadphase;
 
         Frameworks::EventSubscriberPtr m_onCameraCreated;
         Frameworks::EventSubscriberPtr m_onCameraUpdated;
@@ -56,9 +56,11 @@ void EffectCompiler::compileEffect(const std::shared_ptr<EffectMaterial>& effect
     m_builtPrograms.clear();
     m_builtPassStates.clear();
     m_builtEffectTechniques.clear();
+    m_hasMaterialProduced = false;
 
     if (m_profile.m_techniques.empty())
     {
+        m_hasMaterialProduced = true;
         EventPublisher::enqueue(std::make_shared<CompileEffectMaterialFailed>(m_profile.m_name, ErrorCode::compilingEmptyEffectTech));
         return;
     }
@@ -95,7 +97,6 @@ void EffectCompiler::compileEffect(const std::shared_ptr<EffectMaterial>& effect
         }
         m_builtEffectTechniques.emplace_back(built_effect_technique);
     }
-    m_hasMaterialProduced = false;
 }
 
 void EffectCompiler::onShaderProgramBuilt(const Frameworks::IEventPtr& e)
@@ -103,6 +104,7 @@ void EffectCompiler::onShaderProgramBuilt(const Frameworks::IEventPtr& e)
     if (!e) return;
     auto ev_built = std::dynamic_pointer_cast<ShaderProgramBuilt, IEvent>(e);
     if (!ev_built) return;
+    if ((!m_compilingEffect) || (m_hasMaterialProduced)) return;
     if (m_builtPrograms.find(ev_built->GetShaderName()) == m_builtPrograms.end()) return;
     m_builtPrograms[ev_built->GetShaderName()] = ev_built->GetProgram();
     tryBuildEffectPass(ev_built->GetShaderName());
@@ -113,6 +115,10 @@ void EffectCompiler::onBuildProgramFailed(const Frameworks::IEventPtr& e)
     if (!e) return;
     auto ev_fail = std::dynamic_pointer_cast<BuildShaderProgramFailed, IEvent>(e);
     if (!ev_fail) return;
+    // 多個 compiler 同時編譯, 只處理自己的 program
+    if ((!m_compilingEffect) || (m_hasMaterialProduced)) return;
+    if (m_builtPrograms.find(ev_fail->GetShaderName()) == m_builtPrograms.end()) return;
+    m_hasMaterialProduced = true;
     EventPublisher::enqueue(std::make_shared<CompileEffectMaterialFailed>(m_profile.m_name, ev_fail->GetErrorCode()));
 }
 
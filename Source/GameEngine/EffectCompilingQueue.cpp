@@ -14,13 +14,25 @@ using namespace Enigma::Engine;
 
 EffectCompilingQueue::EffectCompilingQueue()
 {
-    m_compiler = menew EffectCompiler();
+    for (unsigned i = 0; i < MAX_CONCURRENT_COMPILERS; i++)
+    {
+        m_idleCompilers.emplace_back(menew EffectCompiler());
+    }
     registerHandlers();
 }
 
 EffectCompilingQueue::~EffectCompilingQueue()
 {
-    SAFE_DELETE(m_compiler);
+    for (auto& compiler : m_idleCompilers)
+    {
+        SAFE_DELETE(compiler);
+    }
+    m_idleCompilers.clear();
+    for (auto& [id, compiling] : m_compilingEffects)
+    {
+        SAFE_DELETE(compiling.m_compiler);
+    }
+    m_compilingEffects.clear();
     unregisterHandlers();
 }
 
@@ -36,22 +48,31 @@ std::error_code EffectCompilingQueue::enqueue(const std::shared_ptr<EffectMateri
 
 std::error_code EffectCompilingQueue::compileNextEffect()
 {
-    if (m_currentCompilingEffect) return ErrorCode::ok;
-    assert(m_compiler);
     std::lock_guard locker{ m_queueLock };
-    if (m_queue.empty())
+    while ((!m_queue.empty()) && (!m_idleCompilers.empty()))
     {
-        m_currentCompilingEffect = nullptr;
-        return ErrorCode::ok;
+        auto [effect, profile] = std::move(m_queue.front());
+        m_queue.pop();
+        EffectCompiler* compiler = m_idleCompilers.back();
+        m_idleCompilers.pop_back();
+        m_compilingEffects.insert_or_assign(effect->id(), CompilingEffect{ compiler, effect });
+        effect->lazyStatus().changeStatus(Frameworks::LazyStatus::Status::Loading);
+        compiler->compileEffect(effect, profile);
     }
-    auto& [effect, profile] = m_queue.front();
-    m_currentCompilingEffect = effect;
-    m_compiler->compileEffect(effect, profile);
-    effect->lazyStatus().changeStatus(Frameworks::LazyStatus::Status::Loading);
-    m_queue.pop();
     return ErrorCode::ok;
 }
 
+std::shared_ptr<EffectMaterial> EffectCompilingQueue::finishCompiling(const EffectMaterialId& id)
+{
+    std::lock_guard locker{ m_queueLock };
+    auto it = m_compilingEffects.find(id);
+    if (it == m_compilingEffects.end()) return nullptr;
+    auto effect = it->second.m_effect;
+    m_idleCompilers.emplace_back(it->second.m_compiler);
+    m_compilingEffects.erase(it);
+    return effect;
+}
+
 void EffectCompilingQueue::registerHandlers()
 {
     m_onCompilerEffectMaterialCompiled = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { onCompilerEffectMaterialCompiled(e); });
@@ -70,31 +91,29 @@ void EffectCompilingQueue::unregisterHandlers()
 
 void EffectCompilingQueue::onCompilerEffectMaterialCompiled(const Frameworks::IEventPtr& e)
 {
-    if (!m_currentCompilingEffect) return;
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<EffectCompiler::EffectMaterialCompiled, Frameworks::IEvent>(e);
     if (!ev) return;
-    if (ev->id() != m_currentCompilingEffect->id()) return;
+    auto effect = finishCompiling(ev->id());
+    if (!effect) return;
 
-    if (m_currentCompilingEffect->getEffectMaterialSource())
+    if (effect->getEffectMaterialSource())
     {
-        m_currentCompilingEffect->getEffectMaterialSource()->hydrateDuplicatedEffects();
+        effect->getEffectMaterialSource()->hydrateDuplicatedEffects();
     }
-    Frameworks::EventPublisher::enqueue(std::make_shared<EffectMaterialSourceCompiled>(m_currentCompilingEffect->id()));
-    m_currentCompilingEffect = nullptr;
+    Frameworks::EventPublisher::enqueue(std::make_shared<EffectMaterialSourceCompiled>(effect->id()));
     auto er = compileNextEffect();
 }
 
 void EffectCompilingQueue::onCompilerCompileEffectMaterialFailed(const Frameworks::IEventPtr& e)
 {
-    if (!m_currentCompilingEffect) return;
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<EffectCompiler::CompileEffectMaterialFailed, Frameworks::IEvent>(e);
     if (!ev) return;
-    if (ev->id() != m_currentCompilingEffect->id()) return;
+    auto effect = finishCompiling(ev->id());
+    if (!effect) return;
 
     Platforms::Debug::ErrorPrintf("effect material %s compile failed : %s\n", ev->id().name().c_str(), ev->error().message().c_str());
     Frameworks::EventPublisher::enqueue(std::make_shared<CompileEffectMaterialSourceFailed>(ev->id(), ev->error()));
-    m_currentCompilingEffect = nullptr;
     auto er = compileNextEffect();
 }
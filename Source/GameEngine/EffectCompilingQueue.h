@@ -9,18 +9,26 @@
 #define EFFECT_COMPILING_QUEUE_H
 
 #include "EffectCompilingProfile.h"
+#include "EffectMaterialId.h"
 #include "Frameworks/EventSubscriber.h"
 #include <system_error>
 #include <queue>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
 
 namespace Enigma::Engine
 {
     class EffectMaterial;
     class EffectCompiler;
 
+    //! ADR : 多個 compiler 同時編譯不同的 effect, 各自的 shader program / device state 命令交錯送出,
+    //!  完成事件用 effect id 對應回 compiler
     class EffectCompilingQueue
     {
     public:
+        static constexpr unsigned MAX_CONCURRENT_COMPILERS = 4;
+
         EffectCompilingQueue();
         ~EffectCompilingQueue();
 
@@ -31,14 +39,22 @@ namespace Enigma::Engine
         void registerHandlers();
         void unregisterHandlers();
 
+        /** 從編譯中的清單移除, compiler 放回 idle, 回傳編譯中的 effect */
+        std::shared_ptr<EffectMaterial> finishCompiling(const EffectMaterialId& id);
+
         void onCompilerEffectMaterialCompiled(const Frameworks::IEventPtr& e);
         void onCompilerCompileEffectMaterialFailed(const Frameworks::IEventPtr& e);
 
     protected:
-        EffectCompiler* m_compiler;
+        struct CompilingEffect
+        {
+            EffectCompiler* m_compiler;
+            std::shared_ptr<EffectMaterial> m_effect;
+        };
+        std::vector<EffectCompiler*> m_idleCompilers;
+        std::unordered_map<EffectMaterialId, CompilingEffect, EffectMaterialId::hash> m_compilingEffects;
         std::queue<std::pair<std::shared_ptr<EffectMaterial>, EffectCompilingProfile>> m_queue;
         std::recursive_mutex m_queueLock;
-        std::shared_ptr<EffectMaterial> m_currentCompilingEffect;
 
         Frameworks::EventSubscriberPtr m_onCompilerEffectMaterialCompiled;
         Frameworks::EventSubscriberPtr m_onCompilerCompileEffectMaterialFailed;
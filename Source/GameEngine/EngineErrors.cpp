@@ -25,6 +25,7 @@ std::string ErrorCategory::message(int err) const
     case ErrorCode::textureAlreadyExists: return "Texture already exists";
     case ErrorCode::textureAlreadyLoaded: return "Texture already loaded";
     case ErrorCode::textureNotReady: return "Texture not ready";
+    case ErrorCode::arenaRangeTooLarge: return "Arena range too large";
     }
     return "Unknown";
 }
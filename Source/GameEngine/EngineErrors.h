@@ -35,6 +35,8 @@ namespace Enigma::Engine
         textureAlreadyExists,
         textureAlreadyLoaded,
         textureNotReady,
+
+        arenaRangeTooLarge = 401,
     };
     class ErrorCategory : public std::error_category
     {
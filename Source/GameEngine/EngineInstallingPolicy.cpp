@@ -4,6 +4,8 @@
 #include "RenderBufferRepository.h"
 #include "TimerService.h"
 #include "EngineErrors.h"
+#include "Frameworks/AssetRetentionCache.h"
+#include "Frameworks/ServiceManager.h"
 #include <cassert>
 
 using namespace Enigma::Engine;
@@ -11,6 +13,8 @@ using namespace Enigma::Engine;
 error EngineInstallingPolicy::install(Frameworks::ServiceManager* service_manager)
 {
     assert(service_manager);
+    m_retentionCache = std::make_shared<Frameworks::AssetRetentionCache>(m_retentionBudget);
+    service_manager->assetRetentionCache(m_retentionCache);
     service_manager->registerSystemService(std::make_shared<ShaderRepository>(service_manager));
     //service_manager->registerSystemService(std::make_shared<TextureRepository>(service_manager));
     service_manager->registerSystemService(std::make_shared<RenderBufferRepository>(service_manager));
@@ -25,5 +29,7 @@ error EngineInstallingPolicy::shutdown(Frameworks::ServiceManager* service_manag
     service_manager->shutdownSystemService(RenderBufferRepository::TYPE_RTTI);
     //service_manager->shutdownSystemService(TextureRepository::TYPE_RTTI);
     service_manager->shutdownSystemService(ShaderRepository::TYPE_RTTI);
+    service_manager->assetRetentionCache(nullptr);
+    m_retentionCache = nullptr;
     return ErrorCode::ok;
 }
@@ -9,16 +9,32 @@
 #define _ENGINE_INSTALLING_POLICY_H
 
 #include "InstallingPolicy.h"
+#include <memory>
+
+namespace Enigma::Frameworks
+{
+    class AssetRetentionCache;
+}
 
 namespace Enigma::Engine
 {
     class EngineInstallingPolicy : public InstallingPolicy
     {
     public:
-        EngineInstallingPolicy() {};
+        static constexpr size_t DEFAULT_RETENTION_BUDGET = 128 * 1024 * 1024;
+
+    public:
+        /** retention cache 由 engine 持有, 之後安裝的 geometry, primitive, texture, scene graph, animation asset repository 共用 */
+        EngineInstallingPolicy(size_t retention_budget = DEFAULT_RETENTION_BUDGET) : m_retentionBudget(retention_budget) {};
 
         virtual error install(Frameworks::ServiceManager* service_manager) override;
         virtual error shutdown(Frameworks::ServiceManager* service_manager) override;
+
+        const std::shared_ptr<Frameworks::AssetRetentionCache>& retentionCache() const { return m_retentionCache; }
+
+    protected:
+        size_t m_retentionBudget;
+        std::shared_ptr<Frameworks::AssetRetentionCache> m_retentionCache;
     };
 }
 #endif // _ENGINE_INSTALLING_POLICY_H
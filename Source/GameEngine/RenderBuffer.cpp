@@ -18,8 +18,22 @@ RenderBuffer::RenderBuffer(const RenderBufferSignature& signature,
     m_isDataEmpty = true;
 }
 
+RenderBuffer::RenderBuffer(const RenderBufferSignature& signature,
+    const Graphics::IVertexBufferPtr& vertex_buffer, const Graphics::IIndexBufferPtr& index_buffer,
+    const RenderBufferArena::Range& arena_range, const std::weak_ptr<RenderBufferArena>& arena)
+    : RenderBuffer(signature, vertex_buffer, index_buffer)
+{
+    m_arenaRange = arena_range;
+    m_arena = arena;
+    m_isDataEmpty = false;
+}
+
 RenderBuffer::~RenderBuffer()
 {
+    if (m_arenaRange)
+    {
+        if (auto arena = m_arena.lock()) arena->release(m_arenaRange.value());
+    }
     m_vertexBuffer = nullptr;
     m_indexBuffer = nullptr;
 }
@@ -27,6 +41,14 @@ RenderBuffer::~RenderBuffer()
 error RenderBuffer::updateVertex(const byte_buffer& dataBuffer, const uint_buffer& indexBuffer)
 {
     assert(m_vertexBuffer);
+    if (m_arenaRange)
+    {
+        if (dataBuffer.empty()) return ErrorCode::ok;
+        const unsigned vtx_count = static_cast<unsigned>(dataBuffer.size()) / m_vertexBuffer->sizeofVertex();
+        std::optional<Graphics::IIndexBuffer::ranged_buffer> idx_ranged;
+        if (!indexBuffer.empty()) idx_ranged = Graphics::IIndexBuffer::ranged_buffer{ 0, static_cast<unsigned>(indexBuffer.size()), indexBuffer };
+        return rangedUpdateVertex({ 0, vtx_count, dataBuffer }, idx_ranged);
+    }
     if (FATAL_LOG_EXPR(dataBuffer.size() > m_vertexBuffer->BufferSize())) return Graphics::ErrorCode::bufferSize;
     if (m_indexBuffer)
     {
@@ -42,6 +64,27 @@ error RenderBuffer::rangedUpdateVertex(const Graphics::IVertexBuffer::ranged_buf
     const std::optional<const Graphics::IIndexBuffer::ranged_buffer>& idxBuffer)
 {
     assert(m_vertexBuffer);
+    if (m_arenaRange)
+    {
+        // 位移到 arena 中的區段, index 要加上 vertex 區段的起點
+        const RenderBufferArena::Range& range = m_arenaRange.value();
+        if (FATAL_LOG_EXPR(vtxBuffer.vtx_offset + vtxBuffer.vtx_count > range.m_vtxCount)) return Graphics::ErrorCode::bufferSize;
+        if ((m_indexBuffer) && (idxBuffer))
+        {
+            if (FATAL_LOG_EXPR(idxBuffer->idx_offset + idxBuffer->data.size() > range.m_idxCount)) return Graphics::ErrorCode::bufferSize;
+        }
+        m_vertexBuffer->RangedUpdate({ vtxBuffer.vtx_offset + range.m_vtxOffset, vtxBuffer.vtx_count, vtxBuffer.data });
+        if ((m_indexBuffer) && (idxBuffer))
+        {
+            Graphics::IIndexBuffer::ranged_buffer rebased{ idxBuffer->idx_offset + range.m_idxOffset, idxBuffer->idx_count, idxBuffer->data };
+            for (auto& index : rebased.data)
+            {
+                index += range.m_vtxOffset;
+            }
+            m_indexBuffer->RangedUpdate(rebased);
+        }
+        return ErrorCode::ok;
+    }
     if (FATAL_LOG_EXPR(vtxBuffer.data.size() > m_vertexBuffer->BufferSize())) return Graphics::ErrorCode::bufferSize;
     if ((m_indexBuffer) && (idxBuffer))
     {
@@ -68,15 +111,18 @@ error RenderBuffer::draw(const std::shared_ptr<EffectMaterial>& effectMaterial,
         Graphics::IGraphicAPI::instance()->bind(m_indexBuffer);
     }
 
+    // sub-allocated 的 index 已經加上 vertex 區段起點, 所以 base vertex 不用再加 arena offset
+    const unsigned start_idx = segment.m_startIdx + baseIndex();
+    const unsigned start_vtx = segment.m_startVtx + (m_indexBuffer ? 0 : baseVertex());
     effectMaterial->applyFirstPass();
     if (m_indexBuffer)
     {
         Graphics::IGraphicAPI::instance()->draw(segment.m_idxCount, segment.m_vtxCount,
-            segment.m_startIdx, static_cast<int>(segment.m_startVtx));
+            start_idx, static_cast<int>(start_vtx));
     }
     else
     {
-        Graphics::IGraphicAPI::instance()->draw(segment.m_vtxCount, segment.m_startVtx);
+        Graphics::IGraphicAPI::instance()->draw(segment.m_vtxCount, start_vtx);
     }
     // if multi-pass effect
     while (effectMaterial->hasNextPass())
@@ -85,11 +131,11 @@ error RenderBuffer::draw(const std::shared_ptr<EffectMaterial>& effectMaterial,
         if (m_indexBuffer)
         {
             Graphics::IGraphicAPI::instance()->draw(segment.m_idxCount, segment.m_vtxCount,
-                segment.m_startIdx, static_cast<int>(segment.m_startVtx));
+                start_idx, static_cast<int>(start_vtx));
         }
         else
         {
-            Graphics::IGraphicAPI::instance()->draw(segment.m_vtxCount, segment.m_startVtx);
+            Graphics::IGraphicAPI::instance()->draw(segment.m_vtxCount, start_vtx);
         }
     }
     return ErrorCode::ok;
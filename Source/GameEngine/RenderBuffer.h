@@ -9,6 +9,7 @@
 #define RENDER_BUFFER_H
 
 #include "RenderBufferSignature.h"
+#include "RenderBufferArena.h"
 #include "Geometries/GeometrySegment.h"
 #include "GraphicKernel/IVertexBuffer.h"
 #include "GraphicKernel/IIndexBuffer.h"
@@ -25,6 +26,10 @@ namespace Enigma::Engine
     public:
         RenderBuffer(const RenderBufferSignature& signature,
             const Graphics::IVertexBufferPtr& vertex_buffer, const Graphics::IIndexBufferPtr& index_buffer);
+        /** sub-allocated from arena chunk buffers, range is released when render buffer destroyed */
+        RenderBuffer(const RenderBufferSignature& signature,
+            const Graphics::IVertexBufferPtr& vertex_buffer, const Graphics::IIndexBufferPtr& index_buffer,
+            const RenderBufferArena::Range& arena_range, const std::weak_ptr<RenderBufferArena>& arena);
         RenderBuffer(const RenderBuffer&) = delete;
         RenderBuffer(RenderBuffer&&) = delete;
         virtual ~RenderBuffer();
@@ -46,6 +51,11 @@ namespace Enigma::Engine
 
         bool isDataEmpty() { return m_isDataEmpty; };
 
+        bool isSubAllocated() const { return m_arenaRange.has_value(); }
+        /** offsets of this render buffer in (shared) vertex/index buffer */
+        unsigned baseVertex() const { return m_arenaRange ? m_arenaRange->m_vtxOffset : 0; }
+        unsigned baseIndex() const { return m_arenaRange ? m_arenaRange->m_idxOffset : 0; }
+
         /** draw */
         error draw(const std::shared_ptr<EffectMaterial>& effectMaterial, const Geometries::GeometrySegment& segment);
 
@@ -58,6 +68,9 @@ namespace Enigma::Engine
         Graphics::IIndexBufferPtr m_indexBuffer;
 
         bool m_isDataEmpty;
+
+        std::optional<RenderBufferArena::Range> m_arenaRange;
+        std::weak_ptr<RenderBufferArena> m_arena;
     };
     using RenderBufferPtr = std::shared_ptr<RenderBuffer>;
 }
@@ -0,0 +1,343 @@
+﻿#include "RenderBufferArena.h"
+#include "RenderBuffer.h"
+#include "EngineErrors.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/CommandBus.h"
+#include "GraphicKernel/GraphicCommands.h"
+#include "GraphicKernel/GraphicEvents.h"
+#include "GraphicKernel/IGraphicAPI.h"
+#include "Platforms/PlatformLayer.h"
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+using namespace Enigma::Engine;
+
+ArenaRangeAllocator::ArenaRangeAllocator(unsigned capacity) : m_capacity(capacity), m_freeCount(capacity)
+{
+    if (capacity > 0) m_freeRanges.emplace(0, capacity);
+}
+
+std::optional<unsigned> ArenaRangeAllocator::allocate(unsigned count)
+{
+    if ((count == 0) || (count > m_freeCount)) return std::nullopt;
+    auto best = m_freeRanges.end();
+    for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it)
+    {
+        if (it->second < count) continue;
+        if ((best == m_freeRanges.end()) || (it->second < best->second)) best = it;
+        if (best->second == count) break;
+    }
+    if (best == m_freeRanges.end()) return std::nullopt;
+    const unsigned offset = best->first;
+    const unsigned remain = best->second - count;
+    m_freeRanges.erase(best);
+    if (remain > 0) m_freeRanges.emplace(offset + count, remain);
+    m_freeCount -= count;
+    return offset;
+}
+
+void ArenaRangeAllocator::release(unsigned offset, unsigned count)
+{
+    if (count == 0) return;
+    assert(offset + count <= m_capacity);
+    auto next = m_freeRanges.lower_bound(offset);
+    assert((next == m_freeRanges.end()) || (offset + count <= next->first));
+    unsigned begin = offset;
+    unsigned end = offset + count;
+    if (next != m_freeRanges.begin())
+    {
+        auto prev = std::prev(next);
+        assert(prev->first + prev->second <= offset);
+        if (prev->first + prev->second == offset)
+        {
+            begin = prev->first;
+            m_freeRanges.erase(prev);
+        }
+    }
+    if ((next != m_freeRanges.end()) && (next->first == end))
+    {
+        end += next->second;
+        m_freeRanges.erase(next);
+    }
+    m_freeRanges.emplace(begin, end - begin);
+    m_freeCount += count;
+}
+
+unsigned ArenaRangeAllocator::largestFreeRange() const
+{
+    unsigned largest = 0;
+    for (const auto& [offset, count] : m_freeRanges)
+    {
+        largest = std::max(largest, count);
+    }
+    return largest;
+}
+
+RenderBufferArena::Chunk::Chunk(const std::string& name, unsigned vtx_capacity, unsigned idx_capacity)
+    : m_vtxBufferName(name + ".vtx"), m_idxBufferName(name + ".idx"), m_vtxRanges(vtx_capacity), m_idxRanges(idx_capacity)
+{
+}
+
+RenderBufferArena::RenderBufferArena(const Config& config) : m_config(config), m_allocatedRangeCount(0)
+{
+    m_onVertexBufferCreated = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { this->onVertexBufferCreated(e); });
+    Frameworks::EventPublisher::subscribe(typeid(Graphics::DeviceVertexBufferCreated), m_onVertexBufferCreated);
+    m_onIndexBufferCreated = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { this->onIndexBufferCreated(e); });
+    Frameworks::EventPublisher::subscribe(typeid(Graphics::DeviceIndexBufferCreated), m_onIndexBufferCreated);
+}
+
+RenderBufferArena::~RenderBufferArena()
+{
+    Frameworks::EventPublisher::unsubscribe(typeid(Graphics::DeviceVertexBufferCreated), m_onVertexBufferCreated);
+    m_onVertexBufferCreated = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(Graphics::DeviceIndexBufferCreated), m_onIndexBufferCreated);
+    m_onIndexBufferCreated = nullptr;
+    m_pendingBuilds.clear();
+    m_chunks.clear();
+}
+
+bool RenderBufferArena::canSubAllocate(const RenderBufferPolicy& policy) const
+{
+    if ((policy.m_sizeofVertex == 0) || (policy.m_vtxBufferSize < policy.m_sizeofVertex)) return false;
+    if (policy.m_vtxBufferSize > m_config.m_maxSubAllocVertexBytes) return false;
+    if (policy.m_vtxBufferSize / policy.m_sizeofVertex > m_config.m_chunkVertexBytes / policy.m_sizeofVertex) return false;
+    const unsigned idx_count = policy.m_idxBufferSize / sizeof(unsigned);
+    return (idx_count <= m_config.m_maxSubAllocIndexCount) && (idx_count <= m_config.m_chunkIndexCount);
+}
+
+error RenderBufferArena::enqueueBuild(const RenderBufferPolicy& policy)
+{
+    if (!canSubAllocate(policy)) return ErrorCode::arenaRangeTooLarge;
+    std::lock_guard locker{ m_arenaLock };
+    // 同一批中有相同 signature 的, 共用同一個 render buffer
+    for (auto& pending : m_pendingBuilds)
+    {
+        if (pending.m_policy.m_signature != policy.m_signature) continue;
+        pending.m_names.emplace_back(policy.m_renderBufferName);
+        return ErrorCode::ok;
+    }
+    auto range = allocateRange(policy.m_sizeofVertex, policy.m_vtxBufferSize / policy.m_sizeofVertex,
+        policy.m_idxBufferSize / static_cast<unsigned>(sizeof(unsigned)));
+    if (!range) return ErrorCode::arenaRangeTooLarge;
+    m_pendingBuilds.push_back(PendingBuild{ { policy.m_renderBufferName }, policy, range.value() });
+    return ErrorCode::ok;
+}
+
+bool RenderBufferArena::hasPendingBuilds()
+{
+    std::lock_guard locker{ m_arenaLock };
+    return !m_pendingBuilds.empty();
+}
+
+std::vector<RenderBufferArena::BuiltBuffer> RenderBufferArena::flushBuilds()
+{
+    std::vector<BuiltBuffer> built_buffers;
+    std::lock_guard locker{ m_arenaLock };
+    if (m_pendingBuilds.empty()) return built_buffers;
+
+    std::map<std::pair<unsigned, unsigned>, std::vector<PendingBuild*>> ready_builds;  // (sizeof vertex, chunk) -> builds
+    for (auto& pending : m_pendingBuilds)
+    {
+        const auto& chunk = m_chunks[pending.m_range.m_sizeofVertex][pending.m_range.m_chunk];
+        if (!chunk->isReady()) continue;
+        ready_builds[{ pending.m_range.m_sizeofVertex, pending.m_range.m_chunk }].push_back(&pending);
+    }
+    if (ready_builds.empty()) return built_buffers;
+
+    for (auto& [key, builds] : ready_builds)
+    {
+        auto& chunk = *m_chunks[key.first][key.second];
+        uploadChunk(chunk, builds);
+        for (auto* pending : builds)
+        {
+            auto buffer = std::make_shared<RenderBuffer>(pending->m_policy.m_signature, chunk.m_vertexBuffer,
+                pending->m_range.m_idxCount > 0 ? chunk.m_indexBuffer : nullptr, pending->m_range, weak_from_this());
+            for (const auto& name : pending->m_names)
+            {
+                built_buffers.push_back(BuiltBuffer{ name, pending->m_policy.m_signature, buffer });
+            }
+        }
+    }
+    m_pendingBuilds.erase(std::remove_if(m_pendingBuilds.begin(), m_pendingBuilds.end(),
+        [this](const PendingBuild& pending) { return m_chunks[pending.m_range.m_sizeofVertex][pending.m_range.m_chunk]->isReady(); }),
+        m_pendingBuilds.end());
+    return built_buffers;
+}
+
+void RenderBufferArena::release(const Range& range)
+{
+    std::lock_guard locker{ m_arenaLock };
+    auto it = m_chunks.find(range.m_sizeofVertex);
+    if ((it == m_chunks.end()) || (range.m_chunk >= it->second.size())) return;
+    auto& chunk = *it->second[range.m_chunk];
+    chunk.m_vtxRanges.release(range.m_vtxOffset, range.m_vtxCount);
+    chunk.m_idxRanges.release(range.m_idxOffset, range.m_idxCount);
+    assert(m_allocatedRangeCount > 0);
+    m_allocatedRangeCount--;
+}
+
+RenderBufferArena::Statistics RenderBufferArena::statistics()
+{
+    Statistics stat;
+    std::lock_guard locker{ m_arenaLock };
+    for (const auto& [sizeof_vertex, chunks] : m_chunks)
+    {
+        for (const auto& chunk : chunks)
+        {
+            stat.m_chunkCount++;
+            stat.m_totalVertexBytes += static_cast<size_t>(chunk->m_vtxRanges.capacity()) * sizeof_vertex;
+            stat.m_usedVertexBytes += static_cast<size_t>(chunk->m_vtxRanges.capacity() - chunk->m_vtxRanges.freeCount()) * sizeof_vertex;
+            stat.m_totalIndexCount += chunk->m_idxRanges.capacity();
+            stat.m_usedIndexCount += chunk->m_idxRanges.capacity() - chunk->m_idxRanges.freeCount();
+        }
+    }
+    stat.m_allocatedRangeCount = m_allocatedRangeCount;
+    return stat;
+}
+
+std::optional<RenderBufferArena::Range> RenderBufferArena::allocateRange(unsigned sizeofVertex, unsigned vtx_count, unsigned idx_count)
+{
+    auto& chunks = m_chunks[sizeofVertex];
+    auto try_allocate = [&](unsigned chunk_index) -> std::optional<Range>
+    {
+        auto& chunk = *chunks[chunk_index];
+        if (chunk.m_vtxRanges.largestFreeRange() < vtx_count) return std::nullopt;
+        if ((idx_count > 0) && (chunk.m_idxRanges.largestFreeRange() < idx_count)) return std::nullopt;
+        Range range;
+        range.m_sizeofVertex = sizeofVertex;
+        range.m_chunk = chunk_index;
+        range.m_vtxOffset = chunk.m_vtxRanges.allocate(vtx_count).value();
+        range.m_vtxCount = vtx_count;
+        if (idx_count > 0)
+        {
+            range.m_idxOffset = chunk.m_idxRanges.allocate(idx_count).value();
+            range.m_idxCount = idx_count;
+        }
+        m_allocatedRangeCount++;
+        return range;
+    };
+    for (unsigned i = 0; i < chunks.size(); i++)
+    {
+        if (auto range = try_allocate(i)) return range;
+    }
+    return try_allocate(createChunk(chunks, sizeofVertex));
+}
+
+unsigned RenderBufferArena::createChunk(ChunkList& chunks, unsigned sizeofVertex)
+{
+    const unsigned chunk_index = static_cast<unsigned>(chunks.size());
+    const unsigned vtx_capacity = m_config.m_chunkVertexBytes / sizeofVertex;
+    chunks.emplace_back(std::make_unique<Chunk>("render_arena." + std::to_string(sizeofVertex) + "." + std::to_string(chunk_index),
+        vtx_capacity, m_config.m_chunkIndexCount));
+    Frameworks::CommandBus::enqueue(std::make_shared<Graphics::CreateVertexBuffer>(
+        chunks.back()->m_vtxBufferName, sizeofVertex, vtx_capacity * sizeofVertex));
+    Frameworks::CommandBus::enqueue(std::make_shared<Graphics::CreateIndexBuffer>(
+        chunks.back()->m_idxBufferName, m_config.m_chunkIndexCount * static_cast<unsigned>(sizeof(unsigned))));
+    return chunk_index;
+}
+
+void RenderBufferArena::uploadChunk(Chunk& chunk, std::vector<PendingBuild*>& builds)
+{
+    assert(chunk.isReady());
+    if (builds.empty()) return;
+    const unsigned sizeofVertex = builds.front()->m_range.m_sizeofVertex;
+
+    // 相鄰的 vertex range 合併成一次上傳
+    std::sort(builds.begin(), builds.end(), [](const PendingBuild* a, const PendingBuild* b) { return a->m_range.m_vtxOffset < b->m_range.m_vtxOffset; });
+    Graphics::IVertexBuffer::ranged_buffer vtx_batch{ 0, 0, {} };
+    auto flush_vertices = [&]()
+    {
+        if (vtx_batch.vtx_count > 0) chunk.m_vertexBuffer->RangedUpdate(vtx_batch);
+        vtx_batch = { 0, 0, {} };
+    };
+    for (const auto* pending : builds)
+    {
+        const Range& range = pending->m_range;
+        if ((vtx_batch.vtx_count > 0) && (vtx_batch.vtx_offset + vtx_batch.vtx_count != range.m_vtxOffset)) flush_vertices();
+        if (vtx_batch.vtx_count == 0) vtx_batch.vtx_offset = range.m_vtxOffset;
+        const size_t start = vtx_batch.data.size();
+        vtx_batch.data.resize(start + static_cast<size_t>(range.m_vtxCount) * sizeofVertex, 0);
+        if (pending->m_policy.m_vtxBuffer)
+        {
+            const auto& src = pending->m_policy.m_vtxBuffer.value();
+            std::memcpy(&vtx_batch.data[start], src.data(), std::min(src.size(), static_cast<size_t>(range.m_vtxCount) * sizeofVertex));
+        }
+        vtx_batch.vtx_count += range.m_vtxCount;
+    }
+    flush_vertices();
+
+    std::sort(builds.begin(), builds.end(), [](const PendingBuild* a, const PendingBuild* b) { return a->m_range.m_idxOffset < b->m_range.m_idxOffset; });
+    Graphics::IIndexBuffer::ranged_buffer idx_batch{ 0, 0, {} };
+    auto flush_indices = [&]()
+    {
+        if (idx_batch.idx_count > 0) chunk.m_indexBuffer->RangedUpdate(idx_batch);
+        idx_batch = { 0, 0, {} };
+    };
+    for (const auto* pending : builds)
+    {
+        const Range& range = pending->m_range;
+        if (range.m_idxCount == 0) continue;
+        if ((idx_batch.idx_count > 0) && (idx_batch.idx_offset + idx_batch.idx_count != range.m_idxOffset)) flush_indices();
+        if (idx_batch.idx_count == 0) idx_batch.idx_offset = range.m_idxOffset;
+        const size_t start = idx_batch.data.size();
+        idx_batch.data.resize(start + range.m_idxCount, range.m_vtxOffset);
+        if (pending->m_policy.m_idxBuffer)
+        {
+            const auto& src = pending->m_policy.m_idxBuffer.value();
+            const size_t count = std::min(src.size(), static_cast<size_t>(range.m_idxCount));
+            for (size_t i = 0; i < count; i++)
+            {
+                idx_batch.data[start + i] = src[i] + range.m_vtxOffset;
+            }
+        }
+        idx_batch.idx_count += range.m_idxCount;
+    }
+    flush_indices();
+}
+
+void RenderBufferArena::onVertexBufferCreated(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<Graphics::DeviceVertexBufferCreated, Frameworks::IEvent>(e);
+    if (!ev) return;
+    std::lock_guard locker{ m_arenaLock };
+    for (auto& [sizeof_vertex, chunks] : m_chunks)
+    {
+        for (auto& chunk : chunks)
+        {
+            if (chunk->m_vtxBufferName != ev->GetBufferName()) continue;
+            auto buffer = Graphics::IGraphicAPI::instance()->TryFindGraphicAsset<Graphics::IVertexBufferPtr>(ev->GetBufferName());
+            if (!buffer)
+            {
+                Platforms::Debug::ErrorPrintf("can't get arena vertex buffer asset %s\n", ev->GetBufferName().c_str());
+                return;
+            }
+            chunk->m_vertexBuffer = buffer.value();
+            return;
+        }
+    }
+}
+
+void RenderBufferArena::onIndexBufferCreated(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<Graphics::DeviceIndexBufferCreated, Frameworks::IEvent>(e);
+    if (!ev) return;
+    std::lock_guard locker{ m_arenaLock };
+    for (auto& [sizeof_vertex, chunks] : m_chunks)
+    {
+        for (auto& chunk : chunks)
+        {
+            if (chunk->m_idxBufferName != ev->GetBufferName()) continue;
+            auto buffer = Graphics::IGraphicAPI::instance()->TryFindGraphicAsset<Graphics::IIndexBufferPtr>(ev->GetBufferName());
+            if (!buffer)
+            {
+                Platforms::Debug::ErrorPrintf("can't get arena index buffer asset %s\n", ev->GetBufferName().c_str());
+                return;
+            }
+            chunk->m_indexBuffer = buffer.value();
+            return;
+        }
+    }
+}
@@ -0,0 +1,148 @@
+﻿/*********************************************************************
+ * \file   RenderBufferArena.h
+ * \brief  sub-allocating vertex/index arena, shared by many small render buffers
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef RENDER_BUFFER_ARENA_H
+#define RENDER_BUFFER_ARENA_H
+
+#include "RenderBufferBuildingPolicies.h"
+#include "RenderBufferSignature.h"
+#include "Frameworks/EventSubscriber.h"
+#include "GraphicKernel/IVertexBuffer.h"
+#include "GraphicKernel/IIndexBuffer.h"
+#include <memory>
+#include <mutex>
+#include <map>
+#include <vector>
+#include <optional>
+#include <system_error>
+
+namespace Enigma::Engine
+{
+    using error = std::error_code;
+
+    class RenderBuffer;
+
+    /** offset 排序的 free list, 單位是 vertex 或 index 個數; best fit 配置, 釋放時與相鄰區段合併 */
+    class ArenaRangeAllocator
+    {
+    public:
+        ArenaRangeAllocator(unsigned capacity);
+
+        std::optional<unsigned> allocate(unsigned count);
+        void release(unsigned offset, unsigned count);
+
+        unsigned capacity() const { return m_capacity; }
+        unsigned freeCount() const { return m_freeCount; }
+        unsigned largestFreeRange() const;
+
+    private:
+        unsigned m_capacity;
+        unsigned m_freeCount;
+        std::map<unsigned, unsigned> m_freeRanges;  ///< offset -> count
+    };
+
+    /** 同一 vertex size 的 geometry 共用大塊的 vertex/index buffer (chunk),
+     每個 render buffer 只佔 chunk 中的一段; index 上傳時會加上 vertex 段的起點,
+     所以 draw 時不需要 base vertex 也正確 (gles 沒有 base vertex) */
+    class RenderBufferArena : public std::enable_shared_from_this<RenderBufferArena>
+    {
+    public:
+        struct Config
+        {
+            unsigned m_chunkVertexBytes = 4 * 1024 * 1024;
+            unsigned m_chunkIndexCount = 256 * 1024;
+            /// 超過這個大小的 geometry 還是用獨立的 buffer
+            unsigned m_maxSubAllocVertexBytes = 256 * 1024;
+            unsigned m_maxSubAllocIndexCount = 64 * 1024;
+        };
+        struct Range
+        {
+            unsigned m_sizeofVertex = 0;
+            unsigned m_chunk = 0;
+            unsigned m_vtxOffset = 0;
+            unsigned m_vtxCount = 0;
+            unsigned m_idxOffset = 0;
+            unsigned m_idxCount = 0;
+        };
+        struct BuiltBuffer
+        {
+            std::string m_name;
+            RenderBufferSignature m_signature;
+            std::shared_ptr<RenderBuffer> m_buffer;
+        };
+        struct Statistics
+        {
+            unsigned m_chunkCount = 0;
+            unsigned m_allocatedRangeCount = 0;
+            size_t m_usedVertexBytes = 0;
+            size_t m_totalVertexBytes = 0;
+            size_t m_usedIndexCount = 0;
+            size_t m_totalIndexCount = 0;
+        };
+
+    public:
+        RenderBufferArena(const Config& config);
+        RenderBufferArena(const RenderBufferArena&) = delete;
+        RenderBufferArena(RenderBufferArena&&) = delete;
+        ~RenderBufferArena();
+        RenderBufferArena& operator=(const RenderBufferArena&) = delete;
+        RenderBufferArena& operator=(RenderBufferArena&&) = delete;
+
+        const Config& config() const { return m_config; }
+
+        bool canSubAllocate(const RenderBufferPolicy& policy) const;
+        /** 配置 range, 資料等 chunk 的 device buffer 建好後再一起上傳 */
+        error enqueueBuild(const RenderBufferPolicy& policy);
+        bool hasPendingBuilds();
+        /** 上傳已就緒 chunk 的資料 (相鄰 range 合併成一次 ranged update), 產生 render buffer */
+        std::vector<BuiltBuffer> flushBuilds();
+
+        /** called by render buffer destructor */
+        void release(const Range& range);
+
+        Statistics statistics();
+
+    private:
+        struct Chunk
+        {
+            std::string m_vtxBufferName;
+            std::string m_idxBufferName;
+            Graphics::IVertexBufferPtr m_vertexBuffer;
+            Graphics::IIndexBufferPtr m_indexBuffer;
+            ArenaRangeAllocator m_vtxRanges;
+            ArenaRangeAllocator m_idxRanges;
+            Chunk(const std::string& name, unsigned vtx_capacity, unsigned idx_capacity);
+            bool isReady() const { return m_vertexBuffer && m_indexBuffer; }
+        };
+        struct PendingBuild
+        {
+            std::vector<std::string> m_names;
+            RenderBufferPolicy m_policy;
+            Range m_range;
+        };
+        using ChunkList = std::vector<std::unique_ptr<Chunk>>;
+
+        std::optional<Range> allocateRange(unsigned sizeofVertex, unsigned vtx_count, unsigned idx_count);
+        unsigned createChunk(ChunkList& chunks, unsigned sizeofVertex);
+        void uploadChunk(Chunk& chunk, std::vector<PendingBuild*>& builds);
+
+        void onVertexBufferCreated(const Frameworks::IEventPtr& e);
+        void onIndexBufferCreated(const Frameworks::IEventPtr& e);
+
+    private:
+        Config m_config;
+        Frameworks::EventSubscriberPtr m_onVertexBufferCreated;
+        Frameworks::EventSubscriberPtr m_onIndexBufferCreated;
+
+        std::map<unsigned, ChunkList> m_chunks;  ///< sizeof vertex -> chunks
+        std::vector<PendingBuild> m_pendingBuilds;
+        unsigned m_allocatedRangeCount;
+        std::recursive_mutex m_arenaLock;
+    };
+}
+
+#endif // RENDER_BUFFER_ARENA_H
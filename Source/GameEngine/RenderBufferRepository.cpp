@@ -16,8 +16,10 @@ DEFINE_RTTI(Engine, RenderBufferRepository, ISystemService);
 RenderBufferRepository::RenderBufferRepository(Frameworks::ServiceManager* srv_manager) : ISystemService(srv_manager)
 {
     m_needTick = false;
+    m_tickPriority = Frameworks::ServicePriority::Background;
     m_isCurrentBuilding = false;
     m_builder = new RenderBufferBuilder(this);
+    enableArena(RenderBufferArena::Config{});
 }
 
 RenderBufferRepository::~RenderBufferRepository()
@@ -43,11 +45,12 @@ Enigma::Frameworks::ServiceResult RenderBufferRepository::onInit()
 
 Enigma::Frameworks::ServiceResult RenderBufferRepository::onTick()
 {
+    if (m_arena) buildArenaRenderBuffers();
     if (m_isCurrentBuilding) return Frameworks::ServiceResult::Pendding;
     std::lock_guard locker{ m_policiesLock };
     if (m_policies.empty())
     {
-        m_needTick = false;
+        m_needTick = (m_arena) && (m_arena->hasPendingBuilds());
         return Frameworks::ServiceResult::Pendding;
     }
     assert(m_builder);
@@ -66,6 +69,8 @@ Enigma::Frameworks::ServiceResult RenderBufferRepository::onTerm()
 
     Frameworks::CommandBus::unsubscribe(typeid(BuildRenderBuffer), m_buildRenderBuffer);
     m_buildRenderBuffer = nullptr;
+
+    m_arena = nullptr;
     return Frameworks::ServiceResult::Complete;
 }
 
@@ -77,6 +82,11 @@ error RenderBufferRepository::buildRenderBuffer(const RenderBufferPolicy& policy
     return ErrorCode::ok;
 }
 
+void RenderBufferRepository::enableArena(const RenderBufferArena::Config& config)
+{
+    m_arena = std::make_shared<RenderBufferArena>(config);
+}
+
 bool RenderBufferRepository::hasRenderBuffer(const RenderBufferSignature& signature)
 {
     std::lock_guard locker{ m_bufferMapLock };
@@ -122,3 +132,32 @@ void RenderBufferRepository::buildRenderBuffer(const Frameworks::ICommandPtr& c)
     if (!cmd) return;
     buildRenderBuffer(cmd->GetPolicy());
 }
+
+void RenderBufferRepository::buildArenaRenderBuffers()
+{
+    assert(m_arena);
+    {
+        // 放得進 arena 的全部取出配置, 其他的留給 builder 逐一建立
+        std::lock_guard locker{ m_policiesLock };
+        std::queue<RenderBufferPolicy> dedicated_policies;
+        while (!m_policies.empty())
+        {
+            const RenderBufferPolicy& policy = m_policies.front();
+            if ((hasRenderBuffer(policy.m_signature)) || (!m_arena->canSubAllocate(policy))
+                || (m_arena->enqueueBuild(policy)))
+            {
+                dedicated_policies.push(policy);
+            }
+            m_policies.pop();
+        }
+        m_policies.swap(dedicated_policies);
+    }
+    for (const auto& built : m_arena->flushBuilds())
+    {
+        {
+            std::lock_guard locker{ m_bufferMapLock };
+            m_renderBuffers.insert_or_assign(built.m_signature, built.m_buffer);
+        }
+        Frameworks::EventPublisher::enqueue(std::make_shared<RenderBufferBuilt>(built.m_name, built.m_signature, built.m_buffer));
+    }
+}
@@ -13,6 +13,7 @@
 #include "Frameworks/Command.h"
 #include "RenderBufferSignature.h"
 #include "RenderBufferBuildingPolicies.h"
+#include "RenderBufferArena.h"
 #include "Frameworks/EventSubscriber.h"
 #include "Frameworks/CommandSubscriber.h"
 #include <mutex>
@@ -42,6 +43,11 @@ namespace Enigma::Engine
 
         error buildRenderBuffer(const RenderBufferPolicy& policy);
 
+        /** 小的 render buffer 改由 arena 配置, 一次 tick 批次建立所有排隊中的 policy.
+         建構時就以 Config{} 啟用; 要換 chunk 大小, 在 build 任何 render buffer 之前再呼叫一次 */
+        void enableArena(const RenderBufferArena::Config& config);
+        std::shared_ptr<RenderBufferArena> arena() const { return m_arena; }
+
         bool hasRenderBuffer(const RenderBufferSignature& signature);
         std::shared_ptr<RenderBuffer> queryRenderBuffer(const RenderBufferSignature& signature);
 
@@ -50,6 +56,8 @@ namespace Enigma::Engine
         void onBuildRenderBufferFailed(const Frameworks::IEventPtr& e);
         void buildRenderBuffer(const Frameworks::ICommandPtr& c);
 
+        void buildArenaRenderBuffers();
+
     private:
         Frameworks::EventSubscriberPtr m_onRenderBufferBuilt;
         Frameworks::EventSubscriberPtr m_onBuildRenderBufferFailed;
@@ -61,6 +69,7 @@ namespace Enigma::Engine
         std::recursive_mutex m_bufferMapLock;
 
         RenderBufferBuilder* m_builder;
+        std::shared_ptr<RenderBufferArena> m_arena;
         std::queue<RenderBufferPolicy> m_policies;
         bool m_isCurrentBuilding;
         std::mutex m_policiesLock;
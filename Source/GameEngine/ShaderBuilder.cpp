@@ -219,6 +219,7 @@ void ShaderBuilder::onShaderCompileFailed(const Frameworks::IEventPtr& e)
     auto ev_vtx_fail = std::dynamic_pointer_cast<Graphics::VertexShaderCompileFailed, Frameworks::IEvent>(e);
     if (ev_vtx_fail)
     {
+        if (ev_vtx_fail->GetShaderName() != m_policy.m_vtxShaderName) return;
         Frameworks::EventPublisher::enqueue(std::make_shared<BuildShaderProgramFailed>(
             m_policy.m_programName, Graphics::ErrorCode::compileShader));
         return;
@@ -226,6 +227,7 @@ void ShaderBuilder::onShaderCompileFailed(const Frameworks::IEventPtr& e)
     auto ev_pix_fail = std::dynamic_pointer_cast<Graphics::PixelShaderCompileFailed, Frameworks::IEvent>(e);
     if (ev_pix_fail)
     {
+        if (ev_pix_fail->GetShaderName() != m_policy.m_pixShaderName) return;
         Frameworks::EventPublisher::enqueue(std::make_shared<BuildShaderProgramFailed>(
             m_policy.m_programName, Graphics::ErrorCode::compileShader));
         return;
@@ -300,6 +302,7 @@ void ShaderBuilder::onShaderProgramLinkFailed(const Frameworks::IEventPtr& e)
     auto ev_link_fail = std::dynamic_pointer_cast<Graphics::ShaderProgramLinkFailed, Frameworks::IEvent>(e);
     if (ev_link_fail)
     {
+        if (ev_link_fail->GetShaderName() != m_policy.m_programName) return;
         Frameworks::EventPublisher::enqueue(std::make_shared<BuildShaderProgramFailed>(
             m_policy.m_programName, Graphics::ErrorCode::linkShaderProgram));
         return;
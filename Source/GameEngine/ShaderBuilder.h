@@ -65,6 +65,7 @@ namespace Enigma::Engine
 
         void buildShaderProgram(const ShaderProgramPolicy& policy);
 
+        const ShaderProgramPolicy& getPolicy() const { return m_policy; }
         Graphics::IShaderProgramPtr getProgram() { return m_program; }
 
     private:
@@ -20,13 +20,25 @@ static std::string shaderCodePathID = std::string("SHADER_CODE_PATH");
 ShaderRepository::ShaderRepository(Frameworks::ServiceManager* srv_mngr) : ISystemService(srv_mngr)
 {
     m_needTick = false;
-    m_isCurrentBuilding = false;
-    m_builder = menew ShaderBuilder(this);
+    m_tickPriority = Frameworks::ServicePriority::Background;
+    for (unsigned i = 0; i < MAX_CONCURRENT_BUILDERS; i++)
+    {
+        m_idleBuilders.emplace_back(menew ShaderBuilder(this));
+    }
 }
 
 ShaderRepository::~ShaderRepository()
 {
-    SAFE_DELETE(m_builder);
+    for (auto& builder : m_idleBuilders)
+    {
+        SAFE_DELETE(builder);
+    }
+    m_idleBuilders.clear();
+    for (auto& [name, builder] : m_buildingBuilders)
+    {
+        SAFE_DELETE(builder);
+    }
+    m_buildingBuilders.clear();
 }
 
 Enigma::Frameworks::ServiceResult ShaderRepository::onInit()
@@ -45,17 +57,40 @@ Enigma::Frameworks::ServiceResult ShaderRepository::onInit()
 
 Enigma::Frameworks::ServiceResult ShaderRepository::onTick()
 {
-    if (m_isCurrentBuilding) return Frameworks::ServiceResult::Pendding;
     std::lock_guard locker{ m_policiesLock };
     if (m_policies.empty())
     {
         m_needTick = false;
         return Frameworks::ServiceResult::Pendding;
     }
-    assert(m_builder);
-    m_builder->buildShaderProgram(m_policies.front());
-    m_policies.pop();
-    m_isCurrentBuilding = true;
+    auto it = m_policies.begin();
+    while ((it != m_policies.end()) && (!m_idleBuilders.empty()))
+    {
+        if (hasShaderProgram(it->m_programName))
+        {
+            // 已經建好 (或前一個同名的 policy 剛建好), 不用再建一次
+            Frameworks::EventPublisher::enqueue(std::make_shared<ShaderProgramBuilt>(it->m_programName, queryShaderProgram(it->m_programName)));
+            it = m_policies.erase(it);
+            continue;
+        }
+        if (isConflictWithBuilding(*it))
+        {
+            ++it;
+            continue;
+        }
+        ShaderBuilder* builder = m_idleBuilders.back();
+        m_idleBuilders.pop_back();
+        m_buildingBuilders.insert_or_assign(it->m_programName, builder);
+        builder->buildShaderProgram(*it);
+        it = m_policies.erase(it);
+        if (isTimeSliceExpired())
+        {
+            // time slice 用完, 剩下的留到下個 frame
+            return Frameworks::ServiceResult::Pendding;
+        }
+    }
+    // 剩下的 policy 要等 builder 完成才能再派送, 由完成事件再打開 tick
+    m_needTick = false;
     return Frameworks::ServiceResult::Pendding;
 }
 
@@ -75,7 +110,7 @@ Enigma::Frameworks::ServiceResult ShaderRepository::onTerm()
 error ShaderRepository::buildShaderProgram(const ShaderProgramPolicy& policy)
 {
     std::lock_guard locker{ m_policiesLock };
-    m_policies.push(policy);
+    m_policies.push_back(policy);
     m_needTick = true;
     return ErrorCode::ok;
 }
@@ -149,17 +184,46 @@ const std::string& ShaderRepository::getShaderCodePathID()
     return shaderCodePathID;
 }
 
+bool ShaderRepository::isConflictWithBuilding(const ShaderProgramPolicy& policy) const
+{
+    for (const auto& [name, builder] : m_buildingBuilders)
+    {
+        const ShaderProgramPolicy& building = builder->getPolicy();
+        if ((building.m_programName == policy.m_programName)
+            || (building.m_vtxShaderName == policy.m_vtxShaderName)
+            || (building.m_vtxLayoutName == policy.m_vtxLayoutName)
+            || (building.m_pixShaderName == policy.m_pixShaderName)) return true;
+    }
+    return false;
+}
+
+void ShaderRepository::releaseBuilder(const std::string& program_name)
+{
+    std::lock_guard locker{ m_policiesLock };
+    auto it = m_buildingBuilders.find(program_name);
+    if (it == m_buildingBuilders.end()) return;
+    m_idleBuilders.emplace_back(it->second);
+    m_buildingBuilders.erase(it);
+    if (!m_policies.empty()) m_needTick = true;
+}
+
 void ShaderRepository::onBuilderShaderProgramBuilt(const Frameworks::IEventPtr& e)
 {
-    assert(m_builder);
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<ShaderBuilder::ShaderProgramBuilt, Frameworks::IEvent>(e);
     if (!ev) return;
 
-    Graphics::IShaderProgramPtr program = m_builder->getProgram();
+    Graphics::IShaderProgramPtr program = nullptr;
+    {
+        std::lock_guard locker{ m_policiesLock };
+        auto it = m_buildingBuilders.find(ev->shaderName());
+        if (it == m_buildingBuilders.end()) return;
+        program = it->second->getProgram();
+    }
     if (!program)
     {
         Platforms::Debug::ErrorPrintf("get null program on builder shader program built!!\n");
+        releaseBuilder(ev->shaderName());
         return;
     }
     {
@@ -179,7 +243,7 @@ void ShaderRepository::onBuilderShaderProgramBuilt(const Frameworks::IEventPtr&
         m_programTable.insert_or_assign(program->getName(), program);
     }
     Frameworks::EventPublisher::enqueue(std::make_shared<ShaderProgramBuilt>(program->getName(), program));
-    m_isCurrentBuilding = false;
+    releaseBuilder(ev->shaderName());
 }
 
 void ShaderRepository::onBuildShaderProgramFailed(const Frameworks::IEventPtr& e)
@@ -189,8 +253,9 @@ void ShaderRepository::onBuildShaderProgramFailed(const Frameworks::IEventPtr& e
     if (!ev) return;
     Platforms::Debug::ErrorPrintf("shader program %s build failed : %s\n",
         ev->GetShaderName().c_str(), ev->GetErrorCode().message().c_str());
-    m_isCurrentBuilding = false;
+    releaseBuilder(ev->GetShaderName());
 }
+
 void ShaderRepository::buildShaderProgram(const Frameworks::ICommandPtr& c)
 {
     if (!c) return;
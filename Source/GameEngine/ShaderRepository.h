@@ -18,7 +18,8 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
-#include <queue>
+#include <deque>
+#include <vector>
 
 namespace Enigma::Graphics
 {
@@ -34,10 +35,14 @@ namespace Enigma::Engine
     class ShaderBuilder;
 
     //! ADR : 沒有StoreMapper, 只是可以重複使用 shader 資源
+    //! ADR : 多個 builder 同時建立 program, 各自用 program name 對應事件;
+    //!  跟進行中的 builder 共用 vertex/pixel shader 或 layout 名稱的 policy 要等前一個完成, 再從 table 直接取用
     class ShaderRepository : public Frameworks::ISystemService
     {
         DECLARE_EN_RTTI;
     public:
+        static constexpr unsigned MAX_CONCURRENT_BUILDERS = 4;
+
         ShaderRepository(Frameworks::ServiceManager* srv_mngr);
         ShaderRepository(const ShaderRepository&) = delete;
         ShaderRepository(ShaderRepository&&) = delete;
@@ -75,6 +80,9 @@ namespace Enigma::Engine
         static const std::string& getShaderCodePathID();
 
     protected:
+        bool isConflictWithBuilding(const ShaderProgramPolicy& policy) const;
+        void releaseBuilder(const std::string& program_name);
+
         void onBuilderShaderProgramBuilt(const Frameworks::IEventPtr& e);
         void onBuildShaderProgramFailed(const Frameworks::IEventPtr& e);
         void buildShaderProgram(const Frameworks::ICommandPtr& c);
@@ -84,10 +92,10 @@ namespace Enigma::Engine
         Frameworks::EventSubscriberPtr m_onBuildShaderProgramFailed;
         Frameworks::CommandSubscriberPtr m_buildShaderProgram;
 
-        ShaderBuilder* m_builder;
-        std::queue<ShaderProgramPolicy> m_policies;
-        bool m_isCurrentBuilding;
-        std::mutex m_policiesLock;
+        std::vector<ShaderBuilder*> m_idleBuilders;
+        std::unordered_map<std::string, ShaderBuilder*> m_buildingBuilders;  ///< key : program name
+        std::deque<ShaderProgramPolicy> m_policies;
+        std::recursive_mutex m_policiesLock;
 
         VertexShaderTable m_vtxShaderTable;
         VertexLayoutTable m_vtxLayoutTable;
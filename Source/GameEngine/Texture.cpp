@@ -5,6 +5,7 @@
 #include "Texture.h"
 #include "TextureAssembler.h"
 #include "TextureQueries.h"
+#include "TextureStreamer.h"
 #include "Frameworks/QueryDispatcher.h"
 #include <cassert>
 
@@ -137,7 +138,8 @@ void Texture::instanceDeviceTexture(const Graphics::ITexturePtr& tex)
     assert(m_lazyStatus.isLoading());
     assert(m_isCubeTexture == tex->isCubeTexture());
     assert(isMultiTexture() == tex->isMultiTexture());
-    assert(m_dimension == tex->dimension());
+    // streaming 時 device texture 先放 mip tail, 尺寸可以比 texture 本身小
+    assert((tex->dimension().m_width <= m_dimension.m_width) && (tex->dimension().m_height <= m_dimension.m_height));
     if (isMultiTexture())
     {
         assert(m_surfaceCount == std::dynamic_pointer_cast<IMultiTexture>(tex)->surfaceCount());
@@ -150,3 +152,8 @@ void Texture::instanceDeviceTexture(const Graphics::ITexturePtr& tex)
     m_lazyStatus.changeStatus(LazyStatus::Status::Ready);
 }
 
+void Texture::streamingPriority(float camera_distance)
+{
+    if (auto streamer = m_streamer.lock()) streamer->updatePriority(m_id, camera_distance);
+}
+
@@ -21,6 +21,7 @@ namespace Enigma::Engine
 {
     class TextureAssembler;
     class TextureDisassembler;
+    class TextureStreamer;
 
     class Texture
     {
@@ -56,6 +57,11 @@ namespace Enigma::Engine
         bool isMultiTexture() const;
         const std::vector<std::string>& filePaths() const; //! ADR : file paths 只是唯讀的屬性
 
+        /** streamer 登錄 texture 時設定 */
+        void streamer(const std::weak_ptr<TextureStreamer>& streamer) { m_streamer = streamer; }
+        /** 使用這個 texture 的物件與 camera 的距離, 沒有 streamer 時不做事 */
+        void streamingPriority(float camera_distance);
+
     protected:
         TextureId m_id;
         Frameworks::LazyStatus m_lazyStatus;
@@ -66,6 +72,7 @@ namespace Enigma::Engine
         std::vector<std::string> m_filePaths;
         FactoryDesc m_factoryDesc;
         Graphics::ITexturePtr m_texture;
+        std::weak_ptr<TextureStreamer> m_streamer;
     };
 }
 
@@ -48,3 +48,9 @@ std::shared_ptr<Texture> TextureFactory::constitute(const TextureId& id, const G
     Frameworks::EventPublisher::enqueue(std::make_shared<TextureConstituted>(id, texture, is_persisted));
     return texture;
 }
+
+void TextureFactory::textureStreamer(const std::shared_ptr<TextureStreamer>& streamer)
+{
+    assert(m_processor);
+    m_processor->textureStreamer(streamer);
+}
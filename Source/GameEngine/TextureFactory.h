@@ -17,6 +17,7 @@ namespace Enigma::Engine
 {
     class Texture;
     class TextureResourceProcessor;
+    class TextureStreamer;
 
     class TextureFactory
     {
@@ -30,6 +31,8 @@ namespace Enigma::Engine
         std::shared_ptr<Texture> create(const TextureId& id);
         std::shared_ptr<Texture> constitute(const TextureId& id, const GenericDto& dto, bool is_persisted);
 
+        void textureStreamer(const std::shared_ptr<TextureStreamer>& streamer);
+
     private:
         TextureResourceProcessor* m_processor;
     };
@@ -9,6 +9,10 @@
 #include "Platforms/PlatformLayer.h"
 #include "TextureLoader.h"
 #include "TextureRepository.h"
+#include "TextureStreamer.h"
+#include "GraphicKernel/TextureContainer.h"
+#include "FileSystem/Filename.h"
+#include "Frameworks/WorkerThreadPool.h"
 #include <cassert>
 #include <memory>
 
@@ -32,6 +36,10 @@ TextureLoader::TextureLoader()
     Frameworks::EventPublisher::subscribe(typeid(Graphics::MultiTextureResourceFromMemoryCreated), m_onMultiTextureResourceCreated);
     m_onTextureCreateResourceFailed = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { this->onTextureCreateResourceFailed(e); });
     Frameworks::EventPublisher::subscribe(typeid(Graphics::TextureResourceCreateFromMemoryFailed), m_onTextureCreateResourceFailed);
+    m_onTextureImageDecoded = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { this->onTextureImageDecoded(e); });
+    Frameworks::EventPublisher::subscribe(typeid(TextureImageDecoded), m_onTextureImageDecoded);
+    m_onDecodeTextureImageFailed = std::make_shared<Frameworks::EventSubscriber>([=](auto e) { this->onDecodeTextureImageFailed(e); });
+    Frameworks::EventPublisher::subscribe(typeid(DecodeTextureImageFailed), m_onDecodeTextureImageFailed);
 }
 
 TextureLoader::~TextureLoader()
@@ -50,62 +58,109 @@ TextureLoader::~TextureLoader()
     m_onMultiTextureResourceCreated = nullptr;
     Frameworks::EventPublisher::unsubscribe(typeid(Graphics::TextureResourceCreateFromMemoryFailed), m_onTextureCreateResourceFailed);
     m_onTextureCreateResourceFailed = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(TextureImageDecoded), m_onTextureImageDecoded);
+    m_onTextureImageDecoded = nullptr;
+    Frameworks::EventPublisher::unsubscribe(typeid(DecodeTextureImageFailed), m_onDecodeTextureImageFailed);
+    m_onDecodeTextureImageFailed = nullptr;
 }
 
 void TextureLoader::loadImage(const std::shared_ptr<Texture>& texture, const std::shared_ptr<TextureDisassembler>& disassembler)
 {
     assert(texture);
-    m_contentingTexture = texture;
-    m_disassembler = disassembler;
-    if (m_contentingTexture->isMultiTexture())
     {
-        CommandBus::enqueue(std::make_shared<CreateDeviceMultiTexture>(m_contentingTexture->id().name()));
+        std::lock_guard locker{ m_contentingLock };
+        m_contentingTextures.insert_or_assign(texture->id().name(), ContentingTexture{ texture, disassembler, nullptr });
+    }
+    if (texture->isMultiTexture())
+    {
+        CommandBus::enqueue(std::make_shared<CreateDeviceMultiTexture>(texture->id().name()));
     }
     else
     {
-        CommandBus::enqueue(std::make_shared<CreateDeviceTexture>(m_contentingTexture->id().name()));
+        CommandBus::enqueue(std::make_shared<CreateDeviceTexture>(texture->id().name()));
+    }
+}
+
+std::optional<TextureLoader::ContentingTexture> TextureLoader::findContentingTexture(const std::string& name)
+{
+    std::lock_guard locker{ m_contentingLock };
+    auto it = m_contentingTextures.find(name);
+    if (it == m_contentingTextures.end()) return std::nullopt;
+    return it->second;
+}
+
+bool TextureLoader::canStreamTexture(const ContentingTexture& contenting) const
+{
+    if ((!m_streamer) || (!m_streamer->workers())) return false;
+    if (contenting.m_texture->isMultiTexture()) return false;
+    if (contenting.m_texture->isCubeTexture()) return false;
+    const auto& filenames = contenting.m_disassembler->imageFilenamesOfLoad();
+    if ((!filenames) || (filenames->size() != 1)) return false;
+    // texture container 已經有 mip chain, device 直接上傳, 不用 streaming decode
+    return FileSystem::Filename(filenames.value()[0], "").getExt() != Graphics::TextureContainer::FILE_EXTENSION;
+}
+
+void TextureLoader::decodeStreamingImage(const ContentingTexture& contenting, const std::shared_ptr<Graphics::ITexture>& dev_tex)
+{
+    auto decoded = std::make_shared<DecodedImage>();
+    {
+        std::lock_guard locker{ m_contentingLock };
+        auto it = m_contentingTextures.find(contenting.m_texture->id().name());
+        if (it == m_contentingTextures.end()) return;
+        it->second.m_decoded = decoded;
     }
+    // worker 只碰 decoded 跟 device texture, 結果用事件送回來, 不抓 this
+    m_streamer->workers()->pushTask([decoded, dev_tex, name = contenting.m_texture->id().name(),
+        filename = contenting.m_disassembler->imageFilenamesOfLoad().value()[0]]()
+        {
+            decoded->m_chain = TextureStreamer::decodeImageFile(dev_tex, filename, decoded->m_error);
+            if (decoded->m_chain)
+            {
+                EventPublisher::enqueue(std::make_shared<TextureImageDecoded>(name));
+            }
+            else
+            {
+                EventPublisher::enqueue(std::make_shared<DecodeTextureImageFailed>(name, decoded->m_error));
+            }
+        });
 }
 
-void TextureLoader::loadResourceTextures(const std::shared_ptr<Graphics::ITexture>& dev_tex)
+void TextureLoader::loadResourceTextures(const ContentingTexture& contenting, const std::shared_ptr<Graphics::ITexture>& dev_tex)
 {
-    assert(m_contentingTexture);
-    assert(m_contentingTexture->lazyStatus().isLoading());
-    assert(m_disassembler);
+    assert(contenting.m_texture->lazyStatus().isLoading());
+    assert(contenting.m_disassembler);
     assert(dev_tex);
-    assert((m_disassembler->imageFilenamesOfLoad()) && (!m_disassembler->imageFilenamesOfLoad()->empty()));
-    if (m_contentingTexture->isMultiTexture())
+    assert((contenting.m_disassembler->imageFilenamesOfLoad()) && (!contenting.m_disassembler->imageFilenamesOfLoad()->empty()));
+    if (contenting.m_texture->isMultiTexture())
     {
-        std::dynamic_pointer_cast<IMultiTexture>(dev_tex)->multiLoad(m_disassembler->imageFilenamesOfLoad().value(), {});
+        std::dynamic_pointer_cast<IMultiTexture>(dev_tex)->multiLoad(contenting.m_disassembler->imageFilenamesOfLoad().value(), {});
     }
     else
     {
-        dev_tex->load(m_disassembler->imageFilenamesOfLoad().value()[0], "");
+        dev_tex->load(contenting.m_disassembler->imageFilenamesOfLoad().value()[0], "");
     }
 }
 
-void TextureLoader::createEmptyResourceTextures(const std::shared_ptr<Graphics::ITexture>& dev_tex)
+void TextureLoader::createEmptyResourceTextures(const ContentingTexture& contenting, const std::shared_ptr<Graphics::ITexture>& dev_tex)
 {
-    assert(m_contentingTexture);
-    assert(m_contentingTexture->lazyStatus().isLoading());
+    assert(contenting.m_texture->lazyStatus().isLoading());
     assert(dev_tex);
-    assert(m_disassembler);
-    assert(m_disassembler->dimensionOfCreation());
-    if (m_contentingTexture->isMultiTexture())
+    assert(contenting.m_disassembler);
+    assert(contenting.m_disassembler->dimensionOfCreation());
+    if (contenting.m_texture->isMultiTexture())
     {
         std::vector<byte_buffer> buffers;
-        buffers.resize(m_disassembler->surfaceCount());
-        std::dynamic_pointer_cast<IMultiTexture>(dev_tex)->multiCreate(m_disassembler->dimensionOfCreation().value(), m_disassembler->surfaceCount(), buffers);
+        buffers.resize(contenting.m_disassembler->surfaceCount());
+        std::dynamic_pointer_cast<IMultiTexture>(dev_tex)->multiCreate(contenting.m_disassembler->dimensionOfCreation().value(), contenting.m_disassembler->surfaceCount(), buffers);
     }
     else
     {
-        dev_tex->create(m_disassembler->dimensionOfCreation().value(), byte_buffer{});
+        dev_tex->create(contenting.m_disassembler->dimensionOfCreation().value(), byte_buffer{});
     }
 }
 
 void TextureLoader::onDeviceTextureCreated(const IEventPtr& e)
 {
-    if (!m_contentingTexture) return;
     if (!e) return;
     std::string tex_name;
     if (auto ev = std::dynamic_pointer_cast<DeviceTextureCreated, IEvent>(e))
@@ -117,22 +172,30 @@ void TextureLoader::onDeviceTextureCreated(const IEventPtr& e)
         tex_name = ev->textureName();
     }
     else return;
-    if (tex_name != m_contentingTexture->id().name()) return;
+    auto contenting = findContentingTexture(tex_name);
+    if (!contenting) return;
 
     auto texture = IGraphicAPI::instance()->TryFindGraphicAsset<ITexturePtr>(tex_name);
     if (!texture)
     {
         Platforms::Debug::Printf("can't get texture asset %s", tex_name.c_str());
-        failLoadingImage(ErrorCode::findStashedAssetFail);
+        failLoadingImage(tex_name, ErrorCode::findStashedAssetFail);
         return;
     }
-    if ((m_disassembler->imageFilenamesOfLoad()) && (!m_disassembler->imageFilenamesOfLoad()->empty()))
+    if ((contenting->m_disassembler->imageFilenamesOfLoad()) && (!contenting->m_disassembler->imageFilenamesOfLoad()->empty()))
     {
-        loadResourceTextures(texture.value());
+        if (canStreamTexture(contenting.value()))
+        {
+            decodeStreamingImage(contenting.value(), texture.value());
+        }
+        else
+        {
+            loadResourceTextures(contenting.value(), texture.value());
+        }
     }
-    else if (m_disassembler->dimensionOfCreation())
+    else if (contenting->m_disassembler->dimensionOfCreation())
     {
-        createEmptyResourceTextures(texture.value());
+        createEmptyResourceTextures(contenting.value(), texture.value());
     }
     else
     {
@@ -140,39 +203,71 @@ void TextureLoader::onDeviceTextureCreated(const IEventPtr& e)
     }
 }
 
-void TextureLoader::onTextureImageLoaded(const Enigma::Frameworks::IEventPtr& e)
+void TextureLoader::onTextureImageDecoded(const Enigma::Frameworks::IEventPtr& e)
 {
-    if (!m_contentingTexture) return;
     if (!e) return;
-    auto ev = std::dynamic_pointer_cast<Graphics::TextureResourceImageLoaded, Frameworks::IEvent>(e);
+    auto ev = std::dynamic_pointer_cast<TextureImageDecoded, Frameworks::IEvent>(e);
     if (!ev) return;
-    if (ev->textureName() != m_contentingTexture->id().name()) return;
-    Graphics::ITexturePtr dev_tex = Graphics::IGraphicAPI::instance()->GetGraphicAsset<Graphics::ITexturePtr>(m_contentingTexture->id().name());
+    auto contenting = findContentingTexture(ev->textureName());
+    if ((!contenting) || (!contenting->m_decoded) || (!contenting->m_decoded->m_chain)) return;
+    Graphics::ITexturePtr dev_tex = Graphics::IGraphicAPI::instance()->GetGraphicAsset<Graphics::ITexturePtr>(ev->textureName());
     if (!dev_tex)
     {
-        Platforms::Debug::Printf("can't get texture asset %s", ev->textureName().c_str());
-        failLoadingImage(ErrorCode::findStashedAssetFail);
+        failLoadingImage(ev->textureName(), ErrorCode::findStashedAssetFail);
         return;
     }
-    m_contentingTexture->instanceDeviceTexture(dev_tex);
-    Frameworks::EventPublisher::enqueue(std::make_shared<TextureLoaded>(m_contentingTexture->id(), m_contentingTexture));
-    m_contentingTexture = nullptr;
+    // 先上傳 mip tail, texture 馬上可以用, 精細的 level 之後由 streamer 補上
+    const TextureMipChain& chain = contenting->m_decoded->m_chain.value();
+    const auto& tail = chain.level(chain.tailLevel(m_streamer->config().m_tailExtent));
+    dev_tex->create(tail.m_dimension, tail.m_pixels);
+}
+
+void TextureLoader::onDecodeTextureImageFailed(const Enigma::Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<DecodeTextureImageFailed, Frameworks::IEvent>(e);
+    if (!ev) return;
+    auto contenting = findContentingTexture(ev->textureName());
+    if (!contenting) return;
+    if (ev->error() == Graphics::ErrorCode::notImplement)
+    {
+        // device 不支援 cpu decode (或 cube texture), 回到原本由 device 載入的路徑
+        {
+            std::lock_guard locker{ m_contentingLock };
+            if (auto it = m_contentingTextures.find(ev->textureName()); it != m_contentingTextures.end()) it->second.m_decoded = nullptr;
+        }
+        Graphics::ITexturePtr dev_tex = Graphics::IGraphicAPI::instance()->GetGraphicAsset<Graphics::ITexturePtr>(ev->textureName());
+        if (dev_tex)
+        {
+            loadResourceTextures(contenting.value(), dev_tex);
+            return;
+        }
+    }
+    Platforms::Debug::Printf("texture %s decode image failed", ev->textureName().c_str());
+    failLoadingImage(ev->textureName(), ev->error());
+}
+
+void TextureLoader::onTextureImageLoaded(const Enigma::Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<Graphics::TextureResourceImageLoaded, Frameworks::IEvent>(e);
+    if (!ev) return;
+    completeLoadingImage(ev->textureName());
 }
 
 void TextureLoader::onTextureLoadImageFailed(const Enigma::Frameworks::IEventPtr& e)
 {
-    if (!m_contentingTexture) return;
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<Graphics::TextureResourceLoadImageFailed, Frameworks::IEvent>(e);
     if (!ev) return;
-    if (ev->textureName() != m_contentingTexture->id().name()) return;
-    Platforms::Debug::Printf("texture %s load image %s failed", m_contentingTexture->id().name().c_str(), m_disassembler->filePaths()[0].c_str());
-    failLoadingImage(ev->error());
+    auto contenting = findContentingTexture(ev->textureName());
+    if (!contenting) return;
+    Platforms::Debug::Printf("texture %s load image %s failed", ev->textureName().c_str(), contenting->m_disassembler->filePaths()[0].c_str());
+    failLoadingImage(ev->textureName(), ev->error());
 }
 
 void TextureLoader::onTextureResourceCreated(const Enigma::Frameworks::IEventPtr& e)
 {
-    if (!m_contentingTexture) return;
     if (!e) return;
     std::string tex_name;
     if (auto ev = std::dynamic_pointer_cast<Graphics::TextureResourceFromMemoryCreated, Frameworks::IEvent>(e))
@@ -184,33 +279,57 @@ void TextureLoader::onTextureResourceCreated(const Enigma::Frameworks::IEventPtr
         tex_name = ev->textureName();
     }
     else return;
-    if (tex_name != m_contentingTexture->id().name()) return;
-    Graphics::ITexturePtr dev_tex = Graphics::IGraphicAPI::instance()->GetGraphicAsset<Graphics::ITexturePtr>(m_contentingTexture->id().name());
-    if (!dev_tex)
-    {
-        Platforms::Debug::Printf("can't get texture asset %s", tex_name.c_str());
-        failLoadingImage(ErrorCode::findStashedAssetFail);
-        return;
-    }
-    m_contentingTexture->instanceDeviceTexture(dev_tex);
-    Frameworks::EventPublisher::enqueue(std::make_shared<TextureLoaded>(m_contentingTexture->id(), m_contentingTexture));
-    m_contentingTexture = nullptr;
+    completeLoadingImage(tex_name);
 }
 
 void TextureLoader::onTextureCreateResourceFailed(const Enigma::Frameworks::IEventPtr& e)
 {
-    if (!m_contentingTexture) return;
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<Graphics::TextureResourceCreateFromMemoryFailed, Frameworks::IEvent>(e);
     if (!ev) return;
-    if (ev->textureName() != m_contentingTexture->id().name()) return;
-    Platforms::Debug::Printf("texture %s create from memory failed", m_contentingTexture->id().name().c_str());
-    failLoadingImage(ev->error());
+    if (!findContentingTexture(ev->textureName())) return;
+    Platforms::Debug::Printf("texture %s create from memory failed", ev->textureName().c_str());
+    failLoadingImage(ev->textureName(), ev->error());
 }
 
-void TextureLoader::failLoadingImage(std::error_code er)
+void TextureLoader::completeLoadingImage(const std::string& name)
 {
-    assert(m_contentingTexture);
-    EventPublisher::enqueue(std::make_shared<LoadTextureFailed>(m_contentingTexture->id(), er));
-    m_contentingTexture = nullptr;
+    ContentingTexture contenting;
+    {
+        std::lock_guard locker{ m_contentingLock };
+        auto it = m_contentingTextures.find(name);
+        if (it == m_contentingTextures.end()) return;
+        // streaming decode 中 device texture 還沒有內容, 不是這次的完成事件
+        if ((it->second.m_decoded) && (!it->second.m_decoded->m_chain)) return;
+        contenting = std::move(it->second);
+        m_contentingTextures.erase(it);
+    }
+    Graphics::ITexturePtr dev_tex = Graphics::IGraphicAPI::instance()->GetGraphicAsset<Graphics::ITexturePtr>(name);
+    if (!dev_tex)
+    {
+        Platforms::Debug::Printf("can't get texture asset %s", name.c_str());
+        EventPublisher::enqueue(std::make_shared<LoadTextureFailed>(contenting.m_texture->id(), ErrorCode::findStashedAssetFail));
+        return;
+    }
+    contenting.m_texture->instanceDeviceTexture(dev_tex);
+    if ((contenting.m_decoded) && (m_streamer))
+    {
+        TextureMipChain& chain = contenting.m_decoded->m_chain.value();
+        const unsigned tail_level = chain.tailLevel(m_streamer->config().m_tailExtent);
+        m_streamer->registerTexture(contenting.m_texture, dev_tex, contenting.m_disassembler->imageFilenamesOfLoad().value()[0], std::move(chain), tail_level);
+    }
+    Frameworks::EventPublisher::enqueue(std::make_shared<TextureLoaded>(contenting.m_texture->id(), contenting.m_texture));
+}
+
+void TextureLoader::failLoadingImage(const std::string& name, std::error_code er)
+{
+    std::shared_ptr<Texture> texture;
+    {
+        std::lock_guard locker{ m_contentingLock };
+        auto it = m_contentingTextures.find(name);
+        if (it == m_contentingTextures.end()) return;
+        texture = it->second.m_texture;
+        m_contentingTextures.erase(it);
+    }
+    EventPublisher::enqueue(std::make_shared<LoadTextureFailed>(texture->id(), er));
 }
@@ -11,13 +11,42 @@
 #include "Frameworks/EventSubscriber.h"
 #include "Texture.h"
 #include "TextureAssembler.h"
+#include "TextureMipChain.h"
 #include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <optional>
 
 namespace Enigma::Engine
 {
     class TextureRepository;
+    class TextureStreamer;
+
+    //! ADR : 同時可以有多個 texture 在載入中, 各自用 texture name 對應 device 事件;
+    //!  有 streamer 時, 單張 image 的 texture 在 worker thread 上 decode, 先上傳 mip tail, 之後交給 streamer
     class TextureLoader
     {
+    private:
+        /** inner events, posted from worker threads */
+        class TextureImageDecoded : public Frameworks::IEvent
+        {
+        public:
+            TextureImageDecoded(const std::string& name) : m_name(name) {};
+            const std::string& textureName() const { return m_name; }
+        private:
+            std::string m_name;
+        };
+        class DecodeTextureImageFailed : public Frameworks::IEvent
+        {
+        public:
+            DecodeTextureImageFailed(const std::string& name, std::error_code er) : m_name(name), m_error(er) {};
+            const std::string& textureName() const { return m_name; }
+            std::error_code error() const { return m_error; }
+        private:
+            std::string m_name;
+            std::error_code m_error;
+        };
+
     public:
         class TextureLoaded : public Frameworks::IEvent
         {
@@ -51,20 +80,41 @@ namespace Enigma::Engine
 
         void loadImage(const std::shared_ptr<Texture>& texture, const std::shared_ptr<TextureDisassembler>& disassembler);
 
+        void textureStreamer(const std::shared_ptr<TextureStreamer>& streamer) { m_streamer = streamer; }
+
     private:
         void onDeviceTextureCreated(const Enigma::Frameworks::IEventPtr& e);
         void onTextureImageLoaded(const Enigma::Frameworks::IEventPtr& e);
         void onTextureLoadImageFailed(const Enigma::Frameworks::IEventPtr& e);
         void onTextureResourceCreated(const Enigma::Frameworks::IEventPtr& e);
         void onTextureCreateResourceFailed(const Enigma::Frameworks::IEventPtr& e);
+        void onTextureImageDecoded(const Enigma::Frameworks::IEventPtr& e);
+        void onDecodeTextureImageFailed(const Enigma::Frameworks::IEventPtr& e);
+
+        struct DecodedImage
+        {
+            std::error_code m_error;
+            std::optional<TextureMipChain> m_chain;
+        };
+        struct ContentingTexture
+        {
+            std::shared_ptr<Texture> m_texture;
+            std::shared_ptr<TextureDisassembler> m_disassembler;
+            std::shared_ptr<DecodedImage> m_decoded;  ///< 只有 streaming decode 才有
+        };
 
-        void loadResourceTextures(const std::shared_ptr<Graphics::ITexture>& dev_tex);
-        void createEmptyResourceTextures(const std::shared_ptr<Graphics::ITexture>& dev_tex);
+        std::optional<ContentingTexture> findContentingTexture(const std::string& name);
+        bool canStreamTexture(const ContentingTexture& contenting) const;
+        void decodeStreamingImage(const ContentingTexture& contenting, const std::shared_ptr<Graphics::ITexture>& dev_tex);
+        void loadResourceTextures(const ContentingTexture& contenting, const std::shared_ptr<Graphics::ITexture>& dev_tex);
+        void createEmptyResourceTextures(const ContentingTexture& contenting, const std::shared_ptr<Graphics::ITexture>& dev_tex);
+        void completeLoadingImage(const std::string& name);
 
-        void failLoadingImage(std::error_code er);
+        void failLoadingImage(const std::string& name, std::error_code er);
     private:
-        std::shared_ptr<TextureDisassembler> m_disassembler;
-        std::shared_ptr<Texture> m_contentingTexture;
+        std::unordered_map<std::string, ContentingTexture> m_contentingTextures;
+        std::recursive_mutex m_contentingLock;
+        std::shared_ptr<TextureStreamer> m_streamer;
 
         Enigma::Frameworks::EventSubscriberPtr m_onTextureCreated;
         Enigma::Frameworks::EventSubscriberPtr m_onMultiTextureCreated;
@@ -73,6 +123,8 @@ namespace Enigma::Engine
         Enigma::Frameworks::EventSubscriberPtr m_onTextureResourceCreated;
         Enigma::Frameworks::EventSubscriberPtr m_onMultiTextureResourceCreated;
         Enigma::Frameworks::EventSubscriberPtr m_onTextureCreateResourceFailed;
+        Enigma::Frameworks::EventSubscriberPtr m_onTextureImageDecoded;
+        Enigma::Frameworks::EventSubscriberPtr m_onDecodeTextureImageFailed;
     };
 }
 
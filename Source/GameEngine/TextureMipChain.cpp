@@ -0,0 +1,89 @@
+﻿#include "TextureMipChain.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::Engine;
+
+static constexpr unsigned PIXEL_BYTES = 4;
+
+TextureMipChain::TextureMipChain(const MathLib::Dimension<unsigned>& dimension, byte_buffer&& rgba_pixels)
+{
+    assert(rgba_pixels.size() == static_cast<size_t>(dimension.m_width) * dimension.m_height * PIXEL_BYTES);
+    const unsigned count = levelCountOf(dimension);
+    m_levels.resize(count);
+    m_levels[0].m_dimension = dimension;
+    m_levels[0].m_pixels = std::move(rgba_pixels);
+    for (unsigned i = 1; i < count; i++)
+    {
+        downsample(m_levels[i - 1], m_levels[i]);
+    }
+}
+
+unsigned TextureMipChain::tailLevel(unsigned max_extent) const
+{
+    for (unsigned i = 0; i < m_levels.size(); i++)
+    {
+        const auto& dim = m_levels[i].m_dimension;
+        if (std::max(dim.m_width, dim.m_height) <= max_extent) return i;
+    }
+    return m_levels.empty() ? 0 : levelCount() - 1;
+}
+
+void TextureMipChain::releaseFinerLevels(unsigned keep_from)
+{
+    for (unsigned i = 0; (i < keep_from) && (i < m_levels.size()); i++)
+    {
+        byte_buffer().swap(m_levels[i].m_pixels);
+    }
+}
+
+Enigma::MathLib::Dimension<unsigned> TextureMipChain::levelDimension(const MathLib::Dimension<unsigned>& dimension, unsigned level)
+{
+    return MathLib::Dimension<unsigned>{ std::max(1u, dimension.m_width >> level), std::max(1u, dimension.m_height >> level) };
+}
+
+unsigned TextureMipChain::levelCountOf(const MathLib::Dimension<unsigned>& dimension)
+{
+    unsigned count = 1;
+    unsigned extent = std::max(dimension.m_width, dimension.m_height);
+    while (extent > 1)
+    {
+        extent >>= 1;
+        count++;
+    }
+    return count;
+}
+
+size_t TextureMipChain::levelBytes(const MathLib::Dimension<unsigned>& dimension, unsigned level)
+{
+    const auto dim = levelDimension(dimension, level);
+    return static_cast<size_t>(dim.m_width) * dim.m_height * PIXEL_BYTES;
+}
+
+void TextureMipChain::downsample(const MipLevel& src, MipLevel& dst)
+{
+    const unsigned src_w = src.m_dimension.m_width;
+    const unsigned src_h = src.m_dimension.m_height;
+    dst.m_dimension = MathLib::Dimension<unsigned>{ std::max(1u, src_w >> 1), std::max(1u, src_h >> 1) };
+    dst.m_pixels.resize(static_cast<size_t>(dst.m_dimension.m_width) * dst.m_dimension.m_height * PIXEL_BYTES);
+    // 奇數邊 (或已經是 1 的邊) 夾在最後一個 pixel
+    for (unsigned y = 0; y < dst.m_dimension.m_height; y++)
+    {
+        const unsigned y0 = std::min(y * 2, src_h - 1);
+        const unsigned y1 = std::min(y * 2 + 1, src_h - 1);
+        for (unsigned x = 0; x < dst.m_dimension.m_width; x++)
+        {
+            const unsigned x0 = std::min(x * 2, src_w - 1);
+            const unsigned x1 = std::min(x * 2 + 1, src_w - 1);
+            const unsigned char* p00 = &src.m_pixels[(static_cast<size_t>(y0) * src_w + x0) * PIXEL_BYTES];
+            const unsigned char* p01 = &src.m_pixels[(static_cast<size_t>(y0) * src_w + x1) * PIXEL_BYTES];
+            const unsigned char* p10 = &src.m_pixels[(static_cast<size_t>(y1) * src_w + x0) * PIXEL_BYTES];
+            const unsigned char* p11 = &src.m_pixels[(static_cast<size_t>(y1) * src_w + x1) * PIXEL_BYTES];
+            unsigned char* d = &dst.m_pixels[(static_cast<size_t>(y) * dst.m_dimension.m_width + x) * PIXEL_BYTES];
+            for (unsigned c = 0; c < PIXEL_BYTES; c++)
+            {
+                d[c] = static_cast<unsigned char>((p00[c] + p01[c] + p10[c] + p11[c] + 2) >> 2);
+            }
+        }
+    }
+}
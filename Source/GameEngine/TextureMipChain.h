@@ -0,0 +1,52 @@
+﻿/*********************************************************************
+ * \file   TextureMipChain.h
+ * \brief  cpu side RGBA8 mip chain, for texture streaming
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TEXTURE_MIP_CHAIN_H
+#define TEXTURE_MIP_CHAIN_H
+
+#include "MathLib/AlgebraBasicTypes.h"
+#include "Frameworks/ExtentTypesDefine.h"
+#include <vector>
+
+namespace Enigma::Engine
+{
+    class TextureMipChain
+    {
+    public:
+        struct MipLevel
+        {
+            MathLib::Dimension<unsigned> m_dimension;
+            byte_buffer m_pixels;
+        };
+
+    public:
+        TextureMipChain() = default;
+        /** 以 2x2 box filter 產生到 1x1 為止的所有 level, level 0 是原圖 */
+        TextureMipChain(const MathLib::Dimension<unsigned>& dimension, byte_buffer&& rgba_pixels);
+
+        unsigned levelCount() const { return static_cast<unsigned>(m_levels.size()); }
+        bool hasLevel(unsigned level) const { return (level < m_levels.size()) && (!m_levels[level].m_pixels.empty()); }
+        const MipLevel& level(unsigned level) const { return m_levels[level]; }
+        /** 最大邊不超過 max_extent 的第一個 level (mip tail 的起點) */
+        unsigned tailLevel(unsigned max_extent) const;
+
+        /** 只保留 [keep_from, levelCount) 的像素, 較精細的 level 釋放掉 */
+        void releaseFinerLevels(unsigned keep_from);
+
+        static MathLib::Dimension<unsigned> levelDimension(const MathLib::Dimension<unsigned>& dimension, unsigned level);
+        static unsigned levelCountOf(const MathLib::Dimension<unsigned>& dimension);
+        static size_t levelBytes(const MathLib::Dimension<unsigned>& dimension, unsigned level);
+
+    protected:
+        static void downsample(const MipLevel& src, MipLevel& dst);
+
+    protected:
+        std::vector<MipLevel> m_levels;
+    };
+}
+
+#endif // TEXTURE_MIP_CHAIN_H
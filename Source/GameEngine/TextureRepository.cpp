@@ -9,6 +9,7 @@
 #include "Frameworks/EventPublisher.h"
 #include "Frameworks/CommandBus.h"
 #include "Frameworks/QueryDispatcher.h"
+#include "Frameworks/AssetRetentionCache.h"
 #include "TextureQueries.h"
 #include "Platforms/PlatformLayer.h"
 #include <cassert>
@@ -17,10 +18,15 @@ using namespace Enigma::Engine;
 
 DEFINE_RTTI(Engine, TextureRepository, ISystemService);
 
+static const std::string RETENTION_CATEGORY = "texture";
+/// image 還沒載入時不知道大小, 先用這個值, 之後再 query 到時更新
+static constexpr size_t UNLOADED_TEXTURE_RETENTION_BYTES = 4096;
+
 TextureRepository::TextureRepository(Frameworks::ServiceManager* srv_manager, const std::shared_ptr<TextureStoreMapper>& store_mapper) : ISystemService(srv_manager), m_storeMapper(store_mapper)
 {
     m_factory = menew TextureFactory();
     m_needTick = false;
+    m_tickPriority = Frameworks::ServicePriority::Background;
     registerHandlers();
 }
 
@@ -41,14 +47,31 @@ Enigma::Frameworks::ServiceResult TextureRepository::onInit()
 Enigma::Frameworks::ServiceResult TextureRepository::onTerm()
 {
     assert(m_storeMapper);
+    if (m_retentionCache) m_retentionCache->releaseCategory(RETENTION_CATEGORY);
     dumpRetainedTexture();
     m_storeMapper->disconnect();
 
     m_textures.clear();
+    if (m_streamer) m_factory->textureStreamer(nullptr);
+    m_streamer = nullptr;
 
     return Frameworks::ServiceResult::Complete;
 }
 
+Enigma::Frameworks::ServiceResult TextureRepository::onTick()
+{
+    if (m_streamer) m_streamer->update(timeSliceDeadline());
+    return Frameworks::ServiceResult::Pendding;
+}
+
+void TextureRepository::enableStreaming(const std::shared_ptr<Frameworks::WorkerThreadPool>& workers, const TextureStreamer::Config& config)
+{
+    assert(m_factory);
+    m_streamer = std::make_shared<TextureStreamer>(workers, config);
+    m_factory->textureStreamer(m_streamer);
+    m_needTick = true;
+}
+
 void TextureRepository::registerHandlers()
 {
     m_removeTexture = std::make_shared<Frameworks::CommandSubscriber>([=](const Frameworks::ICommandPtr& c) { removeTexture(c); });
@@ -89,13 +112,29 @@ std::shared_ptr<Texture> TextureRepository::queryTexture(const TextureId& id)
     if (!hasTexture(id)) return nullptr;
     std::lock_guard locker{ m_textureMapLock };
     auto it = m_textures.find(id);
-    if ((it != m_textures.end()) && (!it->second.expired())) return it->second.lock();
+    if (it != m_textures.end())
+    {
+        if (auto tex = it->second.lock())
+        {
+            if (m_retentionCache)
+            {
+                m_retentionCache->recordHit(RETENTION_CATEGORY);
+                retainTexture(id, tex);
+            }
+            return tex;
+        }
+    }
     assert(m_factory);
     const auto dto = m_storeMapper->queryTexture(id);
     assert(dto.has_value());
     auto tex = m_factory->constitute(id, dto.value(), true);
     assert(tex);
     m_textures.insert_or_assign(id, tex);
+    if (m_retentionCache)
+    {
+        m_retentionCache->recordMiss(RETENTION_CATEGORY);
+        retainTexture(id, tex);
+    }
     return tex;
 }
 
@@ -104,6 +143,7 @@ void TextureRepository::removeTexture(const TextureId& id)
     if (!hasTexture(id)) return;
     std::lock_guard locker{ m_textureMapLock };
     m_textures.erase(id);
+    if (m_retentionCache) m_retentionCache->release(RETENTION_CATEGORY, id.name());
     error er = m_storeMapper->removeTexture(id);
     if (er)
     {
@@ -175,6 +215,15 @@ void TextureRepository::requestTextureConstitution(const Frameworks::IQueryPtr&
     m_textures.insert_or_assign(request->id(), tex);
 }
 
+void TextureRepository::retainTexture(const TextureId& id, const std::shared_ptr<Texture>& texture)
+{
+    if ((!m_retentionCache) || (!texture)) return;
+    // 每次都 retain (不只 touch), image 載入後大小才會更新
+    const auto& dimension = texture->dimension();
+    const size_t bytes = static_cast<size_t>(dimension.m_width) * dimension.m_height * 4;
+    m_retentionCache->retain(RETENTION_CATEGORY, id.name(), texture, bytes > 0 ? bytes : UNLOADED_TEXTURE_RETENTION_BYTES);
+}
+
 void TextureRepository::dumpRetainedTexture()
 {
     Platforms::Debug::Printf("dump retained texture\n");
@@ -14,8 +14,15 @@
 #include "Frameworks/CommandSubscriber.h"
 #include "Frameworks/QuerySubscriber.h"
 #include "TextureId.h"
+#include "TextureStreamer.h"
 #include <unordered_map>
 
+namespace Enigma::Frameworks
+{
+    class AssetRetentionCache;
+    class WorkerThreadPool;
+}
+
 namespace Enigma::Engine
 {
     using error = std::error_code;
@@ -38,6 +45,13 @@ namespace Enigma::Engine
 
         virtual Frameworks::ServiceResult onInit() override;
         virtual Frameworks::ServiceResult onTerm() override;
+        virtual Frameworks::ServiceResult onTick() override;
+
+        /** optional, loaded textures are retained in cache (by dimension) after all owners released */
+        void retentionCache(const std::shared_ptr<Frameworks::AssetRetentionCache>& cache) { m_retentionCache = cache; }
+        /** optional, image textures are decoded on workers, mip tail uploaded first, then streamed by distance within memory budget */
+        void enableStreaming(const std::shared_ptr<Frameworks::WorkerThreadPool>& workers, const TextureStreamer::Config& config);
+        const std::shared_ptr<TextureStreamer>& textureStreamer() const { return m_streamer; }
 
         bool hasTexture(const TextureId& id);
         std::shared_ptr<Texture> queryTexture(const TextureId& id);
@@ -53,6 +67,7 @@ namespace Enigma::Engine
         void queryTexture(const Frameworks::IQueryPtr& q);
         void requestTextureConstitution(const Frameworks::IQueryPtr& q);
 
+        void retainTexture(const TextureId& id, const std::shared_ptr<Texture>& texture);
         void dumpRetainedTexture();
 
     private:
@@ -69,6 +84,8 @@ namespace Enigma::Engine
         using TextureMap = std::unordered_map<TextureId, std::weak_ptr<Texture>, TextureId::hash>;
         TextureMap m_textures;
         std::recursive_mutex m_textureMapLock;
+        std::shared_ptr<Frameworks::AssetRetentionCache> m_retentionCache;
+        std::shared_ptr<TextureStreamer> m_streamer;
     };
 }
 
@@ -8,7 +8,11 @@ using namespace Enigma::Engine;
 error TextureRepositoryInstallingPolicy::install(Frameworks::ServiceManager* service_manager)
 {
     assert(service_manager);
-    service_manager->registerSystemService(std::make_shared<TextureRepository>(service_manager, m_storeMapper));
+    auto repository = std::make_shared<TextureRepository>(service_manager, m_storeMapper);
+    // image 要在 worker 上 decode, 沒有 pool 時維持原本的同步載入
+    if (auto workers = service_manager->workerThreadPool()) repository->enableStreaming(workers, m_streamingConfig);
+    if (auto cache = service_manager->assetRetentionCache()) repository->retentionCache(cache);
+    service_manager->registerSystemService(repository);
     return ErrorCode::ok;
 }
 
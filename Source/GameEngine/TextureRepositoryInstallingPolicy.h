@@ -9,6 +9,7 @@
 #define TEXTURE_REPOSITORY_INSTALLING_POLICY_H
 
 #include "InstallingPolicy.h"
+#include "TextureStreamer.h"
 
 namespace Enigma::Engine
 {
@@ -17,13 +18,16 @@ namespace Enigma::Engine
     class TextureRepositoryInstallingPolicy : public InstallingPolicy
     {
     public:
-        TextureRepositoryInstallingPolicy(const std::shared_ptr<TextureStoreMapper>& store_mapper) : m_storeMapper(store_mapper) {}
+        /** service manager 有 worker pool 時, 用 streaming_config 開啟 texture streaming */
+        TextureRepositoryInstallingPolicy(const std::shared_ptr<TextureStoreMapper>& store_mapper,
+            const TextureStreamer::Config& streaming_config = TextureStreamer::Config{}) : m_storeMapper(store_mapper), m_streamingConfig(streaming_config) {}
 
         virtual error install(Frameworks::ServiceManager* service_manager) override;
         virtual error shutdown(Frameworks::ServiceManager* service_manager) override;
 
     protected:
         std::shared_ptr<TextureStoreMapper> m_storeMapper;
+        TextureStreamer::Config m_streamingConfig;
     };
 }
 
@@ -2,6 +2,7 @@
 #include "TextureLoader.h"
 #include "TextureSaver.h"
 #include "TextureImageUpdater.h"
+#include "TextureStreamer.h"
 #include "Platforms/MemoryMacro.h"
 #include "Frameworks/EventPublisher.h"
 #include "Frameworks/CommandBus.h"
@@ -10,10 +11,11 @@
 #include "TextureEvents.h"
 #include "TextureCommands.h"
 #include "Platforms/PlatformLayer.h"
+#include <algorithm>
 
 using namespace Enigma::Engine;
 
-TextureResourceProcessor::TextureResourceProcessor()
+TextureResourceProcessor::TextureResourceProcessor() : m_maxHydratingTextures(1)
 {
     m_loader = menew TextureLoader();
     m_saver = menew TextureSaver();
@@ -77,22 +79,27 @@ std::error_code TextureResourceProcessor::enqueueHydratingDisassembler(const std
 
 std::error_code TextureResourceProcessor::hydrateNextTextureResource()
 {
-    if (m_currentHydratingTexture) return ErrorCode::ok;
     assert(m_loader);
     std::lock_guard locker{ m_hydratingQueueLock };
-    if (m_hydratingQueue.empty())
+    while ((m_hydratingTextures.size() < m_maxHydratingTextures) && (!m_hydratingQueue.empty()))
     {
-        m_currentHydratingTexture = nullptr;
-        return ErrorCode::ok;
+        auto [texture, dto] = m_hydratingQueue.front();
+        m_hydratingQueue.pop();
+        m_hydratingTextures.insert_or_assign(texture->id().name(), texture);
+        texture->lazyStatus().changeStatus(Frameworks::LazyStatus::Status::Loading);
+        m_loader->loadImage(texture, dto);
     }
-    auto& [texture, dto] = m_hydratingQueue.front();
-    m_currentHydratingTexture = texture;
-    m_loader->loadImage(texture, dto);
-    texture->lazyStatus().changeStatus(Frameworks::LazyStatus::Status::Loading);
-    m_hydratingQueue.pop();
     return ErrorCode::ok;
 }
 
+void TextureResourceProcessor::textureStreamer(const std::shared_ptr<TextureStreamer>& streamer)
+{
+    assert(m_loader);
+    m_loader->textureStreamer(streamer);
+    std::lock_guard locker{ m_hydratingQueueLock };
+    m_maxHydratingTextures = streamer ? std::max(1u, streamer->config().m_maxInFlightTextures) : 1;
+}
+
 std::error_code TextureResourceProcessor::enqueueSavingTexture(const std::shared_ptr<Texture>& texture, const std::shared_ptr<FileSystem::IFile>& file)
 {
     assert(texture);
@@ -176,9 +183,11 @@ void TextureResourceProcessor::onLoaderTextureLoaded(const Frameworks::IEventPtr
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<TextureLoader::TextureLoaded>(e);
     if (!ev) return;
-    if (ev->id() != m_currentHydratingTexture->id()) return;
+    {
+        std::lock_guard locker{ m_hydratingQueueLock };
+        if (m_hydratingTextures.erase(ev->id().name()) == 0) return;
+    }
     Frameworks::EventPublisher::enqueue(std::make_shared<TextureHydrated>(ev->id(), ev->texture()));
-    m_currentHydratingTexture = nullptr;
     const auto er = hydrateNextTextureResource();
     assert(!er);
 }
@@ -189,9 +198,12 @@ void TextureResourceProcessor::onLoaderLoadTextureFailed(const Frameworks::IEven
     if (!e) return;
     auto ev = std::dynamic_pointer_cast<TextureLoader::LoadTextureFailed>(e);
     if (!ev) return;
+    {
+        std::lock_guard locker{ m_hydratingQueueLock };
+        if (m_hydratingTextures.erase(ev->id().name()) == 0) return;
+    }
     Platforms::Debug::ErrorPrintf("texture %s load failed : %s\n", ev->id().name().c_str(), ev->error().message().c_str());
     Frameworks::EventPublisher::enqueue(std::make_shared<HydrateTextureFailed>(ev->id(), ev->error()));
-    m_currentHydratingTexture = nullptr;
     const auto er = hydrateNextTextureResource();
     assert(!er);
 }
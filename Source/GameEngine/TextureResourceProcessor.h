@@ -19,6 +19,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <unordered_map>
 
 namespace Enigma::Engine
 {
@@ -26,6 +27,7 @@ namespace Enigma::Engine
     class TextureLoader;
     class TextureSaver;
     class TextureImageUpdater;
+    class TextureStreamer;
 
     class TextureResourceProcessor
     {
@@ -36,6 +38,9 @@ namespace Enigma::Engine
         std::error_code enqueueHydratingDisassembler(const std::shared_ptr<Texture>& texture, const std::shared_ptr<TextureDisassembler>& disassembler);
         std::error_code hydrateNextTextureResource();
 
+        /** 設定 streamer 後, 可以同時載入 config 的 in-flight 數量 */
+        void textureStreamer(const std::shared_ptr<TextureStreamer>& streamer);
+
         std::error_code enqueueSavingTexture(const std::shared_ptr<Texture>& texture, const std::shared_ptr<FileSystem::IFile>& file);
         std::error_code saveNextTextureResource();
 
@@ -65,7 +70,8 @@ namespace Enigma::Engine
         TextureImageUpdater* m_imageUpdater;
         std::queue<std::pair<std::shared_ptr<Texture>, std::shared_ptr<TextureDisassembler>>> m_hydratingQueue;
         std::recursive_mutex m_hydratingQueueLock;
-        std::shared_ptr<Texture> m_currentHydratingTexture;
+        std::unordered_map<std::string, std::shared_ptr<Texture>> m_hydratingTextures;
+        unsigned m_maxHydratingTextures;
 
         std::queue<std::pair<std::shared_ptr<Texture>, std::shared_ptr<FileSystem::IFile>>> m_savingQueue;
         std::recursive_mutex m_savingQueueLock;
@@ -0,0 +1,242 @@
+﻿#include "TextureStreamer.h"
+#include "Texture.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "FileSystem/FileSystem.h"
+#include "FileSystem/Filename.h"
+#include "GraphicKernel/GraphicErrors.h"
+#include "Platforms/PlatformLayer.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <cassert>
+
+using namespace Enigma::Engine;
+
+TextureStreamer::TextureStreamer(const std::shared_ptr<Frameworks::WorkerThreadPool>& workers, const Config& config)
+    : m_workers(workers), m_config(config), m_decodingCount(0)
+{
+    if (m_config.m_maxInFlightTextures == 0) m_config.m_maxInFlightTextures = 1;
+    if (m_config.m_tailExtent == 0) m_config.m_tailExtent = 1;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    m_textures.clear();
+}
+
+std::optional<TextureMipChain> TextureStreamer::decodeImageFile(const Graphics::ITexturePtr& dev_tex, const std::string& filename, std::error_code& er)
+{
+    assert(dev_tex);
+    FileSystem::Filename filename_at_path(filename, "");
+    FileSystem::IFilePtr file = FileSystem::FileSystem::instance()->openFile(filename_at_path.getSubPathFileName(), FileSystem::read | FileSystem::binary, filename_at_path.getMountPathId());
+    if (!file)
+    {
+        er = Graphics::ErrorCode::fileIO;
+        return std::nullopt;
+    }
+    const size_t file_size = file->size();
+    auto buff = file->read(0, file_size);
+    FileSystem::FileSystem::instance()->closeFile(file);
+    if ((!buff) || (buff->size() != file_size) || (file_size == 0))
+    {
+        er = Graphics::ErrorCode::fileIO;
+        return std::nullopt;
+    }
+    MathLib::Dimension<unsigned> dimension{ 0, 0 };
+    byte_buffer rgba;
+    er = dev_tex->decodeImage(buff.value(), dimension, rgba);
+    if (er) return std::nullopt;
+    return TextureMipChain(dimension, std::move(rgba));
+}
+
+void TextureStreamer::registerTexture(const std::shared_ptr<Texture>& texture, const Graphics::ITexturePtr& dev_tex,
+    const std::string& image_filename, TextureMipChain&& chain, unsigned resident_level)
+{
+    assert(texture);
+    assert(chain.levelCount() > 0);
+    std::lock_guard locker{ m_lock };
+    StreamingTexture st;
+    st.m_texture = texture;
+    st.m_deviceTexture = dev_tex;
+    st.m_imageFilename = image_filename;
+    st.m_dimension = chain.level(0).m_dimension;
+    st.m_tailLevel = chain.tailLevel(m_config.m_tailExtent);
+    st.m_residentLevel = resident_level;
+    st.m_distance = m_config.m_fullResolutionDistance;
+    st.m_chain = std::move(chain);
+    texture->streamer(weak_from_this());
+    // 重複登錄時, 舊的 resident bytes 要扣掉
+    if (auto it = m_textures.find(texture->id()); it != m_textures.end())
+    {
+        m_statistics.m_residentBytes -= residentBytesOf(it->second);
+    }
+    m_statistics.m_residentBytes += residentBytesOf(st);
+    m_textures.insert_or_assign(texture->id(), std::move(st));
+}
+
+void TextureStreamer::unregisterTexture(const TextureId& id)
+{
+    std::lock_guard locker{ m_lock };
+    auto it = m_textures.find(id);
+    if (it == m_textures.end()) return;
+    m_statistics.m_residentBytes -= residentBytesOf(it->second);
+    m_textures.erase(it);
+}
+
+void TextureStreamer::updatePriority(const TextureId& id, float camera_distance)
+{
+    std::lock_guard locker{ m_lock };
+    auto it = m_textures.find(id);
+    if (it == m_textures.end()) return;
+    auto& reported = it->second.m_reportedDistance;
+    if ((!reported) || (camera_distance < reported.value())) reported = camera_distance;
+}
+
+bool TextureStreamer::update(std::chrono::steady_clock::time_point deadline)
+{
+    std::lock_guard locker{ m_lock };
+    for (auto it = m_textures.begin(); it != m_textures.end();)
+    {
+        if ((it->second.m_texture.expired()) || (it->second.m_deviceTexture.expired()))
+        {
+            m_statistics.m_residentBytes -= residentBytesOf(it->second);
+            it = m_textures.erase(it);
+        }
+        else
+        {
+            if (it->second.m_reportedDistance)
+            {
+                it->second.m_distance = it->second.m_reportedDistance.value();
+                it->second.m_reportedDistance.reset();
+            }
+            ++it;
+        }
+    }
+
+    std::vector<std::pair<float, TextureId>> candidates;
+    for (auto& [id, st] : m_textures)
+    {
+        if ((!st.m_isDecoding) && (desiredLevel(st) < st.m_residentLevel)) candidates.emplace_back(st.m_distance, id);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    bool has_pending = m_decodingCount > 0;
+    unsigned uploads = 0;
+    for (auto& [distance, id] : candidates)
+    {
+        if ((uploads >= m_config.m_maxUploadsPerUpdate) || ((uploads > 0) && (std::chrono::steady_clock::now() >= deadline)))
+        {
+            has_pending = true;
+            break;
+        }
+        auto it = m_textures.find(id);
+        if (it == m_textures.end()) continue;
+        StreamingTexture& st = it->second;
+        // 放不下就退一級, 直到跟目前的 level 一樣
+        unsigned target = desiredLevel(st);
+        while (target < st.m_residentLevel)
+        {
+            const size_t needed = TextureMipChain::levelBytes(st.m_dimension, target) - residentBytesOf(st);
+            if (makeRoom(needed, st.m_distance)) break;
+            target++;
+        }
+        if (target >= st.m_residentLevel) continue;
+        if (!st.m_chain.hasLevel(target))
+        {
+            requestDecode(id, st);
+            has_pending = true;
+            continue;
+        }
+        uploadLevel(st, target);
+        uploads++;
+    }
+    return has_pending;
+}
+
+TextureStreamer::Statistics TextureStreamer::statistics()
+{
+    std::lock_guard locker{ m_lock };
+    m_statistics.m_streamingTextures = static_cast<unsigned>(m_textures.size());
+    return m_statistics;
+}
+
+unsigned TextureStreamer::desiredLevel(const StreamingTexture& st) const
+{
+    if ((m_config.m_fullResolutionDistance <= 0.0f) || (st.m_distance <= m_config.m_fullResolutionDistance)) return 0;
+    const unsigned level = static_cast<unsigned>(std::floor(std::log2(st.m_distance / m_config.m_fullResolutionDistance))) + 1;
+    return std::min(level, st.m_tailLevel);
+}
+
+size_t TextureStreamer::residentBytesOf(const StreamingTexture& st) const
+{
+    return TextureMipChain::levelBytes(st.m_dimension, st.m_residentLevel);
+}
+
+bool TextureStreamer::makeRoom(size_t bytes_needed, float requester_distance)
+{
+    if (m_statistics.m_residentBytes + bytes_needed <= m_config.m_memoryBudget) return true;
+    // 比 requester 遠, 而且比 mip tail 精細的 texture, 由遠到近退回 mip tail
+    std::vector<std::pair<float, StreamingTexture*>> victims;
+    for (auto& [id, st] : m_textures)
+    {
+        if ((st.m_distance > requester_distance) && (st.m_residentLevel < st.m_tailLevel)) victims.emplace_back(st.m_distance, &st);
+    }
+    std::sort(victims.begin(), victims.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (auto& [distance, victim] : victims)
+    {
+        if (m_statistics.m_residentBytes + bytes_needed <= m_config.m_memoryBudget) break;
+        uploadLevel(*victim, victim->m_tailLevel);
+        m_statistics.m_evictions++;
+    }
+    return m_statistics.m_residentBytes + bytes_needed <= m_config.m_memoryBudget;
+}
+
+void TextureStreamer::uploadLevel(StreamingTexture& st, unsigned level)
+{
+    assert(st.m_chain.hasLevel(level));
+    auto dev_tex = st.m_deviceTexture.lock();
+    if (!dev_tex) return;
+    const auto& mip = st.m_chain.level(level);
+    dev_tex->create(mip.m_dimension, mip.m_pixels);
+    m_statistics.m_residentBytes -= residentBytesOf(st);
+    st.m_residentLevel = level;
+    m_statistics.m_residentBytes += residentBytesOf(st);
+    m_statistics.m_uploads++;
+    // mip tail 一直留著 (eviction 用), 其他 level 上傳後就不需要了
+    st.m_chain.releaseFinerLevels(st.m_tailLevel);
+}
+
+void TextureStreamer::requestDecode(const TextureId& id, StreamingTexture& st)
+{
+    if ((st.m_isDecoding) || (st.m_imageFilename.empty())) return;
+    if (m_decodingCount >= m_config.m_maxInFlightTextures) return;
+    auto workers = m_workers.lock();
+    auto dev_tex = st.m_deviceTexture.lock();
+    if ((!workers) || (!dev_tex)) return;
+    st.m_isDecoding = true;
+    m_decodingCount++;
+    m_statistics.m_decodes++;
+    workers->pushTask([weak_self = weak_from_this(), id, dev_tex, filename = st.m_imageFilename]()
+        {
+            std::error_code er;
+            auto chain = decodeImageFile(dev_tex, filename, er);
+            if (er) Platforms::Debug::ErrorPrintf("texture %s stream decode failed : %s\n", id.name().c_str(), er.message().c_str());
+            if (auto self = weak_self.lock()) self->onDecodeFinished(id, std::move(chain));
+        });
+}
+
+void TextureStreamer::onDecodeFinished(const TextureId& id, std::optional<TextureMipChain>&& chain)
+{
+    std::lock_guard locker{ m_lock };
+    m_decodingCount--;
+    auto it = m_textures.find(id);
+    if (it == m_textures.end()) return;
+    it->second.m_isDecoding = false;
+    if (!chain)
+    {
+        it->second.m_imageFilename.clear();  // 不再重試, 停在目前的 level
+        return;
+    }
+    if (chain->level(0).m_dimension != it->second.m_dimension) return;  // 檔案換過了, 不混用
+    it->second.m_chain = std::move(chain.value());
+}
@@ -0,0 +1,114 @@
+﻿/*********************************************************************
+ * \file   TextureStreamer.h
+ * \brief  texture streaming, mip tail first, finer mips by camera distance
+ *          priority under a texture memory budget
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include "TextureId.h"
+#include "TextureMipChain.h"
+#include "GraphicKernel/ITexture.h"
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <chrono>
+
+namespace Enigma::Frameworks
+{
+    class WorkerThreadPool;
+}
+
+namespace Enigma::Engine
+{
+    class Texture;
+
+    //! ADR : image decode & mip 產生在 worker thread 上做, device 只收到 RGBA8 的單一 level (ITexture::create);
+    //!  loader 先上傳 mip tail 讓 texture 立即可用, 之後每個 tick 依距離由近到遠換成較精細的 level,
+    //!  超出預算時把最遠的 texture 退回 mip tail. 精細 level 上傳後就釋放, 需要時再從檔案 decode
+    class TextureStreamer : public std::enable_shared_from_this<TextureStreamer>
+    {
+    public:
+        struct Config
+        {
+            unsigned m_maxInFlightTextures = 4;  ///< loader 同時處理的 texture 數, 也是同時 decode 的上限
+            size_t m_memoryBudget = 256 * 1024 * 1024;
+            unsigned m_tailExtent = 64;  ///< mip tail 的最大邊長
+            float m_fullResolutionDistance = 10.0f;  ///< 這個距離內用 level 0, 距離每加倍降一個 level
+            unsigned m_maxUploadsPerUpdate = 2;
+        };
+        struct Statistics
+        {
+            size_t m_residentBytes = 0;
+            unsigned m_streamingTextures = 0;
+            unsigned m_uploads = 0;
+            unsigned m_evictions = 0;
+            unsigned m_decodes = 0;
+        };
+
+    public:
+        TextureStreamer(const std::shared_ptr<Frameworks::WorkerThreadPool>& workers, const Config& config);
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer(TextureStreamer&&) = delete;
+        ~TextureStreamer();
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(TextureStreamer&&) = delete;
+
+        const Config& config() const { return m_config; }
+        std::shared_ptr<Frameworks::WorkerThreadPool> workers() const { return m_workers.lock(); }
+
+        /** read & decode image file to a full mip chain, called on worker threads */
+        static std::optional<TextureMipChain> decodeImageFile(const Graphics::ITexturePtr& dev_tex, const std::string& filename, std::error_code& er);
+
+        /** loader 上傳 mip tail 後登錄, chain 可以還保有較精細的 level, 第一次 refine 不用再 decode */
+        void registerTexture(const std::shared_ptr<Texture>& texture, const Graphics::ITexturePtr& dev_tex,
+            const std::string& image_filename, TextureMipChain&& chain, unsigned resident_level);
+        void unregisterTexture(const TextureId& id);
+
+        /** priority hint, renderer 依照使用這個 texture 的物件與 camera 的距離回報 (Texture::streamingPriority),
+         兩次 update 之間取最近的距離; 沒有回報的 texture 保留上次的距離 */
+        void updatePriority(const TextureId& id, float camera_distance);
+
+        /** refine / evict under budget, call per tick; uploads stop at deadline (time slice of the tick),
+         return true if there is pending work */
+        bool update(std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+        Statistics statistics();
+
+    protected:
+        struct StreamingTexture
+        {
+            std::weak_ptr<Texture> m_texture;
+            Graphics::ITextureWeak m_deviceTexture;
+            std::string m_imageFilename;
+            MathLib::Dimension<unsigned> m_dimension;
+            unsigned m_tailLevel = 0;
+            unsigned m_residentLevel = 0;
+            float m_distance = 0.0f;
+            std::optional<float> m_reportedDistance;
+            TextureMipChain m_chain;
+            bool m_isDecoding = false;
+        };
+        unsigned desiredLevel(const StreamingTexture& st) const;
+        size_t residentBytesOf(const StreamingTexture& st) const;
+        bool makeRoom(size_t bytes_needed, float requester_distance);
+        void uploadLevel(StreamingTexture& st, unsigned level);
+        void requestDecode(const TextureId& id, StreamingTexture& st);
+        void onDecodeFinished(const TextureId& id, std::optional<TextureMipChain>&& chain);
+
+    protected:
+        std::weak_ptr<Frameworks::WorkerThreadPool> m_workers;
+        Config m_config;
+        std::unordered_map<TextureId, StreamingTexture, TextureId::hash> m_textures;
+        std::recursive_mutex m_lock;
+        unsigned m_decodingCount;
+        Statistics m_statistics;
+    };
+}
+
+#endif // TEXTURE_STREAMER_H
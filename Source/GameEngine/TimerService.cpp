@@ -9,6 +9,7 @@ DEFINE_RTTI(Engine, TimerService, ISystemService);
 TimerService::TimerService(ServiceManager* manager) : ISystemService(manager)
 {
     m_needTick = true;
+    declareWriteAccess(GAME_TIMER_RESOURCE);
     m_gameTimer = std::make_unique<Timer>();
     m_realLifeTimer = std::make_unique<Timer>();
 }
@@ -29,6 +30,7 @@ ServiceResult TimerService::onInit()
 
 ServiceResult TimerService::onTick()
 {
+    SERVICE_WRITE_ACCESS(GAME_TIMER_RESOURCE);
     if (m_gameTimer) m_gameTimer->update();
     if (m_realLifeTimer) m_realLifeTimer->update();
 
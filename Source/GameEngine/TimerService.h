@@ -10,6 +10,7 @@
 
 #include "Frameworks/SystemService.h"
 #include "Frameworks/Timer.h"
+#include "Frameworks/ServiceAccessChecker.h"
 #include <memory>
 
 namespace Enigma::Engine
@@ -17,6 +18,10 @@ namespace Enigma::Engine
     class TimerService : public Frameworks::ISystemService
     {
         DECLARE_EN_RTTI;
+    public:
+        /// concurrent tick 時宣告的資源名稱
+        static constexpr const char* GAME_TIMER_RESOURCE = "GameTimer";
+
     public:
         TimerService(Frameworks::ServiceManager* manager);
         TimerService(const TimerService&) = delete;
@@ -29,8 +34,8 @@ namespace Enigma::Engine
         virtual Frameworks::ServiceResult onTick() override;
         virtual Frameworks::ServiceResult onTerm() override;
 
-        const std::unique_ptr<Frameworks::Timer>& getGameTimer() { return m_gameTimer; };
-        const std::unique_ptr<Frameworks::Timer>& getRealLifeTimer() { return m_realLifeTimer; };
+        const std::unique_ptr<Frameworks::Timer>& getGameTimer() { SERVICE_READ_ACCESS(GAME_TIMER_RESOURCE); return m_gameTimer; };
+        const std::unique_ptr<Frameworks::Timer>& getRealLifeTimer() { SERVICE_READ_ACCESS(GAME_TIMER_RESOURCE); return m_realLifeTimer; };
 
         /// speed up : scale > 1.0, slow down : scale < 1.0, pause : scale = 0.0
         void setGameTimerScale(float scale);
@@ -13,7 +13,7 @@ using namespace Enigma::Gateways;
 using namespace Enigma::Engine;
 using namespace Enigma::FileSystem;
 
-AsyncJsonFileDtoDeserializer::AsyncJsonFileDtoDeserializer() : IDtoDeserializer(), m_ruid()
+AsyncJsonFileDtoDeserializer::AsyncJsonFileDtoDeserializer() : IDtoDeserializer()
 {
     m_gateway = std::make_shared<DtoJsonGateway>();
 }
@@ -21,32 +21,26 @@ AsyncJsonFileDtoDeserializer::AsyncJsonFileDtoDeserializer() : IDtoDeserializer(
 void AsyncJsonFileDtoDeserializer::invokeDeserialize(const Frameworks::Ruid& ruid_deserializing, const std::string& param)
 {
     Platforms::Debug::Printf("async invoke deserialize %s", param.c_str());
-    m_ruid = ruid_deserializing;
-    m_parameter = param;
-    m_deserializing = std::async(std::launch::async, [self = weak_from_this()]() // 抓給自己的 shared_ptr, 要抓 weak, 否則相當於自己抓自己shared_ptr, 永遠無法釋放
-        { if (!self.expired()) std::dynamic_pointer_cast<AsyncJsonFileDtoDeserializer, IDtoDeserializer>(self.lock())->DeserializeProcedure(); });
+    assert(m_gateway);
+    // ruid 跟 gateway 以值傳進 callback 串, 同一個 deserializer 可以同時處理多個請求, 也不用抓自己的 shared_ptr
+    FileSystem::FileSystem::instance()->asyncOpenFile(Filename(param), FileSystem::read | FileSystem::binary,
+        [gateway = m_gateway, ruid_deserializing](const IFilePtr& file, error) { onFileOpened(gateway, ruid_deserializing, file); });
 }
 
-void AsyncJsonFileDtoDeserializer::DeserializeProcedure()
+void AsyncJsonFileDtoDeserializer::onFileOpened(const std::shared_ptr<IDtoGateway>& gateway, const Frameworks::Ruid& ruid, const IFilePtr& file)
 {
-    assert(m_gateway);
-    FutureFile readingFile = FileSystem::FileSystem::instance()->asyncOpenFile(Filename(m_parameter), FileSystem::read | FileSystem::binary);
-    while (!readingFile.valid() || (readingFile.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready)) {}
-    IFilePtr readFile = readingFile.get();
-    if (!readFile)
+    if (!file)
     {
-        Frameworks::EventPublisher::enqueue(std::make_shared<DeserializeDtoFailed>(m_ruid, FileSystem::ErrorCode::fileOpenError));
+        Frameworks::EventPublisher::enqueue(std::make_shared<DeserializeDtoFailed>(ruid, FileSystem::ErrorCode::fileOpenError));
         return;
     }
-    size_t filesize = readFile->size();
-    IFile::FutureRead read = readFile->asyncRead(0, filesize);
-    while (!read.valid() || (read.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready)) {}
-    auto buff = read.get();
-    if (!buff)
+    // 已經在 I/O thread 上, 直接取 mapped view 來 parse, 不用再排一個 read request 把內容複製出來
+    auto content = file->view(0, file->size());
+    FileSystem::FileSystem::instance()->closeFile(file);
+    if ((!content) || (content->empty()))
     {
-        Frameworks::EventPublisher::enqueue(std::make_shared<DeserializeDtoFailed>(m_ruid, FileSystem::ErrorCode::readFail));
+        Frameworks::EventPublisher::enqueue(std::make_shared<DeserializeDtoFailed>(ruid, FileSystem::ErrorCode::readFail));
         return;
     }
-    std::string read_json = convert_to_string(buff.value(), buff->size());
-    Frameworks::EventPublisher::enqueue(std::make_shared<GenericDtoDeserialized>(m_ruid, m_gateway->deserialize(read_json)));
+    Frameworks::EventPublisher::enqueue(std::make_shared<GenericDtoDeserialized>(ruid, gateway->deserializeBuffer(content->chars(), content->size())));
 }
@@ -9,12 +9,14 @@
 #define _ASYNC_JSON_FILE_DTO_DESERIALIZER_H
 
 #include <string>
-#include <future>
+#include <memory>
 #include "GameEngine/DtoDeserializer.h"
+#include "FileSystem/IFile.h"
 
 namespace Enigma::Gateways
 {
     class IDtoGateway;
+    /** open -> map -> parse 用 file system I/O pool 的 completion callback 串起來, 中間不佔住任何 thread 等待 */
     class AsyncJsonFileDtoDeserializer : public Engine::IDtoDeserializer
     {
     public:
@@ -22,13 +24,10 @@ namespace Enigma::Gateways
 
         virtual void invokeDeserialize(const Frameworks::Ruid& ruid_deserializing, const std::string& param) override;
     protected:
-        void DeserializeProcedure();
+        static void onFileOpened(const std::shared_ptr<IDtoGateway>& gateway, const Frameworks::Ruid& ruid, const FileSystem::IFilePtr& file);
 
     protected:
         std::shared_ptr<IDtoGateway> m_gateway;
-        Frameworks::Ruid m_ruid;
-        std::string m_parameter;
-        std::future<void> m_deserializing;
     };
 }
 
@@ -0,0 +1,505 @@
+﻿#include "DtoBinaryGateway.h"
+#include "GameEngine/FactoryDesc.h"
+#include "Platforms/PlatformLayerUtilities.h"
+#include "MathLib/Box3.h"
+#include "MathLib/Matrix4.h"
+#include "MathLib/ColorRGBA.h"
+#include "MathLib/ColorRGB.h"
+#include "MathLib/Vector3.h"
+#include "MathLib/Vector4.h"
+#include "MathLib/Vector2.h"
+#include <algorithm>
+#include <any>
+#include <cstring>
+
+using namespace Enigma::Gateways;
+using namespace Enigma::Engine;
+using namespace Enigma::MathLib;
+
+static constexpr char BINARY_MAGIC[4] = { 'E', 'D', 'T', 'B' };
+
+static_assert(sizeof(Vector2) == sizeof(float) * 2, "Vector2 must be tightly packed");
+static_assert(sizeof(Vector3) == sizeof(float) * 3, "Vector3 must be tightly packed");
+static_assert(sizeof(Vector4) == sizeof(float) * 4, "Vector4 must be tightly packed");
+static_assert(sizeof(Matrix4) == sizeof(float) * 16, "Matrix4 must be tightly packed");
+
+using ValueTag = DtoBinaryGateway::ValueTag;
+
+namespace
+{
+    class BinaryWriter
+    {
+    public:
+        void writeRaw(const void* data, size_t size) { m_buffer.append(static_cast<const char*>(data), size); }
+        template <class T> void write(const T& value) { writeRaw(&value, sizeof(T)); }
+        void writeTag(ValueTag tag) { write(static_cast<std::uint8_t>(tag)); }
+        void writeString(const std::string& s)
+        {
+            write(static_cast<std::uint32_t>(s.size()));
+            writeRaw(s.data(), s.size());
+        }
+        template <class T> void writeArray(const std::vector<T>& vs)
+        {
+            write(static_cast<std::uint32_t>(vs.size()));
+            if (!vs.empty()) writeRaw(vs.data(), vs.size() * sizeof(T));
+        }
+
+        std::string& buffer() { return m_buffer; }
+
+    private:
+        std::string m_buffer;
+    };
+
+    class BinaryReader
+    {
+    public:
+        BinaryReader(const char* data, size_t size) : m_cursor(data), m_end(data + size), m_isValid(true) {}
+
+        bool isValid() const { return m_isValid; }
+        void invalidate() { m_isValid = false; }
+        size_t remaining() const { return static_cast<size_t>(m_end - m_cursor); }
+
+        bool readRaw(void* data, size_t size)
+        {
+            if (!m_isValid || static_cast<size_t>(m_end - m_cursor) < size)
+            {
+                m_isValid = false;
+                return false;
+            }
+            if (size > 0) std::memcpy(data, m_cursor, size);
+            m_cursor += size;
+            return true;
+        }
+        template <class T> T read()
+        {
+            T value{};
+            readRaw(&value, sizeof(T));
+            return value;
+        }
+        std::string readString()
+        {
+            const auto length = read<std::uint32_t>();
+            if (!m_isValid || static_cast<size_t>(m_end - m_cursor) < length)
+            {
+                m_isValid = false;
+                return {};
+            }
+            std::string s(m_cursor, length);
+            m_cursor += length;
+            return s;
+        }
+        template <class T> std::vector<T> readArray()
+        {
+            std::vector<T> vs;
+            const auto count = read<std::uint32_t>();
+            if (!m_isValid || static_cast<size_t>(m_end - m_cursor) / sizeof(T) < count)
+            {
+                m_isValid = false;
+                return vs;
+            }
+            vs.resize(count);
+            readRaw(vs.data(), count * sizeof(T));
+            return vs;
+        }
+
+    private:
+        const char* m_cursor;
+        const char* m_end;
+        bool m_isValid;
+    };
+}
+
+//------------------------------------------------------------------------
+static void SerializeDto(BinaryWriter& writer, const GenericDto& dto);
+static void SerializeDtoArray(BinaryWriter& writer, const GenericDtoCollection& dtos);
+static bool SerializeObject(BinaryWriter& writer, const std::any& any_ob);
+static void SerializeFactoryDesc(BinaryWriter& writer, const FactoryDesc& desc);
+static GenericDto DeserializeDto(BinaryReader& reader);
+static GenericDtoCollection DeserializeDtoArray(BinaryReader& reader);
+static std::any DeserializeObject(BinaryReader& reader, ValueTag tag);
+static FactoryDesc DeserializeFactoryDesc(BinaryReader& reader);
+
+GenericDtoCollection DtoBinaryGateway::deserialize(const std::string& content)
+{
+    return deserializeBuffer(content.data(), content.size());
+}
+
+GenericDtoCollection DtoBinaryGateway::deserializeBuffer(const char* data, size_t size)
+{
+    GenericDtoCollection dtos;
+    if (FATAL_LOG_EXPR(!isBinaryContent(data, size)))
+    {
+        LOG_FMT(Info, "content is not a binary dto");
+        return dtos;
+    }
+    BinaryReader reader(data + sizeof(BINARY_MAGIC), size - sizeof(BINARY_MAGIC));
+    const auto version = reader.read<std::uint32_t>();
+    if (FATAL_LOG_EXPR(version != FORMAT_VERSION))
+    {
+        LOG_FMT(Info, "binary dto version %d not supported", version);
+        return dtos;
+    }
+    const auto dto_count = reader.read<std::uint32_t>();
+    // count 來自檔案, 不能直接信任; 每個 dto 至少有 4 bytes 的 attribute count
+    dtos.reserve(std::min<size_t>(dto_count, reader.remaining() / sizeof(std::uint32_t)));
+    for (std::uint32_t i = 0; (i < dto_count) && (reader.isValid()); i++)
+    {
+        dtos.emplace_back(DeserializeDto(reader));
+    }
+    if (FATAL_LOG_EXPR(!reader.isValid()))
+    {
+        LOG_FMT(Info, "binary dto truncated");
+        dtos.clear();
+    }
+    return dtos;
+}
+
+std::string DtoBinaryGateway::serialize(const GenericDtoCollection& dtos)
+{
+    if (dtos.empty()) return "";
+    BinaryWriter writer;
+    writer.writeRaw(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    writer.write(FORMAT_VERSION);
+    writer.write(static_cast<std::uint32_t>(dtos.size()));
+    for (auto& dto : dtos)
+    {
+        SerializeDto(writer, dto);
+    }
+    return std::move(writer.buffer());
+}
+
+bool DtoBinaryGateway::isBinaryContent(const char* data, size_t size)
+{
+    if ((!data) || (size < sizeof(BINARY_MAGIC))) return false;
+    return std::memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0;
+}
+
+//------------------------------------------------------------------------
+void SerializeDto(BinaryWriter& writer, const GenericDto& dto)
+{
+    // 先佔位 attribute count, 不支援的型別不寫入, 最後再回填
+    const size_t count_pos = writer.buffer().size();
+    writer.write(std::uint32_t{ 0 });
+    std::uint32_t attribute_count = 0;
+    for (auto& it : dto)
+    {
+        const size_t attribute_pos = writer.buffer().size();
+        writer.writeString(it.first);
+        if (SerializeObject(writer, it.second))
+        {
+            attribute_count++;
+        }
+        else
+        {
+            writer.buffer().resize(attribute_pos);
+        }
+    }
+    std::memcpy(writer.buffer().data() + count_pos, &attribute_count, sizeof(attribute_count));
+}
+
+void SerializeDtoArray(BinaryWriter& writer, const GenericDtoCollection& dtos)
+{
+    writer.write(static_cast<std::uint32_t>(dtos.size()));
+    for (auto& dto : dtos)
+    {
+        SerializeDto(writer, dto);
+    }
+}
+
+bool SerializeObject(BinaryWriter& writer, const std::any& any_ob)
+{
+    if (any_ob.type() == typeid(GenericDto))
+    {
+        writer.writeTag(ValueTag::DataObject);
+        SerializeDto(writer, std::any_cast<const GenericDto&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(GenericDtoCollection))
+    {
+        writer.writeTag(ValueTag::DataObjectArray);
+        SerializeDtoArray(writer, std::any_cast<const GenericDtoCollection&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(FactoryDesc))
+    {
+        writer.writeTag(ValueTag::FactoryDesc);
+        SerializeFactoryDesc(writer, std::any_cast<const FactoryDesc&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(std::uint64_t))
+    {
+        writer.writeTag(ValueTag::Uint64);
+        writer.write(std::any_cast<std::uint64_t>(any_ob));
+    }
+    else if (any_ob.type() == typeid(std::uint32_t))
+    {
+        writer.writeTag(ValueTag::Uint32);
+        writer.write(std::any_cast<std::uint32_t>(any_ob));
+    }
+    else if (any_ob.type() == typeid(float))
+    {
+        writer.writeTag(ValueTag::Float);
+        writer.write(std::any_cast<float>(any_ob));
+    }
+    else if (any_ob.type() == typeid(std::string))
+    {
+        writer.writeTag(ValueTag::String);
+        writer.writeString(std::any_cast<const std::string&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(bool))
+    {
+        writer.writeTag(ValueTag::Boolean);
+        writer.write(static_cast<std::uint8_t>(std::any_cast<bool>(any_ob) ? 1 : 0));
+    }
+    else if (any_ob.type() == typeid(ColorRGBA))
+    {
+        const auto& color = std::any_cast<const ColorRGBA&>(any_ob);
+        writer.writeTag(ValueTag::ColorRGBA);
+        writer.write(color.R());
+        writer.write(color.G());
+        writer.write(color.B());
+        writer.write(color.A());
+    }
+    else if (any_ob.type() == typeid(ColorRGB))
+    {
+        const auto& color = std::any_cast<const ColorRGB&>(any_ob);
+        writer.writeTag(ValueTag::ColorRGB);
+        writer.write(color.R());
+        writer.write(color.G());
+        writer.write(color.B());
+    }
+    else if (any_ob.type() == typeid(Vector2))
+    {
+        writer.writeTag(ValueTag::Vector2);
+        writer.write(std::any_cast<const Vector2&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(Vector3))
+    {
+        writer.writeTag(ValueTag::Vector3);
+        writer.write(std::any_cast<const Vector3&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(Vector4))
+    {
+        writer.writeTag(ValueTag::Vector4);
+        writer.write(std::any_cast<const Vector4&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(Box3))
+    {
+        const auto& box = std::any_cast<const Box3&>(any_ob);
+        writer.writeTag(ValueTag::Box3);
+        writer.write(box.Center());
+        for (int i = 0; i < 3; i++)
+        {
+            writer.write(box.Axis(i));
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            writer.write(box.Extent(i));
+        }
+    }
+    else if (any_ob.type() == typeid(Matrix4))
+    {
+        writer.writeTag(ValueTag::Matrix4);
+        writer.write(std::any_cast<const Matrix4&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(std::vector<std::string>))
+    {
+        const auto& ss = std::any_cast<const std::vector<std::string>&>(any_ob);
+        writer.writeTag(ValueTag::StringArray);
+        writer.write(static_cast<std::uint32_t>(ss.size()));
+        for (auto& s : ss)
+        {
+            writer.writeString(s);
+        }
+    }
+    else if (any_ob.type() == typeid(std::vector<std::uint32_t>))
+    {
+        writer.writeTag(ValueTag::Uint32Array);
+        writer.writeArray(std::any_cast<const std::vector<std::uint32_t>&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(std::vector<float>))
+    {
+        writer.writeTag(ValueTag::FloatArray);
+        writer.writeArray(std::any_cast<const std::vector<float>&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(std::vector<Vector2>))
+    {
+        writer.writeTag(ValueTag::Vector2Array);
+        writer.writeArray(std::any_cast<const std::vector<Vector2>&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(std::vector<Vector3>))
+    {
+        writer.writeTag(ValueTag::Vector3Array);
+        writer.writeArray(std::any_cast<const std::vector<Vector3>&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(std::vector<Vector4>))
+    {
+        writer.writeTag(ValueTag::Vector4Array);
+        writer.writeArray(std::any_cast<const std::vector<Vector4>&>(any_ob));
+    }
+    else if (any_ob.type() == typeid(std::vector<Matrix4>))
+    {
+        writer.writeTag(ValueTag::Matrix4Array);
+        writer.writeArray(std::any_cast<const std::vector<Matrix4>&>(any_ob));
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+void SerializeFactoryDesc(BinaryWriter& writer, const FactoryDesc& desc)
+{
+    writer.write(static_cast<std::uint8_t>(desc.instanceType()));
+    writer.writeString(desc.resourceName());
+    writer.writeString(desc.resourceFilename());
+    writer.writeString(desc.rttiName());
+    writer.writeString(desc.prefabFilename());
+}
+
+//------------------------------------------------------------------------
+GenericDto DeserializeDto(BinaryReader& reader)
+{
+    GenericDto dto;
+    const auto attribute_count = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; (i < attribute_count) && (reader.isValid()); i++)
+    {
+        auto attribute = reader.readString();
+        const auto tag = static_cast<ValueTag>(reader.read<std::uint8_t>());
+        auto value = DeserializeObject(reader, tag);
+        if (!value.has_value())
+        {
+            reader.invalidate();
+            break;
+        }
+        dto.addOrUpdate(attribute, std::move(value));
+    }
+    return dto;
+}
+
+GenericDtoCollection DeserializeDtoArray(BinaryReader& reader)
+{
+    GenericDtoCollection dtos;
+    const auto dto_count = reader.read<std::uint32_t>();
+    for (std::uint32_t i = 0; (i < dto_count) && (reader.isValid()); i++)
+    {
+        dtos.emplace_back(DeserializeDto(reader));
+    }
+    return dtos;
+}
+
+std::any DeserializeObject(BinaryReader& reader, ValueTag tag)
+{
+    if (!reader.isValid()) return {};
+    switch (tag)
+    {
+    case ValueTag::DataObject:
+        return DeserializeDto(reader);
+    case ValueTag::DataObjectArray:
+        return DeserializeDtoArray(reader);
+    case ValueTag::FactoryDesc:
+        return DeserializeFactoryDesc(reader);
+    case ValueTag::Uint64:
+        return reader.read<std::uint64_t>();
+    case ValueTag::Uint32:
+        return reader.read<std::uint32_t>();
+    case ValueTag::Float:
+        return reader.read<float>();
+    case ValueTag::String:
+        return reader.readString();
+    case ValueTag::Boolean:
+        return reader.read<std::uint8_t>() != 0;
+    case ValueTag::ColorRGBA:
+    {
+        const auto r = reader.read<float>();
+        const auto g = reader.read<float>();
+        const auto b = reader.read<float>();
+        const auto a = reader.read<float>();
+        return ColorRGBA(r, g, b, a);
+    }
+    case ValueTag::ColorRGB:
+    {
+        const auto r = reader.read<float>();
+        const auto g = reader.read<float>();
+        const auto b = reader.read<float>();
+        return ColorRGB(r, g, b);
+    }
+    case ValueTag::Vector2:
+        return reader.read<Vector2>();
+    case ValueTag::Vector3:
+        return reader.read<Vector3>();
+    case ValueTag::Vector4:
+        return reader.read<Vector4>();
+    case ValueTag::Box3:
+    {
+        Box3 box;
+        box.Center() = reader.read<Vector3>();
+        for (int i = 0; i < 3; i++)
+        {
+            box.Axis(i) = reader.read<Vector3>();
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            box.Extent(i) = reader.read<float>();
+        }
+        return box;
+    }
+    case ValueTag::Matrix4:
+        return reader.read<Matrix4>();
+    case ValueTag::StringArray:
+    {
+        std::vector<std::string> ss;
+        const auto count = reader.read<std::uint32_t>();
+        for (std::uint32_t i = 0; (i < count) && (reader.isValid()); i++)
+        {
+            ss.emplace_back(reader.readString());
+        }
+        return ss;
+    }
+    case ValueTag::Uint32Array:
+        return reader.readArray<std::uint32_t>();
+    case ValueTag::FloatArray:
+        return reader.readArray<float>();
+    case ValueTag::Vector2Array:
+        return reader.readArray<Vector2>();
+    case ValueTag::Vector3Array:
+        return reader.readArray<Vector3>();
+    case ValueTag::Vector4Array:
+        return reader.readArray<Vector4>();
+    case ValueTag::Matrix4Array:
+        return reader.readArray<Matrix4>();
+    }
+    // 不認得的 tag, 無法得知 payload 長度, 後面的資料都不能讀了
+    LOG_FMT(Info, "unknown binary dto tag %d", static_cast<int>(tag));
+    return {};
+}
+
+FactoryDesc DeserializeFactoryDesc(BinaryReader& reader)
+{
+    const auto instance_type = static_cast<FactoryDesc::InstanceType>(reader.read<std::uint8_t>());
+    const auto resource_name = reader.readString();
+    const auto resource_filename = reader.readString();
+    const auto rtti = reader.readString();
+    const auto prefab = reader.readString();
+    FactoryDesc desc(rtti);
+    switch (instance_type)
+    {
+    case FactoryDesc::InstanceType::Native:
+        desc.claimAsNative(prefab);
+        break;
+    case FactoryDesc::InstanceType::ByPrefab:
+        desc.claimByPrefab(prefab);
+        break;
+    case FactoryDesc::InstanceType::Deferred:
+        desc.claimAsDeferred(prefab);
+        break;
+    case FactoryDesc::InstanceType::Instanced:
+        desc.claimAsInstanced(prefab);
+        break;
+    case FactoryDesc::InstanceType::FromResource:
+        desc.claimFromResource(resource_name, resource_filename);
+        break;
+    case FactoryDesc::InstanceType::ResourceAsset:
+        desc.claimAsResourceAsset(resource_name, resource_filename);
+        break;
+    }
+    return desc;
+}
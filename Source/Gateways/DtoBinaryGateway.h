@@ -0,0 +1,65 @@
+﻿/*********************************************************************
+ * \file   DtoBinaryGateway.h
+ * \brief  binary dto gateway, typed tag stream with raw array payload
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef DTO_BINARY_GATEWAY_H
+#define DTO_BINARY_GATEWAY_H
+
+#include "DtoGateway.h"
+#include <string>
+#include <cstdint>
+
+namespace Enigma::Gateways
+{
+    /** binary layout :
+     *  header : magic "EDTB", uint32 version, uint32 dto count
+     *  dto : uint32 attribute count, { string name, uint8 tag, payload } ...
+     *  string : uint32 length + bytes, array : uint32 count + raw elements
+     *  數值都是 little-endian 原始資料 (Win32/Android 平台皆是 little-endian), 陣列可以整塊 memcpy,
+     *  deserializeBuffer 可以直接吃 file mapping 的 view, 不需要先複製成 string */
+    class DtoBinaryGateway : public IDtoGateway
+    {
+    public:
+        static constexpr const char* FILE_EXTENSION = ".bdto";
+        static constexpr std::uint32_t FORMAT_VERSION = 1;
+
+        enum class ValueTag : std::uint8_t
+        {
+            DataObject = 1,
+            DataObjectArray,
+            FactoryDesc,
+            Uint64,
+            Uint32,
+            Float,
+            String,
+            Boolean,
+            ColorRGBA,
+            ColorRGB,
+            Vector2,
+            Vector3,
+            Vector4,
+            Box3,
+            Matrix4,
+            StringArray,
+            Uint32Array,
+            FloatArray,
+            Vector2Array,
+            Vector3Array,
+            Vector4Array,
+            Matrix4Array,
+        };
+
+    public:
+        Engine::GenericDtoCollection deserialize(const std::string& content) override;
+        Engine::GenericDtoCollection deserializeBuffer(const char* data, size_t size) override;
+        std::string serialize(const Engine::GenericDtoCollection& dtos) override;
+
+        /** check magic header, for content sniffing */
+        static bool isBinaryContent(const char* data, size_t size);
+    };
+}
+
+#endif // DTO_BINARY_GATEWAY_H
@@ -17,6 +17,8 @@ namespace Enigma::Gateways
     public:
         virtual ~IDtoGateway() = default;
         virtual Engine::GenericDtoCollection deserialize(const std::string& content) = 0;
+        /** deserialize from raw buffer (ex. file content, mapped view), default copy to string */
+        virtual Engine::GenericDtoCollection deserializeBuffer(const char* data, size_t size) { return deserialize(std::string(data, size)); }
         virtual std::string serialize(const Engine::GenericDtoCollection& dtos) = 0;
     };
 }
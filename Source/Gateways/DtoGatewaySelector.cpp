@@ -0,0 +1,46 @@
+﻿#include "DtoGatewaySelector.h"
+#include "DtoBinaryGateway.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace Enigma::Gateways;
+
+DtoGatewaySelector::DtoGatewaySelector(const std::shared_ptr<IDtoGateway>& default_gateway) : m_defaultGateway(default_gateway)
+{
+    registerGateway(DtoBinaryGateway::FILE_EXTENSION, std::make_shared<DtoBinaryGateway>());
+}
+
+DtoGatewaySelector::~DtoGatewaySelector()
+{
+    m_gateways.clear();
+}
+
+void DtoGatewaySelector::registerGateway(const std::string& extension, const std::shared_ptr<IDtoGateway>& gateway)
+{
+    if (!gateway) return;
+    m_gateways.insert_or_assign(extensionOf(extension), gateway);
+}
+
+void DtoGatewaySelector::unregisterGateway(const std::string& extension)
+{
+    m_gateways.erase(extensionOf(extension));
+}
+
+const std::shared_ptr<IDtoGateway>& DtoGatewaySelector::selectGateway(const std::string& filename) const
+{
+    if (m_gateways.empty()) return m_defaultGateway;
+    const auto it = m_gateways.find(extensionOf(filename));
+    if (it == m_gateways.end()) return m_defaultGateway;
+    return it->second;
+}
+
+std::string DtoGatewaySelector::extensionOf(const std::string& filename)
+{
+    std::string name = filename.substr(0, filename.find('@'));
+    const auto dot_pos = name.find_last_of('.');
+    if (dot_pos == std::string::npos) return "";
+    if (name.find_first_of("/\\", dot_pos) != std::string::npos) return "";
+    std::string extension = name.substr(dot_pos);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
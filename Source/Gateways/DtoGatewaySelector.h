@@ -0,0 +1,47 @@
+﻿/*********************************************************************
+ * \file   DtoGatewaySelector.h
+ * \brief  select dto gateway by file extension
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef DTO_GATEWAY_SELECTOR_H
+#define DTO_GATEWAY_SELECTOR_H
+
+#include "DtoGateway.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace Enigma::Gateways
+{
+    /** 依 dto 檔案的副檔名選 gateway, 沒有註冊的副檔名用 default gateway (通常是 json).
+     *  預設註冊 binary gateway (.bdto). 註冊只在 setup 時做, 之後的 select 可以多執行緒呼叫 */
+    class DtoGatewaySelector
+    {
+    public:
+        explicit DtoGatewaySelector(const std::shared_ptr<IDtoGateway>& default_gateway);
+        DtoGatewaySelector(const DtoGatewaySelector&) = delete;
+        DtoGatewaySelector(DtoGatewaySelector&&) = delete;
+        ~DtoGatewaySelector();
+        DtoGatewaySelector& operator=(const DtoGatewaySelector&) = delete;
+        DtoGatewaySelector& operator=(DtoGatewaySelector&&) = delete;
+
+        /** extension with dot, ex. ".bdto", case insensitive */
+        void registerGateway(const std::string& extension, const std::shared_ptr<IDtoGateway>& gateway);
+        void unregisterGateway(const std::string& extension);
+
+        const std::shared_ptr<IDtoGateway>& defaultGateway() const { return m_defaultGateway; }
+        /** filename may have "@PathId" suffix */
+        const std::shared_ptr<IDtoGateway>& selectGateway(const std::string& filename) const;
+
+        /** lower case extension with dot, path id stripped, empty if no extension */
+        static std::string extensionOf(const std::string& filename);
+
+    protected:
+        std::shared_ptr<IDtoGateway> m_defaultGateway;
+        std::unordered_map<std::string, std::shared_ptr<IDtoGateway>> m_gateways;
+    };
+}
+
+#endif // DTO_GATEWAY_SELECTOR_H
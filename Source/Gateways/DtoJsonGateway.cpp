@@ -1,9 +1,9 @@
 ﻿#include "DtoJsonGateway.h"
-#include "Frameworks/StringFormat.h"
 #include "GameEngine/FactoryDesc.h"
-#include "rapidjson/document.h"
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/prettywriter.h"
+#include "rapidjson/reader.h"
+#include "rapidjson/writer.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/encodedstream.h"
 #include "Platforms/PlatformLayerUtilities.h"
 #include "MathLib/Box3.h"
 #include "MathLib/Matrix4.h"
@@ -13,6 +13,8 @@
 #include "MathLib/Vector4.h"
 #include "MathLib/Vector2.h"
 #include <any>
+#include <array>
+#include <cctype>
 
 constexpr const char* TYPE_TOKEN = "Type";
 constexpr const char* VALUE_TOKEN = "Value";
@@ -48,75 +50,199 @@ using namespace Enigma::Gateways;
 using namespace Enigma::Engine;
 using namespace Enigma::MathLib;
 
+namespace
+{
+    /** 逐 token 拉取 json, 不建 DOM; rapidjson 的 handler 只把最後一個事件記下來 */
+    class JsonTokenReader : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JsonTokenReader>
+    {
+    public:
+        enum class Token { None, Null, Bool, Number, String, Key, StartObject, EndObject, StartArray, EndArray };
+
+    public:
+        JsonTokenReader(const char* data, size_t size)
+            : m_data(data), m_memoryStream(data, size), m_stream(m_memoryStream), m_token(Token::None), m_bool(false), m_double(0.0), m_int64(0), m_uint64(0)
+        {
+            m_reader.IterativeParseInit();
+        }
+        JsonTokenReader(const JsonTokenReader&) = delete;
+        JsonTokenReader& operator=(const JsonTokenReader&) = delete;
+
+        /** 前進一個 token, 結束或 parse error 時傳回 false */
+        bool next()
+        {
+            m_token = Token::None;
+            if (m_reader.IterativeParseComplete()) return false;
+            if (!m_reader.IterativeParseNext<rapidjson::kParseDefaultFlags>(m_stream, *this)) return false;
+            return m_token != Token::None;
+        }
+        Token token() const { return m_token; }
+        /** root value 已經讀完 (或 parse error) */
+        bool isComplete() const { return m_reader.IterativeParseComplete(); }
+        bool isNumber() const { return m_token == Token::Number; }
+        bool hasParseError() const { return m_reader.HasParseError(); }
+        rapidjson::ParseErrorCode parseErrorCode() const { return m_reader.GetParseErrorCode(); }
+        size_t errorOffset() const { return m_reader.GetErrorOffset(); }
+        /** 目前已讀取的 byte 位置 (相對於 buffer 開頭) */
+        size_t tell() const { return m_stream.Tell(); }
+        const char* buffer() const { return m_data; }
+
+        bool getBool() const { return m_bool; }
+        float getFloat() const { return static_cast<float>(m_double); }
+        int getInt() const { return static_cast<int>(m_int64); }
+        std::uint32_t getUint32() const { return static_cast<std::uint32_t>(m_uint64); }
+        std::uint64_t getUint64() const { return m_uint64; }
+        const std::string& getString() const { return m_string; }
+
+        /** 目前 token 是 value 的開頭, 跳過整個 value (含子物件) */
+        void skipValue()
+        {
+            if ((m_token != Token::StartObject) && (m_token != Token::StartArray)) return;
+            unsigned depth = 1;
+            while ((depth > 0) && next())
+            {
+                if ((m_token == Token::StartObject) || (m_token == Token::StartArray)) depth++;
+                else if ((m_token == Token::EndObject) || (m_token == Token::EndArray)) depth--;
+            }
+        }
+
+        /** 數值陣列先解到共用的 scratch buffer, 再一次配置剛好大小的 vector */
+        std::vector<float>& floatScratch() { return m_floatScratch; }
+        std::vector<std::uint32_t>& uintScratch() { return m_uintScratch; }
+
+        // rapidjson handler
+        bool Null() { m_token = Token::Null; return true; }
+        bool Bool(bool b) { m_token = Token::Bool; m_bool = b; return true; }
+        bool Int(int i) { return Int64(i); }
+        bool Uint(unsigned u) { return Uint64(u); }
+        bool Int64(std::int64_t i)
+        {
+            m_token = Token::Number;
+            m_double = static_cast<double>(i);
+            m_int64 = i;
+            m_uint64 = static_cast<std::uint64_t>(i);
+            return true;
+        }
+        bool Uint64(std::uint64_t u)
+        {
+            m_token = Token::Number;
+            m_double = static_cast<double>(u);
+            m_int64 = static_cast<std::int64_t>(u);
+            m_uint64 = u;
+            return true;
+        }
+        bool Double(double d)
+        {
+            m_token = Token::Number;
+            m_double = d;
+            m_int64 = static_cast<std::int64_t>(d);
+            m_uint64 = d > 0.0 ? static_cast<std::uint64_t>(d) : 0;
+            return true;
+        }
+        bool String(const char* str, rapidjson::SizeType length, bool)
+        {
+            m_token = Token::String;
+            m_string.assign(str, length);
+            return true;
+        }
+        bool Key(const char* str, rapidjson::SizeType length, bool)
+        {
+            m_token = Token::Key;
+            m_string.assign(str, length);
+            return true;
+        }
+        bool StartObject() { m_token = Token::StartObject; return true; }
+        bool EndObject(rapidjson::SizeType) { m_token = Token::EndObject; return true; }
+        bool StartArray() { m_token = Token::StartArray; return true; }
+        bool EndArray(rapidjson::SizeType) { m_token = Token::EndArray; return true; }
+
+    private:
+        const char* m_data;
+        rapidjson::MemoryStream m_memoryStream;
+        rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream> m_stream;
+        rapidjson::Reader m_reader;
+        Token m_token;
+        bool m_bool;
+        double m_double;
+        std::int64_t m_int64;
+        std::uint64_t m_uint64;
+        std::string m_string;
+        std::vector<float> m_floatScratch;
+        std::vector<std::uint32_t> m_uintScratch;
+    };
+    using Token = JsonTokenReader::Token;
+
+    /** rapidjson output stream, 直接寫進輸出字串 */
+    class StringOutputStream
+    {
+    public:
+        typedef char Ch;
+        explicit StringOutputStream(std::string& s) : m_string(s) {}
+        void Put(char c) { m_string.push_back(c); }
+        void Flush() {}
+
+    private:
+        std::string& m_string;
+    };
+    using JsonWriter = rapidjson::Writer<StringOutputStream>;
+}
+
 //------------------------------------------------------------------------
-static GenericDto DeserializeDto(const rapidjson::Value& value);
-static GenericDtoCollection DeserializeDtoArray(const rapidjson::Value& value);
-static void DeserializeAttribute(GenericDto& dto, const std::string& attribute, const rapidjson::Value& value);
-static FactoryDesc DeserializeFactoryDesc(const rapidjson::Value& value);
-static std::uint64_t DeserializeUInt64(const rapidjson::Value& value);
-static std::uint32_t DeserializeUInt32(const rapidjson::Value& value);
-static float DeserializeFloat(const rapidjson::Value& value);
-static std::string DeserializeString(const rapidjson::Value& value);
-static bool DeserializeBoolean(const rapidjson::Value& value);
-static ColorRGBA DeserializeColorRGBA(const rapidjson::Value& value);
-static ColorRGB DeserializeColorRGB(const rapidjson::Value& value);
-static Vector2 DeserializeVector2(const rapidjson::Value& value);
-static Vector3 DeserializeVector3(const rapidjson::Value& value);
-static Vector4 DeserializeVector4(const rapidjson::Value& value);
-static Box3 DeserializeBox3(const rapidjson::Value& value);
-static Matrix4 DeserializeMatrix4(const rapidjson::Value& value);
-static std::vector<std::string> DeserializeStringArray(const rapidjson::Value& value);
-static std::vector<std::uint32_t> DeserializeUInt32Array(const rapidjson::Value& value);
-static std::vector<float> DeserializeFloatArray(const rapidjson::Value& value);
-static std::vector<Vector2> DeserializeVector2Array(const rapidjson::Value& value);
-static std::vector<Vector3> DeserializeVector3Array(const rapidjson::Value& value);
-static std::vector<Vector4> DeserializeVector4Array(const rapidjson::Value& value);
-static std::vector<Matrix4> DeserializeMatrix4Array(const rapidjson::Value& value);
+static GenericDto DeserializeDto(JsonTokenReader& reader);
+static GenericDtoCollection DeserializeDtoArray(JsonTokenReader& reader);
+static void DeserializeAttribute(GenericDto& dto, const std::string& attribute, JsonTokenReader& reader);
+static void DeserializeValue(GenericDto& dto, const std::string& attribute, const std::string& type, JsonTokenReader& reader);
+static FactoryDesc DeserializeFactoryDesc(JsonTokenReader& reader);
+static bool DeserializeFloats(JsonTokenReader& reader, float* values, size_t count);
+static std::vector<std::string> DeserializeStringArray(JsonTokenReader& reader);
+static std::vector<std::uint32_t> DeserializeUInt32Array(JsonTokenReader& reader);
+static std::vector<float> DeserializeFloatArray(JsonTokenReader& reader);
+template <class T, size_t N, class Maker> static std::vector<T> DeserializeFloatTupleArray(JsonTokenReader& reader, Maker make);
 //------------------------------------------------------------------------
-static rapidjson::Value serializeDto(const GenericDto& dto, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeDtoArray(const GenericDtoCollection& dtos, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeObject(std::any ob, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeFactoryDesc(const FactoryDesc& desc, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeUInt64(const std::uint64_t n);
-static rapidjson::Value SerializeUInt32(const std::uint32_t n);
-static rapidjson::Value SerializeFloat(const float v);
-static rapidjson::Value SerializeString(const std::string& s, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeBoolean(const bool b);
-static rapidjson::Value SerializeColorRGBA(const ColorRGBA& color, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeColorRGB(const ColorRGB& color, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeVector2(const Vector2& vec, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeVector3(const Vector3& vec, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeVector4(const Vector4& vec, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeBox3(const Box3& box, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeMatrix4(const Matrix4& mx, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeStringArray(const std::vector<std::string>& ss, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeUInt32Array(const std::vector<std::uint32_t>& ns, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeFloatArray(const std::vector<float>& vs, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeVector2Array(const std::vector<Vector2>& vecs, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeVector3Array(const std::vector<Vector3>& vecs, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeVector4Array(const std::vector<Vector4>& vecs, rapidjson::MemoryPoolAllocator<>& allocator);
-static rapidjson::Value SerializeMatrix4Array(const std::vector<Matrix4>& mxs, rapidjson::MemoryPoolAllocator<>& allocator);
+static void SerializeDto(JsonWriter& writer, const GenericDto& dto);
+static void SerializeDtoArray(JsonWriter& writer, const GenericDtoCollection& dtos);
+static void SerializeObject(JsonWriter& writer, const std::any& any_ob);
+static void SerializeFactoryDesc(JsonWriter& writer, const FactoryDesc& desc);
+static void SerializeString(JsonWriter& writer, const std::string& s);
+static void SerializeFloats(JsonWriter& writer, const float* values, size_t count);
+static void SerializeColorRGBA(JsonWriter& writer, const ColorRGBA& color);
+static void SerializeColorRGB(JsonWriter& writer, const ColorRGB& color);
+static void SerializeVector2(JsonWriter& writer, const Vector2& vec);
+static void SerializeVector3(JsonWriter& writer, const Vector3& vec);
+static void SerializeVector4(JsonWriter& writer, const Vector4& vec);
+static void SerializeBox3(JsonWriter& writer, const Box3& box);
+static void SerializeMatrix4(JsonWriter& writer, const Matrix4& mx);
+static void SerializeStringArray(JsonWriter& writer, const std::vector<std::string>& ss);
+static void SerializeUInt32Array(JsonWriter& writer, const std::vector<std::uint32_t>& ns);
+static void SerializeFloatArray(JsonWriter& writer, const std::vector<float>& vs);
+template <class T, class Serializer> static void SerializeArray(JsonWriter& writer, const std::vector<T>& vs, Serializer serialize);
 
 GenericDtoCollection DtoJsonGateway::deserialize(const std::string& json)
+{
+    return deserializeBuffer(json.data(), json.size());
+}
+
+GenericDtoCollection DtoJsonGateway::deserializeBuffer(const char* data, size_t size)
 {
     GenericDtoCollection dtos;
-    rapidjson::Document json_doc;
-    json_doc.Parse<0>(json.c_str());
-    if (FATAL_LOG_EXPR(json_doc.HasParseError()))
+    JsonTokenReader reader(data, size);
+    const bool is_array = (reader.next()) && (reader.token() == Token::StartArray);
+    if (is_array) dtos = DeserializeDtoArray(reader);
+    // root array 之後不能再有 token, 跟 DOM parse 的 kParseErrorDocumentRootNotSingular 一樣
+    const bool is_single_root = (!reader.next()) && (reader.isComplete());
+    if (FATAL_LOG_EXPR(reader.hasParseError()))
     {
-        std::string ss = string_format("error %d, @ %d", json_doc.GetParseError(), json_doc.GetErrorOffset());
-        LOG(Info, ss);
-        return dtos;
+        LOG_FMT(Info, "error %d, @ %zu", reader.parseErrorCode(), reader.errorOffset());
+        return {};
     }
-    if (FATAL_LOG_EXPR(!json_doc.IsArray()))
+    if (FATAL_LOG_EXPR(!is_array))
     {
-        std::string ss = string_format("json is not a contract array");
-        LOG(Info, ss);
-        return dtos;
+        LOG_FMT(Info, "json is not a contract array");
+        return {};
     }
-    for (auto json_it = json_doc.GetArray().Begin(); json_it != json_doc.GetArray().End(); ++json_it)
+    if (FATAL_LOG_EXPR(!is_single_root))
     {
-        dtos.emplace_back(DeserializeDto(*json_it));
+        LOG_FMT(Info, "json has trailing data after the contract array, @ %zu", reader.tell());
+        return {};
     }
 
     return dtos;
@@ -125,108 +251,224 @@ GenericDtoCollection DtoJsonGateway::deserialize(const std::string& json)
 std::string DtoJsonGateway::serialize(const GenericDtoCollection& dtos)
 {
     if (dtos.empty()) return "";
-    rapidjson::Document json_doc;
-    json_doc.SetArray();
-    for (auto dto : dtos)
-    {
-        json_doc.PushBack(serializeDto(dto, json_doc.GetAllocator()), json_doc.GetAllocator());
-    }
-
-    rapidjson::StringBuffer buf;
-    rapidjson::PrettyWriter writer(buf);
-    writer.SetFormatOptions(rapidjson::kFormatSingleLineArray);
-    json_doc.Accept(writer);
-    std::string json(buf.GetString(), buf.GetSize());
+    std::string json;
+    StringOutputStream stream(json);
+    JsonWriter writer(stream);
+    SerializeDtoArray(writer, dtos);
     return json;
 }
 
 //-------------------------------------------------------------------------
-GenericDto DeserializeDto(const rapidjson::Value& value_ob)
+// 各 Deserialize 函式進入時, reader 停在 value 的第一個 token, 離開時停在 value 的最後一個 token
+GenericDto DeserializeDto(JsonTokenReader& reader)
 {
     GenericDto dto;
-    for (auto json_it = value_ob.MemberBegin(); json_it != value_ob.MemberEnd(); ++json_it)
+    if (reader.token() != Token::StartObject)  // 空的 dto 序列化成 null
+    {
+        reader.skipValue();
+        return dto;
+    }
+    while ((reader.next()) && (reader.token() == Token::Key))
     {
-        if (json_it->value.IsNull()) continue;
-        DeserializeAttribute(dto, json_it->name.GetString(), json_it->value);
+        std::string attribute = reader.getString();
+        if (!reader.next()) break;
+        if (reader.token() == Token::Null) continue;
+        DeserializeAttribute(dto, attribute, reader);
     }
     return dto;
 }
 
-GenericDtoCollection DeserializeDtoArray(const rapidjson::Value& value)
+GenericDtoCollection DeserializeDtoArray(JsonTokenReader& reader)
 {
     GenericDtoCollection dtos;
-    if (!value.IsArray()) return dtos;
-    auto values = value.GetArray();
-    for (auto json_it = values.Begin(); json_it != values.End(); ++json_it)
+    if (reader.token() != Token::StartArray)
+    {
+        reader.skipValue();
+        return dtos;
+    }
+    while ((reader.next()) && (reader.token() != Token::EndArray))
     {
-        dtos.emplace_back(DeserializeDto(*json_it));
+        dtos.emplace_back(DeserializeDto(reader));
     }
     return dtos;
 }
 
-void DeserializeAttribute(GenericDto& dto, const std::string& attribute, const rapidjson::Value& value)
+void DeserializeAttribute(GenericDto& dto, const std::string& attribute, JsonTokenReader& reader)
+{
+    if (reader.token() != Token::StartObject)
+    {
+        reader.skipValue();
+        return;
+    }
+    std::string type;
+    // Value 寫在 Type 之前的話, 先記下 value 的範圍, 等讀到 Type 再回頭解
+    size_t deferred_begin = 0;
+    size_t deferred_end = 0;
+    while ((reader.next()) && (reader.token() == Token::Key))
+    {
+        if (reader.getString() == TYPE_TOKEN)
+        {
+            if (!reader.next()) return;
+            if (reader.token() == Token::String) type = reader.getString();
+            reader.skipValue();
+        }
+        else if ((reader.getString() == VALUE_TOKEN) && (!type.empty()))
+        {
+            if (!reader.next()) return;
+            DeserializeValue(dto, attribute, type, reader);
+        }
+        else if (reader.getString() == VALUE_TOKEN)
+        {
+            deferred_begin = reader.tell();
+            if (!reader.next()) return;
+            reader.skipValue();
+            deferred_end = reader.tell();
+        }
+        else
+        {
+            if (!reader.next()) return;
+            reader.skipValue();
+        }
+    }
+    if ((deferred_end == 0) || (type.empty())) return;
+    const char* data = reader.buffer() + deferred_begin;
+    const char* data_end = reader.buffer() + deferred_end;
+    while ((data < data_end) && ((*data == ':') || (std::isspace(static_cast<unsigned char>(*data))))) ++data;
+    JsonTokenReader value_reader(data, static_cast<size_t>(data_end - data));
+    if (value_reader.next()) DeserializeValue(dto, attribute, type, value_reader);
+}
+
+void DeserializeValue(GenericDto& dto, const std::string& attribute, const std::string& type, JsonTokenReader& reader)
 {
-    if (!value.HasMember(TYPE_TOKEN)) return;
-    if (!value.HasMember(VALUE_TOKEN)) return;
-    std::string type = value[TYPE_TOKEN].GetString();
     if (type == DATA_OBJECT_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeDto(value[VALUE_TOKEN]));
-    else if (type == DATA_OBJECT_ARRAY_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeDtoArray(value[VALUE_TOKEN]));
-    else if (type == FACTORY_DESC_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeFactoryDesc(value[VALUE_TOKEN]));
+    {
+        dto.addOrUpdate(attribute, DeserializeDto(reader));
+        return;
+    }
+    if (type == DATA_OBJECT_ARRAY_TOKEN)
+    {
+        dto.addOrUpdate(attribute, DeserializeDtoArray(reader));
+        return;
+    }
+    if (reader.token() == Token::Null) return;
+    if (type == FACTORY_DESC_TOKEN)
+    {
+        dto.addOrUpdate(attribute, DeserializeFactoryDesc(reader));
+    }
     else if (type == UINT64_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeUInt64(value[VALUE_TOKEN]));
+    {
+        if (reader.isNumber()) dto.addOrUpdate(attribute, reader.getUint64());
+        reader.skipValue();
+    }
     else if (type == UINT32_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeUInt32(value[VALUE_TOKEN]));
+    {
+        if (reader.isNumber()) dto.addOrUpdate(attribute, reader.getUint32());
+        reader.skipValue();
+    }
     else if (type == FLOAT_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeFloat(value[VALUE_TOKEN]));
+    {
+        if (reader.isNumber()) dto.addOrUpdate(attribute, reader.getFloat());
+        reader.skipValue();
+    }
     else if (type == STRING_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeString(value[VALUE_TOKEN]));
+    {
+        if (reader.token() == Token::String) dto.addOrUpdate(attribute, reader.getString());
+        reader.skipValue();
+    }
     else if (type == BOOLEAN_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeBoolean(value[VALUE_TOKEN]));
+    {
+        if (reader.token() == Token::Bool) dto.addOrUpdate(attribute, reader.getBool());
+        reader.skipValue();
+    }
     else if (type == COLOR_RGBA_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeColorRGBA(value[VALUE_TOKEN]));
+    {
+        std::array<float, 4> vs{};
+        dto.addOrUpdate(attribute, DeserializeFloats(reader, vs.data(), vs.size()) ? ColorRGBA(vs[0], vs[1], vs[2], vs[3]) : ColorRGBA::WHITE);
+    }
     else if (type == COLOR_RGB_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeColorRGB(value[VALUE_TOKEN]));
+    {
+        std::array<float, 3> vs{};
+        dto.addOrUpdate(attribute, DeserializeFloats(reader, vs.data(), vs.size()) ? ColorRGB(vs[0], vs[1], vs[2]) : ColorRGB::WHITE);
+    }
     else if (type == VECTOR2_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeVector2(value[VALUE_TOKEN]));
+    {
+        std::array<float, 2> vs{};
+        dto.addOrUpdate(attribute, DeserializeFloats(reader, vs.data(), vs.size()) ? Vector2(vs[0], vs[1]) : Vector2::ZERO);
+    }
     else if (type == VECTOR3_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeVector3(value[VALUE_TOKEN]));
+    {
+        std::array<float, 3> vs{};
+        dto.addOrUpdate(attribute, DeserializeFloats(reader, vs.data(), vs.size()) ? Vector3(vs[0], vs[1], vs[2]) : Vector3::ZERO);
+    }
     else if (type == VECTOR4_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeVector4(value[VALUE_TOKEN]));
+    {
+        std::array<float, 4> vs{};
+        dto.addOrUpdate(attribute, DeserializeFloats(reader, vs.data(), vs.size()) ? Vector4(vs[0], vs[1], vs[2], vs[3]) : Vector4::ZERO);
+    }
     else if (type == BOX3_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeBox3(value[VALUE_TOKEN]));
+    {
+        std::array<float, 15> vs{};
+        Box3 box;
+        if (DeserializeFloats(reader, vs.data(), vs.size()))
+        {
+            box.Center() = Vector3(vs[0], vs[1], vs[2]);
+            box.Axis(0) = Vector3(vs[3], vs[4], vs[5]);
+            box.Axis(1) = Vector3(vs[6], vs[7], vs[8]);
+            box.Axis(2) = Vector3(vs[9], vs[10], vs[11]);
+            box.Extent(0) = vs[12];
+            box.Extent(1) = vs[13];
+            box.Extent(2) = vs[14];
+        }
+        dto.addOrUpdate(attribute, box);
+    }
     else if (type == MATRIX4_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeMatrix4(value[VALUE_TOKEN]));
+    {
+        std::array<float, 16> vs{};
+        dto.addOrUpdate(attribute, DeserializeFloats(reader, vs.data(), vs.size()) ? Matrix4(vs.data()) : Matrix4::IDENTITY);
+    }
     else if (type == STRING_ARRAY_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeStringArray(value[VALUE_TOKEN]));
+        dto.addOrUpdate(attribute, DeserializeStringArray(reader));
     else if (type == UINT32_ARRAY_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeUInt32Array(value[VALUE_TOKEN]));
+        dto.addOrUpdate(attribute, DeserializeUInt32Array(reader));
     else if (type == FLOAT_ARRAY_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeFloatArray(value[VALUE_TOKEN]));
+        dto.addOrUpdate(attribute, DeserializeFloatArray(reader));
     else if (type == VECTOR2_ARRAY_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeVector2Array(value[VALUE_TOKEN]));
+        dto.addOrUpdate(attribute, DeserializeFloatTupleArray<Vector2, 2>(reader, [](const float* vs) { return Vector2(vs[0], vs[1]); }));
     else if (type == VECTOR3_ARRAY_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeVector3Array(value[VALUE_TOKEN]));
+        dto.addOrUpdate(attribute, DeserializeFloatTupleArray<Vector3, 3>(reader, [](const float* vs) { return Vector3(vs[0], vs[1], vs[2]); }));
     else if (type == VECTOR4_ARRAY_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeVector4Array(value[VALUE_TOKEN]));
+        dto.addOrUpdate(attribute, DeserializeFloatTupleArray<Vector4, 4>(reader, [](const float* vs) { return Vector4(vs[0], vs[1], vs[2], vs[3]); }));
     else if (type == MATRIX4_ARRAY_TOKEN)
-        dto.addOrUpdate(attribute, DeserializeMatrix4Array(value[VALUE_TOKEN]));
+        dto.addOrUpdate(attribute, DeserializeFloatTupleArray<Matrix4, 16>(reader, [](const float* vs) { return Matrix4(vs); }));
+    else
+        reader.skipValue();
 }
 
-FactoryDesc DeserializeFactoryDesc(const rapidjson::Value& value)
+FactoryDesc DeserializeFactoryDesc(JsonTokenReader& reader)
 {
     FactoryDesc::InstanceType instance_type = FactoryDesc::InstanceType::Native;
     std::string resource_name;
     std::string resource_filename;
     std::string rtti;
     std::string prefab;
-    if (value.HasMember(INSTANCE_TYPE)) instance_type = static_cast<FactoryDesc::InstanceType>(value[INSTANCE_TYPE].GetInt());
-    if (value.HasMember(RESOURCE_NAME)) resource_name = value[RESOURCE_NAME].GetString();
-    if (value.HasMember(RESOURCE_FILENAME)) resource_filename = value[RESOURCE_FILENAME].GetString();
-    if (value.HasMember(RTTI_NAME)) rtti = value[RTTI_NAME].GetString();
-    if (value.HasMember(PREFAB_FILENAME)) prefab = value[PREFAB_FILENAME].GetString();
+    if (reader.token() == Token::StartObject)
+    {
+        while ((reader.next()) && (reader.token() == Token::Key))
+        {
+            std::string key = reader.getString();
+            if (!reader.next()) break;
+            if ((key == INSTANCE_TYPE) && (reader.isNumber())) instance_type = static_cast<FactoryDesc::InstanceType>(reader.getInt());
+            else if (reader.token() != Token::String) reader.skipValue();
+            else if (key == RESOURCE_NAME) resource_name = reader.getString();
+            else if (key == RESOURCE_FILENAME) resource_filename = reader.getString();
+            else if (key == RTTI_NAME) rtti = reader.getString();
+            else if (key == PREFAB_FILENAME) prefab = reader.getString();
+        }
+    }
+    else
+    {
+        reader.skipValue();
+    }
     FactoryDesc desc(rtti);
     switch (instance_type)
     {
@@ -252,497 +494,364 @@ FactoryDesc DeserializeFactoryDesc(const rapidjson::Value& value)
     return desc;
 }
 
-std::uint64_t DeserializeUInt64(const rapidjson::Value& value)
+/** 固定長度的 float 陣列 (vector, color, box, matrix), 不足的補 0, 多的忽略; 不是陣列傳回 false */
+bool DeserializeFloats(JsonTokenReader& reader, float* values, size_t count)
 {
-    return value.GetUint64();
-}
-
-std::uint32_t DeserializeUInt32(const rapidjson::Value& value)
-{
-    return value.GetUint();
-}
-
-float DeserializeFloat(const rapidjson::Value& value)
-{
-    return value.GetFloat();
-}
-
-std::string DeserializeString(const rapidjson::Value& value)
-{
-    return value.GetString();
-}
-bool DeserializeBoolean(const rapidjson::Value& value)
-{
-    return value.GetBool();
-}
-ColorRGBA DeserializeColorRGBA(const rapidjson::Value& value)
-{
-    if (!value.IsArray()) return ColorRGBA::WHITE;
-    auto values = value.GetArray();
-    return ColorRGBA(values[0].GetFloat(), values[1].GetFloat(), values[2].GetFloat(), values[3].GetFloat());
-}
-
-ColorRGB DeserializeColorRGB(const rapidjson::Value& value)
-{
-    if (!value.IsArray()) return ColorRGB::WHITE;
-    auto values = value.GetArray();
-    return ColorRGB(values[0].GetFloat(), values[1].GetFloat(), values[2].GetFloat());
-}
-Vector2 DeserializeVector2(const rapidjson::Value& value)
-{
-    if (!value.IsArray()) return Vector2::ZERO;
-    auto values = value.GetArray();
-    return Vector2(values[0].GetFloat(), values[1].GetFloat());
-}
-Vector3 DeserializeVector3(const rapidjson::Value& value)
-{
-    if (!value.IsArray()) return Vector3::ZERO;
-    auto values = value.GetArray();
-    return Vector3(values[0].GetFloat(), values[1].GetFloat(), values[2].GetFloat());
-}
-Vector4 DeserializeVector4(const rapidjson::Value& value)
-{
-    if (!value.IsArray()) return Vector4::ZERO;
-    auto values = value.GetArray();
-    return Vector4(values[0].GetFloat(), values[1].GetFloat(), values[2].GetFloat(), values[3].GetFloat());
-}
-
-Box3 DeserializeBox3(const rapidjson::Value& value)
-{
-    Box3 box;
-    if (!value.IsArray()) return box;
-    auto values = value.GetArray();
-    box.Center() = Vector3(values[0].GetFloat(), values[1].GetFloat(), values[2].GetFloat());
-    box.Axis(0) = Vector3(values[3].GetFloat(), values[4].GetFloat(), values[5].GetFloat());
-    box.Axis(1) = Vector3(values[6].GetFloat(), values[7].GetFloat(), values[8].GetFloat());
-    box.Axis(2) = Vector3(values[9].GetFloat(), values[10].GetFloat(), values[11].GetFloat());
-    box.Extent(0) = values[12].GetFloat();
-    box.Extent(1) = values[13].GetFloat();
-    box.Extent(2) = values[14].GetFloat();
-
-    return box;
-}
-
-Matrix4 DeserializeMatrix4(const rapidjson::Value& value)
-{
-    if (!value.IsArray()) return Matrix4::IDENTITY;
-    auto values = value.GetArray();
-    return Matrix4(values[0].GetFloat(), values[1].GetFloat(), values[2].GetFloat(), values[3].GetFloat(),
-        values[4].GetFloat(), values[5].GetFloat(), values[6].GetFloat(), values[7].GetFloat(),
-        values[8].GetFloat(), values[9].GetFloat(), values[10].GetFloat(), values[11].GetFloat(),
-        values[12].GetFloat(), values[13].GetFloat(), values[14].GetFloat(), values[15].GetFloat());
+    if (reader.token() != Token::StartArray)
+    {
+        reader.skipValue();
+        return false;
+    }
+    size_t index = 0;
+    while ((reader.next()) && (reader.token() != Token::EndArray))
+    {
+        if ((index < count) && (reader.isNumber())) values[index] = reader.getFloat();
+        reader.skipValue();
+        index++;
+    }
+    return true;
 }
 
-std::vector<std::string> DeserializeStringArray(const rapidjson::Value& value)
+std::vector<std::string> DeserializeStringArray(JsonTokenReader& reader)
 {
     std::vector<std::string> ss;
-    if (!value.IsArray()) return ss;
-    auto values = value.GetArray();
-    for (auto json_it = values.Begin(); json_it != values.End(); ++json_it)
+    if (reader.token() != Token::StartArray)
+    {
+        reader.skipValue();
+        return ss;
+    }
+    while ((reader.next()) && (reader.token() != Token::EndArray))
     {
-        ss.emplace_back(DeserializeString(*json_it));
+        if (reader.token() == Token::String) ss.emplace_back(reader.getString());
+        reader.skipValue();
     }
     return ss;
 }
 
-std::vector<std::uint32_t> DeserializeUInt32Array(const rapidjson::Value& value)
+std::vector<std::uint32_t> DeserializeUInt32Array(JsonTokenReader& reader)
 {
-    std::vector<std::uint32_t> ns;
-    if (!value.IsArray()) return ns;
-    auto values = value.GetArray();
-    for (auto json_it = values.Begin(); json_it != values.End(); ++json_it)
+    if (reader.token() != Token::StartArray)
     {
-        ns.emplace_back(DeserializeUInt32(*json_it));
+        reader.skipValue();
+        return {};
     }
-    return ns;
-}
-
-std::vector<float> DeserializeFloatArray(const rapidjson::Value& value)
-{
-    std::vector<float> vs;
-    if (!value.IsArray()) return vs;
-    auto values = value.GetArray();
-    for (auto json_it = values.Begin(); json_it != values.End(); ++json_it)
+    auto& scratch = reader.uintScratch();
+    scratch.clear();
+    while ((reader.next()) && (reader.token() != Token::EndArray))
     {
-        vs.emplace_back(DeserializeFloat(*json_it));
+        if (reader.isNumber()) scratch.emplace_back(reader.getUint32());
+        reader.skipValue();
     }
-    return vs;
+    return std::vector<std::uint32_t>(scratch.begin(), scratch.end());
 }
 
-std::vector<Vector2> DeserializeVector2Array(const rapidjson::Value& value)
+std::vector<float> DeserializeFloatArray(JsonTokenReader& reader)
 {
-    std::vector<Vector2> vecs;
-    if (!value.IsArray()) return vecs;
-    auto values = value.GetArray();
-    for (auto json_it = values.Begin(); json_it != values.End(); ++json_it)
+    if (reader.token() != Token::StartArray)
     {
-        vecs.emplace_back(DeserializeVector2(*json_it));
+        reader.skipValue();
+        return {};
     }
-    return vecs;
-}
-
-std::vector<Vector3> DeserializeVector3Array(const rapidjson::Value& value)
-{
-    std::vector<Vector3> vecs;
-    if (!value.IsArray()) return vecs;
-    auto values = value.GetArray();
-    for (auto json_it = values.Begin(); json_it != values.End(); ++json_it)
+    auto& scratch = reader.floatScratch();
+    scratch.clear();
+    while ((reader.next()) && (reader.token() != Token::EndArray))
     {
-        vecs.emplace_back(DeserializeVector3(*json_it));
+        if (reader.isNumber()) scratch.emplace_back(reader.getFloat());
+        reader.skipValue();
     }
-    return vecs;
+    return std::vector<float>(scratch.begin(), scratch.end());
 }
 
-std::vector<Vector4> DeserializeVector4Array(const rapidjson::Value& value)
+/** vector / matrix 陣列, 每個元素是 N 個 float 的陣列 */
+template <class T, size_t N, class Maker> std::vector<T> DeserializeFloatTupleArray(JsonTokenReader& reader, Maker make)
 {
-    std::vector<Vector4> vecs;
-    if (!value.IsArray()) return vecs;
-    auto values = value.GetArray();
-    for (auto json_it = values.Begin(); json_it != values.End(); ++json_it)
+    std::vector<T> vs;
+    if (reader.token() != Token::StartArray)
     {
-        vecs.emplace_back(DeserializeVector4(*json_it));
+        reader.skipValue();
+        return vs;
     }
-    return vecs;
-}
-
-std::vector<Matrix4> DeserializeMatrix4Array(const rapidjson::Value& value)
-{
-    std::vector<Matrix4> mxs;
-    if (!value.IsArray()) return mxs;
-    auto values = value.GetArray();
-    for (auto json_it = values.Begin(); json_it != values.End(); ++json_it)
+    auto& scratch = reader.floatScratch();
+    scratch.clear();
+    while ((reader.next()) && (reader.token() != Token::EndArray))
+    {
+        const size_t offset = scratch.size();
+        scratch.resize(offset + N, 0.0f);
+        if (!DeserializeFloats(reader, scratch.data() + offset, N)) scratch.resize(offset);
+    }
+    vs.reserve(scratch.size() / N);
+    for (size_t i = 0; i + N <= scratch.size(); i += N)
     {
-        mxs.emplace_back(DeserializeMatrix4(*json_it));
+        vs.emplace_back(make(scratch.data() + i));
     }
-    return mxs;
+    return vs;
 }
 
 //--------------------------------------------------------------------------
-rapidjson::Value serializeDto(const GenericDto& dto, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeDto(JsonWriter& writer, const GenericDto& dto)
 {
-    if (dto.isEmpty()) return rapidjson::Value();
-    rapidjson::Value json{ rapidjson::kObjectType };
-    for (auto it : dto)
+    if (dto.isEmpty())
     {
-        json.AddMember(SerializeString(it.first, allocator), SerializeObject(it.second, allocator), allocator);
+        writer.Null();
+        return;
     }
-
-    return json;
+    writer.StartObject();
+    for (auto& it : dto)
+    {
+        SerializeString(writer, it.first);
+        SerializeObject(writer, it.second);
+    }
+    writer.EndObject();
 }
 
-rapidjson::Value SerializeDtoArray(const GenericDtoCollection& dtos, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeDtoArray(JsonWriter& writer, const GenericDtoCollection& dtos)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
+    writer.StartArray();
     for (auto& o : dtos)
     {
-        value.PushBack(serializeDto(o, allocator), allocator);
+        SerializeDto(writer, o);
     }
-    return value;
+    writer.EndArray();
 }
 
-rapidjson::Value SerializeObject(std::any any_ob, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeObject(JsonWriter& writer, const std::any& any_ob)
 {
-    rapidjson::Value node{ rapidjson::kObjectType };
-    if (any_ob.type() == typeid(GenericDto))
+    writer.StartObject();
+    auto write_type = [&writer](const char* type)
+    {
+        writer.Key(TYPE_TOKEN);
+        writer.String(type);
+        writer.Key(VALUE_TOKEN);
+    };
+    if (auto dto = std::any_cast<GenericDto>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(DATA_OBJECT_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN),
-            serializeDto(std::any_cast<GenericDto>(any_ob), allocator), allocator);
+        write_type(DATA_OBJECT_TOKEN);
+        SerializeDto(writer, *dto);
     }
-    else if (any_ob.type() == typeid(GenericDtoCollection))
+    else if (auto dtos = std::any_cast<GenericDtoCollection>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(DATA_OBJECT_ARRAY_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN),
-            SerializeDtoArray(std::any_cast<GenericDtoCollection>(any_ob), allocator), allocator);
+        write_type(DATA_OBJECT_ARRAY_TOKEN);
+        SerializeDtoArray(writer, *dtos);
     }
-    else if (any_ob.type() == typeid(FactoryDesc))
+    else if (auto desc = std::any_cast<FactoryDesc>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(FACTORY_DESC_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN),
-            SerializeFactoryDesc(std::any_cast<FactoryDesc>(any_ob), allocator), allocator);
+        write_type(FACTORY_DESC_TOKEN);
+        SerializeFactoryDesc(writer, *desc);
     }
-    else if (any_ob.type() == typeid(std::uint64_t))
+    else if (auto n64 = std::any_cast<std::uint64_t>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(UINT64_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN),
-            SerializeUInt64(std::any_cast<std::uint64_t>(any_ob)), allocator);
+        write_type(UINT64_TOKEN);
+        writer.Uint64(*n64);
     }
-    else if (any_ob.type() == typeid(std::uint32_t))
+    else if (auto n32 = std::any_cast<std::uint32_t>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(UINT32_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN),
-            SerializeUInt32(std::any_cast<std::uint32_t>(any_ob)), allocator);
+        write_type(UINT32_TOKEN);
+        writer.Uint(*n32);
     }
-    else if (any_ob.type() == typeid(float))
+    else if (auto v = std::any_cast<float>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(FLOAT_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN),
-            SerializeFloat(std::any_cast<float>(any_ob)), allocator);
+        write_type(FLOAT_TOKEN);
+        writer.Double(*v);
     }
-    else if (any_ob.type() == typeid(std::string))
+    else if (auto s = std::any_cast<std::string>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(STRING_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN),
-            SerializeString(std::any_cast<std::string>(any_ob), allocator), allocator);
+        write_type(STRING_TOKEN);
+        SerializeString(writer, *s);
     }
-    else if (any_ob.type() == typeid(bool))
+    else if (auto b = std::any_cast<bool>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(BOOLEAN_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN),
-            SerializeBoolean(std::any_cast<bool>(any_ob)), allocator);
+        write_type(BOOLEAN_TOKEN);
+        writer.Bool(*b);
     }
-    else if (any_ob.type() == typeid(ColorRGBA))
+    else if (auto color_rgba = std::any_cast<ColorRGBA>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(COLOR_RGBA_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeColorRGBA(std::any_cast<ColorRGBA>(any_ob), allocator), allocator);
+        write_type(COLOR_RGBA_TOKEN);
+        SerializeColorRGBA(writer, *color_rgba);
     }
-    else if (any_ob.type() == typeid(ColorRGB))
+    else if (auto color_rgb = std::any_cast<ColorRGB>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(COLOR_RGB_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeColorRGB(std::any_cast<ColorRGB>(any_ob), allocator), allocator);
+        write_type(COLOR_RGB_TOKEN);
+        SerializeColorRGB(writer, *color_rgb);
     }
-    else if (any_ob.type() == typeid(Vector2))
+    else if (auto vec2 = std::any_cast<Vector2>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(VECTOR2_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeVector2(std::any_cast<Vector2>(any_ob), allocator), allocator);
+        write_type(VECTOR2_TOKEN);
+        SerializeVector2(writer, *vec2);
     }
-    else if (any_ob.type() == typeid(Vector3))
+    else if (auto vec3 = std::any_cast<Vector3>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(VECTOR3_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeVector3(std::any_cast<Vector3>(any_ob), allocator), allocator);
+        write_type(VECTOR3_TOKEN);
+        SerializeVector3(writer, *vec3);
     }
-    else if (any_ob.type() == typeid(Vector4))
+    else if (auto vec4 = std::any_cast<Vector4>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(VECTOR4_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeVector4(std::any_cast<Vector4>(any_ob), allocator), allocator);
+        write_type(VECTOR4_TOKEN);
+        SerializeVector4(writer, *vec4);
     }
-    else if (any_ob.type() == typeid(Box3))
+    else if (auto box = std::any_cast<Box3>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(BOX3_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeBox3(std::any_cast<Box3>(any_ob), allocator), allocator);
+        write_type(BOX3_TOKEN);
+        SerializeBox3(writer, *box);
     }
-    else if (any_ob.type() == typeid(Matrix4))
+    else if (auto mx = std::any_cast<Matrix4>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(MATRIX4_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeMatrix4(std::any_cast<Matrix4>(any_ob), allocator), allocator);
+        write_type(MATRIX4_TOKEN);
+        SerializeMatrix4(writer, *mx);
     }
-    else if (any_ob.type() == typeid(std::vector<std::string>))
+    else if (auto ss = std::any_cast<std::vector<std::string>>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(STRING_ARRAY_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeStringArray(std::any_cast<std::vector<std::string>>(any_ob), allocator), allocator);
+        write_type(STRING_ARRAY_TOKEN);
+        SerializeStringArray(writer, *ss);
     }
-    else if (any_ob.type() == typeid(std::vector<std::uint32_t>))
+    else if (auto ns = std::any_cast<std::vector<std::uint32_t>>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(UINT32_ARRAY_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeUInt32Array(std::any_cast<std::vector<std::uint32_t>>(any_ob), allocator), allocator);
+        write_type(UINT32_ARRAY_TOKEN);
+        SerializeUInt32Array(writer, *ns);
     }
-    else if (any_ob.type() == typeid(std::vector<float>))
+    else if (auto vs = std::any_cast<std::vector<float>>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(FLOAT_ARRAY_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeFloatArray(std::any_cast<std::vector<float>>(any_ob), allocator), allocator);
+        write_type(FLOAT_ARRAY_TOKEN);
+        SerializeFloatArray(writer, *vs);
     }
-    else if (any_ob.type() == typeid(std::vector<Vector2>))
+    else if (auto vec2s = std::any_cast<std::vector<Vector2>>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(VECTOR2_ARRAY_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeVector2Array(std::any_cast<std::vector<Vector2>>(any_ob), allocator), allocator);
+        write_type(VECTOR2_ARRAY_TOKEN);
+        SerializeArray(writer, *vec2s, SerializeVector2);
     }
-    else if (any_ob.type() == typeid(std::vector<Vector3>))
+    else if (auto vec3s = std::any_cast<std::vector<Vector3>>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(VECTOR3_ARRAY_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeVector3Array(std::any_cast<std::vector<Vector3>>(any_ob), allocator), allocator);
+        write_type(VECTOR3_ARRAY_TOKEN);
+        SerializeArray(writer, *vec3s, SerializeVector3);
     }
-    else if (any_ob.type() == typeid(std::vector<Vector4>))
+    else if (auto vec4s = std::any_cast<std::vector<Vector4>>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(VECTOR4_ARRAY_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeVector4Array(std::any_cast<std::vector<Vector4>>(any_ob), allocator), allocator);
+        write_type(VECTOR4_ARRAY_TOKEN);
+        SerializeArray(writer, *vec4s, SerializeVector4);
     }
-    else if (any_ob.type() == typeid(std::vector<Matrix4>))
+    else if (auto mxs = std::any_cast<std::vector<Matrix4>>(&any_ob))
     {
-        node.AddMember(rapidjson::StringRef(TYPE_TOKEN), rapidjson::StringRef(MATRIX4_ARRAY_TOKEN), allocator);
-        node.AddMember(rapidjson::StringRef(VALUE_TOKEN), SerializeMatrix4Array(std::any_cast<std::vector<Matrix4>>(any_ob), allocator), allocator);
+        write_type(MATRIX4_ARRAY_TOKEN);
+        SerializeArray(writer, *mxs, SerializeMatrix4);
     }
-    return node;
-}
-
-rapidjson::Value SerializeFactoryDesc(const FactoryDesc& desc, rapidjson::MemoryPoolAllocator<>& allocator)
-{
-    rapidjson::Value value{ rapidjson::kObjectType };
-    value.AddMember(rapidjson::StringRef(INSTANCE_TYPE), static_cast<int>(desc.instanceType()), allocator);
-    value.AddMember(rapidjson::StringRef(RESOURCE_NAME), SerializeString(desc.resourceName(), allocator), allocator);
-    value.AddMember(rapidjson::StringRef(RESOURCE_FILENAME), SerializeString(desc.resourceFilename(), allocator), allocator);
-    value.AddMember(rapidjson::StringRef(RTTI_NAME), SerializeString(desc.rttiName(), allocator), allocator);
-    value.AddMember(rapidjson::StringRef(PREFAB_FILENAME), SerializeString(desc.prefabFilename(), allocator), allocator);
-    return value;
-}
-
-rapidjson::Value SerializeUInt64(const std::uint64_t n)
-{
-    return rapidjson::Value(n);
+    writer.EndObject();
 }
 
-rapidjson::Value SerializeUInt32(const std::uint32_t n)
+void SerializeFactoryDesc(JsonWriter& writer, const FactoryDesc& desc)
 {
-    return rapidjson::Value(n);
+    writer.StartObject();
+    writer.Key(INSTANCE_TYPE);
+    writer.Int(static_cast<int>(desc.instanceType()));
+    writer.Key(RESOURCE_NAME);
+    SerializeString(writer, desc.resourceName());
+    writer.Key(RESOURCE_FILENAME);
+    SerializeString(writer, desc.resourceFilename());
+    writer.Key(RTTI_NAME);
+    SerializeString(writer, desc.rttiName());
+    writer.Key(PREFAB_FILENAME);
+    SerializeString(writer, desc.prefabFilename());
+    writer.EndObject();
 }
 
-rapidjson::Value SerializeFloat(const float v)
+void SerializeString(JsonWriter& writer, const std::string& s)
 {
-    return rapidjson::Value(v);
+    writer.String(s.data(), static_cast<rapidjson::SizeType>(s.size()));
 }
 
-rapidjson::Value SerializeString(const std::string& s, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeFloats(JsonWriter& writer, const float* values, size_t count)
 {
-    return rapidjson::Value(s, allocator);
+    writer.StartArray();
+    for (size_t i = 0; i < count; i++)
+    {
+        writer.Double(values[i]);
+    }
+    writer.EndArray();
 }
 
-rapidjson::Value SerializeBoolean(const bool b)
-{
-    return rapidjson::Value(b);
-}
-rapidjson::Value SerializeColorRGBA(const ColorRGBA& color, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeColorRGBA(JsonWriter& writer, const ColorRGBA& color)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
-    value.PushBack(color.R(), allocator);
-    value.PushBack(color.G(), allocator);
-    value.PushBack(color.B(), allocator);
-    value.PushBack(color.A(), allocator);
-    return value;
+    const float vs[4] = { color.R(), color.G(), color.B(), color.A() };
+    SerializeFloats(writer, vs, 4);
 }
 
-rapidjson::Value SerializeColorRGB(const ColorRGB& color, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeColorRGB(JsonWriter& writer, const ColorRGB& color)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
-    value.PushBack(color.R(), allocator);
-    value.PushBack(color.G(), allocator);
-    value.PushBack(color.B(), allocator);
-    return value;
+    const float vs[3] = { color.R(), color.G(), color.B() };
+    SerializeFloats(writer, vs, 3);
 }
 
-rapidjson::Value SerializeVector2(const Vector2& vec, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeVector2(JsonWriter& writer, const Vector2& vec)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
-    value.PushBack(vec.x(), allocator);
-    value.PushBack(vec.y(), allocator);
-    return value;
+    const float vs[2] = { vec.x(), vec.y() };
+    SerializeFloats(writer, vs, 2);
 }
 
-rapidjson::Value SerializeVector3(const Vector3& vec, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeVector3(JsonWriter& writer, const Vector3& vec)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
-    value.PushBack(vec.x(), allocator);
-    value.PushBack(vec.y(), allocator);
-    value.PushBack(vec.z(), allocator);
-    return value;
+    const float vs[3] = { vec.x(), vec.y(), vec.z() };
+    SerializeFloats(writer, vs, 3);
 }
 
-rapidjson::Value SerializeVector4(const Vector4& vec, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeVector4(JsonWriter& writer, const Vector4& vec)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
-    value.PushBack(vec.x(), allocator);
-    value.PushBack(vec.y(), allocator);
-    value.PushBack(vec.z(), allocator);
-    value.PushBack(vec.w(), allocator);
-    return value;
+    const float vs[4] = { vec.x(), vec.y(), vec.z(), vec.w() };
+    SerializeFloats(writer, vs, 4);
 }
 
-rapidjson::Value SerializeBox3(const Box3& box, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeBox3(JsonWriter& writer, const Box3& box)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
-    value.PushBack(box.Center().x(), allocator);
-    value.PushBack(box.Center().y(), allocator);
-    value.PushBack(box.Center().z(), allocator);
-    for (int i = 0; i < 3; i++)
-    {
-        value.PushBack(box.Axis(i).x(), allocator);
-        value.PushBack(box.Axis(i).y(), allocator);
-        value.PushBack(box.Axis(i).z(), allocator);
-    }
-    value.PushBack(box.Extent(0), allocator);
-    value.PushBack(box.Extent(1), allocator);
-    value.PushBack(box.Extent(2), allocator);
-
-    return value;
+    const float vs[15] = {
+        box.Center().x(), box.Center().y(), box.Center().z(),
+        box.Axis(0).x(), box.Axis(0).y(), box.Axis(0).z(),
+        box.Axis(1).x(), box.Axis(1).y(), box.Axis(1).z(),
+        box.Axis(2).x(), box.Axis(2).y(), box.Axis(2).z(),
+        box.Extent(0), box.Extent(1), box.Extent(2) };
+    SerializeFloats(writer, vs, 15);
 }
 
-rapidjson::Value SerializeMatrix4(const Matrix4& mx, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeMatrix4(JsonWriter& writer, const Matrix4& mx)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
+    writer.StartArray();
     for (int i = 0; i < 4; i++)
     {
-        value.PushBack(mx[i][0], allocator);
-        value.PushBack(mx[i][1], allocator);
-        value.PushBack(mx[i][2], allocator);
-        value.PushBack(mx[i][3], allocator);
+        for (int j = 0; j < 4; j++)
+        {
+            writer.Double(mx[i][j]);
+        }
     }
-    return value;
+    writer.EndArray();
 }
 
-rapidjson::Value SerializeStringArray(const std::vector<std::string>& ss, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeStringArray(JsonWriter& writer, const std::vector<std::string>& ss)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
-    for (auto s : ss)
+    writer.StartArray();
+    for (auto& s : ss)
     {
-        value.PushBack(SerializeString(s, allocator), allocator);
+        SerializeString(writer, s);
     }
-    return value;
+    writer.EndArray();
 }
 
-rapidjson::Value SerializeUInt32Array(const std::vector<std::uint32_t>& ns, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeUInt32Array(JsonWriter& writer, const std::vector<std::uint32_t>& ns)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
+    writer.StartArray();
     for (auto n : ns)
     {
-        value.PushBack(SerializeUInt32(n), allocator);
-    }
-    return value;
-}
-
-rapidjson::Value SerializeFloatArray(const std::vector<float>& vs, rapidjson::MemoryPoolAllocator<>& allocator)
-{
-    rapidjson::Value value(rapidjson::kArrayType);
-    for (auto v : vs)
-    {
-        value.PushBack(SerializeFloat(v), allocator);
-    }
-    return value;
-}
-
-rapidjson::Value SerializeVector2Array(const std::vector<Vector2>& vecs, rapidjson::MemoryPoolAllocator<>& allocator)
-{
-    rapidjson::Value value(rapidjson::kArrayType);
-    for (auto vec : vecs)
-    {
-        value.PushBack(SerializeVector2(vec, allocator), allocator);
-    }
-    return value;
-}
-
-rapidjson::Value SerializeVector3Array(const std::vector<Vector3>& vecs, rapidjson::MemoryPoolAllocator<>& allocator)
-{
-    rapidjson::Value value(rapidjson::kArrayType);
-    for (auto vec : vecs)
-    {
-        value.PushBack(SerializeVector3(vec, allocator), allocator);
+        writer.Uint(n);
     }
-    return value;
+    writer.EndArray();
 }
 
-rapidjson::Value SerializeVector4Array(const std::vector<Vector4>& vecs, rapidjson::MemoryPoolAllocator<>& allocator)
+void SerializeFloatArray(JsonWriter& writer, const std::vector<float>& vs)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
-    for (auto vec : vecs)
-    {
-        value.PushBack(SerializeVector4(vec, allocator), allocator);
-    }
-    return value;
+    SerializeFloats(writer, vs.data(), vs.size());
 }
 
-rapidjson::Value SerializeMatrix4Array(const std::vector<Matrix4>& mxs, rapidjson::MemoryPoolAllocator<>& allocator)
+template <class T, class Serializer> void SerializeArray(JsonWriter& writer, const std::vector<T>& vs, Serializer serialize)
 {
-    rapidjson::Value value(rapidjson::kArrayType);
-    for (auto mx : mxs)
+    writer.StartArray();
+    for (auto& v : vs)
     {
-        value.PushBack(SerializeMatrix4(mx, allocator), allocator);
+        serialize(writer, v);
     }
-    return value;
+    writer.EndArray();
 }
@@ -20,6 +20,9 @@ namespace Enigma::Gateways
     {
     public:
         Engine::GenericDtoCollection deserialize(const std::string& json) override;
+        /** 不需要 null-terminated, 可以直接 parse file view; 逐 token 串流解析, 不建 rapidjson DOM */
+        Engine::GenericDtoCollection deserializeBuffer(const char* data, size_t size) override;
+        /** 直接以 rapidjson Writer 串流輸出, 不排版 */
         std::string serialize(const Engine::GenericDtoCollection& dtos) override;
     };
 }
@@ -1,5 +1,4 @@
 ﻿#include "EffectProfileJsonGateway.h"
-#include "Frameworks/StringFormat.h"
 #include "Platforms/PlatformLayer.h"
 #include "FileSystem/FileSystem.h"
 #include "FileSystem/IFile.h"
@@ -74,26 +73,22 @@ std::optional<EffectCompilingProfile> EffectProfileJsonGateway::Deserialize(cons
     json_doc.Parse<0>(json.c_str());
     if (FATAL_LOG_EXPR(json_doc.HasParseError()))
     {
-        std::string ss = string_format("error %d, @ %d", json_doc.GetParseError(), json_doc.GetErrorOffset());
-        LOG(Info, ss);
+        LOG_FMT(Info, "error %d, @ %zu", json_doc.GetParseError(), json_doc.GetErrorOffset());
         return std::nullopt;
     }
     if (!json_doc.HasMember(TECHNIQUE_LIST_TOKEN))
     {
-        std::string ss = string_format("effect doesn't have technique list");
-        LOG(Info, ss);
+        LOG_FMT(Info, "effect doesn't have technique list");
         return std::nullopt;
     }
     if (!json_doc.HasMember(VERTEX_SHADER_LIST_TOKEN))
     {
-        std::string ss = string_format("effect doesn't have vertex shader list");
-        LOG(Info, ss);
+        LOG_FMT(Info, "effect doesn't have vertex shader list");
         return std::nullopt;
     }
     if (!json_doc.HasMember(PIXEL_SHADER_LIST_TOKEN))
     {
-        std::string ss = string_format("effect doesn't have pixel shader list");
-        LOG(Info, ss);
+        LOG_FMT(Info, "effect doesn't have pixel shader list");
         return std::nullopt;
     }
     m_vertexShaderGateways = DeserializeVertexShaderList(json_doc[VERTEX_SHADER_LIST_TOKEN]);
@@ -142,8 +137,7 @@ std::vector<EffectProfileJsonGateway::VertexShaderGatewayMeta> EffectProfileJson
     auto shader_metas = std::vector<VertexShaderGatewayMeta>{};
     if (FATAL_LOG_EXPR(!shader_list.IsArray()))
     {
-        std::string ss = string_format("vertex shader list is not a array");
-        LOG(Info, ss);
+        LOG_FMT(Info, "vertex shader list is not a array");
         return shader_metas;
     }
     for (auto shader_it = shader_list.GetArray().Begin(); shader_it != shader_list.GetArray().End(); ++shader_it)
@@ -160,8 +154,7 @@ std::vector<EffectProfileJsonGateway::PixelShaderGatewayMeta> EffectProfileJsonG
     auto shader_metas = std::vector<PixelShaderGatewayMeta>{};
     if (FATAL_LOG_EXPR(!shader_list.IsArray()))
     {
-        std::string ss = string_format("pixel shader list is not a array");
-        LOG(Info, ss);
+        LOG_FMT(Info, "pixel shader list is not a array");
         return shader_metas;
     }
     for (auto shader_it = shader_list.GetArray().Begin(); shader_it != shader_list.GetArray().End(); ++shader_it)
@@ -177,8 +170,7 @@ std::vector<EffectProfileJsonGateway::SamplerStateGatewayMeta> EffectProfileJson
     auto state_metas = std::vector<SamplerStateGatewayMeta>{};
     if (FATAL_LOG_EXPR(!sampler_list.IsArray()))
     {
-        std::string ss = string_format("sampler state list is not a array");
-        LOG(Info, ss);
+        LOG_FMT(Info, "sampler state list is not a array");
         return state_metas;
     }
     for (auto sampler = sampler_list.GetArray().Begin(); sampler != sampler_list.GetArray().End(); ++sampler)
@@ -194,8 +186,7 @@ std::vector<EffectProfileJsonGateway::RasterizerStateGatewayMeta> EffectProfileJ
     auto state_metas = std::vector<RasterizerStateGatewayMeta>{};
     if (FATAL_LOG_EXPR(!rasterizer_list.IsArray()))
     {
-        std::string ss = string_format("rasterizer state list is not a array");
-        LOG(Info, ss);
+        LOG_FMT(Info, "rasterizer state list is not a array");
         return state_metas;
     }
     for (auto rasterizer = rasterizer_list.GetArray().Begin(); rasterizer != rasterizer_list.GetArray().End(); ++rasterizer)
@@ -211,8 +202,7 @@ std::vector<EffectProfileJsonGateway::BlendStateGatewayMeta> EffectProfileJsonGa
     auto state_metas = std::vector<BlendStateGatewayMeta>{};
     if (FATAL_LOG_EXPR(!blend_list.IsArray()))
     {
-        std::string ss = string_format("blend state list is not a array");
-        LOG(Info, ss);
+        LOG_FMT(Info, "blend state list is not a array");
         return state_metas;
     }
     for (auto blend = blend_list.GetArray().Begin(); blend != blend_list.GetArray().End(); ++blend)
@@ -228,8 +218,7 @@ std::vector<EffectProfileJsonGateway::DepthStateGatewayMeta> EffectProfileJsonGa
     auto state_metas = std::vector<DepthStateGatewayMeta>{};
     if (FATAL_LOG_EXPR(!depth_list.IsArray()))
     {
-        std::string ss = string_format("depth state list is not a array");
-        LOG(Info, ss);
+        LOG_FMT(Info, "depth state list is not a array");
         return state_metas;
     }
     for (auto depth = depth_list.GetArray().Begin(); depth != depth_list.GetArray().End(); ++depth)
@@ -245,8 +234,7 @@ std::vector<EffectTechniqueProfile> EffectProfileJsonGateway::DeserializeTechniq
     auto profiles = std::vector<EffectTechniqueProfile>{};
     if (FATAL_LOG_EXPR(!tech_list.IsArray()))
     {
-        std::string ss = string_format("technique list is not a array");
-        LOG(Info, ss);
+        LOG_FMT(Info, "technique list is not a array");
         return profiles;
     }
     for (auto tech = tech_list.GetArray().Begin(); tech != tech_list.GetArray().End(); ++tech)
@@ -262,8 +250,7 @@ std::vector<EffectPassProfile> EffectProfileJsonGateway::DeserializePassProfileL
     auto profiles = std::vector<EffectPassProfile>{};
     if (FATAL_LOG_EXPR(!pass_list.IsArray()))
     {
-        std::string ss = string_format("pass list is not a array");
-        LOG(Info, ss);
+        LOG_FMT(Info, "pass list is not a array");
         return profiles;
     }
     for (auto pass = pass_list.GetArray().Begin(); pass != pass_list.GetArray().End(); ++pass)
@@ -340,8 +327,7 @@ Enigma::Graphics::IDeviceSamplerState::SamplerStateData::Filter EffectProfileJso
 {
     if (m_filterReference.find(filter) == m_filterReference.end())
     {
-        std::string ss = string_format("filter %s is not a valid filter", filter.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "filter %s is not a valid filter", filter.c_str());
         return Graphics::IDeviceSamplerState::SamplerStateData::Filter::None;
     }
     return m_filterReference.at(filter);
@@ -351,8 +337,7 @@ Enigma::Graphics::IDeviceSamplerState::SamplerStateData::AddressMode EffectProfi
 {
     if (m_addressModeReference.find(address_mode) == m_addressModeReference.end())
     {
-        std::string ss = string_format("address mode %s is not a valid address mode", address_mode.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "address mode %s is not a valid address mode", address_mode.c_str());
         return Graphics::IDeviceSamplerState::SamplerStateData::AddressMode::Clamp;
     }
     return m_addressModeReference.at(address_mode);
@@ -362,8 +347,7 @@ Enigma::Graphics::IDeviceSamplerState::SamplerStateData::CompareFunc EffectProfi
 {
     if (m_samplerCompReference.find(compare_func) == m_samplerCompReference.end())
     {
-        std::string ss = string_format("compare func %s is not a valid sampler compare func", compare_func.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "compare func %s is not a valid sampler compare func", compare_func.c_str());
         return Graphics::IDeviceSamplerState::SamplerStateData::CompareFunc::Never;
     }
     return m_samplerCompReference.at(compare_func);
@@ -393,8 +377,7 @@ Enigma::Graphics::IDeviceRasterizerState::RasterizerStateData::FillMode EffectPr
 {
     if (m_fillModeReference.find(fill_mode) == m_fillModeReference.end())
     {
-        std::string ss = string_format("fill mode %s is not a valid fill mode", fill_mode.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "fill mode %s is not a valid fill mode", fill_mode.c_str());
         return Graphics::IDeviceRasterizerState::RasterizerStateData::FillMode::Fill;
     }
     return m_fillModeReference.at(fill_mode);
@@ -404,8 +387,7 @@ Enigma::Graphics::IDeviceRasterizerState::RasterizerStateData::BackfaceCullMode
 {
     if (m_cullModeReference.find(cull_mode) == m_cullModeReference.end())
     {
-        std::string ss = string_format("cull mode %s is not a valid cull mode", cull_mode.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "cull mode %s is not a valid cull mode", cull_mode.c_str());
         return Graphics::IDeviceRasterizerState::RasterizerStateData::BackfaceCullMode::Cull_None;
     }
     return m_cullModeReference.at(cull_mode);
@@ -419,8 +401,7 @@ EffectProfileJsonGateway::BlendStateGatewayMeta EffectProfileJsonGateway::Deseri
     meta.m_name = state[NAME_TOKEN].GetString();
     if (FATAL_LOG_EXPR(!state[BLEND_TYPES_TOKEN].IsArray()))
     {
-        std::string ss = string_format("blend types is not a array");
-        LOG(Info, ss);
+        LOG_FMT(Info, "blend types is not a array");
         return meta;
     }
     for (unsigned int i = 0; i < state[BLEND_TYPES_TOKEN].Capacity(); i++)
@@ -436,8 +417,7 @@ Enigma::Graphics::IDeviceAlphaBlendState::BlendStateData::BlendType EffectProfil
 {
     if (m_blendTypeReference.find(blend_type) == m_blendTypeReference.end())
     {
-        std::string ss = string_format("blend type %s is not a valid blend type", blend_type.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "blend type %s is not a valid blend type", blend_type.c_str());
         return Graphics::IDeviceAlphaBlendState::BlendStateData::BlendType::Blend_Opaque;
     }
     return m_blendTypeReference.at(blend_type);
@@ -493,8 +473,7 @@ Enigma::Graphics::IDeviceDepthStencilState::DepthStencilData::CompareFunc Effect
 {
     if (m_depthCompReference.find(compare_func) == m_depthCompReference.end())
     {
-        std::string ss = string_format("depth compare func %s is not a valid depth compare func", compare_func.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "depth compare func %s is not a valid depth compare func", compare_func.c_str());
         return Graphics::IDeviceDepthStencilState::DepthStencilData::CompareFunc::Always;
     }
     return m_depthCompReference.at(compare_func);
@@ -564,8 +543,7 @@ std::vector<EffectSamplerProfile> EffectProfileJsonGateway::DeserializeSamplerPr
     auto profiles = std::vector<EffectSamplerProfile>{};
     if (FATAL_LOG_EXPR(!sampler_list.IsArray()))
     {
-        std::string ss = string_format("sampler list is not a array");
-        LOG(Info, ss);
+        LOG_FMT(Info, "sampler list is not a array");
         return profiles;
     }
     for (auto samp = sampler_list.GetArray().Begin(); samp != sampler_list.GetArray().End(); ++samp)
@@ -592,8 +570,7 @@ EffectAlphaBlendProfile EffectProfileJsonGateway::FetchBlendStateProfile(const s
         });
     if (FATAL_LOG_EXPR(it == m_blendStateGateways.end()))
     {
-        std::string ss = string_format("can't find blend state %s", state_name.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "can't find blend state %s", state_name.c_str());
         return profile;
     }
     profile.m_name = it->m_name;
@@ -610,8 +587,7 @@ EffectRasterizerProfile EffectProfileJsonGateway::FetchRasterizerStateProfile(co
         });
     if (FATAL_LOG_EXPR(it == m_rasterizerStateGateways.end()))
     {
-        std::string ss = string_format("can't find rasterizer state %s", state_name.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "can't find rasterizer state %s", state_name.c_str());
         return profile;
     }
     profile.m_name = it->m_name;
@@ -628,8 +604,7 @@ EffectDepthStencilProfile EffectProfileJsonGateway::FetchDepthStateProfile(const
         });
     if (FATAL_LOG_EXPR(it == m_depthStateGateways.end()))
     {
-        std::string ss = string_format("can't find depth state %s", state_name.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "can't find depth state %s", state_name.c_str());
         return profile;
     }
     profile.m_name = it->m_name;
@@ -648,10 +623,10 @@ std::string EffectProfileJsonGateway::ReadShaderCode(const std::string& filename
         return "";
     }
 
-    auto code_buff = iFile->read(0, file_size);
-    if (!code_buff) return "";
+    auto code_view = iFile->view(0, file_size);
     FileSystem::FileSystem::instance()->closeFile(iFile);
-    return convert_to_string(code_buff.value(), file_size);
+    if (!code_view) return "";
+    return std::string(code_view->asStringView());
 }
 
 Enigma::MathLib::ColorRGBA EffectProfileJsonGateway::DeserializeColorRGBA(const rapidjson::Value& value) const
@@ -688,8 +663,7 @@ Enigma::Graphics::IDeviceDepthStencilState::DepthStencilData::StencilOpCode Effe
 {
     if (m_stencilOpReference.find(op_code) == m_stencilOpReference.end())
     {
-        std::string ss = string_format("can't find stencil op code %s", op_code.c_str());
-        LOG(Info, ss);
+        LOG_FMT(Info, "can't find stencil op code %s", op_code.c_str());
         return Graphics::IDeviceDepthStencilState::DepthStencilData::StencilOpCode::Keep;
     }
     return m_stencilOpReference.at(op_code);
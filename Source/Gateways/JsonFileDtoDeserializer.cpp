@@ -22,12 +22,17 @@ void JsonFileDtoDeserializer::invokeDeserialize(const Frameworks::Ruid& ruid_des
 {
     assert(m_gateway);
     IFilePtr readFile = FileSystem::FileSystem::instance()->openFile(Filename(param), FileSystem::read | FileSystem::binary);
+    if (!readFile)
+    {
+        Frameworks::EventPublisher::enqueue(std::make_shared<DeserializeDtoFailed>(ruid_deserializing, Engine::ErrorCode::fileIOError));
+        return;
+    }
     size_t filesize = readFile->size();
-    auto read_buff = readFile->read(0, filesize);
-    if (read_buff)
+    auto content = readFile->view(0, filesize);
+    FileSystem::FileSystem::instance()->closeFile(readFile);
+    if (content)
     {
-        std::string read_json = convert_to_string(read_buff.value(), read_buff->size());
-        Frameworks::EventPublisher::enqueue(std::make_shared<GenericDtoDeserialized>(ruid_deserializing, m_gateway->deserialize(read_json)));
+        Frameworks::EventPublisher::enqueue(std::make_shared<GenericDtoDeserialized>(ruid_deserializing, m_gateway->deserializeBuffer(content->chars(), content->size())));
     }
     else
     {
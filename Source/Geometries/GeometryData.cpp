@@ -23,6 +23,7 @@ GeometryData::GeometryData(const GeometryId& id) : m_factoryDesc(GeometryData::T
     m_topology = PrimitiveTopology::Topology_Undefine;
 
     m_geometryBound = BoundingVolume{ Box3::UNIT_BOX };
+    m_positionRevision = 0;
 }
 
 GeometryData::~GeometryData()
@@ -206,6 +207,7 @@ error GeometryData::createVertexCapacity(const std::string& vertex_format_string
     m_idxCapacity = idx_capa;
     m_vtxUsedCount = vtx_count;
     m_idxUsedCount = idx_count;
+    markPositionsChanged();
 
     m_geoSegmentVector.clear();
     m_geoSegmentVector.push_back(GeometrySegment());
@@ -229,6 +231,7 @@ error GeometryData::resizeVertexMemoryCapacity(unsigned vtx_capa, unsigned idx_c
         m_indexMemory.resize(idx_capa);
         m_idxCapacity = idx_capa;
     }
+    markPositionsChanged();
 
     return ErrorCode::ok;
 }
@@ -243,6 +246,7 @@ void GeometryData::setUsingVertexCount(unsigned vtx_count, unsigned idx_count)
     {
         m_idxUsedCount = idx_count;
     }
+    markPositionsChanged();
     if (m_geoSegmentVector.size() == 1)
     {
         m_geoSegmentVector[0].m_startVtx = 0;
@@ -576,6 +580,7 @@ error GeometryData::setIndexArray(const std::vector<unsigned>& idx_ary)
     unsigned int data_count = m_idxUsedCount;
     if (idx_ary.size() < data_count) data_count = static_cast<unsigned>(idx_ary.size());
     memcpy(&m_indexMemory[0], &idx_ary[0], data_count * sizeof(unsigned int));
+    markPositionsChanged();
     return ErrorCode::ok;
 }
 
@@ -639,6 +644,7 @@ error GeometryData::setVertexMemoryData(unsigned vtxIndex, int elementOffset, in
 
     if (elementOffset < 0) return ErrorCode::ok;  // no need set
 
+    if (elementOffset == m_vertexDesc.positionOffset()) markPositionsChanged();
     size_t step = m_vertexDesc.totalVertexSize() / sizeof(float);
     size_t base_idx = step * vtxIndex + elementOffset;
     int cp_dimension = srcDimension;
@@ -700,6 +706,7 @@ error GeometryData::setVertexMemoryDataArray(unsigned start, int elementOffset,
 
     if (elementOffset < 0) return ErrorCode::ok;  // no need set
 
+    if (elementOffset == m_vertexDesc.positionOffset()) markPositionsChanged();
     size_t step = m_vertexDesc.totalVertexSize() / sizeof(float);
     size_t pos_count = m_vtxUsedCount - static_cast<size_t>(start);
     if (count < pos_count) pos_count = count;
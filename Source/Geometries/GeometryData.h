@@ -21,6 +21,7 @@
 #include "GameEngine/RenderBufferSignature.h"
 #include "GeometryId.h"
 #include <memory>
+#include <atomic>
 
 namespace Enigma::Geometries
 {
@@ -192,6 +193,11 @@ namespace Enigma::Geometries
         /** resize segment array */
         void resizeSegmentVector(unsigned int new_size) { m_geoSegmentVector.resize(new_size, GeometrySegment()); };
 
+        /** 直接改寫 vertex memory 的 position (ex. terrain 高度) 後要呼叫, 讓依 position 建的快取 (ex. bvh) 失效 */
+        void markPositionsChanged() { m_positionRevision++; }
+        /** position 或 index 每次改變都會增加 */
+        unsigned positionRevision() const { return m_positionRevision; }
+
         /** calculate bounding volume */
         void calculateBoundingVolume(bool axis_align);
         /** get bounding volume */
@@ -229,6 +235,8 @@ namespace Enigma::Geometries
         Graphics::PrimitiveTopology m_topology;
 
         Engine::BoundingVolume m_geometryBound;
+
+        std::atomic<unsigned> m_positionRevision;
     };
 
     using GeometryDataPtr = std::shared_ptr<GeometryData>;
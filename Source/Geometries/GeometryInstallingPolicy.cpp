@@ -8,7 +8,9 @@ using namespace Enigma::Geometries;
 error GeometryInstallingPolicy::install(Frameworks::ServiceManager* service_manager)
 {
     assert(service_manager);
-    service_manager->registerSystemService(std::make_shared<GeometryRepository>(service_manager, m_storeMapper));
+    auto repository = std::make_shared<GeometryRepository>(service_manager, m_storeMapper);
+    if (auto cache = service_manager->assetRetentionCache()) repository->retentionCache(cache);
+    service_manager->registerSystemService(repository);
     return ErrorCode::ok;
 }
 
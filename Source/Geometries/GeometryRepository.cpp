@@ -9,6 +9,7 @@
 #include "Frameworks/CommandBus.h"
 #include "GeometryDataQueries.h"
 #include "Frameworks/QueryDispatcher.h"
+#include "Frameworks/AssetRetentionCache.h"
 #include "GeometryDataFactory.h"
 #include "GeometryCommands.h"
 #include "GeometryErrors.h"
@@ -19,6 +20,8 @@ using namespace Enigma::Frameworks;
 
 DEFINE_RTTI(Geometries, GeometryRepository, ISystemService);
 
+static const std::string RETENTION_CATEGORY = "geometry";
+
 GeometryRepository::GeometryRepository(Frameworks::ServiceManager* srv_manager, const std::shared_ptr<GeometryDataStoreMapper>& store_mapper) : ISystemService(srv_manager)
 {
     m_storeMapper = store_mapper;
@@ -57,6 +60,7 @@ ServiceResult GeometryRepository::onInit()
 
 ServiceResult GeometryRepository::onTerm()
 {
+    if (m_retentionCache) m_retentionCache->releaseCategory(RETENTION_CATEGORY);
     dumpRetainedGeometry();
     m_storeMapper->disconnect();
     m_geometries.clear();
@@ -98,13 +102,29 @@ std::shared_ptr<GeometryData> GeometryRepository::queryGeometryData(const Geomet
     if (!hasGeometryData(id)) return nullptr;
     std::lock_guard locker{ m_geometryLock };
     auto it = m_geometries.find(id);
-    if ((it != m_geometries.end()) && (!it->second.expired())) return it->second.lock();
+    if (it != m_geometries.end())
+    {
+        if (auto geometry = it->second.lock())
+        {
+            if (m_retentionCache)
+            {
+                m_retentionCache->recordHit(RETENTION_CATEGORY);
+                retainGeometryData(id, geometry);
+            }
+            return geometry;
+        }
+    }
     assert(m_factory);
     const auto dto = m_storeMapper->queryGeometry(id);
     assert(dto.has_value());
     auto geometry = m_factory->constitute(id, dto.value(), true);
     assert(geometry);
     m_geometries.insert_or_assign(id, geometry);
+    if (m_retentionCache)
+    {
+        m_retentionCache->recordMiss(RETENTION_CATEGORY);
+        retainGeometryData(id, geometry);
+    }
     return geometry;
 }
 
@@ -175,6 +195,14 @@ void GeometryRepository::removeGeometryData(const Frameworks::ICommandPtr& c)
     removeGeometryData(cmd->id());
 }
 
+void GeometryRepository::retainGeometryData(const GeometryId& id, const std::shared_ptr<GeometryData>& data)
+{
+    if ((!m_retentionCache) || (!data)) return;
+    if (m_retentionCache->touch(RETENTION_CATEGORY, id.name())) return;
+    const size_t bytes = data->getVertexMemory().size() + data->getIndexMemory().size() * sizeof(unsigned int);
+    m_retentionCache->retain(RETENTION_CATEGORY, id.name(), data, bytes);
+}
+
 void GeometryRepository::dumpRetainedGeometry()
 {
     Platforms::Debug::Printf("dump retained geometry\n");
@@ -193,6 +221,7 @@ void GeometryRepository::removeGeometryData(const GeometryId& id)
     if (!hasGeometryData(id)) return;
     std::lock_guard locker{ m_geometryLock };
     m_geometries.erase(id);
+    if (m_retentionCache) m_retentionCache->release(RETENTION_CATEGORY, id.name());
     error er = m_storeMapper->removeGeometry(id);
     if (er)
     {
@@ -18,6 +18,11 @@
 #include <mutex>
 #include <unordered_map>
 
+namespace Enigma::Frameworks
+{
+    class AssetRetentionCache;
+}
+
 namespace Enigma::Geometries
 {
     using error = std::error_code;
@@ -44,6 +49,9 @@ namespace Enigma::Geometries
 
         void registerGeometryFactory(const std::string& rtti_name, const GeometryCreator& creator);
 
+        /** optional, loaded geometries are retained in cache (by vertex & index memory size) after all owners released */
+        void retentionCache(const std::shared_ptr<Frameworks::AssetRetentionCache>& cache) { m_retentionCache = cache; }
+
         bool hasGeometryData(const GeometryId& id);
         std::shared_ptr<GeometryData> queryGeometryData(const GeometryId& id);
         void removeGeometryData(const GeometryId& id);
@@ -58,6 +66,7 @@ namespace Enigma::Geometries
         void putGeometryData(const Frameworks::ICommandPtr& c);
         void removeGeometryData(const Frameworks::ICommandPtr& c);
 
+        void retainGeometryData(const GeometryId& id, const std::shared_ptr<GeometryData>& data);
         void dumpRetainedGeometry();
 
     protected:
@@ -66,6 +75,7 @@ namespace Enigma::Geometries
         //! ADR: 在 repository 中，map 是存放已生成 asset 的 cache, 不擁有asset, 所以改用 weak_ptr
         std::unordered_map<GeometryId, std::weak_ptr<GeometryData>, GeometryId::hash> m_geometries;
         std::recursive_mutex m_geometryLock;
+        std::shared_ptr<Frameworks::AssetRetentionCache> m_retentionCache;
 
         Frameworks::QuerySubscriberPtr m_queryGeometryData;
         Frameworks::QuerySubscriberPtr m_hasGeometryData;
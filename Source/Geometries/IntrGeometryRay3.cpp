@@ -2,7 +2,9 @@
 #include "GameEngine/IntrBVRay3.h"
 #include "IntrGeometryCache.h"
 #include "TriangleList.h"
+#include "TriangleBvh.h"
 #include "MathLib/IntrRay3Triangle3.h"
+#include "MathLib/MathGlobal.h"
 #include "Frameworks/unique_ptr_dynamic_cast.hpp"
 #include <cassert>
 
@@ -10,6 +12,9 @@ using namespace Enigma::Geometries;
 using namespace Enigma::Engine;
 using namespace Enigma::MathLib;
 
+/// 三角形少的 geometry 直接逐一測試, 不值得建 bvh
+static constexpr unsigned MIN_BVH_TRIANGLES = 64;
+
 IntrGeometryRay3::IntrGeometryRay3(const GeometryDataPtr& geo, const Ray3& ray) :
     Intersector(), m_ray(ray), m_geometry(geo)
 {
@@ -114,6 +119,13 @@ Intersector::Result IntrGeometryRay3::testForTriangleList(std::unique_ptr<IntrGe
     unsigned int tri_count = tri_list->getTriangleCount();
     if (tri_count <= 0) return { false, std::move(geo_cache) };
 
+    if (tri_count >= MIN_BVH_TRIANGLES)
+    {
+        if (!tri_list->triangleBvh()->testRay(m_ray.origin(), m_ray.direction(), Math::MAX_FLOAT)) return { false, std::move(geo_cache) };
+        if (geo_cache == nullptr) geo_cache = std::make_unique<IntrGeometryCache>();
+        return { true, std::move(geo_cache) };
+    }
+
     unsigned int start_index = 0;
     if (geo_cache) start_index = geo_cache->getElementCachedIndex();
     unsigned int forward_count = tri_count - start_index;
@@ -168,6 +180,31 @@ Intersector::Result IntrGeometryRay3::findForTriangleList(std::unique_ptr<IntrGe
     if ((geo_cache) && (geo_cache->getRequiredResultCount())) req_result_total = geo_cache->getRequiredResultCount();
     unsigned int result_count = 0;
 
+    if (tri_count >= MIN_BVH_TRIANGLES)
+    {
+        // bvh 依距離排序, 只要求部份結果時拿到的是最近的幾個
+        const auto bvh = tri_list->triangleBvh();
+        std::vector<TriangleBvh::Hit> hits;
+        if (req_result_total == 1)
+        {
+            if (auto hit = bvh->findNearest(m_ray.origin(), m_ray.direction(), Math::MAX_FLOAT)) hits.push_back(hit.value());
+        }
+        else
+        {
+            hits = bvh->findAll(m_ray.origin(), m_ray.direction(), Math::MAX_FLOAT);
+            if (hits.size() > req_result_total) hits.resize(req_result_total);
+        }
+        if (hits.empty()) return { false, std::move(geo_cache) };
+        if (geo_cache == nullptr) geo_cache = std::make_unique<IntrGeometryCache>();
+        geo_cache->setElementCachedIndex(hits.front().m_triangle);
+        for (const auto& hit : hits)
+        {
+            m_tParams.emplace_back(hit.m_t);
+            m_points.emplace_back(hit.m_t * m_ray.direction() + m_ray.origin());
+        }
+        return { true, std::move(geo_cache) };
+    }
+
     Vector3 triangle[3];
     for (unsigned int i = 1; i < test_total; i++) // 從1開始，加減0是一樣的
     {
@@ -0,0 +1,291 @@
+﻿#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+
+using namespace Enigma::Geometries;
+
+// Forsyth 的參數, 模擬的 LRU cache 大小跟分數
+static constexpr unsigned SCORE_CACHE_SIZE = 32;
+static constexpr float CACHE_DECAY_POWER = 1.5f;
+static constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+static constexpr float VALENCE_BOOST_POWER = 0.5f;
+static constexpr unsigned MAX_VALENCE_SCORE = 64;
+
+static std::uint32_t floatBits(float f)
+{
+    f += 0.0f;  // -0 -> +0
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static std::uint64_t hashVertex(const float* vertex, unsigned floats_per_vertex)
+{
+    // FNV-1a over float bits
+    std::uint64_t h = 14695981039346656037ull;
+    for (unsigned i = 0; i < floats_per_vertex; i++)
+    {
+        h ^= floatBits(vertex[i]);
+        h *= 1099511628211ull;
+    }
+    return h ^ (h >> 29);
+}
+
+static bool isSameVertex(const float* a, const float* b, unsigned floats_per_vertex)
+{
+    for (unsigned i = 0; i < floats_per_vertex; i++)
+    {
+        if (floatBits(a[i]) != floatBits(b[i])) return false;
+    }
+    return true;
+}
+
+unsigned MeshOptimizer::weldVertices(const std::vector<float>& vertex_attributes, unsigned floats_per_vertex, std::vector<unsigned>& remap)
+{
+    assert(floats_per_vertex > 0);
+    const unsigned vertex_count = static_cast<unsigned>(vertex_attributes.size() / floats_per_vertex);
+    remap.assign(vertex_count, UNUSED_VERTEX);
+    if (vertex_count == 0) return 0;
+
+    // open addressing table, 存第一個出現的 vertex index
+    size_t table_size = 1;
+    while (table_size < static_cast<size_t>(vertex_count) * 2) table_size <<= 1;
+    std::vector<unsigned> table(table_size, UNUSED_VERTEX);
+    const size_t mask = table_size - 1;
+    unsigned welded_count = 0;
+    for (unsigned i = 0; i < vertex_count; i++)
+    {
+        const float* vertex = &vertex_attributes[static_cast<size_t>(i) * floats_per_vertex];
+        size_t slot = static_cast<size_t>(hashVertex(vertex, floats_per_vertex)) & mask;
+        while (true)
+        {
+            const unsigned candidate = table[slot];
+            if (candidate == UNUSED_VERTEX)
+            {
+                table[slot] = i;
+                remap[i] = welded_count++;
+                break;
+            }
+            if (isSameVertex(vertex, &vertex_attributes[static_cast<size_t>(candidate) * floats_per_vertex], floats_per_vertex))
+            {
+                remap[i] = remap[candidate];
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+    return welded_count;
+}
+
+void MeshOptimizer::remapIndices(std::vector<unsigned>& indices, const std::vector<unsigned>& remap)
+{
+    for (auto& index : indices)
+    {
+        assert(index < remap.size());
+        index = remap[index];
+    }
+}
+
+float MeshOptimizer::calculateAcmr(const std::vector<unsigned>& indices, unsigned vertex_count, unsigned cache_size)
+{
+    const size_t triangle_count = indices.size() / 3;
+    if ((triangle_count == 0) || (cache_size == 0)) return 0.0f;
+    // FIFO cache, 記錄每個 vertex 進 cache 的時間戳
+    std::vector<unsigned> cache_timestamps(vertex_count, 0);
+    unsigned timestamp = cache_size + 1;
+    unsigned misses = 0;
+    for (size_t i = 0; i < triangle_count * 3; i++)
+    {
+        const unsigned index = indices[i];
+        assert(index < vertex_count);
+        if (timestamp - cache_timestamps[index] > cache_size)
+        {
+            cache_timestamps[index] = timestamp++;
+            misses++;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(triangle_count);
+}
+
+namespace
+{
+    struct VertexScoreTable
+    {
+        float m_cache[SCORE_CACHE_SIZE];
+        float m_valence[MAX_VALENCE_SCORE + 1];
+
+        VertexScoreTable()
+        {
+            for (unsigned i = 0; i < SCORE_CACHE_SIZE; i++)
+            {
+                if (i < 3)
+                {
+                    m_cache[i] = LAST_TRIANGLE_SCORE;
+                    continue;
+                }
+                const float scaler = 1.0f / static_cast<float>(SCORE_CACHE_SIZE - 3);
+                m_cache[i] = std::pow(1.0f - static_cast<float>(i - 3) * scaler, CACHE_DECAY_POWER);
+            }
+            m_valence[0] = 0.0f;
+            for (unsigned i = 1; i <= MAX_VALENCE_SCORE; i++)
+            {
+                m_valence[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+            }
+        }
+
+        float score(int cache_position, unsigned remaining_valence) const
+        {
+            if (remaining_valence == 0) return -1.0f;  // 已經沒有 triangle 要用這個 vertex
+            float s = cache_position >= 0 ? m_cache[cache_position] : 0.0f;
+            return s + m_valence[std::min(remaining_valence, MAX_VALENCE_SCORE)];
+        }
+    };
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned>& indices, unsigned vertex_count)
+{
+    const unsigned triangle_count = static_cast<unsigned>(indices.size() / 3);
+    if (triangle_count == 0) return;
+    static const VertexScoreTable score_table;
+
+    // vertex -> triangles adjacency (CSR)
+    std::vector<unsigned> adjacency_offsets(vertex_count + 1, 0);
+    for (unsigned i = 0; i < triangle_count * 3; i++)
+    {
+        assert(indices[i] < vertex_count);
+        adjacency_offsets[indices[i] + 1]++;
+    }
+    for (unsigned v = 0; v < vertex_count; v++)
+    {
+        adjacency_offsets[v + 1] += adjacency_offsets[v];
+    }
+    std::vector<unsigned> adjacency(triangle_count * 3);
+    std::vector<unsigned> remaining_valence(vertex_count, 0);
+    for (unsigned t = 0; t < triangle_count; t++)
+    {
+        for (unsigned k = 0; k < 3; k++)
+        {
+            const unsigned v = indices[t * 3 + k];
+            adjacency[adjacency_offsets[v] + remaining_valence[v]++] = t;
+        }
+    }
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (unsigned v = 0; v < vertex_count; v++)
+    {
+        vertex_score[v] = score_table.score(-1, remaining_valence[v]);
+    }
+    std::vector<float> triangle_score(triangle_count);
+    for (unsigned t = 0; t < triangle_count; t++)
+    {
+        triangle_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+    }
+    std::vector<unsigned char> is_emitted(triangle_count, 0);
+
+    std::vector<unsigned> optimized;
+    optimized.reserve(indices.size());
+    // cache 多留 3 格給剛加入的 triangle
+    std::vector<unsigned> cache;
+    std::vector<unsigned> new_cache;
+    cache.reserve(SCORE_CACHE_SIZE + 3);
+    new_cache.reserve(SCORE_CACHE_SIZE + 3);
+    unsigned scan_cursor = 0;
+    int best_triangle = -1;
+    float best_score = -1.0f;
+    for (unsigned t = 0; t < triangle_count; t++)
+    {
+        if (triangle_score[t] > best_score)
+        {
+            best_score = triangle_score[t];
+            best_triangle = static_cast<int>(t);
+        }
+    }
+
+    for (unsigned emitted = 0; emitted < triangle_count; emitted++)
+    {
+        if (best_triangle < 0)
+        {
+            // cache 內的 vertex 都沒有剩下的 triangle, 找下一個還沒輸出的
+            while ((scan_cursor < triangle_count) && (is_emitted[scan_cursor])) scan_cursor++;
+            assert(scan_cursor < triangle_count);
+            best_triangle = static_cast<int>(scan_cursor);
+        }
+        const unsigned tri = static_cast<unsigned>(best_triangle);
+        is_emitted[tri] = 1;
+        const unsigned tri_vertices[3] = { indices[tri * 3], indices[tri * 3 + 1], indices[tri * 3 + 2] };
+        optimized.insert(optimized.end(), tri_vertices, tri_vertices + 3);
+
+        // 從 adjacency 中移除這個 triangle
+        for (unsigned v : tri_vertices)
+        {
+            const unsigned begin = adjacency_offsets[v];
+            const unsigned end = begin + remaining_valence[v];
+            for (unsigned a = begin; a < end; a++)
+            {
+                if (adjacency[a] != tri) continue;
+                std::swap(adjacency[a], adjacency[end - 1]);
+                break;
+            }
+            remaining_valence[v]--;
+        }
+
+        // LRU : 新 triangle 的 vertex 放最前面
+        new_cache.assign(tri_vertices, tri_vertices + 3);
+        for (unsigned v : cache)
+        {
+            if ((v != tri_vertices[0]) && (v != tri_vertices[1]) && (v != tri_vertices[2])) new_cache.push_back(v);
+        }
+        std::swap(cache, new_cache);
+        for (unsigned c = 0; c < cache.size(); c++)
+        {
+            const unsigned v = cache[c];
+            cache_position[v] = c < SCORE_CACHE_SIZE ? static_cast<int>(c) : -1;
+            const float score = score_table.score(cache_position[v], remaining_valence[v]);
+            const float delta = score - vertex_score[v];
+            vertex_score[v] = score;
+            const unsigned begin = adjacency_offsets[v];
+            for (unsigned a = begin; a < begin + remaining_valence[v]; a++)
+            {
+                triangle_score[adjacency[a]] += delta;
+            }
+        }
+        // 被擠出 cache 的 vertex 已經更新分數, 從 cache 移除
+        if (cache.size() > SCORE_CACHE_SIZE) cache.resize(SCORE_CACHE_SIZE);
+
+        // 下一個 triangle 只從 cache 內 vertex 的 triangle 中選
+        best_triangle = -1;
+        best_score = -1.0f;
+        for (unsigned v : cache)
+        {
+            const unsigned begin = adjacency_offsets[v];
+            for (unsigned a = begin; a < begin + remaining_valence[v]; a++)
+            {
+                const unsigned t = adjacency[a];
+                if (triangle_score[t] > best_score)
+                {
+                    best_score = triangle_score[t];
+                    best_triangle = static_cast<int>(t);
+                }
+            }
+        }
+    }
+    indices = std::move(optimized);
+}
+
+unsigned MeshOptimizer::optimizeVertexFetch(std::vector<unsigned>& indices, unsigned vertex_count, std::vector<unsigned>& remap)
+{
+    remap.assign(vertex_count, UNUSED_VERTEX);
+    unsigned next_vertex = 0;
+    for (auto& index : indices)
+    {
+        assert(index < vertex_count);
+        if (remap[index] == UNUSED_VERTEX) remap[index] = next_vertex++;
+        index = remap[index];
+    }
+    return next_vertex;
+}
@@ -0,0 +1,421 @@
+﻿#include "TriangleBvh.h"
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <cassert>
+
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TRIANGLE_BVH_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TRIANGLE_BVH_NEON
+#include <arm_neon.h>
+#endif
+
+static constexpr unsigned SAH_BIN_COUNT = 12;
+static constexpr unsigned MAX_TRAVERSE_DEPTH = 64;
+static constexpr float PARALLEL_TOLERANCE = 1.0e-12f;
+
+#if defined(TRIANGLE_BVH_SSE)
+using float4 = __m128;
+using mask4 = __m128;
+static inline float4 load4(const float* p) { return _mm_loadu_ps(p); }
+static inline void store4(float* p, float4 v) { _mm_storeu_ps(p, v); }
+static inline float4 set4(float f) { return _mm_set1_ps(f); }
+static inline float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+static inline float4 sub4(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+static inline float4 div4(float4 a, float4 b) { return _mm_div_ps(a, b); }
+static inline float4 abs4(float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline mask4 greater4(float4 a, float4 b) { return _mm_cmpgt_ps(a, b); }
+static inline mask4 greaterEqual4(float4 a, float4 b) { return _mm_cmpge_ps(a, b); }
+static inline mask4 and4(mask4 a, mask4 b) { return _mm_and_ps(a, b); }
+static inline float4 select4(mask4 m, float4 a, float4 b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+#elif defined(TRIANGLE_BVH_NEON)
+using float4 = float32x4_t;
+using mask4 = uint32x4_t;
+static inline float4 load4(const float* p) { return vld1q_f32(p); }
+static inline void store4(float* p, float4 v) { vst1q_f32(p, v); }
+static inline float4 set4(float f) { return vdupq_n_f32(f); }
+static inline float4 add4(float4 a, float4 b) { return vaddq_f32(a, b); }
+static inline float4 sub4(float4 a, float4 b) { return vsubq_f32(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return vmulq_f32(a, b); }
+static inline float4 div4(float4 a, float4 b) { return vdivq_f32(a, b); }
+static inline float4 abs4(float4 a) { return vabsq_f32(a); }
+static inline mask4 greater4(float4 a, float4 b) { return vcgtq_f32(a, b); }
+static inline mask4 greaterEqual4(float4 a, float4 b) { return vcgeq_f32(a, b); }
+static inline mask4 and4(mask4 a, mask4 b) { return vandq_u32(a, b); }
+static inline float4 select4(mask4 m, float4 a, float4 b) { return vbslq_f32(m, a, b); }
+#endif
+
+struct TriangleBvh::Ray
+{
+    std::array<float, 3> m_origin;
+    std::array<float, 3> m_direction;
+    std::array<float, 3> m_invDirection;
+};
+
+static float surfaceArea(const std::array<float, 3>& lo, const std::array<float, 3>& hi)
+{
+    const float dx = hi[0] - lo[0];
+    const float dy = hi[1] - lo[1];
+    const float dz = hi[2] - lo[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+static void growBounds(std::array<float, 3>& lo, std::array<float, 3>& hi, const std::array<float, 3>& other_lo, const std::array<float, 3>& other_hi)
+{
+    for (unsigned a = 0; a < 3; a++)
+    {
+        lo[a] = std::min(lo[a], other_lo[a]);
+        hi[a] = std::max(hi[a], other_hi[a]);
+    }
+}
+
+static bool intersectBox(const TriangleBvh::Node& node, const std::array<float, 3>& origin, const std::array<float, 3>& inv_direction,
+    float max_t, float& t_enter)
+{
+    float t0 = 0.0f;
+    float t1 = max_t;
+    for (unsigned a = 0; a < 3; a++)
+    {
+        // 與軸平行, 起點要在 slab 內
+        if (std::isinf(inv_direction[a]))
+        {
+            if ((origin[a] < node.m_min[a]) || (origin[a] > node.m_max[a])) return false;
+            continue;
+        }
+        float near_t = (node.m_min[a] - origin[a]) * inv_direction[a];
+        float far_t = (node.m_max[a] - origin[a]) * inv_direction[a];
+        if (near_t > far_t) std::swap(near_t, far_t);
+        t0 = std::max(t0, near_t);
+        t1 = std::min(t1, far_t);
+        if (t0 > t1) return false;
+    }
+    t_enter = t0;
+    return true;
+}
+
+TriangleBvh::TriangleBvh(const std::vector<Vector3>& triangle_positions) : m_triangleCount(0), m_depth(0)
+{
+    m_triangleCount = static_cast<unsigned>(triangle_positions.size() / 3);
+    if (m_triangleCount == 0) return;
+    std::vector<BuildTriangle> triangles(m_triangleCount);
+    for (unsigned i = 0; i < m_triangleCount; i++)
+    {
+        BuildTriangle& tri = triangles[i];
+        const Vector3* v = &triangle_positions[static_cast<size_t>(i) * 3];
+        for (unsigned a = 0; a < 3; a++)
+        {
+            tri.m_min[a] = std::min({ v[0][a], v[1][a], v[2][a] });
+            tri.m_max[a] = std::max({ v[0][a], v[1][a], v[2][a] });
+            tri.m_centroid[a] = (tri.m_min[a] + tri.m_max[a]) * 0.5f;
+        }
+        tri.m_index = i;
+    }
+    m_nodes.reserve(static_cast<size_t>(m_triangleCount / PACKET_WIDTH + 1) * 2);
+    m_packets.reserve(m_triangleCount / PACKET_WIDTH + 1);
+    buildNode(triangle_positions, triangles, 0, m_triangleCount, 1);
+}
+
+TriangleBvh::~TriangleBvh()
+{
+    m_nodes.clear();
+    m_packets.clear();
+}
+
+bool TriangleBvh::testRay(const Vector3& origin, const Vector3& direction, float max_t) const
+{
+    const Ray ray{ { origin.x(), origin.y(), origin.z() }, { direction.x(), direction.y(), direction.z() },
+        { 1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z() } };
+    bool is_hit = false;
+    traverse(ray, max_t, [&is_hit, max_t](const TrianglePacket&, const std::array<float, PACKET_WIDTH>& t, float&)
+    {
+        for (unsigned i = 0; i < PACKET_WIDTH; i++)
+        {
+            if ((t[i] >= 0.0f) && (t[i] <= max_t)) is_hit = true;
+        }
+        return !is_hit;
+    });
+    return is_hit;
+}
+
+std::optional<TriangleBvh::Hit> TriangleBvh::findNearest(const Vector3& origin, const Vector3& direction, float max_t) const
+{
+    const Ray ray{ { origin.x(), origin.y(), origin.z() }, { direction.x(), direction.y(), direction.z() },
+        { 1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z() } };
+    std::optional<Hit> nearest;
+    traverse(ray, max_t, [&nearest](const TrianglePacket& packet, const std::array<float, PACKET_WIDTH>& t, float& limit_t)
+    {
+        for (unsigned i = 0; i < PACKET_WIDTH; i++)
+        {
+            if ((t[i] < 0.0f) || (t[i] > limit_t)) continue;
+            // 找到較近的交點後, 更遠的 node 就不必再走
+            limit_t = t[i];
+            nearest = Hit{ t[i], packet.m_triangles[i] };
+        }
+        return true;
+    });
+    return nearest;
+}
+
+std::vector<TriangleBvh::Hit> TriangleBvh::findAll(const Vector3& origin, const Vector3& direction, float max_t) const
+{
+    const Ray ray{ { origin.x(), origin.y(), origin.z() }, { direction.x(), direction.y(), direction.z() },
+        { 1.0f / direction.x(), 1.0f / direction.y(), 1.0f / direction.z() } };
+    std::vector<Hit> hits;
+    traverse(ray, max_t, [&hits](const TrianglePacket& packet, const std::array<float, PACKET_WIDTH>& t, float& limit_t)
+    {
+        for (unsigned i = 0; i < PACKET_WIDTH; i++)
+        {
+            if ((t[i] < 0.0f) || (t[i] > limit_t)) continue;
+            hits.push_back({ t[i], packet.m_triangles[i] });
+        }
+        return true;
+    });
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.m_t < b.m_t; });
+    return hits;
+}
+
+unsigned TriangleBvh::buildNode(const std::vector<Vector3>& positions, std::vector<BuildTriangle>& triangles,
+    unsigned begin, unsigned end, unsigned depth)
+{
+    assert(begin < end);
+    m_depth = std::max(m_depth, depth);
+    const unsigned node_index = static_cast<unsigned>(m_nodes.size());
+    Node node{ triangles[begin].m_min, 0, triangles[begin].m_max, 0 };
+    for (unsigned i = begin + 1; i < end; i++)
+    {
+        growBounds(node.m_min, node.m_max, triangles[i].m_min, triangles[i].m_max);
+    }
+    m_nodes.push_back(node);
+    if (end - begin <= PACKET_WIDTH)
+    {
+        m_nodes[node_index].m_rightOrPacket = static_cast<unsigned>(m_packets.size());
+        m_nodes[node_index].m_triangleCount = end - begin;
+        appendPacket(positions, triangles, begin, end);
+        return node_index;
+    }
+    // 太深時改用對半分, 讓深度不超過走訪時的固定 stack
+    unsigned middle = depth < MAX_TRAVERSE_DEPTH / 2 ? partitionBySah(triangles, begin, end) : begin;
+    if ((middle == begin) || (middle == end))
+    {
+        // 重心都擠在一起, SAH 分不開, 沿最長軸對半分
+        unsigned axis = 0;
+        for (unsigned a = 1; a < 3; a++)
+        {
+            if (node.m_max[a] - node.m_min[a] > node.m_max[axis] - node.m_min[axis]) axis = a;
+        }
+        middle = begin + (end - begin) / 2;
+        std::nth_element(triangles.begin() + begin, triangles.begin() + middle, triangles.begin() + end,
+            [axis](const BuildTriangle& a, const BuildTriangle& b) { return a.m_centroid[axis] < b.m_centroid[axis]; });
+    }
+    buildNode(positions, triangles, begin, middle, depth + 1);
+    const unsigned right = buildNode(positions, triangles, middle, end, depth + 1);
+    m_nodes[node_index].m_rightOrPacket = right;
+    return node_index;
+}
+
+unsigned TriangleBvh::partitionBySah(std::vector<BuildTriangle>& triangles, unsigned begin, unsigned end)
+{
+    std::array<float, 3> centroid_min = triangles[begin].m_centroid;
+    std::array<float, 3> centroid_max = triangles[begin].m_centroid;
+    for (unsigned i = begin + 1; i < end; i++)
+    {
+        growBounds(centroid_min, centroid_max, triangles[i].m_centroid, triangles[i].m_centroid);
+    }
+    struct Bin
+    {
+        std::array<float, 3> m_min;
+        std::array<float, 3> m_max;
+        unsigned m_count;
+    };
+    const float max_float = std::numeric_limits<float>::max();
+    float best_cost = max_float;
+    unsigned best_axis = 0;
+    unsigned best_split = 0;
+    for (unsigned axis = 0; axis < 3; axis++)
+    {
+        const float extent = centroid_max[axis] - centroid_min[axis];
+        if (extent <= 0.0f) continue;
+        const float scale = static_cast<float>(SAH_BIN_COUNT) / extent;
+        std::array<Bin, SAH_BIN_COUNT> bins;
+        bins.fill({ { max_float, max_float, max_float }, { -max_float, -max_float, -max_float }, 0 });
+        for (unsigned i = begin; i < end; i++)
+        {
+            const unsigned b = std::min(SAH_BIN_COUNT - 1, static_cast<unsigned>((triangles[i].m_centroid[axis] - centroid_min[axis]) * scale));
+            growBounds(bins[b].m_min, bins[b].m_max, triangles[i].m_min, triangles[i].m_max);
+            bins[b].m_count++;
+        }
+        // 由右往左累積, 再由左往右掃過每個切分位置
+        std::array<float, SAH_BIN_COUNT> right_area{};
+        std::array<unsigned, SAH_BIN_COUNT> right_count{};
+        std::array<float, 3> lo = { max_float, max_float, max_float };
+        std::array<float, 3> hi = { -max_float, -max_float, -max_float };
+        unsigned count = 0;
+        for (unsigned b = SAH_BIN_COUNT - 1; b > 0; b--)
+        {
+            growBounds(lo, hi, bins[b].m_min, bins[b].m_max);
+            count += bins[b].m_count;
+            right_area[b] = count > 0 ? surfaceArea(lo, hi) : 0.0f;
+            right_count[b] = count;
+        }
+        lo = { max_float, max_float, max_float };
+        hi = { -max_float, -max_float, -max_float };
+        count = 0;
+        for (unsigned split = 1; split < SAH_BIN_COUNT; split++)
+        {
+            growBounds(lo, hi, bins[split - 1].m_min, bins[split - 1].m_max);
+            count += bins[split - 1].m_count;
+            if ((count == 0) || (right_count[split] == 0)) continue;
+            const float cost = surfaceArea(lo, hi) * static_cast<float>(count) + right_area[split] * static_cast<float>(right_count[split]);
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = split;
+            }
+        }
+    }
+    if (best_cost == max_float) return begin;
+    const float extent = centroid_max[best_axis] - centroid_min[best_axis];
+    const float scale = static_cast<float>(SAH_BIN_COUNT) / extent;
+    auto it = std::partition(triangles.begin() + begin, triangles.begin() + end, [&](const BuildTriangle& tri)
+    {
+        return std::min(SAH_BIN_COUNT - 1, static_cast<unsigned>((tri.m_centroid[best_axis] - centroid_min[best_axis]) * scale)) < best_split;
+    });
+    return static_cast<unsigned>(it - triangles.begin());
+}
+
+void TriangleBvh::appendPacket(const std::vector<Vector3>& positions, const std::vector<BuildTriangle>& triangles, unsigned begin, unsigned end)
+{
+    assert(end - begin <= PACKET_WIDTH);
+    TrianglePacket packet{};
+    packet.m_triangles.fill(INVALID_TRIANGLE);
+    // 空的 lane 兩個邊都是 0, determinant 為 0, 不會交到
+    for (unsigned i = 0; i < end - begin; i++)
+    {
+        const unsigned tri = triangles[begin + i].m_index;
+        const Vector3& v0 = positions[static_cast<size_t>(tri) * 3];
+        const Vector3 e1 = positions[static_cast<size_t>(tri) * 3 + 1] - v0;
+        const Vector3 e2 = positions[static_cast<size_t>(tri) * 3 + 2] - v0;
+        packet.m_v0x[i] = v0.x();
+        packet.m_v0y[i] = v0.y();
+        packet.m_v0z[i] = v0.z();
+        packet.m_e1x[i] = e1.x();
+        packet.m_e1y[i] = e1.y();
+        packet.m_e1z[i] = e1.z();
+        packet.m_e2x[i] = e2.x();
+        packet.m_e2y[i] = e2.y();
+        packet.m_e2z[i] = e2.z();
+        packet.m_triangles[i] = tri;
+    }
+    m_packets.push_back(packet);
+}
+
+template <class Visitor> void TriangleBvh::traverse(const Ray& ray, float& max_t, Visitor&& visit) const
+{
+    if (m_nodes.empty()) return;
+    std::array<unsigned, MAX_TRAVERSE_DEPTH> stack;
+    unsigned stack_size = 0;
+    float t_enter;
+    if (!intersectBox(m_nodes[0], ray.m_origin, ray.m_invDirection, max_t, t_enter)) return;
+    stack[stack_size++] = 0;
+    std::array<float, PACKET_WIDTH> t;
+    while (stack_size > 0)
+    {
+        const Node& node = m_nodes[stack[--stack_size]];
+        if (node.m_triangleCount > 0)
+        {
+            intersectPacket(m_packets[node.m_rightOrPacket], ray, t);
+            if (!visit(m_packets[node.m_rightOrPacket], t, max_t)) return;
+            continue;
+        }
+        const unsigned left = static_cast<unsigned>(&node - m_nodes.data()) + 1;
+        const unsigned right = node.m_rightOrPacket;
+        float left_t, right_t;
+        const bool is_left_hit = intersectBox(m_nodes[left], ray.m_origin, ray.m_invDirection, max_t, left_t);
+        const bool is_right_hit = intersectBox(m_nodes[right], ray.m_origin, ray.m_invDirection, max_t, right_t);
+        assert(stack_size + 2 <= MAX_TRAVERSE_DEPTH);
+        // 遠的先進 stack, 近的先走
+        if (is_left_hit && is_right_hit)
+        {
+            stack[stack_size++] = left_t <= right_t ? right : left;
+            stack[stack_size++] = left_t <= right_t ? left : right;
+        }
+        else if (is_left_hit)
+        {
+            stack[stack_size++] = left;
+        }
+        else if (is_right_hit)
+        {
+            stack[stack_size++] = right;
+        }
+    }
+}
+
+void TriangleBvh::intersectPacket(const TrianglePacket& packet, const Ray& ray, std::array<float, PACKET_WIDTH>& t)
+{
+    // Moller-Trumbore, 4 個三角形一起算, 兩面都算
+#if defined(TRIANGLE_BVH_SSE) || defined(TRIANGLE_BVH_NEON)
+    const float4 dx = set4(ray.m_direction[0]);
+    const float4 dy = set4(ray.m_direction[1]);
+    const float4 dz = set4(ray.m_direction[2]);
+    const float4 e1x = load4(packet.m_e1x.data());
+    const float4 e1y = load4(packet.m_e1y.data());
+    const float4 e1z = load4(packet.m_e1z.data());
+    const float4 e2x = load4(packet.m_e2x.data());
+    const float4 e2y = load4(packet.m_e2y.data());
+    const float4 e2z = load4(packet.m_e2z.data());
+    // p = d x e2
+    const float4 px = sub4(mul4(dy, e2z), mul4(dz, e2y));
+    const float4 py = sub4(mul4(dz, e2x), mul4(dx, e2z));
+    const float4 pz = sub4(mul4(dx, e2y), mul4(dy, e2x));
+    const float4 det = add4(add4(mul4(e1x, px), mul4(e1y, py)), mul4(e1z, pz));
+    const float4 inv_det = div4(set4(1.0f), det);
+    const float4 sx = sub4(set4(ray.m_origin[0]), load4(packet.m_v0x.data()));
+    const float4 sy = sub4(set4(ray.m_origin[1]), load4(packet.m_v0y.data()));
+    const float4 sz = sub4(set4(ray.m_origin[2]), load4(packet.m_v0z.data()));
+    const float4 u = mul4(add4(add4(mul4(sx, px), mul4(sy, py)), mul4(sz, pz)), inv_det);
+    // q = s x e1
+    const float4 qx = sub4(mul4(sy, e1z), mul4(sz, e1y));
+    const float4 qy = sub4(mul4(sz, e1x), mul4(sx, e1z));
+    const float4 qz = sub4(mul4(sx, e1y), mul4(sy, e1x));
+    const float4 v = mul4(add4(add4(mul4(dx, qx), mul4(dy, qy)), mul4(dz, qz)), inv_det);
+    const float4 dist = mul4(add4(add4(mul4(e2x, qx), mul4(e2y, qy)), mul4(e2z, qz)), inv_det);
+    const float4 zero = set4(0.0f);
+    mask4 is_hit = greater4(abs4(det), set4(PARALLEL_TOLERANCE));
+    is_hit = and4(is_hit, greaterEqual4(u, zero));
+    is_hit = and4(is_hit, greaterEqual4(v, zero));
+    is_hit = and4(is_hit, greaterEqual4(set4(1.0f), add4(u, v)));
+    is_hit = and4(is_hit, greaterEqual4(dist, zero));
+    store4(t.data(), select4(is_hit, dist, set4(-1.0f)));
+#else
+    for (unsigned i = 0; i < PACKET_WIDTH; i++)
+    {
+        t[i] = -1.0f;
+        const float px = ray.m_direction[1] * packet.m_e2z[i] - ray.m_direction[2] * packet.m_e2y[i];
+        const float py = ray.m_direction[2] * packet.m_e2x[i] - ray.m_direction[0] * packet.m_e2z[i];
+        const float pz = ray.m_direction[0] * packet.m_e2y[i] - ray.m_direction[1] * packet.m_e2x[i];
+        const float det = packet.m_e1x[i] * px + packet.m_e1y[i] * py + packet.m_e1z[i] * pz;
+        if (std::fabs(det) <= PARALLEL_TOLERANCE) continue;
+        const float inv_det = 1.0f / det;
+        const float sx = ray.m_origin[0] - packet.m_v0x[i];
+        const float sy = ray.m_origin[1] - packet.m_v0y[i];
+        const float sz = ray.m_origin[2] - packet.m_v0z[i];
+        const float u = (sx * px + sy * py + sz * pz) * inv_det;
+        if ((u < 0.0f) || (u > 1.0f)) continue;
+        const float qx = sy * packet.m_e1z[i] - sz * packet.m_e1y[i];
+        const float qy = sz * packet.m_e1x[i] - sx * packet.m_e1z[i];
+        const float qz = sx * packet.m_e1y[i] - sy * packet.m_e1x[i];
+        const float v = (ray.m_direction[0] * qx + ray.m_direction[1] * qy + ray.m_direction[2] * qz) * inv_det;
+        if ((v < 0.0f) || (u + v > 1.0f)) continue;
+        const float dist = (packet.m_e2x[i] * qx + packet.m_e2y[i] * qy + packet.m_e2z[i] * qz) * inv_det;
+        if (dist >= 0.0f) t[i] = dist;
+    }
+#endif
+}
@@ -0,0 +1,98 @@
+﻿/*********************************************************************
+ * \file   TriangleBvh.h
+ * \brief  bounding volume hierarchy of triangles, for ray queries
+ *          on triangle list geometry
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include "MathLib/Vector3.h"
+#include <vector>
+#include <array>
+#include <optional>
+
+namespace Enigma::Geometries
+{
+    /** binned SAH 建構, node 攤平成陣列 (左子節點緊接在父節點後), 每個 leaf 最多 4 個三角形,
+     以 SoA packet 存放, 一次用 simd 測 4 個三角形 */
+    class TriangleBvh
+    {
+    public:
+        static constexpr unsigned PACKET_WIDTH = 4;
+        static constexpr unsigned INVALID_TRIANGLE = 0xffffffff;
+
+        struct Hit
+        {
+            float m_t;
+            unsigned m_triangle;
+        };
+
+        struct Node
+        {
+            std::array<float, 3> m_min;
+            /// interior : 右子節點, leaf : packet index
+            unsigned m_rightOrPacket;
+            std::array<float, 3> m_max;
+            /// 0 : interior node, 否則是 leaf 的三角形數
+            unsigned m_triangleCount;
+        };
+
+        struct TrianglePacket
+        {
+            std::array<float, PACKET_WIDTH> m_v0x, m_v0y, m_v0z;
+            std::array<float, PACKET_WIDTH> m_e1x, m_e1y, m_e1z;
+            std::array<float, PACKET_WIDTH> m_e2x, m_e2y, m_e2z;
+            std::array<unsigned, PACKET_WIDTH> m_triangles;
+        };
+
+    public:
+        /** triangle_positions : 每三個點一個三角形, 三角形編號就是在陣列中的順序 */
+        explicit TriangleBvh(const std::vector<MathLib::Vector3>& triangle_positions);
+        TriangleBvh(const TriangleBvh&) = delete;
+        TriangleBvh(TriangleBvh&&) = delete;
+        ~TriangleBvh();
+        TriangleBvh& operator=(const TriangleBvh&) = delete;
+        TriangleBvh& operator=(TriangleBvh&&) = delete;
+
+        unsigned triangleCount() const { return m_triangleCount; }
+        size_t nodeCount() const { return m_nodes.size(); }
+        unsigned depth() const { return m_depth; }
+
+        /** direction 不需要單位長度, t 以 direction 為單位; 只算 0 <= t <= max_t 的交點, 兩面都算 */
+        bool testRay(const MathLib::Vector3& origin, const MathLib::Vector3& direction, float max_t) const;
+        std::optional<Hit> findNearest(const MathLib::Vector3& origin, const MathLib::Vector3& direction, float max_t) const;
+        /** 所有交點, 依 t 排序 */
+        std::vector<Hit> findAll(const MathLib::Vector3& origin, const MathLib::Vector3& direction, float max_t) const;
+
+    protected:
+        struct BuildTriangle
+        {
+            std::array<float, 3> m_min;
+            std::array<float, 3> m_max;
+            std::array<float, 3> m_centroid;
+            unsigned m_index;
+        };
+        struct Ray;
+
+        unsigned buildNode(const std::vector<MathLib::Vector3>& positions, std::vector<BuildTriangle>& triangles,
+            unsigned begin, unsigned end, unsigned depth);
+        static unsigned partitionBySah(std::vector<BuildTriangle>& triangles, unsigned begin, unsigned end);
+        void appendPacket(const std::vector<MathLib::Vector3>& positions, const std::vector<BuildTriangle>& triangles, unsigned begin, unsigned end);
+
+        /** visit(packet) 回傳 false 時停止走訪 */
+        template <class Visitor> void traverse(const Ray& ray, float& max_t, Visitor&& visit) const;
+        /** packet 中 4 個三角形的 t, 沒交到的是 -1 */
+        static void intersectPacket(const TrianglePacket& packet, const Ray& ray, std::array<float, PACKET_WIDTH>& t);
+
+    protected:
+        unsigned m_triangleCount;
+        unsigned m_depth;
+        std::vector<Node> m_nodes;
+        std::vector<TrianglePacket> m_packets;
+    };
+}
+
+#endif // TRIANGLE_BVH_H
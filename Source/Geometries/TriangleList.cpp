@@ -4,6 +4,7 @@
 #include "GeometryErrors.h"
 #include "MathLib/MathAlgorithm.h"
 #include "TriangleListAssembler.h"
+#include "TriangleBvh.h"
 
 using namespace Enigma::Geometries;
 using namespace Enigma::Engine;
@@ -12,7 +13,7 @@ using namespace Enigma::Graphics;
 
 DEFINE_RTTI(Geometries, TriangleList, GeometryData);
 
-TriangleList::TriangleList(const GeometryId& id) : GeometryData(id)
+TriangleList::TriangleList(const GeometryId& id) : GeometryData(id), m_bvhRevision(0)
 {
     m_factoryDesc = FactoryDesc(TriangleList::TYPE_RTTI.getName());
     m_topology = Graphics::PrimitiveTopology::Topology_TriangleList;
@@ -139,3 +140,19 @@ error TriangleList::calculateVertexTangentSpace(unsigned tex_channel)
 
     return ErrorCode::ok;
 }
+
+std::shared_ptr<const TriangleBvh> TriangleList::triangleBvh()
+{
+    std::lock_guard locker{ m_bvhLock };
+    const unsigned revision = positionRevision();
+    if ((m_bvh) && (m_bvhRevision == revision)) return m_bvh;
+    const unsigned tri_count = getTriangleCount();
+    std::vector<Vector3> positions(static_cast<size_t>(tri_count) * 3);
+    for (unsigned i = 0; i < tri_count; i++)
+    {
+        fetchTrianglePos(i, &positions[static_cast<size_t>(i) * 3]);
+    }
+    m_bvh = std::make_shared<TriangleBvh>(positions);
+    m_bvhRevision = revision;
+    return m_bvh;
+}
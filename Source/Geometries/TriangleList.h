@@ -11,10 +11,12 @@
 #include "GeometryData.h"
 #include "GeometryId.h"
 #include <memory>
+#include <mutex>
 
 namespace Enigma::Geometries
 {
     using error = std::error_code;
+    class TriangleBvh;
 
     class TriangleList : public GeometryData
     {
@@ -39,6 +41,14 @@ namespace Enigma::Geometries
 
         /** calculate tangent space */
         error calculateVertexTangentSpace(unsigned int tex_channel);
+
+        /** 第一次查詢時才建立, position / index 改變後下次查詢會重建; 回傳的 bvh 在重建後仍可繼續使用 */
+        std::shared_ptr<const TriangleBvh> triangleBvh();
+
+    protected:
+        std::mutex m_bvhLock;
+        std::shared_ptr<const TriangleBvh> m_bvh;
+        unsigned m_bvhRevision;
     };
     using TriangleListPtr = std::shared_ptr<TriangleList>;
 
@@ -718,6 +718,8 @@ DXGI_FORMAT ConvertGraphicFormatToDXGI(const Enigma::Graphics::GraphicFormat& fo
     case Enigma::Graphics::GraphicFormat::FMT_R32F:           return DXGI_FORMAT_R32_FLOAT;
     case Enigma::Graphics::GraphicFormat::FMT_G32R32F:        return DXGI_FORMAT_R32G32_FLOAT;
     case Enigma::Graphics::GraphicFormat::FMT_A32B32G32R32F:  return DXGI_FORMAT_R32G32B32A32_FLOAT;
+    case Enigma::Graphics::GraphicFormat::FMT_DXT1:           return DXGI_FORMAT_BC1_UNORM;
+    case Enigma::Graphics::GraphicFormat::FMT_DXT5:           return DXGI_FORMAT_BC3_UNORM;
     case Enigma::Graphics::GraphicFormat::FMT_D16_LOCKABLE:
     case Enigma::Graphics::GraphicFormat::FMT_D16:            return DXGI_FORMAT_D16_UNORM;
     case Enigma::Graphics::GraphicFormat::FMT_D32F_LOCKABLE:
@@ -753,6 +755,8 @@ unsigned int ConvertDXGIFormatToGraphicFormat(DXGI_FORMAT fmt)
     case DXGI_FORMAT_D16_UNORM:             return Enigma::Graphics::GraphicFormat::FMT_D16;
     case DXGI_FORMAT_D32_FLOAT:             return Enigma::Graphics::GraphicFormat::FMT_D32;
     case DXGI_FORMAT_D24_UNORM_S8_UINT:     return Enigma::Graphics::GraphicFormat::FMT_D24S8;
+    case DXGI_FORMAT_BC1_UNORM:             return Enigma::Graphics::GraphicFormat::FMT_DXT1;
+    case DXGI_FORMAT_BC3_UNORM:             return Enigma::Graphics::GraphicFormat::FMT_DXT5;
     default: return Enigma::Graphics::GraphicFormat::FMT_UNKNOWN;
     }
 }
@@ -1,6 +1,7 @@
 ﻿#include "PixelShaderDx11.h"
 #include "GraphicAPIDx11.h"
 #include "VertexDeclarationDx11.h"
+#include "ShaderCompilerDx11.h"
 #include "GraphicKernel/GraphicErrors.h"
 #include "GraphicKernel/GraphicEvents.h"
 #include "GraphicKernel/IShaderVariable.h"
@@ -40,33 +41,22 @@ error PixelShaderDx11::CompileCode(const std::string& code, const std::string& p
     assert(graphic);
     if (FATAL_LOG_EXPR(!graphic->GetD3DDevice())) return ErrorCode::d3dDeviceNullPointer;
 
-    size_t code_leng = code.length();
-    ID3DBlob* outBuf = nullptr;
-    ID3DBlob* errorBuf = nullptr;
-    DWORD flag1 = D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR | D3DCOMPILE_ENABLE_BACKWARDS_COMPATIBILITY;
-#ifdef _DEBUG
-    flag1 |= D3DCOMPILE_DEBUG;
-#endif // _DEBUG
-
-    HRESULT hr = D3DCompile(code.c_str(), code_leng, nullptr, nullptr, nullptr,
-        entry.c_str(), profile.c_str(), flag1, 0, &outBuf, &errorBuf);
-    if (FAILED(hr))
+    std::string error_message;
+    auto byte_code = ShaderCompilerDx11::compileByteCode(code, profile, entry, error_message);
+    if (!byte_code)
     {
-        std::string str = string_format("%s Shader Compile Failed : %s", m_name.c_str(), errorBuf->GetBufferPointer());
+        std::string str = string_format("%s Shader Compile Failed : %s", m_name.c_str(), error_message.c_str());
         LOG(Error, str);
-        SAFE_RELEASE(outBuf);
-        SAFE_RELEASE(errorBuf);
         Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::PixelShaderCompileFailed>(m_name, str));
         return ErrorCode::compileShader;
     }
-    SAFE_RELEASE(errorBuf);
-    hr = graphic->GetD3DDevice()->CreatePixelShader(outBuf->GetBufferPointer(), outBuf->GetBufferSize(), NULL, &m_d3dShader);
+    HRESULT hr = graphic->GetD3DDevice()->CreatePixelShader(byte_code->data(), byte_code->size(), NULL, &m_d3dShader);
     //GUID guid = IID_ID3D11ShaderReflection;
     //D3DReflect(outBuf->GetBufferPointer(), outBuf->GetBufferSize(), Fix_IID_ID3D11ShaderReflection,
       //  reinterpret_cast<void**>(&m_d3dShaderReflect));
-    D3DReflect(outBuf->GetBufferPointer(), outBuf->GetBufferSize(), IID_ID3D11ShaderReflection,
+    // reflection 從 byte code 重建, cache 命中時一樣可以取得
+    D3DReflect(byte_code->data(), byte_code->size(), IID_ID3D11ShaderReflection,
         reinterpret_cast<void**>(&m_d3dShaderReflect));
-    SAFE_RELEASE(outBuf);
 
     ParseSemanticTable(code);
     //RetrieveShaderVariables(graphic->GetD3DDevice(), semantic_table, IShaderVariable::VarOfPixelShader);
@@ -0,0 +1,44 @@
+﻿#include "ShaderCompilerDx11.h"
+#include "GraphicKernel/IGraphicAPI.h"
+#include "GraphicKernel/ShaderBinaryCache.h"
+#include "Frameworks/StringFormat.h"
+#include "Platforms/MemoryMacro.h"
+#include <d3dcompiler.h>
+
+using namespace Enigma::Devices;
+
+std::optional<byte_buffer> ShaderCompilerDx11::compileByteCode(const std::string& code, const std::string& profile,
+    const std::string& entry, std::string& error_message)
+{
+    DWORD flag1 = D3DCOMPILE_PACK_MATRIX_COLUMN_MAJOR | D3DCOMPILE_ENABLE_BACKWARDS_COMPATIBILITY;
+#ifdef _DEBUG
+    flag1 |= D3DCOMPILE_DEBUG;
+#endif // _DEBUG
+
+    const auto& cache = Graphics::IGraphicAPI::instance()->shaderBinaryCache();
+    std::uint64_t cache_key = 0;
+    if (cache)
+    {
+        // compile flags 不同, byte code 就不同, 要算進 key
+        cache_key = Graphics::ShaderBinaryCache::makeKey(code, profile, entry, string_format("dx11:%08x", flag1));
+        if (auto binary = cache->load(cache_key)) return binary;
+    }
+
+    ID3DBlob* outBuf = nullptr;
+    ID3DBlob* errorBuf = nullptr;
+    HRESULT hr = D3DCompile(code.c_str(), code.length(), nullptr, nullptr, nullptr,
+        entry.c_str(), profile.c_str(), flag1, 0, &outBuf, &errorBuf);
+    if (FAILED(hr))
+    {
+        error_message = errorBuf ? static_cast<const char*>(errorBuf->GetBufferPointer()) : "";
+        SAFE_RELEASE(outBuf);
+        SAFE_RELEASE(errorBuf);
+        return std::nullopt;
+    }
+    SAFE_RELEASE(errorBuf);
+    byte_buffer byte_code = make_data_buffer(static_cast<unsigned char*>(outBuf->GetBufferPointer()), outBuf->GetBufferSize());
+    SAFE_RELEASE(outBuf);
+
+    if (cache) cache->store(cache_key, byte_code);
+    return byte_code;
+}
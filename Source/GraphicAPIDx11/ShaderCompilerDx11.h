@@ -0,0 +1,27 @@
+﻿/*********************************************************************
+ * \file   ShaderCompilerDx11.h
+ * \brief  hlsl compile to byte code, with shader binary cache lookup
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef SHADER_COMPILER_DX11_H
+#define SHADER_COMPILER_DX11_H
+
+#include "Frameworks/ExtentTypesDefine.h"
+#include <string>
+#include <optional>
+
+namespace Enigma::Devices
+{
+    class ShaderCompilerDx11
+    {
+    public:
+        /** 先查 graphic api 的 shader binary cache, 沒有才用 D3DCompile 編譯, 編譯成功後寫回 cache.
+         *  失敗時回傳 nullopt, error_message 是 compiler 的錯誤訊息 */
+        static std::optional<byte_buffer> compileByteCode(const std::string& code, const std::string& profile,
+            const std::string& entry, std::string& error_message);
+    };
+}
+
+#endif // SHADER_COMPILER_DX11_H
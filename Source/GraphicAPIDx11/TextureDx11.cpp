@@ -5,6 +5,7 @@
 #include "Platforms/PlatformLayer.h"
 #include "GraphicKernel/GraphicErrors.h"
 #include "GraphicKernel/GraphicEvents.h"
+#include "GraphicKernel/TextureContainer.h"
 #include "Frameworks/EventPublisher.h"
 #include "MathLib/Rect.h"
 #include "FileSystem/IFile.h"
@@ -17,6 +18,26 @@ using ErrorCode = Enigma::Graphics::ErrorCode;
 extern DXGI_FORMAT ConvertGraphicFormatToDXGI(const Enigma::Graphics::GraphicFormat& format);
 extern unsigned int ConvertDXGIFormatToGraphicFormat(DXGI_FORMAT fmt);
 
+/** WIC 需要 COM, decode 的 worker thread 第一次用到時初始化, thread 結束時釋放 */
+class ComThreadScope
+{
+public:
+    ComThreadScope() : m_hr(CoInitializeEx(nullptr, COINIT_MULTITHREADED)) {}
+    ComThreadScope(const ComThreadScope&) = delete;
+    ComThreadScope(ComThreadScope&&) = delete;
+    ~ComThreadScope() { if (SUCCEEDED(m_hr)) CoUninitialize(); }
+    ComThreadScope& operator=(const ComThreadScope&) = delete;
+    ComThreadScope& operator=(ComThreadScope&&) = delete;
+
+private:
+    HRESULT m_hr;  ///< 已初始化過時是 S_FALSE, 一樣要配對 CoUninitialize; 已經是 STA 時是 RPC_E_CHANGED_MODE, COM 仍可用
+};
+
+static void ensureComInitialized()
+{
+    thread_local ComThreadScope com_scope;
+}
+
 TextureDx11::TextureDx11(const std::string& name) :ITexture(name)
 {
     m_d3dTextureResource = nullptr;
@@ -100,6 +121,8 @@ error TextureDx11::createFromSystemMemory(const MathLib::Dimension<unsigned>& di
             m_name, ErrorCode::deviceCreateTexture));
         return ErrorCode::deviceCreateTexture;
     }
+    // streaming 會用不同解析度重建同一個 texture, 舊的 resource 要釋放
+    SAFE_RELEASE(m_d3dTextureResource);
     m_d3dTextureResource = d3dResource;
     texture2D->Release();
 
@@ -122,6 +145,8 @@ error TextureDx11::loadTextureImage(const byte_buffer& img_buff)
         return ErrorCode::d3dDeviceNullPointer;
     }
 
+    if (Graphics::TextureContainer::isContainerContent(img_buff.data(), img_buff.size())) return loadContainerImage(img_buff);
+
     SAFE_RELEASE(m_d3dTextureResource);
 
     DirectX::TexMetadata metaData;
@@ -154,6 +179,126 @@ error TextureDx11::loadTextureImage(const byte_buffer& img_buff)
     return ErrorCode::ok;
 }
 
+error TextureDx11::loadContainerImage(const byte_buffer& container_buff)
+{
+    GraphicAPIDx11* api_dx11 = dynamic_cast<GraphicAPIDx11*>(Graphics::IGraphicAPI::instance());
+    assert(api_dx11);
+    ID3D11Device* device = api_dx11->GetD3DDevice();
+    if (FATAL_LOG_EXPR(!device))
+    {
+        Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceLoadImageFailed>(
+            m_name, ErrorCode::d3dDeviceNullPointer));
+        return ErrorCode::d3dDeviceNullPointer;
+    }
+    Graphics::TextureContainer::Header header;
+    std::vector<Graphics::TextureContainer::PayloadView> payloads;
+    error er = Graphics::TextureContainer::parse(container_buff.data(), container_buff.size(), header, payloads);
+    const Graphics::TextureContainer::PayloadView* payload = er ? nullptr : Graphics::TextureContainer::selectPayload(payloads,
+        { Graphics::GraphicFormat::FMT_DXT5, Graphics::GraphicFormat::FMT_DXT1 });
+    if (!payload)
+    {
+        if (!er) er = ErrorCode::textureContainerPayload;
+        Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceLoadImageFailed>(m_name, er));
+        return er;
+    }
+
+    D3D11_TEXTURE2D_DESC tex_desc;
+    ZeroMemory(&tex_desc, sizeof(tex_desc));
+    tex_desc.Width = header.m_dimension.m_width;
+    tex_desc.Height = header.m_dimension.m_height;
+    tex_desc.MipLevels = static_cast<UINT>(payload->m_levels.size());
+    tex_desc.ArraySize = 1;
+    tex_desc.SampleDesc.Count = 1;
+    tex_desc.Format = ConvertGraphicFormatToDXGI(payload->m_format);
+    tex_desc.Usage = D3D11_USAGE_IMMUTABLE;
+    tex_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    // sub resource 直接指到 container buffer, 不需要中間的 decode/copy
+    std::vector<D3D11_SUBRESOURCE_DATA> level_data(payload->m_levels.size());
+    for (size_t i = 0; i < payload->m_levels.size(); i++)
+    {
+        level_data[i].pSysMem = payload->m_levels[i].m_data;
+        level_data[i].SysMemPitch = payload->m_levels[i].m_rowPitch;
+        level_data[i].SysMemSlicePitch = static_cast<UINT>(payload->m_levels[i].m_size);
+    }
+    ID3D11Texture2D* texture2D = nullptr;
+    HRESULT hr = device->CreateTexture2D(&tex_desc, &level_data[0], &texture2D);
+    if (FAILED(hr))
+    {
+        Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceLoadImageFailed>(
+            m_name, ErrorCode::deviceCreateTexture));
+        return ErrorCode::deviceCreateTexture;
+    }
+    D3D11_SHADER_RESOURCE_VIEW_DESC SRDesc;
+    ZeroMemory(&SRDesc, sizeof(SRDesc));
+    SRDesc.Format = tex_desc.Format;
+    SRDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    SRDesc.Texture2D.MostDetailedMip = 0;
+    SRDesc.Texture2D.MipLevels = tex_desc.MipLevels;
+    ID3D11ShaderResourceView* d3dResource = nullptr;
+    hr = device->CreateShaderResourceView(texture2D, &SRDesc, &d3dResource);
+    texture2D->Release();
+    if (FATAL_LOG_EXPR(S_OK != hr))
+    {
+        Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceLoadImageFailed>(
+            m_name, ErrorCode::dxCreateShaderResource));
+        return ErrorCode::dxCreateShaderResource;
+    }
+    SAFE_RELEASE(m_d3dTextureResource);
+    m_d3dTextureResource = d3dResource;
+    m_isCubeTexture = false;
+    m_dimension = header.m_dimension;
+    m_format = payload->m_format;
+
+    Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceImageLoaded>(m_name));
+    return ErrorCode::ok;
+}
+
+error TextureDx11::decodeImage(const byte_buffer& img_buff, MathLib::Dimension<unsigned>& dimension, byte_buffer& rgba_buff)
+{
+    if (img_buff.size() < 4) return ErrorCode::nullMemoryBuffer;
+    if (Graphics::TextureContainer::isContainerContent(img_buff.data(), img_buff.size())) return decodeContainerImage(img_buff, dimension, rgba_buff);
+    ensureComInitialized();
+
+    DirectX::TexMetadata metaData;
+    DirectX::ScratchImage scratchImage;
+    HRESULT hr;
+    if ((img_buff[0] == 'D') && (img_buff[1] == 'D') && (img_buff[2] == 'S') && (img_buff[3] == ' '))
+    {
+        hr = DirectX::LoadFromDDSMemory(&img_buff[0], img_buff.size(), 0, &metaData, scratchImage);
+    }
+    else
+    {
+        hr = DirectX::LoadFromWICMemory(&img_buff[0], img_buff.size(), DirectX::WIC_FLAGS_FORCE_RGB, &metaData, scratchImage);
+    }
+    if (FAILED(hr)) return ErrorCode::dxLoadTexture;
+    if (metaData.arraySize != 1) return ErrorCode::notImplement;  // cube texture 不走 streaming
+
+    const DirectX::Image* image = scratchImage.GetImage(0, 0, 0);
+    if (!image) return ErrorCode::dxLoadTexture;
+    DirectX::ScratchImage rgbaImage;
+    if (image->format != DXGI_FORMAT_R8G8B8A8_UNORM)
+    {
+        if (DirectX::IsCompressed(image->format))
+        {
+            hr = DirectX::Decompress(*image, DXGI_FORMAT_R8G8B8A8_UNORM, rgbaImage);
+        }
+        else
+        {
+            hr = DirectX::Convert(*image, DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, rgbaImage);
+        }
+        if (FAILED(hr)) return ErrorCode::dxLoadTexture;
+        image = rgbaImage.GetImage(0, 0, 0);
+    }
+    dimension = MathLib::Dimension<unsigned>{ static_cast<unsigned>(image->width), static_cast<unsigned>(image->height) };
+    const size_t row_size = image->width * 4;
+    rgba_buff.resize(row_size * image->height);
+    for (size_t y = 0; y < image->height; y++)
+    {
+        memcpy(&rgba_buff[y * row_size], image->pixels + y * image->rowPitch, row_size);
+    }
+    return ErrorCode::ok;
+}
+
 error TextureDx11::retrieveTextureImage(const MathLib::Rect& rcSrc)
 {
     m_retrievedBuff.clear();
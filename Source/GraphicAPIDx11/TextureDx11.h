@@ -28,9 +28,12 @@ namespace Enigma::Devices
 
         ID3D11ShaderResourceView* getD3DResourceView() const { return m_d3dTextureResource; }
 
+        virtual error decodeImage(const byte_buffer& img_buff, MathLib::Dimension<unsigned>& dimension, byte_buffer& rgba_buff) override;
+
     protected:
         virtual error createFromSystemMemory(const MathLib::Dimension<unsigned>& dimension, const byte_buffer& buff) override;
         virtual error loadTextureImage(const byte_buffer& img_buff) override;
+        virtual error loadContainerImage(const byte_buffer& container_buff) override;
         virtual error retrieveTextureImage(const MathLib::Rect& rcSrc) override;
         virtual error updateTextureImage(const MathLib::Rect& rcDest, const byte_buffer& img_buff) override;
         virtual error saveTextureImage(const FileSystem::IFilePtr& file) override;
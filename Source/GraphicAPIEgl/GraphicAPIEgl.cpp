@@ -24,7 +24,10 @@
 #if TARGET_PLATFORM == PLATFORM_ANDROID
 #include <GLES3/gl3.h>
 #include <GLES3/gl3ext.h>
+#include <EGL/egl.h>
 #endif
+#include <cstdio>
+#include <cstring>
 
 using namespace Enigma::Devices;
 using namespace Enigma::Platforms;
@@ -32,6 +35,42 @@ using ErrorCode = Enigma::Graphics::ErrorCode;
 
 GLenum PrimitiveTopologyToGL(Enigma::Graphics::PrimitiveTopology pt);
 
+/// GLES 3.2 或 EXT/OES_draw_elements_base_vertex 才有, 不能看編譯時的 API level, 要看執行時的 driver
+typedef void (GL_APIENTRYP DrawElementsBaseVertexProc)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint basevertex);
+static DrawElementsBaseVertexProc s_drawElementsBaseVertex = nullptr;
+
+static bool hasGlExtension(const char* extensions, const char* name)
+{
+    if ((!extensions) || (!name)) return false;
+    const size_t name_length = strlen(name);
+    for (const char* found = strstr(extensions, name); found; found = strstr(found + name_length, name))
+    {
+        const bool is_token_begin = (found == extensions) || (found[-1] == ' ');
+        const bool is_token_end = (found[name_length] == ' ') || (found[name_length] == '\0');
+        if (is_token_begin && is_token_end) return true;
+    }
+    return false;
+}
+
+static DrawElementsBaseVertexProc loadDrawElementsBaseVertex(const char* version, const char* extensions)
+{
+    int major = 0;
+    int minor = 0;
+    if ((version) && (sscanf(version, "OpenGL ES %d.%d", &major, &minor) == 2) && ((major > 3) || ((major == 3) && (minor >= 2))))
+    {
+        if (auto proc = reinterpret_cast<DrawElementsBaseVertexProc>(eglGetProcAddress("glDrawElementsBaseVertex"))) return proc;
+    }
+    if (hasGlExtension(extensions, "GL_EXT_draw_elements_base_vertex"))
+    {
+        if (auto proc = reinterpret_cast<DrawElementsBaseVertexProc>(eglGetProcAddress("glDrawElementsBaseVertexEXT"))) return proc;
+    }
+    if (hasGlExtension(extensions, "GL_OES_draw_elements_base_vertex"))
+    {
+        if (auto proc = reinterpret_cast<DrawElementsBaseVertexProc>(eglGetProcAddress("glDrawElementsBaseVertexOES"))) return proc;
+    }
+    return nullptr;
+}
+
 GraphicAPIEgl::GraphicAPIEgl() : IGraphicAPI(AsyncType::NotAsyncDevice), m_surfaceDimension{ 1, 1 }
 {
     m_apiVersion = APIVersion::API_EGL;
@@ -51,6 +90,9 @@ error GraphicAPIEgl::createDevice(const Graphics::DeviceRequiredBits& rqb, void*
     Debug::Printf("Version %s", versionStr);
     const char* extentStr = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
     Debug::Printf("Extensions %s", extentStr);
+    s_drawElementsBaseVertex = loadDrawElementsBaseVertex(versionStr, extentStr);
+    m_isBaseVertexDrawSupported = s_drawElementsBaseVertex != nullptr;
+    Debug::Printf("Base vertex draw %s", m_isBaseVertexDrawSupported ? "supported" : "not supported");
     return ErrorCode::ok;
 }
 
@@ -90,9 +132,19 @@ error GraphicAPIEgl::drawPrimitive(unsigned vertexCount, unsigned vertexOffset)
 
 error GraphicAPIEgl::drawIndexedPrimitive(unsigned indexCount, unsigned vertexCount, unsigned indexOffset, int baseVertexOffset)
 {
-    // GLES 3.0 才有
-    glDrawRangeElements(PrimitiveTopologyToGL(m_boundTopology), baseVertexOffset, baseVertexOffset + vertexCount - 1,
-        static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, nullptr);
+    // GLES 3.0 沒有 base vertex, index 值要自己含 vertex 位移 (render buffer arena 上傳時已經加上);
+    // 不能用 glDrawRangeElements, 因為 index 值不在 [baseVertexOffset, baseVertexOffset + vertexCount) 範圍內.
+    // 共用 index pattern 的 geometry (ex. terrain chunk) 需要 base vertex, driver 不支援時那些 geometry 會退回不需要 base vertex 的版本
+    const void* index_offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(indexOffset) * sizeof(unsigned int));
+    if (baseVertexOffset != 0)
+    {
+        // 忽略 base vertex 會畫出錯的三角形, 寧可不畫
+        if (FATAL_LOG_EXPR(!s_drawElementsBaseVertex)) return ErrorCode::baseVertexNotSupported;
+        s_drawElementsBaseVertex(PrimitiveTopologyToGL(m_boundTopology), static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT,
+            index_offset, baseVertexOffset);
+        return ErrorCode::ok;
+    }
+    glDrawElements(PrimitiveTopologyToGL(m_boundTopology), static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, index_offset);
     return ErrorCode::ok;
 }
 
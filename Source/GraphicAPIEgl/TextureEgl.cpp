@@ -4,6 +4,7 @@
 #include "Platforms/PlatformLayer.h"
 #include "GraphicKernel/GraphicErrors.h"
 #include "GraphicKernel/GraphicEvents.h"
+#include "GraphicKernel/TextureContainer.h"
 #include "Frameworks/EventPublisher.h"
 #include "MathLib/Rect.h"
 #include <cassert>
@@ -57,39 +58,99 @@ error TextureEgl::createFromSystemMemory(const MathLib::Dimension<unsigned>& dim
 
 error TextureEgl::loadTextureImage(const byte_buffer& img_buff)
 {
-    if (FATAL_LOG_EXPR(img_buff.empty()))
+    if (Graphics::TextureContainer::isContainerContent(img_buff.data(), img_buff.size())) return loadContainerImage(img_buff);
+    MathLib::Dimension<unsigned> dimension{ 0, 0 };
+    byte_buffer raw_buffer;
+    error er = decodeImage(img_buff, dimension, raw_buffer);
+    if (er)
     {
-        Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceLoadImageFailed>(
-            m_name, ErrorCode::nullMemoryBuffer));
-        return ErrorCode::nullMemoryBuffer;
+        if (er != ErrorCode::pngFileFormat)
+        {
+            Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceLoadImageFailed>(m_name, er));
+        }
+        return er;
     }
-    if (png_check_sig((const unsigned char*)&img_buff[0], 8))
+    createFromSystemMemory(dimension, raw_buffer);
+
+    Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceImageLoaded>(m_name));
+
+    return ErrorCode::ok;
+}
+
+error TextureEgl::loadContainerImage(const byte_buffer& container_buff)
+{
+    Graphics::TextureContainer::Header header;
+    std::vector<Graphics::TextureContainer::PayloadView> payloads;
+    error er = Graphics::TextureContainer::parse(container_buff.data(), container_buff.size(), header, payloads);
+    // ETC2 是 GLES 3.0 必須支援的格式
+    const Graphics::TextureContainer::PayloadView* payload = er ? nullptr : Graphics::TextureContainer::selectPayload(payloads,
+        { Graphics::GraphicFormat::FMT_ETC2_RGBA8, Graphics::GraphicFormat::FMT_ETC2_RGB8 });
+    if (!payload)
     {
-        png_image image;
-        memset(&image, 0, sizeof(image));
-        image.version = PNG_IMAGE_VERSION;
-        int res = png_image_begin_read_from_memory(&image, &img_buff[0], img_buff.size());
-        if (res == 0) return ErrorCode::eglLoadTexture;
-        byte_buffer raw_buffer;
-        image.format = PNG_FORMAT_RGBA;
-        unsigned int raw_buffer_size = PNG_IMAGE_SIZE(image);
-        raw_buffer.resize(raw_buffer_size);
-        res = png_image_finish_read(&image, NULL, &raw_buffer[0], 0, NULL);
-        if (res == 0)
+        if (!er) er = ErrorCode::textureContainerPayload;
+        Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceLoadImageFailed>(m_name, er));
+        return er;
+    }
+    if (m_texture != 0)
+    {
+        glDeleteTextures(1, &m_texture);
+        m_texture = 0;
+    }
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // level data 直接從 container buffer 上傳, 不需要 decode
+    for (size_t i = 0; i < payload->m_levels.size(); i++)
+    {
+        const auto& level = payload->m_levels[i];
+        if (payload->m_format.fmt == Graphics::GraphicFormat::FMT_A8B8G8R8)
+        {
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), GL_RGBA, static_cast<GLsizei>(level.m_dimension.m_width), static_cast<GLsizei>(level.m_dimension.m_height),
+                0, GL_RGBA, GL_UNSIGNED_BYTE, level.m_data);
+        }
+        else
         {
-            Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceLoadImageFailed>(
-                m_name, ErrorCode::eglLoadTexture));
-            return ErrorCode::eglLoadTexture;
+            const GLenum gl_format = payload->m_format.fmt == Graphics::GraphicFormat::FMT_ETC2_RGBA8 ? GL_COMPRESSED_RGBA8_ETC2_EAC : GL_COMPRESSED_RGB8_ETC2;
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), gl_format, static_cast<GLsizei>(level.m_dimension.m_width), static_cast<GLsizei>(level.m_dimension.m_height),
+                0, static_cast<GLsizei>(level.m_size), level.m_data);
         }
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(payload->m_levels.size() - 1));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_isCubeTexture = false;
+    m_dimension = header.m_dimension;
+    m_format = payload->m_format;
 
-        createFromSystemMemory(MathLib::Dimension<unsigned>{ image.width, image.height }, raw_buffer);
-        png_image_free(&image);
+    Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceImageLoaded>(m_name));
+
+    return ErrorCode::ok;
+}
 
-        Frameworks::EventPublisher::enqueue(std::make_shared<Graphics::TextureResourceImageLoaded>(m_name));
+error TextureEgl::decodeImage(const byte_buffer& img_buff, MathLib::Dimension<unsigned>& dimension, byte_buffer& rgba_buff)
+{
+    if (FATAL_LOG_EXPR(img_buff.size() < 8)) return ErrorCode::nullMemoryBuffer;
+    if (Graphics::TextureContainer::isContainerContent(img_buff.data(), img_buff.size())) return decodeContainerImage(img_buff, dimension, rgba_buff);
+    if (!png_check_sig((const unsigned char*)&img_buff[0], 8)) return ErrorCode::pngFileFormat;
 
-        return ErrorCode::ok;
+    // png_image 的狀態都在 local, 可以在 worker thread 上同時 decode
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    int res = png_image_begin_read_from_memory(&image, &img_buff[0], img_buff.size());
+    if (res == 0) return ErrorCode::eglLoadTexture;
+    image.format = PNG_FORMAT_RGBA;
+    unsigned int raw_buffer_size = PNG_IMAGE_SIZE(image);
+    rgba_buff.resize(raw_buffer_size);
+    res = png_image_finish_read(&image, NULL, &rgba_buff[0], 0, NULL);
+    if (res == 0)
+    {
+        png_image_free(&image);
+        return ErrorCode::eglLoadTexture;
     }
-    return ErrorCode::pngFileFormat;
+    dimension = MathLib::Dimension<unsigned>{ image.width, image.height };
+    png_image_free(&image);
+    return ErrorCode::ok;
 }
 
 error TextureEgl::retrieveTextureImage(const MathLib::Rect& rcSrc)
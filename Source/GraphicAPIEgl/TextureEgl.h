@@ -27,9 +27,12 @@ namespace Enigma::Devices
         TextureEgl& operator=(TextureEgl&&) = delete;
 
         GLuint GetTextureHandle() const { return m_texture; }
+
+        virtual error decodeImage(const byte_buffer& img_buff, MathLib::Dimension<unsigned>& dimension, byte_buffer& rgba_buff) override;
     protected:
         virtual error createFromSystemMemory(const MathLib::Dimension<unsigned>& dimension, const byte_buffer& buff) override;
         virtual error loadTextureImage(const byte_buffer& img_buff) override;
+        virtual error loadContainerImage(const byte_buffer& container_buff) override;
         virtual error retrieveTextureImage(const MathLib::Rect& rcSrc) override;
         virtual error updateTextureImage(const MathLib::Rect& rcDest, const byte_buffer& img_buff) override;
         virtual error saveTextureImage(const FileSystem::IFilePtr& file) override;
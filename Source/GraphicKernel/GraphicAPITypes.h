@@ -65,6 +65,8 @@ namespace Enigma::Graphics
             FMT_DXT3 = EN_MAKEFOURCC('D', 'X', 'T', '3'),     /**< DXT3          */
             FMT_DXT4 = EN_MAKEFOURCC('D', 'X', 'T', '4'),     /**< DXT4          */
             FMT_DXT5 = EN_MAKEFOURCC('D', 'X', 'T', '5'),     /**< DXT5          */
+            FMT_ETC2_RGB8 = EN_MAKEFOURCC('E', 'T', 'C', '2'),     /**< ETC2 RGB8     */
+            FMT_ETC2_RGBA8 = EN_MAKEFOURCC('E', 'T', 'C', 'A'),     /**< ETC2 RGBA8 (EAC alpha) */
 
             FMT_D16_LOCKABLE = 70,     /**<  D16_LOCKABLE    */
             FMT_D32 = 71,     /**<  D32             */
@@ -44,6 +44,8 @@ std::string ErrorCategory::message(int err) const
     case ErrorCode::eglLoadTexture: return "Egl Load Texture fail";
     case ErrorCode::nullEglTexture: return "null egl texture error";
     case ErrorCode::pngFileFormat: return "png file format error";
+    case ErrorCode::textureContainerFormat: return "texture container format error";
+    case ErrorCode::textureContainerPayload: return "no texture container payload supported by device";
 
     case ErrorCode::deviceCreateVertexBuffer: return "Device create vertex buffer fail";
     case ErrorCode::deviceCreateIndexBuffer: return "Device create index buffer fail";
@@ -52,6 +54,7 @@ std::string ErrorCategory::message(int err) const
     case ErrorCode::nullVertexBuffer: return "null vertex buffer";
     case ErrorCode::nullIndexBuffer: return "null index buffer";
     case ErrorCode::eglBufferMapping: return "egl vertex / index buffer mapping fail";
+    case ErrorCode::baseVertexNotSupported: return "device does not support drawing with base vertex";
 
     case ErrorCode::deviceCreateVertexShader: return "device create vertex shader fail";
     case ErrorCode::deviceCreatePixelShader: return "device create pixel shader fail";
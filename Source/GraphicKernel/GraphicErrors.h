@@ -48,6 +48,8 @@ namespace Enigma::Graphics
         eglLoadTexture,
         pngFileFormat,
         nullEglTexture,
+        textureContainerFormat,
+        textureContainerPayload,
 
         deviceCreateVertexBuffer = 1301,
         deviceCreateIndexBuffer,
@@ -56,6 +58,7 @@ namespace Enigma::Graphics
         nullVertexBuffer,
         nullIndexBuffer,
         eglBufferMapping,
+        baseVertexNotSupported,
 
         deviceCreateVertexShader = 1401,
         deviceCreatePixelShader,
@@ -4,6 +4,7 @@
 #include "GraphicCommands.h"
 #include "MathLib/ColorRGBA.h"
 #include "Frameworks/CommandBus.h"
+#include "Frameworks/FrameProfiler.h"
 #include "Platforms/PlatformLayer.h"
 #include <cassert>
 #include <memory>
@@ -12,7 +13,7 @@ using namespace Enigma::Graphics;
 
 IGraphicAPI* IGraphicAPI::m_instance = nullptr;
 
-IGraphicAPI::IGraphicAPI(AsyncType async) : m_wnd(nullptr), m_apiVersion(APIVersion::API_Unknown), m_boundTopology(PrimitiveTopology::Topology_Undefine)
+IGraphicAPI::IGraphicAPI(AsyncType async) : m_wnd(nullptr), m_apiVersion(APIVersion::API_Unknown), m_isBaseVertexDrawSupported(true), m_boundTopology(PrimitiveTopology::Topology_Undefine)
 {
     assert(!m_instance);
     m_instance = this;
@@ -244,6 +245,7 @@ void IGraphicAPI::endScene()
 
 void IGraphicAPI::draw(unsigned vertexCount, unsigned vertexOffset)
 {
+    PROFILE_COUNTER(DrawCall, 1);
     if (UseAsync())
     {
         asyncDrawPrimitive(vertexCount, vertexOffset);
@@ -256,6 +258,7 @@ void IGraphicAPI::draw(unsigned vertexCount, unsigned vertexOffset)
 
 void IGraphicAPI::draw(unsigned indexCount, unsigned vertexCount, unsigned indexOffset, int baseVertexOffset)
 {
+    PROFILE_COUNTER(DrawCall, 1);
     if (UseAsync())
     {
         asyncDrawIndexedPrimitive(indexCount, vertexCount, indexOffset, baseVertexOffset);
@@ -293,6 +296,7 @@ void IGraphicAPI::flip()
 
 void IGraphicAPI::bind(const IBackSurfacePtr& back_surface, const IDepthStencilSurfacePtr& depth_surface)
 {
+    PROFILE_COUNTER(Bind, 1);
     if (UseAsync())
     {
         AsyncBindBackSurface(back_surface, depth_surface);
@@ -305,6 +309,7 @@ void IGraphicAPI::bind(const IBackSurfacePtr& back_surface, const IDepthStencilS
 
 void IGraphicAPI::bind(const TargetViewPort& vp)
 {
+    PROFILE_COUNTER(Bind, 1);
     if (UseAsync())
     {
         AsyncBindViewPort(vp);
@@ -317,6 +322,7 @@ void IGraphicAPI::bind(const TargetViewPort& vp)
 
 void IGraphicAPI::bind(const IShaderProgramPtr& shader)
 {
+    PROFILE_COUNTER(Bind, 1);
     if (UseAsync())
     {
         AsyncBindShaderProgram(shader);
@@ -329,6 +335,7 @@ void IGraphicAPI::bind(const IShaderProgramPtr& shader)
 
 void IGraphicAPI::bind(const IVertexBufferPtr& buffer, PrimitiveTopology pt)
 {
+    PROFILE_COUNTER(Bind, 1);
     if (UseAsync())
     {
         AsyncBindVertexBuffer(buffer, pt);
@@ -341,6 +348,7 @@ void IGraphicAPI::bind(const IVertexBufferPtr& buffer, PrimitiveTopology pt)
 
 void IGraphicAPI::bind(const IIndexBufferPtr& buffer)
 {
+    PROFILE_COUNTER(Bind, 1);
     if (UseAsync())
     {
         AsyncBindIndexBuffer(buffer);
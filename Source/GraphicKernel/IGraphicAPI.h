@@ -53,6 +53,7 @@ namespace Enigma::Graphics
     using IIndexBufferPtr = std::shared_ptr<IIndexBuffer>;
     class TargetViewPort;
     class AssetRepository;
+    class ShaderBinaryCache;
 
     class IGraphicAPI
     {
@@ -97,6 +98,8 @@ namespace Enigma::Graphics
         virtual void bind(const IIndexBufferPtr& buffer);
 
         bool UseAsync() const { return m_async == AsyncType::UseAsyncDevice; }
+        /** draw 可以帶 base vertex (共用 index pattern 的 geometry 需要); device 建立之後才確定 */
+        bool isBaseVertexDrawSupported() const { return m_isBaseVertexDrawSupported; }
         virtual const DeviceRequiredBits& GetDeviceRequiredBits() { return m_deviceRequiredBits; };
 
         virtual const IBackSurfacePtr& CurrentBoundBackSurface() const { return m_boundBackSurface; }
@@ -135,6 +138,10 @@ namespace Enigma::Graphics
             return m_stash->HasData(asset_key);
         }
 
+        /** compiled shader binary cache, null 表示不使用 cache, shader compile 會在這裡查詢/寫入 */
+        void setShaderBinaryCache(const std::shared_ptr<ShaderBinaryCache>& cache) { m_shaderBinaryCache = cache; }
+        const std::shared_ptr<ShaderBinaryCache>& shaderBinaryCache() const { return m_shaderBinaryCache; }
+
     protected:
         void subscribeHandlers();
         void unsubscribeHandlers();
@@ -339,12 +346,14 @@ namespace Enigma::Graphics
         void* m_wnd;
         DeviceRequiredBits m_deviceRequiredBits;
         APIVersion m_apiVersion;
+        bool m_isBaseVertexDrawSupported;
 
         GraphicFormat m_fmtBackSurface;
         GraphicFormat m_fmtDepthSurface;
 
         GraphicThread* m_workerThread;
         AssetStash* m_stash;
+        std::shared_ptr<ShaderBinaryCache> m_shaderBinaryCache;
 
         IBackSurfacePtr m_boundBackSurface;
         IDepthStencilSurfacePtr m_boundDepthSurface;
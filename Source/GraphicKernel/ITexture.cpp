@@ -2,6 +2,7 @@
 #include "IGraphicAPI.h"
 #include "GraphicThread.h"
 #include "GraphicErrors.h"
+#include "TextureContainer.h"
 #include "MathLib/Rect.h"
 #include "FileSystem/FileSystem.h"
 #include "FileSystem/Filename.h"
@@ -99,6 +100,29 @@ void ITexture::retrieve(const MathLib::Rect& rcSrc)
     }
 }
 
+error ITexture::decodeImage(const byte_buffer&, MathLib::Dimension<unsigned>&, byte_buffer&)
+{
+    return ErrorCode::notImplement;
+}
+
+error ITexture::loadContainerImage(const byte_buffer&)
+{
+    return ErrorCode::notImplement;
+}
+
+error ITexture::decodeContainerImage(const byte_buffer& container_buff, MathLib::Dimension<unsigned>& dimension, byte_buffer& rgba_buff)
+{
+    TextureContainer::Header header;
+    std::vector<TextureContainer::PayloadView> payloads;
+    if (error er = TextureContainer::parse(container_buff.data(), container_buff.size(), header, payloads)) return er;
+    const TextureContainer::PayloadView* payload = TextureContainer::selectPayload(payloads, {});
+    if (!payload) return ErrorCode::notImplement;
+    const TextureContainer::LevelView& level = payload->m_levels[0];
+    dimension = level.m_dimension;
+    rgba_buff.assign(level.m_data, level.m_data + level.m_size);
+    return ErrorCode::ok;
+}
+
 error ITexture::loadTextureImage(const std::string& filename, const std::string& pathid)
 {
     FileSystem::Filename filename_at_path(filename, pathid);
@@ -63,9 +63,17 @@ namespace Enigma::Graphics
 
         virtual bool isMultiTexture() { return false; }
 
+        /** decode image file content to RGBA8 pixels on cpu, no device access,
+         *  can be called from worker threads (texture streaming decode images off the graphic thread) */
+        virtual error decodeImage(const byte_buffer& img_buff, MathLib::Dimension<unsigned>& dimension, byte_buffer& rgba_buff);
+
     protected:
         virtual error loadTextureImage(const byte_buffer& img_buff) = 0;
         virtual error loadTextureImage(const std::string& filename, const std::string& pathid);
+        /** pre-processed texture container (.etex), device 直接從 container buffer 上傳整個 mip chain */
+        virtual error loadContainerImage(const byte_buffer& container_buff);
+        /** container 的 raw RGBA8 payload level 0, 沒有 raw payload 時回傳 notImplement */
+        error decodeContainerImage(const byte_buffer& container_buff, MathLib::Dimension<unsigned>& dimension, byte_buffer& rgba_buff);
         virtual error createFromSystemMemory(const MathLib::Dimension<unsigned>& dimension, const byte_buffer& buff) = 0;
         virtual error saveTextureImage(const FileSystem::IFilePtr& file) = 0;
         virtual error retrieveTextureImage(const MathLib::Rect& rcSrc) = 0;
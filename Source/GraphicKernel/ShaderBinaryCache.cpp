@@ -0,0 +1,119 @@
+﻿#include "ShaderBinaryCache.h"
+#include "GraphicErrors.h"
+#include "FileSystem/FileSystem.h"
+#include "Frameworks/StringFormat.h"
+#include <cstring>
+
+using namespace Enigma::Graphics;
+
+static constexpr char CACHE_MAGIC[4] = { 'E', 'S', 'B', 'C' };
+static constexpr std::uint32_t CACHE_VERSION = 1;
+static constexpr size_t CACHE_HEADER_SIZE = sizeof(CACHE_MAGIC) + sizeof(std::uint32_t) + sizeof(std::uint64_t) + sizeof(std::uint32_t);
+
+static std::string defaultCachePathID = std::string("SHADER_BINARY_CACHE_PATH");
+
+static std::uint64_t hashFnv1a(std::uint64_t hash, const std::string& s)
+{
+    constexpr std::uint64_t fnv_prime = 0x100000001b3ull;
+    for (unsigned char c : s)
+    {
+        hash ^= c;
+        hash *= fnv_prime;
+    }
+    // 字串之間加分隔, 避免 "ab"+"c" 跟 "a"+"bc" 相同
+    hash ^= 0xff;
+    hash *= fnv_prime;
+    return hash;
+}
+
+ShaderBinaryCache::ShaderBinaryCache(const std::string& cache_path_id) : m_pathId(cache_path_id)
+{
+}
+
+ShaderBinaryCache::~ShaderBinaryCache()
+{
+}
+
+std::uint64_t ShaderBinaryCache::makeKey(const std::string& code, const std::string& profile, const std::string& entry, const std::string& compiler_tag)
+{
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hashFnv1a(hash, code);
+    hash = hashFnv1a(hash, profile);
+    hash = hashFnv1a(hash, entry);
+    hash = hashFnv1a(hash, compiler_tag);
+    return hash;
+}
+
+const std::string& ShaderBinaryCache::getDefaultCachePathID()
+{
+    return defaultCachePathID;
+}
+
+std::optional<byte_buffer> ShaderBinaryCache::load(std::uint64_t key)
+{
+    auto file = FileSystem::FileSystem::instance()->openFile(cacheFilename(key), FileSystem::read | FileSystem::binary);
+    std::optional<byte_buffer> binary;
+    if (file)
+    {
+        const size_t file_size = file->size();
+        auto content = file->read(0, file_size);
+        FileSystem::FileSystem::instance()->closeFile(file);
+        if ((content) && (content->size() > CACHE_HEADER_SIZE) && (std::memcmp(content->data(), CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0))
+        {
+            std::uint32_t version;
+            std::uint64_t stored_key;
+            std::uint32_t binary_size;
+            const unsigned char* cursor = content->data() + sizeof(CACHE_MAGIC);
+            std::memcpy(&version, cursor, sizeof(version));
+            cursor += sizeof(version);
+            std::memcpy(&stored_key, cursor, sizeof(stored_key));
+            cursor += sizeof(stored_key);
+            std::memcpy(&binary_size, cursor, sizeof(binary_size));
+            if ((version == CACHE_VERSION) && (stored_key == key) && (binary_size == content->size() - CACHE_HEADER_SIZE))
+            {
+                binary = byte_buffer(content->begin() + CACHE_HEADER_SIZE, content->end());
+            }
+        }
+    }
+    std::lock_guard locker{ m_lock };
+    if (binary) m_statistics.m_hits++;
+    else m_statistics.m_misses++;
+    return binary;
+}
+
+error ShaderBinaryCache::store(std::uint64_t key, const byte_buffer& binary)
+{
+    if (binary.empty()) return ErrorCode::nullMemoryBuffer;
+    byte_buffer content(CACHE_HEADER_SIZE);
+    unsigned char* cursor = content.data();
+    std::memcpy(cursor, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    cursor += sizeof(CACHE_MAGIC);
+    std::memcpy(cursor, &CACHE_VERSION, sizeof(CACHE_VERSION));
+    cursor += sizeof(CACHE_VERSION);
+    std::memcpy(cursor, &key, sizeof(key));
+    cursor += sizeof(key);
+    const auto binary_size = static_cast<std::uint32_t>(binary.size());
+    std::memcpy(cursor, &binary_size, sizeof(binary_size));
+    content.insert(content.end(), binary.begin(), binary.end());
+
+    // 同一個 key 可能被兩個 shader 同時寫入, 寫檔時鎖住
+    std::lock_guard locker{ m_lock };
+    auto file = FileSystem::FileSystem::instance()->openFile(cacheFilename(key), FileSystem::write | FileSystem::binary);
+    if (!file) return ErrorCode::fileIO;
+    const size_t write_size = file->write(0, content);
+    FileSystem::FileSystem::instance()->closeFile(file);
+    if (write_size != content.size()) return ErrorCode::fileIO;
+    m_statistics.m_stores++;
+    return ErrorCode::ok;
+}
+
+ShaderBinaryCache::Statistics ShaderBinaryCache::statistics()
+{
+    std::lock_guard locker{ m_lock };
+    return m_statistics;
+}
+
+std::string ShaderBinaryCache::cacheFilename(std::uint64_t key) const
+{
+    return string_format("%016llx.shbin@%s", static_cast<unsigned long long>(key), m_pathId.c_str());
+}
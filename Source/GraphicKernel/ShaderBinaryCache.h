@@ -0,0 +1,63 @@
+﻿/*********************************************************************
+ * \file   ShaderBinaryCache.h
+ * \brief  persistent compiled shader binary cache, keyed by source + profile hash
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef SHADER_BINARY_CACHE_H
+#define SHADER_BINARY_CACHE_H
+
+#include "Frameworks/ExtentTypesDefine.h"
+#include <string>
+#include <optional>
+#include <mutex>
+#include <cstdint>
+#include <system_error>
+
+namespace Enigma::Graphics
+{
+    using error = std::error_code;
+
+    /** 每個 shader binary 存成一個檔案 "<key>.shbin@PathId", key 是 code/profile/entry/compiler tag 的 hash.
+     *  binary 本身就帶有 reflection 資料 (dx11 用 D3DReflect 解), warm start 時可以整個跳過 compile.
+     *  load/store 可以在多個執行緒同時呼叫 */
+    class ShaderBinaryCache
+    {
+    public:
+        struct Statistics
+        {
+            unsigned m_hits = 0;
+            unsigned m_misses = 0;
+            unsigned m_stores = 0;
+        };
+
+    public:
+        ShaderBinaryCache(const std::string& cache_path_id);
+        ShaderBinaryCache(const ShaderBinaryCache&) = delete;
+        ShaderBinaryCache(ShaderBinaryCache&&) = delete;
+        ~ShaderBinaryCache();
+        ShaderBinaryCache& operator=(const ShaderBinaryCache&) = delete;
+        ShaderBinaryCache& operator=(ShaderBinaryCache&&) = delete;
+
+        /** compiler tag 要包含 api 跟 compile flags, 不同的編譯選項不能共用 binary */
+        static std::uint64_t makeKey(const std::string& code, const std::string& profile, const std::string& entry, const std::string& compiler_tag);
+        /** app delegate 預設掛載 cache 目錄用的 path ID */
+        static const std::string& getDefaultCachePathID();
+
+        std::optional<byte_buffer> load(std::uint64_t key);
+        error store(std::uint64_t key, const byte_buffer& binary);
+
+        Statistics statistics();
+
+    protected:
+        std::string cacheFilename(std::uint64_t key) const;
+
+    protected:
+        std::string m_pathId;
+        std::mutex m_lock;
+        Statistics m_statistics;
+    };
+}
+
+#endif // SHADER_BINARY_CACHE_H
@@ -0,0 +1,184 @@
+﻿#include "TextureContainer.h"
+#include "GraphicErrors.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+using namespace Enigma::Graphics;
+
+static constexpr char CONTAINER_MAGIC[4] = { 'E', 'T', 'X', 'C' };
+static constexpr std::uint32_t CONTAINER_VERSION = 1;
+static constexpr size_t HEADER_SIZE = 32;
+static constexpr size_t PAYLOAD_ENTRY_SIZE = 8;
+static constexpr size_t LEVEL_ENTRY_SIZE = 8;
+static constexpr size_t LEVEL_DATA_ALIGNMENT = 16;
+static constexpr std::uint32_t FLAG_HAS_ALPHA = 0x1;
+static constexpr unsigned MAX_MIP_COUNT = 16;
+static constexpr unsigned RAW_FORMAT = GraphicFormat::FMT_A8B8G8R8;
+
+static std::uint32_t readU32(const unsigned char* p)
+{
+    std::uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void writeU32(byte_buffer& buff, size_t offset, std::uint32_t v)
+{
+    memcpy(&buff[offset], &v, sizeof(v));
+}
+
+static size_t alignUp(size_t v, size_t alignment)
+{
+    return (v + alignment - 1) / alignment * alignment;
+}
+
+bool TextureContainer::isContainerContent(const void* data, size_t size)
+{
+    if ((!data) || (size < HEADER_SIZE)) return false;
+    return memcmp(data, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) == 0;
+}
+
+std::optional<TextureContainer::Header> TextureContainer::readHeader(const void* data, size_t size)
+{
+    if (!isContainerContent(data, size)) return std::nullopt;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    if (readU32(p + 4) != CONTAINER_VERSION) return std::nullopt;
+    Header header;
+    header.m_dimension = { readU32(p + 8), readU32(p + 12) };
+    header.m_mipCount = readU32(p + 16);
+    header.m_payloadCount = readU32(p + 20);
+    header.m_hasAlpha = (readU32(p + 24) & FLAG_HAS_ALPHA) != 0;
+    if ((header.m_dimension.m_width == 0) || (header.m_dimension.m_height == 0)) return std::nullopt;
+    if ((header.m_mipCount == 0) || (header.m_mipCount > MAX_MIP_COUNT)) return std::nullopt;
+    return header;
+}
+
+error TextureContainer::parse(const void* data, size_t size, Header& header, std::vector<PayloadView>& payloads)
+{
+    auto h = readHeader(data, size);
+    if (!h) return ErrorCode::textureContainerFormat;
+    header = h.value();
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const size_t payload_entry_size = PAYLOAD_ENTRY_SIZE + LEVEL_ENTRY_SIZE * header.m_mipCount;
+    if (HEADER_SIZE + payload_entry_size * header.m_payloadCount > size) return ErrorCode::textureContainerFormat;
+
+    payloads.clear();
+    payloads.reserve(header.m_payloadCount);
+    for (unsigned i = 0; i < header.m_payloadCount; i++)
+    {
+        const unsigned char* entry = p + HEADER_SIZE + payload_entry_size * i;
+        PayloadView payload{ GraphicFormat{ readU32(entry) }, {} };
+        payload.m_levels.reserve(header.m_mipCount);
+        for (unsigned lv = 0; lv < header.m_mipCount; lv++)
+        {
+            const unsigned char* level_entry = entry + PAYLOAD_ENTRY_SIZE + LEVEL_ENTRY_SIZE * lv;
+            const size_t offset = readU32(level_entry);
+            const size_t bytes = readU32(level_entry + 4);
+            const MathLib::Dimension<unsigned> dimension = levelDimension(header.m_dimension, lv);
+            if ((offset > size) || (bytes > size - offset)) return ErrorCode::textureContainerFormat;
+            if (bytes != levelBytes(payload.m_format, dimension)) return ErrorCode::textureContainerFormat;
+            payload.m_levels.push_back({ dimension, p + offset, bytes, levelRowPitch(payload.m_format, dimension.m_width) });
+        }
+        payloads.emplace_back(std::move(payload));
+    }
+    return ErrorCode::ok;
+}
+
+const TextureContainer::PayloadView* TextureContainer::selectPayload(const std::vector<PayloadView>& payloads, const std::vector<GraphicFormat>& supported_formats)
+{
+    for (const auto& fmt : supported_formats)
+    {
+        auto it = std::find_if(payloads.begin(), payloads.end(), [&fmt](const PayloadView& payload) { return payload.m_format.fmt == fmt.fmt; });
+        if (it != payloads.end()) return &(*it);
+    }
+    auto it = std::find_if(payloads.begin(), payloads.end(), [](const PayloadView& payload) { return payload.m_format.fmt == RAW_FORMAT; });
+    if (it != payloads.end()) return &(*it);
+    return nullptr;
+}
+
+byte_buffer TextureContainer::serialize(const MathLib::Dimension<unsigned>& dimension, bool has_alpha, const std::vector<PayloadSource>& payloads)
+{
+    if (payloads.empty()) return {};
+    const unsigned mip_count = static_cast<unsigned>(payloads[0].m_levels.size());
+    if ((mip_count == 0) || (mip_count > MAX_MIP_COUNT)) return {};
+    for (const auto& payload : payloads)
+    {
+        if (payload.m_levels.size() != mip_count) return {};
+        for (unsigned lv = 0; lv < mip_count; lv++)
+        {
+            if (payload.m_levels[lv].size() != levelBytes(payload.m_format, levelDimension(dimension, lv))) return {};
+        }
+    }
+
+    const size_t payload_entry_size = PAYLOAD_ENTRY_SIZE + LEVEL_ENTRY_SIZE * mip_count;
+    size_t total_size = alignUp(HEADER_SIZE + payload_entry_size * payloads.size(), LEVEL_DATA_ALIGNMENT);
+    for (const auto& payload : payloads)
+    {
+        for (const auto& level : payload.m_levels)
+        {
+            total_size = alignUp(total_size + level.size(), LEVEL_DATA_ALIGNMENT);
+        }
+    }
+    byte_buffer buff(total_size, 0);
+    memcpy(&buff[0], CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+    writeU32(buff, 4, CONTAINER_VERSION);
+    writeU32(buff, 8, dimension.m_width);
+    writeU32(buff, 12, dimension.m_height);
+    writeU32(buff, 16, mip_count);
+    writeU32(buff, 20, static_cast<std::uint32_t>(payloads.size()));
+    writeU32(buff, 24, has_alpha ? FLAG_HAS_ALPHA : 0);
+
+    size_t data_offset = alignUp(HEADER_SIZE + payload_entry_size * payloads.size(), LEVEL_DATA_ALIGNMENT);
+    for (size_t i = 0; i < payloads.size(); i++)
+    {
+        const size_t entry = HEADER_SIZE + payload_entry_size * i;
+        writeU32(buff, entry, payloads[i].m_format.fmt);
+        for (unsigned lv = 0; lv < mip_count; lv++)
+        {
+            const byte_buffer& level = payloads[i].m_levels[lv];
+            writeU32(buff, entry + PAYLOAD_ENTRY_SIZE + LEVEL_ENTRY_SIZE * lv, static_cast<std::uint32_t>(data_offset));
+            writeU32(buff, entry + PAYLOAD_ENTRY_SIZE + LEVEL_ENTRY_SIZE * lv + 4, static_cast<std::uint32_t>(level.size()));
+            if (!level.empty()) memcpy(&buff[data_offset], level.data(), level.size());
+            data_offset = alignUp(data_offset + level.size(), LEVEL_DATA_ALIGNMENT);
+        }
+    }
+    return buff;
+}
+
+bool TextureContainer::isBlockCompressed(const GraphicFormat& fmt)
+{
+    return blockBytes(fmt) != 0;
+}
+
+unsigned TextureContainer::blockBytes(const GraphicFormat& fmt)
+{
+    switch (fmt.fmt)
+    {
+    case GraphicFormat::FMT_DXT1:
+    case GraphicFormat::FMT_ETC2_RGB8:
+        return 8;
+    case GraphicFormat::FMT_DXT5:
+    case GraphicFormat::FMT_ETC2_RGBA8:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+unsigned TextureContainer::levelRowPitch(const GraphicFormat& fmt, unsigned width)
+{
+    if (const unsigned block_bytes = blockBytes(fmt)) return ((width + 3) / 4) * block_bytes;
+    return width * fmt.PixelBits() / 8;
+}
+
+size_t TextureContainer::levelBytes(const GraphicFormat& fmt, const MathLib::Dimension<unsigned>& dimension)
+{
+    const size_t rows = isBlockCompressed(fmt) ? (dimension.m_height + 3) / 4 : dimension.m_height;
+    return static_cast<size_t>(levelRowPitch(fmt, dimension.m_width)) * rows;
+}
+
+Enigma::MathLib::Dimension<unsigned> TextureContainer::levelDimension(const MathLib::Dimension<unsigned>& dimension, unsigned level)
+{
+    return { std::max(1u, dimension.m_width >> level), std::max(1u, dimension.m_height >> level) };
+}
@@ -0,0 +1,78 @@
+﻿/*********************************************************************
+ * \file   TextureContainer.h
+ * \brief  pre-processed texture container (.etex), mip chains of one or more payload formats,
+ *          produced offline (TextureConverter), read by devices without decoding
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TEXTURE_CONTAINER_H
+#define TEXTURE_CONTAINER_H
+
+#include "GraphicAPITypes.h"
+#include "MathLib/AlgebraBasicTypes.h"
+#include "Frameworks/ExtentTypesDefine.h"
+#include <vector>
+#include <optional>
+#include <system_error>
+
+namespace Enigma::Graphics
+{
+    using error = std::error_code;
+
+    /** 檔案結構 : header, payload table, level data (每個 level 16 bytes 對齊).
+     *  每個 payload 是同一張圖的完整 mip chain, 格式可以是 block compressed (BC1/BC3/ETC2) 或 raw RGBA8,
+     *  device 挑第一個支援的 payload 直接上傳, raw RGBA8 是最後的 fallback */
+    class TextureContainer
+    {
+    public:
+        static constexpr const char* FILE_EXTENSION = ".etex";
+
+        struct Header
+        {
+            MathLib::Dimension<unsigned> m_dimension;
+            unsigned m_mipCount;
+            unsigned m_payloadCount;
+            bool m_hasAlpha;
+        };
+        /** level data 直接指到 container buffer 裡面, 不複製 */
+        struct LevelView
+        {
+            MathLib::Dimension<unsigned> m_dimension;
+            const unsigned char* m_data;
+            size_t m_size;
+            unsigned m_rowPitch;
+        };
+        struct PayloadView
+        {
+            GraphicFormat m_format;
+            std::vector<LevelView> m_levels;
+        };
+        /** offline 產生用, levels 從 level 0 到最小的 level */
+        struct PayloadSource
+        {
+            GraphicFormat m_format;
+            std::vector<byte_buffer> m_levels;
+        };
+
+    public:
+        static bool isContainerContent(const void* data, size_t size);
+        /** 只讀 header, 不用 parse payload */
+        static std::optional<Header> readHeader(const void* data, size_t size);
+        /** payload views 指到 data 裡面, data 要比 views 活得久 */
+        static error parse(const void* data, size_t size, Header& header, std::vector<PayloadView>& payloads);
+        /** 依 supported formats 的順序挑 payload, 都沒有時用 raw RGBA8, 再沒有就回傳 nullptr */
+        static const PayloadView* selectPayload(const std::vector<PayloadView>& payloads, const std::vector<GraphicFormat>& supported_formats);
+
+        static byte_buffer serialize(const MathLib::Dimension<unsigned>& dimension, bool has_alpha, const std::vector<PayloadSource>& payloads);
+
+        static bool isBlockCompressed(const GraphicFormat& fmt);
+        /** block compressed 格式 4x4 一個 block 的 bytes, 非 block 格式回傳 0 */
+        static unsigned blockBytes(const GraphicFormat& fmt);
+        static unsigned levelRowPitch(const GraphicFormat& fmt, unsigned width);
+        static size_t levelBytes(const GraphicFormat& fmt, const MathLib::Dimension<unsigned>& dimension);
+        static MathLib::Dimension<unsigned> levelDimension(const MathLib::Dimension<unsigned>& dimension, unsigned level);
+    };
+}
+
+#endif // TEXTURE_CONTAINER_H
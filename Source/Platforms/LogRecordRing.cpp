@@ -0,0 +1,63 @@
+﻿#include "LogRecordRing.h"
+#include <cstring>
+
+using namespace Enigma::Platforms;
+
+LogRecordRing::LogRecordRing(size_t capacity) : m_enqueuePos(0), m_dequeuePos(0)
+{
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    m_mask = size - 1;
+    m_slots = std::make_unique<Slot[]>(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+LogRecordRing::~LogRecordRing()
+{
+    m_slots = nullptr;
+}
+
+bool LogRecordRing::tryPush(const LogRecord& record)
+{
+    size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Slot& slot = m_slots[pos & m_mask];
+        const size_t sequence = slot.m_sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0)
+        {
+            // 搶到這個 slot 才寫入, 寫完再發布 sequence 給 consumer
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                std::memcpy(&slot.m_record, &record, offsetof(LogRecord, m_message) + record.m_length);
+                slot.m_sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;  // full
+        }
+        else
+        {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool LogRecordRing::tryPop(LogRecord& record)
+{
+    const size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+    Slot& slot = m_slots[pos & m_mask];
+    const size_t sequence = slot.m_sequence.load(std::memory_order_acquire);
+    if (static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1) < 0) return false;  // empty, or producer 還沒寫完
+    std::memcpy(&record, &slot.m_record, offsetof(LogRecord, m_message) + slot.m_record.m_length);
+    record.m_message[record.m_length] = '\0';
+    slot.m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+    m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
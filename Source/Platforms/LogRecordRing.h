@@ -0,0 +1,68 @@
+﻿/*********************************************************************
+ * \file   LogRecordRing.h
+ * \brief  fixed size log record & bounded lock-free ring (multi-producer, single consumer)
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef LOG_RECORD_RING_H
+#define LOG_RECORD_RING_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace Enigma::Platforms
+{
+    /** 一筆 log, 固定大小, 不配置記憶體; 長度跟 Logger::Printf 的 buffer 一樣, 超過的部分截掉.
+     ring 只複製用到的長度, 短訊息不會因此變慢 */
+    struct LogRecord
+    {
+        static constexpr size_t MAX_MESSAGE_LENGTH = 2048;
+
+        std::int64_t m_microseconds;   ///< 從 logger 啟動開始算
+        const char* m_filename;  ///< __FILE__, string literal, 只存指標
+        std::uint32_t m_line;
+        std::uint32_t m_threadIndex;
+        std::uint8_t m_level;
+        std::uint16_t m_length;
+        char m_message[MAX_MESSAGE_LENGTH];
+    };
+
+    /** 每個 slot 帶一個 sequence 號碼, push/pop 都只用 atomic, 不上鎖.
+     ring 滿了 tryPush 直接傳回 false, 呼叫端 (graphic/IO/worker thread) 不會被卡住 */
+    class LogRecordRing
+    {
+    public:
+        /** capacity 會補成 2 的次方 */
+        explicit LogRecordRing(size_t capacity);
+        LogRecordRing(const LogRecordRing&) = delete;
+        LogRecordRing(LogRecordRing&&) = delete;
+        ~LogRecordRing();
+        LogRecordRing& operator=(const LogRecordRing&) = delete;
+        LogRecordRing& operator=(LogRecordRing&&) = delete;
+
+        size_t capacity() const { return m_mask + 1; }
+
+        /** 任何 thread 都可以呼叫 */
+        bool tryPush(const LogRecord& record);
+        /** 只能由單一 consumer (writer thread) 呼叫 */
+        bool tryPop(LogRecord& record);
+
+    protected:
+        struct Slot
+        {
+            std::atomic<size_t> m_sequence;
+            LogRecord m_record;
+        };
+
+    protected:
+        std::unique_ptr<Slot[]> m_slots;
+        size_t m_mask;
+        alignas(64) std::atomic<size_t> m_enqueuePos;
+        alignas(64) std::atomic<size_t> m_dequeuePos;
+    };
+}
+
+#endif // LOG_RECORD_RING_H
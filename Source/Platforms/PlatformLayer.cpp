@@ -1,38 +1,131 @@
 ﻿#include "PlatformLayer.h"
+#include "LogRecordRing.h"
 #include <cstdarg>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
 
 using namespace Enigma::Platforms;
 std::ofstream Logger::m_logFile;
-std::string levelToken[]{ "Info", "Debug", "Warnning", "Error", "Fatal" };
+static const char* levelToken[]{ "Info", "Debug", "Warnning", "Error", "Fatal" };
 
-void Logger::InitLoggerFile(const std::string& filepath)
+/// 每個 slot 約 2K, ring 約 2M
+static constexpr size_t LOG_RING_CAPACITY = 1024;
+static constexpr size_t LOG_LINE_LENGTH = LogRecord::MAX_MESSAGE_LENGTH + 512;
+static constexpr size_t LOG_BATCH_BYTES = 64 * 1024;
+/// producer 每筆都會通知, 這只是漏接通知時的保險
+static constexpr std::chrono::milliseconds LOG_WRITER_INTERVAL{ 50 };
+
+namespace
 {
-    if (m_logFile.is_open())
+    std::unique_ptr<LogRecordRing> s_ring;
+    std::thread s_writerThread;
+    std::mutex s_writerLock;
+    std::condition_variable s_writerCondition;
+    std::atomic<bool> s_isWriterRunning{ false };
+    std::atomic<bool> s_isWriterExiting{ false };
+    /// 看到 writer running 之後還沒 push 完的 producer 數, close 時要等它們
+    std::atomic<unsigned> s_pushingCount{ 0 };
+    std::atomic<unsigned> s_droppedCount{ 0 };
+    std::atomic<std::uint32_t> s_lastThreadIndex{ 0 };
+    thread_local std::uint32_t s_threadIndex = 0;
+
+    /** 程式結束前沒有呼叫 CloseLoggerFile 的話, 在這裡停掉 writer thread (要宣告在 thread/ring 之後) */
+    struct WriterShutdown
+    {
+        ~WriterShutdown() { Logger::CloseLoggerFile(); }
+    } s_writerShutdown;
+
+    std::chrono::steady_clock::time_point logEpoch()
+    {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return epoch;
+    }
+
+    std::uint32_t currentThreadIndex()
+    {
+        if (s_threadIndex == 0) s_threadIndex = ++s_lastThreadIndex;
+        return s_threadIndex;
+    }
+
+    void stampRecord(LogRecord& record, Logger::Level lv, const char* filename, int line)
+    {
+        record.m_microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - logEpoch()).count();
+        record.m_filename = filename;
+        record.m_line = static_cast<std::uint32_t>(line);
+        record.m_threadIndex = currentThreadIndex();
+        record.m_level = static_cast<std::uint8_t>(lv);
+    }
+
+    size_t formatRecord(const LogRecord& record, char* line, size_t line_size)
     {
-        m_logFile.close();
+        const long long milliseconds = static_cast<long long>(record.m_microseconds / 1000);
+        int written;
+        if (record.m_filename)
+        {
+            written = snprintf(line, line_size, "%lld.%03lld T%u [%s] %s @ %s(%u)\n", milliseconds / 1000, milliseconds % 1000,
+                record.m_threadIndex, levelToken[record.m_level], record.m_message, record.m_filename, record.m_line);
+        }
+        else
+        {
+            written = snprintf(line, line_size, "%lld.%03lld T%u [%s] %s\n", milliseconds / 1000, milliseconds % 1000,
+                record.m_threadIndex, levelToken[record.m_level], record.m_message);
+        }
+        if (written < 0) return 0;
+        return std::min(static_cast<size_t>(written), line_size - 1);
     }
+}
+
+void Logger::InitLoggerFile(const std::string& filepath)
+{
+    CloseLoggerFile();
     m_logFile.open(filepath.c_str(), std::fstream::out | std::fstream::trunc);
+    if (!s_ring) s_ring = std::make_unique<LogRecordRing>(LOG_RING_CAPACITY);
+    s_isWriterExiting.store(false);
+    s_writerThread = std::thread(WriterProcedure);
+    s_isWriterRunning.store(true, std::memory_order_release);
 }
 
 void Logger::CloseLoggerFile()
 {
+    if (s_writerThread.joinable())
+    {
+        // 跟 EmitRecord 的 s_pushingCount 成對, 都用 seq_cst: 不會有 producer 看到 running 而這裡看不到它在 push
+        s_isWriterRunning.store(false);
+        s_isWriterExiting.store(true, std::memory_order_release);
+        s_writerCondition.notify_one();
+        s_writerThread.join();
+        // writer 最後一次清空之後, 先前看到 running 的 producer 可能才 push 進來
+        while (s_pushingCount.load() != 0) std::this_thread::yield();
+        DrainRecords();
+    }
     if (m_logFile) m_logFile.close();
 }
 
-bool Logger::LogIf(bool cond, Level lv, const std::string& msg, const char* filename, int line)
+void Logger::LogInline(Level lv, const char* msg, const char* filename, int line)
 {
-    if (cond) LogInline(lv, msg, filename, line);
-    return cond;
+    EmitRecord(lv, msg, std::strlen(msg), filename, line);
 }
 
 void Logger::LogInline(Level lv, const std::string& msg, const char* filename, int line)
 {
-    OutputLog(Printf("[%s] %s @ %s(%d)\n", levelToken[(int)lv].c_str(), msg.c_str(), filename, line));
+    EmitRecord(lv, msg.c_str(), msg.length(), filename, line);
+}
+
+void Logger::Log(Level lv, const char* msg)
+{
+    EmitRecord(lv, msg, std::strlen(msg), nullptr, 0);
 }
 
 void Logger::Log(Level lv, const std::string& msg)
 {
-    OutputLog(Printf("[%s] %s\n", levelToken[(int)lv].c_str(), msg.c_str()));
+    EmitRecord(lv, msg.c_str(), msg.length(), nullptr, 0);
 }
 
 std::string Logger::Printf(const char* fmt, ...)
@@ -40,7 +133,7 @@ std::string Logger::Printf(const char* fmt, ...)
     va_list argList;
     va_start(argList, fmt);
     const unsigned int MAX_CHARS = 2048;
-    static char s_buffer[MAX_CHARS];
+    thread_local char s_buffer[MAX_CHARS];
     int written = vsnprintf(s_buffer, MAX_CHARS, fmt, argList);
     s_buffer[MAX_CHARS - 1] = '\0';
     va_end(argList);
@@ -48,11 +141,113 @@ std::string Logger::Printf(const char* fmt, ...)
     return s_buffer;
 }
 
-void Logger::OutputLog(const std::string& msg)
+void Logger::LogFormat(Level lv, const char* fmt, ...)
+{
+    LogRecord record;
+    stampRecord(record, lv, nullptr, 0);
+    va_list argList;
+    va_start(argList, fmt);
+    int written = vsnprintf(record.m_message, LogRecord::MAX_MESSAGE_LENGTH, fmt, argList);
+    va_end(argList);
+    if (written < 0)
+    {
+        std::strcpy(record.m_message, "Logger Printf Error!!");
+        written = static_cast<int>(std::strlen(record.m_message));
+    }
+    record.m_length = static_cast<std::uint16_t>(std::min(static_cast<size_t>(written), LogRecord::MAX_MESSAGE_LENGTH - 1));
+    PushRecord(lv, record);
+}
+
+unsigned Logger::DroppedCount()
+{
+    return s_droppedCount.load(std::memory_order_relaxed);
+}
+
+void Logger::EmitRecord(Level lv, const char* msg, size_t length, const char* filename, int line)
+{
+    LogRecord record;
+    stampRecord(record, lv, filename, line);
+    record.m_length = static_cast<std::uint16_t>(std::min(length, LogRecord::MAX_MESSAGE_LENGTH - 1));
+    std::memcpy(record.m_message, msg, record.m_length);
+    record.m_message[record.m_length] = '\0';
+    PushRecord(lv, record);
+}
+
+void Logger::PushRecord(Level lv, const LogRecord& record)
+{
+    s_pushingCount.fetch_add(1);
+    while (s_isWriterRunning.load())
+    {
+        if (s_ring->tryPush(record))
+        {
+            s_pushingCount.fetch_sub(1);
+            s_writerCondition.notify_one();
+            return;
+        }
+        // ring 滿了: Error 以下的丟掉並計數, 不卡住呼叫端; Error 以上的等 writer 騰出空間
+        if (lv < Level::Error)
+        {
+            s_pushingCount.fetch_sub(1);
+            s_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        s_writerCondition.notify_one();
+        std::this_thread::yield();
+    }
+    s_pushingCount.fetch_sub(1);
+    char text[LOG_LINE_LENGTH];
+    formatRecord(record, text, sizeof(text));
+    Debug::Printf("%s", text);
+}
+
+void Logger::WriterProcedure()
+{
+    std::string batch;
+    batch.reserve(LOG_BATCH_BYTES + LOG_LINE_LENGTH);
+    auto flush_batch = [&batch]()
+    {
+        if (batch.empty()) return;
+        if (m_logFile) m_logFile.write(batch.data(), static_cast<std::streamsize>(batch.size())).flush();
+        batch.clear();
+    };
+    LogRecord record;
+    char text[LOG_LINE_LENGTH];
+    unsigned reported_dropped = s_droppedCount.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        // 先讀 exiting 再清空 ring, 確保結束前 push 進來的都有寫出
+        const bool is_exiting = s_isWriterExiting.load(std::memory_order_acquire);
+        while (s_ring->tryPop(record))
+        {
+            const size_t length = formatRecord(record, text, sizeof(text));
+            Debug::Printf("%s", text);
+            batch.append(text, length);
+            if (batch.size() >= LOG_BATCH_BYTES) flush_batch();
+        }
+        const unsigned dropped = s_droppedCount.load(std::memory_order_relaxed);
+        if (dropped != reported_dropped)
+        {
+            const int length = snprintf(text, sizeof(text), "[%s] %u log records dropped, ring is full\n", levelToken[static_cast<int>(Level::Warnning)], dropped - reported_dropped);
+            if (length > 0) batch.append(text, std::min(static_cast<size_t>(length), sizeof(text) - 1));
+            reported_dropped = dropped;
+        }
+        flush_batch();
+        if (is_exiting) break;
+        std::unique_lock locker{ s_writerLock };
+        s_writerCondition.wait_for(locker, LOG_WRITER_INTERVAL);
+    }
+}
+
+void Logger::DrainRecords()
 {
-    if (m_logFile)
+    if (!s_ring) return;
+    LogRecord record;
+    char text[LOG_LINE_LENGTH];
+    while (s_ring->tryPop(record))
     {
-        m_logFile.write(msg.c_str(), msg.length()).flush();
+        const size_t length = formatRecord(record, text, sizeof(text));
+        Debug::Printf("%s", text);
+        if (m_logFile) m_logFile.write(text, static_cast<std::streamsize>(length));
     }
-    Debug::Printf(msg.c_str());
+    if (m_logFile) m_logFile.flush();
 }
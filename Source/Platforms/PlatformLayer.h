@@ -11,8 +11,15 @@
 #include <string>
 #include <fstream>
 
+#ifndef LOGGER_MIN_LEVEL
+/// 編譯時期的 log level 下限 (Logger::Level 的數值), 低於這個 level 的 LOG / LOG_IF 不產生任何程式碼
+#define LOGGER_MIN_LEVEL 0
+#endif
+
 namespace Enigma::Platforms
 {
+    struct LogRecord;
+
     class Debug
     {
     public:
@@ -20,6 +27,8 @@ namespace Enigma::Platforms
         static int ErrorPrintf(const char* format, ...);
     };
 
+    /** log 先放進 lock-free ring, 由背景 writer thread 格式化並批次寫檔, 任何 thread 都可以呼叫.
+     沒有開 log 檔時, 直接同步輸出到 debug console */
     class Logger
     {
     public:
@@ -31,15 +40,36 @@ namespace Enigma::Platforms
             Error,
             Fatal
         };
+        static constexpr bool IsLevelEnabled(Level lv) { return static_cast<int>(lv) >= LOGGER_MIN_LEVEL; }
     public:
+        /** open log file & start writer thread */
         static void InitLoggerFile(const std::string& filepath);
+        /** write remaining records, stop writer thread & close log file */
         static void CloseLoggerFile();
-        static bool LogIf(bool cond, Level lv, const std::string& msg, const char* filename, int line);
+        /** expr 是 #expr 字串常數, 條件成立才輸出, 不成立時沒有任何配置 */
+        template <Level lv> static bool LogIf(bool cond, const char* expr, const char* filename, int line)
+        {
+            if constexpr (IsLevelEnabled(lv))
+            {
+                if (cond) LogInline(lv, expr, filename, line);
+            }
+            return cond;
+        }
+        static void LogInline(Level lv, const char* msg, const char* filename, int line);
         static void LogInline(Level lv, const std::string& msg, const char* filename, int line);
+        static void Log(Level lv, const char* msg);
         static void Log(Level lv, const std::string& msg);
         static std::string Printf(const char* fmt, ...);
+        /** 直接格式化到 log record 裡, 不產生 std::string; 透過 LOG_FMT 呼叫, level 被編譯掉時連參數都不會求值 */
+        static void LogFormat(Level lv, const char* fmt, ...);
+        /** ring 滿了而被丟掉的 log 數 */
+        static unsigned DroppedCount();
     protected:
-        static void OutputLog(const std::string& msg);
+        static void EmitRecord(Level lv, const char* msg, size_t length, const char* filename, int line);
+        static void PushRecord(Level lv, const LogRecord& record);
+        static void WriterProcedure();
+        /** writer thread 停掉之後, 在呼叫端 thread 寫出 ring 裡剩下的 */
+        static void DrainRecords();
 
     protected:
         static std::ofstream m_logFile;
@@ -49,10 +79,11 @@ namespace Enigma::Platforms
 #ifdef DISABLE_FATAL_LOGGER
 #define FATAL_LOG_EXPR(expr) (expr)
 #else
-#define FATAL_LOG_EXPR(expr) Enigma::Platforms::Logger::LogIf((expr), Enigma::Platforms::Logger::Level::Fatal, #expr, __FILE__, __LINE__)
+#define FATAL_LOG_EXPR(expr) Enigma::Platforms::Logger::LogIf<Enigma::Platforms::Logger::Level::Fatal>((expr), #expr, __FILE__, __LINE__)
 #endif
-#define LOG_INLINE(lv, msg) Enigma::Platforms::Logger::LogInline(Enigma::Platforms::Logger::Level::lv, (msg), __FILE__, __LINE__)
-#define LOG(lv, msg) Enigma::Platforms::Logger::Log(Enigma::Platforms::Logger::Level::lv, (msg))
-#define LOG_IF(lv, expr) Enigma::Platforms::Logger::LogIf((expr), Enigma::Platforms::Logger::Level::lv, #expr, __FILE__, __LINE__)
+#define LOG_INLINE(lv, msg) do { if constexpr (Enigma::Platforms::Logger::IsLevelEnabled(Enigma::Platforms::Logger::Level::lv)) Enigma::Platforms::Logger::LogInline(Enigma::Platforms::Logger::Level::lv, (msg), __FILE__, __LINE__); } while (0)
+#define LOG(lv, msg) do { if constexpr (Enigma::Platforms::Logger::IsLevelEnabled(Enigma::Platforms::Logger::Level::lv)) Enigma::Platforms::Logger::Log(Enigma::Platforms::Logger::Level::lv, (msg)); } while (0)
+#define LOG_FMT(lv, ...) do { if constexpr (Enigma::Platforms::Logger::IsLevelEnabled(Enigma::Platforms::Logger::Level::lv)) Enigma::Platforms::Logger::LogFormat(Enigma::Platforms::Logger::Level::lv, __VA_ARGS__); } while (0)
+#define LOG_IF(lv, expr) Enigma::Platforms::Logger::LogIf<Enigma::Platforms::Logger::Level::lv>((expr), #expr, __FILE__, __LINE__)
 
 #endif // !_PLATFORM_LAYER_H
@@ -0,0 +1,25 @@
+﻿#include "PlatformLayerUtilities.h"
+
+#if TARGET_PLATFORM == PLATFORM_LINUX
+#include <stdio.h>
+
+namespace Enigma::Platforms
+{
+    int Debug::Printf(const char* format, ...)
+    {
+        va_list argList;
+        va_start(argList, format);
+        int nWritten = vfprintf(stdout, format, argList);
+        va_end(argList);
+        return nWritten;
+    }
+    int Debug::ErrorPrintf(const char* format, ...)
+    {
+        va_list argList;
+        va_start(argList, format);
+        int nWritten = vfprintf(stderr, format, argList);
+        va_end(argList);
+        return nWritten;
+    }
+}
+#endif
@@ -0,0 +1,109 @@
+﻿#include "ProfileZone.h"
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <chrono>
+
+using namespace Enigma::Platforms;
+
+/// 一直沒有人收集時, 每條 thread 最多留這麼多 zone, 之後的丟掉
+static constexpr size_t MAX_THREAD_ZONES = 64 * 1024;
+
+namespace
+{
+    struct ThreadBuffer
+    {
+        std::mutex m_lock;
+        std::vector<ProfileZone::Record> m_zones;
+        std::uint32_t m_threadIndex = 0;
+        std::string m_threadName;
+        bool m_isRetired = false;
+    };
+
+    std::atomic<bool> s_isEnabled{ true };
+    std::mutex s_registryLock;
+    std::vector<std::shared_ptr<ThreadBuffer>> s_threadBuffers;
+    std::uint32_t s_lastThreadIndex = 0;
+
+    /** thread 結束時標記 buffer, 收完剩下的 zone 之後由 collect 移除 */
+    struct ThreadBufferHolder
+    {
+        std::shared_ptr<ThreadBuffer> m_buffer;
+        ~ThreadBufferHolder()
+        {
+            if (!m_buffer) return;
+            std::lock_guard locker{ m_buffer->m_lock };
+            m_buffer->m_isRetired = true;
+        }
+    };
+    thread_local ThreadBufferHolder s_threadBuffer;
+
+    ThreadBuffer& currentThreadBuffer()
+    {
+        if (!s_threadBuffer.m_buffer)
+        {
+            auto buffer = std::make_shared<ThreadBuffer>();
+            std::lock_guard locker{ s_registryLock };
+            buffer->m_threadIndex = ++s_lastThreadIndex;
+            s_threadBuffers.emplace_back(buffer);
+            s_threadBuffer.m_buffer = buffer;
+        }
+        return *s_threadBuffer.m_buffer;
+    }
+}
+
+ProfileZone::ProfileZone(const char* name) : m_name(name), m_beginNanoseconds(-1)
+{
+    if (s_isEnabled.load(std::memory_order_relaxed)) m_beginNanoseconds = nowNanoseconds();
+}
+
+ProfileZone::~ProfileZone()
+{
+    if (m_beginNanoseconds < 0) return;
+    const std::int64_t end_nanoseconds = nowNanoseconds();
+    ThreadBuffer& buffer = currentThreadBuffer();
+    std::lock_guard locker{ buffer.m_lock };
+    if (buffer.m_zones.size() >= MAX_THREAD_ZONES) return;
+    buffer.m_zones.push_back(Record{ m_name, m_beginNanoseconds, end_nanoseconds, buffer.m_threadIndex });
+}
+
+void ProfileZone::setEnabled(bool is_enabled)
+{
+    s_isEnabled.store(is_enabled, std::memory_order_relaxed);
+}
+
+bool ProfileZone::isEnabled()
+{
+    return s_isEnabled.load(std::memory_order_relaxed);
+}
+
+void ProfileZone::setThreadName(const char* name)
+{
+    ThreadBuffer& buffer = currentThreadBuffer();
+    std::lock_guard locker{ buffer.m_lock };
+    buffer.m_threadName = name ? name : "";
+}
+
+std::int64_t ProfileZone::nowNanoseconds()
+{
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void ProfileZone::collect(std::vector<Record>& zones, std::unordered_map<std::uint32_t, std::string>& thread_names)
+{
+    std::lock_guard registry_locker{ s_registryLock };
+    for (auto it = s_threadBuffers.begin(); it != s_threadBuffers.end();)
+    {
+        ThreadBuffer& buffer = **it;
+        bool is_retired;
+        {
+            std::lock_guard locker{ buffer.m_lock };
+            zones.insert(zones.end(), buffer.m_zones.begin(), buffer.m_zones.end());
+            buffer.m_zones.clear();
+            if (!buffer.m_threadName.empty()) thread_names.emplace(buffer.m_threadIndex, buffer.m_threadName);
+            is_retired = buffer.m_isRetired;
+        }
+        it = is_retired ? s_threadBuffers.erase(it) : std::next(it);
+    }
+}
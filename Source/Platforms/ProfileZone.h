@@ -0,0 +1,73 @@
+﻿/*********************************************************************
+ * \file   ProfileZone.h
+ * \brief  profiler thread & zone primitives, per-thread zone buffers;
+ *          Frameworks::FrameProfiler collects them every frame
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef _PROFILE_ZONE_H
+#define _PROFILE_ZONE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+/// debug build 預設開啟; release build 沒有定義 ENABLE_FRAME_PROFILER 時, 所有 PROFILE_ 巨集都不產生程式碼
+#if defined(_DEBUG) && !defined(DISABLE_FRAME_PROFILER) && !defined(ENABLE_FRAME_PROFILER)
+#define ENABLE_FRAME_PROFILER
+#endif
+
+namespace Enigma::Platforms
+{
+    /** scoped zone, 結束時記在目前 thread 自己的 buffer.
+     FileSystem 這類底層模組只用這裡的 PROFILE_ZONE / PROFILE_THREAD_NAME, 不必依賴 Frameworks */
+    class ProfileZone
+    {
+    public:
+        struct Record
+        {
+            const char* m_name;
+            std::int64_t m_beginNanoseconds;
+            std::int64_t m_endNanoseconds;
+            std::uint32_t m_threadIndex;
+        };
+
+    public:
+        /** name 要是存活期夠長的字串 (string literal, static rtti name) */
+        explicit ProfileZone(const char* name);
+        ProfileZone(const ProfileZone&) = delete;
+        ProfileZone(ProfileZone&&) = delete;
+        ~ProfileZone();
+        ProfileZone& operator=(const ProfileZone&) = delete;
+        ProfileZone& operator=(ProfileZone&&) = delete;
+
+        static void setEnabled(bool is_enabled);
+        static bool isEnabled();
+
+        /** trace 裡顯示的 thread 名稱, 在 thread 開始時呼叫 */
+        static void setThreadName(const char* name);
+        /** zone 時間的基準, 從第一次呼叫開始算 */
+        static std::int64_t nowNanoseconds();
+
+        /** 取走各 thread 記下的 zone 與 thread 名稱; 已結束的 thread, buffer 收完之後移除 */
+        static void collect(std::vector<Record>& zones, std::unordered_map<std::uint32_t, std::string>& thread_names);
+
+    private:
+        const char* m_name;
+        std::int64_t m_beginNanoseconds;
+    };
+}
+
+#if defined(ENABLE_FRAME_PROFILER)
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) Enigma::Platforms::ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) Enigma::Platforms::ProfileZone::setThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif // _PROFILE_ZONE_H
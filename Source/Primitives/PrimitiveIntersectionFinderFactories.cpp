@@ -7,6 +7,11 @@ std::unordered_map<std::string, PrimitiveRay3IntersectionFinderCreator> Primitiv
 
 PrimitiveRay3IntersectionFinder* PrimitiveRay3IntersectionFinderFactory::createPrimitiveRay3IntersectionFinder(const Frameworks::Rtti& primitive_rtti)
 {
+    // 有自己 finder 的衍生型別 (ex. terrain) 優先於基底型別的 finder
+    if (auto it = m_creators.find(primitive_rtti.getName()); it != m_creators.end())
+    {
+        return it->second();
+    }
     if (auto it = std::find_if(m_creators.begin(), m_creators.end(), [&primitive_rtti](const auto& pair) { return Frameworks::Rtti::isExactlyOrDerivedFrom(primitive_rtti.getName(), pair.first); }); it != m_creators.end())
     {
         return it->second();
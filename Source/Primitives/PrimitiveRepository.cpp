@@ -12,6 +12,7 @@
 #include "Platforms/PlatformLayer.h"
 #include "PrimitiveCommands.h"
 #include "Frameworks/CommandBus.h"
+#include "Frameworks/AssetRetentionCache.h"
 
 using namespace Enigma::Primitives;
 using namespace Enigma::Frameworks;
@@ -20,6 +21,10 @@ DEFINE_RTTI(Primitives, PrimitiveRepository, ISystemService);
 
 using error = std::error_code;
 
+static const std::string RETENTION_CATEGORY = "primitive";
+/// primitive 的 geometry, texture 由各自的 repository 計算, 這裡只算 primitive 本身的概略大小
+static constexpr size_t PRIMITIVE_RETENTION_BYTES = 1024;
+
 PrimitiveRepository::PrimitiveRepository(ServiceManager* srv_manager, const std::shared_ptr<PrimitiveStoreMapper>& store_mapper)
     : ISystemService(srv_manager), m_storeMapper(store_mapper)
 {
@@ -58,6 +63,7 @@ ServiceResult PrimitiveRepository::onInit()
 ServiceResult PrimitiveRepository::onTerm()
 {
     assert(m_storeMapper);
+    if (m_retentionCache) m_retentionCache->releaseCategory(RETENTION_CATEGORY);
     dumpRetainedPrimitives();
     m_storeMapper->disconnect();
     m_primitives.clear();
@@ -95,13 +101,26 @@ bool PrimitiveRepository::hasPrimitive(const PrimitiveId& id)
 std::shared_ptr<Primitive> PrimitiveRepository::queryPrimitive(const PrimitiveId& id)
 {
     if (!hasPrimitive(id)) return nullptr;
-    if (auto cached_prim = findCachedPrimitive(id)) return cached_prim;
+    if (auto cached_prim = findCachedPrimitive(id))
+    {
+        if (m_retentionCache)
+        {
+            m_retentionCache->recordHit(RETENTION_CATEGORY);
+            retainPrimitive(id, cached_prim);
+        }
+        return cached_prim;
+    }
     assert(m_factory);
     const auto dto = m_storeMapper->queryPrimitive(id.origin());
     assert(dto.has_value());
     auto prim = m_factory->constitute(id, dto.value(), true);
     assert(prim);
     m_primitives.insert_or_assign(id, prim);
+    if (m_retentionCache)
+    {
+        m_retentionCache->recordMiss(RETENTION_CATEGORY);
+        retainPrimitive(id, prim);
+    }
     return prim;
 }
 
@@ -110,6 +129,7 @@ void PrimitiveRepository::removePrimitive(const PrimitiveId& id)
     if (!hasPrimitive(id)) return;
     std::lock_guard locker{ m_primitiveLock };
     m_primitives.erase(id);
+    if (m_retentionCache) m_retentionCache->release(RETENTION_CATEGORY, id.name() + "#" + std::to_string(id.sequence()));
     error er = m_storeMapper->removePrimitive(id.origin());
     if (er)
     {
@@ -222,6 +242,15 @@ std::shared_ptr<Primitive> PrimitiveRepository::findCachedPrimitive(const Primit
     return nullptr;
 }
 
+void PrimitiveRepository::retainPrimitive(const PrimitiveId& id, const std::shared_ptr<Primitive>& primitive)
+{
+    if ((!m_retentionCache) || (!primitive)) return;
+    // 同名的 primitive 以 sequence 區分
+    const std::string key = id.name() + "#" + std::to_string(id.sequence());
+    if (m_retentionCache->touch(RETENTION_CATEGORY, key)) return;
+    m_retentionCache->retain(RETENTION_CATEGORY, key, primitive, PRIMITIVE_RETENTION_BYTES);
+}
+
 void PrimitiveRepository::dumpRetainedPrimitives()
 {
     Platforms::Debug::Printf("dump retained primitives\n");
@@ -16,6 +16,11 @@
 #include "GameEngine/GenericDto.h"
 #include <mutex>
 
+namespace Enigma::Frameworks
+{
+    class AssetRetentionCache;
+}
+
 namespace Enigma::Primitives
 {
     class Primitive;
@@ -40,6 +45,9 @@ namespace Enigma::Primitives
 
         void registerPrimitiveFactory(const std::string& rtti, const PrimitiveCreator& creator);
 
+        /** optional, loaded primitives are retained in cache after all owners released */
+        void retentionCache(const std::shared_ptr<Frameworks::AssetRetentionCache>& cache) { m_retentionCache = cache; }
+
         std::uint64_t nextSequenceNumber();
         bool hasPrimitive(const PrimitiveId& id);
         std::shared_ptr<Primitive> queryPrimitive(const PrimitiveId& id);
@@ -55,6 +63,7 @@ namespace Enigma::Primitives
         void removePrimitive(const Frameworks::ICommandPtr& c);
 
         std::shared_ptr<Primitive> findCachedPrimitive(const PrimitiveId& id);
+        void retainPrimitive(const PrimitiveId& id, const std::shared_ptr<Primitive>& primitive);
         void dumpRetainedPrimitives();
 
     protected:
@@ -64,6 +73,7 @@ namespace Enigma::Primitives
         //! ADR: 在 repository 中，map 是存放已生成 asset 的 cache, 不擁有asset, 所以改用 weak_ptr 
         std::unordered_map<PrimitiveId, std::weak_ptr<Primitive>, PrimitiveId::hash> m_primitives;
         std::recursive_mutex m_primitiveLock;
+        std::shared_ptr<Frameworks::AssetRetentionCache> m_retentionCache;
 
         Frameworks::QuerySubscriberPtr m_queryPrimitive;
         Frameworks::QuerySubscriberPtr m_queryPrimitiveNextSequenceNumber;
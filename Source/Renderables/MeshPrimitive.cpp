@@ -194,6 +194,10 @@ error MeshPrimitive::insertToRendererWithTransformUpdating(const std::shared_ptr
         er = render->insertRenderElement(ele, mxWorld, lightingState, m_renderListID);
         if (er) return er;
     }
+    for (auto& mat : m_materials)
+    {
+        if (mat) render->updateTexturePriority(mat->effectTextureMap(), mxWorld, m_bound);
+    }
     return er;
 }
 
@@ -116,6 +116,19 @@ float ModelAnimationAsset::getAnimationLengthInSecond()
     return ret_time;
 }
 
+size_t ModelAnimationAsset::footprintBytes() const
+{
+    size_t bytes = sizeof(ModelAnimationAsset);
+    for (const auto& node_data : m_meshNodeKeyArray)
+    {
+        bytes += sizeof(MeshNodeTimeSRTData) + node_data.m_meshNodeName.size();
+        bytes += node_data.m_timeSRTData.getScaleKeyVector().size() * sizeof(AnimationTimeSRT::ScaleKey);
+        bytes += node_data.m_timeSRTData.getRotationKeyVector().size() * sizeof(AnimationTimeSRT::RotationKey);
+        bytes += node_data.m_timeSRTData.getTranslateKeyVector().size() * sizeof(AnimationTimeSRT::TranslateKey);
+    }
+    return bytes;
+}
+
 void ModelAnimationAsset::appendModelAnimationAsset(float offset_time, const std::shared_ptr<ModelAnimationAsset>& src_asset)
 {
     if (!src_asset) return;
@@ -70,6 +70,7 @@ namespace Enigma::Renderables
 
         /** get animation length (in second) */
         virtual float getAnimationLengthInSecond() override;
+        virtual size_t footprintBytes() const override;
 
         /** append Model Animation Asset from src */
         void appendModelAnimationAsset(float offset_time, const std::shared_ptr<ModelAnimationAsset>& src_asset);
@@ -23,6 +23,7 @@ RenderablePrimitiveBuilder::RenderablePrimitiveBuilder(ServiceManager* mngr, con
     m_primitiveRepository = primitive_repository;
     m_geometryRepository = geometry_repository;
     m_needTick = false;
+    m_tickPriority = ServicePriority::Background;
     m_meshBuilder = nullptr;
 }
 
@@ -3,6 +3,7 @@
 #include "RendererErrors.h"
 #include "Platforms/PlatformLayer.h"
 #include "GameEngine/MaterialVariableMap.h"
+#include "GameEngine/EffectSemanticTexture.h"
 
 using namespace Enigma::Renderer;
 
@@ -3,6 +3,10 @@
 #include "RenderTarget.h"
 #include "SceneGraph/Camera.h"
 #include "GameEngine/MaterialVariableMap.h"
+#include "GameEngine/EffectSemanticTexture.h"
+#include "GameEngine/Texture.h"
+#include "Frameworks/FrameProfiler.h"
+#include <algorithm>
 
 using namespace Enigma::Renderer;
 
@@ -75,6 +79,30 @@ error Renderer::removeRenderElement(const std::shared_ptr<RenderElement>& elemen
     return m_renderPacksArray[static_cast<size_t>(list_id)].removeRenderElement(element, m_stampBitMask);
 }
 
+void Renderer::updateTexturePriority(const Engine::EffectTextureMap& texture_map, const MathLib::Matrix4& mxWorld, const Engine::BoundingVolume& model_bound)
+{
+    if (texture_map.getCount() == 0) return;
+    auto camera = m_associatedCamera.lock();
+    if (!camera) return;
+    MathLib::Vector3 center = mxWorld.UnMatrixTranslate();
+    float radius = 0.0f;
+    if (auto box = model_bound.BoundingBox3())
+    {
+        center = mxWorld.TransformCoord(box->Center());
+        radius = MathLib::Vector3(box->Extent(0), box->Extent(1), box->Extent(2)).length() * mxWorld.GetMaxScale();
+    }
+    else if (auto sphere = model_bound.BoundingSphere3())
+    {
+        center = mxWorld.TransformCoord(sphere->Center());
+        radius = sphere->Radius() * mxWorld.GetMaxScale();
+    }
+    const float distance = std::max((center - camera->location()).length() - radius, 0.0f);
+    for (unsigned i = 0; i < texture_map.getCount(); i++)
+    {
+        if (const auto& texture = texture_map.getEffectSemanticTexture(i).texture()) texture->streamingPriority(distance);
+    }
+}
+
 error Renderer::beginScene()
 {
     if (!m_target.expired())
@@ -115,6 +143,7 @@ error Renderer::beginScene(const MathLib::Vector3& camera_loc, const MathLib::Ma
 error Renderer::prepareScene(const SceneGraph::VisibleSet& visible_set,
     SceneGraph::Spatial::SpatialFlags accept_filter, SceneGraph::Spatial::SpatialFlags reject_filter)
 {
+    PROFILE_ZONE("Renderer::prepareScene");
     const size_t count = visible_set.getCount();
     if (count <= 0) return ErrorCode::ok;
     const SceneGraph::VisibleSet::SpatialVector& spatial_array = visible_set.GetObjectSet();
@@ -130,6 +159,7 @@ error Renderer::prepareScene(const SceneGraph::VisibleSet& visible_set,
 
 error Renderer::drawScene()
 {
+    PROFILE_ZONE("Renderer::drawScene");
     for (size_t i = 0; i < m_renderPacksArray.size(); i++)
     {
         if (!m_renderPacksArray[i].hasElements()) continue;
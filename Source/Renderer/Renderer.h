@@ -16,6 +16,8 @@
 #include "SceneGraph/Spatial.h"
 #include "RenderPackList.h"
 #include "GameEngine/IRenderer.h"
+#include "GameEngine/EffectTextureMap.h"
+#include "GameEngine/BoundingVolume.h"
 #include <memory>
 #include <string>
 #include <system_error>
@@ -69,6 +71,8 @@ namespace Enigma::Renderer
             const Engine::RenderLightingState& lighting, RenderListID list_id);
         /** remove render element */
         virtual error removeRenderElement(const std::shared_ptr<RenderElement>& element, RenderListID list_id);
+        /** 以 associated camera 到物件 world bound 的距離, 回報 texture map 中各 texture 的 streaming priority */
+        void updateTexturePriority(const Engine::EffectTextureMap& texture_map, const MathLib::Matrix4& mxWorld, const Engine::BoundingVolume& model_bound);
 
         /** begin scene */
         virtual error beginScene();
@@ -94,6 +98,7 @@ namespace Enigma::Renderer
 
         /** associated camera */
         void setAssociatedCamera(const std::shared_ptr<SceneGraph::Camera>& camera);
+        std::shared_ptr<SceneGraph::Camera> associatedCamera() const { return m_associatedCamera.lock(); }
 
         /** we need change the sorting setting sometime */
         void enableSortBeforeDraw(RenderListID list_id, bool flag);
@@ -8,6 +8,7 @@
 #include "Frameworks/EventPublisher.h"
 #include "Frameworks/CommandBus.h"
 #include "Platforms/MemoryMacro.h"
+#include "GameEngine/EffectSemanticTexture.h"
 #include <cassert>
 
 #include "Platforms/PlatformLayer.h"
@@ -1,9 +1,14 @@
 ﻿#include "Culler.h"
 #include "Camera.h"
 #include "Frustum.h"
+#include "OcclusionCuller.h"
 #include "SceneGraphErrors.h"
 #include "Spatial.h"
 #include "Platforms/PlatformLayer.h"
+#include "Platforms/MemoryMacro.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "Frameworks/FrameProfiler.h"
+#include <algorithm>
 #include <cassert>
 
 using namespace Enigma::SceneGraph;
@@ -18,6 +23,9 @@ Culler::Culler(const std::shared_ptr<Camera>& camera)
     m_outerClipPlanes.resize(m_countCullerPlane);
     UpdateFrustumPlanes();
     m_outerClipShiftZ = 2.0f;
+    m_fanOutLevel = 0;
+    m_maxFanOutLevel = 0;
+    m_minFanOutSubtrees = 0;
 }
 
 Culler::Culler(const Culler& culler)
@@ -28,6 +36,12 @@ Culler::Culler(const Culler& culler)
     m_planeActivations = culler.m_planeActivations;
     m_outerClipShiftZ = culler.m_outerClipShiftZ;
     m_visibleSet = culler.m_visibleSet;
+    // occlusion culler 有每個 frame 的 depth buffer, 複製的 culler 要有自己的, 才能同時 culling
+    m_occlusionCuller = culler.m_occlusionCuller ? culler.m_occlusionCuller->duplicate() : nullptr;
+    m_workers = culler.m_workers;
+    m_fanOutLevel = culler.m_fanOutLevel;
+    m_maxFanOutLevel = culler.m_maxFanOutLevel;
+    m_minFanOutSubtrees = culler.m_minFanOutSubtrees;
     m_clipPlanes.resize(m_countCullerPlane);
     m_outerClipPlanes.resize(m_countCullerPlane);
     UpdateFrustumPlanes();
@@ -41,11 +55,33 @@ Culler::Culler(Culler&& culler) noexcept
     m_planeActivations = std::move(culler.m_planeActivations);
     m_outerClipShiftZ = culler.m_outerClipShiftZ;
     m_visibleSet = std::move(culler.m_visibleSet);
+    m_occlusionCuller = std::move(culler.m_occlusionCuller);
+    m_workers = std::move(culler.m_workers);
+    m_fanOutLevel = culler.m_fanOutLevel;
+    m_maxFanOutLevel = culler.m_maxFanOutLevel;
+    m_minFanOutSubtrees = culler.m_minFanOutSubtrees;
     m_clipPlanes.resize(m_countCullerPlane);
     m_outerClipPlanes.resize(m_countCullerPlane);
     UpdateFrustumPlanes();
 }
 
+Culler::Culler(const Culler& parent, unsigned fan_out_level)
+{
+    m_isEnableOuterClipping = parent.m_isEnableOuterClipping;
+    m_camera = parent.m_camera;
+    m_countCullerPlane = parent.m_countCullerPlane;
+    m_planeActivations = parent.m_planeActivations;
+    m_outerClipShiftZ = parent.m_outerClipShiftZ;
+    // 直接複製 planes, 包含 portal 加入的 additional planes, 不重算 frustum planes
+    m_clipPlanes = parent.m_clipPlanes;
+    m_outerClipPlanes = parent.m_outerClipPlanes;
+    m_workers = parent.m_workers;
+    m_fanOutLevel = fan_out_level;
+    m_maxFanOutLevel = parent.m_maxFanOutLevel;
+    m_minFanOutSubtrees = parent.m_minFanOutSubtrees;
+    m_traversingSpatials = parent.m_traversingSpatials;
+}
+
 Culler::~Culler()
 {
 }
@@ -59,6 +95,12 @@ Culler& Culler::operator=(const Culler& culler)
     m_planeActivations = culler.m_planeActivations;
     m_outerClipShiftZ = culler.m_outerClipShiftZ;
     m_visibleSet = culler.m_visibleSet;
+    // occlusion culler 有每個 frame 的 depth buffer, 複製的 culler 要有自己的, 才能同時 culling
+    m_occlusionCuller = culler.m_occlusionCuller ? culler.m_occlusionCuller->duplicate() : nullptr;
+    m_workers = culler.m_workers;
+    m_fanOutLevel = culler.m_fanOutLevel;
+    m_maxFanOutLevel = culler.m_maxFanOutLevel;
+    m_minFanOutSubtrees = culler.m_minFanOutSubtrees;
     m_clipPlanes.resize(m_countCullerPlane);
     m_outerClipPlanes.resize(m_countCullerPlane);
     UpdateFrustumPlanes();
@@ -73,6 +115,11 @@ Culler& Culler::operator=(Culler&& culler) noexcept
     m_planeActivations = std::move(culler.m_planeActivations);
     m_outerClipShiftZ = culler.m_outerClipShiftZ;
     m_visibleSet = std::move(culler.m_visibleSet);
+    m_occlusionCuller = std::move(culler.m_occlusionCuller);
+    m_workers = std::move(culler.m_workers);
+    m_fanOutLevel = culler.m_fanOutLevel;
+    m_maxFanOutLevel = culler.m_maxFanOutLevel;
+    m_minFanOutSubtrees = culler.m_minFanOutSubtrees;
     m_clipPlanes.resize(m_countCullerPlane);
     m_outerClipPlanes.resize(m_countCullerPlane);
     UpdateFrustumPlanes();
@@ -220,6 +267,7 @@ void Culler::UpdateFrustumPlanes()
 
 error Culler::ComputeVisibleSet(const std::shared_ptr<Spatial>& scene)
 {
+    PROFILE_ZONE("Culler::ComputeVisibleSet");
     m_visibleSet.clear();
 
     m_planeActivations.set();
@@ -228,7 +276,102 @@ error Culler::ComputeVisibleSet(const std::shared_ptr<Spatial>& scene)
     if (!scene) return ErrorCode::nullSceneGraph;
     UpdateFrustumPlanes();
 
-    return scene->cullVisibleSet(this, false);
+    m_traversingSpatials.clear();
+    error er = scene->cullVisibleSet(this, false);
+    if (er) return er;
+    if (m_occlusionCuller) er = m_occlusionCuller->cullOccludedObjects(m_camera, m_visibleSet);
+    return er;
+}
+
+std::vector<error> Culler::computeVisibleSets(const std::vector<Culler*>& cullers, const std::shared_ptr<Spatial>& scene,
+    const std::shared_ptr<Frameworks::WorkerThreadPool>& workers)
+{
+    std::vector<error> errors(cullers.size());
+#if defined(_DEBUG)
+    for (size_t i = 0; i < cullers.size(); i++)
+    {
+        for (size_t j = i + 1; j < cullers.size(); j++)
+        {
+            assert((!cullers[i]) || (!cullers[j]) || (cullers[i] != cullers[j]));
+            assert((!cullers[i]) || (!cullers[j]) || (!cullers[i]->m_occlusionCuller) || (cullers[i]->m_occlusionCuller != cullers[j]->m_occlusionCuller));
+        }
+    }
+#endif
+    auto compute_visible_sets = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            errors[i] = cullers[i] ? cullers[i]->ComputeVisibleSet(scene) : make_error_code(ErrorCode::nullCullerCamera);
+        }
+    };
+    if (workers)
+    {
+        workers->parallelFor(cullers.size(), compute_visible_sets);
+    }
+    else
+    {
+        compute_visible_sets(0, cullers.size());
+    }
+    return errors;
+}
+
+void Culler::enableParallelCulling(const std::shared_ptr<Frameworks::WorkerThreadPool>& workers, unsigned max_fan_out_level, unsigned min_fan_out_subtrees)
+{
+    m_workers = workers;
+    m_maxFanOutLevel = max_fan_out_level;
+    m_minFanOutSubtrees = std::max(2u, min_fan_out_subtrees);
+}
+
+void Culler::disableParallelCulling()
+{
+    m_workers.reset();
+    m_maxFanOutLevel = 0;
+}
+
+error Culler::cullSubtrees(const SpatialList& subtrees, bool noCull)
+{
+    const auto workers = m_workers.lock();
+    if ((!workers) || (m_fanOutLevel >= m_maxFanOutLevel) || (subtrees.size() < m_minFanOutSubtrees))
+    {
+        for (auto& subtree : subtrees)
+        {
+            error er = subtree->cullVisibleSet(this, noCull);
+            if (er) return er;
+        }
+        return ErrorCode::ok;
+    }
+
+    const std::vector<std::shared_ptr<Spatial>> subtree_array{ subtrees.begin(), subtrees.end() };
+    std::vector<std::unique_ptr<Culler>> task_cullers(subtree_array.size());
+    std::vector<error> task_errors(subtree_array.size());
+    workers->parallelFor(subtree_array.size(), [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                task_cullers[i] = std::unique_ptr<Culler>(menew Culler(*this, m_fanOutLevel + 1));
+                task_errors[i] = subtree_array[i]->cullVisibleSet(task_cullers[i].get(), noCull);
+            }
+        });
+    // 依照 subtree 的順序合併, 結果與循序 culling 相同
+    for (size_t i = 0; i < subtree_array.size(); i++)
+    {
+        m_visibleSet.Merge(std::move(task_cullers[i]->m_visibleSet));
+        if (task_errors[i]) return task_errors[i];
+    }
+    return ErrorCode::ok;
+}
+
+bool Culler::beginTraversal(const Spatial* spatial)
+{
+    if (std::find(m_traversingSpatials.begin(), m_traversingSpatials.end(), spatial) != m_traversingSpatials.end()) return false;
+    m_traversingSpatials.push_back(spatial);
+    return true;
+}
+
+void Culler::endTraversal(const Spatial* spatial)
+{
+    auto it = std::find(m_traversingSpatials.rbegin(), m_traversingSpatials.rend(), spatial);
+    if (it != m_traversingSpatials.rend()) m_traversingSpatials.erase(std::next(it).base());
 }
 
 bool Culler::IsVisible(const Engine::BoundingVolume& bound)
@@ -13,6 +13,13 @@
 #include <memory>
 #include <system_error>
 #include <bitset>
+#include <list>
+#include <vector>
+
+namespace Enigma::Frameworks
+{
+    class WorkerThreadPool;
+}
 
 namespace Enigma::SceneGraph
 {
@@ -20,6 +27,7 @@ namespace Enigma::SceneGraph
     class Camera;
     class VisibleSet;
     class Spatial;
+    class OcclusionCuller;
 
     /** Scene Graph Culler object */
     class Culler
@@ -37,6 +45,7 @@ namespace Enigma::SceneGraph
         };
         enum { CULLER_MAX_PLANE_QUANTITY = 32 };
         using PlaneActivationBits = std::bitset<CULLER_MAX_PLANE_QUANTITY>;
+        using SpatialList = std::list<std::shared_ptr<Spatial>>;
 
     public:
         Culler(const std::shared_ptr<Camera>& camera);
@@ -52,6 +61,27 @@ namespace Enigma::SceneGraph
         const VisibleSet& getVisibleSet() const { return m_visibleSet; };
 
         error ComputeVisibleSet(const std::shared_ptr<Spatial>& scene);
+        /** compute several cullers' visible set (ex. main camera, cascade shadow, deferred lights) concurrently,
+         each culler must have its own occlusion culler */
+        static std::vector<error> computeVisibleSets(const std::vector<Culler*>& cullers, const std::shared_ptr<Spatial>& scene,
+            const std::shared_ptr<Frameworks::WorkerThreadPool>& workers);
+
+        /** cull subtrees on worker pool, each subtree use a forked culler and merge visible sets in subtree order.
+         @param max_fan_out_level nested fan out levels, deeper subtrees are culled on the task's thread
+         @param min_fan_out_subtrees nodes with fewer children are culled sequentially */
+        void enableParallelCulling(const std::shared_ptr<Frameworks::WorkerThreadPool>& workers, unsigned max_fan_out_level = 2, unsigned min_fan_out_subtrees = 4);
+        void disableParallelCulling();
+        /** cull children of node, used by node culling (recursive calling) */
+        error cullSubtrees(const SpatialList& subtrees, bool noCull);
+
+        /** portal zone 互相連接, 用 culler 自己的 traversal 紀錄避免無窮迴圈, 不同的 culler 可以同時走訪同一個 zone
+         @return false if spatial is traversing */
+        bool beginTraversal(const Spatial* spatial);
+        void endTraversal(const Spatial* spatial);
+
+        /** optional occlusion culling stage, run after frustum culling, null to disable */
+        void occlusionCuller(const std::shared_ptr<OcclusionCuller>& occlusion_culler) { m_occlusionCuller = occlusion_culler; }
+        const std::shared_ptr<OcclusionCuller>& occlusionCuller() const { return m_occlusionCuller; }
 
         bool IsVisible(const Engine::BoundingVolume& bound);
         bool IsVisible(MathLib::Vector3* vecPos, unsigned int quantity, bool isIgnoreNearPlane);
@@ -72,6 +102,10 @@ namespace Enigma::SceneGraph
         void PushAdditionalPlane(const MathLib::Plane3& plane);
         void RemoveAdditionalPlane();
 
+    protected:
+        /** forked culler for subtree task, copy planes & activations, with empty visible set */
+        Culler(const Culler& parent, unsigned fan_out_level);
+
     protected:
 
         std::shared_ptr<Camera> m_camera;
@@ -99,6 +133,14 @@ namespace Enigma::SceneGraph
         float m_outerClipShiftZ;
 
         VisibleSet m_visibleSet;
+
+        std::shared_ptr<OcclusionCuller> m_occlusionCuller;
+
+        std::weak_ptr<Frameworks::WorkerThreadPool> m_workers;
+        unsigned m_fanOutLevel;
+        unsigned m_maxFanOutLevel;
+        unsigned m_minFanOutSubtrees;
+        std::vector<const Spatial*> m_traversingSpatials;
     };
 };
 
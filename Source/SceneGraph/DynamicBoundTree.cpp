@@ -0,0 +1,259 @@
+﻿#include "DynamicBoundTree.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::SceneGraph;
+
+static constexpr size_t INITIAL_NODE_CAPACITY = 64;
+
+DynamicBoundTree::DynamicBoundTree(float fat_margin) : m_fatMargin(fat_margin), m_root(NULL_NODE), m_freeList(NULL_NODE), m_proxyCount(0)
+{
+    m_nodes.reserve(INITIAL_NODE_CAPACITY);
+}
+
+DynamicBoundTree::~DynamicBoundTree()
+{
+    m_nodes.clear();
+}
+
+int DynamicBoundTree::createProxy(const Aabb& bound, unsigned user_data)
+{
+    const int proxy = allocateNode();
+    Node& node = m_nodes[proxy];
+    for (unsigned k = 0; k < 3; k++)
+    {
+        node.m_bound.m_min[k] = bound.m_min[k] - m_fatMargin;
+        node.m_bound.m_max[k] = bound.m_max[k] + m_fatMargin;
+    }
+    node.m_userData = user_data;
+    node.m_height = 0;
+    insertLeaf(proxy);
+    m_proxyCount++;
+    return proxy;
+}
+
+void DynamicBoundTree::destroyProxy(int proxy)
+{
+    assert((proxy >= 0) && (proxy < static_cast<int>(m_nodes.size())));
+    assert(m_nodes[proxy].isLeaf());
+    removeLeaf(proxy);
+    freeNode(proxy);
+    m_proxyCount--;
+}
+
+bool DynamicBoundTree::moveProxy(int proxy, const Aabb& bound)
+{
+    assert((proxy >= 0) && (proxy < static_cast<int>(m_nodes.size())));
+    assert(m_nodes[proxy].isLeaf());
+    if (m_nodes[proxy].m_bound.contains(bound)) return false;
+    removeLeaf(proxy);
+    Node& node = m_nodes[proxy];
+    for (unsigned k = 0; k < 3; k++)
+    {
+        node.m_bound.m_min[k] = bound.m_min[k] - m_fatMargin;
+        node.m_bound.m_max[k] = bound.m_max[k] + m_fatMargin;
+    }
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicBoundTree::clear()
+{
+    m_nodes.clear();
+    m_root = NULL_NODE;
+    m_freeList = NULL_NODE;
+    m_proxyCount = 0;
+}
+
+float DynamicBoundTree::areaRatio() const
+{
+    if (m_root == NULL_NODE) return 0.0f;
+    const float root_area = m_nodes[m_root].m_bound.surfaceArea();
+    if (root_area <= 0.0f) return 0.0f;
+    float total_area = 0.0f;
+    for (const auto& node : m_nodes)
+    {
+        if (node.m_height <= 0) continue;
+        total_area += node.m_bound.surfaceArea();
+    }
+    return total_area / root_area;
+}
+
+int DynamicBoundTree::allocateNode()
+{
+    if (m_freeList == NULL_NODE)
+    {
+        m_nodes.emplace_back();
+        m_freeList = static_cast<int>(m_nodes.size()) - 1;
+        m_nodes[m_freeList].m_parent = NULL_NODE;
+    }
+    const int index = m_freeList;
+    Node& node = m_nodes[index];
+    m_freeList = node.m_parent;
+    node.m_parent = NULL_NODE;
+    node.m_child1 = NULL_NODE;
+    node.m_child2 = NULL_NODE;
+    node.m_height = 0;
+    node.m_userData = 0;
+    return index;
+}
+
+void DynamicBoundTree::freeNode(int node)
+{
+    m_nodes[node].m_parent = m_freeList;
+    m_nodes[node].m_height = -1;
+    m_freeList = node;
+}
+
+void DynamicBoundTree::insertLeaf(int leaf)
+{
+    if (m_root == NULL_NODE)
+    {
+        m_root = leaf;
+        m_nodes[leaf].m_parent = NULL_NODE;
+        return;
+    }
+
+    // 往下找面積增量最小的兄弟節點
+    const Aabb leaf_bound = m_nodes[leaf].m_bound;
+    int index = m_root;
+    while (!m_nodes[index].isLeaf())
+    {
+        const Node& node = m_nodes[index];
+        const float area = node.m_bound.surfaceArea();
+        const float combined_area = Aabb::merge(node.m_bound, leaf_bound).surfaceArea();
+        // 在這裡建新的 parent 的成本, 以及往下走要承擔的繼承成本
+        const float cost = 2.0f * combined_area;
+        const float inheritance_cost = 2.0f * (combined_area - area);
+        auto descend_cost = [&](int child)
+        {
+            const Aabb merged = Aabb::merge(leaf_bound, m_nodes[child].m_bound);
+            if (m_nodes[child].isLeaf()) return merged.surfaceArea() + inheritance_cost;
+            return merged.surfaceArea() - m_nodes[child].m_bound.surfaceArea() + inheritance_cost;
+        };
+        const float cost1 = descend_cost(node.m_child1);
+        const float cost2 = descend_cost(node.m_child2);
+        if ((cost < cost1) && (cost < cost2)) break;
+        index = cost1 < cost2 ? node.m_child1 : node.m_child2;
+    }
+    const int sibling = index;
+
+    const int old_parent = m_nodes[sibling].m_parent;
+    const int new_parent = allocateNode();
+    m_nodes[new_parent].m_parent = old_parent;
+    m_nodes[new_parent].m_bound = Aabb::merge(leaf_bound, m_nodes[sibling].m_bound);
+    m_nodes[new_parent].m_height = m_nodes[sibling].m_height + 1;
+    m_nodes[new_parent].m_child1 = sibling;
+    m_nodes[new_parent].m_child2 = leaf;
+    m_nodes[sibling].m_parent = new_parent;
+    m_nodes[leaf].m_parent = new_parent;
+    if (old_parent == NULL_NODE)
+    {
+        m_root = new_parent;
+    }
+    else if (m_nodes[old_parent].m_child1 == sibling)
+    {
+        m_nodes[old_parent].m_child1 = new_parent;
+    }
+    else
+    {
+        m_nodes[old_parent].m_child2 = new_parent;
+    }
+    refitAncestors(m_nodes[leaf].m_parent);
+}
+
+void DynamicBoundTree::removeLeaf(int leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = NULL_NODE;
+        return;
+    }
+    const int parent = m_nodes[leaf].m_parent;
+    const int grand_parent = m_nodes[parent].m_parent;
+    const int sibling = m_nodes[parent].m_child1 == leaf ? m_nodes[parent].m_child2 : m_nodes[parent].m_child1;
+    if (grand_parent == NULL_NODE)
+    {
+        m_root = sibling;
+        m_nodes[sibling].m_parent = NULL_NODE;
+        freeNode(parent);
+        return;
+    }
+    if (m_nodes[grand_parent].m_child1 == parent)
+    {
+        m_nodes[grand_parent].m_child1 = sibling;
+    }
+    else
+    {
+        m_nodes[grand_parent].m_child2 = sibling;
+    }
+    m_nodes[sibling].m_parent = grand_parent;
+    freeNode(parent);
+    refitAncestors(grand_parent);
+}
+
+void DynamicBoundTree::refitAncestors(int node)
+{
+    int index = node;
+    while (index != NULL_NODE)
+    {
+        index = balance(index);
+        Node& n = m_nodes[index];
+        n.m_height = 1 + std::max(m_nodes[n.m_child1].m_height, m_nodes[n.m_child2].m_height);
+        n.m_bound = Aabb::merge(m_nodes[n.m_child1].m_bound, m_nodes[n.m_child2].m_bound);
+        index = n.m_parent;
+    }
+}
+
+int DynamicBoundTree::balance(int a)
+{
+    // 子樹高度差超過 1 時, 把較高的子節點轉上來 (同 AVL 的單旋轉)
+    Node& node_a = m_nodes[a];
+    if (node_a.isLeaf() || (node_a.m_height < 2)) return a;
+    const int b = node_a.m_child1;
+    const int c = node_a.m_child2;
+    const int height_diff = m_nodes[c].m_height - m_nodes[b].m_height;
+    if ((height_diff >= -1) && (height_diff <= 1)) return a;
+
+    // up 轉成 a 的 parent, a 接手 up 的一個子節點
+    const int up = height_diff > 1 ? c : b;
+    const int stay = height_diff > 1 ? b : c;
+    Node& node_up = m_nodes[up];
+    const int f = node_up.m_child1;
+    const int g = node_up.m_child2;
+
+    node_up.m_child1 = a;
+    node_up.m_parent = node_a.m_parent;
+    node_a.m_parent = up;
+    if (node_up.m_parent == NULL_NODE)
+    {
+        m_root = up;
+    }
+    else if (m_nodes[node_up.m_parent].m_child1 == a)
+    {
+        m_nodes[node_up.m_parent].m_child1 = up;
+    }
+    else
+    {
+        m_nodes[node_up.m_parent].m_child2 = up;
+    }
+
+    // 較高的孫節點留在 up 下, 較矮的給 a
+    const int high = m_nodes[f].m_height > m_nodes[g].m_height ? f : g;
+    const int low = high == f ? g : f;
+    node_up.m_child2 = high;
+    if (up == c)
+    {
+        node_a.m_child2 = low;
+    }
+    else
+    {
+        node_a.m_child1 = low;
+    }
+    m_nodes[low].m_parent = a;
+    node_a.m_bound = Aabb::merge(m_nodes[stay].m_bound, m_nodes[low].m_bound);
+    node_a.m_height = 1 + std::max(m_nodes[stay].m_height, m_nodes[low].m_height);
+    node_up.m_bound = Aabb::merge(node_a.m_bound, m_nodes[high].m_bound);
+    node_up.m_height = 1 + std::max(node_a.m_height, m_nodes[high].m_height);
+    return up;
+}
@@ -0,0 +1,230 @@
+﻿/*********************************************************************
+ * \file   DynamicBoundTree.h
+ * \brief  incremental AABB tree of fattened proxies, for dynamic
+ *          scene broadphase queries
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef DYNAMIC_BOUND_TREE_H
+#define DYNAMIC_BOUND_TREE_H
+
+#include <vector>
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace Enigma::SceneGraph
+{
+    /** 每個 proxy 存放放大過 (fat margin) 的 AABB, bound 小幅移動時不用重新插入;
+     插入時以面積增量 (SAH) 選擇兄弟節點, 並以旋轉維持平衡 */
+    class DynamicBoundTree
+    {
+    public:
+        static constexpr int NULL_NODE = -1;
+
+        struct Aabb
+        {
+            std::array<float, 3> m_min;
+            std::array<float, 3> m_max;
+
+            bool contains(const Aabb& other) const;
+            bool overlaps(const Aabb& other) const;
+            float surfaceArea() const;
+            static Aabb merge(const Aabb& a, const Aabb& b);
+        };
+
+        struct Node
+        {
+            Aabb m_bound;
+            /// free list 時是 next free node
+            int m_parent;
+            int m_child1;
+            int m_child2;
+            /// leaf 是 0, free node 是 -1
+            int m_height;
+            unsigned m_userData;
+
+            bool isLeaf() const { return m_child1 == NULL_NODE; }
+        };
+
+    public:
+        explicit DynamicBoundTree(float fat_margin);
+        DynamicBoundTree(const DynamicBoundTree&) = delete;
+        DynamicBoundTree(DynamicBoundTree&&) = delete;
+        ~DynamicBoundTree();
+        DynamicBoundTree& operator=(const DynamicBoundTree&) = delete;
+        DynamicBoundTree& operator=(DynamicBoundTree&&) = delete;
+
+        /** 回傳 proxy id (leaf node index) */
+        int createProxy(const Aabb& bound, unsigned user_data);
+        void destroyProxy(int proxy);
+        /** bound 仍在 fat bound 內時不動, 回傳是否重新插入 */
+        bool moveProxy(int proxy, const Aabb& bound);
+        void clear();
+
+        unsigned userData(int proxy) const { return m_nodes[proxy].m_userData; }
+        const Aabb& fatBound(int proxy) const { return m_nodes[proxy].m_bound; }
+        unsigned proxyCount() const { return m_proxyCount; }
+        int height() const { return m_root == NULL_NODE ? 0 : m_nodes[m_root].m_height; }
+        /** sum of interior node area / root area, 越小越好 */
+        float areaRatio() const;
+
+        /** visit(proxy) 回傳 false 時停止 */
+        template <class Visitor> void queryOverlap(const Aabb& bound, Visitor&& visit) const;
+        /** direction 不需單位長度, 子節點依 fat bound 的進入距離先近後遠走訪, t_enter > max_t 的略過;
+         visit(proxy, t_enter) 回傳新的 max_t (找最近交點時可以縮短射線), 回傳負值時停止 */
+        template <class Visitor> void queryRay(const std::array<float, 3>& origin, const std::array<float, 3>& direction, float max_t, Visitor&& visit) const;
+
+        static bool intersectRay(const Aabb& bound, const std::array<float, 3>& origin, const std::array<float, 3>& inv_direction, float max_t, float& t_enter);
+
+    protected:
+        int allocateNode();
+        void freeNode(int node);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        int balance(int node);
+        void refitAncestors(int node);
+
+    protected:
+        float m_fatMargin;
+        std::vector<Node> m_nodes;
+        int m_root;
+        int m_freeList;
+        unsigned m_proxyCount;
+    };
+
+    inline bool DynamicBoundTree::Aabb::contains(const Aabb& other) const
+    {
+        return m_min[0] <= other.m_min[0] && m_min[1] <= other.m_min[1] && m_min[2] <= other.m_min[2]
+            && other.m_max[0] <= m_max[0] && other.m_max[1] <= m_max[1] && other.m_max[2] <= m_max[2];
+    }
+
+    inline bool DynamicBoundTree::Aabb::overlaps(const Aabb& other) const
+    {
+        return m_min[0] <= other.m_max[0] && other.m_min[0] <= m_max[0]
+            && m_min[1] <= other.m_max[1] && other.m_min[1] <= m_max[1]
+            && m_min[2] <= other.m_max[2] && other.m_min[2] <= m_max[2];
+    }
+
+    inline float DynamicBoundTree::Aabb::surfaceArea() const
+    {
+        const float dx = m_max[0] - m_min[0];
+        const float dy = m_max[1] - m_min[1];
+        const float dz = m_max[2] - m_min[2];
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+
+    inline DynamicBoundTree::Aabb DynamicBoundTree::Aabb::merge(const Aabb& a, const Aabb& b)
+    {
+        Aabb result;
+        for (unsigned k = 0; k < 3; k++)
+        {
+            result.m_min[k] = a.m_min[k] < b.m_min[k] ? a.m_min[k] : b.m_min[k];
+            result.m_max[k] = a.m_max[k] > b.m_max[k] ? a.m_max[k] : b.m_max[k];
+        }
+        return result;
+    }
+
+    inline bool DynamicBoundTree::intersectRay(const Aabb& bound, const std::array<float, 3>& origin, const std::array<float, 3>& inv_direction, float max_t, float& t_enter)
+    {
+        float t_min = 0.0f;
+        float t_max = max_t;
+        for (unsigned k = 0; k < 3; k++)
+        {
+            if (std::isinf(inv_direction[k]))
+            {
+                // 平行於 slab
+                if ((origin[k] < bound.m_min[k]) || (origin[k] > bound.m_max[k])) return false;
+                continue;
+            }
+            float t0 = (bound.m_min[k] - origin[k]) * inv_direction[k];
+            float t1 = (bound.m_max[k] - origin[k]) * inv_direction[k];
+            if (t0 > t1) std::swap(t0, t1);
+            if (t0 > t_min) t_min = t0;
+            if (t1 < t_max) t_max = t1;
+            if (t_min > t_max) return false;
+        }
+        t_enter = t_min;
+        return true;
+    }
+
+    template <class Visitor> void DynamicBoundTree::queryOverlap(const Aabb& bound, Visitor&& visit) const
+    {
+        if (m_root == NULL_NODE) return;
+        std::vector<int> stack;
+        stack.reserve(64);
+        stack.push_back(m_root);
+        while (!stack.empty())
+        {
+            const int index = stack.back();
+            stack.pop_back();
+            const Node& node = m_nodes[index];
+            if (!node.m_bound.overlaps(bound)) continue;
+            if (node.isLeaf())
+            {
+                if (!visit(index)) return;
+                continue;
+            }
+            stack.push_back(node.m_child1);
+            stack.push_back(node.m_child2);
+        }
+    }
+
+    template <class Visitor> void DynamicBoundTree::queryRay(const std::array<float, 3>& origin, const std::array<float, 3>& direction, float max_t, Visitor&& visit) const
+    {
+        if (m_root == NULL_NODE) return;
+        const std::array<float, 3> inv_direction = { 1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2] };
+        struct Entry
+        {
+            int m_node;
+            float m_t;
+        };
+        std::vector<Entry> stack;
+        stack.reserve(64);
+        float t_enter;
+        if (!intersectRay(m_nodes[m_root].m_bound, origin, inv_direction, max_t, t_enter)) return;
+        stack.push_back({ m_root, t_enter });
+        while (!stack.empty())
+        {
+            const Entry entry = stack.back();
+            stack.pop_back();
+            // max_t 可能在 push 之後被縮短
+            if (entry.m_t > max_t) continue;
+            const Node& node = m_nodes[entry.m_node];
+            if (node.isLeaf())
+            {
+                max_t = visit(entry.m_node, entry.m_t);
+                if (max_t < 0.0f) return;
+                continue;
+            }
+            float t1, t2;
+            const bool hit1 = intersectRay(m_nodes[node.m_child1].m_bound, origin, inv_direction, max_t, t1);
+            const bool hit2 = intersectRay(m_nodes[node.m_child2].m_bound, origin, inv_direction, max_t, t2);
+            if (hit1 && hit2)
+            {
+                // 遠的先 push, 近的先走訪
+                if (t1 <= t2)
+                {
+                    stack.push_back({ node.m_child2, t2 });
+                    stack.push_back({ node.m_child1, t1 });
+                }
+                else
+                {
+                    stack.push_back({ node.m_child1, t1 });
+                    stack.push_back({ node.m_child2, t2 });
+                }
+            }
+            else if (hit1)
+            {
+                stack.push_back({ node.m_child1, t1 });
+            }
+            else if (hit2)
+            {
+                stack.push_back({ node.m_child2, t2 });
+            }
+        }
+    }
+}
+
+#endif // DYNAMIC_BOUND_TREE_H
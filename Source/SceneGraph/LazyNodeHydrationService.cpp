@@ -19,6 +19,7 @@ DEFINE_RTTI(SceneGraph, LazyNodeHydrationService, ISystemService);
 LazyNodeHydrationService::LazyNodeHydrationService(Frameworks::ServiceManager* mngr, const std::shared_ptr<SceneGraphRepository>& scene_graph_repository, const std::shared_ptr<Engine::TimerService>& timer) : ISystemService(mngr), m_sceneGraphRepository(scene_graph_repository), m_timer(timer), m_isCurrentHydrating(false)
 {
     m_needTick = false;
+    m_tickPriority = ServicePriority::Background;
     registerHandlers();
 }
 
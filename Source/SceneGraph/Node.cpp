@@ -99,16 +99,7 @@ error Node::onCullingVisible(Culler* culler, bool noCull)
     culler->Insert(thisSpatial());
 
     if (m_childList.size() == 0) return ErrorCode::ok;
-    error er = ErrorCode::ok;
-    ChildList::iterator iter = m_childList.begin();
-    while (iter != m_childList.end())
-    {
-        er = (*iter)->cullVisibleSet(culler, noCull);
-        if (er) return er;
-
-        ++iter;
-    }
-    return ErrorCode::ok;
+    return culler->cullSubtrees(m_childList, noCull);
 }
 
 SceneTraveler::TravelResult Node::visitBy(SceneTraveler* traveler)
@@ -0,0 +1,181 @@
+﻿#include "OcclusionCuller.h"
+#include "Camera.h"
+#include "VisibleSet.h"
+#include "Spatial.h"
+#include "SceneGraphErrors.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "MathLib/Box3.h"
+#include "MathLib/Sphere3.h"
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <optional>
+#include <cmath>
+#include <cassert>
+
+using namespace Enigma::SceneGraph;
+using namespace Enigma::MathLib;
+
+using clock_type = std::chrono::high_resolution_clock;
+using milliseconds_float = std::chrono::duration<float, std::milli>;
+
+static constexpr unsigned MIN_RASTERIZE_ROWS = 8;
+static constexpr size_t MIN_TEST_OBJECTS = 64;
+
+static std::optional<Box3> boxOfBound(const Enigma::Engine::BoundingVolume& bound, bool is_inscribed)
+{
+    if (auto box = bound.BoundingBox3()) return box;
+    if (auto sphere = bound.BoundingSphere3())
+    {
+        // occluder 要用內接 box 才保守, 被測物件用外接 box
+        const float extent = is_inscribed ? sphere->Radius() / std::sqrt(3.0f) : sphere->Radius();
+        return Box3(sphere->Center(), Vector3::UNIT_X, Vector3::UNIT_Y, Vector3::UNIT_Z, extent, extent, extent);
+    }
+    return std::nullopt;
+}
+
+OcclusionCuller::OcclusionCuller(unsigned buffer_width, unsigned buffer_height, const std::shared_ptr<Frameworks::WorkerThreadPool>& workers)
+    : m_workers(workers), m_depthBuffer(buffer_width, buffer_height)
+{
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    m_staticOccluderTriangles.clear();
+    m_frameOccluderTriangles.clear();
+}
+
+void OcclusionCuller::addStaticOccluder(const std::vector<Vector3>& world_triangles)
+{
+    std::lock_guard locker{ m_staticOccluderLock };
+    m_staticOccluderTriangles.insert(m_staticOccluderTriangles.end(), world_triangles.begin(), world_triangles.end());
+}
+
+void OcclusionCuller::clearStaticOccluders()
+{
+    std::lock_guard locker{ m_staticOccluderLock };
+    m_staticOccluderTriangles.clear();
+}
+
+std::shared_ptr<OcclusionCuller> OcclusionCuller::duplicate() const
+{
+    auto occlusion_culler = std::make_shared<OcclusionCuller>(m_depthBuffer.width(), m_depthBuffer.height(), m_workers.lock());
+    std::lock_guard locker{ m_staticOccluderLock };
+    occlusion_culler->m_staticOccluderTriangles = m_staticOccluderTriangles;
+    return occlusion_culler;
+}
+
+error OcclusionCuller::cullOccludedObjects(const std::shared_ptr<Camera>& camera, VisibleSet& visible_set)
+{
+    if (!camera) return ErrorCode::cameraNotReady;
+    m_statistics = Statistics{};
+    const auto workers = m_workers.lock();
+
+    auto time_point = clock_type::now();
+    m_depthBuffer.clear(camera->projectionTransform() * camera->viewTransform());
+    m_frameOccluderTriangles.clear();
+    for (const auto& spatial : visible_set.GetObjectSet())
+    {
+        if ((!spatial) || (!spatial->testSpatialFlag(Spatial::Spatial_Occluder))) continue;
+        if (collectOccluderTriangles(camera, spatial)) m_statistics.m_occluderCount++;
+    }
+    {
+        std::lock_guard locker{ m_staticOccluderLock };
+        m_depthBuffer.setupTriangles(m_staticOccluderTriangles);
+    }
+    m_depthBuffer.setupTriangles(m_frameOccluderTriangles);
+    m_statistics.m_occluderTriangleCount = m_depthBuffer.triangleCount();
+    m_statistics.m_setupMilliseconds = milliseconds_float(clock_type::now() - time_point).count();
+    if (m_depthBuffer.triangleCount() == 0) return ErrorCode::ok;
+
+    time_point = clock_type::now();
+    if (workers)
+    {
+        workers->parallelFor(m_depthBuffer.height(), [this](size_t begin, size_t end)
+            { m_depthBuffer.rasterizeRows(static_cast<unsigned>(begin), static_cast<unsigned>(end)); }, MIN_RASTERIZE_ROWS);
+    }
+    else
+    {
+        m_depthBuffer.rasterizeRows(0, m_depthBuffer.height());
+    }
+    m_statistics.m_rasterizeMilliseconds = milliseconds_float(clock_type::now() - time_point).count();
+
+    time_point = clock_type::now();
+    m_depthBuffer.buildHiZPyramid();
+    m_statistics.m_pyramidMilliseconds = milliseconds_float(clock_type::now() - time_point).count();
+
+    time_point = clock_type::now();
+    const VisibleSet::SpatialVector& objects = visible_set.GetObjectSet();
+    std::vector<unsigned char> occluded_flags(objects.size(), 0);
+    std::atomic<unsigned> tested_count{ 0 };
+    auto test_objects = [&](size_t begin, size_t end)
+    {
+        unsigned tested = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            const auto& spatial = objects[i];
+            if ((!spatial) || (!spatial->isRenderable()) || (spatial->testSpatialFlag(Spatial::Spatial_Occluder))) continue;
+            auto box = boxOfBound(spatial->getWorldBound(), false);
+            if (!box) continue;
+            tested++;
+            if (m_depthBuffer.isOccluded(box->ComputeVertices())) occluded_flags[i] = 1;
+        }
+        tested_count += tested;
+    };
+    if (workers)
+    {
+        workers->parallelFor(objects.size(), test_objects, MIN_TEST_OBJECTS);
+    }
+    else
+    {
+        test_objects(0, objects.size());
+    }
+    m_statistics.m_testedCount = tested_count;
+    visible_set.removeIf([&occluded_flags](size_t index, const SpatialPtr&) { return occluded_flags[index] != 0; });
+    m_statistics.m_occludedCount = static_cast<unsigned>(std::count(occluded_flags.begin(), occluded_flags.end(), 1));
+    m_statistics.m_testMilliseconds = milliseconds_float(clock_type::now() - time_point).count();
+
+    return ErrorCode::ok;
+}
+
+bool OcclusionCuller::collectOccluderTriangles(const std::shared_ptr<Camera>& camera, const std::shared_ptr<Spatial>& spatial)
+{
+    assert(camera && spatial);
+    auto box = boxOfBound(spatial->getWorldBound(), true);
+    if (!box) return false;
+    const Vector3 eye = camera->location();
+    const Vector3 offset = eye - box->Center();
+    bool is_eye_inside = true;
+    for (int i = 0; i < 3; i++)
+    {
+        if (std::fabs(offset.dot(box->Axis(i))) > box->Extent(i)) is_eye_inside = false;
+    }
+    if (is_eye_inside) return false;
+    const auto corners = box->ComputeVertices();
+    const Vector3 forward = camera->eyeToLookatVector();
+    const float near_z = camera->cullingFrustum().nearPlaneZ();
+    for (const auto& corner : corners)
+    {
+        if ((corner - eye).dot(forward) <= near_z) return false;
+    }
+    appendBoxTriangles(corners, m_frameOccluderTriangles);
+    return true;
+}
+
+void OcclusionCuller::appendBoxTriangles(const std::array<Vector3, 8>& corners, std::vector<Vector3>& triangles)
+{
+    // Box3::ComputeVertices 的頂點順序 : 0~3 是 -axis2 面, 4~7 是 +axis2 面
+    static constexpr unsigned box_indices[36] =
+    {
+        0, 1, 2, 0, 2, 3,
+        4, 6, 5, 4, 7, 6,
+        0, 5, 1, 0, 4, 5,
+        3, 2, 6, 3, 6, 7,
+        0, 3, 7, 0, 7, 4,
+        1, 5, 6, 1, 6, 2,
+    };
+    for (unsigned index : box_indices)
+    {
+        triangles.emplace_back(corners[index]);
+    }
+}
@@ -0,0 +1,82 @@
+﻿/*********************************************************************
+ * \file   OcclusionCuller.h
+ * \brief  software (Hi-Z) occlusion culling stage, run after frustum culling
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include "OcclusionDepthBuffer.h"
+#include "MathLib/Vector3.h"
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <system_error>
+
+namespace Enigma::Frameworks
+{
+    class WorkerThreadPool;
+}
+
+namespace Enigma::SceneGraph
+{
+    using error = std::error_code;
+    class Camera;
+    class VisibleSet;
+    class Spatial;
+
+    /** 把標記為 occluder (Spatial_Occluder) 的可見物件及 static occluder (ex. terrain 的粗略網格)
+     畫進低解析度 depth buffer, 再用 Hi-Z pyramid 測試其他可見物件的 bound */
+    class OcclusionCuller
+    {
+    public:
+        struct Statistics
+        {
+            unsigned m_occluderCount = 0;
+            size_t m_occluderTriangleCount = 0;
+            unsigned m_testedCount = 0;
+            unsigned m_occludedCount = 0;
+            float m_setupMilliseconds = 0.0f;
+            float m_rasterizeMilliseconds = 0.0f;
+            float m_pyramidMilliseconds = 0.0f;
+            float m_testMilliseconds = 0.0f;
+        };
+
+    public:
+        OcclusionCuller(unsigned buffer_width, unsigned buffer_height, const std::shared_ptr<Frameworks::WorkerThreadPool>& workers);
+        OcclusionCuller(const OcclusionCuller&) = delete;
+        OcclusionCuller(OcclusionCuller&&) = delete;
+        ~OcclusionCuller();
+        OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+        OcclusionCuller& operator=(OcclusionCuller&&) = delete;
+
+        /** static occluder triangles in world space, 3 vertices per triangle */
+        void addStaticOccluder(const std::vector<MathLib::Vector3>& world_triangles);
+        void clearStaticOccluders();
+        /** 同樣的 buffer 大小, workers 及 static occluders, 但有自己的 depth buffer; 給複製的 culler 用 */
+        std::shared_ptr<OcclusionCuller> duplicate() const;
+
+        /** remove occluded objects from visible set, used by culler after frustum culling */
+        error cullOccludedObjects(const std::shared_ptr<Camera>& camera, VisibleSet& visible_set);
+
+        const Statistics& statistics() const { return m_statistics; }
+        const OcclusionDepthBuffer& depthBuffer() const { return m_depthBuffer; }
+
+    protected:
+        static void appendBoxTriangles(const std::array<MathLib::Vector3, 8>& corners, std::vector<MathLib::Vector3>& triangles);
+        /** camera 在 occluder 裡面, 或 occluder 跨過 near plane 時不畫, 否則整個畫面都會被當成遮住 */
+        bool collectOccluderTriangles(const std::shared_ptr<Camera>& camera, const std::shared_ptr<Spatial>& spatial);
+
+    protected:
+        std::weak_ptr<Frameworks::WorkerThreadPool> m_workers;
+        OcclusionDepthBuffer m_depthBuffer;
+        std::vector<MathLib::Vector3> m_staticOccluderTriangles;
+        mutable std::mutex m_staticOccluderLock;
+        std::vector<MathLib::Vector3> m_frameOccluderTriangles;
+        Statistics m_statistics;
+    };
+}
+
+#endif // OCCLUSION_CULLER_H
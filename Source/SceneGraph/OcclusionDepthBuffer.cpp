@@ -0,0 +1,314 @@
+﻿#include "OcclusionDepthBuffer.h"
+#include "MathLib/Vector4.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cassert>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define OCCLUSION_RASTER_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define OCCLUSION_RASTER_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace Enigma::SceneGraph;
+using namespace Enigma::MathLib;
+
+static constexpr float MIN_CLIP_W = 1.0e-5f;
+static constexpr float MIN_TRIANGLE_AREA = 1.0e-6f;
+
+OcclusionDepthBuffer::OcclusionDepthBuffer(unsigned width, unsigned height)
+{
+    m_width = std::max(4u, (width + 3u) & ~3u);
+    m_height = std::max(1u, height);
+    m_mxViewProj = Matrix4::IDENTITY;
+    m_pyramid.emplace_back(PyramidLevel{ m_width, m_height, std::vector<float>(static_cast<size_t>(m_width) * m_height, FAR_DEPTH) });
+}
+
+OcclusionDepthBuffer::~OcclusionDepthBuffer()
+{
+    m_triangles.clear();
+    m_pyramid.clear();
+}
+
+void OcclusionDepthBuffer::clear(const Matrix4& mx_view_proj)
+{
+    m_mxViewProj = mx_view_proj;
+    m_triangles.clear();
+    m_pyramid.resize(1);
+    std::fill(m_pyramid[0].m_depth.begin(), m_pyramid[0].m_depth.end(), FAR_DEPTH);
+}
+
+void OcclusionDepthBuffer::setupTriangles(const std::vector<Vector3>& world_triangles)
+{
+    if (world_triangles.empty()) return;
+    setupTriangles(&world_triangles[0], world_triangles.size());
+}
+
+void OcclusionDepthBuffer::setupTriangles(const Vector3* world_triangles, size_t vertex_count)
+{
+    assert(world_triangles);
+    m_triangles.reserve(m_triangles.size() + vertex_count / 3);
+    for (size_t i = 0; i + 2 < vertex_count; i += 3)
+    {
+        std::array<Vector4, 3> clip_vertices;
+        unsigned outside_flags[6] = { 0, 0, 0, 0, 0, 0 };
+        for (unsigned v = 0; v < 3; v++)
+        {
+            clip_vertices[v] = m_mxViewProj * Vector4(world_triangles[i + v], 1.0f);
+            const Vector4& c = clip_vertices[v];
+            if (c.x() < -c.w()) outside_flags[0]++;
+            if (c.x() > c.w()) outside_flags[1]++;
+            if (c.y() < -c.w()) outside_flags[2]++;
+            if (c.y() > c.w()) outside_flags[3]++;
+            if (c.z() < 0.0f) outside_flags[4]++;
+            if (c.z() > c.w()) outside_flags[5]++;
+        }
+        // 全部頂點都在同一個 clip plane 外面, 不用畫
+        if (std::any_of(std::begin(outside_flags), std::end(outside_flags), [](unsigned n) { return n == 3; })) continue;
+
+        // near plane (z >= 0) clipping, 三角形最多被切成四邊形
+        std::array<Vector4, 4> clipped;
+        unsigned clipped_count = 0;
+        for (unsigned v = 0; v < 3; v++)
+        {
+            const Vector4& curr = clip_vertices[v];
+            const Vector4& next = clip_vertices[(v + 1) % 3];
+            const bool is_curr_inside = curr.z() >= 0.0f;
+            const bool is_next_inside = next.z() >= 0.0f;
+            if (is_curr_inside) clipped[clipped_count++] = curr;
+            if (is_curr_inside != is_next_inside)
+            {
+                const float t = curr.z() / (curr.z() - next.z());
+                clipped[clipped_count++] = curr + t * (next - curr);
+            }
+        }
+        if (clipped_count < 3) continue;
+        setupClippedPolygon(clipped, clipped_count);
+    }
+}
+
+void OcclusionDepthBuffer::setupClippedPolygon(const std::array<Vector4, 4>& clip_vertices, unsigned vertex_count)
+{
+    std::array<float, 4> sx;
+    std::array<float, 4> sy;
+    std::array<float, 4> sz;
+    for (unsigned v = 0; v < vertex_count; v++)
+    {
+        const float w = std::max(clip_vertices[v].w(), MIN_CLIP_W);
+        const float inv_w = 1.0f / w;
+        sx[v] = (clip_vertices[v].x() * inv_w * 0.5f + 0.5f) * static_cast<float>(m_width);
+        sy[v] = (0.5f - clip_vertices[v].y() * inv_w * 0.5f) * static_cast<float>(m_height);
+        sz[v] = std::clamp(clip_vertices[v].z() * inv_w, 0.0f, FAR_DEPTH);
+    }
+    for (unsigned v = 1; v + 1 < vertex_count; v++)
+    {
+        ScreenTriangle tri;
+        tri.m_x = { sx[0], sx[v], sx[v + 1] };
+        tri.m_y = { sy[0], sy[v], sy[v + 1] };
+        tri.m_z = { sz[0], sz[v], sz[v + 1] };
+        tri.m_minY = std::min({ tri.m_y[0], tri.m_y[1], tri.m_y[2] });
+        tri.m_maxY = std::max({ tri.m_y[0], tri.m_y[1], tri.m_y[2] });
+        m_triangles.emplace_back(tri);
+    }
+}
+
+void OcclusionDepthBuffer::rasterizeRows(unsigned row_begin, unsigned row_end)
+{
+    row_end = std::min(row_end, m_height);
+    if (row_begin >= row_end) return;
+    for (const auto& tri : m_triangles)
+    {
+        if (tri.m_maxY < static_cast<float>(row_begin) || tri.m_minY >= static_cast<float>(row_end)) continue;
+        rasterizeTriangle(tri, row_begin, row_end);
+    }
+}
+
+void OcclusionDepthBuffer::rasterizeTriangle(const ScreenTriangle& tri, unsigned row_begin, unsigned row_end)
+{
+    float x0 = tri.m_x[0], y0 = tri.m_y[0], z0 = tri.m_z[0];
+    float x1 = tri.m_x[1], y1 = tri.m_y[1], z1 = tri.m_z[1];
+    float x2 = tri.m_x[2], y2 = tri.m_y[2], z2 = tri.m_z[2];
+    float area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+    if (std::fabs(area) < MIN_TRIANGLE_AREA) return;
+    if (area < 0.0f)
+    {
+        // 不做 back face culling, 統一成正面的繞序
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+        std::swap(z1, z2);
+        area = -area;
+    }
+    const int min_x = std::max(0, static_cast<int>(std::floor(std::min({ x0, x1, x2 })))) & ~3;
+    const int max_x = std::min(static_cast<int>(m_width) - 1, static_cast<int>(std::ceil(std::max({ x0, x1, x2 }))));
+    const int min_y = std::max(static_cast<int>(row_begin), static_cast<int>(std::floor(tri.m_minY)));
+    const int max_y = std::min(static_cast<int>(row_end) - 1, static_cast<int>(std::ceil(tri.m_maxY)));
+    if ((min_x > max_x) || (min_y > max_y)) return;
+
+    // edge function : e(a, b, p) = (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)
+    // w0 = e(v1, v2, p), w1 = e(v2, v0, p), w2 = e(v0, v1, p), 三個都 >= 0 表示在三角形內
+    const float inv_area = 1.0f / area;
+    const float w0_dx = -(y2 - y1), w0_dy = x2 - x1;
+    const float w1_dx = -(y0 - y2), w1_dy = x0 - x2;
+    const float w2_dx = -(y1 - y0), w2_dy = x1 - x0;
+    const float z_dx = (w0_dx * z0 + w1_dx * z1 + w2_dx * z2) * inv_area;
+
+    const float start_px = static_cast<float>(min_x) + 0.5f;
+    const float start_py = static_cast<float>(min_y) + 0.5f;
+    float w0_row = w0_dy * (start_py - y1) + w0_dx * (start_px - x1);
+    float w1_row = w1_dy * (start_py - y2) + w1_dx * (start_px - x2);
+    float w2_row = w2_dy * (start_py - y0) + w2_dx * (start_px - x0);
+
+    std::vector<float>& depth = m_pyramid[0].m_depth;
+    for (int y = min_y; y <= max_y; y++)
+    {
+        float* row = &depth[static_cast<size_t>(y) * m_width];
+        float w0 = w0_row, w1 = w1_row, w2 = w2_row;
+        float z = (w0 * z0 + w1 * z1 + w2 * z2) * inv_area;
+        int x = min_x;
+#if defined(OCCLUSION_RASTER_SSE)
+        const __m128 offsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 w0_step = _mm_mul_ps(offsets, _mm_set1_ps(w0_dx));
+        const __m128 w1_step = _mm_mul_ps(offsets, _mm_set1_ps(w1_dx));
+        const __m128 w2_step = _mm_mul_ps(offsets, _mm_set1_ps(w2_dx));
+        const __m128 z_step = _mm_mul_ps(offsets, _mm_set1_ps(z_dx));
+        for (; x <= max_x; x += 4)
+        {
+            const __m128 e0 = _mm_add_ps(_mm_set1_ps(w0), w0_step);
+            const __m128 e1 = _mm_add_ps(_mm_set1_ps(w1), w1_step);
+            const __m128 e2 = _mm_add_ps(_mm_set1_ps(w2), w2_step);
+            const __m128 inside = _mm_cmpge_ps(_mm_min_ps(e0, _mm_min_ps(e1, e2)), zero);
+            if (_mm_movemask_ps(inside) != 0)
+            {
+                const __m128 pixel_z = _mm_add_ps(_mm_set1_ps(z), z_step);
+                const __m128 old_z = _mm_loadu_ps(row + x);
+                const __m128 new_z = _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(old_z, pixel_z)), _mm_andnot_ps(inside, old_z));
+                _mm_storeu_ps(row + x, new_z);
+            }
+            w0 += 4.0f * w0_dx;
+            w1 += 4.0f * w1_dx;
+            w2 += 4.0f * w2_dx;
+            z += 4.0f * z_dx;
+        }
+#elif defined(OCCLUSION_RASTER_NEON)
+        const float offset_values[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        const float32x4_t offsets = vld1q_f32(offset_values);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        const float32x4_t w0_step = vmulq_n_f32(offsets, w0_dx);
+        const float32x4_t w1_step = vmulq_n_f32(offsets, w1_dx);
+        const float32x4_t w2_step = vmulq_n_f32(offsets, w2_dx);
+        const float32x4_t z_step = vmulq_n_f32(offsets, z_dx);
+        for (; x <= max_x; x += 4)
+        {
+            const float32x4_t e0 = vaddq_f32(vdupq_n_f32(w0), w0_step);
+            const float32x4_t e1 = vaddq_f32(vdupq_n_f32(w1), w1_step);
+            const float32x4_t e2 = vaddq_f32(vdupq_n_f32(w2), w2_step);
+            const uint32x4_t inside = vcgeq_f32(vminq_f32(e0, vminq_f32(e1, e2)), zero);
+            const float32x4_t pixel_z = vaddq_f32(vdupq_n_f32(z), z_step);
+            const float32x4_t old_z = vld1q_f32(row + x);
+            vst1q_f32(row + x, vbslq_f32(inside, vminq_f32(old_z, pixel_z), old_z));
+            w0 += 4.0f * w0_dx;
+            w1 += 4.0f * w1_dx;
+            w2 += 4.0f * w2_dx;
+            z += 4.0f * z_dx;
+        }
+#else
+        for (; x <= max_x; x++)
+        {
+            if ((w0 >= 0.0f) && (w1 >= 0.0f) && (w2 >= 0.0f))
+            {
+                row[x] = std::min(row[x], z);
+            }
+            w0 += w0_dx;
+            w1 += w1_dx;
+            w2 += w2_dx;
+            z += z_dx;
+        }
+#endif
+        w0_row += w0_dy;
+        w1_row += w1_dy;
+        w2_row += w2_dy;
+    }
+}
+
+void OcclusionDepthBuffer::buildHiZPyramid()
+{
+    m_pyramid.resize(1);
+    while ((m_pyramid.back().m_width > 1) || (m_pyramid.back().m_height > 1))
+    {
+        const PyramidLevel& src = m_pyramid.back();
+        PyramidLevel dst;
+        dst.m_width = (src.m_width + 1) / 2;
+        dst.m_height = (src.m_height + 1) / 2;
+        dst.m_depth.resize(static_cast<size_t>(dst.m_width) * dst.m_height);
+        for (unsigned y = 0; y < dst.m_height; y++)
+        {
+            const unsigned sy0 = y * 2;
+            const unsigned sy1 = std::min(sy0 + 1, src.m_height - 1);
+            for (unsigned x = 0; x < dst.m_width; x++)
+            {
+                const unsigned sx0 = x * 2;
+                const unsigned sx1 = std::min(sx0 + 1, src.m_width - 1);
+                dst.m_depth[static_cast<size_t>(y) * dst.m_width + x] = std::max(
+                    std::max(src.m_depth[static_cast<size_t>(sy0) * src.m_width + sx0], src.m_depth[static_cast<size_t>(sy0) * src.m_width + sx1]),
+                    std::max(src.m_depth[static_cast<size_t>(sy1) * src.m_width + sx0], src.m_depth[static_cast<size_t>(sy1) * src.m_width + sx1]));
+            }
+        }
+        m_pyramid.emplace_back(std::move(dst));
+    }
+}
+
+bool OcclusionDepthBuffer::isOccluded(const std::array<Vector3, 8>& world_corners) const
+{
+    float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+    float min_z = FLT_MAX;
+    for (const auto& corner : world_corners)
+    {
+        const Vector4 c = m_mxViewProj * Vector4(corner, 1.0f);
+        // 跨過 near plane, 一定看得到
+        if ((c.z() < 0.0f) || (c.w() < MIN_CLIP_W)) return false;
+        const float inv_w = 1.0f / c.w();
+        const float sx = (c.x() * inv_w * 0.5f + 0.5f) * static_cast<float>(m_width);
+        const float sy = (0.5f - c.y() * inv_w * 0.5f) * static_cast<float>(m_height);
+        min_x = std::min(min_x, sx);
+        max_x = std::max(max_x, sx);
+        min_y = std::min(min_y, sy);
+        max_y = std::max(max_y, sy);
+        min_z = std::min(min_z, c.z() * inv_w);
+    }
+    // 畫面外的交給 frustum culling 判斷
+    if ((max_x < 0.0f) || (max_y < 0.0f) || (min_x >= static_cast<float>(m_width)) || (min_y >= static_cast<float>(m_height))) return false;
+
+    int x0 = std::max(0, static_cast<int>(std::floor(min_x)));
+    int y0 = std::max(0, static_cast<int>(std::floor(min_y)));
+    int x1 = std::min(static_cast<int>(m_width) - 1, static_cast<int>(std::floor(max_x)));
+    int y1 = std::min(static_cast<int>(m_height) - 1, static_cast<int>(std::floor(max_y)));
+    // 找到 rect 只涵蓋 2x2 texel 的 level
+    unsigned level = 0;
+    while (((x1 - x0) > 1 || (y1 - y0) > 1) && (level + 1 < m_pyramid.size()))
+    {
+        x0 >>= 1; y0 >>= 1; x1 >>= 1; y1 >>= 1;
+        level++;
+    }
+    const PyramidLevel& lv = m_pyramid[level];
+    float max_depth = 0.0f;
+    for (int y = y0; y <= y1; y++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            max_depth = std::max(max_depth, lv.m_depth[static_cast<size_t>(y) * lv.m_width + x]);
+        }
+    }
+    return min_z > max_depth;
+}
+
+float OcclusionDepthBuffer::depthAt(unsigned level, unsigned x, unsigned y) const
+{
+    if (level >= m_pyramid.size()) return FAR_DEPTH;
+    const PyramidLevel& lv = m_pyramid[level];
+    if ((x >= lv.m_width) || (y >= lv.m_height)) return FAR_DEPTH;
+    return lv.m_depth[static_cast<size_t>(y) * lv.m_width + x];
+}
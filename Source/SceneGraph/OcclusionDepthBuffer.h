@@ -0,0 +1,85 @@
+﻿/*********************************************************************
+ * \file   OcclusionDepthBuffer.h
+ * \brief  low resolution software depth buffer & hierarchical-z pyramid,
+ *          for cpu occlusion culling
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef OCCLUSION_DEPTH_BUFFER_H
+#define OCCLUSION_DEPTH_BUFFER_H
+
+#include "MathLib/Matrix4.h"
+#include "MathLib/Vector3.h"
+#include <vector>
+#include <array>
+
+namespace Enigma::SceneGraph
+{
+    class OcclusionDepthBuffer
+    {
+    public:
+        /** depth 是 projection 後的 z/w, 0 ~ 1, 越小越近 */
+        static constexpr float FAR_DEPTH = 1.0f;
+
+        struct ScreenTriangle
+        {
+            std::array<float, 3> m_x;
+            std::array<float, 3> m_y;
+            std::array<float, 3> m_z;
+            float m_minY;
+            float m_maxY;
+        };
+
+    public:
+        /** width 會補齊成 4 的倍數 (simd 一次處理 4 pixels) */
+        OcclusionDepthBuffer(unsigned width, unsigned height);
+        OcclusionDepthBuffer(const OcclusionDepthBuffer&) = delete;
+        OcclusionDepthBuffer(OcclusionDepthBuffer&&) = delete;
+        ~OcclusionDepthBuffer();
+        OcclusionDepthBuffer& operator=(const OcclusionDepthBuffer&) = delete;
+        OcclusionDepthBuffer& operator=(OcclusionDepthBuffer&&) = delete;
+
+        unsigned width() const { return m_width; }
+        unsigned height() const { return m_height; }
+
+        /** clear depth & triangle list, set view-projection transform of this frame */
+        void clear(const MathLib::Matrix4& mx_view_proj);
+
+        /** transform world triangles (3 vertices per triangle) to screen space, clipped by near plane */
+        void setupTriangles(const std::vector<MathLib::Vector3>& world_triangles);
+        void setupTriangles(const MathLib::Vector3* world_triangles, size_t vertex_count);
+        size_t triangleCount() const { return m_triangles.size(); }
+
+        /** rasterize all triangles into rows [row_begin, row_end), disjoint row ranges can run concurrently */
+        void rasterizeRows(unsigned row_begin, unsigned row_end);
+        /** build max-depth pyramid from rasterized depth */
+        void buildHiZPyramid();
+
+        /** test bounding corners (world space) against pyramid, call after buildHiZPyramid */
+        bool isOccluded(const std::array<MathLib::Vector3, 8>& world_corners) const;
+
+        unsigned pyramidLevelCount() const { return static_cast<unsigned>(m_pyramid.size()); }
+        float depthAt(unsigned level, unsigned x, unsigned y) const;
+
+    protected:
+        struct PyramidLevel
+        {
+            unsigned m_width;
+            unsigned m_height;
+            std::vector<float> m_depth;
+        };
+        void setupClippedPolygon(const std::array<MathLib::Vector4, 4>& clip_vertices, unsigned vertex_count);
+        void rasterizeTriangle(const ScreenTriangle& tri, unsigned row_begin, unsigned row_end);
+
+    protected:
+        unsigned m_width;
+        unsigned m_height;
+        MathLib::Matrix4 m_mxViewProj;
+        std::vector<ScreenTriangle> m_triangles;
+        /// level 0 是原始 depth buffer, 之後每層存 2x2 的最大 depth
+        std::vector<PyramidLevel> m_pyramid;
+    };
+}
+
+#endif // OCCLUSION_DEPTH_BUFFER_H
@@ -1,5 +1,6 @@
 ﻿#include "OutRegionNode.h"
 #include "OutRegionNodeAssembler.h"
+#include "Culler.h"
 #include "SceneGraphCommands.h"
 #include "SceneGraphErrors.h"
 
@@ -9,7 +10,6 @@ DEFINE_RTTI(SceneGraph, OutRegionNode, LazyNode);
 
 OutRegionNode::OutRegionNode(const SpatialId& id) : LazyNode(id)
 {
-    m_hasTraversed = false;
 }
 
 OutRegionNode::~OutRegionNode()
@@ -85,14 +85,12 @@ error OutRegionNode::onCullingVisible(Culler* culler, bool noCull)
     }
     error er = ErrorCode::ok;
 
-    if (!m_hasTraversed)
+    if (culler->beginTraversal(this))
     {
-        m_hasTraversed = true;
-
         // Add the zone walls and contained objects.
         er = Node::onCullingVisible(culler, noCull);
 
-        m_hasTraversed = false;
+        culler->endTraversal(this);
     }
     return er;
 }
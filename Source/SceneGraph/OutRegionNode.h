@@ -40,7 +40,6 @@ namespace Enigma::SceneGraph
 
     protected:
         std::optional<SpatialId> m_ownerManagementId;
-        bool m_hasTraversed;
     };
 }
 
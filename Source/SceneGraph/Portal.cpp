@@ -86,15 +86,11 @@ void Portal::adjacentZone(const std::shared_ptr<PortalZoneNode>& zone)
     std::make_shared<PortalZoneAttached>(m_id, m_adjacentZoneId)->enqueue();
 }
 
-std::shared_ptr<PortalZoneNode> Portal::adjacentZone()
+void Portal::resolveAdjacentZone()
 {
-    if (m_adjacentZoneId.empty()) return nullptr;
-    if (!m_adjacentPortalZone)
-    {
-        auto zone = std::dynamic_pointer_cast<PortalZoneNode>(Node::queryNode(m_adjacentZoneId));
-        if (zone) adjacentZone(zone);
-    }
-    return m_adjacentPortalZone;
+    if ((m_adjacentZoneId.empty()) || (m_adjacentPortalZone)) return;
+    auto zone = std::dynamic_pointer_cast<PortalZoneNode>(Node::queryNode(m_adjacentZoneId));
+    if (zone) adjacentZone(zone);
 }
 
 error Portal::onCullingVisible(Culler* culler, bool noCull)
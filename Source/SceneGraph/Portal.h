@@ -39,7 +39,10 @@ namespace Enigma::SceneGraph
         virtual void disassemble(const std::shared_ptr<SpatialDisassembler>& disassembler) override;
 
         void adjacentZone(const std::shared_ptr<PortalZoneNode>& zone);
-        std::shared_ptr<PortalZoneNode> adjacentZone();
+        /** culling 可能在 worker threads 上, 這裡只讀, 不做查詢 */
+        std::shared_ptr<PortalZoneNode> adjacentZone() const { return m_adjacentPortalZone; }
+        /** zone 比 portal 早建立時, 用 id 查詢並連上; 要在 main thread 上呼叫 */
+        void resolveAdjacentZone();
 
         /// Portal Open & Close, Closed Portal 就像關起來的門
         bool isOpen() const { return m_isOpen; };
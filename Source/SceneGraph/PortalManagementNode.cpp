@@ -85,11 +85,11 @@ error PortalManagementNode::onCullingVisible(Culler* culler, bool noCull)
         culler->Insert(thisSpatial());
         std::shared_ptr<PortalZoneNode> startZone;
         Vector3 camPos = culler->GetCamera()->location();
-        if ((m_cachedStartZone.lock()) && (m_cachedStartZone.lock()->getWorldBound().PointInside(camPos)))
         {
+            std::lock_guard locker{ m_cachedStartZoneLock };
             startZone = m_cachedStartZone.lock();
         }
-        else
+        if ((!startZone) || (!startZone->getWorldBound().PointInside(camPos)))
         {
             ContainingPortalZoneFinder zone_finder(camPos);
             //CSceneTraveler::TravelResult result=region_finder.travelTo(this);
@@ -97,7 +97,11 @@ error PortalManagementNode::onCullingVisible(Culler* culler, bool noCull)
             if (result == SceneTraveler::TravelResult::InterruptError) return ErrorCode::ok;
 
             startZone = zone_finder.GetContainingZone();
-            if (startZone) m_cachedStartZone = startZone;
+            if (startZone)
+            {
+                std::lock_guard locker{ m_cachedStartZoneLock };
+                m_cachedStartZone = startZone;
+            }
         }
         if (startZone)
         {
@@ -106,13 +110,19 @@ error PortalManagementNode::onCullingVisible(Culler* culler, bool noCull)
         }
         else if (auto out_region = outsideRegion())
         {
-            m_cachedStartZone.reset();
+            {
+                std::lock_guard locker{ m_cachedStartZoneLock };
+                m_cachedStartZone.reset();
+            }
             er = out_region->cullVisibleSet(culler, noCull);
             if (er) return er;
         }
         else
         {  // no start zone, so cull the whole scene
-            m_cachedStartZone.reset();
+            {
+                std::lock_guard locker{ m_cachedStartZoneLock };
+                m_cachedStartZone.reset();
+            }
             er = Node::onCullingVisible(culler, noCull);
         }
     }
@@ -145,15 +155,11 @@ void PortalManagementNode::attachOutsideRegion(const Frameworks::ICommandPtr& c)
     attachOutsideRegion(cmd->getRegion());
 }
 
-std::shared_ptr<OutRegionNode> PortalManagementNode::outsideRegion()
+void PortalManagementNode::resolveOutsideRegion()
 {
-    if (m_outsideRegionId.empty()) return nullptr;
-    if (!m_outsideRegion)
-    {
-        auto outside_region = std::dynamic_pointer_cast<OutRegionNode>(Node::queryNode(m_outsideRegionId));
-        if (outside_region) attachOutsideRegion(outside_region);
-    }
-    return m_outsideRegion;
+    if ((m_outsideRegionId.empty()) || (m_outsideRegion)) return;
+    auto outside_region = std::dynamic_pointer_cast<OutRegionNode>(Node::queryNode(m_outsideRegionId));
+    if (outside_region) attachOutsideRegion(outside_region);
 }
 
 void PortalManagementNode::subscribeOutRegionAttachment()
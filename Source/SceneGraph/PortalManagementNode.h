@@ -14,6 +14,7 @@
 
 #include "Node.h"
 #include "Frameworks/CommandSubscriber.h"
+#include <mutex>
 
 namespace Enigma::SceneGraph
 {
@@ -39,6 +40,8 @@ namespace Enigma::SceneGraph
         virtual void disassemble(const std::shared_ptr<SpatialDisassembler>& disassembler) override;
 
         void attachOutsideRegion(const std::shared_ptr<OutRegionNode>& node);
+        /** outside region 比 management node 早建立時, 用 id 查詢並連上; 要在 main thread 上呼叫 */
+        void resolveOutsideRegion();
 
         /** on cull visible, used by culler, for compute visible set, find start zone, then go to portal culling procedure  */
         virtual error onCullingVisible(Culler* culler, bool noCull) override;
@@ -46,7 +49,8 @@ namespace Enigma::SceneGraph
 
     protected:
         void attachOutsideRegion(const Frameworks::ICommandPtr& c);
-        std::shared_ptr<OutRegionNode> outsideRegion();
+        /** culling 可能在 worker threads 上, 這裡只讀, 不做查詢 */
+        std::shared_ptr<OutRegionNode> outsideRegion() const { return m_outsideRegion; }
         void subscribeOutRegionAttachment();
         void unsubscribeOutRegionAttachment();
 
@@ -54,6 +58,7 @@ namespace Enigma::SceneGraph
         SpatialId m_outsideRegionId;
         std::shared_ptr<OutRegionNode> m_outsideRegion;
         std::weak_ptr<PortalZoneNode> m_cachedStartZone;
+        std::mutex m_cachedStartZoneLock;  ///< cullers of different cameras may run concurrently
 
         Frameworks::CommandSubscriberPtr m_attachOutsideRegion;
     };
@@ -22,6 +22,7 @@ error PortalSceneGraph::createRoot(const SpatialId& scene_root_id)
     assert(!scene_root_id.empty());
     m_root = std::dynamic_pointer_cast<PortalManagementNode>(Node::queryNode(scene_root_id));
     if (!m_root) return ErrorCode::sceneRepositoryFailed;
+    m_root->resolveOutsideRegion();
     m_root->setLocalTransform(Matrix4::IDENTITY);
     return ErrorCode::ok;
 }
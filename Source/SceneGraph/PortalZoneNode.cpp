@@ -1,6 +1,7 @@
 ﻿#include "PortalZoneNode.h"
 #include "PortalZoneNodeAssembler.h"
 #include "Portal.h"
+#include "Culler.h"
 #include "PortalManagementNode.h"
 #include "SceneGraphCommands.h"
 #include "Frameworks/CommandBus.h"
@@ -15,7 +16,6 @@ DEFINE_RTTI(SceneGraph, PortalZoneNode, LazyNode);
 
 PortalZoneNode::PortalZoneNode(const SpatialId& id) : LazyNode(id)
 {
-    m_hasTraversed = false;
 }
 
 PortalZoneNode::~PortalZoneNode()
@@ -91,14 +91,12 @@ error PortalZoneNode::onCullingVisible(Culler* culler, bool noCull)
     }
     error er = ErrorCode::ok;
 
-    if (!m_hasTraversed)
+    if (culler->beginTraversal(this))
     {
-        m_hasTraversed = true;
-
         // Add the zone walls and contained objects.
         er = Node::onCullingVisible(culler, noCull);
 
-        m_hasTraversed = false;
+        culler->endTraversal(this);
     }
     return er;
 }
@@ -42,7 +42,6 @@ namespace Enigma::SceneGraph
 
     protected:
         std::optional<SpatialId> m_portalParentId; // either portal or portal management node
-        bool m_hasTraversed;
     };
 }
 
@@ -0,0 +1,486 @@
+﻿#include "SceneBroadphase.h"
+#include "Spatial.h"
+#include "Pawn.h"
+#include "EnumDerivedSpatials.h"
+#include "SceneGraphEvents.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "MathLib/IntrBox3Box3.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace Enigma::SceneGraph;
+using namespace Enigma::Frameworks;
+using namespace Enigma::MathLib;
+
+static constexpr size_t MIN_BATCH_RAYS = 64;
+
+static std::array<float, 3> arrayOf(const Vector3& v)
+{
+    return { v.x(), v.y(), v.z() };
+}
+
+SceneBroadphase::SceneBroadphase(float fat_margin, const std::shared_ptr<Frameworks::WorkerThreadPool>& workers)
+    : m_workers(workers), m_tree(fat_margin), m_refitCount(0), m_reinsertCount(0)
+{
+    registerHandlers();
+}
+
+SceneBroadphase::~SceneBroadphase()
+{
+    unregisterHandlers();
+    clear();
+}
+
+void SceneBroadphase::registerHandlers()
+{
+    m_onNodeChildAttached = std::make_shared<EventSubscriber>([=](auto e) { onNodeChildAttached(e); });
+    EventPublisher::subscribe(typeid(NodeChildAttached), m_onNodeChildAttached);
+    m_onNodeChildDetached = std::make_shared<EventSubscriber>([=](auto e) { onNodeChildDetached(e); });
+    EventPublisher::subscribe(typeid(NodeChildDetached), m_onNodeChildDetached);
+    m_onSpatialBoundChanged = std::make_shared<EventSubscriber>([=](auto e) { onSpatialBoundChanged(e); });
+    EventPublisher::subscribe(typeid(SpatialBoundChanged), m_onSpatialBoundChanged);
+    m_onSpatialRemoved = std::make_shared<EventSubscriber>([=](auto e) { onSpatialRemoved(e); });
+    EventPublisher::subscribe(typeid(SpatialRemoved), m_onSpatialRemoved);
+}
+
+void SceneBroadphase::unregisterHandlers()
+{
+    EventPublisher::unsubscribe(typeid(NodeChildAttached), m_onNodeChildAttached);
+    m_onNodeChildAttached = nullptr;
+    EventPublisher::unsubscribe(typeid(NodeChildDetached), m_onNodeChildDetached);
+    m_onNodeChildDetached = nullptr;
+    EventPublisher::unsubscribe(typeid(SpatialBoundChanged), m_onSpatialBoundChanged);
+    m_onSpatialBoundChanged = nullptr;
+    EventPublisher::unsubscribe(typeid(SpatialRemoved), m_onSpatialRemoved);
+    m_onSpatialRemoved = nullptr;
+}
+
+std::optional<DynamicBoundTree::Aabb> SceneBroadphase::aabbOfBound(const Engine::BoundingVolume& bound)
+{
+    if (bound.isEmpty()) return std::nullopt;
+    if (auto box = bound.BoundingBox3())
+    {
+        DynamicBoundTree::Aabb aabb;
+        for (unsigned k = 0; k < 3; k++)
+        {
+            // oriented box 投影到軸上的半徑
+            const float radius = std::fabs(box->Axis(0)[k]) * box->Extent(0) + std::fabs(box->Axis(1)[k]) * box->Extent(1)
+                + std::fabs(box->Axis(2)[k]) * box->Extent(2);
+            aabb.m_min[k] = box->Center()[k] - radius;
+            aabb.m_max[k] = box->Center()[k] + radius;
+        }
+        return aabb;
+    }
+    if (auto sphere = bound.BoundingSphere3())
+    {
+        DynamicBoundTree::Aabb aabb;
+        for (unsigned k = 0; k < 3; k++)
+        {
+            aabb.m_min[k] = sphere->Center()[k] - sphere->Radius();
+            aabb.m_max[k] = sphere->Center()[k] + sphere->Radius();
+        }
+        return aabb;
+    }
+    return std::nullopt;
+}
+
+void SceneBroadphase::bindSceneRoot(const std::shared_ptr<Spatial>& root)
+{
+    if (!root) return;
+    m_sceneRootId = root->id();
+    insertSpatial(root);
+}
+
+void SceneBroadphase::insertSpatial(const std::shared_ptr<Spatial>& spatial)
+{
+    if (!spatial) return;
+    EnumDerivedSpatials enumerator(Pawn::TYPE_RTTI);
+    spatial->visitBy(&enumerator);
+    std::unique_lock locker{ m_lock };
+    for (const auto& pawn : enumerator.GetSpatials())
+    {
+        insertPawn(pawn);
+    }
+}
+
+void SceneBroadphase::removeSpatial(const SpatialId& id)
+{
+    std::vector<SpatialId> removing_ids{ id };
+    if (!id.rtti().isDerived(Pawn::TYPE_RTTI))
+    {
+        if (auto spatial = Spatial::querySpatial(id))
+        {
+            EnumDerivedSpatials enumerator(Pawn::TYPE_RTTI);
+            spatial->visitBy(&enumerator);
+            for (const auto& pawn : enumerator.GetSpatials())
+            {
+                removing_ids.emplace_back(pawn->id());
+            }
+        }
+    }
+    std::unique_lock locker{ m_lock };
+    m_nodeWorldTransforms.erase(id);
+    for (const auto& removing_id : removing_ids)
+    {
+        removeProxy(removing_id);
+    }
+}
+
+void SceneBroadphase::refitSpatial(const SpatialId& id)
+{
+    if (id.rtti().isDerived(Pawn::TYPE_RTTI))
+    {
+        {
+            std::shared_lock locker{ m_lock };
+            if (m_slotsById.find(id) == m_slotsById.end()) return;
+        }
+        auto pawn = Spatial::querySpatial(id);
+        if (!pawn) return;
+        const Engine::BoundingVolume world_bound = pawn->getWorldBound();
+        std::unique_lock locker{ m_lock };
+        refitProxy(id, world_bound);
+        return;
+    }
+    // node 移動時只有 node 本身與其上層發 SpatialBoundChanged, 底下 pawn 的 world bound 要在這裡跟著 refit;
+    // pawn 移動時上層每個 node 也會發, 這些 node 的 world transform 沒變, 不需要走訪
+    auto spatial = Spatial::querySpatial(id);
+    if (!spatial) return;
+    const Matrix4 mx_world = spatial->getWorldTransform();
+    {
+        std::unique_lock locker{ m_lock };
+        auto [it, is_new] = m_nodeWorldTransforms.try_emplace(id, mx_world);
+        if ((!is_new) && (it->second == mx_world)) return;
+        it->second = mx_world;
+    }
+    EnumDerivedSpatials enumerator(Pawn::TYPE_RTTI);
+    spatial->visitBy(&enumerator);
+    std::vector<std::pair<SpatialId, Engine::BoundingVolume>> pawn_bounds;
+    pawn_bounds.reserve(enumerator.GetSpatials().size());
+    for (const auto& pawn : enumerator.GetSpatials())
+    {
+        pawn_bounds.emplace_back(pawn->id(), pawn->getWorldBound());
+    }
+    std::unique_lock locker{ m_lock };
+    for (const auto& [pawn_id, world_bound] : pawn_bounds)
+    {
+        refitProxy(pawn_id, world_bound);
+    }
+}
+
+void SceneBroadphase::clear()
+{
+    std::unique_lock locker{ m_lock };
+    m_tree.clear();
+    m_proxies.clear();
+    m_freeSlots.clear();
+    m_slotsById.clear();
+    m_nodeWorldTransforms.clear();
+}
+
+bool SceneBroadphase::contains(const SpatialId& id) const
+{
+    std::shared_lock locker{ m_lock };
+    auto it = m_slotsById.find(id);
+    if (it == m_slotsById.end()) return false;
+    return m_proxies[it->second].m_treeProxy != DynamicBoundTree::NULL_NODE;
+}
+
+SceneBroadphase::Statistics SceneBroadphase::statistics() const
+{
+    std::shared_lock locker{ m_lock };
+    Statistics stat;
+    stat.m_proxyCount = m_tree.proxyCount();
+    stat.m_treeHeight = static_cast<unsigned>(m_tree.height());
+    stat.m_refitCount = m_refitCount;
+    stat.m_reinsertCount = m_reinsertCount;
+    return stat;
+}
+
+void SceneBroadphase::insertPawn(const std::shared_ptr<Spatial>& pawn)
+{
+    assert(pawn);
+    if (m_slotsById.find(pawn->id()) != m_slotsById.end())
+    {
+        refitProxy(pawn->id(), pawn->getWorldBound());
+        return;
+    }
+    unsigned slot;
+    if (m_freeSlots.empty())
+    {
+        slot = static_cast<unsigned>(m_proxies.size());
+        m_proxies.emplace_back();
+    }
+    else
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    m_proxies[slot].m_id = pawn->id();
+    m_proxies[slot].m_treeProxy = DynamicBoundTree::NULL_NODE;
+    if (auto aabb = aabbOfBound(pawn->getWorldBound()))
+    {
+        m_proxies[slot].m_bound = aabb.value();
+        m_proxies[slot].m_treeProxy = m_tree.createProxy(aabb.value(), slot);
+    }
+    m_slotsById.emplace(pawn->id(), slot);
+}
+
+void SceneBroadphase::removeProxy(const SpatialId& id)
+{
+    auto it = m_slotsById.find(id);
+    if (it == m_slotsById.end()) return;
+    const unsigned slot = it->second;
+    if (m_proxies[slot].m_treeProxy != DynamicBoundTree::NULL_NODE) m_tree.destroyProxy(m_proxies[slot].m_treeProxy);
+    m_proxies[slot].m_treeProxy = DynamicBoundTree::NULL_NODE;
+    m_proxies[slot].m_id = SpatialId();
+    m_freeSlots.emplace_back(slot);
+    m_slotsById.erase(it);
+}
+
+void SceneBroadphase::refitProxy(const SpatialId& id, const Engine::BoundingVolume& world_bound)
+{
+    auto it = m_slotsById.find(id);
+    if (it == m_slotsById.end()) return;
+    Proxy& proxy = m_proxies[it->second];
+    auto aabb = aabbOfBound(world_bound);
+    if (!aabb)
+    {
+        // 仍然追蹤, bound 不是空的時候再放回 tree
+        if (proxy.m_treeProxy != DynamicBoundTree::NULL_NODE) m_tree.destroyProxy(proxy.m_treeProxy);
+        proxy.m_treeProxy = DynamicBoundTree::NULL_NODE;
+        return;
+    }
+    proxy.m_bound = aabb.value();
+    m_refitCount++;
+    if (proxy.m_treeProxy == DynamicBoundTree::NULL_NODE)
+    {
+        proxy.m_treeProxy = m_tree.createProxy(aabb.value(), it->second);
+        return;
+    }
+    if (m_tree.moveProxy(proxy.m_treeProxy, aabb.value())) m_reinsertCount++;
+}
+
+std::vector<SceneBroadphase::RayHit> SceneBroadphase::queryRay(const MathLib::Ray3& ray, float max_t) const
+{
+    std::vector<RayHit> hits;
+    const std::array<float, 3> origin = arrayOf(ray.origin());
+    const std::array<float, 3> direction = arrayOf(ray.direction());
+    const std::array<float, 3> inv_direction = { 1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2] };
+    std::shared_lock locker{ m_lock };
+    m_tree.queryRay(origin, direction, max_t, [&](int tree_proxy, float)
+        {
+            const Proxy& proxy = m_proxies[m_tree.userData(tree_proxy)];
+            float t_enter;
+            if (DynamicBoundTree::intersectRay(proxy.m_bound, origin, inv_direction, max_t, t_enter)) hits.push_back({ proxy.m_id, t_enter });
+            return max_t;
+        });
+    std::sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b) { return a.m_t < b.m_t; });
+    return hits;
+}
+
+std::optional<SceneBroadphase::RayHit> SceneBroadphase::raycastNearest(const MathLib::Ray3& ray, float max_t, const NarrowPhase& narrow_phase) const
+{
+    std::shared_lock locker{ m_lock };
+    return raycastNearestLocked(ray, max_t, narrow_phase);
+}
+
+bool SceneBroadphase::testRay(const MathLib::Ray3& ray, float max_t, const NarrowPhase& narrow_phase) const
+{
+    std::shared_lock locker{ m_lock };
+    return testRayLocked(ray, max_t, narrow_phase);
+}
+
+std::optional<SceneBroadphase::RayHit> SceneBroadphase::raycastNearestLocked(const MathLib::Ray3& ray, float max_t, const NarrowPhase& narrow_phase) const
+{
+    std::optional<RayHit> nearest;
+    const std::array<float, 3> origin = arrayOf(ray.origin());
+    const std::array<float, 3> direction = arrayOf(ray.direction());
+    const std::array<float, 3> inv_direction = { 1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2] };
+    m_tree.queryRay(origin, direction, max_t, [&](int tree_proxy, float)
+        {
+            const Proxy& proxy = m_proxies[m_tree.userData(tree_proxy)];
+            float t_enter;
+            if (!DynamicBoundTree::intersectRay(proxy.m_bound, origin, inv_direction, max_t, t_enter)) return max_t;
+            std::optional<float> t = t_enter;
+            if (narrow_phase) t = narrow_phase(proxy.m_id, t_enter);
+            if ((!t) || (t.value() < 0.0f) || (t.value() > max_t)) return max_t;
+            nearest = RayHit{ proxy.m_id, t.value() };
+            max_t = t.value();
+            return max_t;
+        });
+    return nearest;
+}
+
+bool SceneBroadphase::testRayLocked(const MathLib::Ray3& ray, float max_t, const NarrowPhase& narrow_phase) const
+{
+    bool is_hit = false;
+    const std::array<float, 3> origin = arrayOf(ray.origin());
+    const std::array<float, 3> direction = arrayOf(ray.direction());
+    const std::array<float, 3> inv_direction = { 1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2] };
+    m_tree.queryRay(origin, direction, max_t, [&](int tree_proxy, float)
+        {
+            const Proxy& proxy = m_proxies[m_tree.userData(tree_proxy)];
+            float t_enter;
+            if (!DynamicBoundTree::intersectRay(proxy.m_bound, origin, inv_direction, max_t, t_enter)) return max_t;
+            if (narrow_phase)
+            {
+                auto t = narrow_phase(proxy.m_id, t_enter);
+                if ((!t) || (t.value() < 0.0f) || (t.value() > max_t)) return max_t;
+            }
+            is_hit = true;
+            return -1.0f;
+        });
+    return is_hit;
+}
+
+std::vector<SpatialId> SceneBroadphase::querySphere(const MathLib::Sphere3& sphere) const
+{
+    std::vector<SpatialId> ids;
+    const std::array<float, 3> center = arrayOf(sphere.Center());
+    const float radius = sphere.Radius();
+    DynamicBoundTree::Aabb query_bound;
+    for (unsigned k = 0; k < 3; k++)
+    {
+        query_bound.m_min[k] = center[k] - radius;
+        query_bound.m_max[k] = center[k] + radius;
+    }
+    std::shared_lock locker{ m_lock };
+    m_tree.queryOverlap(query_bound, [&](int tree_proxy)
+        {
+            const Proxy& proxy = m_proxies[m_tree.userData(tree_proxy)];
+            // 球心到 aabb 的最近距離
+            float distance_sq = 0.0f;
+            for (unsigned k = 0; k < 3; k++)
+            {
+                const float d = std::max(std::max(proxy.m_bound.m_min[k] - center[k], 0.0f), center[k] - proxy.m_bound.m_max[k]);
+                distance_sq += d * d;
+            }
+            if (distance_sq <= radius * radius) ids.emplace_back(proxy.m_id);
+            return true;
+        });
+    return ids;
+}
+
+std::vector<SpatialId> SceneBroadphase::queryBox(const MathLib::Box3& box) const
+{
+    std::vector<SpatialId> ids;
+    DynamicBoundTree::Aabb query_bound;
+    for (unsigned k = 0; k < 3; k++)
+    {
+        const float radius = std::fabs(box.Axis(0)[k]) * box.Extent(0) + std::fabs(box.Axis(1)[k]) * box.Extent(1)
+            + std::fabs(box.Axis(2)[k]) * box.Extent(2);
+        query_bound.m_min[k] = box.Center()[k] - radius;
+        query_bound.m_max[k] = box.Center()[k] + radius;
+    }
+    const bool is_axis_aligned = (std::fabs(box.Axis(0).x()) == 1.0f) && (std::fabs(box.Axis(1).y()) == 1.0f) && (std::fabs(box.Axis(2).z()) == 1.0f);
+    std::shared_lock locker{ m_lock };
+    m_tree.queryOverlap(query_bound, [&](int tree_proxy)
+        {
+            const Proxy& proxy = m_proxies[m_tree.userData(tree_proxy)];
+            if (!proxy.m_bound.overlaps(query_bound)) return true;
+            if (!is_axis_aligned)
+            {
+                // oriented box 再用分離軸測一次
+                const Box3 proxy_box(Vector3((proxy.m_bound.m_min[0] + proxy.m_bound.m_max[0]) * 0.5f, (proxy.m_bound.m_min[1] + proxy.m_bound.m_max[1]) * 0.5f, (proxy.m_bound.m_min[2] + proxy.m_bound.m_max[2]) * 0.5f),
+                    Vector3::UNIT_X, Vector3::UNIT_Y, Vector3::UNIT_Z,
+                    (proxy.m_bound.m_max[0] - proxy.m_bound.m_min[0]) * 0.5f, (proxy.m_bound.m_max[1] - proxy.m_bound.m_min[1]) * 0.5f, (proxy.m_bound.m_max[2] - proxy.m_bound.m_min[2]) * 0.5f);
+                IntrBox3Box3 intersector(box, proxy_box);
+                if (!intersector.test(nullptr).m_hasIntersect) return true;
+            }
+            ids.emplace_back(proxy.m_id);
+            return true;
+        });
+    return ids;
+}
+
+std::vector<std::optional<SceneBroadphase::RayHit>> SceneBroadphase::raycastNearest(const std::vector<MathLib::Ray3>& rays, float max_t, const NarrowPhase& narrow_phase) const
+{
+    std::vector<std::optional<RayHit>> hits(rays.size());
+    std::shared_lock locker{ m_lock };
+    auto cast_rays = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            hits[i] = raycastNearestLocked(rays[i], max_t, narrow_phase);
+        }
+    };
+    if (auto workers = m_workers.lock())
+    {
+        workers->parallelFor(rays.size(), cast_rays, MIN_BATCH_RAYS);
+    }
+    else
+    {
+        cast_rays(0, rays.size());
+    }
+    return hits;
+}
+
+std::vector<unsigned char> SceneBroadphase::testRays(const std::vector<MathLib::Ray3>& rays, float max_t, const NarrowPhase& narrow_phase) const
+{
+    std::vector<unsigned char> results(rays.size(), 0);
+    std::shared_lock locker{ m_lock };
+    auto test_rays = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            results[i] = testRayLocked(rays[i], max_t, narrow_phase) ? 1 : 0;
+        }
+    };
+    if (auto workers = m_workers.lock())
+    {
+        workers->parallelFor(rays.size(), test_rays, MIN_BATCH_RAYS);
+    }
+    else
+    {
+        test_rays(0, rays.size());
+    }
+    return results;
+}
+
+void SceneBroadphase::onNodeChildAttached(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<NodeChildAttached>(e);
+    if (!ev) return;
+    auto child = ev->child();
+    // 其他 scene graph (ex. 還在組裝的 prefab) 的 attach 不要加進來, 整個子樹 attach 到 root 時才加入
+    if ((!child) || (!isUnderSceneRoot(child))) return;
+    insertSpatial(child);
+}
+
+void SceneBroadphase::onNodeChildDetached(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<NodeChildDetached>(e);
+    if (!ev) return;
+    removeSpatial(ev->childId());
+}
+
+void SceneBroadphase::onSpatialBoundChanged(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<SpatialBoundChanged>(e);
+    if (!ev) return;
+    refitSpatial(ev->id());
+}
+
+bool SceneBroadphase::isUnderSceneRoot(const std::shared_ptr<Spatial>& spatial) const
+{
+    if (!m_sceneRootId) return true;
+    for (auto ancestor = spatial; ancestor; ancestor = ancestor->getParent())
+    {
+        if (ancestor->id() == m_sceneRootId.value()) return true;
+    }
+    return false;
+}
+
+void SceneBroadphase::onSpatialRemoved(const Frameworks::IEventPtr& e)
+{
+    if (!e) return;
+    auto ev = std::dynamic_pointer_cast<SpatialRemoved>(e);
+    if (!ev) return;
+    std::unique_lock locker{ m_lock };
+    m_nodeWorldTransforms.erase(ev->id());
+    removeProxy(ev->id());
+}
@@ -0,0 +1,143 @@
+﻿/*********************************************************************
+ * \file   SceneBroadphase.h
+ * \brief  dynamic broadphase over pawn world bounds, for picking,
+ *          line-of-sight and proximity queries
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef SCENE_BROADPHASE_H
+#define SCENE_BROADPHASE_H
+
+#include "DynamicBoundTree.h"
+#include "SpatialId.h"
+#include "Frameworks/EventSubscriber.h"
+#include "MathLib/Ray3.h"
+#include "MathLib/Box3.h"
+#include "MathLib/Sphere3.h"
+#include "MathLib/Matrix4.h"
+#include "GameEngine/BoundingVolume.h"
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <functional>
+#include <optional>
+
+namespace Enigma::Frameworks
+{
+    class WorkerThreadPool;
+}
+
+namespace Enigma::SceneGraph
+{
+    class Spatial;
+
+    /** 以 DynamicBoundTree 索引 pawn 的 world bound. pawn attach 到 scene graph 時加入,
+     detach 或從 repository 移除時拿掉, SpatialBoundChanged 時 refit.
+     world bound 是空的 pawn 仍會追蹤, 等 bound 不是空的時候再放進 tree.
+     查詢用 shared lock, 可以從多個執行緒同時查詢; 批次查詢用 worker pool 分段 */
+    class SceneBroadphase
+    {
+    public:
+        struct RayHit
+        {
+            SpatialId m_id;
+            /// narrow phase 的交點距離, 沒有 narrow phase 時是進入 world bound 的距離
+            float m_t;
+        };
+        /** narrow phase test (ex. IntrPrimitiveRay3), 回傳交點距離; t_enter 是射線進入 world bound 的距離 */
+        using NarrowPhase = std::function<std::optional<float>(const SpatialId& id, float t_enter)>;
+
+        struct Statistics
+        {
+            unsigned m_proxyCount = 0;
+            unsigned m_treeHeight = 0;
+            unsigned m_refitCount = 0;
+            unsigned m_reinsertCount = 0;
+        };
+
+    public:
+        SceneBroadphase(float fat_margin, const std::shared_ptr<Frameworks::WorkerThreadPool>& workers);
+        SceneBroadphase(const SceneBroadphase&) = delete;
+        SceneBroadphase(SceneBroadphase&&) = delete;
+        ~SceneBroadphase();
+        SceneBroadphase& operator=(const SceneBroadphase&) = delete;
+        SceneBroadphase& operator=(SceneBroadphase&&) = delete;
+
+        /** 加入 scene root 下所有 pawn, 之後 attach event 只接受 attach 到這個 root 子樹的 child;
+         沒有綁定 root 時, 任何 attach 都會加入 */
+        void bindSceneRoot(const std::shared_ptr<Spatial>& root);
+        /** 加入 spatial 及其下所有 pawn (已經在的只做 refit) */
+        void insertSpatial(const std::shared_ptr<Spatial>& spatial);
+        /** 移除 spatial 及其下所有 pawn */
+        void removeSpatial(const SpatialId& id);
+        /** node 的 world transform 改變時, refit 其下所有 pawn */
+        void refitSpatial(const SpatialId& id);
+        void clear();
+        /** pawn 是否在 tree 裡 (world bound 是空的不算) */
+        bool contains(const SpatialId& id) const;
+        Statistics statistics() const;
+
+        /** 所有 world bound 跟射線相交的 spatial, 依進入距離排序; direction 不需單位長度 */
+        std::vector<RayHit> queryRay(const MathLib::Ray3& ray, float max_t) const;
+        /** 最近的交點, 由近到遠呼叫 narrow phase, 找到交點後縮短射線 */
+        std::optional<RayHit> raycastNearest(const MathLib::Ray3& ray, float max_t, const NarrowPhase& narrow_phase) const;
+        /** line of sight, 任一交點即停止 */
+        bool testRay(const MathLib::Ray3& ray, float max_t, const NarrowPhase& narrow_phase) const;
+        std::vector<SpatialId> querySphere(const MathLib::Sphere3& sphere) const;
+        std::vector<SpatialId> queryBox(const MathLib::Box3& box) const;
+
+        /** batch queries from gameplay, 結果順序與 rays 相同 */
+        std::vector<std::optional<RayHit>> raycastNearest(const std::vector<MathLib::Ray3>& rays, float max_t, const NarrowPhase& narrow_phase) const;
+        std::vector<unsigned char> testRays(const std::vector<MathLib::Ray3>& rays, float max_t, const NarrowPhase& narrow_phase) const;
+
+        static std::optional<DynamicBoundTree::Aabb> aabbOfBound(const Engine::BoundingVolume& bound);
+
+    protected:
+        void registerHandlers();
+        void unregisterHandlers();
+
+        void onNodeChildAttached(const Frameworks::IEventPtr& e);
+        void onNodeChildDetached(const Frameworks::IEventPtr& e);
+        void onSpatialBoundChanged(const Frameworks::IEventPtr& e);
+        void onSpatialRemoved(const Frameworks::IEventPtr& e);
+        bool isUnderSceneRoot(const std::shared_ptr<Spatial>& spatial) const;
+
+        struct Proxy
+        {
+            SpatialId m_id;
+            DynamicBoundTree::Aabb m_bound;
+            /// world bound 是空的時候為 NULL_NODE
+            int m_treeProxy;
+        };
+        void insertPawn(const std::shared_ptr<Spatial>& pawn);
+        void removeProxy(const SpatialId& id);
+        void refitProxy(const SpatialId& id, const Engine::BoundingVolume& world_bound);
+
+        /** 以下需先取得 lock */
+        std::optional<RayHit> raycastNearestLocked(const MathLib::Ray3& ray, float max_t, const NarrowPhase& narrow_phase) const;
+        bool testRayLocked(const MathLib::Ray3& ray, float max_t, const NarrowPhase& narrow_phase) const;
+
+    protected:
+        std::weak_ptr<Frameworks::WorkerThreadPool> m_workers;
+        std::optional<SpatialId> m_sceneRootId;
+        DynamicBoundTree m_tree;
+        /// tree 的 user data 是 proxy slot index
+        std::vector<Proxy> m_proxies;
+        std::vector<unsigned> m_freeSlots;
+        std::unordered_map<SpatialId, unsigned, SpatialId::hash> m_slotsById;
+        /// 上次 refit 時 node 的 world transform
+        std::unordered_map<SpatialId, MathLib::Matrix4, SpatialId::hash> m_nodeWorldTransforms;
+        mutable std::shared_mutex m_lock;
+        unsigned m_refitCount;
+        unsigned m_reinsertCount;
+
+        Frameworks::EventSubscriberPtr m_onNodeChildAttached;
+        Frameworks::EventSubscriberPtr m_onNodeChildDetached;
+        Frameworks::EventSubscriberPtr m_onSpatialBoundChanged;
+        Frameworks::EventSubscriberPtr m_onSpatialRemoved;
+    };
+}
+
+#endif // SCENE_BROADPHASE_H
@@ -2,6 +2,8 @@
 #include "Camera.h"
 #include "Pawn.h"
 #include "Light.h"
+#include "Portal.h"
+#include "PortalManagementNode.h"
 #include "CameraFrustumCommands.h"
 #include "SceneGraphCommands.h"
 #include "CameraFrustumEvents.h"
@@ -212,4 +214,13 @@ void SceneGraphFactory::reattachOwnership(const std::shared_ptr<Spatial>& spatia
         error er = Ownership::attachOwnership(owner.value(), spatial);
         assert(!er);
     }
+    // zone / outside region 比 owner 早建立時, 不會經過它們的 ownership, 在這裡連上, culling 時就只需要讀取
+    if (auto portal = std::dynamic_pointer_cast<Portal>(spatial))
+    {
+        portal->resolveAdjacentZone();
+    }
+    else if (auto management_node = std::dynamic_pointer_cast<PortalManagementNode>(spatial))
+    {
+        management_node->resolveOutsideRegion();
+    }
 }
@@ -34,6 +34,7 @@ error SceneGraphInstallingPolicy::install(Frameworks::ServiceManager* service_ma
     scene_graph_repository->registerSpatialFactory(PortalZoneNode::TYPE_RTTI.getName(), PortalZoneNode::create);
     scene_graph_repository->registerSpatialFactory(OutRegionNode::TYPE_RTTI.getName(), OutRegionNode::create);
     scene_graph_repository->registerSpatialLightFactory(Light::TYPE_RTTI.getName(), Light::create);
+    if (auto cache = service_manager->assetRetentionCache()) scene_graph_repository->retentionCache(cache);
     service_manager->registerSystemService(scene_graph_repository);
     service_manager->registerSystemService(std::make_shared<LazyNodeHydrationService>(service_manager, scene_graph_repository, timer));
     service_manager->registerSystemService(std::make_shared<LightInfoTraversal>(service_manager));
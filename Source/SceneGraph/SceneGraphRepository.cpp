@@ -15,6 +15,7 @@
 #include "Frameworks/EventPublisher.h"
 #include "Frameworks/CommandBus.h"
 #include "Frameworks/QueryDispatcher.h"
+#include "Frameworks/AssetRetentionCache.h"
 #include "Platforms/PlatformLayerUtilities.h"
 #include "Platforms/MemoryMacro.h"
 #include "CameraFrustumCommands.h"
@@ -33,6 +34,10 @@ using namespace Enigma::Platforms;
 
 DEFINE_RTTI(SceneGraph, SceneGraphRepository, ISystemService);
 
+static const std::string RETENTION_CATEGORY = "spatial";
+/// spatial 的 primitive 由 primitive repository 計算, 這裡只算 spatial 本身的概略大小
+static constexpr size_t SPATIAL_RETENTION_BYTES = 512;
+
 SceneGraphRepository::SceneGraphRepository(Frameworks::ServiceManager* srv_mngr, const std::shared_ptr<SceneGraphStoreMapper>& store_mapper) : ISystemService(srv_mngr)
 {
     m_handSystem = GraphicCoordSys::LeftHand;
@@ -55,6 +60,7 @@ ServiceResult SceneGraphRepository::onInit()
 }
 ServiceResult SceneGraphRepository::onTerm()
 {
+    if (m_retentionCache) m_retentionCache->releaseCategory(RETENTION_CATEGORY);
     dumpRetainedCameras();
     dumpRetainedSpatials();
 
@@ -212,7 +218,15 @@ bool SceneGraphRepository::hasSpatial(const SpatialId& id)
 std::shared_ptr<Spatial> SceneGraphRepository::querySpatial(const SpatialId& id)
 {
     if (!hasSpatial(id)) return nullptr;
-    if (auto spatial = findCachedSpatial(id); spatial) return spatial;
+    if (auto spatial = findCachedSpatial(id); spatial)
+    {
+        if (m_retentionCache)
+        {
+            m_retentionCache->recordHit(RETENTION_CATEGORY);
+            retainSpatial(id, spatial);
+        }
+        return spatial;
+    }
     std::lock_guard locker{ m_spatialMapLock };
     auto dto = m_storeMapper->querySpatial(id);
     assert(dto.has_value());
@@ -227,6 +241,11 @@ std::shared_ptr<Spatial> SceneGraphRepository::querySpatial(const SpatialId& id)
     }
     assert(spatial);
     m_spatials.insert_or_assign(id, spatial);
+    if (m_retentionCache)
+    {
+        m_retentionCache->recordMiss(RETENTION_CATEGORY);
+        retainSpatial(id, spatial);
+    }
     return spatial;
 }
 
@@ -414,6 +433,7 @@ void SceneGraphRepository::removeSpatial(const SpatialId& id)
     if (const auto spatial = findCachedSpatial(id)) spatial->persistenceLevel(PersistenceLevel::None);
     std::lock_guard locker{ m_spatialMapLock };
     m_spatials.erase(id);
+    if (m_retentionCache) m_retentionCache->release(RETENTION_CATEGORY, id.name() + "#" + id.rtti().getName());
     auto er = m_storeMapper->removeSpatial(id);
     if (!er)
     {
@@ -635,6 +655,15 @@ std::shared_ptr<Spatial> SceneGraphRepository::findCachedSpatial(const SpatialId
     return nullptr;
 }
 
+void SceneGraphRepository::retainSpatial(const SpatialId& id, const std::shared_ptr<Spatial>& spatial)
+{
+    if ((!m_retentionCache) || (!spatial)) return;
+    // 同名不同型別的 spatial 是不同的 id
+    const std::string key = id.name() + "#" + id.rtti().getName();
+    if (m_retentionCache->touch(RETENTION_CATEGORY, key)) return;
+    m_retentionCache->retain(RETENTION_CATEGORY, key, spatial, SPATIAL_RETENTION_BYTES);
+}
+
 void SceneGraphRepository::dumpRetainedCameras()
 {
     Platforms::Debug::Printf("Dumping retained cameras\n");
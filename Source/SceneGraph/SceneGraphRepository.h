@@ -22,6 +22,11 @@
 #include <unordered_map>
 #include <mutex>
 
+namespace Enigma::Frameworks
+{
+    class AssetRetentionCache;
+}
+
 namespace Enigma::SceneGraph
 {
     class SceneGraphStoreMapper;
@@ -52,6 +57,9 @@ namespace Enigma::SceneGraph
         void registerSpatialFactory(const std::string& rtti, const SpatialCreator& creator);
         void registerSpatialLightFactory(const std::string& rtti, const LightCreator& creator);
 
+        /** optional, spatials loaded from store are retained in cache after all owners released */
+        void retentionCache(const std::shared_ptr<Frameworks::AssetRetentionCache>& cache) { m_retentionCache = cache; }
+
         /** query entities */
         bool hasCamera(const SpatialId& id);
         std::shared_ptr<Camera> queryCamera(const SpatialId& id);
@@ -102,6 +110,7 @@ namespace Enigma::SceneGraph
 
         std::shared_ptr<Camera> findCachedCamera(const SpatialId& id);
         std::shared_ptr<Spatial> findCachedSpatial(const SpatialId& id);
+        void retainSpatial(const SpatialId& id, const std::shared_ptr<Spatial>& spatial);
 
         void dumpRetainedCameras();
         void dumpRetainedSpatials();
@@ -118,6 +127,7 @@ namespace Enigma::SceneGraph
         //! ADR: 在 repository 中，map 是存放已生成 asset 的 cache, 不擁有asset, 所以改用 weak_ptr
         std::unordered_map<SpatialId, std::weak_ptr<Spatial>, SpatialId::hash> m_spatials;
         std::recursive_mutex m_spatialMapLock;
+        std::shared_ptr<Frameworks::AssetRetentionCache> m_retentionCache;
 
         Frameworks::QuerySubscriberPtr m_queryCamera;
         Frameworks::QuerySubscriberPtr m_requestCameraCreation;
@@ -50,6 +50,7 @@ namespace Enigma::SceneGraph
             //Spatial_BelongToParent = 0x01,  ///< parent負責刪除, ==> 沒什麼用處, 刪掉
             Spatial_Hide = 0x02,
             Spatial_Unlit = 0x04,  ///< 不受光的物件, 可以不用計算lighting render state
+            Spatial_Occluder = 0x08,  ///< 遮蔽物, world bound 內部視為實心, 用在 occlusion culling
             //Spatial_ShadowCaster = 0x10,  // move into shadow map module
             //Spatial_ShadowReceiver = 0x20, // move into shadow map module
             //Spatial_ReflectionPlane = 0x??,
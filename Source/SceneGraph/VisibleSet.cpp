@@ -36,3 +36,28 @@ void VisibleSet::Insert(const SpatialPtr& obj)
 {
     m_visibleObjSet.emplace_back(obj);
 }
+
+void VisibleSet::Merge(VisibleSet&& other)
+{
+    if (m_visibleObjSet.empty())
+    {
+        m_visibleObjSet = std::move(other.m_visibleObjSet);
+    }
+    else
+    {
+        m_visibleObjSet.insert(m_visibleObjSet.end(), std::make_move_iterator(other.m_visibleObjSet.begin()), std::make_move_iterator(other.m_visibleObjSet.end()));
+    }
+    other.m_visibleObjSet.clear();
+}
+
+void VisibleSet::removeIf(const std::function<bool(size_t index, const SpatialPtr& obj)>& predicate)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < m_visibleObjSet.size(); i++)
+    {
+        if (predicate(i, m_visibleObjSet[i])) continue;
+        if (kept != i) m_visibleObjSet[kept] = std::move(m_visibleObjSet[i]);
+        kept++;
+    }
+    m_visibleObjSet.resize(kept);
+}
@@ -10,6 +10,7 @@
 
 #include <vector>
 #include <memory>
+#include <functional>
 
 namespace Enigma::SceneGraph
 {
@@ -35,6 +36,10 @@ namespace Enigma::SceneGraph
         const SpatialVector& GetObjectSet() const;
 
         void Insert(const SpatialPtr& obj);
+        /** append other set's objects, used to merge subtree culling results */
+        void Merge(VisibleSet&& other);
+        /** remove objects matching predicate, keep the order of remaining objects */
+        void removeIf(const std::function<bool(size_t index, const SpatialPtr& obj)>& predicate);
         void clear();
 
     protected:
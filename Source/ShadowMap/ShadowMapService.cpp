@@ -29,6 +29,7 @@ ShadowMapService::ShadowMapService(ServiceManager* manager, const std::shared_pt
     : ISystemService(manager)
 {
     m_needTick = true;
+    declareReadAccess(GameCommon::GameSceneService::SCENE_CULLER_RESOURCE);
     m_configuration = configuration;
     m_sceneService = scene_service;
     m_cameraService = camera_service;
@@ -0,0 +1,318 @@
+﻿#include "TerrainChunkLayout.h"
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+using namespace Enigma::Terrain;
+using namespace Enigma::MathLib;
+
+TerrainChunkLayout::TerrainChunkLayout() : m_numRows(0), m_numCols(0), m_chunkCells(0), m_chunkCountX(0), m_chunkCountZ(0), m_lodCount(0),
+    m_cellWidth(1.0f), m_cellHeight(1.0f)
+{
+}
+
+TerrainChunkLayout::TerrainChunkLayout(unsigned num_rows, unsigned num_cols, unsigned chunk_cells) : TerrainChunkLayout()
+{
+    if (!isChunkable(num_rows, num_cols, chunk_cells)) return;
+    m_numRows = num_rows;
+    m_numCols = num_cols;
+    m_chunkCells = chunk_cells;
+    m_chunkCountX = num_cols / chunk_cells;
+    m_chunkCountZ = num_rows / chunk_cells;
+    // 最粗的 lod 還要有 2x2 quads 才能做 fan
+    while ((2u << m_lodCount) <= chunk_cells) m_lodCount++;
+    m_chunkLods.resize(chunkCount(), ChunkLod{ 0, 0 });
+}
+
+bool TerrainChunkLayout::isChunkable(unsigned num_rows, unsigned num_cols, unsigned chunk_cells)
+{
+    if ((chunk_cells < 2) || ((chunk_cells & (chunk_cells - 1)) != 0)) return false;
+    if ((num_rows == 0) || (num_cols == 0)) return false;
+    return (num_rows % chunk_cells == 0) && (num_cols % chunk_cells == 0);
+}
+
+uint_buffer TerrainChunkLayout::buildIndexPatterns()
+{
+    assert(isValid());
+    uint_buffer indices;
+    indices.reserve(patternIndexCount());
+    m_patterns.resize(static_cast<size_t>(m_lodCount) * STITCH_VARIANT_COUNT);
+    for (unsigned lod = 0; lod < m_lodCount; lod++)
+    {
+        const unsigned step = 1u << lod;
+        const unsigned block_count = m_chunkCells / (2 * step);
+        for (unsigned mask = 0; mask < STITCH_VARIANT_COUNT; mask++)
+        {
+            const unsigned start = static_cast<unsigned>(indices.size());
+            for (unsigned bz = 0; bz < block_count; bz++)
+            {
+                for (unsigned bx = 0; bx < block_count; bx++)
+                {
+                    // 只有在 chunk 邊上的 block 才需要拿掉邊的中點
+                    unsigned skip_mids = 0;
+                    if (bx == 0) skip_mids |= (mask & Stitch_MinX);
+                    if (bx == block_count - 1) skip_mids |= (mask & Stitch_MaxX);
+                    if (bz == 0) skip_mids |= (mask & Stitch_MinZ);
+                    if (bz == block_count - 1) skip_mids |= (mask & Stitch_MaxZ);
+                    appendBlockFan(indices, bx * 2 * step, bz * 2 * step, step, skip_mids);
+                }
+            }
+            m_patterns[lod * STITCH_VARIANT_COUNT + mask] = { start, static_cast<unsigned>(indices.size()) - start };
+        }
+    }
+    return indices;
+}
+
+void TerrainChunkLayout::calculatePatternRanges()
+{
+    assert(isValid());
+    m_patterns.resize(static_cast<size_t>(m_lodCount) * STITCH_VARIANT_COUNT);
+    unsigned start = 0;
+    for (unsigned lod = 0; lod < m_lodCount; lod++)
+    {
+        for (unsigned mask = 0; mask < STITCH_VARIANT_COUNT; mask++)
+        {
+            const unsigned count = patternIndexCount(lod, mask);
+            m_patterns[lod * STITCH_VARIANT_COUNT + mask] = { start, count };
+            start += count;
+        }
+    }
+}
+
+unsigned TerrainChunkLayout::patternIndexCount() const
+{
+    unsigned count = 0;
+    for (unsigned lod = 0; lod < m_lodCount; lod++)
+    {
+        for (unsigned mask = 0; mask < STITCH_VARIANT_COUNT; mask++)
+        {
+            count += patternIndexCount(lod, mask);
+        }
+    }
+    return count;
+}
+
+unsigned TerrainChunkLayout::patternIndexCount(unsigned lod, unsigned stitch_mask) const
+{
+    // 每個 block 8 個三角形, 每條要縫合的邊上, 每個 block 少一個三角形
+    const unsigned block_count = m_chunkCells >> (lod + 1);
+    unsigned stitched_edges = 0;
+    for (unsigned bit = Stitch_MinX; bit <= Stitch_MaxZ; bit <<= 1)
+    {
+        if (stitch_mask & bit) stitched_edges++;
+    }
+    return (block_count * block_count * 8 - stitched_edges * block_count) * 3;
+}
+
+unsigned TerrainChunkLayout::patternTriangleCount(unsigned lod, unsigned stitch_mask) const
+{
+    assert(lod * STITCH_VARIANT_COUNT + stitch_mask < m_patterns.size());
+    return m_patterns[lod * STITCH_VARIANT_COUNT + stitch_mask][1] / 3;
+}
+
+unsigned TerrainChunkLayout::chunkOriginVertex(unsigned chunk) const
+{
+    assert(chunk < chunkCount());
+    const unsigned cx = chunk % m_chunkCountX;
+    const unsigned cz = chunk / m_chunkCountX;
+    return cz * m_chunkCells * (m_numCols + 1) + cx * m_chunkCells;
+}
+
+Enigma::Geometries::GeometrySegment TerrainChunkLayout::chunkSegment(unsigned chunk, unsigned lod, unsigned stitch_mask) const
+{
+    assert(lod * STITCH_VARIANT_COUNT + stitch_mask < m_patterns.size());
+    const auto& pattern = m_patterns[lod * STITCH_VARIANT_COUNT + stitch_mask];
+    Geometries::GeometrySegment segment;
+    segment.m_startVtx = chunkOriginVertex(chunk);
+    segment.m_vtxCount = m_chunkCells * (m_numCols + 1) + m_chunkCells + 1;
+    segment.m_startIdx = pattern[0];
+    segment.m_idxCount = pattern[1];
+    return segment;
+}
+
+void TerrainChunkLayout::chunkVertexRange(unsigned chunk, unsigned& min_x, unsigned& min_z, unsigned& max_x, unsigned& max_z) const
+{
+    assert(chunk < chunkCount());
+    min_x = (chunk % m_chunkCountX) * m_chunkCells;
+    min_z = (chunk / m_chunkCountX) * m_chunkCells;
+    max_x = min_x + m_chunkCells;
+    max_z = min_z + m_chunkCells;
+}
+
+void TerrainChunkLayout::calculateChunkBounds(const float_buffer& heights, const Vector3& min_position, const Vector3& max_position)
+{
+    assert(isValid());
+    m_minPosition = min_position;
+    m_cellWidth = (max_position.x() - min_position.x()) / static_cast<float>(m_numCols);
+    m_cellHeight = (max_position.z() - min_position.z()) / static_cast<float>(m_numRows);
+    m_chunkMinCorners.resize(chunkCount());
+    m_chunkMaxCorners.resize(chunkCount());
+    updateChunkBounds(heights, 0, 0, m_numCols, m_numRows);
+}
+
+void TerrainChunkLayout::updateChunkBounds(const float_buffer& heights, unsigned min_x, unsigned min_z, unsigned max_x, unsigned max_z)
+{
+    if ((!isValid()) || (m_chunkMinCorners.size() != chunkCount())) return;
+    const unsigned vtx_num_x = m_numCols + 1;
+    // 在 chunk 邊界上的頂點同時屬於兩邊的 chunk
+    const unsigned cx_begin = min_x == 0 ? 0 : (min_x - 1) / m_chunkCells;
+    const unsigned cz_begin = min_z == 0 ? 0 : (min_z - 1) / m_chunkCells;
+    const unsigned cx_end = std::min(max_x / m_chunkCells, m_chunkCountX - 1);
+    const unsigned cz_end = std::min(max_z / m_chunkCells, m_chunkCountZ - 1);
+    for (unsigned cz = cz_begin; cz <= cz_end; cz++)
+    {
+        for (unsigned cx = cx_begin; cx <= cx_end; cx++)
+        {
+            const unsigned chunk = cz * m_chunkCountX + cx;
+            unsigned x0, z0, x1, z1;
+            chunkVertexRange(chunk, x0, z0, x1, z1);
+            float min_height = heights.empty() ? 0.0f : heights[z0 * vtx_num_x + x0];
+            float max_height = min_height;
+            if (!heights.empty())
+            {
+                for (unsigned z = z0; z <= z1; z++)
+                {
+                    const auto row_begin = heights.begin() + z * vtx_num_x + x0;
+                    const auto [lo, hi] = std::minmax_element(row_begin, row_begin + (x1 - x0 + 1));
+                    min_height = std::min(min_height, *lo);
+                    max_height = std::max(max_height, *hi);
+                }
+            }
+            m_chunkMinCorners[chunk] = Vector3(m_minPosition.x() + static_cast<float>(x0) * m_cellWidth, min_height,
+                m_minPosition.z() + static_cast<float>(z0) * m_cellHeight);
+            m_chunkMaxCorners[chunk] = Vector3(m_minPosition.x() + static_cast<float>(x1) * m_cellWidth, max_height,
+                m_minPosition.z() + static_cast<float>(z1) * m_cellHeight);
+        }
+    }
+}
+
+std::vector<TerrainChunkLayout::Selection> TerrainChunkLayout::selectChunks(const Vector3& local_view_position,
+    const Matrix4& mx_local_view_proj, float lod_base_distance)
+{
+    std::vector<Selection> selections;
+    if ((!isValid()) || (m_chunkMinCorners.size() != chunkCount()) || (m_patterns.empty())) return selections;
+
+    for (unsigned chunk = 0; chunk < chunkCount(); chunk++)
+    {
+        m_chunkLods[chunk] = { chooseLod(chunk, local_view_position, lod_base_distance), 0 };
+    }
+    // 相鄰 chunk 的 lod 差不能超過 1 (stitch pattern 只處理差 1), 只往細的方向調整, 一定會收斂
+    bool is_changed = true;
+    while (is_changed)
+    {
+        is_changed = false;
+        for (unsigned cz = 0; cz < m_chunkCountZ; cz++)
+        {
+            for (unsigned cx = 0; cx < m_chunkCountX; cx++)
+            {
+                unsigned& lod = m_chunkLods[cz * m_chunkCountX + cx].m_lod;
+                unsigned limit = lod;
+                if (cx > 0) limit = std::min(limit, m_chunkLods[cz * m_chunkCountX + cx - 1].m_lod + 1);
+                if (cx + 1 < m_chunkCountX) limit = std::min(limit, m_chunkLods[cz * m_chunkCountX + cx + 1].m_lod + 1);
+                if (cz > 0) limit = std::min(limit, m_chunkLods[(cz - 1) * m_chunkCountX + cx].m_lod + 1);
+                if (cz + 1 < m_chunkCountZ) limit = std::min(limit, m_chunkLods[(cz + 1) * m_chunkCountX + cx].m_lod + 1);
+                if (limit < lod)
+                {
+                    lod = limit;
+                    is_changed = true;
+                }
+            }
+        }
+    }
+    for (unsigned cz = 0; cz < m_chunkCountZ; cz++)
+    {
+        for (unsigned cx = 0; cx < m_chunkCountX; cx++)
+        {
+            ChunkLod& chunk_lod = m_chunkLods[cz * m_chunkCountX + cx];
+            unsigned mask = 0;
+            if ((cx > 0) && (m_chunkLods[cz * m_chunkCountX + cx - 1].m_lod > chunk_lod.m_lod)) mask |= Stitch_MinX;
+            if ((cx + 1 < m_chunkCountX) && (m_chunkLods[cz * m_chunkCountX + cx + 1].m_lod > chunk_lod.m_lod)) mask |= Stitch_MaxX;
+            if ((cz > 0) && (m_chunkLods[(cz - 1) * m_chunkCountX + cx].m_lod > chunk_lod.m_lod)) mask |= Stitch_MinZ;
+            if ((cz + 1 < m_chunkCountZ) && (m_chunkLods[(cz + 1) * m_chunkCountX + cx].m_lod > chunk_lod.m_lod)) mask |= Stitch_MaxZ;
+            chunk_lod.m_stitchMask = mask;
+        }
+    }
+
+    // frustum planes (a, b, c, d), clip = M * v, 點在內側時 a*x + b*y + c*z + d >= 0;
+    // near plane 用 w + z >= 0, 對 [0, 1] 與 [-1, 1] 的 depth range 都保守
+    std::array<std::array<float, 4>, 6> planes;
+    for (int i = 0; i < 4; i++)
+    {
+        const float r0 = mx_local_view_proj(0, i);
+        const float r1 = mx_local_view_proj(1, i);
+        const float r2 = mx_local_view_proj(2, i);
+        const float r3 = mx_local_view_proj(3, i);
+        planes[0][i] = r3 + r0;
+        planes[1][i] = r3 - r0;
+        planes[2][i] = r3 + r1;
+        planes[3][i] = r3 - r1;
+        planes[4][i] = r3 + r2;
+        planes[5][i] = r3 - r2;
+    }
+    selections.reserve(chunkCount());
+    for (unsigned chunk = 0; chunk < chunkCount(); chunk++)
+    {
+        const Vector3& lo = m_chunkMinCorners[chunk];
+        const Vector3& hi = m_chunkMaxCorners[chunk];
+        bool is_outside = false;
+        for (const auto& plane : planes)
+        {
+            // 取 aabb 上沿法線方向最遠的角 (p-vertex), 它在外側就整個在外側
+            const float px = plane[0] >= 0.0f ? hi.x() : lo.x();
+            const float py = plane[1] >= 0.0f ? hi.y() : lo.y();
+            const float pz = plane[2] >= 0.0f ? hi.z() : lo.z();
+            if (plane[0] * px + plane[1] * py + plane[2] * pz + plane[3] < 0.0f)
+            {
+                is_outside = true;
+                break;
+            }
+        }
+        if (is_outside) continue;
+        selections.push_back({ chunk, m_chunkLods[chunk].m_lod, m_chunkLods[chunk].m_stitchMask });
+    }
+    return selections;
+}
+
+void TerrainChunkLayout::appendBlockFan(uint_buffer& indices, unsigned x, unsigned z, unsigned step, unsigned skip_mids) const
+{
+    const unsigned stride = m_numCols + 1;
+    auto index_of = [=](unsigned dx, unsigned dz) { return (z + dz) * stride + x + dx; };
+    const unsigned center = index_of(step, step);
+    // block 外圈, 與原本格子三角形相同的環繞方向
+    const unsigned s = step;
+    const unsigned d = step * 2;
+    const std::array<std::pair<unsigned, unsigned>, 8> ring =
+    { {
+        { index_of(0, 0), 0 }, { index_of(0, s), Stitch_MinX },
+        { index_of(0, d), 0 }, { index_of(s, d), Stitch_MaxZ },
+        { index_of(d, d), 0 }, { index_of(d, s), Stitch_MaxX },
+        { index_of(d, 0), 0 }, { index_of(s, 0), Stitch_MinZ },
+    } };
+    std::array<unsigned, 8> boundary;
+    unsigned boundary_count = 0;
+    for (const auto& [vertex, edge] : ring)
+    {
+        if ((edge != 0) && (skip_mids & edge)) continue;
+        boundary[boundary_count++] = vertex;
+    }
+    for (unsigned i = 0; i < boundary_count; i++)
+    {
+        indices.push_back(center);
+        indices.push_back(boundary[i]);
+        indices.push_back(boundary[(i + 1) % boundary_count]);
+    }
+}
+
+unsigned TerrainChunkLayout::chooseLod(unsigned chunk, const Vector3& local_view_position, float lod_base_distance) const
+{
+    if (lod_base_distance <= 0.0f) return 0;
+    const Vector3& lo = m_chunkMinCorners[chunk];
+    const Vector3& hi = m_chunkMaxCorners[chunk];
+    const float dx = std::max({ lo.x() - local_view_position.x(), 0.0f, local_view_position.x() - hi.x() });
+    const float dy = std::max({ lo.y() - local_view_position.y(), 0.0f, local_view_position.y() - hi.y() });
+    const float dz = std::max({ lo.z() - local_view_position.z(), 0.0f, local_view_position.z() - hi.z() });
+    const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (distance < lod_base_distance) return 0;
+    const unsigned lod = static_cast<unsigned>(std::floor(std::log2(distance / lod_base_distance))) + 1;
+    return std::min(lod, m_lodCount - 1);
+}
@@ -0,0 +1,112 @@
+﻿/*********************************************************************
+ * \file   TerrainChunkLayout.h
+ * \brief  terrain chunks, geo-mipmapping lod index patterns & chunk lod selection
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TERRAIN_CHUNK_LAYOUT_H
+#define TERRAIN_CHUNK_LAYOUT_H
+
+#include "Frameworks/ExtentTypesDefine.h"
+#include "Geometries/GeometrySegment.h"
+#include "MathLib/Vector3.h"
+#include "MathLib/Matrix4.h"
+#include <vector>
+#include <array>
+
+namespace Enigma::Terrain
+{
+    /** 把 (rows x cols) 的格點切成 chunk_cells x chunk_cells 的 chunk, 頂點仍是整張地形的 row major 排列.
+     每個 lod 的 index pattern 以 chunk 原點頂點為 0, row stride 為 (cols + 1), 所以所有 chunk 共用,
+     draw 時用 segment 的 start vertex 當 base vertex 位移到各 chunk.
+     pattern 以 2x2 格為一組, 從中心點做 fan, 鄰近 chunk 較粗 (lod + 1) 的邊不使用邊上的中點, 避免裂縫 */
+    class TerrainChunkLayout
+    {
+    public:
+        enum StitchEdge : unsigned
+        {
+            Stitch_MinX = 0x01,
+            Stitch_MaxX = 0x02,
+            Stitch_MinZ = 0x04,
+            Stitch_MaxZ = 0x08,
+        };
+        static constexpr unsigned STITCH_VARIANT_COUNT = 16;
+
+        struct ChunkLod
+        {
+            unsigned m_lod;
+            unsigned m_stitchMask;
+        };
+        struct Selection
+        {
+            unsigned m_chunk;
+            unsigned m_lod;
+            unsigned m_stitchMask;
+        };
+
+    public:
+        TerrainChunkLayout();
+        TerrainChunkLayout(unsigned num_rows, unsigned num_cols, unsigned chunk_cells);
+
+        /** chunk_cells 要是 2 的次方 (>= 2), 且能整除 rows & cols */
+        static bool isChunkable(unsigned num_rows, unsigned num_cols, unsigned chunk_cells);
+
+        bool isValid() const { return m_chunkCells > 0; }
+        unsigned chunkCells() const { return m_chunkCells; }
+        unsigned chunkCountX() const { return m_chunkCountX; }
+        unsigned chunkCountZ() const { return m_chunkCountZ; }
+        unsigned chunkCount() const { return m_chunkCountX * m_chunkCountZ; }
+        /** lod 0 每格一個 quad, lod n 每 2^n 格一個 quad, 最粗的 lod 每個 chunk 2x2 quads */
+        unsigned lodCount() const { return m_lodCount; }
+
+        /** all lod & stitch variants, indices relative to chunk origin vertex, 同時算好各 pattern 的範圍 */
+        uint_buffer buildIndexPatterns();
+        /** index 已經從 dto 讀進來時, 只需要算各 pattern 的範圍 */
+        void calculatePatternRanges();
+        unsigned patternIndexCount() const;
+        unsigned patternTriangleCount(unsigned lod, unsigned stitch_mask) const;
+
+        unsigned chunkOriginVertex(unsigned chunk) const;
+        Geometries::GeometrySegment chunkSegment(unsigned chunk, unsigned lod, unsigned stitch_mask) const;
+        /** chunk 涵蓋的頂點範圍 (含邊界) */
+        void chunkVertexRange(unsigned chunk, unsigned& min_x, unsigned& min_z, unsigned& max_x, unsigned& max_z) const;
+
+        /** chunk aabb in terrain local space, from height map */
+        void calculateChunkBounds(const float_buffer& heights, const MathLib::Vector3& min_position, const MathLib::Vector3& max_position);
+        /** height map 的矩形範圍 (頂點座標, 含 max) 改變後重算相關 chunk 的 bounds */
+        void updateChunkBounds(const float_buffer& heights, unsigned min_x, unsigned min_z, unsigned max_x, unsigned max_z);
+        const MathLib::Vector3& chunkMinCorner(unsigned chunk) const { return m_chunkMinCorners[chunk]; }
+        const MathLib::Vector3& chunkMaxCorner(unsigned chunk) const { return m_chunkMaxCorners[chunk]; }
+
+        /** 依距離選 lod (lod n 從 lod_base_distance * 2^(n-1) 開始), 相鄰 chunk 的 lod 差限制在 1,
+         再用 local view-projection 的 frustum 剔除 chunk, 回傳可見 chunk 的 lod 與 stitch mask */
+        std::vector<Selection> selectChunks(const MathLib::Vector3& local_view_position, const MathLib::Matrix4& mx_local_view_proj,
+            float lod_base_distance);
+        /** 上次 selectChunks 所有 chunk 的 lod (含被剔除的) */
+        const std::vector<ChunkLod>& chunkLods() const { return m_chunkLods; }
+
+    protected:
+        unsigned patternIndexCount(unsigned lod, unsigned stitch_mask) const;
+        void appendBlockFan(uint_buffer& indices, unsigned x, unsigned z, unsigned step, unsigned skip_mids) const;
+        unsigned chooseLod(unsigned chunk, const MathLib::Vector3& local_view_position, float lod_base_distance) const;
+
+    protected:
+        unsigned m_numRows;
+        unsigned m_numCols;
+        unsigned m_chunkCells;
+        unsigned m_chunkCountX;
+        unsigned m_chunkCountZ;
+        unsigned m_lodCount;
+        float m_cellWidth;
+        float m_cellHeight;
+        MathLib::Vector3 m_minPosition;
+        /// [lod * STITCH_VARIANT_COUNT + mask] -> (start index, index count)
+        std::vector<std::array<unsigned, 2>> m_patterns;
+        std::vector<MathLib::Vector3> m_chunkMinCorners;
+        std::vector<MathLib::Vector3> m_chunkMaxCorners;
+        std::vector<ChunkLod> m_chunkLods;
+    };
+}
+
+#endif // TERRAIN_CHUNK_LAYOUT_H
@@ -1,6 +1,9 @@
 ﻿#include "TerrainGeometry.h"
 #include "Platforms/PlatformLayer.h"
 #include "TerrainGeometryAssembler.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include <algorithm>
+#include <cassert>
 
 using namespace Enigma::Terrain;
 using namespace Enigma::Engine;
@@ -8,7 +11,131 @@ using namespace Enigma::MathLib;
 
 DEFINE_RTTI(Terrain, TerrainGeometry, TriangleList);
 
-TerrainGeometry::TerrainGeometry(const Geometries::GeometryId& id) : TriangleList(id), m_numRows(0), m_numCols(0)
+static constexpr size_t MIN_PARALLEL_ROWS = 16;
+static constexpr size_t MIN_PARALLEL_HEIGHT_QUERIES = 256;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TERRAIN_NORMAL_SIMD
+#define TERRAIN_NORMAL_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define TERRAIN_NORMAL_SIMD
+#define TERRAIN_NORMAL_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(TERRAIN_NORMAL_SSE)
+static constexpr unsigned SIMD_WIDTH = 4;
+using float4 = __m128;
+static inline float4 load4(const float* p) { return _mm_loadu_ps(p); }
+static inline void store4(float* p, float4 v) { _mm_storeu_ps(p, v); }
+static inline float4 set4(float f) { return _mm_set1_ps(f); }
+static inline float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+static inline float4 sub4(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+static inline float4 div4(float4 a, float4 b) { return _mm_div_ps(a, b); }
+static inline float4 sqrt4(float4 a) { return _mm_sqrt_ps(a); }
+#elif defined(TERRAIN_NORMAL_NEON)
+static constexpr unsigned SIMD_WIDTH = 4;
+using float4 = float32x4_t;
+static inline float4 load4(const float* p) { return vld1q_f32(p); }
+static inline void store4(float* p, float4 v) { vst1q_f32(p, v); }
+static inline float4 set4(float f) { return vdupq_n_f32(f); }
+static inline float4 add4(float4 a, float4 b) { return vaddq_f32(a, b); }
+static inline float4 sub4(float4 a, float4 b) { return vsubq_f32(a, b); }
+static inline float4 mul4(float4 a, float4 b) { return vmulq_f32(a, b); }
+static inline float4 div4(float4 a, float4 b) { return vdivq_f32(a, b); }
+static inline float4 sqrt4(float4 a) { return vsqrtq_f32(a); }
+#else
+static constexpr unsigned SIMD_WIDTH = 1;
+#endif
+
+/** 六個鄰邊 (正規化後) 兩兩外積加總, 鄰點不存在時該邊高度差視為 0 */
+static Vector3 computeVertexNormal(const float* heights, unsigned num_cols, unsigned num_rows,
+    const Dimension<float>& dimension, unsigned ix, unsigned iz)
+{
+    const unsigned vtx_num_x = num_cols + 1;
+    const float h0 = heights[iz * vtx_num_x + ix];
+    const float h1 = ix < num_cols ? heights[iz * vtx_num_x + ix + 1] - h0 : 0.0f;
+    const float h2 = iz > 0 ? heights[(iz - 1) * vtx_num_x + ix] - h0 : 0.0f;
+    const float h3 = ix > 0 ? heights[iz * vtx_num_x + ix - 1] - h0 : 0.0f;
+    const float h4 = iz < num_rows ? heights[(iz + 1) * vtx_num_x + ix] - h0 : 0.0f;
+    const float h5 = ((iz < num_rows) && (ix < num_cols)) ? heights[(iz + 1) * vtx_num_x + ix + 1] - h0 : 0.0f;
+    const float h6 = ((iz > 0) && (ix > 0)) ? heights[(iz - 1) * vtx_num_x + ix - 1] - h0 : 0.0f;
+    const Vector3 vecEdge1 = Vector3(dimension.m_width, h1, 0.0f).normalize();
+    const Vector3 vecEdge2 = Vector3(0.0f, h2, -dimension.m_height).normalize();
+    const Vector3 vecEdge3 = Vector3(-dimension.m_width, h3, 0.0f).normalize();
+    const Vector3 vecEdge4 = Vector3(0.0f, h4, dimension.m_height).normalize();
+    const Vector3 vecEdge5 = Vector3(dimension.m_width, h5, dimension.m_height).normalize();
+    const Vector3 vecEdge6 = Vector3(-dimension.m_width, h6, -dimension.m_height).normalize();
+    Vector3 vecNor = vecEdge1.cross(vecEdge2) + vecEdge2.cross(vecEdge6) + vecEdge6.cross(vecEdge3)
+        + vecEdge3.cross(vecEdge4) + vecEdge4.cross(vecEdge5) + vecEdge5.cross(vecEdge1);
+    vecNor.normalizeSelf();
+    return vecNor;
+}
+
+static inline void writeVertexNormal(float* normals, size_t stride, const float* heights, unsigned num_cols, unsigned num_rows,
+    const Dimension<float>& dimension, unsigned ix, unsigned iz)
+{
+    const Vector3 nor = computeVertexNormal(heights, num_cols, num_rows, dimension, ix, iz);
+    float* dst = normals + stride * (iz * (num_cols + 1) + ix);
+    dst[0] = nor.x();
+    dst[1] = nor.y();
+    dst[2] = nor.z();
+}
+
+#if defined(TERRAIN_NORMAL_SIMD)
+/** SoA 的 computeVertexNormal, row 指向連續 SIMD_WIDTH 個內部頂點的第一個 */
+static void computeInteriorNormals(const float* row, unsigned vtx_num_x, const Dimension<float>& dimension,
+    float* nx, float* ny, float* nz)
+{
+    const float4 h0 = load4(row);
+    const float4 h1 = sub4(load4(row + 1), h0);
+    const float4 h2 = sub4(load4(row - vtx_num_x), h0);
+    const float4 h3 = sub4(load4(row - 1), h0);
+    const float4 h4 = sub4(load4(row + vtx_num_x), h0);
+    const float4 h5 = sub4(load4(row + vtx_num_x + 1), h0);
+    const float4 h6 = sub4(load4(row - vtx_num_x - 1), h0);
+
+    struct Edge { float4 x; float4 y; float4 z; };
+    const float4 zero = set4(0.0f);
+    const float w = dimension.m_width;
+    const float d = dimension.m_height;
+    auto make_edge = [&zero](float x, float4 h, float z) -> Edge
+    {
+        const float4 x4 = set4(x);
+        const float4 z4 = set4(z);
+        const float4 len = sqrt4(add4(add4(mul4(x4, x4), mul4(h, h)), mul4(z4, z4)));
+        return { div4(x4, len), div4(h, len), div4(z4, len) };
+    };
+    const Edge e1 = make_edge(w, h1, 0.0f);
+    const Edge e2 = make_edge(0.0f, h2, -d);
+    const Edge e3 = make_edge(-w, h3, 0.0f);
+    const Edge e4 = make_edge(0.0f, h4, d);
+    const Edge e5 = make_edge(w, h5, d);
+    const Edge e6 = make_edge(-w, h6, -d);
+    Edge sum{ zero, zero, zero };
+    auto add_cross = [&sum](const Edge& a, const Edge& b)
+    {
+        sum.x = add4(sum.x, sub4(mul4(a.y, b.z), mul4(a.z, b.y)));
+        sum.y = add4(sum.y, sub4(mul4(a.z, b.x), mul4(a.x, b.z)));
+        sum.z = add4(sum.z, sub4(mul4(a.x, b.y), mul4(a.y, b.x)));
+    };
+    add_cross(e1, e2);
+    add_cross(e2, e6);
+    add_cross(e6, e3);
+    add_cross(e3, e4);
+    add_cross(e4, e5);
+    add_cross(e5, e1);
+    // 內部頂點的 y 分量恆為正, 長度不會是 0
+    const float4 len = sqrt4(add4(add4(mul4(sum.x, sum.x), mul4(sum.y, sum.y)), mul4(sum.z, sum.z)));
+    store4(nx, div4(sum.x, len));
+    store4(ny, div4(sum.y, len));
+    store4(nz, div4(sum.z, len));
+}
+#endif
+
+TerrainGeometry::TerrainGeometry(const Geometries::GeometryId& id) : TriangleList(id), m_numRows(0), m_numCols(0), m_chunkCells(0)
 {
     m_factoryDesc = Engine::FactoryDesc(TerrainGeometry::TYPE_RTTI.getName());
 }
@@ -42,6 +169,7 @@ void TerrainGeometry::assemble(const std::shared_ptr<Geometries::GeometryAssembl
         {
             terrainAssembler->heightMap(m_heightMap);
         }
+        terrainAssembler->chunkCells(m_chunkCells);
     }
     else
     {
@@ -74,6 +202,15 @@ void TerrainGeometry::disassemble(const std::shared_ptr<Geometries::GeometryDisa
             m_heightMap = std::vector<float>((m_numRows + 1) * (m_numCols + 1));
             std::memset(m_heightMap.data(), 0, m_heightMap.size() * sizeof(float));
         }
+        m_chunkCells = terrainDisassembler->chunkCells();
+        m_chunkLayout = TerrainChunkLayout(m_numRows, m_numCols, m_chunkCells);
+        if (m_chunkLayout.isValid())
+        {
+            m_chunkLayout.calculatePatternRanges();
+            m_chunkLayout.calculateChunkBounds(m_heightMap, m_minPosition, m_maxPosition);
+        }
+        const auto dimension = getCellDimension();
+        m_heightPyramid.build(m_heightMap, m_numRows, m_numCols, m_minPosition, dimension.m_width, dimension.m_height);
     }
     else
     {
@@ -81,94 +218,163 @@ void TerrainGeometry::disassemble(const std::shared_ptr<Geometries::GeometryDisa
     }
 }
 
-void TerrainGeometry::updateHeightMapToVertexMemory()
+void TerrainGeometry::updateHeightMapToVertexMemory(const std::shared_ptr<Frameworks::WorkerThreadPool>& workers)
 {
-    rangedUpdateHeightMapToVertexMemory(0, static_cast<unsigned>(m_heightMap.size()));
+    assert(m_numRows > 0 && m_numCols > 0);
+    if (FATAL_LOG_EXPR(m_heightMap.empty())) return;
+    updateHeightBounds({ 0, 0, m_numCols, m_numRows });
+    if (!workers)
+    {
+        writeHeightRows(0, m_numCols, 0, m_numRows);
+        return;
+    }
+    workers->parallelFor(m_numRows + 1, [this](size_t begin, size_t end)
+        { writeHeightRows(0, m_numCols, static_cast<unsigned>(begin), static_cast<unsigned>(end - 1)); }, MIN_PARALLEL_ROWS);
 }
 
 void TerrainGeometry::rangedUpdateHeightMapToVertexMemory(unsigned offset, unsigned count)
 {
     assert(m_numRows > 0 && m_numCols > 0);
     if (FATAL_LOG_EXPR(m_heightMap.empty())) return;
-    //todo : check performance later
-    for (unsigned i = offset; i < offset + count; i++)
+    if (count == 0) return;
+    writeHeightSpan(offset, count);
+    const auto [start_x, start_z] = revertVertexIndex(offset);
+    const auto [end_x, end_z] = revertVertexIndex(offset + count - 1);
+    if (start_z == end_z)
     {
-        auto pos = getPosition3(i);
-        pos.y() = m_heightMap[i];
-        setPosition3(i, pos);
+        updateHeightBounds({ start_x, start_z, end_x, end_z });
+    }
+    else
+    {
+        updateHeightBounds({ 0, start_z, m_numCols, end_z });
     }
 }
 
-void TerrainGeometry::updateVertexNormals()
+void TerrainGeometry::rectUpdateHeightMapToVertexMemory(const VertexRect& rect)
 {
-    rangedUpdateVertexNormals(0, static_cast<unsigned>(m_heightMap.size()));
+    assert(m_numRows > 0 && m_numCols > 0);
+    if (FATAL_LOG_EXPR(m_heightMap.empty())) return;
+    const VertexRect clamped = expandVertexRect(rect, 0);
+    writeHeightRows(clamped.m_minX, clamped.m_maxX, clamped.m_minZ, clamped.m_maxZ);
+    updateHeightBounds(clamped);
+}
+
+void TerrainGeometry::updateVertexNormals(const std::shared_ptr<Frameworks::WorkerThreadPool>& workers)
+{
+    assert(m_numRows > 0 && m_numCols > 0);
+    if (FATAL_LOG_EXPR(m_heightMap.empty())) return;
+    if (!workers)
+    {
+        writeNormalRows(0, m_numCols, 0, m_numRows);
+        return;
+    }
+    workers->parallelFor(m_numRows + 1, [this](size_t begin, size_t end)
+        { writeNormalRows(0, m_numCols, static_cast<unsigned>(begin), static_cast<unsigned>(end - 1)); }, MIN_PARALLEL_ROWS);
 }
 
 void TerrainGeometry::rangedUpdateVertexNormals(unsigned offset, unsigned count)
 {
-    auto dimension = getCellDimension();
+    if (count == 0) return;
     auto [start_x, start_z] = revertVertexIndex(offset);
     auto [end_x, end_z] = revertVertexIndex(offset + count - 1);
-    if (start_x > 0) start_x--;
-    if (start_z > 0) start_z--;
-    if (end_x < m_numCols) end_x++;
-    if (end_z < m_numRows) end_z++;
+    // 跨 row 的線性範圍, 中間的 row 是整列
+    if (start_z != end_z)
+    {
+        start_x = 0;
+        end_x = m_numCols;
+    }
+    rectUpdateVertexNormals({ start_x, start_z, end_x, end_z });
+}
+
+TerrainGeometry::VertexRect TerrainGeometry::rectUpdateVertexNormals(const VertexRect& rect)
+{
+    assert(m_numRows > 0 && m_numCols > 0);
+    const VertexRect affected = expandVertexRect(rect, 1);
+    if (FATAL_LOG_EXPR(m_heightMap.empty())) return affected;
+    writeNormalRows(affected.m_minX, affected.m_maxX, affected.m_minZ, affected.m_maxZ);
+    return affected;
+}
+
+TerrainGeometry::VertexRect TerrainGeometry::expandVertexRect(const VertexRect& rect, unsigned border) const
+{
+    VertexRect expanded;
+    expanded.m_minX = rect.m_minX > border ? rect.m_minX - border : 0;
+    expanded.m_minZ = rect.m_minZ > border ? rect.m_minZ - border : 0;
+    expanded.m_maxX = std::min(rect.m_maxX + border, m_numCols);
+    expanded.m_maxZ = std::min(rect.m_maxZ + border, m_numRows);
+    return expanded;
+}
+
+void TerrainGeometry::updateHeightBounds(const VertexRect& rect)
+{
+    markPositionsChanged();
+    m_chunkLayout.updateChunkBounds(m_heightMap, rect.m_minX, rect.m_minZ, rect.m_maxX, rect.m_maxZ);
+    m_heightPyramid.update(m_heightMap, rect.m_minX, rect.m_minZ, rect.m_maxX, rect.m_maxZ);
+}
+
+void TerrainGeometry::writeHeightRows(unsigned min_x, unsigned max_x, unsigned min_z, unsigned max_z)
+{
+    if ((min_x > max_x) || (min_z > max_z)) return;
+    for (unsigned iz = min_z; iz <= max_z; iz++)
+    {
+        writeHeightSpan(convertVertexIndex(min_x, iz), max_x - min_x + 1);
+    }
+}
+
+void TerrainGeometry::writeHeightSpan(unsigned offset, unsigned count)
+{
+    const int pos_offset = m_vertexDesc.positionOffset();
+    if (pos_offset < 0) return;
+    assert(offset + count <= m_heightMap.size());
+    assert(offset + count <= m_vtxUsedCount);
+    // 直接依 stride 寫入 position.y, 不必每個頂點經過 vertex description 的通用轉換
+    const size_t stride = m_vertexDesc.totalVertexSize() / sizeof(float);
+    float* y = reinterpret_cast<float*>(m_vertexMemory.data()) + static_cast<size_t>(pos_offset) + 1 + stride * offset;
+    const float* heights = &m_heightMap[offset];
+    for (unsigned i = 0; i < count; i++, y += stride)
+    {
+        *y = heights[i];
+    }
+}
 
-    unsigned vtx_num_x = m_numCols + 1;
-    // calculate normal
-    for (unsigned ix = start_x; ix <= end_x; ix++)
+void TerrainGeometry::writeNormalRows(unsigned min_x, unsigned max_x, unsigned min_z, unsigned max_z)
+{
+    if ((min_x > max_x) || (min_z > max_z)) return;
+    const int nor_offset = m_vertexDesc.normalOffset();
+    if (nor_offset < 0) return;
+    assert(m_heightMap.size() <= m_vtxUsedCount);
+    const auto dimension = getCellDimension();
+    const size_t stride = m_vertexDesc.totalVertexSize() / sizeof(float);
+    float* normals = reinterpret_cast<float*>(m_vertexMemory.data()) + nor_offset;
+    const unsigned vtx_num_x = m_numCols + 1;
+
+    float nx[SIMD_WIDTH];
+    float ny[SIMD_WIDTH];
+    float nz[SIMD_WIDTH];
+    for (unsigned iz = min_z; iz <= max_z; iz++)
     {
-        for (unsigned iz = start_z; iz <= end_z; iz++)
+        unsigned ix = min_x;
+#if defined(TERRAIN_NORMAL_SIMD)
+        // 內部頂點 (六個鄰點都存在) 一次算 SIMD_WIDTH 個, 邊界與尾端交給 scalar
+        if ((iz > 0) && (iz < m_numRows))
         {
-            float h0 = m_heightMap[iz * vtx_num_x + ix];
-            float h1 = 0.0f;
-            if (ix < m_numCols)
-            {
-                h1 = m_heightMap[iz * vtx_num_x + ix + 1] - h0;
-            }
-            float h2 = 0.0f;
-            if (iz > 0)
-            {
-                h2 = m_heightMap[(iz - 1) * vtx_num_x + ix] - h0;
-            }
-            float h3 = 0.0f;
-            if (ix > 0)
-            {
-                h3 = m_heightMap[iz * vtx_num_x + ix - 1] - h0;
-            }
-            float h4 = 0.0f;
-            if (iz < m_numRows)
+            if (ix == 0) writeVertexNormal(normals, stride, m_heightMap.data(), m_numCols, m_numRows, dimension, ix++, iz);
+            for (; (ix + SIMD_WIDTH <= m_numCols) && (ix + SIMD_WIDTH <= max_x + 1); ix += SIMD_WIDTH)
             {
-                h4 = m_heightMap[(iz + 1) * vtx_num_x + ix] - h0;
+                computeInteriorNormals(&m_heightMap[iz * vtx_num_x + ix], vtx_num_x, dimension, nx, ny, nz);
+                float* dst = normals + stride * (iz * vtx_num_x + ix);
+                for (unsigned k = 0; k < SIMD_WIDTH; k++, dst += stride)
+                {
+                    dst[0] = nx[k];
+                    dst[1] = ny[k];
+                    dst[2] = nz[k];
+                }
             }
-            float h5 = 0.0f;
-            if ((iz < m_numRows) && (ix < m_numCols))
-            {
-                h5 = m_heightMap[(iz + 1) * vtx_num_x + ix + 1] - h0;
-            }
-            float h6 = 0.0f;
-            if ((iz > 0) && (ix > 0))
-            {
-                h6 = m_heightMap[(iz - 1) * vtx_num_x + ix - 1] - h0;
-            }
-            Vector3 vecEdge1 = Vector3(dimension.m_width, h1, 0.0f).normalize();
-            Vector3 vecEdge2 = Vector3(0.0f, h2, -dimension.m_height).normalize();
-            Vector3 vecEdge3 = Vector3(-dimension.m_width, h3, 0.0f).normalize();
-            Vector3 vecEdge4 = Vector3(0.0f, h4, dimension.m_height).normalize();
-            Vector3 vecEdge5 = Vector3(dimension.m_width, h5, dimension.m_height).normalize();
-            Vector3 vecEdge6 = Vector3(-dimension.m_width, h6, -dimension.m_height).normalize();
-            Vector3 vecFace1 = vecEdge1.cross(vecEdge2);
-            Vector3 vecFace2 = vecEdge2.cross(vecEdge6);
-            Vector3 vecFace3 = vecEdge6.cross(vecEdge3);
-            Vector3 vecFace4 = vecEdge3.cross(vecEdge4);
-            Vector3 vecFace5 = vecEdge4.cross(vecEdge5);
-            Vector3 vecFace6 = vecEdge5.cross(vecEdge1);
-            Vector3 vecNor = vecFace1 + vecFace2 + vecFace3 + vecFace4 + vecFace5 + vecFace6;
-            vecNor.normalizeSelf();
-
-            // vtx idx
-            int vtxIdx = iz * vtx_num_x + ix;
-            setVertexNormal(vtxIdx, vecNor);
+        }
+#endif
+        for (; ix <= max_x; ix++)
+        {
+            writeVertexNormal(normals, stride, m_heightMap.data(), m_numCols, m_numRows, dimension, ix, iz);
         }
     }
 }
@@ -200,11 +406,53 @@ void TerrainGeometry::changeHeight(unsigned x, unsigned z, float new_height)
 std::tuple<unsigned, unsigned> TerrainGeometry::locateCell(const MathLib::Vector3& position) const
 {
     auto dimension = getCellDimension();
-    unsigned cell_x = static_cast<unsigned>(std::floorf((position.x() - m_minPosition.x()) / dimension.m_width + 0.5f));
-    unsigned cell_z = static_cast<unsigned>(std::floorf((position.z() - m_minPosition.z()) / dimension.m_height + 0.5f));
+    unsigned cell_x = static_cast<unsigned>(std::floor((position.x() - m_minPosition.x()) / dimension.m_width + 0.5f));
+    unsigned cell_z = static_cast<unsigned>(std::floor((position.z() - m_minPosition.z()) / dimension.m_height + 0.5f));
     return std::make_tuple(cell_x, cell_z);
 }
 
+float TerrainGeometry::heightAt(float x, float z) const
+{
+    assert(m_numCols > 0 && m_numRows > 0);
+    if (m_heightMap.empty()) return 0.0f;
+    const auto dimension = getCellDimension();
+    const float fx = std::clamp((x - m_minPosition.x()) / dimension.m_width, 0.0f, static_cast<float>(m_numCols));
+    const float fz = std::clamp((z - m_minPosition.z()) / dimension.m_height, 0.0f, static_cast<float>(m_numRows));
+    const unsigned ix = std::min(static_cast<unsigned>(fx), m_numCols - 1);
+    const unsigned iz = std::min(static_cast<unsigned>(fz), m_numRows - 1);
+    const float tx = fx - static_cast<float>(ix);
+    const float tz = fz - static_cast<float>(iz);
+    const float* row0 = &m_heightMap[iz * (m_numCols + 1) + ix];
+    const float* row1 = row0 + (m_numCols + 1);
+    const float h0 = row0[0] + (row0[1] - row0[0]) * tx;
+    const float h1 = row1[0] + (row1[1] - row1[0]) * tx;
+    return h0 + (h1 - h0) * tz;
+}
+
+void TerrainGeometry::heightsAt(const std::vector<Vector3>& positions, float_buffer& heights,
+    const std::shared_ptr<Frameworks::WorkerThreadPool>& workers) const
+{
+    heights.resize(positions.size());
+    auto query_range = [&positions, &heights, this](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            heights[i] = heightAt(positions[i].x(), positions[i].z());
+        }
+    };
+    if (!workers)
+    {
+        query_range(0, positions.size());
+        return;
+    }
+    workers->parallelFor(positions.size(), query_range, MIN_PARALLEL_HEIGHT_QUERIES);
+}
+
+std::optional<float> TerrainGeometry::intersectRay(const Vector3& origin, const Vector3& direction, float max_t) const
+{
+    return m_heightPyramid.intersectRay(m_heightMap, origin, direction, max_t);
+}
+
 unsigned TerrainGeometry::convertVertexIndex(unsigned x, unsigned z) const
 {
     assert(m_numCols > 0 && m_numRows > 0);
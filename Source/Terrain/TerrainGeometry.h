@@ -9,13 +9,32 @@
 #define TERRAIN_GEOMETRY_H
 
 #include "Geometries/TriangleList.h"
+#include "TerrainChunkLayout.h"
+#include "TerrainHeightPyramid.h"
 #include "MathLib/AlgebraBasicTypes.h"
+#include "MathLib/MathGlobal.h"
+#include <memory>
+#include <optional>
+
+namespace Enigma::Frameworks
+{
+    class WorkerThreadPool;
+}
 
 namespace Enigma::Terrain
 {
     class TerrainGeometry : public Geometries::TriangleList
     {
         DECLARE_EN_RTTI;
+    public:
+        /** 頂點格子座標的矩形範圍 (含 max), 編輯器用來標記 height map 修改過的區域 */
+        struct VertexRect
+        {
+            unsigned m_minX;
+            unsigned m_minZ;
+            unsigned m_maxX;
+            unsigned m_maxZ;
+        };
     public:
         TerrainGeometry(const Geometries::GeometryId& id);
         virtual ~TerrainGeometry() override;
@@ -31,10 +50,14 @@ namespace Enigma::Terrain
         virtual std::shared_ptr<Geometries::GeometryDisassembler> disassembler() override;
         virtual void disassemble(const std::shared_ptr<Geometries::GeometryDisassembler>& disassembler) override;
 
-        void updateHeightMapToVertexMemory();
+        /** 整張地形重建時, 有 workers 就以 row 分段平行處理 */
+        void updateHeightMapToVertexMemory(const std::shared_ptr<Frameworks::WorkerThreadPool>& workers = nullptr);
         void rangedUpdateHeightMapToVertexMemory(unsigned offset, unsigned count);
-        void updateVertexNormals();
+        void rectUpdateHeightMapToVertexMemory(const VertexRect& rect);
+        void updateVertexNormals(const std::shared_ptr<Frameworks::WorkerThreadPool>& workers = nullptr);
         void rangedUpdateVertexNormals(unsigned offset, unsigned count);
+        /** 重算 rect 及外圍一圈頂點的 normal (相鄰高度改變也會影響), 回傳實際更新的範圍 */
+        VertexRect rectUpdateVertexNormals(const VertexRect& rect);
 
         MathLib::Dimension<float> getCellDimension() const;
         unsigned getNumRows() const { return m_numRows; }
@@ -50,6 +73,29 @@ namespace Enigma::Terrain
 
         std::tuple<unsigned, unsigned> locateCell(const MathLib::Vector3& position) const;
 
+        /** 地形 local space (x, z) 的高度, 以格子四角 bilinear 內插, 範圍外夾到邊上 */
+        float heightAt(float x, float z) const;
+        /** 大量物件貼地用, heights[i] = heightAt(positions[i].x, positions[i].z), 有 workers 就分段平行處理 */
+        void heightsAt(const std::vector<MathLib::Vector3>& positions, float_buffer& heights,
+            const std::shared_ptr<Frameworks::WorkerThreadPool>& workers = nullptr) const;
+        /** ray in terrain local space, 用 min/max height pyramid 找最近的格子三角形交點, 回傳 ray 的 t */
+        std::optional<float> intersectRay(const MathLib::Vector3& origin, const MathLib::Vector3& direction,
+            float max_t = MathLib::Math::MAX_FLOAT) const;
+
+        /** 0 表示整張地形一個 segment; 有 chunk layout 時 index buffer 是各 lod 共用的 pattern */
+        unsigned getChunkCells() const { return m_chunkCells; }
+        const TerrainChunkLayout& chunkLayout() const { return m_chunkLayout; }
+        TerrainChunkLayout& chunkLayout() { return m_chunkLayout; }
+
+    protected:
+        VertexRect expandVertexRect(const VertexRect& rect, unsigned border) const;
+        /** 高度改變後, 更新 chunk bounds 及 height pyramid */
+        void updateHeightBounds(const VertexRect& rect);
+        /** 只寫入 position.y, 不同的 row 可以平行寫 */
+        void writeHeightRows(unsigned min_x, unsigned max_x, unsigned min_z, unsigned max_z);
+        void writeHeightSpan(unsigned offset, unsigned count);
+        void writeNormalRows(unsigned min_x, unsigned max_x, unsigned min_z, unsigned max_z);
+
     protected:
         unsigned m_numRows;
         unsigned m_numCols;
@@ -58,6 +104,9 @@ namespace Enigma::Terrain
         MathLib::Vector2 m_minTextureCoordinate;
         MathLib::Vector2 m_maxTextureCoordinate;
         float_buffer m_heightMap;
+        unsigned m_chunkCells;
+        TerrainChunkLayout m_chunkLayout;
+        TerrainHeightPyramid m_heightPyramid;
     };
 }
 
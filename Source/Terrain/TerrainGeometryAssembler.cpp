@@ -1,6 +1,9 @@
 ﻿#include "TerrainGeometryAssembler.h"
 #include "TerrainGeometry.h"
+#include "TerrainChunkLayout.h"
 #include "MathLib/ContainmentBox3.h"
+#include "GraphicKernel/IGraphicAPI.h"
+#include "Platforms/PlatformLayer.h"
 
 using namespace Enigma::Terrain;
 using namespace Enigma::Geometries;
@@ -14,14 +17,19 @@ static std::string TOKEN_MAX_POSITION = "MaxPosition";
 static std::string TOKEN_MIN_TEXTURE_COORDINATE = "MinTextureCoordinate";
 static std::string TOKEN_MAX_TEXTURE_COORDINATE = "MaxTextureCoordinate";
 static std::string TOKEN_HEIGHT_MAP = "HeightMap";
+static std::string TOKEN_CHUNK_CELLS = "ChunkCells";
 
 unsigned calculateGeometryVertexCount(unsigned num_rows, unsigned num_cols)
 {
     return (num_rows + 1) * (num_cols + 1);
 }
 
-unsigned calculateGeometryIndexCount(unsigned num_rows, unsigned num_cols)
+unsigned calculateGeometryIndexCount(unsigned num_rows, unsigned num_cols, unsigned chunk_cells)
 {
+    if (TerrainChunkLayout::isChunkable(num_rows, num_cols, chunk_cells))
+    {
+        return TerrainChunkLayout(num_rows, num_cols, chunk_cells).patternIndexCount();
+    }
     return num_rows * num_cols * 6;
 }
 
@@ -50,6 +58,7 @@ TerrainGeometryAssembler::TerrainGeometryAssembler(const GeometryId& id) : Trian
 {
     m_factoryDesc = FactoryDesc(TerrainGeometry::TYPE_RTTI);
     m_numRows = m_numCols = 1;
+    m_chunkCells = 0;
 }
 
 GenericDto TerrainGeometryAssembler::assemble()
@@ -68,6 +77,10 @@ GenericDto TerrainGeometryAssembler::assemble()
     {
         dto.addOrUpdate(TOKEN_HEIGHT_MAP, m_heightMap.value());
     }
+    if (m_chunkCells != 0)
+    {
+        dto.addOrUpdate(TOKEN_CHUNK_CELLS, m_chunkCells);
+    }
     return dto;
 }
 
@@ -75,7 +88,7 @@ void TerrainGeometryAssembler::assembleNonVertexAttributes()
 {
     m_vtxCapacity = calculateGeometryVertexCount(m_numRows, m_numCols);
     m_vtxUsedCount = m_vtxCapacity;
-    m_idxCapacity = calculateGeometryIndexCount(m_numRows, m_numCols);
+    m_idxCapacity = calculateGeometryIndexCount(m_numRows, m_numCols, m_chunkCells);
     m_idxUsedCount = m_idxCapacity;
     m_segments = { { 0, m_vtxUsedCount, 0, m_idxUsedCount } };
     m_vertexFormat.fromString("xyz_nor_tex2(2,2)");
@@ -86,6 +99,7 @@ void TerrainGeometryAssembler::assembleNonVertexAttributes()
 TerrainGeometryDisassembler::TerrainGeometryDisassembler() : TriangleListDisassembler()
 {
     m_numRows = m_numCols = 1;
+    m_chunkCells = 0;
 }
 
 void TerrainGeometryDisassembler::disassemble(const Engine::GenericDto& dto)
@@ -98,6 +112,14 @@ void TerrainGeometryDisassembler::disassemble(const Engine::GenericDto& dto)
     if (auto v = dto.tryGetValue<Vector2>(TOKEN_MIN_TEXTURE_COORDINATE)) m_minTextureCoordinate = v.value();
     if (auto v = dto.tryGetValue<Vector2>(TOKEN_MAX_TEXTURE_COORDINATE)) m_maxTextureCoordinate = v.value();
     if (auto v = dto.tryGetValue<float_buffer>(TOKEN_HEIGHT_MAP)) m_heightMap = v.value();
+    if (auto v = dto.tryGetValue<unsigned>(TOKEN_CHUNK_CELLS)) m_chunkCells = v.value();
+    // chunk 共用的 index pattern 要用 base vertex 畫, device 不支援時改用整張 mesh 的 index;
+    // 沒有 chunk 的地形不必問 device, 離線工具跟測試可以不建 graphic api
+    if ((m_chunkCells != 0) && (!Graphics::IGraphicAPI::instance()->isBaseVertexDrawSupported()))
+    {
+        Platforms::Debug::Printf("terrain chunks need base vertex draw, fall back to single segment mesh\n");
+        m_chunkCells = 0;
+    }
     disassembleGeometryVertices();
 }
 
@@ -109,7 +131,7 @@ void TerrainGeometryDisassembler::disassembleGeometryVertices()
 
     m_vtxCapacity = calculateGeometryVertexCount(m_numRows, m_numCols);
     m_vtxUsedCount = m_vtxCapacity;
-    m_idxCapacity = calculateGeometryIndexCount(m_numRows, m_numCols);
+    m_idxCapacity = calculateGeometryIndexCount(m_numRows, m_numCols, m_chunkCells);
     m_idxUsedCount = m_idxCapacity;
     m_segments = { { 0, m_vtxUsedCount, 0, m_idxUsedCount } };
     m_position3s = std::vector<Vector3>(m_vtxUsedCount);
@@ -121,8 +143,9 @@ void TerrainGeometryDisassembler::disassembleGeometryVertices()
     {
         unsigned xi = vi % (m_numCols + 1);
         unsigned zi = vi / (m_numCols + 1);
-        float x_ratio = static_cast<float>(xi) / static_cast<float>(m_numCols + 1);
-        float z_ratio = static_cast<float>(zi) / static_cast<float>(m_numRows + 1);
+        // 最後一個頂點要落在 max position 上, 與 TerrainGeometry::getCellDimension 一致
+        float x_ratio = static_cast<float>(xi) / static_cast<float>(m_numCols);
+        float z_ratio = static_cast<float>(zi) / static_cast<float>(m_numRows);
         float height = m_heightMap ? m_heightMap.value()[vi] : 0.0f;
         m_position3s.value()[vi] = Vector3(x_ratio * terrain_size.x() + m_minPosition.x(), height, z_ratio * terrain_size.z() + m_minPosition.z());
         m_normals.value()[vi] = Vector3(0.0f, 1.0f, 0.0f);
@@ -130,18 +153,26 @@ void TerrainGeometryDisassembler::disassembleGeometryVertices()
         alpha_coords[vi] = Vector2(x_ratio, (1.0f - z_ratio));
     }
 
-    m_indices = std::vector<unsigned int>(m_idxUsedCount);
-    unsigned cell_count = m_numCols * m_numRows;
-    for (unsigned cell_i = 0; cell_i < cell_count; cell_i++)
+    if (TerrainChunkLayout::isChunkable(m_numRows, m_numCols, m_chunkCells))
+    {
+        // chunk 共用各 lod 的 index pattern, 頂點仍是整張格子
+        m_indices = TerrainChunkLayout(m_numRows, m_numCols, m_chunkCells).buildIndexPatterns();
+    }
+    else
     {
-        unsigned xi = cell_i % m_numCols;
-        unsigned zi = cell_i / m_numRows;
-        m_indices.value()[cell_i * 6] = zi * (m_numCols + 1) + xi;
-        m_indices.value()[cell_i * 6 + 1] = (zi + 1) * (m_numCols + 1) + xi;
-        m_indices.value()[cell_i * 6 + 2] = (zi + 1) * (m_numCols + 1) + xi + 1;
-        m_indices.value()[cell_i * 6 + 3] = zi * (m_numCols + 1) + xi;
-        m_indices.value()[cell_i * 6 + 4] = (zi + 1) * (m_numCols + 1) + xi + 1;
-        m_indices.value()[cell_i * 6 + 5] = zi * (m_numCols + 1) + xi + 1;
+        m_indices = std::vector<unsigned int>(m_idxUsedCount);
+        unsigned cell_count = m_numCols * m_numRows;
+        for (unsigned cell_i = 0; cell_i < cell_count; cell_i++)
+        {
+            unsigned xi = cell_i % m_numCols;
+            unsigned zi = cell_i / m_numRows;
+            m_indices.value()[cell_i * 6] = zi * (m_numCols + 1) + xi;
+            m_indices.value()[cell_i * 6 + 1] = (zi + 1) * (m_numCols + 1) + xi;
+            m_indices.value()[cell_i * 6 + 2] = (zi + 1) * (m_numCols + 1) + xi + 1;
+            m_indices.value()[cell_i * 6 + 3] = zi * (m_numCols + 1) + xi;
+            m_indices.value()[cell_i * 6 + 4] = (zi + 1) * (m_numCols + 1) + xi + 1;
+            m_indices.value()[cell_i * 6 + 5] = zi * (m_numCols + 1) + xi + 1;
+        }
     }
     m_textureCoordinates = { { tex_coords, alpha_coords } };
     m_vertexFormat.fromString("xyz_nor_tex2(2,2)");
@@ -35,6 +35,8 @@ namespace Enigma::Terrain
         void minTextureCoordinate(const MathLib::Vector2& min) { m_minTextureCoordinate = min; }
         void maxTextureCoordinate(const MathLib::Vector2& max) { m_maxTextureCoordinate = max; }
         void heightMap(const std::optional<float_buffer>& height_map) { m_heightMap = height_map; }
+        /** 0 : 不分 chunk, 整張地形一個 segment */
+        void chunkCells(unsigned cells) { m_chunkCells = cells; }
 
 
         Engine::GenericDto assemble() override;
@@ -50,6 +52,7 @@ namespace Enigma::Terrain
         MathLib::Vector2 m_minTextureCoordinate;
         MathLib::Vector2 m_maxTextureCoordinate;
         std::optional<float_buffer> m_heightMap;
+        unsigned m_chunkCells;
     };
     class TerrainGeometryDisassembler : public Geometries::TriangleListDisassembler
     {
@@ -70,6 +73,7 @@ namespace Enigma::Terrain
         [[nodiscard]] const MathLib::Vector2& minTextureCoordinate() const { return m_minTextureCoordinate; }
         [[nodiscard]] const MathLib::Vector2& maxTextureCoordinate() const { return m_maxTextureCoordinate; }
         [[nodiscard]] const std::optional<float_buffer>& heightMap() const { return m_heightMap; }
+        [[nodiscard]] unsigned chunkCells() const { return m_chunkCells; }
 
     protected:
         void disassembleGeometryVertices();
@@ -82,6 +86,7 @@ namespace Enigma::Terrain
         MathLib::Vector2 m_minTextureCoordinate;
         MathLib::Vector2 m_maxTextureCoordinate;
         std::optional<float_buffer> m_heightMap;
+        unsigned m_chunkCells;
     };
 }
 
@@ -0,0 +1,228 @@
+﻿#include "TerrainHeightPyramid.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cassert>
+
+using namespace Enigma::Terrain;
+using namespace Enigma::MathLib;
+
+static constexpr float PARALLEL_TOLERANCE = 1.0e-12f;
+
+static bool clipSlab(float origin, float direction, float lo, float hi, float& t_enter, float& t_exit)
+{
+    if (std::fabs(direction) < PARALLEL_TOLERANCE) return (origin >= lo) && (origin <= hi);
+    float t0 = (lo - origin) / direction;
+    float t1 = (hi - origin) / direction;
+    if (t0 > t1) std::swap(t0, t1);
+    t_enter = std::max(t_enter, t0);
+    t_exit = std::min(t_exit, t1);
+    return t_enter <= t_exit;
+}
+
+static std::optional<float> intersectTriangle(const Vector3& origin, const Vector3& direction, const Vector3& v0, const Vector3& v1, const Vector3& v2)
+{
+    // Moller-Trumbore, 兩面都算
+    const Vector3 edge1 = v1 - v0;
+    const Vector3 edge2 = v2 - v0;
+    const Vector3 p = direction.cross(edge2);
+    const float det = edge1.dot(p);
+    if (std::fabs(det) < PARALLEL_TOLERANCE) return std::nullopt;
+    const float inv_det = 1.0f / det;
+    const Vector3 s = origin - v0;
+    const float u = s.dot(p) * inv_det;
+    if ((u < 0.0f) || (u > 1.0f)) return std::nullopt;
+    const Vector3 q = s.cross(edge1);
+    const float v = direction.dot(q) * inv_det;
+    if ((v < 0.0f) || (u + v > 1.0f)) return std::nullopt;
+    const float t = edge2.dot(q) * inv_det;
+    if (t < 0.0f) return std::nullopt;
+    return t;
+}
+
+TerrainHeightPyramid::TerrainHeightPyramid() : m_numRows(0), m_numCols(0), m_cellWidth(1.0f), m_cellHeight(1.0f)
+{
+}
+
+void TerrainHeightPyramid::build(const float_buffer& heights, unsigned num_rows, unsigned num_cols, const Vector3& min_position,
+    float cell_width, float cell_height)
+{
+    m_levels.clear();
+    if ((num_rows == 0) || (num_cols == 0) || (heights.size() < static_cast<size_t>(num_rows + 1) * (num_cols + 1))) return;
+    m_numRows = num_rows;
+    m_numCols = num_cols;
+    m_minPosition = min_position;
+    m_cellWidth = cell_width;
+    m_cellHeight = cell_height;
+    unsigned width = num_cols;
+    unsigned height = num_rows;
+    while (true)
+    {
+        m_levels.push_back({ width, height, std::vector<float>(static_cast<size_t>(width) * height),
+            std::vector<float>(static_cast<size_t>(width) * height) });
+        if ((width == 1) && (height == 1)) break;
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+    update(heights, 0, 0, num_cols, num_rows);
+}
+
+void TerrainHeightPyramid::update(const float_buffer& heights, unsigned min_x, unsigned min_z, unsigned max_x, unsigned max_z)
+{
+    if (!isBuilt()) return;
+    // 頂點 (x, z) 是格子 (x - 1 ~ x, z - 1 ~ z) 的角
+    unsigned min_cx = min_x > 0 ? min_x - 1 : 0;
+    unsigned min_cz = min_z > 0 ? min_z - 1 : 0;
+    unsigned max_cx = std::min(max_x, m_numCols - 1);
+    unsigned max_cz = std::min(max_z, m_numRows - 1);
+    if ((min_cx > max_cx) || (min_cz > max_cz)) return;
+    updateCells(heights, min_cx, min_cz, max_cx, max_cz);
+    for (unsigned level = 1; level < m_levels.size(); level++)
+    {
+        min_cx >>= 1;
+        min_cz >>= 1;
+        max_cx >>= 1;
+        max_cz >>= 1;
+        updateLevel(level, min_cx, min_cz, max_cx, max_cz);
+    }
+}
+
+std::optional<float> TerrainHeightPyramid::intersectRay(const float_buffer& heights, const Vector3& origin, const Vector3& direction,
+    float max_t) const
+{
+    if (!isBuilt()) return std::nullopt;
+    struct Node
+    {
+        unsigned m_level;
+        unsigned m_x;
+        unsigned m_z;
+        float m_tEnter;
+    };
+    std::vector<Node> stack;
+    stack.reserve(m_levels.size() * 4);
+    float t_enter = 0.0f;
+    float t_exit = max_t;
+    const unsigned top = static_cast<unsigned>(m_levels.size()) - 1;
+    if (!intersectNodeBox(top, 0, 0, origin, direction, t_enter, t_exit)) return std::nullopt;
+    stack.push_back({ top, 0, 0, t_enter });
+
+    std::optional<float> nearest;
+    float nearest_t = max_t;
+    while (!stack.empty())
+    {
+        const Node node = stack.back();
+        stack.pop_back();
+        if (node.m_tEnter > nearest_t) continue;
+        if (node.m_level == 0)
+        {
+            if (auto t = intersectCell(heights, node.m_x, node.m_z, origin, direction); t && (t.value() <= nearest_t))
+            {
+                nearest = t;
+                nearest_t = t.value();
+            }
+            continue;
+        }
+        const Level& child_level = m_levels[node.m_level - 1];
+        std::array<Node, 4> children;
+        unsigned child_count = 0;
+        for (unsigned dz = 0; dz < 2; dz++)
+        {
+            for (unsigned dx = 0; dx < 2; dx++)
+            {
+                const unsigned cx = node.m_x * 2 + dx;
+                const unsigned cz = node.m_z * 2 + dz;
+                if ((cx >= child_level.m_width) || (cz >= child_level.m_height)) continue;
+                float child_enter = 0.0f;
+                float child_exit = nearest_t;
+                if (!intersectNodeBox(node.m_level - 1, cx, cz, origin, direction, child_enter, child_exit)) continue;
+                children[child_count++] = { node.m_level - 1, cx, cz, child_enter };
+            }
+        }
+        // 遠的先進 stack, 近的先處理, 找到交點後更遠的 node 就可以跳過
+        std::sort(children.begin(), children.begin() + child_count, [](const Node& a, const Node& b) { return a.m_tEnter > b.m_tEnter; });
+        stack.insert(stack.end(), children.begin(), children.begin() + child_count);
+    }
+    return nearest;
+}
+
+void TerrainHeightPyramid::updateCells(const float_buffer& heights, unsigned min_cx, unsigned min_cz, unsigned max_cx, unsigned max_cz)
+{
+    Level& cells = m_levels[0];
+    const unsigned stride = m_numCols + 1;
+    for (unsigned z = min_cz; z <= max_cz; z++)
+    {
+        for (unsigned x = min_cx; x <= max_cx; x++)
+        {
+            const float h00 = heights[z * stride + x];
+            const float h10 = heights[z * stride + x + 1];
+            const float h01 = heights[(z + 1) * stride + x];
+            const float h11 = heights[(z + 1) * stride + x + 1];
+            cells.m_minHeights[z * cells.m_width + x] = std::min({ h00, h10, h01, h11 });
+            cells.m_maxHeights[z * cells.m_width + x] = std::max({ h00, h10, h01, h11 });
+        }
+    }
+}
+
+void TerrainHeightPyramid::updateLevel(unsigned level, unsigned min_x, unsigned min_z, unsigned max_x, unsigned max_z)
+{
+    assert(level > 0);
+    const Level& src = m_levels[level - 1];
+    Level& dst = m_levels[level];
+    max_x = std::min(max_x, dst.m_width - 1);
+    max_z = std::min(max_z, dst.m_height - 1);
+    for (unsigned z = min_z; z <= max_z; z++)
+    {
+        for (unsigned x = min_x; x <= max_x; x++)
+        {
+            float min_height = src.m_minHeights[(z * 2) * src.m_width + x * 2];
+            float max_height = src.m_maxHeights[(z * 2) * src.m_width + x * 2];
+            for (unsigned sz = z * 2; sz < std::min(z * 2 + 2, src.m_height); sz++)
+            {
+                for (unsigned sx = x * 2; sx < std::min(x * 2 + 2, src.m_width); sx++)
+                {
+                    min_height = std::min(min_height, src.m_minHeights[sz * src.m_width + sx]);
+                    max_height = std::max(max_height, src.m_maxHeights[sz * src.m_width + sx]);
+                }
+            }
+            dst.m_minHeights[z * dst.m_width + x] = min_height;
+            dst.m_maxHeights[z * dst.m_width + x] = max_height;
+        }
+    }
+}
+
+bool TerrainHeightPyramid::intersectNodeBox(unsigned level, unsigned x, unsigned z, const Vector3& origin, const Vector3& direction,
+    float& t_enter, float& t_exit) const
+{
+    const Level& nodes = m_levels[level];
+    const unsigned cell_min_x = x << level;
+    const unsigned cell_min_z = z << level;
+    const unsigned cell_max_x = std::min((x + 1) << level, m_numCols);
+    const unsigned cell_max_z = std::min((z + 1) << level, m_numRows);
+    const float lo_x = m_minPosition.x() + static_cast<float>(cell_min_x) * m_cellWidth;
+    const float hi_x = m_minPosition.x() + static_cast<float>(cell_max_x) * m_cellWidth;
+    const float lo_z = m_minPosition.z() + static_cast<float>(cell_min_z) * m_cellHeight;
+    const float hi_z = m_minPosition.z() + static_cast<float>(cell_max_z) * m_cellHeight;
+    return clipSlab(origin.x(), direction.x(), std::min(lo_x, hi_x), std::max(lo_x, hi_x), t_enter, t_exit)
+        && clipSlab(origin.z(), direction.z(), std::min(lo_z, hi_z), std::max(lo_z, hi_z), t_enter, t_exit)
+        && clipSlab(origin.y(), direction.y(), nodes.m_minHeights[z * nodes.m_width + x], nodes.m_maxHeights[z * nodes.m_width + x], t_enter, t_exit);
+}
+
+std::optional<float> TerrainHeightPyramid::intersectCell(const float_buffer& heights, unsigned x, unsigned z, const Vector3& origin,
+    const Vector3& direction) const
+{
+    const unsigned stride = m_numCols + 1;
+    auto vertex = [&](unsigned vx, unsigned vz)
+    {
+        return Vector3(m_minPosition.x() + static_cast<float>(vx) * m_cellWidth, heights[vz * stride + vx],
+            m_minPosition.z() + static_cast<float>(vz) * m_cellHeight);
+    };
+    // 與 TerrainGeometryDisassembler 的格子三角形一致, 對角線是 (x, z) - (x + 1, z + 1)
+    const Vector3 v00 = vertex(x, z);
+    const Vector3 v01 = vertex(x, z + 1);
+    const Vector3 v11 = vertex(x + 1, z + 1);
+    const Vector3 v10 = vertex(x + 1, z);
+    const auto t0 = intersectTriangle(origin, direction, v00, v01, v11);
+    const auto t1 = intersectTriangle(origin, direction, v00, v11, v10);
+    if (t0 && t1) return std::min(t0.value(), t1.value());
+    return t0 ? t0 : t1;
+}
@@ -0,0 +1,63 @@
+﻿/*********************************************************************
+ * \file   TerrainHeightPyramid.h
+ * \brief  min/max height pyramid over terrain cells, for ray queries
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TERRAIN_HEIGHT_PYRAMID_H
+#define TERRAIN_HEIGHT_PYRAMID_H
+
+#include "Frameworks/ExtentTypesDefine.h"
+#include "MathLib/Vector3.h"
+#include <vector>
+#include <optional>
+
+namespace Enigma::Terrain
+{
+    /** level 0 每個格子存四個角的最小/最大高度, 之後每層合併 2x2, 直到只剩一格.
+     ray 從最上層往下走, 只進入 ray 穿過的 (min, max) box, 由近到遠, 到 level 0 才測格子的兩個三角形 */
+    class TerrainHeightPyramid
+    {
+    public:
+        TerrainHeightPyramid();
+
+        /** cell_width / cell_height : 格子在 x / z 方向的大小 */
+        void build(const float_buffer& heights, unsigned num_rows, unsigned num_cols, const MathLib::Vector3& min_position,
+            float cell_width, float cell_height);
+        /** height map 的矩形範圍 (頂點座標, 含 max) 改變後, 重算涵蓋到的格子及上層 */
+        void update(const float_buffer& heights, unsigned min_x, unsigned min_z, unsigned max_x, unsigned max_z);
+
+        bool isBuilt() const { return !m_levels.empty(); }
+        unsigned levelCount() const { return static_cast<unsigned>(m_levels.size()); }
+
+        /** ray in terrain local space, direction 不需要單位長度; 回傳最近交點的 t (0 <= t <= max_t) */
+        std::optional<float> intersectRay(const float_buffer& heights, const MathLib::Vector3& origin, const MathLib::Vector3& direction,
+            float max_t) const;
+
+    protected:
+        struct Level
+        {
+            unsigned m_width;
+            unsigned m_height;
+            std::vector<float> m_minHeights;
+            std::vector<float> m_maxHeights;
+        };
+        void updateCells(const float_buffer& heights, unsigned min_cx, unsigned min_cz, unsigned max_cx, unsigned max_cz);
+        void updateLevel(unsigned level, unsigned min_x, unsigned min_z, unsigned max_x, unsigned max_z);
+        bool intersectNodeBox(unsigned level, unsigned x, unsigned z, const MathLib::Vector3& origin, const MathLib::Vector3& direction,
+            float& t_enter, float& t_exit) const;
+        std::optional<float> intersectCell(const float_buffer& heights, unsigned x, unsigned z, const MathLib::Vector3& origin,
+            const MathLib::Vector3& direction) const;
+
+    protected:
+        unsigned m_numRows;
+        unsigned m_numCols;
+        MathLib::Vector3 m_minPosition;
+        float m_cellWidth;
+        float m_cellHeight;
+        std::vector<Level> m_levels;
+    };
+}
+
+#endif // TERRAIN_HEIGHT_PYRAMID_H
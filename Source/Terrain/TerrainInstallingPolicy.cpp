@@ -6,6 +6,8 @@
 #include "Primitives/PrimitiveCommands.h"
 #include "SceneGraph/SceneGraphRepository.h"
 #include "TerrainPrimitive.h"
+#include "TerrainPrimitiveRay3IntersectionFinder.h"
+#include "Primitives/PrimitiveIntersectionFinderFactories.h"
 #include <cassert>
 #include <system_error>
 
@@ -16,6 +18,7 @@ error TerrainInstallingPolicy::install(Frameworks::ServiceManager* service_manag
     assert(service_manager);
     std::make_shared<Geometries::RegisterGeometryFactory>(TerrainGeometry::TYPE_RTTI.getName(), TerrainGeometry::create)->execute();
     std::make_shared<Enigma::Primitives::RegisterPrimitiveFactory>(TerrainPrimitive::TYPE_RTTI.getName(), TerrainPrimitive::create)->execute();
+    Primitives::PrimitiveRay3IntersectionFinderFactory::registerCreator(TerrainPrimitive::TYPE_RTTI.getName(), TerrainPrimitiveRay3IntersectionFinder::create);
     const auto scene_graph_repository = service_manager->getSystemServiceAs<SceneGraph::SceneGraphRepository>();
     assert(scene_graph_repository);
     scene_graph_repository->registerSpatialFactory(TerrainPawn::TYPE_RTTI.getName(), TerrainPawn::create);
@@ -1,19 +1,25 @@
 ﻿#include "TerrainPrimitive.h"
 #include "TerrainPrimitiveAssembler.h"
+#include "TerrainGeometry.h"
+#include "Renderables/RenderableErrors.h"
+#include "Platforms/PlatformLayer.h"
 
 using namespace Enigma::Terrain;
 using namespace Enigma::Renderer;
+using namespace Enigma::Renderables;
 
 DEFINE_RTTI(Terrain, TerrainPrimitive, MeshPrimitive);
 
-TerrainPrimitive::TerrainPrimitive(const Primitives::PrimitiveId& id) : MeshPrimitive(id)
+static constexpr float DEFAULT_LOD_BASE_DISTANCE = 64.0f;
+
+TerrainPrimitive::TerrainPrimitive(const Primitives::PrimitiveId& id) : MeshPrimitive(id), m_lodBaseDistance(DEFAULT_LOD_BASE_DISTANCE)
 {
     m_factoryDesc = Engine::FactoryDesc(TerrainPrimitive::TYPE_RTTI.getName()).claimAsInstanced(id.name() + ".terrain");
 }
 
 TerrainPrimitive::~TerrainPrimitive()
 {
-
+    m_chunkElements.clear();
 }
 
 std::shared_ptr<TerrainPrimitive> TerrainPrimitive::create(const Primitives::PrimitiveId& id)
@@ -31,3 +37,83 @@ std::shared_ptr<Enigma::Primitives::PrimitiveDisassembler> TerrainPrimitive::dis
     return std::make_shared<TerrainPrimitiveDisassembler>();
 }
 
+error TerrainPrimitive::insertToRendererWithTransformUpdating(const std::shared_ptr<Engine::IRenderer>& renderer,
+    const MathLib::Matrix4& mxWorld, const Engine::RenderLightingState& lightingState)
+{
+    const auto terrain_geometry = std::dynamic_pointer_cast<TerrainGeometry>(m_geometry);
+    if ((!terrain_geometry) || (!terrain_geometry->chunkLayout().isValid()))
+    {
+        return MeshPrimitive::insertToRendererWithTransformUpdating(renderer, mxWorld, lightingState);
+    }
+    if (!m_lazyStatus.isReady()) return ErrorCode::ok;
+    const auto render = std::dynamic_pointer_cast<Renderer::Renderer, Engine::IRenderer>(renderer);
+    if (FATAL_LOG_EXPR(!render)) return ErrorCode::nullRenderer;
+    m_mxPrimitiveWorld = mxWorld;
+    if (testPrimitiveFlag(Primitive_UnRenderable)) return ErrorCode::ok;
+    if (FATAL_LOG_EXPR(m_elements.empty())) return ErrorCode::emptyRenderElementList;
+
+    TerrainChunkLayout& layout = terrain_geometry->chunkLayout();
+    if ((m_chunkElementSource.lock() != m_elements.front()) || (m_chunkElements.size() != layout.chunkCount()))
+    {
+        m_chunkElements.assign(layout.chunkCount(), nullptr);
+        m_chunkElementLods.assign(layout.chunkCount(), TerrainChunkLayout::ChunkLod{ 0, 0 });
+        m_chunkElementSource = m_elements.front();
+    }
+    m_chunkStatistics = ChunkStatistics{};
+    // 沒有被放進這個 frame 的 chunk element, renderer 會在 frame 結束時清掉
+    error er = ErrorCode::ok;
+    for (const auto& selection : selectChunks(render, layout, mxWorld))
+    {
+        er = render->insertRenderElement(chunkElement(layout, selection), mxWorld, lightingState, m_renderListID);
+        if (er) return er;
+        m_chunkStatistics.m_visibleChunkCount++;
+        m_chunkStatistics.m_drawnTriangleCount += layout.patternTriangleCount(selection.m_lod, selection.m_stitchMask);
+    }
+    return er;
+}
+
+error TerrainPrimitive::removeFromRenderer(const std::shared_ptr<Engine::IRenderer>& renderer)
+{
+    if (m_chunkElements.empty()) return MeshPrimitive::removeFromRenderer(renderer);
+    const auto render = std::dynamic_pointer_cast<Renderer::Renderer, Engine::IRenderer>(renderer);
+    if (FATAL_LOG_EXPR(!render)) return ErrorCode::nullRenderer;
+    for (auto& ele : m_chunkElements)
+    {
+        if (ele) render->removeRenderElement(ele, m_renderListID);
+    }
+    return ErrorCode::ok;
+}
+
+std::vector<TerrainChunkLayout::Selection> TerrainPrimitive::selectChunks(const std::shared_ptr<Renderer::Renderer>& render,
+    TerrainChunkLayout& layout, const MathLib::Matrix4& mxWorld) const
+{
+    const auto camera = render->associatedCamera();
+    if (!camera)
+    {
+        // 沒有 camera 可以選 lod, 全部用最細的 lod
+        std::vector<TerrainChunkLayout::Selection> selections(layout.chunkCount());
+        for (unsigned chunk = 0; chunk < layout.chunkCount(); chunk++)
+        {
+            selections[chunk] = { chunk, 0, 0 };
+        }
+        return selections;
+    }
+    // 在 terrain local space 裡選, chunk bounds 不必轉換
+    const MathLib::Vector3 local_view_position = mxWorld.Inverse().TransformCoord(camera->location());
+    const MathLib::Matrix4 mx_local_view_proj = camera->projectionTransform() * camera->viewTransform() * mxWorld;
+    return layout.selectChunks(local_view_position, mx_local_view_proj, m_lodBaseDistance);
+}
+
+const std::shared_ptr<RenderElement>& TerrainPrimitive::chunkElement(const TerrainChunkLayout& layout, const TerrainChunkLayout::Selection& selection)
+{
+    auto& element = m_chunkElements[selection.m_chunk];
+    auto& element_lod = m_chunkElementLods[selection.m_chunk];
+    if ((!element) || (element_lod.m_lod != selection.m_lod) || (element_lod.m_stitchMask != selection.m_stitchMask))
+    {
+        // 換 lod 時舊的 element 不再放入 renderer, 會被 flush 掉
+        element = std::make_shared<RenderElement>(m_renderBuffer, m_elements.front()->getEffectMaterial(),
+            layout.chunkSegment(selection.m_chunk, selection.m_lod, selection.m_stitchMask));
+        element_lod = { selection.m_lod, selection.m_stitchMask };
+    }
+    return element;
+}
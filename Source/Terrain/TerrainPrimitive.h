@@ -9,12 +9,23 @@
 #define TERRAIN_PRIMITIVE_H
 
 #include "Renderables/MeshPrimitive.h"
+#include "TerrainChunkLayout.h"
 
 namespace Enigma::Terrain
 {
+    using error = std::error_code;
+
+    /** geometry 有 chunk layout 時, 每個 frame 依 renderer 的 camera 選出可見 chunk 及各自的 lod,
+     只放這些 chunk 的 render element; 否則跟一般 mesh 一樣整張畫 */
     class TerrainPrimitive : public Renderables::MeshPrimitive
     {
         DECLARE_EN_RTTI;
+    public:
+        struct ChunkStatistics
+        {
+            unsigned m_visibleChunkCount = 0;
+            unsigned m_drawnTriangleCount = 0;
+        };
     public:
         TerrainPrimitive(const Primitives::PrimitiveId& id);
         virtual ~TerrainPrimitive() override;
@@ -27,6 +38,29 @@ namespace Enigma::Terrain
 
         virtual std::shared_ptr<Primitives::PrimitiveAssembler> assembler() const override;
         virtual std::shared_ptr<Primitives::PrimitiveDisassembler> disassembler() const override;
+
+        virtual error insertToRendererWithTransformUpdating(const std::shared_ptr<Engine::IRenderer>& renderer,
+            const MathLib::Matrix4& mxWorld, const Engine::RenderLightingState& lightingState) override;
+        virtual error removeFromRenderer(const std::shared_ptr<Engine::IRenderer>& renderer) override;
+
+        /** lod 0 的距離範圍 (terrain local space), 之後每個 lod 的距離加倍 */
+        void lodBaseDistance(float distance) { m_lodBaseDistance = distance; }
+        float lodBaseDistance() const { return m_lodBaseDistance; }
+        const ChunkStatistics& chunkStatistics() const { return m_chunkStatistics; }
+
+    protected:
+        std::vector<TerrainChunkLayout::Selection> selectChunks(const std::shared_ptr<Renderer::Renderer>& render,
+            TerrainChunkLayout& layout, const MathLib::Matrix4& mxWorld) const;
+        const std::shared_ptr<Renderer::RenderElement>& chunkElement(const TerrainChunkLayout& layout, const TerrainChunkLayout::Selection& selection);
+
+    protected:
+        float m_lodBaseDistance;
+        /// 每個 chunk 最近一次用的 element, lod / stitch 改變才重建
+        std::vector<std::shared_ptr<Renderer::RenderElement>> m_chunkElements;
+        std::vector<TerrainChunkLayout::ChunkLod> m_chunkElementLods;
+        /// chunk element 是照這個 mesh element 的 render buffer & effect 建的, mesh element 重建時要跟著清掉
+        std::weak_ptr<Renderer::RenderElement> m_chunkElementSource;
+        ChunkStatistics m_chunkStatistics;
     };
 }
 
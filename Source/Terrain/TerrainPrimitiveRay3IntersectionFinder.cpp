@@ -0,0 +1,53 @@
+﻿#include "TerrainPrimitiveRay3IntersectionFinder.h"
+#include "TerrainPrimitive.h"
+#include "TerrainGeometry.h"
+
+using namespace Enigma::Terrain;
+using namespace Enigma::MathLib;
+using namespace Enigma::Primitives;
+
+TerrainPrimitiveRay3IntersectionFinder::TerrainPrimitiveRay3IntersectionFinder()
+{
+}
+
+TerrainPrimitiveRay3IntersectionFinder::~TerrainPrimitiveRay3IntersectionFinder()
+{
+}
+
+PrimitiveRay3IntersectionFinder* TerrainPrimitiveRay3IntersectionFinder::create()
+{
+    return new TerrainPrimitiveRay3IntersectionFinder();
+}
+
+Intersector::Result TerrainPrimitiveRay3IntersectionFinder::test(const std::shared_ptr<Primitive>& primitive, const Ray3& ray,
+    std::unique_ptr<IntersectorCache> cache) const
+{
+    auto terrain = std::dynamic_pointer_cast<TerrainPrimitive>(primitive);
+    if (!terrain) return { false, std::move(cache) };
+    return { intersectTerrain(terrain, ray).has_value(), std::move(cache) };
+}
+
+std::tuple<std::vector<IntrPrimitiveRay3::ResultRecord>, Intersector::Result> TerrainPrimitiveRay3IntersectionFinder::find(
+    const std::shared_ptr<Primitive>& primitive, const Ray3& ray, std::unique_ptr<IntersectorCache> cache) const
+{
+    std::vector<IntrPrimitiveRay3::ResultRecord> records;
+    auto terrain = std::dynamic_pointer_cast<TerrainPrimitive>(primitive);
+    if (!terrain) return { records, Intersector::Result(false, std::move(cache)) };
+    auto t = intersectTerrain(terrain, ray);
+    if (t)
+    {
+        records.emplace_back(IntrPrimitiveRay3::ResultRecord(t.value(), t.value() * ray.direction() + ray.origin(), terrain));
+    }
+    return { records, Intersector::Result(t.has_value(), std::move(cache)) };
+}
+
+std::optional<float> TerrainPrimitiveRay3IntersectionFinder::intersectTerrain(const std::shared_ptr<TerrainPrimitive>& terrain, const Ray3& ray) const
+{
+    auto geometry = std::dynamic_pointer_cast<TerrainGeometry>(terrain->getGeometryData());
+    if (!geometry) return std::nullopt;
+    // 不正規化 local direction, local 的 t 就等於 world ray 的 t
+    const Matrix4 inv_world = terrain->getPrimitiveWorldTransform().Inverse();
+    const Vector3 local_origin = inv_world.TransformCoord(ray.origin());
+    const Vector3 local_direction = inv_world.TransformVector(ray.direction());
+    return geometry->intersectRay(local_origin, local_direction);
+}
@@ -0,0 +1,41 @@
+﻿/*********************************************************************
+ * \file   TerrainPrimitiveRay3IntersectionFinder.h
+ * \brief  ray picking on terrain through height pyramid, instead of
+ *          walking all triangles of the mesh
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TERRAIN_PRIMITIVE_RAY3_INTERSECTION_FINDER_H
+#define TERRAIN_PRIMITIVE_RAY3_INTERSECTION_FINDER_H
+
+#include "MathLib/Intersector.h"
+#include "MathLib/Ray3.h"
+#include "Primitives/PrimitiveRay3IntersectionFinder.h"
+#include "Primitives/Primitive.h"
+#include <optional>
+
+namespace Enigma::Terrain
+{
+    class TerrainPrimitive;
+
+    class TerrainPrimitiveRay3IntersectionFinder : public Primitives::PrimitiveRay3IntersectionFinder
+    {
+    public:
+        TerrainPrimitiveRay3IntersectionFinder();
+        virtual ~TerrainPrimitiveRay3IntersectionFinder() override;
+
+        static Primitives::PrimitiveRay3IntersectionFinder* create();
+
+        virtual MathLib::Intersector::Result test(const std::shared_ptr<Primitives::Primitive>& primitive, const MathLib::Ray3& ray, std::unique_ptr<MathLib::IntersectorCache> cache) const override;
+        /** 只回傳最近的交點 */
+        virtual std::tuple<std::vector<Primitives::IntrPrimitiveRay3::ResultRecord>, MathLib::Intersector::Result>
+            find(const std::shared_ptr<Primitives::Primitive>& primitive, const MathLib::Ray3& ray, std::unique_ptr<MathLib::IntersectorCache> cache) const override;
+
+    private:
+        /** t in ray parameter of the world space ray */
+        std::optional<float> intersectTerrain(const std::shared_ptr<TerrainPrimitive>& terrain, const MathLib::Ray3& ray) const;
+    };
+}
+
+#endif // TERRAIN_PRIMITIVE_RAY3_INTERSECTION_FINDER_H
@@ -0,0 +1,321 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "AssetPackage/AssetBlockCodec.h"
+#include "AssetPackage/AssetPackageFile.h"
+#include "AssetPackage/AssetPackageFormat.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::AssetPackage;
+
+namespace SceneGraphTest
+{
+    /** block codec 測試用的暫存目錄, 結束時整個刪掉 */
+    class BlockCodecScratchDir
+    {
+    public:
+        explicit BlockCodecScratchDir(const std::string& name) : m_dir(std::filesystem::temp_directory_path() / ("EnigmaAssetBlockCodecTest_" + name))
+        {
+            std::filesystem::remove_all(m_dir);
+            std::filesystem::create_directories(m_dir);
+        }
+        ~BlockCodecScratchDir()
+        {
+            std::error_code er;
+            std::filesystem::remove_all(m_dir, er);
+        }
+        std::string basefilename(const std::string& name) const { return (m_dir / name).string(); }
+
+    private:
+        std::filesystem::path m_dir;
+    };
+
+    TEST_CLASS(AssetBlockCodecTest)
+    {
+    public:
+        TEST_METHOD(TestLz4RoundTrip)
+        {
+            const std::vector<size_t> sizes{ 1, 12, 13, 100, 4096, AssetPackageFile::ASSET_BLOCK_SIZE };
+            for (size_t size : sizes)
+            {
+                const auto random_block = makeRandomBytes(static_cast<unsigned>(size), size);
+                const std::vector<unsigned char> zero_block(size, 0);
+                const auto text_block = makeRepeatedText(size);
+                for (const auto* block : { &random_block, &zero_block, &text_block })
+                {
+                    std::vector<unsigned char> comp(AssetBlockCodec::lz4CompressBound(size));
+                    const size_t comp_size = AssetBlockCodec::lz4Compress(block->data(), size, comp.data(), comp.size());
+                    Assert::IsTrue(comp_size > 0);
+                    Assert::IsTrue(comp_size <= comp.size());
+                    std::vector<unsigned char> out(size, 0xcd);
+                    Assert::IsTrue(AssetBlockCodec::lz4Decompress(comp.data(), comp_size, out.data(), out.size()));
+                    Assert::IsTrue(out == *block);
+                }
+            }
+            // 全零跟重複文字要真的壓得小
+            const std::vector<unsigned char> zero_block(AssetPackageFile::ASSET_BLOCK_SIZE, 0);
+            Assert::IsTrue(AssetBlockCodec::compressBlock(AssetCodec::lz4, zero_block.data(), zero_block.size()).size() < zero_block.size() / 100);
+            const auto text_block = makeRepeatedText(AssetPackageFile::ASSET_BLOCK_SIZE);
+            Assert::IsTrue(AssetBlockCodec::compressBlock(AssetCodec::lz4, text_block.data(), text_block.size()).size() < text_block.size() / 4);
+        }
+
+        TEST_METHOD(TestIncompressibleBlockIsLeftEmpty)
+        {
+            const auto random_block = makeRandomBytes(7, AssetPackageFile::ASSET_BLOCK_SIZE);
+            Assert::IsTrue(AssetBlockCodec::compressBlock(AssetCodec::lz4, random_block.data(), random_block.size()).empty());
+            Assert::IsTrue(AssetBlockCodec::compressBlock(AssetCodec::zlib, random_block.data(), random_block.size()).empty());
+            // dst 空間小於 bound 時不壓縮
+            std::vector<unsigned char> comp(AssetBlockCodec::lz4CompressBound(random_block.size()) - 1);
+            Assert::AreEqual(static_cast<size_t>(0), AssetBlockCodec::lz4Compress(random_block.data(), random_block.size(), comp.data(), comp.size()));
+        }
+
+        TEST_METHOD(TestCorruptInputIsRejected)
+        {
+            const auto text_block = makeRepeatedText(4096);
+            std::vector<unsigned char> comp(AssetBlockCodec::lz4CompressBound(text_block.size()));
+            comp.resize(AssetBlockCodec::lz4Compress(text_block.data(), text_block.size(), comp.data(), comp.size()));
+            std::vector<unsigned char> out(text_block.size());
+            Assert::IsTrue(AssetBlockCodec::lz4Decompress(comp.data(), comp.size(), out.data(), out.size()));
+
+            // 截短的資料
+            Assert::IsFalse(AssetBlockCodec::lz4Decompress(comp.data(), comp.size() - 1, out.data(), out.size()));
+            Assert::IsFalse(AssetBlockCodec::lz4Decompress(comp.data(), comp.size() / 2, out.data(), out.size()));
+            // 輸出大小不符
+            std::vector<unsigned char> small_out(text_block.size() - 1);
+            Assert::IsFalse(AssetBlockCodec::lz4Decompress(comp.data(), comp.size(), small_out.data(), small_out.size()));
+            std::vector<unsigned char> large_out(text_block.size() + 1);
+            Assert::IsFalse(AssetBlockCodec::lz4Decompress(comp.data(), comp.size(), large_out.data(), large_out.size()));
+
+            // 手工 sequence : 1 個 literal 'a', match offset 指到輸出開頭之前
+            const unsigned char bad_offset[] = { 0x10, 'a', 0x05, 0x00, 0x00 };
+            std::vector<unsigned char> seq_out(1 + 4 + 5);
+            Assert::IsFalse(AssetBlockCodec::lz4Decompress(bad_offset, sizeof(bad_offset), seq_out.data(), seq_out.size()));
+            const unsigned char zero_offset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+            Assert::IsFalse(AssetBlockCodec::lz4Decompress(zero_offset, sizeof(zero_offset), seq_out.data(), seq_out.size()));
+            // literal 長度超過輸入
+            const unsigned char long_literal[] = { 0x50, 'a', 'b' };
+            Assert::IsFalse(AssetBlockCodec::lz4Decompress(long_literal, sizeof(long_literal), seq_out.data(), seq_out.size()));
+
+            // 亂數資料不管怎樣都不能寫出界, 結果只能是 false 或剛好填滿
+            for (unsigned seed = 0; seed < 64; seed++)
+            {
+                const auto garbage = makeRandomBytes(seed, 64 + seed);
+                std::vector<unsigned char> garbage_out(256);
+                AssetBlockCodec::lz4Decompress(garbage.data(), garbage.size(), garbage_out.data(), garbage_out.size());
+            }
+
+            auto zlib_comp = AssetBlockCodec::compressBlock(AssetCodec::zlib, text_block.data(), text_block.size());
+            Assert::IsFalse(zlib_comp.empty());
+            Assert::IsTrue(AssetBlockCodec::decompressBlock(AssetCodec::zlib, zlib_comp.data(), zlib_comp.size(), out.data(), out.size()));
+            Assert::IsFalse(AssetBlockCodec::decompressBlock(AssetCodec::zlib, zlib_comp.data(), zlib_comp.size(), small_out.data(), small_out.size()));
+            Assert::IsFalse(AssetBlockCodec::decompressBlock(AssetCodec::zlib, zlib_comp.data(), zlib_comp.size(), large_out.data(), large_out.size()));
+            zlib_comp[zlib_comp.size() / 2] ^= 0xff;
+            zlib_comp.back() ^= 0xff;
+            Assert::IsFalse(AssetBlockCodec::decompressBlock(AssetCodec::zlib, zlib_comp.data(), zlib_comp.size(), out.data(), out.size()));
+        }
+
+        TEST_METHOD(TestStoredRawBlocks)
+        {
+            const auto random_block = makeRandomBytes(11, 1000);
+            std::vector<unsigned char> out(random_block.size());
+            const unsigned int raw_entry = static_cast<unsigned int>(random_block.size()) | AssetBlockCodec::STORED_RAW_FLAG;
+            Assert::IsTrue(AssetBlockCodec::decompressStoredBlock(AssetCodec::lz4, raw_entry, random_block.data(), out.data(), out.size()));
+            Assert::IsTrue(out == random_block);
+            Assert::IsTrue(AssetBlockCodec::decompressStoredBlock(AssetCodec::zlib, raw_entry, random_block.data(), out.data(), out.size()));
+            Assert::IsTrue(out == random_block);
+            // 原始資料的 block 大小一定要等於輸出大小
+            Assert::IsFalse(AssetBlockCodec::decompressStoredBlock(AssetCodec::lz4, raw_entry, random_block.data(), out.data(), out.size() - 1));
+
+            // package 裡壓不小的 block 要標成原始資料, 壓得小的不標
+            BlockCodecScratchDir scratch{ "StoredRaw" };
+            const std::string name = scratch.basefilename("pkg");
+            const unsigned int block_size = AssetPackageFile::ASSET_BLOCK_SIZE;
+            std::vector<char> content(block_size * 3 + 100);
+            const auto random_bytes = makeRandomBytes(13, block_size);
+            const auto text_bytes = makeRepeatedText(block_size);
+            for (size_t i = 0; i < content.size(); i++)
+            {
+                const size_t block = i / block_size;
+                content[i] = static_cast<char>((block % 2 == 0) ? random_bytes[i % block_size] : text_bytes[i % block_size]);
+            }
+            for (AssetCodec codec : { AssetCodec::zlib, AssetCodec::lz4 })
+            {
+                std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::createNewPackage(name + std::to_string(static_cast<unsigned>(codec))) };
+                Assert::IsFalse(static_cast<bool>(package->addAssetMemory(content, "mixed", 1, codec)));
+                auto header_data = package->tryGetAssetHeaderData("mixed");
+                Assert::IsTrue(header_data.has_value());
+                Assert::AreEqual(static_cast<unsigned int>(codec), header_data->m_codec);
+                const auto table = readBlockTable(package->getBaseFilename(), header_data->m_offset, 4);
+                Assert::AreEqual(block_size, table[0]);
+                Assert::AreEqual(4u, table[1]);
+                Assert::AreEqual(block_size | AssetBlockCodec::STORED_RAW_FLAG, table[2]);
+                Assert::IsTrue((table[3] & AssetBlockCodec::STORED_RAW_FLAG) == 0);
+                Assert::AreEqual(block_size | AssetBlockCodec::STORED_RAW_FLAG, table[4]);
+                auto retrieved = package->tryRetrieveAssetToMemory("mixed");
+                Assert::IsTrue(retrieved.has_value());
+                Assert::IsTrue(retrieved.value() == content);
+            }
+        }
+
+        TEST_METHOD(TestRangeAcrossBlockBoundaries)
+        {
+            BlockCodecScratchDir scratch{ "Range" };
+            const unsigned int block_size = AssetPackageFile::ASSET_BLOCK_SIZE;
+            std::vector<char> content(block_size * 10 + block_size / 2);
+            const auto random_bytes = makeRandomBytes(17, content.size());
+            for (size_t i = 0; i < content.size(); i++)
+            {
+                // 前半段好壓縮, 後半段亂數, 兩種 block 都會出現
+                content[i] = (i < content.size() / 2) ? static_cast<char>(i / 97) : static_cast<char>(random_bytes[i]);
+            }
+            const auto asset_size = static_cast<unsigned int>(content.size());
+            struct Range { unsigned int m_offset; unsigned int m_size; };
+            const std::vector<Range> ranges{
+                { 0, 1 }, { block_size - 10, 20 }, { block_size, block_size }, { block_size - 1, block_size + 2 },
+                { block_size * 2 - 1, block_size * 3 }, { 5, block_size * 9 }, { 0, asset_size },
+                { asset_size - 3, 3 }, { asset_size - 100, 1000 } };
+            for (AssetCodec codec : { AssetCodec::zlib, AssetCodec::lz4 })
+            {
+                std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::createNewPackage(scratch.basefilename("pkg" + std::to_string(static_cast<unsigned>(codec)))) };
+                // 碰到 PARALLEL_BLOCK_COUNT 以上的 block 時走注入的 parallel for
+                unsigned int parallel_calls = 0;
+                package->setParallelFor([&parallel_calls](size_t count, const std::function<void(size_t, size_t)>& task)
+                    {
+                        parallel_calls++;
+                        std::thread worker([&task, count]() { task(count / 2, count); });
+                        task(0, count / 2);
+                        worker.join();
+                    });
+                Assert::IsFalse(static_cast<bool>(package->addAssetMemory(content, "ranged", 1, codec)));
+                for (const Range& range : ranges)
+                {
+                    auto buff = package->tryRetrieveAssetRange("ranged", range.m_offset, range.m_size);
+                    Assert::IsTrue(buff.has_value());
+                    const unsigned int expected_size = std::min(range.m_size, asset_size - range.m_offset);
+                    Assert::AreEqual(static_cast<size_t>(expected_size), buff->size());
+                    Assert::IsTrue(std::equal(buff->begin(), buff->end(), content.begin() + range.m_offset));
+                }
+                Assert::IsTrue(parallel_calls > 0);
+                Assert::IsFalse(package->tryRetrieveAssetRange("ranged", asset_size, 1).has_value());
+                Assert::IsFalse(package->tryRetrieveAssetRange("ranged", 0, 0).has_value());
+                Assert::IsFalse(package->tryRetrieveAssetRange("missing", 0, 1).has_value());
+            }
+        }
+
+        TEST_METHOD(TestFormatTag1PackageIsUpgraded)
+        {
+            BlockCodecScratchDir scratch{ "Tag1" };
+            const std::string name = scratch.basefilename("legacy");
+            std::vector<char> legacy_content(5000);
+            for (size_t i = 0; i < legacy_content.size(); i++)
+            {
+                legacy_content[i] = static_cast<char>("legacy asset "[i % 13]);
+            }
+            writeTag1Package(name, "legacy", legacy_content);
+
+            const auto fresh_content = makeRepeatedText(AssetPackageFile::ASSET_BLOCK_SIZE + 10);
+            {
+                std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::openPackage(name) };
+                Assert::IsTrue(static_cast<bool>(package));
+                auto header_data = package->tryGetAssetHeaderData("legacy");
+                Assert::IsTrue(header_data.has_value());
+                Assert::AreEqual(static_cast<unsigned int>(AssetCodec::zlibWhole), header_data->m_codec);
+                auto whole = package->tryRetrieveAssetToMemory("legacy");
+                Assert::IsTrue(whole.has_value());
+                Assert::IsTrue(whole.value() == legacy_content);
+                auto part = package->tryRetrieveAssetRange("legacy", 100, 50);
+                Assert::IsTrue(part.has_value());
+                Assert::IsTrue(std::equal(part->begin(), part->end(), legacy_content.begin() + 100));
+
+                Assert::IsFalse(static_cast<bool>(package->addAssetMemory(std::vector<char>(fresh_content.begin(), fresh_content.end()), "fresh", 1, AssetCodec::lz4)));
+            }
+            // 存檔時 header 升級成新格式, 舊 asset 仍然是整個 zlib
+            Assert::AreEqual(PACKAGE_FORMAT_TAG, readFormatTag(name));
+            std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::openPackage(name) };
+            Assert::IsTrue(static_cast<bool>(package));
+            Assert::AreEqual(static_cast<unsigned int>(AssetCodec::zlibWhole), package->tryGetAssetHeaderData("legacy")->m_codec);
+            Assert::AreEqual(static_cast<unsigned int>(AssetCodec::lz4), package->tryGetAssetHeaderData("fresh")->m_codec);
+            auto whole = package->tryRetrieveAssetToMemory("legacy");
+            Assert::IsTrue(whole.has_value());
+            Assert::IsTrue(whole.value() == legacy_content);
+            auto fresh = package->tryRetrieveAssetToMemory("fresh");
+            Assert::IsTrue(fresh.has_value());
+            Assert::IsTrue(std::equal(fresh->begin(), fresh->end(), fresh_content.begin(), fresh_content.end()));
+        }
+
+    private:
+        static std::vector<unsigned char> makeRandomBytes(unsigned seed, size_t size)
+        {
+            std::mt19937 random{ seed };
+            std::vector<unsigned char> buff(size);
+            for (auto& c : buff)
+            {
+                c = static_cast<unsigned char>(random());
+            }
+            return buff;
+        }
+
+        static std::vector<unsigned char> makeRepeatedText(size_t size)
+        {
+            const char text[] = "The quick brown fox jumps over the lazy dog. ";
+            std::vector<unsigned char> buff(size);
+            for (size_t i = 0; i < size; i++)
+            {
+                buff[i] = static_cast<unsigned char>(text[i % (sizeof(text) - 1)]);
+            }
+            return buff;
+        }
+
+        /** block size, block count, 接著 block_count 個 stored size */
+        static std::vector<unsigned int> readBlockTable(const std::string& basefilename, unsigned int offset, unsigned int block_count)
+        {
+            std::ifstream bundle{ basefilename + PACKAGE_BUNDLE_FILE_EXT, std::ios::binary };
+            bundle.seekg(offset);
+            std::vector<unsigned int> table(2 + block_count);
+            bundle.read(reinterpret_cast<char*>(table.data()), table.size() * sizeof(unsigned int));
+            Assert::IsTrue(static_cast<bool>(bundle));
+            return table;
+        }
+
+        static unsigned int readFormatTag(const std::string& basefilename)
+        {
+            std::ifstream header{ basefilename + PACKAGE_HEADER_FILE_EXT, std::ios::binary };
+            unsigned int tag = 0;
+            header.read(reinterpret_cast<char*>(&tag), sizeof(tag));
+            return tag;
+        }
+
+        /** 照 format tag 1 的格式寫 : header data 沒有 codec 欄位, asset 是整個 zlib stream */
+        static void writeTag1Package(const std::string& basefilename, const std::string& asset_key, const std::vector<char>& content)
+        {
+            // 整個 asset 當成一個 zlib block 壓縮, 就是舊格式的 zlib stream
+            const auto comp = AssetBlockCodec::compressBlock(AssetCodec::zlib, reinterpret_cast<const unsigned char*>(content.data()), content.size());
+            Assert::IsFalse(comp.empty());
+            std::ofstream bundle{ basefilename + PACKAGE_BUNDLE_FILE_EXT, std::ios::binary };
+            bundle.write(reinterpret_cast<const char*>(comp.data()), comp.size());
+
+            auto write_uint = [](std::ostream& os, unsigned int value) { os.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+            std::ofstream header{ basefilename + PACKAGE_HEADER_FILE_EXT, std::ios::binary };
+            write_uint(header, PACKAGE_FORMAT_TAG_WHOLE_ZLIB);
+            write_uint(header, AssetPackageFile::VERSION_USE_FILE_TIME);
+            write_uint(header, 1);
+            write_uint(header, static_cast<unsigned int>(asset_key.length() + 1));
+            header.write(asset_key.c_str(), asset_key.length() + 1);
+            write_uint(header, static_cast<unsigned int>(asset_key.length() + 1 + sizeof(unsigned int) * 5));
+            header.write(asset_key.c_str(), asset_key.length() + 1);
+            write_uint(header, 1);
+            write_uint(header, static_cast<unsigned int>(comp.size()));
+            write_uint(header, static_cast<unsigned int>(content.size()));
+            write_uint(header, 0);
+            write_uint(header, 0);
+        }
+    };
+}
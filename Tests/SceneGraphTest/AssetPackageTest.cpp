@@ -0,0 +1,444 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "AssetPackage/AssetPackageFile.h"
+#include "AssetPackage/AssetPackageFormat.h"
+#include "AssetPackage/AssetPackageReader.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::AssetPackage;
+
+namespace SceneGraphTest
+{
+    /** 每個 test 用自己的暫存目錄, 結束時整個刪掉 */
+    class PackageScratchDir
+    {
+    public:
+        explicit PackageScratchDir(const std::string& name) : m_dir(std::filesystem::temp_directory_path() / ("EnigmaAssetPackageTest_" + name))
+        {
+            std::filesystem::remove_all(m_dir);
+            std::filesystem::create_directories(m_dir);
+        }
+        ~PackageScratchDir()
+        {
+            std::error_code er;
+            std::filesystem::remove_all(m_dir, er);
+        }
+        std::string basefilename(const std::string& name) const { return (m_dir / name).string(); }
+
+    private:
+        std::filesystem::path m_dir;
+    };
+
+    /** 一半重複 pattern 一半亂數, 壓縮後大小仍跟原始大小相關 */
+    static std::vector<char> makeAssetContent(unsigned seed, size_t size)
+    {
+        std::mt19937 random{ seed };
+        std::vector<char> buff(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            buff[i] = (i % 2 == 0) ? static_cast<char>(i / 64 + seed) : static_cast<char>(random());
+        }
+        return buff;
+    }
+
+    static std::uintmax_t packageFileSize(const std::string& basefilename, const char* ext)
+    {
+        std::error_code er;
+        const auto size = std::filesystem::file_size(basefilename + ext, er);
+        return er ? 0 : size;
+    }
+
+    TEST_CLASS(AssetPackageTest)
+    {
+    public:
+        TEST_METHOD(TestJournalReplayAfterUnclosedPackage)
+        {
+            PackageScratchDir scratch{ "journal" };
+            const std::string live_name = scratch.basefilename("live");
+            const std::string crashed_name = scratch.basefilename("crashed");
+            const auto content_a = makeAssetContent(1, 100 * 1024);
+            const auto content_b = makeAssetContent(2, 3000);
+            const auto content_c = makeAssetContent(3, 5000);
+            {
+                std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::createNewPackage(live_name) };
+                Assert::IsFalse(static_cast<bool>(package->addAssetMemory(content_a, "asset_a", 1)));
+                Assert::IsFalse(static_cast<bool>(package->addAssetMemory(content_b, "asset_b", 1)));
+                Assert::IsFalse(static_cast<bool>(package->addAssetMemory(content_c, "asset_c", 1)));
+                Assert::IsFalse(static_cast<bool>(package->removeAsset("asset_b")));
+                Assert::IsTrue(packageFileSize(live_name, PACKAGE_JOURNAL_FILE_EXT) > 0);
+                // 還沒關檔 (header 沒有 checkpoint) 就把檔案複製走, 等於在這裡當掉
+                for (const char* ext : { PACKAGE_HEADER_FILE_EXT, PACKAGE_BUNDLE_FILE_EXT, PACKAGE_JOURNAL_FILE_EXT })
+                {
+                    std::filesystem::copy_file(live_name + ext, crashed_name + ext);
+                }
+            }
+            // journal 尾端寫一半的 record 要被丟掉
+            {
+                std::ofstream journal{ crashed_name + PACKAGE_JOURNAL_FILE_EXT, std::fstream::out | std::fstream::binary | std::fstream::app };
+                const unsigned int torn_record[] = { 1, 4096 };
+                journal.write(reinterpret_cast<const char*>(torn_record), sizeof(torn_record));
+            }
+            const auto torn_journal_size = packageFileSize(crashed_name, PACKAGE_JOURNAL_FILE_EXT);
+            {
+                std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::openPackage(crashed_name) };
+                Assert::IsTrue(packageFileSize(crashed_name, PACKAGE_JOURNAL_FILE_EXT) < torn_journal_size);
+                Assert::IsTrue(package->tryRetrieveAssetToMemory("asset_a") == content_a);
+                Assert::IsTrue(package->tryRetrieveAssetToMemory("asset_c") == content_c);
+                Assert::IsFalse(package->tryRetrieveAssetToMemory("asset_b").has_value());
+                Assert::IsFalse(package->tryGetAssetHeaderData("asset_b").has_value());
+            }
+            // 正常關檔後 journal 已經 checkpoint 進 header
+            Assert::IsTrue(packageFileSize(crashed_name, PACKAGE_JOURNAL_FILE_EXT) == 0);
+            std::unique_ptr<AssetPackageFile> reopened{ AssetPackageFile::openPackage(crashed_name) };
+            Assert::IsTrue(reopened->tryRetrieveAssetToMemory("asset_a") == content_a);
+            Assert::IsTrue(reopened->tryRetrieveAssetToMemory("asset_c") == content_c);
+            Assert::IsFalse(reopened->tryRetrieveAssetToMemory("asset_b").has_value());
+        }
+
+        TEST_METHOD(TestRemovedSpaceIsReused)
+        {
+            PackageScratchDir scratch{ "reuse" };
+            const std::string name = scratch.basefilename("reuse");
+            std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::createNewPackage(name) };
+            const auto content_big = makeAssetContent(10, 200 * 1024);
+            const auto content_tail = makeAssetContent(11, 4000);
+            const auto content_small = makeAssetContent(12, 20 * 1024);
+            Assert::IsFalse(static_cast<bool>(package->addAssetMemory(content_big, "big", 1)));
+            Assert::IsFalse(static_cast<bool>(package->addAssetMemory(content_tail, "tail", 1)));
+            const auto bundle_size = packageFileSize(name, PACKAGE_BUNDLE_FILE_EXT);
+            Assert::IsTrue(package->getFreeBytes() == 0);
+
+            Assert::IsFalse(static_cast<bool>(package->removeAsset("big")));
+            const auto free_bytes = package->getFreeBytes();
+            Assert::IsTrue(free_bytes > 0);
+            Assert::IsFalse(static_cast<bool>(package->addAssetMemory(content_small, "small", 1)));
+            // 小 asset 放進空洞, bundle 不變大
+            Assert::IsTrue(packageFileSize(name, PACKAGE_BUNDLE_FILE_EXT) == bundle_size);
+            Assert::IsTrue(package->getFreeBytes() < free_bytes);
+            Assert::IsTrue(package->tryGetAssetHeaderData("small")->m_offset < package->tryGetAssetHeaderData("tail")->m_offset);
+            Assert::IsTrue(package->tryRetrieveAssetToMemory("small") == content_small);
+            Assert::IsTrue(package->tryRetrieveAssetToMemory("tail") == content_tail);
+        }
+
+        TEST_METHOD(TestCompactShrinksBundleAndKeepsAssets)
+        {
+            PackageScratchDir scratch{ "compact" };
+            const std::string name = scratch.basefilename("compact");
+            constexpr unsigned ASSET_COUNT = 12;
+            std::vector<std::vector<char>> contents;
+            {
+                std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::createNewPackage(name) };
+                for (unsigned i = 0; i < ASSET_COUNT; i++)
+                {
+                    contents.emplace_back(makeAssetContent(100 + i, 8 * 1024 + i * 3000));
+                    Assert::IsFalse(static_cast<bool>(package->addAssetMemory(contents[i], "asset_" + std::to_string(i), 1)));
+                }
+                for (unsigned i = 0; i < ASSET_COUNT; i += 3)
+                {
+                    Assert::IsFalse(static_cast<bool>(package->removeAsset("asset_" + std::to_string(i))));
+                }
+                const auto bundle_size = packageFileSize(name, PACKAGE_BUNDLE_FILE_EXT);
+                const auto free_bytes = package->getFreeBytes();
+                Assert::IsTrue(free_bytes > 0);
+
+                Assert::IsFalse(static_cast<bool>(package->compact()));
+                Assert::IsTrue(package->getFreeBytes() == 0);
+                Assert::IsTrue(packageFileSize(name, PACKAGE_BUNDLE_FILE_EXT) == bundle_size - free_bytes);
+                for (unsigned i = 0; i < ASSET_COUNT; i++)
+                {
+                    const auto content = package->tryRetrieveAssetToMemory("asset_" + std::to_string(i));
+                    if (i % 3 == 0) Assert::IsFalse(content.has_value());
+                    else Assert::IsTrue(content == contents[i]);
+                }
+            }
+            std::unique_ptr<AssetPackageFile> reopened{ AssetPackageFile::openPackage(name) };
+            Assert::IsTrue(reopened->getFreeBytes() == 0);
+            for (unsigned i = 1; i < ASSET_COUNT; i++)
+            {
+                if (i % 3 == 0) continue;
+                Assert::IsTrue(reopened->tryRetrieveAssetToMemory("asset_" + std::to_string(i)) == contents[i]);
+            }
+        }
+
+        TEST_METHOD(BenchmarkAddRemoveAgainstRepack)
+        {
+            PackageScratchDir scratch{ "add_remove" };
+            const std::string name = scratch.basefilename("add_remove");
+            constexpr unsigned ASSET_COUNT = 10000;
+            constexpr unsigned REMOVE_STRIDE = 10;
+            constexpr unsigned REPACK_COUNT = 50;
+            using milliseconds_double = std::chrono::duration<double, std::milli>;
+            std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::createNewPackage(name) };
+
+            // journal 路徑 : 每筆只 append journal record, 每 JOURNAL_CHECKPOINT_RECORDS 筆寫回 header
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned i = 0; i < ASSET_COUNT; i++)
+            {
+                Assert::IsFalse(static_cast<bool>(package->addAssetMemory(makeAssetContent(i, 64 + i % 256), "asset_" + std::to_string(i), 1)));
+            }
+            const double journal_add_ms = milliseconds_double(std::chrono::steady_clock::now() - start).count();
+            start = std::chrono::steady_clock::now();
+            unsigned removed_count = 0;
+            for (unsigned i = 0; i < ASSET_COUNT; i += REMOVE_STRIDE)
+            {
+                Assert::IsFalse(static_cast<bool>(package->removeAsset("asset_" + std::to_string(i))));
+                removed_count++;
+            }
+            const double journal_remove_ms = milliseconds_double(std::chrono::steady_clock::now() - start).count();
+            Assert::IsTrue(package->getFreeBytes() > 0);
+
+            // 舊的路徑 : 每次 remove 都把後面的資料往前搬並寫回完整 header, 每次 add 也寫回完整 header;
+            // 用 compact 重現 (搬移 + 整個 header)
+            start = std::chrono::steady_clock::now();
+            for (unsigned i = 0; i < REPACK_COUNT; i++)
+            {
+                Assert::IsFalse(static_cast<bool>(package->removeAsset("asset_" + std::to_string(i * REMOVE_STRIDE + 1))));
+                Assert::IsFalse(static_cast<bool>(package->compact()));
+            }
+            const double repack_remove_ms = milliseconds_double(std::chrono::steady_clock::now() - start).count();
+            start = std::chrono::steady_clock::now();
+            for (unsigned i = 0; i < REPACK_COUNT; i++)
+            {
+                Assert::IsFalse(static_cast<bool>(package->addAssetMemory(makeAssetContent(ASSET_COUNT + i, 64), "asset_" + std::to_string(ASSET_COUNT + i), 1)));
+                Assert::IsFalse(static_cast<bool>(package->compact()));
+            }
+            const double repack_add_ms = milliseconds_double(std::chrono::steady_clock::now() - start).count();
+            Assert::IsTrue(package->getFreeBytes() == 0);
+            package = nullptr;
+
+            // 兩種路徑之後內容都還在
+            package.reset(AssetPackageFile::openPackage(name));
+            Assert::IsTrue(static_cast<bool>(package));
+            for (unsigned i = 0; i < ASSET_COUNT; i += 97)
+            {
+                const auto content = package->tryRetrieveAssetToMemory("asset_" + std::to_string(i));
+                const bool is_removed = (i % REMOVE_STRIDE == 0) || ((i % REMOVE_STRIDE == 1) && (i / REMOVE_STRIDE < REPACK_COUNT));
+                Assert::IsTrue(content.has_value() != is_removed);
+                if (content) Assert::IsTrue(content.value() == makeAssetContent(i, 64 + i % 256));
+            }
+            Assert::IsTrue(package->tryRetrieveAssetToMemory("asset_" + std::to_string(ASSET_COUNT)) == makeAssetContent(ASSET_COUNT, 64));
+
+            char report[256];
+            snprintf(report, sizeof(report), "%u assets: journal add %.2f us, remove %.2f us; repack add %.2f us, remove %.2f us (per asset)\n", ASSET_COUNT,
+                journal_add_ms * 1000.0 / ASSET_COUNT, journal_remove_ms * 1000.0 / removed_count, repack_add_ms * 1000.0 / REPACK_COUNT, repack_remove_ms * 1000.0 / REPACK_COUNT);
+            Logger::WriteMessage(report);
+        }
+
+        TEST_METHOD(TestReaderLooksUpPresentAndMissingKeys)
+        {
+            PackageScratchDir scratch{ "reader" };
+            const std::string name = scratch.basefilename("reader");
+            constexpr unsigned ASSET_COUNT = 2000;
+            buildNumberedPackage(name, ASSET_COUNT);
+            std::vector<std::string> missing_keys{ "", "asset_", "Asset_1", "asset_1 ", "asset_01", "asset_12x", "xasset_12" };
+            for (unsigned i = ASSET_COUNT; i < ASSET_COUNT * 2; i++)
+            {
+                missing_keys.emplace_back("asset_" + std::to_string(i));
+            }
+
+            std::unique_ptr<AssetPackageReader> reader{ AssetPackageReader::openPackage(name) };
+            Assert::IsTrue(static_cast<bool>(reader));
+            Assert::IsFalse(reader->isUsingPrebuiltIndex());
+            assertNumberedAssets(*reader, ASSET_COUNT, missing_keys);
+
+            // 存下來的 index 要查出一樣的結果
+            Assert::IsFalse(static_cast<bool>(reader->saveIndexFile()));
+            reader = nullptr;
+            reader.reset(AssetPackageReader::openPackage(name));
+            Assert::IsTrue(static_cast<bool>(reader));
+            Assert::IsTrue(reader->isUsingPrebuiltIndex());
+            assertNumberedAssets(*reader, ASSET_COUNT, missing_keys);
+            reader = nullptr;
+
+            // header 改過之後舊 index 不能用, 重建的 index 要查得到新的 asset
+            {
+                std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::openPackage(name) };
+                Assert::IsFalse(static_cast<bool>(package->addAssetMemory(makeAssetContent(ASSET_COUNT, 64), missing_keys.back(), 1)));
+                // journal 還沒 checkpoint 前 reader 開不起來
+                error er;
+                Assert::IsFalse(static_cast<bool>(std::unique_ptr<AssetPackageReader>(AssetPackageReader::openPackage(name, er))));
+                Assert::IsTrue(static_cast<bool>(er));
+            }
+            reader.reset(AssetPackageReader::openPackage(name));
+            Assert::IsTrue(static_cast<bool>(reader));
+            Assert::IsFalse(reader->isUsingPrebuiltIndex());
+            Assert::IsTrue(reader->getAssetCount() == ASSET_COUNT + 1);
+            Assert::IsTrue(reader->tryRetrieveAssetToMemory(missing_keys.back()) == makeAssetContent(ASSET_COUNT, 64));
+            Assert::IsFalse(reader->hasAsset(missing_keys[missing_keys.size() - 2]));
+        }
+
+        TEST_METHOD(BenchmarkReaderLookup)
+        {
+            PackageScratchDir scratch{ "lookup" };
+            const std::string name = scratch.basefilename("lookup");
+            constexpr unsigned ASSET_COUNT = 10000;
+            buildNumberedPackage(name, ASSET_COUNT);
+            std::vector<std::string> hit_keys;
+            std::vector<std::string> miss_keys;
+            for (unsigned i = 0; i < ASSET_COUNT; i++)
+            {
+                hit_keys.emplace_back("asset_" + std::to_string(i));
+                miss_keys.emplace_back("asset_" + std::to_string(i + ASSET_COUNT));
+            }
+            std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::openPackage(name) };
+            std::unique_ptr<AssetPackageReader> reader{ AssetPackageReader::openPackage(name) };
+            Assert::IsTrue(static_cast<bool>(reader));
+
+            auto measure = [](const std::vector<std::string>& keys, const auto& lookup)
+            {
+                size_t found = 0;
+                const auto start = std::chrono::steady_clock::now();
+                for (const auto& key : keys)
+                {
+                    if (lookup(key)) found++;
+                }
+                const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                return std::make_pair(found, ns / static_cast<double>(keys.size()));
+            };
+            const auto file_hit = measure(hit_keys, [&](const std::string& key) { return package->tryGetAssetHeaderData(key).has_value(); });
+            const auto file_miss = measure(miss_keys, [&](const std::string& key) { return package->tryGetAssetHeaderData(key).has_value(); });
+            const auto reader_hit = measure(hit_keys, [&](const std::string& key) { return reader->hasAsset(key); });
+            const auto reader_miss = measure(miss_keys, [&](const std::string& key) { return reader->hasAsset(key); });
+            Assert::IsTrue(file_hit.first == ASSET_COUNT);
+            Assert::IsTrue(reader_hit.first == ASSET_COUNT);
+            Assert::IsTrue(file_miss.first == 0);
+            Assert::IsTrue(reader_miss.first == 0);
+
+            char report[256];
+            snprintf(report, sizeof(report), "%u assets: AssetPackageFile hit %.1f ns, miss %.1f ns; AssetPackageReader hit %.1f ns, miss %.1f ns\n",
+                ASSET_COUNT, file_hit.second, file_miss.second, reader_hit.second, reader_miss.second);
+            Logger::WriteMessage(report);
+        }
+
+        TEST_METHOD(BenchmarkReaderOpenWithPrebuiltIndex)
+        {
+            PackageScratchDir scratch{ "open" };
+            const std::string name = scratch.basefilename("open");
+            constexpr unsigned ASSET_COUNT = 10000;
+            constexpr unsigned OPEN_COUNT = 20;
+            buildNumberedPackage(name, ASSET_COUNT);
+            using microseconds_double = std::chrono::duration<double, std::micro>;
+            auto measure_open = [&name](bool expect_prebuilt)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                for (unsigned i = 0; i < OPEN_COUNT; i++)
+                {
+                    std::unique_ptr<AssetPackageReader> reader{ AssetPackageReader::openPackage(name) };
+                    Assert::IsTrue(static_cast<bool>(reader));
+                    Assert::IsTrue(reader->isUsingPrebuiltIndex() == expect_prebuilt);
+                    Assert::IsTrue(reader->getAssetCount() == ASSET_COUNT);
+                }
+                return microseconds_double(std::chrono::steady_clock::now() - start).count() / OPEN_COUNT;
+            };
+            // 沒有 index file, 每次開檔都 buildIndex
+            const double build_us = measure_open(false);
+            {
+                std::unique_ptr<AssetPackageReader> reader{ AssetPackageReader::openPackage(name) };
+                Assert::IsFalse(static_cast<bool>(reader->saveIndexFile()));
+            }
+            const double prebuilt_us = measure_open(true);
+            std::unique_ptr<AssetPackageReader> reader{ AssetPackageReader::openPackage(name) };
+            assertNumberedAssets(*reader, ASSET_COUNT, { "asset_" + std::to_string(ASSET_COUNT) });
+
+            char report[256];
+            snprintf(report, sizeof(report), "%u assets: open with buildIndex %.1f us, with prebuilt index %.1f us\n", ASSET_COUNT, build_us, prebuilt_us);
+            Logger::WriteMessage(report);
+        }
+
+        TEST_METHOD(TestConcurrentRetrieveToMemory)
+        {
+            PackageScratchDir scratch{ "concurrent" };
+            const std::string name = scratch.basefilename("concurrent");
+            constexpr unsigned ASSET_COUNT = 256;
+            constexpr unsigned THREAD_COUNT = 8;
+            constexpr unsigned ROUNDS = 4;
+            // 大部分是小 asset, 每 16 個有一個跨好幾個 block 的大 asset
+            auto asset_size = [](unsigned i) { return (i % 16 == 0) ? AssetPackageFile::ASSET_BLOCK_SIZE * 5 + i : 512 + i * 37; };
+            {
+                std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::createNewPackage(name) };
+                for (unsigned i = 0; i < ASSET_COUNT; i++)
+                {
+                    Assert::IsFalse(static_cast<bool>(package->addAssetMemory(makeAssetContent(i, asset_size(i)), "asset_" + std::to_string(i), 1)));
+                }
+            }
+            std::vector<std::vector<char>> contents;
+            for (unsigned i = 0; i < ASSET_COUNT; i++) contents.emplace_back(makeAssetContent(i, asset_size(i)));
+            std::unique_ptr<AssetPackageReader> reader{ AssetPackageReader::openPackage(name) };
+            Assert::IsTrue(static_cast<bool>(reader));
+
+            // reader 不上鎖, 每個 thread 從不同的位置開始讀全部 asset
+            std::atomic<unsigned> mismatch_count{ 0 };
+            std::atomic<size_t> retrieved_bytes{ 0 };
+            std::vector<std::thread> threads;
+            const auto start = std::chrono::steady_clock::now();
+            for (unsigned t = 0; t < THREAD_COUNT; t++)
+            {
+                threads.emplace_back([&, t]()
+                    {
+                        size_t bytes = 0;
+                        for (unsigned round = 0; round < ROUNDS; round++)
+                        {
+                            for (unsigned n = 0; n < ASSET_COUNT; n++)
+                            {
+                                const unsigned i = (n * 7 + t * 31 + round) % ASSET_COUNT;
+                                const auto content = reader->tryRetrieveAssetToMemory("asset_" + std::to_string(i));
+                                if ((!content) || (content.value() != contents[i])) mismatch_count++;
+                                if (content) bytes += content->size();
+                            }
+                        }
+                        retrieved_bytes += bytes;
+                    });
+            }
+            for (auto& thread : threads) thread.join();
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            Assert::AreEqual(0u, mismatch_count.load());
+            size_t expected_bytes = 0;
+            for (const auto& content : contents) expected_bytes += content.size();
+            Assert::IsTrue(retrieved_bytes.load() == expected_bytes * THREAD_COUNT * ROUNDS);
+
+            char report[256];
+            snprintf(report, sizeof(report), "%u threads retrieve %u assets x %u: %.1f MB/s, %.0f assets/s\n", THREAD_COUNT, ASSET_COUNT, ROUNDS,
+                static_cast<double>(retrieved_bytes.load()) / (1024.0 * 1024.0) / seconds, static_cast<double>(THREAD_COUNT * ROUNDS * ASSET_COUNT) / seconds);
+            Logger::WriteMessage(report);
+        }
+
+    private:
+        /** asset_0 ~ asset_{count-1}, 內容由編號決定, 建完關檔 (checkpoint) */
+        static void buildNumberedPackage(const std::string& name, unsigned count)
+        {
+            std::unique_ptr<AssetPackageFile> package{ AssetPackageFile::createNewPackage(name) };
+            for (unsigned i = 0; i < count; i++)
+            {
+                Assert::IsFalse(static_cast<bool>(package->addAssetMemory(makeAssetContent(i, 64 + i % 256), "asset_" + std::to_string(i), 1)));
+            }
+        }
+
+        static void assertNumberedAssets(const AssetPackageReader& reader, unsigned count, const std::vector<std::string>& missing_keys)
+        {
+            Assert::IsTrue(reader.getAssetCount() == count);
+            for (unsigned i = 0; i < count; i++)
+            {
+                const std::string key = "asset_" + std::to_string(i);
+                Assert::IsTrue(reader.hasAsset(key));
+                Assert::IsTrue(reader.getAssetOriginalSize(key) == 64 + i % 256);
+                if (i % 97 == 0) Assert::IsTrue(reader.tryRetrieveAssetToMemory(key) == makeAssetContent(i, 64 + i % 256));
+            }
+            for (const auto& key : missing_keys)
+            {
+                Assert::IsFalse(reader.hasAsset(key));
+                Assert::IsFalse(reader.tryGetAssetHeaderData(key).has_value());
+                Assert::IsFalse(reader.tryRetrieveAssetToMemory(key).has_value());
+                Assert::IsTrue(reader.getAssetOriginalSize(key) == 0);
+            }
+        }
+    };
+}
@@ -0,0 +1,152 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "Frameworks/AssetRetentionCache.h"
+#include <memory>
+#include <string>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Frameworks;
+
+namespace SceneGraphTest
+{
+    TEST_CLASS(AssetRetentionCacheTest)
+    {
+    public:
+        TEST_METHOD(TestEvictLeastRecentlyUsed)
+        {
+            AssetRetentionCache cache(300);
+            auto a = std::make_shared<int>(1);
+            std::weak_ptr<int> weak_a = a;
+            cache.retain("geometry", "a", a, 100);
+            cache.retain("geometry", "b", std::make_shared<int>(2), 100);
+            cache.retain("geometry", "c", std::make_shared<int>(3), 100);
+            a = nullptr;
+            // cache 持有 asset
+            Assert::IsFalse(weak_a.expired());
+
+            // a 最近用過, 超出預算時先釋放 b
+            Assert::IsTrue(cache.touch("geometry", "a"));
+            cache.retain("geometry", "d", std::make_shared<int>(4), 100);
+            Assert::IsTrue(cache.isRetained("geometry", "a"));
+            Assert::IsFalse(cache.isRetained("geometry", "b"));
+            Assert::IsTrue(cache.isRetained("geometry", "c"));
+            Assert::IsTrue(cache.isRetained("geometry", "d"));
+
+            // 重新 retain 會更新大小及使用順序
+            cache.retain("geometry", "c", std::make_shared<int>(3), 150);
+            Assert::IsFalse(cache.isRetained("geometry", "a"));
+            Assert::IsTrue(weak_a.expired());
+            Assert::IsTrue(cache.isRetained("geometry", "c"));
+            Assert::IsTrue(cache.isRetained("geometry", "d"));
+            Assert::AreEqual(static_cast<size_t>(250), cache.statistics().m_retainedBytes);
+
+            // 縮小預算馬上釋放
+            cache.budget(160);
+            Assert::IsFalse(cache.isRetained("geometry", "d"));
+            Assert::IsTrue(cache.isRetained("geometry", "c"));
+            Assert::IsFalse(cache.touch("geometry", "d"));
+        }
+
+        TEST_METHOD(TestCategoryBudgetOnlyEvictsOwnCategory)
+        {
+            AssetRetentionCache cache(1000);
+            cache.categoryBudget("texture", 200);
+            Assert::AreEqual(static_cast<size_t>(200), cache.categoryBudget("texture"));
+            Assert::AreEqual(static_cast<size_t>(0), cache.categoryBudget("geometry"));
+            cache.retain("geometry", "g0", std::make_shared<int>(0), 100);
+            cache.retain("texture", "t0", std::make_shared<int>(0), 100);
+            cache.retain("texture", "t1", std::make_shared<int>(1), 100);
+            cache.retain("geometry", "g1", std::make_shared<int>(1), 100);
+            // texture 超出自己的預算, 釋放最舊的 texture, 即使 g0 更舊
+            cache.retain("texture", "t2", std::make_shared<int>(2), 100);
+            Assert::IsTrue(cache.isRetained("geometry", "g0"));
+            Assert::IsFalse(cache.isRetained("texture", "t0"));
+            Assert::IsTrue(cache.isRetained("texture", "t1"));
+            Assert::IsTrue(cache.isRetained("texture", "t2"));
+            Assert::AreEqual(static_cast<size_t>(200), cache.statistics("texture").m_retainedBytes);
+            Assert::AreEqual(static_cast<size_t>(200), cache.statistics("geometry").m_retainedBytes);
+
+            // 總預算仍然跨 category 套用
+            cache.budget(300);
+            Assert::IsFalse(cache.isRetained("geometry", "g0"));
+            Assert::AreEqual(static_cast<size_t>(300), cache.statistics().m_retainedBytes);
+
+            // 0 表示取消 category 預算
+            cache.categoryBudget("texture", 0);
+            Assert::AreEqual(static_cast<size_t>(0), cache.categoryBudget("texture"));
+            cache.budget(1000);
+            cache.retain("texture", "t3", std::make_shared<int>(3), 100);
+            Assert::AreEqual(static_cast<size_t>(300), cache.statistics("texture").m_retainedBytes);
+        }
+
+        TEST_METHOD(TestPinnedAssetsAreNeverEvicted)
+        {
+            AssetRetentionCache cache(200);
+            // pin 可以先於 retain
+            cache.pin("primitive", "hero");
+            Assert::IsTrue(cache.isPinned("primitive", "hero"));
+            cache.retain("primitive", "hero", std::make_shared<int>(0), 150);
+            cache.retain("primitive", "p0", std::make_shared<int>(1), 100);
+            // 超出預算, 但 hero 最舊也不釋放
+            Assert::IsTrue(cache.isRetained("primitive", "hero"));
+            Assert::IsFalse(cache.isRetained("primitive", "p0"));
+            // pinned 超出預算時, 預算不能把它擠掉
+            cache.budget(100);
+            Assert::IsTrue(cache.isRetained("primitive", "hero"));
+            cache.clear();
+            Assert::IsTrue(cache.isRetained("primitive", "hero"));
+
+            // unpin 後馬上依預算釋放
+            cache.unpin("primitive", "hero");
+            Assert::IsFalse(cache.isPinned("primitive", "hero"));
+            Assert::IsFalse(cache.isRetained("primitive", "hero"));
+
+            // releaseCategory 連 pinned 的也釋放, 但保留 pin 標記
+            cache.budget(1000);
+            cache.pin("primitive", "hero");
+            cache.retain("primitive", "hero", std::make_shared<int>(0), 150);
+            cache.retain("geometry", "g0", std::make_shared<int>(0), 100);
+            cache.releaseCategory("primitive");
+            Assert::IsFalse(cache.isRetained("primitive", "hero"));
+            Assert::IsTrue(cache.isPinned("primitive", "hero"));
+            Assert::IsTrue(cache.isRetained("geometry", "g0"));
+        }
+
+        TEST_METHOD(TestStatistics)
+        {
+            AssetRetentionCache cache(200);
+            cache.recordMiss("scene_graph");
+            cache.retain("scene_graph", "s0", std::make_shared<int>(0), 100);
+            cache.recordHit("scene_graph");
+            cache.recordHit("scene_graph");
+            cache.recordMiss("animation");
+            cache.retain("animation", "a0", std::make_shared<int>(0), 100);
+            cache.retain("animation", "a1", std::make_shared<int>(1), 100);
+
+            const auto scene_stat = cache.statistics("scene_graph");
+            Assert::AreEqual(static_cast<std::uint64_t>(2), scene_stat.m_hits);
+            Assert::AreEqual(static_cast<std::uint64_t>(1), scene_stat.m_misses);
+            Assert::AreEqual(static_cast<std::uint64_t>(1), scene_stat.m_evictions);
+            Assert::AreEqual(static_cast<size_t>(0), scene_stat.m_retainedCount);
+            const auto animation_stat = cache.statistics("animation");
+            Assert::AreEqual(static_cast<std::uint64_t>(0), animation_stat.m_evictions);
+            Assert::AreEqual(static_cast<size_t>(2), animation_stat.m_retainedCount);
+            Assert::AreEqual(static_cast<size_t>(200), animation_stat.m_retainedBytes);
+            auto total = cache.statistics();
+            Assert::AreEqual(static_cast<std::uint64_t>(2), total.m_hits);
+            Assert::AreEqual(static_cast<std::uint64_t>(2), total.m_misses);
+            Assert::AreEqual(static_cast<std::uint64_t>(1), total.m_evictions);
+            Assert::AreEqual(static_cast<size_t>(2), total.m_retainedCount);
+            Assert::AreEqual(static_cast<size_t>(0), cache.statistics("unknown").m_retainedCount);
+
+            // release 不算 eviction; reset 只歸零計數, 不動目前的 retained 狀態
+            cache.release("animation", "a0");
+            cache.resetStatistics();
+            total = cache.statistics();
+            Assert::AreEqual(static_cast<std::uint64_t>(0), total.m_hits);
+            Assert::AreEqual(static_cast<std::uint64_t>(0), total.m_misses);
+            Assert::AreEqual(static_cast<std::uint64_t>(0), total.m_evictions);
+            Assert::AreEqual(static_cast<size_t>(1), total.m_retainedCount);
+            Assert::AreEqual(static_cast<size_t>(100), total.m_retainedBytes);
+        }
+    };
+}
@@ -0,0 +1,409 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "Gateways/DtoJsonGateway.h"
+#include "Gateways/DtoBinaryGateway.h"
+#include "GameEngine/GenericDto.h"
+#include "GameEngine/FactoryDesc.h"
+#include "MathLib/Box3.h"
+#include "MathLib/Matrix4.h"
+#include "MathLib/ColorRGBA.h"
+#include "MathLib/ColorRGB.h"
+#include "MathLib/Vector2.h"
+#include "MathLib/Vector3.h"
+#include "MathLib/Vector4.h"
+#include "rapidjson/document.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Engine;
+using namespace Enigma::MathLib;
+using namespace Enigma::Gateways;
+
+/** 改成 SAX 之前的 DOM 版 deserialize, 當作對照組 */
+namespace DomReference
+{
+    GenericDtoCollection deserializeDtoArray(const rapidjson::Value& value);
+
+    std::vector<float> floats(const rapidjson::Value& value, size_t count)
+    {
+        std::vector<float> fs(count, 0.0f);
+        for (size_t i = 0; i < count; i++) fs[i] = value[static_cast<rapidjson::SizeType>(i)].GetFloat();
+        return fs;
+    }
+    template <class T, class F> std::vector<T> deserializeArray(const rapidjson::Value& value, F&& deserialize)
+    {
+        std::vector<T> ts;
+        if (!value.IsArray()) return ts;
+        for (auto it = value.Begin(); it != value.End(); ++it) ts.emplace_back(deserialize(*it));
+        return ts;
+    }
+    Vector2 vector2(const rapidjson::Value& value) { auto f = floats(value, 2); return Vector2(f[0], f[1]); }
+    Vector3 vector3(const rapidjson::Value& value) { auto f = floats(value, 3); return Vector3(f[0], f[1], f[2]); }
+    Vector4 vector4(const rapidjson::Value& value) { auto f = floats(value, 4); return Vector4(f[0], f[1], f[2], f[3]); }
+    Matrix4 matrix4(const rapidjson::Value& value)
+    {
+        auto f = floats(value, 16);
+        return Matrix4(f[0], f[1], f[2], f[3], f[4], f[5], f[6], f[7], f[8], f[9], f[10], f[11], f[12], f[13], f[14], f[15]);
+    }
+    FactoryDesc factoryDesc(const rapidjson::Value& value)
+    {
+        auto string_of = [&value](const char* key) { return value.HasMember(key) ? std::string(value[key].GetString()) : std::string(); };
+        const auto instance_type = value.HasMember("InstanceType") ? static_cast<FactoryDesc::InstanceType>(value["InstanceType"].GetInt()) : FactoryDesc::InstanceType::Native;
+        FactoryDesc desc(string_of("RttiName"));
+        switch (instance_type)
+        {
+        case FactoryDesc::InstanceType::Native: desc.claimAsNative(string_of("PrefabFilename")); break;
+        case FactoryDesc::InstanceType::ByPrefab: desc.claimByPrefab(string_of("PrefabFilename")); break;
+        case FactoryDesc::InstanceType::Deferred: desc.claimAsDeferred(string_of("PrefabFilename")); break;
+        case FactoryDesc::InstanceType::Instanced: desc.claimAsInstanced(string_of("PrefabFilename")); break;
+        case FactoryDesc::InstanceType::FromResource: desc.claimFromResource(string_of("ResourceName"), string_of("ResourceFilename")); break;
+        case FactoryDesc::InstanceType::ResourceAsset: desc.claimAsResourceAsset(string_of("ResourceName"), string_of("ResourceFilename")); break;
+        }
+        return desc;
+    }
+    GenericDto deserializeDto(const rapidjson::Value& value_ob)
+    {
+        GenericDto dto;
+        if (!value_ob.IsObject()) return dto;
+        for (auto it = value_ob.MemberBegin(); it != value_ob.MemberEnd(); ++it)
+        {
+            const rapidjson::Value& value = it->value;
+            if ((value.IsNull()) || (!value.HasMember("Type")) || (!value.HasMember("Value"))) continue;
+            const std::string attribute = it->name.GetString();
+            const std::string type = value["Type"].GetString();
+            const rapidjson::Value& v = value["Value"];
+            if (type == "DataObject") dto.addOrUpdate(attribute, deserializeDto(v));
+            else if (type == "DataObjectArray") dto.addOrUpdate(attribute, deserializeDtoArray(v));
+            else if (type == "FactoryDesc") dto.addOrUpdate(attribute, factoryDesc(v));
+            else if (type == "Uint64") dto.addOrUpdate(attribute, static_cast<std::uint64_t>(v.GetUint64()));
+            else if (type == "Uint32") dto.addOrUpdate(attribute, static_cast<std::uint32_t>(v.GetUint()));
+            else if (type == "Float") dto.addOrUpdate(attribute, v.GetFloat());
+            else if (type == "String") dto.addOrUpdate(attribute, std::string(v.GetString()));
+            else if (type == "Boolean") dto.addOrUpdate(attribute, v.GetBool());
+            else if (type == "ColorRGBA") { auto f = floats(v, 4); dto.addOrUpdate(attribute, ColorRGBA(f[0], f[1], f[2], f[3])); }
+            else if (type == "ColorRGB") { auto f = floats(v, 3); dto.addOrUpdate(attribute, ColorRGB(f[0], f[1], f[2])); }
+            else if (type == "Vector2") dto.addOrUpdate(attribute, vector2(v));
+            else if (type == "Vector3") dto.addOrUpdate(attribute, vector3(v));
+            else if (type == "Vector4") dto.addOrUpdate(attribute, vector4(v));
+            else if (type == "Box3")
+            {
+                auto f = floats(v, 15);
+                Box3 box;
+                box.Center() = Vector3(f[0], f[1], f[2]);
+                box.Axis(0) = Vector3(f[3], f[4], f[5]);
+                box.Axis(1) = Vector3(f[6], f[7], f[8]);
+                box.Axis(2) = Vector3(f[9], f[10], f[11]);
+                box.Extent(0) = f[12];
+                box.Extent(1) = f[13];
+                box.Extent(2) = f[14];
+                dto.addOrUpdate(attribute, box);
+            }
+            else if (type == "Matrix4") dto.addOrUpdate(attribute, matrix4(v));
+            else if (type == "StringArray") dto.addOrUpdate(attribute, deserializeArray<std::string>(v, [](const rapidjson::Value& s) { return std::string(s.GetString()); }));
+            else if (type == "Uint32Array") dto.addOrUpdate(attribute, deserializeArray<std::uint32_t>(v, [](const rapidjson::Value& n) { return static_cast<std::uint32_t>(n.GetUint()); }));
+            else if (type == "FloatArray") dto.addOrUpdate(attribute, deserializeArray<float>(v, [](const rapidjson::Value& f) { return f.GetFloat(); }));
+            else if (type == "Vector2Array") dto.addOrUpdate(attribute, deserializeArray<Vector2>(v, vector2));
+            else if (type == "Vector3Array") dto.addOrUpdate(attribute, deserializeArray<Vector3>(v, vector3));
+            else if (type == "Vector4Array") dto.addOrUpdate(attribute, deserializeArray<Vector4>(v, vector4));
+            else if (type == "Matrix4Array") dto.addOrUpdate(attribute, deserializeArray<Matrix4>(v, matrix4));
+        }
+        return dto;
+    }
+    GenericDtoCollection deserializeDtoArray(const rapidjson::Value& value)
+    {
+        return deserializeArray<GenericDto>(value, deserializeDto);
+    }
+    GenericDtoCollection deserialize(const std::string& json)
+    {
+        rapidjson::Document doc;
+        doc.Parse<0>(json.data(), json.size());
+        if ((doc.HasParseError()) || (!doc.IsArray())) return {};
+        return deserializeDtoArray(doc);
+    }
+}
+
+namespace SceneGraphTest
+{
+    /** dto 的內容轉成排序過的字串, 用來比較兩邊 deserialize 的結果 */
+    class DtoDescriber
+    {
+    public:
+        static std::string describe(const GenericDtoCollection& dtos)
+        {
+            std::string s;
+            for (auto& dto : dtos) describeDto(s, dto);
+            return s;
+        }
+
+    private:
+        static void floats(std::string& s, const float* values, size_t count)
+        {
+            char text[32];
+            s += "[";
+            for (size_t i = 0; i < count; i++)
+            {
+                snprintf(text, sizeof(text), "%.9g,", values[i]);
+                s += text;
+            }
+            s += "]";
+        }
+        static void describeDto(std::string& s, const GenericDto& dto)
+        {
+            std::map<std::string, const std::any*> sorted;
+            for (auto& [attribute, value] : dto) sorted.emplace(attribute, &value);
+            s += "{";
+            for (auto& [attribute, value] : sorted)
+            {
+                s += attribute + "=";
+                describeValue(s, *value);
+                s += ";";
+            }
+            s += "}";
+        }
+        static void describeValue(std::string& s, const std::any& a)
+        {
+            if (auto p = std::any_cast<GenericDto>(&a)) describeDto(s, *p);
+            else if (auto p = std::any_cast<GenericDtoCollection>(&a)) { s += "["; for (auto& dto : *p) describeDto(s, dto); s += "]"; }
+            else if (auto p = std::any_cast<FactoryDesc>(&a)) s += "FD(" + p->rttiName() + "," + std::to_string(static_cast<int>(p->instanceType())) + "," + p->resourceName() + "," + p->resourceFilename() + "," + p->prefabFilename() + ")";
+            else if (auto p = std::any_cast<std::uint64_t>(&a)) s += "u64:" + std::to_string(*p);
+            else if (auto p = std::any_cast<std::uint32_t>(&a)) s += "u32:" + std::to_string(*p);
+            else if (auto p = std::any_cast<float>(&a)) floats(s, p, 1);
+            else if (auto p = std::any_cast<std::string>(&a)) s += "s:" + *p;
+            else if (auto p = std::any_cast<bool>(&a)) s += *p ? "T" : "F";
+            else if (auto p = std::any_cast<ColorRGBA>(&a)) { const float v[4]{ p->R(), p->G(), p->B(), p->A() }; floats(s, v, 4); }
+            else if (auto p = std::any_cast<ColorRGB>(&a)) { const float v[3]{ p->R(), p->G(), p->B() }; floats(s, v, 3); }
+            else if (auto p = std::any_cast<Vector2>(&a)) { const float v[2]{ p->x(), p->y() }; floats(s, v, 2); }
+            else if (auto p = std::any_cast<Vector3>(&a)) { const float v[3]{ p->x(), p->y(), p->z() }; floats(s, v, 3); }
+            else if (auto p = std::any_cast<Vector4>(&a)) { const float v[4]{ p->x(), p->y(), p->z(), p->w() }; floats(s, v, 4); }
+            else if (auto p = std::any_cast<Box3>(&a))
+            {
+                const float v[15]{ p->Center().x(), p->Center().y(), p->Center().z(), p->Axis(0).x(), p->Axis(0).y(), p->Axis(0).z(),
+                    p->Axis(1).x(), p->Axis(1).y(), p->Axis(1).z(), p->Axis(2).x(), p->Axis(2).y(), p->Axis(2).z(), p->Extent(0), p->Extent(1), p->Extent(2) };
+                floats(s, v, 15);
+            }
+            else if (auto p = std::any_cast<Matrix4>(&a)) describeMatrix(s, *p);
+            else if (auto p = std::any_cast<std::vector<std::string>>(&a)) { for (auto& str : *p) s += str + ";"; }
+            else if (auto p = std::any_cast<std::vector<std::uint32_t>>(&a)) { for (auto n : *p) s += std::to_string(n) + ","; }
+            else if (auto p = std::any_cast<std::vector<float>>(&a)) floats(s, p->data(), p->size());
+            else if (auto p = std::any_cast<std::vector<Vector2>>(&a)) { for (auto& v : *p) describeValue(s, v); }
+            else if (auto p = std::any_cast<std::vector<Vector3>>(&a)) { for (auto& v : *p) describeValue(s, v); }
+            else if (auto p = std::any_cast<std::vector<Vector4>>(&a)) { for (auto& v : *p) describeValue(s, v); }
+            else if (auto p = std::any_cast<std::vector<Matrix4>>(&a)) { for (auto& m : *p) describeMatrix(s, m); }
+            else s += "?";
+        }
+        static void describeMatrix(std::string& s, const Matrix4& mx)
+        {
+            float v[16];
+            for (int i = 0; i < 16; i++) v[i] = mx[i / 4][i % 4];
+            floats(s, v, 16);
+        }
+    };
+
+    TEST_CLASS(DtoJsonGatewayTest)
+    {
+    public:
+        static std::filesystem::path mediaPath()
+        {
+            return std::filesystem::path(__FILE__).parent_path() / "../../Media";
+        }
+        static std::string loadFile(const std::filesystem::path& path)
+        {
+            std::ifstream file(path, std::ios::binary);
+            std::stringstream ss;
+            ss << file.rdbuf();
+            return ss.str();
+        }
+        /** Media 底下所有 json array 檔 */
+        static std::vector<std::string> loadMediaContracts()
+        {
+            std::vector<std::string> contents;
+            std::error_code er;
+            for (auto& entry : std::filesystem::recursive_directory_iterator(mediaPath(), er))
+            {
+                if (!entry.is_regular_file()) continue;
+                std::string content = loadFile(entry.path());
+                const auto first = content.find_first_not_of(" \t\r\n");
+                if ((first == std::string::npos) || (content[first] != '[')) continue;
+                contents.emplace_back(std::move(content));
+            }
+            return contents;
+        }
+        static size_t peakMemoryKB()
+        {
+#if defined(_WIN32)
+            PROCESS_MEMORY_COUNTERS counters{};
+            GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+            return counters.PeakWorkingSetSize / 1024;
+#else
+            rusage usage{};
+            getrusage(RUSAGE_SELF, &usage);
+            return static_cast<size_t>(usage.ru_maxrss);
+#endif
+        }
+        static GenericDtoCollection makeAllTypeDtos()
+        {
+            GenericDto child;
+            child.addName("child");
+            child.addRtti(FactoryDesc("ChildRtti").claimAsResourceAsset("child_name", "child.json@DataPath"));
+            GenericDto dto;
+            dto.addName("all types");
+            dto.addRtti(FactoryDesc("TestRtti").claimAsDeferred("deferred.json@DataPath"));
+            dto.addOrUpdate("Child", child);
+            dto.addOrUpdate("Children", GenericDtoCollection{ child, GenericDto{} });
+            dto.addOrUpdate("U64", static_cast<std::uint64_t>(0x123456789abcdefull));
+            dto.addOrUpdate("U32", static_cast<std::uint32_t>(4000000000u));
+            dto.addOrUpdate("F", 0.1f);
+            dto.addOrUpdate("S", std::string("quote \" slash \\ tab \t unicode \xe4\xb8\xad"));
+            dto.addOrUpdate("B", true);
+            dto.addOrUpdate("RGBA", ColorRGBA(0.1f, 0.2f, 0.3f, 0.4f));
+            dto.addOrUpdate("RGB", ColorRGB(0.5f, 0.6f, 0.7f));
+            dto.addOrUpdate("V2", Vector2(1.5f, -2.5f));
+            dto.addOrUpdate("V3", Vector3(1.0e-7f, 3.4e38f, -0.0f));
+            dto.addOrUpdate("V4", Vector4(1.0f, 2.0f, 3.0f, 4.0f));
+            dto.addOrUpdate("Box", Box3(Vector3(1.0f, 2.0f, 3.0f), Vector3::UNIT_X, Vector3::UNIT_Y, Vector3::UNIT_Z, 1.0f, 2.0f, 3.0f));
+            dto.addOrUpdate("Mx", Matrix4(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f));
+            dto.addOrUpdate("Ss", std::vector<std::string>{ "a", "", "c" });
+            dto.addOrUpdate("U32s", std::vector<std::uint32_t>{ 0, 1, 4294967295u });
+            dto.addOrUpdate("Fs", std::vector<float>{ 0.25f, -1.0f / 3.0f });
+            dto.addOrUpdate("V2s", std::vector<Vector2>{ Vector2(1.0f, 2.0f), Vector2(3.0f, 4.0f) });
+            dto.addOrUpdate("V3s", std::vector<Vector3>{ Vector3(1.0f, 2.0f, 3.0f) });
+            dto.addOrUpdate("V4s", std::vector<Vector4>{});
+            dto.addOrUpdate("Mxs", std::vector<Matrix4>{ Matrix4::IDENTITY });
+            return { dto, GenericDto{} };
+        }
+
+        TEST_METHOD(TestSaxMatchesDomReference)
+        {
+            DtoJsonGateway gateway;
+            const std::string json = gateway.serialize(makeAllTypeDtos());
+            const auto sax_dtos = gateway.deserialize(json);
+            Assert::AreEqual(static_cast<size_t>(2), sax_dtos.size());
+            Assert::IsTrue(DtoDescriber::describe(sax_dtos) == DtoDescriber::describe(DomReference::deserialize(json)));
+            Assert::IsTrue(DtoDescriber::describe(sax_dtos) == DtoDescriber::describe(makeAllTypeDtos()));
+
+            for (auto& content : loadMediaContracts())
+            {
+                Assert::IsTrue(DtoDescriber::describe(gateway.deserialize(content)) == DtoDescriber::describe(DomReference::deserialize(content)));
+            }
+        }
+
+        TEST_METHOD(TestRejectsMalformedJson)
+        {
+            DtoJsonGateway gateway;
+            Assert::AreEqual(static_cast<size_t>(1), gateway.deserialize("[{}]  \r\n").size());
+            // 跟 DOM parse 一樣, root array 之後不能有其他資料
+            for (const char* json : { "[{}] x", "[{}]]", "[{}] []", "[{}],", "[{}", "{}", "" })
+            {
+                Assert::IsTrue(gateway.deserialize(json).empty());
+                Assert::IsTrue(DomReference::deserialize(json).empty());
+            }
+        }
+
+        /** Media 底下的 contract 檔, SAX 跟 DOM 的 parse 時間及 peak memory (單獨執行才準); 結果寫在 test output */
+        TEST_METHOD(BenchmarkParseMediaContracts)
+        {
+            constexpr int REPEAT = 20;
+            const auto contents = loadMediaContracts();
+            size_t bytes = 0;
+            for (auto& content : contents) bytes += content.size();
+            DtoJsonGateway gateway;
+            auto measure = [&contents](auto&& deserialize)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                size_t count = 0;
+                for (int i = 0; i < REPEAT; i++)
+                {
+                    for (auto& content : contents) count += deserialize(content).size();
+                }
+                return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / REPEAT;
+            };
+            // peak 只會增加, 先量 SAX 再量 DOM
+            const size_t base_peak = peakMemoryKB();
+            const double sax_ms = measure([&gateway](const std::string& json) { return gateway.deserialize(json); });
+            const size_t sax_peak = peakMemoryKB();
+            const double dom_ms = measure([](const std::string& json) { return DomReference::deserialize(json); });
+            const size_t dom_peak = peakMemoryKB();
+
+            char report[256];
+            snprintf(report, sizeof(report), "%zu files, %zu bytes: SAX %.2f ms (peak +%zu KB), DOM %.2f ms (peak +%zu KB)\n",
+                contents.size(), bytes, sax_ms, sax_peak - base_peak, dom_ms, dom_peak - sax_peak);
+            Logger::WriteMessage(report);
+            Assert::IsFalse(contents.empty());
+        }
+    };
+
+    TEST_CLASS(DtoBinaryGatewayTest)
+    {
+    public:
+        TEST_METHOD(TestJsonBinaryJsonRoundTripEveryValueTag)
+        {
+            DtoJsonGateway json_gateway;
+            DtoBinaryGateway binary_gateway;
+            const std::string json = json_gateway.serialize(DtoJsonGatewayTest::makeAllTypeDtos());
+            const auto json_dtos = json_gateway.deserialize(json);
+            const std::string binary = binary_gateway.serialize(json_dtos);
+            Assert::IsTrue(DtoBinaryGateway::isBinaryContent(binary.data(), binary.size()));
+            Assert::IsFalse(DtoBinaryGateway::isBinaryContent(json.data(), json.size()));
+            const auto binary_dtos = binary_gateway.deserialize(binary);
+            Assert::AreEqual(static_cast<size_t>(2), binary_dtos.size());
+            // 每種 ValueTag 都要還原成同樣的型別及數值
+            Assert::AreEqual(std::string::npos, DtoDescriber::describe(binary_dtos).find('?'));
+            Assert::IsTrue(DtoDescriber::describe(binary_dtos) == DtoDescriber::describe(json_dtos));
+            const auto& all_types = binary_dtos[0];
+            for (const char* attribute : { "Child", "Children", "U64", "U32", "F", "S", "B", "RGBA", "RGB", "V2", "V3", "V4", "Box", "Mx",
+                "Ss", "U32s", "Fs", "V2s", "V3s", "V4s", "Mxs" })
+            {
+                Assert::IsTrue(all_types.hasValue(attribute));
+            }
+
+            const std::string json_again = json_gateway.serialize(binary_dtos);
+            Assert::IsTrue(DtoDescriber::describe(json_gateway.deserialize(json_again)) == DtoDescriber::describe(json_dtos));
+            // attribute 順序不固定, 只比大小及內容
+            const std::string binary_again = binary_gateway.serialize(binary_dtos);
+            Assert::AreEqual(binary.size(), binary_again.size());
+            Assert::IsTrue(DtoDescriber::describe(binary_gateway.deserialize(binary_again)) == DtoDescriber::describe(json_dtos));
+        }
+
+        TEST_METHOD(TestRejectsTruncatedOrCorruptBuffer)
+        {
+            DtoBinaryGateway gateway;
+            const std::string binary = gateway.serialize(DtoJsonGatewayTest::makeAllTypeDtos());
+            // 任何截斷的長度都不能讀出部分的 dto
+            for (size_t size = 0; size < binary.size(); size++)
+            {
+                Assert::IsTrue(gateway.deserializeBuffer(binary.data(), size).empty());
+            }
+            Assert::AreEqual(static_cast<size_t>(2), gateway.deserializeBuffer(binary.data(), binary.size()).size());
+
+            // 檔案裡的 dto count 很大, 但沒有資料, 不能照 count 配置記憶體
+            std::string huge_count = binary.substr(0, 8);
+            const std::uint32_t count = 0xffffffffu;
+            huge_count.append(reinterpret_cast<const char*>(&count), sizeof(count));
+            Assert::IsTrue(gateway.deserialize(huge_count).empty());
+
+            // 版本不符, 及不認得的 tag
+            std::string wrong_version = binary;
+            wrong_version[4] = static_cast<char>(DtoBinaryGateway::FORMAT_VERSION + 1);
+            Assert::IsTrue(gateway.deserialize(wrong_version).empty());
+            GenericDto dto;
+            dto.addOrUpdate("U32", static_cast<std::uint32_t>(7));
+            std::string bad_tag = gateway.serialize({ dto });
+            const size_t tag_pos = bad_tag.find("U32") + 3;
+            Assert::AreEqual(static_cast<char>(DtoBinaryGateway::ValueTag::Uint32), bad_tag[tag_pos]);
+            bad_tag[tag_pos] = static_cast<char>(0xee);
+            Assert::IsTrue(gateway.deserialize(bad_tag).empty());
+        }
+    };
+}
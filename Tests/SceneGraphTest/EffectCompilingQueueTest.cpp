@@ -0,0 +1,221 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "GameEngine/EffectCompilingQueue.h"
+#include "GameEngine/EffectCompiler.h"
+#include "GameEngine/EffectMaterial.h"
+#include "GameEngine/EffectEvents.h"
+#include "GameEngine/EngineErrors.h"
+#include "GameEngine/ShaderRepository.h"
+#include "GameEngine/ShaderBuilder.h"
+#include "GameEngine/ShaderEvents.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/CommandBus.h"
+#include <memory>
+#include <string>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Engine;
+using namespace Enigma::Frameworks;
+
+namespace SceneGraphTest
+{
+    /** 看得到編譯中 / idle compiler 的 queue */
+    class ProbedCompilingQueue : public EffectCompilingQueue
+    {
+    public:
+        size_t compilingCount() { std::lock_guard locker{ m_queueLock }; return m_compilingEffects.size(); }
+        size_t idleCount() { std::lock_guard locker{ m_queueLock }; return m_idleCompilers.size(); }
+        size_t queuedCount() { std::lock_guard locker{ m_queueLock }; return m_queue.size(); }
+        bool isCompiling(const std::string& name) { std::lock_guard locker{ m_queueLock }; return m_compilingEffects.count(EffectMaterialId(name)) > 0; }
+    };
+
+    /** 看得到進行中 builder 跟等待中 policy 的 repository */
+    class ProbedShaderRepository : public ShaderRepository
+    {
+    public:
+        using ShaderRepository::ShaderRepository;
+        bool isBuilding(const std::string& program_name) { std::lock_guard locker{ m_policiesLock }; return m_buildingBuilders.count(program_name) > 0; }
+        size_t buildingCount() { std::lock_guard locker{ m_policiesLock }; return m_buildingBuilders.size(); }
+        size_t pendingCount() { std::lock_guard locker{ m_policiesLock }; return m_policies.size(); }
+        size_t idleCount() { std::lock_guard locker{ m_policiesLock }; return m_idleBuilders.size(); }
+    };
+
+    TEST_CLASS(EffectCompilingQueueTest)
+    {
+    public:
+        TEST_METHOD(TestCompletionEventsMatchCompilerById)
+        {
+            ServiceManager manager;
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+            manager.registerSystemService(std::make_shared<CommandBus>(&manager));
+            manager.runToState(ServiceManager::ServiceState::Running);
+            std::vector<std::string> compiled_ids;
+            std::vector<std::string> failed_ids;
+            auto on_compiled = std::make_shared<EventSubscriber>([&](auto e) { compiled_ids.push_back(std::dynamic_pointer_cast<EffectMaterialSourceCompiled>(e)->id().name()); });
+            auto on_failed = std::make_shared<EventSubscriber>([&](auto e) { failed_ids.push_back(std::dynamic_pointer_cast<CompileEffectMaterialSourceFailed>(e)->id().name()); });
+            EventPublisher::subscribe(typeid(EffectMaterialSourceCompiled), on_compiled);
+            EventPublisher::subscribe(typeid(CompileEffectMaterialSourceFailed), on_failed);
+            {
+                ProbedCompilingQueue queue;
+                const unsigned effect_count = EffectCompilingQueue::MAX_CONCURRENT_COMPILERS + 2;
+                std::vector<std::shared_ptr<EffectMaterial>> effects;
+                for (unsigned i = 0; i < effect_count; i++)
+                {
+                    effects.emplace_back(std::make_shared<EffectMaterial>(EffectMaterialId(effectName(i))));
+                    Assert::IsTrue(queue.enqueue(effects.back(), makeProfile(effectName(i))) == ErrorCode::ok);
+                }
+                Assert::IsTrue(queue.enqueue(effects.front(), makeProfile(effectName(0))) == ErrorCode::effectAlreadyCompiled);
+                Assert::IsTrue(queue.compileNextEffect() == ErrorCode::ok);
+                Assert::AreEqual(static_cast<size_t>(EffectCompilingQueue::MAX_CONCURRENT_COMPILERS), queue.compilingCount());
+                Assert::AreEqual(size_t{ 0 }, queue.idleCount());
+                Assert::AreEqual(size_t{ 2 }, queue.queuedCount());
+                Assert::IsTrue(effects[3]->lazyStatus().isLoading());
+                Assert::IsTrue(effects[4]->lazyStatus().isInQueue());
+
+                // 不照派送順序完成, 由 id 找回 compiler, 空出來的 compiler 接下一個
+                EventPublisher::publish(std::make_shared<EffectCompiler::EffectMaterialCompiled>(EffectMaterialId(effectName(2)), effects[2]));
+                Assert::IsFalse(queue.isCompiling(effectName(2)));
+                Assert::IsTrue(queue.isCompiling(effectName(4)));
+                Assert::IsTrue(effects[4]->lazyStatus().isLoading());
+                Assert::AreEqual(size_t{ 1 }, queue.queuedCount());
+
+                // 不認識的 id 跟重複的完成事件都不影響其他 compiler
+                EventPublisher::publish(std::make_shared<EffectCompiler::EffectMaterialCompiled>(EffectMaterialId("unknown_effect"), nullptr));
+                EventPublisher::publish(std::make_shared<EffectCompiler::EffectMaterialCompiled>(EffectMaterialId(effectName(2)), effects[2]));
+                Assert::AreEqual(static_cast<size_t>(EffectCompilingQueue::MAX_CONCURRENT_COMPILERS), queue.compilingCount());
+                Assert::AreEqual(size_t{ 1 }, queue.queuedCount());
+
+                EventPublisher::publish(std::make_shared<EffectCompiler::CompileEffectMaterialFailed>(EffectMaterialId(effectName(0)), ErrorCode::compilingEmptyEffectTech));
+                Assert::IsFalse(queue.isCompiling(effectName(0)));
+                Assert::IsTrue(queue.isCompiling(effectName(5)));
+                Assert::AreEqual(size_t{ 0 }, queue.queuedCount());
+
+                for (unsigned i : { 3u, 1u, 5u, 4u })
+                {
+                    EventPublisher::publish(std::make_shared<EffectCompiler::EffectMaterialCompiled>(EffectMaterialId(effectName(i)), effects[i]));
+                }
+                Assert::AreEqual(size_t{ 0 }, queue.compilingCount());
+                Assert::AreEqual(static_cast<size_t>(EffectCompilingQueue::MAX_CONCURRENT_COMPILERS), queue.idleCount());
+                manager.runOnce();
+            }
+            EventPublisher::unsubscribe(typeid(EffectMaterialSourceCompiled), on_compiled);
+            EventPublisher::unsubscribe(typeid(CompileEffectMaterialSourceFailed), on_failed);
+            Assert::IsTrue(compiled_ids == std::vector<std::string>{ effectName(2), effectName(3), effectName(1), effectName(5), effectName(4) });
+            Assert::IsTrue(failed_ids == std::vector<std::string>{ effectName(0) });
+        }
+
+        TEST_METHOD(TestFailedCompilerIsReusedByQueuedEffect)
+        {
+            ServiceManager manager;
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+            manager.registerSystemService(std::make_shared<CommandBus>(&manager));
+            manager.runToState(ServiceManager::ServiceState::Running);
+            std::vector<std::string> failed_ids;
+            auto on_failed = std::make_shared<EventSubscriber>([&](auto e) { failed_ids.push_back(std::dynamic_pointer_cast<CompileEffectMaterialSourceFailed>(e)->id().name()); });
+            EventPublisher::subscribe(typeid(CompileEffectMaterialSourceFailed), on_failed);
+            {
+                ProbedCompilingQueue queue;
+                // 沒有 technique 的 profile, compiler 自己送出失敗事件; 其他 compiler 仍在編譯中
+                std::vector<std::shared_ptr<EffectMaterial>> effects;
+                for (unsigned i = 0; i < EffectCompilingQueue::MAX_CONCURRENT_COMPILERS + 1; i++)
+                {
+                    effects.emplace_back(std::make_shared<EffectMaterial>(EffectMaterialId(effectName(i))));
+                    EffectCompilingProfile profile = (i == 1) ? EffectCompilingProfile{ effectName(i), {} } : makeProfile(effectName(i));
+                    Assert::IsTrue(queue.enqueue(effects.back(), profile) == ErrorCode::ok);
+                }
+                Assert::IsTrue(queue.compileNextEffect() == ErrorCode::ok);
+                Assert::IsTrue(queue.isCompiling(effectName(1)));
+                Assert::AreEqual(size_t{ 1 }, queue.queuedCount());
+                // 第一次 dispatch 處理 compiler 的失敗事件, 第二次送出 source 失敗事件
+                manager.runOnce();
+                manager.runOnce();
+                Assert::IsFalse(queue.isCompiling(effectName(1)));
+                Assert::IsTrue(queue.isCompiling(effectName(EffectCompilingQueue::MAX_CONCURRENT_COMPILERS)));
+                Assert::AreEqual(static_cast<size_t>(EffectCompilingQueue::MAX_CONCURRENT_COMPILERS), queue.compilingCount());
+            }
+            EventPublisher::unsubscribe(typeid(CompileEffectMaterialSourceFailed), on_failed);
+            Assert::IsTrue(failed_ids == std::vector<std::string>{ effectName(1) });
+        }
+
+        TEST_METHOD(TestBuildsWithClashingShaderNamesAreDeferred)
+        {
+            ServiceManager manager;
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+            manager.registerSystemService(std::make_shared<CommandBus>(&manager));
+            manager.runToState(ServiceManager::ServiceState::Running);
+            {
+                ProbedShaderRepository repository(&manager);
+                repository.onInit();
+                // b 跟 a 共用 vertex shader, d 跟 c 共用 pixel shader, e 跟 a 共用 layout
+                Assert::IsTrue(repository.buildShaderProgram(makePolicy("prog_a", "vs_shared", "layout_a", "ps_a")) == ErrorCode::ok);
+                Assert::IsTrue(repository.buildShaderProgram(makePolicy("prog_b", "vs_shared", "layout_b", "ps_b")) == ErrorCode::ok);
+                Assert::IsTrue(repository.buildShaderProgram(makePolicy("prog_c", "vs_c", "layout_c", "ps_shared")) == ErrorCode::ok);
+                Assert::IsTrue(repository.buildShaderProgram(makePolicy("prog_d", "vs_d", "layout_d", "ps_shared")) == ErrorCode::ok);
+                Assert::IsTrue(repository.buildShaderProgram(makePolicy("prog_e", "vs_e", "layout_a", "ps_e")) == ErrorCode::ok);
+                Assert::IsTrue(repository.isNeedTick());
+
+                repository.onTick();
+                Assert::AreEqual(size_t{ 2 }, repository.buildingCount());
+                Assert::IsTrue(repository.isBuilding("prog_a"));
+                Assert::IsTrue(repository.isBuilding("prog_c"));
+                Assert::AreEqual(size_t{ 3 }, repository.pendingCount());
+                // 還有 idle builder, 但等待中的都跟進行中的衝突, 要等完成事件
+                Assert::AreEqual(static_cast<size_t>(ShaderRepository::MAX_CONCURRENT_BUILDERS - 2), repository.idleCount());
+                Assert::IsFalse(repository.isNeedTick());
+
+                // 別的 program 的失敗事件不影響 a
+                EventPublisher::publish(std::make_shared<BuildShaderProgramFailed>("prog_unknown", ErrorCode::findStashedAssetFail));
+                Assert::IsTrue(repository.isBuilding("prog_a"));
+                Assert::IsFalse(repository.isNeedTick());
+
+                EventPublisher::publish(std::make_shared<BuildShaderProgramFailed>("prog_a", ErrorCode::findStashedAssetFail));
+                Assert::IsFalse(repository.isBuilding("prog_a"));
+                Assert::IsTrue(repository.isNeedTick());
+                repository.onTick();
+                Assert::IsTrue(repository.isBuilding("prog_b"));
+                Assert::IsTrue(repository.isBuilding("prog_c"));
+                Assert::IsTrue(repository.isBuilding("prog_e"));
+                Assert::IsFalse(repository.isBuilding("prog_d"));
+                Assert::AreEqual(size_t{ 1 }, repository.pendingCount());
+
+                // builder 完成 (沒有 device, program 是空的) 也會放回 builder, d 才能開始
+                EventPublisher::publish(std::make_shared<ShaderBuilder::ShaderProgramBuilt>("prog_c"));
+                Assert::IsFalse(repository.isBuilding("prog_c"));
+                repository.onTick();
+                Assert::IsTrue(repository.isBuilding("prog_d"));
+                Assert::AreEqual(size_t{ 0 }, repository.pendingCount());
+                Assert::AreEqual(size_t{ 3 }, repository.buildingCount());
+                repository.onTerm();
+            }
+        }
+
+    private:
+        static std::string effectName(unsigned i)
+        {
+            return "effect_" + std::to_string(i);
+        }
+
+        /** 一個 technique 一個 pass, 送出的 command 沒人處理, compiler 會一直停在編譯中 */
+        static EffectCompilingProfile makeProfile(const std::string& name)
+        {
+            EffectPassProfile pass;
+            pass.m_name = name + "_pass";
+            pass.m_program = makePolicy(name + "_program", name + "_vs", name + "_layout", name + "_ps");
+            EffectCompilingProfile profile;
+            profile.m_name = name;
+            profile.m_techniques.push_back(EffectTechniqueProfile{ "default", { pass } });
+            return profile;
+        }
+
+        static ShaderProgramPolicy makePolicy(const std::string& program, const std::string& vtx_shader, const std::string& layout, const std::string& pix_shader)
+        {
+            ShaderProgramPolicy policy;
+            policy.m_programName = program;
+            policy.m_vtxShaderName = vtx_shader;
+            policy.m_vtxLayoutName = layout;
+            policy.m_pixShaderName = pix_shader;
+            return policy;
+        }
+    };
+}
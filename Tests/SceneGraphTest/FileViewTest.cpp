@@ -0,0 +1,185 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "FileSystem/FileSystem.h"
+#include "FileSystem/FileView.h"
+#include "FileSystem/MappedFileRegion.h"
+#include "FileSystem/StdMountPath.h"
+#include "FileSystem/PackageMountPath.h"
+#include "AssetPackage/AssetPackageFile.h"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::FileSystem;
+
+namespace SceneGraphTest
+{
+    /** 每個 test 建自己的 file system, 暫存目錄掛在 FILE_PATH_ID 下, 結束時都清掉 */
+    class ViewScratch
+    {
+    public:
+        static inline const std::string FILE_PATH_ID = "ViewTestPath";
+        static inline const std::string PACKAGE_PATH_ID = "ViewTestPackage";
+
+        explicit ViewScratch(const std::string& name) : m_dir(std::filesystem::temp_directory_path() / ("EnigmaFileViewTest_" + name))
+        {
+            std::filesystem::remove_all(m_dir);
+            std::filesystem::create_directories(m_dir);
+            m_fileSystem.reset(Enigma::FileSystem::FileSystem::create());
+            m_fileSystem->addMountPath(std::make_shared<StdMountPath>(m_dir.generic_string(), FILE_PATH_ID));
+        }
+        ~ViewScratch()
+        {
+            m_fileSystem = nullptr;
+            m_package = nullptr;
+            std::error_code er;
+            std::filesystem::remove_all(m_dir, er);
+        }
+        std::string writeFile(const std::string& name, const std::string& content) const
+        {
+            std::ofstream file{ m_dir / name, std::ios::binary | std::ios::trunc };
+            file.write(content.data(), content.size());
+            return name + "@" + FILE_PATH_ID;
+        }
+        std::string addPackageAsset(const std::string& key, const std::string& content)
+        {
+            if (!m_package)
+            {
+                m_package.reset(Enigma::AssetPackage::AssetPackageFile::createNewPackage((m_dir / "package").string()));
+                m_fileSystem->addMountPath(std::make_shared<PackageMountPath>(m_package, PACKAGE_PATH_ID));
+            }
+            Assert::IsFalse(static_cast<bool>(m_package->addAssetMemory(std::vector<char>(content.begin(), content.end()), key, 1)));
+            return key + "@" + PACKAGE_PATH_ID;
+        }
+        std::string fullPath(const std::string& name) const { return (m_dir / name).string(); }
+        Enigma::FileSystem::FileSystem* fileSystem() const { return m_fileSystem.get(); }
+
+    private:
+        std::filesystem::path m_dir;
+        std::unique_ptr<Enigma::FileSystem::FileSystem> m_fileSystem;
+        std::shared_ptr<Enigma::AssetPackage::AssetPackageFile> m_package;
+    };
+
+    TEST_CLASS(FileViewTest)
+    {
+    public:
+        TEST_METHOD(TestMappedViewOutlivesClose)
+        {
+            ViewScratch scratch("OutlivesClose");
+            const std::string content = makeContent(10000);
+            const std::string filename = scratch.writeFile("mapped.bin", content);
+            std::optional<FileView> whole;
+            std::optional<FileView> tail;
+            {
+                IFilePtr file = scratch.fileSystem()->openFile(filename, read | binary);
+                Assert::IsTrue(static_cast<bool>(file));
+                whole = file->view(0, content.size());
+                tail = file->view(9000, 5000);
+                Assert::IsTrue(whole.has_value());
+                Assert::IsTrue(tail.has_value());
+                // 同一個 mapping, 不複製內容
+                Assert::IsTrue(whole->data() + 9000 == tail->data());
+                scratch.fileSystem()->closeFile(file);
+            }
+            Assert::AreEqual(content.size(), whole->size());
+            Assert::IsTrue(whole->asStringView() == content);
+            Assert::AreEqual(size_t{ 1000 }, tail->size());
+            Assert::IsTrue(tail->asStringView() == std::string_view(content).substr(9000));
+            // 檔案關了 (甚至刪了) view 還能用
+            std::filesystem::remove(scratch.fullPath("mapped.bin"));
+            Assert::IsTrue(whole->subView(5000, 10).asStringView() == std::string_view(content).substr(5000, 10));
+        }
+
+        TEST_METHOD(TestSubViewIsClampedToBounds)
+        {
+            ViewScratch scratch("SubView");
+            const std::string content = makeContent(256);
+            IFilePtr file = scratch.fileSystem()->openFile(scratch.writeFile("bounds.bin", content), read | binary);
+            Assert::IsTrue(static_cast<bool>(file));
+            auto view = file->view(0, content.size());
+            Assert::IsTrue(view.has_value());
+
+            Assert::IsTrue(view->subView(10, 20).asStringView() == std::string_view(content).substr(10, 20));
+            Assert::AreEqual(size_t{ 6 }, view->subView(250, 100).size());
+            Assert::IsTrue(view->subView(256, 1).empty());
+            Assert::IsTrue(view->subView(1000, 1).empty());
+            Assert::IsTrue(view->subView(1000, 1).data() == view->data() + view->size());
+            Assert::AreEqual(size_t{ 256 }, view->subView(0, static_cast<size_t>(-1)).size());
+            // sub view 的 sub view 以自己的範圍截斷
+            auto inner = view->subView(100, 50).subView(40, 100);
+            Assert::AreEqual(size_t{ 10 }, inner.size());
+            Assert::IsTrue(inner.data() == view->data() + 140);
+
+            Assert::IsTrue(file->view(200, 1000)->asStringView() == std::string_view(content).substr(200));
+            Assert::IsTrue(file->view(256, 1)->empty());
+            Assert::IsFalse(file->view(257, 1).has_value());
+            Assert::IsFalse(file->view(0, 0).has_value());
+            scratch.fileSystem()->closeFile(file);
+        }
+
+        TEST_METHOD(TestZeroLengthFileFallsBackToRead)
+        {
+            ViewScratch scratch("ZeroLength");
+            const std::string filename = scratch.writeFile("empty.bin", "");
+            // 空檔案不能 map, 改走 read()
+            Assert::IsFalse(static_cast<bool>(MappedFileRegion::map(scratch.fullPath("empty.bin"))));
+            Assert::IsFalse(static_cast<bool>(MappedFileRegion::map(scratch.fullPath("missing.bin"))));
+            IFilePtr file = scratch.fileSystem()->openFile(filename, read | binary);
+            Assert::IsTrue(static_cast<bool>(file));
+            auto view = file->view(0, 16);
+            Assert::IsTrue(view.has_value());
+            Assert::IsTrue(view->empty());
+            auto buff = file->read(0, 16);
+            Assert::IsTrue(buff.has_value());
+            Assert::IsTrue(buff->empty());
+            scratch.fileSystem()->closeFile(file);
+
+            // 寫入模式的 file 也是走 read()
+            const std::string content = makeContent(64);
+            IFilePtr writable = scratch.fileSystem()->openFile(scratch.writeFile("writable.bin", content), read | write | binary);
+            Assert::IsTrue(static_cast<bool>(writable));
+            auto writable_view = writable->view(0, content.size());
+            Assert::IsTrue(writable_view.has_value());
+            Assert::IsTrue(writable_view->asStringView() == content);
+            scratch.fileSystem()->closeFile(writable);
+        }
+
+        TEST_METHOD(TestPackageContentViewsShareBuffer)
+        {
+            ViewScratch scratch("Package");
+            const std::string content = makeContent(200000);
+            const std::string filename = scratch.addPackageAsset("asset.bin", content);
+            std::optional<FileView> whole;
+            std::optional<FileView> middle;
+            {
+                IFilePtr file = scratch.fileSystem()->openFile(filename, read | binary);
+                Assert::IsTrue(static_cast<bool>(file));
+                whole = file->view(0, content.size());
+                middle = file->view(100000, 10);
+                Assert::IsTrue(whole.has_value());
+                Assert::IsTrue(middle.has_value());
+                // 兩個 view 共用解壓後的 cache buffer
+                Assert::IsTrue(whole->data() + 100000 == middle->data());
+                Assert::IsTrue(file->view(150000, 1000000)->data() == whole->data() + 150000);
+                Assert::AreEqual(size_t{ 50000 }, file->view(150000, 1000000)->size());
+                Assert::IsFalse(file->view(content.size() + 1, 1).has_value());
+                scratch.fileSystem()->closeFile(file);
+            }
+            Assert::IsTrue(whole->asStringView() == content);
+            Assert::IsTrue(middle->asStringView() == std::string_view(content).substr(100000, 10));
+        }
+
+    private:
+        static std::string makeContent(size_t size)
+        {
+            std::string content(size, '\0');
+            for (size_t i = 0; i < size; i++)
+            {
+                content[i] = static_cast<char>('a' + (i * 7 + i / 13) % 26);
+            }
+            return content;
+        }
+    };
+}
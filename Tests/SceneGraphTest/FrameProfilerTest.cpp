@@ -0,0 +1,167 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "Frameworks/FrameProfiler.h"
+#include "Platforms/ProfileZone.h"
+#include "rapidjson/document.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Frameworks;
+using namespace Enigma::Platforms;
+
+namespace SceneGraphTest
+{
+    TEST_CLASS(FrameProfilerTest)
+    {
+    public:
+        TEST_METHOD(TestEndFrameAggregatesZonesAndCounters)
+        {
+            resetProfiler();
+            for (int i = 0; i < 3; i++)
+            {
+                ProfileZone zone("FrameProfilerTest::short");
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            std::thread([]()
+                {
+                    ProfileZone zone("FrameProfilerTest::long");
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                }).join();
+            FrameProfiler::addCounter(FrameProfiler::Counter::DrawCall, 5);
+            FrameProfiler::addCounter(FrameProfiler::Counter::DrawCall, 2);
+            FrameProfiler::addCounter(FrameProfiler::Counter::Bind, 3);
+            FrameProfiler::endFrame();
+
+            const FrameProfiler::FrameStatistics frame = FrameProfiler::lastFrameStatistics();
+            Assert::AreEqual(size_t{ 2 }, frame.m_zones.size());
+            // 依總時間排序, 結束的 thread 留下的 zone 也要收到
+            Assert::AreEqual(std::string("FrameProfilerTest::long"), frame.m_zones[0].m_name);
+            Assert::AreEqual(1u, frame.m_zones[0].m_callCount);
+            Assert::IsTrue(frame.m_zones[0].m_totalMilliseconds >= 20.0);
+            Assert::AreEqual(std::string("FrameProfilerTest::short"), frame.m_zones[1].m_name);
+            Assert::AreEqual(3u, frame.m_zones[1].m_callCount);
+            Assert::IsTrue(frame.m_zones[1].m_totalMilliseconds >= 3.0);
+            Assert::IsTrue(frame.m_zones[1].m_maxMilliseconds <= frame.m_zones[1].m_totalMilliseconds);
+            Assert::IsTrue(frame.m_zones[1].m_maxMilliseconds * 3.0 >= frame.m_zones[1].m_totalMilliseconds);
+            Assert::AreEqual(std::int64_t{ 7 }, counter(frame, FrameProfiler::Counter::DrawCall));
+            Assert::AreEqual(std::int64_t{ 3 }, counter(frame, FrameProfiler::Counter::Bind));
+            Assert::AreEqual(std::int64_t{ 0 }, counter(frame, FrameProfiler::Counter::Event));
+            Assert::IsTrue(frame.m_frameMilliseconds > 0.0);
+
+            // 每個 frame 重新統計
+            FrameProfiler::endFrame();
+            const FrameProfiler::FrameStatistics next = FrameProfiler::lastFrameStatistics();
+            Assert::AreEqual(frame.m_frameIndex + 1, next.m_frameIndex);
+            Assert::IsTrue(next.m_zones.empty());
+            Assert::AreEqual(std::int64_t{ 0 }, counter(next, FrameProfiler::Counter::DrawCall));
+        }
+        TEST_METHOD(TestDisabledProfilerRecordsNothing)
+        {
+            resetProfiler();
+            FrameProfiler::setEnabled(false);
+            {
+                ProfileZone zone("FrameProfilerTest::disabled");
+            }
+            FrameProfiler::addCounter(FrameProfiler::Counter::Command, 4);
+            FrameProfiler::endFrame();
+            FrameProfiler::setEnabled(true);
+
+            const FrameProfiler::FrameStatistics frame = FrameProfiler::lastFrameStatistics();
+            Assert::IsTrue(frame.m_zones.empty());
+            Assert::AreEqual(std::int64_t{ 0 }, counter(frame, FrameProfiler::Counter::Command));
+        }
+        TEST_METHOD(TestChromeTraceExportsCapturedFrames)
+        {
+            resetProfiler();
+            FrameProfiler::beginCapture(2);
+            std::thread([]()
+                {
+                    ProfileZone::setThreadName("ProfilerTest \"worker\"");
+                    ProfileZone zone("FrameProfilerTest::\"traced\"");
+                }).join();
+            FrameProfiler::addCounter(FrameProfiler::Counter::DrawCall, 9);
+            FrameProfiler::endFrame();
+            Assert::IsTrue(FrameProfiler::isCapturing());
+            FrameProfiler::endFrame();
+            Assert::IsFalse(FrameProfiler::isCapturing());
+            // capture 結束之後的 frame 不再記錄
+            {
+                ProfileZone zone("FrameProfilerTest::after");
+            }
+            FrameProfiler::endFrame();
+
+            const std::string json = FrameProfiler::exportChromeTrace();
+            rapidjson::Document document;
+            document.Parse(json.c_str());
+            Assert::IsFalse(document.HasParseError());
+            Assert::IsTrue(document.HasMember("traceEvents") && document["traceEvents"].IsArray());
+
+            unsigned worker_tid = 0;
+            unsigned traced_tid = 0;
+            unsigned frame_count = 0;
+            unsigned draw_call_count = 0;
+            std::int64_t first_draw_calls = -1;
+            double traced_ts = -1.0;
+            double first_frame_ts = -1.0;
+            for (auto& event : document["traceEvents"].GetArray())
+            {
+                const std::string phase = event["ph"].GetString();
+                const std::string name = event["name"].GetString();
+                if ((phase == "M") && (name == "thread_name") && (std::string(event["args"]["name"].GetString()) == "ProfilerTest \"worker\""))
+                {
+                    worker_tid = event["tid"].GetUint();
+                }
+                else if (phase == "X")
+                {
+                    Assert::AreNotEqual(std::string("FrameProfilerTest::after"), name);
+                    if (name != "FrameProfilerTest::\"traced\"") continue;
+                    traced_tid = event["tid"].GetUint();
+                    traced_ts = event["ts"].GetDouble();
+                    Assert::IsTrue(event["dur"].GetDouble() >= 0.0);
+                }
+                else if ((phase == "i") && (name == "Frame"))
+                {
+                    if (frame_count == 0) first_frame_ts = event["ts"].GetDouble();
+                    frame_count++;
+                }
+                else if ((phase == "C") && (name == "DrawCall"))
+                {
+                    if (draw_call_count == 0) first_draw_calls = event["args"]["value"].GetInt64();
+                    draw_call_count++;
+                }
+            }
+            Assert::AreNotEqual(0u, worker_tid);
+            Assert::AreEqual(worker_tid, traced_tid);
+            // zone 與 frame 用同一個時間基準, zone 在第一個 frame 結束之前
+            Assert::IsTrue((traced_ts >= 0.0) && (traced_ts <= first_frame_ts));
+            Assert::AreEqual(2u, frame_count);
+            Assert::AreEqual(2u, draw_call_count);
+            Assert::AreEqual(std::int64_t{ 9 }, first_draw_calls);
+
+            const std::filesystem::path trace_path = std::filesystem::temp_directory_path() / "enigma_frame_profiler_trace.json";
+            Assert::IsTrue(FrameProfiler::writeChromeTrace(trace_path.string()));
+            std::ifstream file(trace_path, std::ios::binary);
+            const std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            file.close();
+            std::filesystem::remove(trace_path);
+            Assert::AreEqual(json, written);
+        }
+
+    private:
+        /** 清掉先前留下的 zone 與 counter */
+        static void resetProfiler()
+        {
+            FrameProfiler::setEnabled(true);
+            FrameProfiler::endFrame();
+        }
+        static std::int64_t counter(const FrameProfiler::FrameStatistics& frame, FrameProfiler::Counter counter)
+        {
+            return frame.m_counters[static_cast<size_t>(counter)];
+        }
+    };
+}
@@ -0,0 +1,230 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "FileSystem/IoThreadPool.h"
+#include "FileSystem/IFile.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::FileSystem;
+
+namespace SceneGraphTest
+{
+    /** 佔住 I/O thread, 直到 open; 確定它開始執行後, 之後排的 request 都還在排隊 */
+    class IoThreadGate
+    {
+    public:
+        static constexpr std::chrono::seconds WAIT_TIMEOUT{ 5 };
+
+        void occupy(IoThreadPool& pool)
+        {
+            pool.pushRequest(IoThreadPool::Priority::High, [this]()
+                {
+                    m_started.set_value();
+                    m_opened.wait_for(WAIT_TIMEOUT);
+                });
+            Assert::IsTrue(m_started.get_future().wait_for(WAIT_TIMEOUT) == std::future_status::ready);
+        }
+        void open() { m_open.set_value(); }
+
+    private:
+        std::promise<void> m_started;
+        std::promise<void> m_open;
+        std::shared_future<void> m_opened{ m_open.get_future().share() };
+    };
+
+    /** 記錄 work 執行的順序 */
+    class ExecutionLog
+    {
+    public:
+        IoThreadPool::Work record(char name)
+        {
+            return [this, name]()
+            {
+                std::lock_guard locker{ m_lock };
+                m_order.push_back(name);
+                m_condition.notify_all();
+            };
+        }
+        std::string waitFor(size_t count)
+        {
+            std::unique_lock locker{ m_lock };
+            m_condition.wait_for(locker, IoThreadGate::WAIT_TIMEOUT, [&]() { return m_order.size() >= count; });
+            return m_order;
+        }
+
+    private:
+        std::mutex m_lock;
+        std::condition_variable m_condition;
+        std::string m_order;
+    };
+
+    /** 記憶體中的 file, 只給 async future API 用 */
+    class MemoryFile : public IFile
+    {
+    public:
+        explicit MemoryFile(const std::vector<unsigned char>& content) : m_content(content) {}
+        std::string getFullPath() override { return "memory"; }
+        std::optional<std::vector<unsigned char>> read(size_t offset, size_t size_request) override
+        {
+            if (offset >= m_content.size()) return std::nullopt;
+            const size_t end = std::min(m_content.size(), offset + size_request);
+            return std::vector<unsigned char>(m_content.begin() + offset, m_content.begin() + end);
+        }
+        size_t write(size_t offset, const std::vector<unsigned char>& in_buff) override
+        {
+            if (m_content.size() < offset + in_buff.size()) m_content.resize(offset + in_buff.size());
+            std::copy(in_buff.begin(), in_buff.end(), m_content.begin() + offset);
+            return in_buff.size();
+        }
+        size_t size() override { return m_content.size(); }
+        time_t filetime() override { return 0; }
+        bool isExisted() override { return true; }
+        bool isWritable() override { return true; }
+
+    protected:
+        error open() override { return error{}; }
+        error close() override { return error{}; }
+
+    private:
+        std::vector<unsigned char> m_content;
+    };
+
+    TEST_CLASS(IoThreadPoolTest)
+    {
+    public:
+        TEST_METHOD(TestHigherPriorityRunsFirst)
+        {
+            IoThreadPool pool(1);
+            IoThreadGate gate;
+            gate.occupy(pool);
+            ExecutionLog log;
+            pool.pushRequest(IoThreadPool::Priority::Low, log.record('l'));
+            pool.pushRequest(IoThreadPool::Priority::Normal, log.record('n'));
+            pool.pushRequest(IoThreadPool::Priority::Low, log.record('L'));
+            pool.pushRequest(IoThreadPool::Priority::High, log.record('h'));
+            pool.pushRequest(IoThreadPool::Priority::Normal, log.record('N'));
+            Assert::AreEqual(size_t{ 5 }, pool.pendingCount());
+            gate.open();
+            // 高優先權先, 同優先權照排入順序
+            Assert::AreEqual(std::string("hnNlL"), log.waitFor(5));
+        }
+
+        TEST_METHOD(TestCancelPendingRequest)
+        {
+            IoThreadPool pool(1);
+            IoThreadGate gate;
+            gate.occupy(pool);
+            ExecutionLog log;
+            unsigned cancelled_count = 0;
+            const auto cancelled = pool.pushRequest(IoThreadPool::Priority::Normal, log.record('c'), [&]() { cancelled_count++; });
+            const auto kept = pool.pushRequest(IoThreadPool::Priority::Normal, log.record('k'), [&]() { cancelled_count++; });
+            Assert::AreNotEqual(IoThreadPool::INVALID_REQUEST, cancelled);
+
+            Assert::IsTrue(pool.cancelRequest(cancelled));
+            Assert::AreEqual(1u, cancelled_count);
+            Assert::IsFalse(pool.cancelRequest(cancelled));
+            Assert::IsFalse(pool.cancelRequest(IoThreadPool::INVALID_REQUEST));
+            Assert::AreEqual(size_t{ 1 }, pool.pendingCount());
+
+            gate.open();
+            Assert::AreEqual(std::string("k"), log.waitFor(1));
+            // 已經執行過的不能取消, 也不會呼叫 cancel handler
+            Assert::IsFalse(pool.cancelRequest(kept));
+            Assert::AreEqual(1u, cancelled_count);
+        }
+
+        TEST_METHOD(TestPendingRequestsAreCancelledOnDestruction)
+        {
+            auto pool = std::make_unique<IoThreadPool>(1);
+            IoThreadGate gate;
+            gate.occupy(*pool);
+            ExecutionLog log;
+            std::atomic<unsigned> cancelled_count{ 0 };
+            for (char name : { 'a', 'b', 'c' })
+            {
+                pool->pushRequest(IoThreadPool::Priority::Normal, log.record(name), [&]() { cancelled_count++; });
+            }
+            // 解構時先清掉排隊的 request 才等 thread 結束; 清掉之後才放開佔住的 thread
+            IoThreadPool* destructing_pool = pool.get();
+            std::thread releaser([&]()
+                {
+                    while (destructing_pool->pendingCount() > 0) std::this_thread::yield();
+                    gate.open();
+                });
+            pool = nullptr;
+            releaser.join();
+            Assert::AreEqual(3u, cancelled_count.load());
+            Assert::AreEqual(std::string(""), log.waitFor(0));
+        }
+
+        TEST_METHOD(TestParallelForCoversEveryIndexOnce)
+        {
+            IoThreadPool pool(3);
+            constexpr size_t count = 1000;
+            std::vector<std::atomic<unsigned>> hits(count);
+            pool.parallelFor(count, [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; i++) hits[i]++;
+                }, 16);
+            for (size_t i = 0; i < count; i++) Assert::AreEqual(1u, hits[i].load());
+
+            // 比 min range 小就在呼叫端直接做完
+            std::thread::id worker_thread;
+            pool.parallelFor(8, [&](size_t begin, size_t end)
+                {
+                    Assert::AreEqual(size_t{ 0 }, begin);
+                    Assert::AreEqual(size_t{ 8 }, end);
+                    worker_thread = std::this_thread::get_id();
+                }, 16);
+            Assert::IsTrue(worker_thread == std::this_thread::get_id());
+        }
+
+        TEST_METHOD(TestParallelForFromBusyIoThreadCompletes)
+        {
+            // 唯一的 I/O thread 自己呼叫 parallelFor, helper 排不到也要能做完
+            IoThreadPool pool(1);
+            std::promise<size_t> done;
+            pool.pushRequest(IoThreadPool::Priority::Normal, [&]()
+                {
+                    std::atomic<size_t> sum{ 0 };
+                    pool.parallelFor(100, [&](size_t begin, size_t end)
+                        {
+                            for (size_t i = begin; i < end; i++) sum += i;
+                        });
+                    done.set_value(sum.load());
+                });
+            auto result = done.get_future();
+            Assert::IsTrue(result.wait_for(IoThreadGate::WAIT_TIMEOUT) == std::future_status::ready);
+            Assert::AreEqual(size_t{ 4950 }, result.get());
+        }
+
+        TEST_METHOD(TestFutureApiCompletesInlineOnIoThread)
+        {
+            Assert::IsFalse(IoThreadPool::isIoThread());
+            IoThreadPool pool(1);
+            MemoryFile file({ 1, 2, 3, 4 });
+            std::promise<bool> checked;
+            pool.pushRequest(IoThreadPool::Priority::Normal, [&]()
+                {
+                    // 在 I/O thread 上等 future 不能靠別的 I/O thread 完成
+                    auto read = file.asyncRead(1, 2);
+                    auto written = file.asyncWrite(4, { 5 });
+                    const bool is_ready = IoThreadPool::isIoThread()
+                        && (read.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                        && (written.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+                    checked.set_value(is_ready && (read.get() == std::vector<unsigned char>{ 2, 3 }) && (written.get() == 1));
+                });
+            auto result = checked.get_future();
+            Assert::IsTrue(result.wait_for(IoThreadGate::WAIT_TIMEOUT) == std::future_status::ready);
+            Assert::IsTrue(result.get());
+            Assert::AreEqual(size_t{ 5 }, file.size());
+        }
+    };
+}
@@ -0,0 +1,226 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "Platforms/LogRecordRing.h"
+#include "Platforms/PlatformLayer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Platforms;
+
+namespace SceneGraphTest
+{
+    TEST_CLASS(LogRecordRingTest)
+    {
+    public:
+        TEST_METHOD(TestCapacityRoundsUpToPowerOfTwo)
+        {
+            Assert::AreEqual(size_t{ 8 }, LogRecordRing(5).capacity());
+            Assert::AreEqual(size_t{ 8 }, LogRecordRing(8).capacity());
+            Assert::AreEqual(size_t{ 2 }, LogRecordRing(1).capacity());
+        }
+        TEST_METHOD(TestFullRingRejectsPush)
+        {
+            LogRecordRing ring(8);
+            LogRecord record;
+            for (std::uint32_t i = 0; i < 8; i++)
+            {
+                Assert::IsTrue(ring.tryPush(makeRecord(0, i)));
+            }
+            Assert::IsFalse(ring.tryPush(makeRecord(0, 8)));
+            // 騰出一格之後又可以 push, 被拒絕的那筆不會佔位置
+            Assert::IsTrue(ring.tryPop(record));
+            Assert::AreEqual(0u, record.m_line);
+            Assert::IsTrue(ring.tryPush(makeRecord(0, 9)));
+            Assert::IsFalse(ring.tryPush(makeRecord(0, 10)));
+            for (std::uint32_t expected : { 1u, 2u, 3u, 4u, 5u, 6u, 7u, 9u })
+            {
+                Assert::IsTrue(ring.tryPop(record));
+                Assert::AreEqual(expected, record.m_line);
+                assertMessage(record, 0, expected);
+            }
+            Assert::IsFalse(ring.tryPop(record));
+        }
+        TEST_METHOD(TestWraparoundKeepsOrderAndContent)
+        {
+            LogRecordRing ring(4);
+            LogRecord record;
+            std::uint32_t pushed = 0;
+            std::uint32_t popped = 0;
+            // 每輪 push 3 筆 pop 3 筆, slot 的位置一直在繞圈, sequence 號碼遠大於 capacity
+            for (int round = 0; round < 500; round++)
+            {
+                for (int i = 0; i < 3; i++) Assert::IsTrue(ring.tryPush(makeRecord(0, pushed++)));
+                for (int i = 0; i < 3; i++)
+                {
+                    Assert::IsTrue(ring.tryPop(record));
+                    Assert::AreEqual(popped, record.m_line);
+                    assertMessage(record, 0, popped);
+                    popped++;
+                }
+                Assert::IsFalse(ring.tryPop(record));
+            }
+            Assert::AreEqual(1500u, popped);
+        }
+        TEST_METHOD(TestConcurrentProducersLoseNothing)
+        {
+            constexpr std::uint32_t PRODUCER_COUNT = 4;
+            constexpr std::uint32_t RECORD_COUNT = 5000;
+            LogRecordRing ring(64);
+            std::vector<std::thread> producers;
+            for (std::uint32_t p = 0; p < PRODUCER_COUNT; p++)
+            {
+                producers.emplace_back([&ring, p]()
+                    {
+                        for (std::uint32_t i = 0; i < RECORD_COUNT; i++)
+                        {
+                            const LogRecord record = makeRecord(p, i);
+                            while (!ring.tryPush(record)) std::this_thread::yield();
+                        }
+                    });
+            }
+            std::vector<std::uint32_t> next(PRODUCER_COUNT, 0);
+            std::uint32_t received = 0;
+            LogRecord record;
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while ((received < PRODUCER_COUNT * RECORD_COUNT) && (std::chrono::steady_clock::now() < deadline))
+            {
+                if (!ring.tryPop(record))
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                Assert::IsTrue(record.m_threadIndex < PRODUCER_COUNT);
+                // 同一個 producer 的 log 要照順序出來, 不能漏也不能重複
+                Assert::AreEqual(next[record.m_threadIndex], record.m_line);
+                assertMessage(record, record.m_threadIndex, record.m_line);
+                next[record.m_threadIndex]++;
+                received++;
+            }
+            for (auto& producer : producers) producer.join();
+            Assert::AreEqual(PRODUCER_COUNT * RECORD_COUNT, received);
+            Assert::IsFalse(ring.tryPop(record));
+        }
+        TEST_METHOD(TestLogFmtWritesFormattedRecord)
+        {
+            const std::filesystem::path log_path = logFilePath("fmt");
+            Enigma::Platforms::Logger::InitLoggerFile(log_path.string());
+            LOG_FMT(Error, "value %d %s", 42, "abc");
+            // 超過 record 長度的訊息要截斷, 不能寫出界
+            LOG_FMT(Error, "%s", std::string(LogRecord::MAX_MESSAGE_LENGTH * 2, 'x').c_str());
+            Enigma::Platforms::Logger::CloseLoggerFile();
+
+            const std::vector<std::string> lines = readMessages(log_path);
+            std::filesystem::remove(log_path);
+            Assert::AreEqual(size_t{ 2 }, lines.size());
+            Assert::AreEqual(std::string("value 42 abc"), lines[0]);
+            Assert::AreEqual(std::string(LogRecord::MAX_MESSAGE_LENGTH - 1, 'x'), lines[1]);
+        }
+        TEST_METHOD(TestCloseDrainsRecordsLoggedBeforeClose)
+        {
+            constexpr std::uint32_t RECORD_COUNT = 3000;
+            const std::filesystem::path log_path = logFilePath("drain");
+            Enigma::Platforms::Logger::InitLoggerFile(log_path.string());
+            // 比 ring 大很多, writer 來不及寫的部分要在 close 時寫出
+            for (std::uint32_t i = 0; i < RECORD_COUNT; i++)
+            {
+                LOG_FMT(Error, "P%u #%u", 0u, i);
+            }
+            Enigma::Platforms::Logger::CloseLoggerFile();
+
+            const std::vector<std::uint32_t> sequences = readSequences(log_path, 1)[0];
+            std::filesystem::remove(log_path);
+            Assert::AreEqual(size_t{ RECORD_COUNT }, sequences.size());
+            for (std::uint32_t i = 0; i < RECORD_COUNT; i++) Assert::AreEqual(i, sequences[i]);
+        }
+        TEST_METHOD(TestCloseWhileProducersAreLogging)
+        {
+            constexpr std::uint32_t PRODUCER_COUNT = 4;
+            const std::filesystem::path log_path = logFilePath("close");
+            Enigma::Platforms::Logger::InitLoggerFile(log_path.string());
+            std::atomic<bool> is_closed{ false };
+            std::atomic<std::uint32_t> started{ 0 };
+            std::vector<std::thread> producers;
+            for (std::uint32_t p = 0; p < PRODUCER_COUNT; p++)
+            {
+                producers.emplace_back([&is_closed, &started, p]()
+                    {
+                        started++;
+                        for (std::uint32_t i = 0; !is_closed.load(); i++)
+                        {
+                            LOG_FMT(Error, "P%u #%u", p, i);
+                        }
+                    });
+            }
+            while (started.load() < PRODUCER_COUNT) std::this_thread::yield();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            Enigma::Platforms::Logger::CloseLoggerFile();
+            is_closed.store(true);
+            for (auto& producer : producers) producer.join();
+
+            // close 之前 push 進 ring 的都要寫出; 每個 producer 寫出的是從 0 開始沒有缺號的前段
+            const std::vector<std::vector<std::uint32_t>> sequences = readSequences(log_path, PRODUCER_COUNT);
+            std::filesystem::remove(log_path);
+            for (std::uint32_t p = 0; p < PRODUCER_COUNT; p++)
+            {
+                Assert::IsFalse(sequences[p].empty());
+                for (std::uint32_t i = 0; i < sequences[p].size(); i++) Assert::AreEqual(i, sequences[p][i]);
+            }
+        }
+
+    private:
+        static LogRecord makeRecord(std::uint32_t producer, std::uint32_t index)
+        {
+            LogRecord record{};
+            record.m_threadIndex = producer;
+            record.m_line = index;
+            record.m_level = static_cast<std::uint8_t>(Enigma::Platforms::Logger::Level::Info);
+            const int written = snprintf(record.m_message, LogRecord::MAX_MESSAGE_LENGTH, "P%u #%u", producer, index);
+            record.m_length = static_cast<std::uint16_t>(written);
+            return record;
+        }
+        static void assertMessage(const LogRecord& record, std::uint32_t producer, std::uint32_t index)
+        {
+            char expected[64];
+            snprintf(expected, sizeof(expected), "P%u #%u", producer, index);
+            Assert::AreEqual(std::string(expected), std::string(record.m_message, record.m_length));
+        }
+        static std::filesystem::path logFilePath(const std::string& name)
+        {
+            return std::filesystem::temp_directory_path() / ("enigma_log_ring_" + name + ".log");
+        }
+        /** 取出每行 "[Error] " 之後的訊息 */
+        static std::vector<std::string> readMessages(const std::filesystem::path& log_path)
+        {
+            std::vector<std::string> messages;
+            std::ifstream file(log_path);
+            std::string line;
+            const std::string token = "[Error] ";
+            while (std::getline(file, line))
+            {
+                const size_t pos = line.find(token);
+                if (pos != std::string::npos) messages.push_back(line.substr(pos + token.length()));
+            }
+            return messages;
+        }
+        static std::vector<std::vector<std::uint32_t>> readSequences(const std::filesystem::path& log_path, std::uint32_t producer_count)
+        {
+            std::vector<std::vector<std::uint32_t>> sequences(producer_count);
+            for (const auto& message : readMessages(log_path))
+            {
+                unsigned producer = 0;
+                unsigned index = 0;
+                Assert::AreEqual(2, sscanf(message.c_str(), "P%u #%u", &producer, &index));
+                Assert::IsTrue(producer < producer_count);
+                sequences[producer].push_back(index);
+            }
+            return sequences;
+        }
+    };
+}
@@ -0,0 +1,210 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "FileSystem/FileSystem.h"
+#include "FileSystem/FileSystemErrors.h"
+#include "FileSystem/StdMountPath.h"
+#include "FileStorage/MapperFileJournal.h"
+#include "FileStorage/GeometryDataFileStoreMapper.h"
+#include "Gateways/DtoJsonGateway.h"
+#include "GameEngine/GenericDto.h"
+#include "GameEngine/FactoryDesc.h"
+#include "GameEngine/EngineErrors.h"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::FileStorage;
+using namespace Enigma::Engine;
+
+namespace SceneGraphTest
+{
+    /** 每個 test 建自己的 file system, 暫存目錄掛在 TEST_PATH_ID 下, 結束時都清掉 */
+    class MapperScratch
+    {
+    public:
+        static inline const std::string TEST_PATH_ID = "MapperTestPath";
+
+        explicit MapperScratch(const std::string& name) : m_dir(std::filesystem::temp_directory_path() / ("EnigmaMapperFileJournalTest_" + name))
+        {
+            std::filesystem::remove_all(m_dir);
+            std::filesystem::create_directories(m_dir);
+            m_fileSystem.reset(Enigma::FileSystem::FileSystem::create());
+            m_fileSystem->addMountPath(std::make_shared<Enigma::FileSystem::StdMountPath>(m_dir.generic_string(), TEST_PATH_ID));
+        }
+        ~MapperScratch()
+        {
+            m_fileSystem = nullptr;
+            std::error_code er;
+            std::filesystem::remove_all(m_dir, er);
+        }
+        /** engine 用的 "name@PathId" */
+        std::string filename(const std::string& name) const { return name + "@" + TEST_PATH_ID; }
+        std::filesystem::path realPath(const std::string& name) const { return m_dir / name; }
+
+    private:
+        std::filesystem::path m_dir;
+        std::unique_ptr<Enigma::FileSystem::FileSystem> m_fileSystem;
+    };
+
+    TEST_CLASS(MapperFileJournalTest)
+    {
+    public:
+        TEST_METHOD(TestReplayAppliesPutAndRemoveInOrder)
+        {
+            MapperScratch scratch("replay");
+            MapperFileJournal journal(scratch.filename("mapper.txt"));
+            Assert::IsTrue(journal.appendPut("a,a.json") == Enigma::FileSystem::ErrorCode::ok);
+            Assert::IsTrue(journal.appendPut("b,b.json") == Enigma::FileSystem::ErrorCode::ok);
+            Assert::IsTrue(journal.appendRemove("a,a.json") == Enigma::FileSystem::ErrorCode::ok);
+            Assert::AreEqual(3u, journal.recordCount());
+
+            MapperFileJournal reopened(scratch.filename("mapper.txt"));
+            const auto records = replayRecords(reopened);
+            Assert::AreEqual(size_t{ 3 }, records.size());
+            Assert::IsTrue(records[0] == std::make_pair(true, std::string("a,a.json")));
+            Assert::IsTrue(records[1] == std::make_pair(true, std::string("b,b.json")));
+            Assert::IsTrue(records[2] == std::make_pair(false, std::string("a,a.json")));
+            Assert::AreEqual(3u, reopened.recordCount());
+        }
+
+        TEST_METHOD(TestTornLastRecordIsSkippedAndTruncated)
+        {
+            MapperScratch scratch("torn");
+            MapperFileJournal journal(scratch.filename("mapper.txt"));
+            Assert::IsTrue(journal.appendPut("a,a.json") == Enigma::FileSystem::ErrorCode::ok);
+            {
+                // 寫到一半中斷, 最後一筆沒有換行
+                std::ofstream torn(scratch.realPath("mapper.txt.journal"), std::ios::binary | std::ios::app);
+                torn << "+b,b.js";
+            }
+
+            MapperFileJournal reopened(scratch.filename("mapper.txt"));
+            auto records = replayRecords(reopened);
+            Assert::AreEqual(size_t{ 1 }, records.size());
+            Assert::IsTrue(records[0] == std::make_pair(true, std::string("a,a.json")));
+
+            // 截掉中斷的紀錄後, 新的紀錄不會接在它後面
+            Assert::IsTrue(reopened.appendPut("c,c.json") == Enigma::FileSystem::ErrorCode::ok);
+            MapperFileJournal again(scratch.filename("mapper.txt"));
+            records = replayRecords(again);
+            Assert::AreEqual(size_t{ 2 }, records.size());
+            Assert::IsTrue(records[1] == std::make_pair(true, std::string("c,c.json")));
+        }
+
+        TEST_METHOD(TestCompactionAtThreshold)
+        {
+            MapperScratch scratch("compact");
+            constexpr unsigned threshold = 3;
+            MapperFileJournal journal(scratch.filename("mapper.txt"), threshold);
+            for (unsigned i = 0; i < threshold; i++)
+            {
+                Assert::IsFalse(journal.needCompaction());
+                Assert::IsTrue(journal.appendPut("r" + std::to_string(i) + ",r.json") == Enigma::FileSystem::ErrorCode::ok);
+            }
+            Assert::IsTrue(journal.needCompaction());
+
+            const std::string content = "r0,r.json\nr1,r.json\nr2,r.json\n";
+            Assert::IsTrue(journal.compact(content) == Enigma::FileSystem::ErrorCode::ok);
+            Assert::AreEqual(0u, journal.recordCount());
+            Assert::IsFalse(journal.needCompaction());
+            Assert::AreEqual(std::uintmax_t{ 0 }, std::filesystem::file_size(scratch.realPath("mapper.txt.journal")));
+
+            MapperFileJournal reopened(scratch.filename("mapper.txt"), threshold);
+            const auto mapper_content = reopened.readMapperFile();
+            Assert::IsTrue(mapper_content.has_value());
+            Assert::AreEqual(content, mapper_content.value());
+            Assert::AreEqual(size_t{ 0 }, replayRecords(reopened).size());
+        }
+
+    private:
+        static std::vector<std::pair<bool, std::string>> replayRecords(MapperFileJournal& journal)
+        {
+            std::vector<std::pair<bool, std::string>> records;
+            auto er = journal.replay([&](bool is_put, const std::string& record) { records.emplace_back(is_put, record); });
+            Assert::IsTrue(er == Enigma::FileSystem::ErrorCode::ok);
+            return records;
+        }
+    };
+
+    TEST_CLASS(FileStoreMapperJournalTest)
+    {
+    public:
+        TEST_METHOD(TestFilenameMapIsRebuiltFromJournal)
+        {
+            MapperScratch scratch("geometry_journal");
+            const auto mapper_filename = scratch.filename("geometry.mapper");
+            const auto crashed_filename = scratch.filename("crashed.mapper");
+            {
+                auto mapper = makeMapper(mapper_filename);
+                Assert::IsTrue(mapper->connect() == Enigma::FileSystem::ErrorCode::ok);
+                putGeometries(*mapper, scratch);
+                // 沒有 disconnect 的狀態: 只有 journal, 沒有 mapper file
+                Assert::IsFalse(std::filesystem::exists(scratch.realPath("geometry.mapper")));
+                std::filesystem::copy_file(scratch.realPath("geometry.mapper.journal"), scratch.realPath("crashed.mapper.journal"));
+                Assert::IsTrue(mapper->disconnect() == Enigma::FileSystem::ErrorCode::ok);
+            }
+
+            auto crashed = makeMapper(crashed_filename);
+            Assert::IsTrue(crashed->connect() == Enigma::FileSystem::ErrorCode::ok);
+            assertGeometriesRebuilt(*crashed);
+            Assert::IsTrue(crashed->disconnect() == Enigma::FileSystem::ErrorCode::ok);
+        }
+
+        TEST_METHOD(TestFilenameMapIsRebuiltAfterCompaction)
+        {
+            MapperScratch scratch("geometry_compact");
+            const auto mapper_filename = scratch.filename("geometry.mapper");
+            {
+                auto mapper = makeMapper(mapper_filename);
+                Assert::IsTrue(mapper->connect() == Enigma::FileSystem::ErrorCode::ok);
+                putGeometries(*mapper, scratch);
+                // disconnect 時 compact
+                Assert::IsTrue(mapper->disconnect() == Enigma::FileSystem::ErrorCode::ok);
+            }
+            Assert::AreEqual(std::uintmax_t{ 0 }, std::filesystem::file_size(scratch.realPath("geometry.mapper.journal")));
+
+            auto reopened = makeMapper(mapper_filename);
+            Assert::IsTrue(reopened->connect() == Enigma::FileSystem::ErrorCode::ok);
+            assertGeometriesRebuilt(*reopened);
+            Assert::IsTrue(reopened->disconnect() == Enigma::FileSystem::ErrorCode::ok);
+        }
+
+    private:
+        static std::unique_ptr<GeometryDataFileStoreMapper> makeMapper(const std::string& mapper_filename)
+        {
+            return std::make_unique<GeometryDataFileStoreMapper>(mapper_filename, std::make_shared<Enigma::Gateways::DtoJsonGateway>());
+        }
+        /** put a, b, c 再 remove b, 最後 a 改存到另一個檔案 */
+        static void putGeometries(GeometryDataFileStoreMapper& mapper, const MapperScratch& scratch)
+        {
+            for (const std::string name : { "a", "b", "c" })
+            {
+                Assert::IsTrue(mapper.putGeometry(Enigma::Geometries::GeometryId{ name }, makeDto(name, scratch.filename(name + ".json"))) == ErrorCode::ok);
+            }
+            Assert::IsTrue(mapper.removeGeometry(Enigma::Geometries::GeometryId{ "b" }) == ErrorCode::ok);
+            Assert::IsTrue(mapper.putGeometry(Enigma::Geometries::GeometryId{ "a" }, makeDto("a2", scratch.filename("a2.json"))) == ErrorCode::ok);
+        }
+        static void assertGeometriesRebuilt(GeometryDataFileStoreMapper& mapper)
+        {
+            Assert::IsTrue(mapper.hasGeometry(Enigma::Geometries::GeometryId{ "a" }));
+            Assert::IsFalse(mapper.hasGeometry(Enigma::Geometries::GeometryId{ "b" }));
+            Assert::IsTrue(mapper.hasGeometry(Enigma::Geometries::GeometryId{ "c" }));
+            auto a = mapper.queryGeometry(Enigma::Geometries::GeometryId{ "a" });
+            Assert::IsTrue(a.has_value());
+            Assert::AreEqual(std::string("a2"), a->getName());
+            auto c = mapper.queryGeometry(Enigma::Geometries::GeometryId{ "c" });
+            Assert::IsTrue(c.has_value());
+            Assert::AreEqual(std::string("c"), c->getName());
+        }
+        static GenericDto makeDto(const std::string& name, const std::string& filename)
+        {
+            GenericDto dto;
+            dto.addName(name);
+            dto.addRtti(FactoryDesc("TestGeometry").claimAsResourceAsset(name, filename));
+            return dto;
+        }
+    };
+}
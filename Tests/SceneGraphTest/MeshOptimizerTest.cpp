@@ -0,0 +1,202 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "Geometries/MeshOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <random>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Geometries;
+
+namespace SceneGraphTest
+{
+    TEST_CLASS(MeshOptimizerTest)
+    {
+    public:
+        TEST_METHOD(TestWeldKeepsTriangleSet)
+        {
+            // 每個 triangle 自己一組 vertex, 跟 dae split 出來的一樣
+            std::vector<float> positions;
+            std::vector<unsigned> indices;
+            makeTriangleSoup(16, 12, 7u, positions, indices);
+            const auto triangles_before = collectTriangles(indices, positions, 3);
+
+            std::vector<unsigned> remap;
+            const unsigned welded_count = MeshOptimizer::weldVertices(positions, 3, remap);
+            Assert::AreEqual(17u * 13u, welded_count);
+            Assert::AreEqual(positions.size() / 3, remap.size());
+            MeshOptimizer::remapIndices(indices, remap);
+            const std::vector<float> welded = MeshOptimizer::remapVertices(positions, remap, welded_count, 3);
+            for (unsigned index : indices) Assert::IsTrue(index < welded_count);
+            Assert::IsTrue(triangles_before == collectTriangles(indices, welded, 3));
+        }
+        TEST_METHOD(TestWeldKeepsVerticesWithDifferentAttributes)
+        {
+            // 位置相同, normal 不同 (硬邊) 不能合併; -0 跟 +0 視為相同
+            const std::vector<float> vertices{
+                0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+                0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+                -0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+                1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+            std::vector<unsigned> remap;
+            Assert::AreEqual(3u, MeshOptimizer::weldVertices(vertices, 6, remap));
+            Assert::AreEqual(remap[0], remap[2]);
+            Assert::AreNotEqual(remap[0], remap[1]);
+            Assert::AreNotEqual(remap[0], remap[3]);
+        }
+        TEST_METHOD(TestVertexCacheDoesNotWorsenAcmr)
+        {
+            std::vector<float> positions;
+            std::vector<unsigned> soup;
+            makeTriangleSoup(40, 30, 11u, positions, soup);
+            std::vector<unsigned> remap;
+            const unsigned vertex_count = MeshOptimizer::weldVertices(positions, 3, remap);
+            MeshOptimizer::remapIndices(soup, remap);
+            const std::vector<float> welded = MeshOptimizer::remapVertices(positions, remap, vertex_count, 3);
+
+            // 打亂順序的 grid 跟照列排好的 grid, 最佳化後都不能比原本差
+            std::vector<unsigned> row_ordered = soup;
+            sortTrianglesByFirstIndex(row_ordered);
+            for (auto* input : { &soup, &row_ordered })
+            {
+                std::vector<unsigned> indices = *input;
+                const auto triangles_before = collectTriangles(indices, welded, 3);
+                const float acmr_before = MeshOptimizer::calculateAcmr(indices, vertex_count);
+                MeshOptimizer::optimizeVertexCache(indices, vertex_count);
+                const float acmr_after = MeshOptimizer::calculateAcmr(indices, vertex_count);
+                Assert::IsTrue(acmr_after <= acmr_before);
+                Assert::IsTrue(acmr_after < 1.0f);
+                Assert::IsTrue(triangles_before == collectTriangles(indices, welded, 3));
+            }
+        }
+        TEST_METHOD(TestVertexFetchOrdersByFirstUse)
+        {
+            std::vector<unsigned> indices{ 4, 2, 0, 2, 4, 5, 5, 0, 2 };
+            std::vector<unsigned> remap;
+            // vertex 1, 3 沒有被用到
+            Assert::AreEqual(4u, MeshOptimizer::optimizeVertexFetch(indices, 6, remap));
+            Assert::IsTrue(indices == std::vector<unsigned>{ 0, 1, 2, 1, 0, 3, 3, 2, 1 });
+            Assert::IsTrue(remap == std::vector<unsigned>{ 2, MeshOptimizer::UNUSED_VERTEX, 1, MeshOptimizer::UNUSED_VERTEX, 0, 3 });
+        }
+        TEST_METHOD(TestSkinWeightsFollowVertices)
+        {
+            std::vector<float> positions;
+            std::vector<unsigned> indices;
+            makeTriangleSoup(12, 10, 3u, positions, indices);
+            const unsigned soup_count = static_cast<unsigned>(positions.size() / 3);
+            // 4 個 weight 與 palette index 都由位置決定, 同位置的 vertex 有相同的 skin
+            std::vector<float> weights;
+            std::vector<unsigned> palettes;
+            for (unsigned i = 0; i < soup_count; i++)
+            {
+                const float x = positions[i * 3];
+                const float z = positions[i * 3 + 2];
+                const float w = x / 12.0f;
+                weights.insert(weights.end(), { w * 0.5f, (1.0f - w) * 0.5f, z / 20.0f, 0.5f - z / 20.0f });
+                palettes.push_back(static_cast<unsigned>(x) | (static_cast<unsigned>(z) << 8));
+            }
+            const auto corners_before = collectCorners(indices, positions, weights, palettes);
+
+            // 跟 DaeMeshVerticesParser 一樣: weld 時 skin 算進 attribute, 然後 cache, fetch
+            std::vector<float> attributes;
+            for (unsigned i = 0; i < soup_count; i++)
+            {
+                attributes.insert(attributes.end(), positions.begin() + i * 3, positions.begin() + i * 3 + 3);
+                attributes.insert(attributes.end(), weights.begin() + i * 4, weights.begin() + i * 4 + 4);
+                attributes.push_back(static_cast<float>(palettes[i]));
+            }
+            std::vector<unsigned> remap;
+            unsigned vertex_count = MeshOptimizer::weldVertices(attributes, 8, remap);
+            Assert::AreEqual(13u * 11u, vertex_count);
+            MeshOptimizer::remapIndices(indices, remap);
+            positions = MeshOptimizer::remapVertices(positions, remap, vertex_count, 3);
+            weights = MeshOptimizer::remapVertices(weights, remap, vertex_count, 4);
+            palettes = MeshOptimizer::remapVertices(palettes, remap, vertex_count);
+
+            MeshOptimizer::optimizeVertexCache(indices, vertex_count);
+            vertex_count = MeshOptimizer::optimizeVertexFetch(indices, vertex_count, remap);
+            positions = MeshOptimizer::remapVertices(positions, remap, vertex_count, 3);
+            weights = MeshOptimizer::remapVertices(weights, remap, vertex_count, 4);
+            palettes = MeshOptimizer::remapVertices(palettes, remap, vertex_count);
+
+            Assert::AreEqual(size_t{ vertex_count } * 4, weights.size());
+            Assert::AreEqual(size_t{ vertex_count }, palettes.size());
+            Assert::IsTrue(corners_before == collectCorners(indices, positions, weights, palettes));
+        }
+
+    private:
+        using Corner = std::vector<float>;
+
+        /** (w+1)x(h+1) 的 grid, 每個 quad 兩個 triangle, 每個 triangle 三個獨立的 vertex, 順序打亂 */
+        static void makeTriangleSoup(unsigned w, unsigned h, unsigned seed, std::vector<float>& positions, std::vector<unsigned>& indices)
+        {
+            std::vector<std::array<unsigned, 3>> triangles;
+            for (unsigned z = 0; z < h; z++)
+            {
+                for (unsigned x = 0; x < w; x++)
+                {
+                    const unsigned v0 = z * (w + 1) + x;
+                    const unsigned v1 = v0 + 1;
+                    const unsigned v2 = v0 + (w + 1);
+                    const unsigned v3 = v2 + 1;
+                    triangles.push_back({ v0, v2, v1 });
+                    triangles.push_back({ v1, v2, v3 });
+                }
+            }
+            std::mt19937 random(seed);
+            std::shuffle(triangles.begin(), triangles.end(), random);
+            positions.clear();
+            indices.clear();
+            for (auto& triangle : triangles)
+            {
+                for (unsigned v : triangle)
+                {
+                    indices.push_back(static_cast<unsigned>(positions.size() / 3));
+                    positions.insert(positions.end(), { static_cast<float>(v % (w + 1)), 0.0f, static_cast<float>(v / (w + 1)) });
+                }
+            }
+        }
+        static void sortTrianglesByFirstIndex(std::vector<unsigned>& indices)
+        {
+            std::vector<std::array<unsigned, 3>> triangles(indices.size() / 3);
+            for (size_t t = 0; t < triangles.size(); t++) triangles[t] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+            std::sort(triangles.begin(), triangles.end(), [](const auto& a, const auto& b)
+                {
+                    return *std::min_element(a.begin(), a.end()) < *std::min_element(b.begin(), b.end());
+                });
+            for (size_t t = 0; t < triangles.size(); t++) std::copy(triangles[t].begin(), triangles[t].end(), indices.begin() + t * 3);
+        }
+        /** triangle 以 vertex 內容表示, 轉到最小的 corner 開頭 (保留 winding) 後排序 */
+        static std::vector<std::vector<Corner>> collectTriangles(const std::vector<unsigned>& indices, const std::vector<float>& vertices, unsigned floats_per_vertex)
+        {
+            std::vector<std::vector<Corner>> triangles;
+            for (size_t t = 0; t + 2 < indices.size(); t += 3)
+            {
+                std::vector<Corner> triangle;
+                for (size_t c = 0; c < 3; c++)
+                {
+                    const auto begin = vertices.begin() + static_cast<std::ptrdiff_t>(indices[t + c]) * floats_per_vertex;
+                    triangle.emplace_back(begin, begin + floats_per_vertex);
+                }
+                std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+                triangles.push_back(std::move(triangle));
+            }
+            std::sort(triangles.begin(), triangles.end());
+            return triangles;
+        }
+        /** 每個 triangle corner 的位置, weight, palette index */
+        static std::vector<std::vector<Corner>> collectCorners(const std::vector<unsigned>& indices, const std::vector<float>& positions,
+            const std::vector<float>& weights, const std::vector<unsigned>& palettes)
+        {
+            std::vector<float> vertices;
+            for (size_t i = 0; i < palettes.size(); i++)
+            {
+                vertices.insert(vertices.end(), positions.begin() + i * 3, positions.begin() + i * 3 + 3);
+                vertices.insert(vertices.end(), weights.begin() + i * 4, weights.begin() + i * 4 + 4);
+                vertices.push_back(static_cast<float>(palettes[i]));
+            }
+            return collectTriangles(indices, vertices, 8);
+        }
+    };
+}
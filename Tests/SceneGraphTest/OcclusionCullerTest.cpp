@@ -0,0 +1,256 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "SceneGraph/Culler.h"
+#include "SceneGraph/OcclusionCuller.h"
+#include "SceneGraph/Camera.h"
+#include "SceneGraph/Frustum.h"
+#include "SceneGraph/Node.h"
+#include "SceneGraph/Pawn.h"
+#include "SceneGraph/VisibleSet.h"
+#include "SceneGraph/SceneGraphErrors.h"
+#include "SceneGraph/SceneGraphQueries.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/QueryDispatcher.h"
+#include "Frameworks/QuerySubscriber.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "MathLib/MathGlobal.h"
+#include "MathLib/Radian.h"
+#include <algorithm>
+#include <optional>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::SceneGraph;
+using namespace Enigma::Frameworks;
+using namespace Enigma::MathLib;
+
+namespace SceneGraphTest
+{
+    /** 沒有 primitive 的 pawn 不是 renderable, occlusion 只測 renderable 的物件 */
+    class OccludeeTestPawn : public Pawn
+    {
+    public:
+        OccludeeTestPawn(const SpatialId& id) : Pawn(id) {}
+
+        bool isRenderable() override { return true; }
+    };
+
+    /** spatial query 要查得到 parent, bound 才會往上更新 */
+    class OcclusionScene
+    {
+    public:
+        OcclusionScene()
+        {
+            m_manager.registerSystemService(std::make_shared<EventPublisher>(&m_manager));
+            m_manager.registerSystemService(std::make_shared<QueryDispatcher>(&m_manager));
+            m_manager.runToState(ServiceManager::ServiceState::Running);
+            m_querySpatial = std::make_shared<QuerySubscriber>([this](const IQueryPtr& q)
+                {
+                    auto query = std::dynamic_pointer_cast<QuerySpatial>(q);
+                    auto it = m_spatials.find(query->id());
+                    if (it != m_spatials.end()) query->setResult(it->second);
+                });
+            QueryDispatcher::subscribe(typeid(QuerySpatial), m_querySpatial);
+            m_root = std::make_shared<Node>(SpatialId("root", Node::TYPE_RTTI));
+            m_spatials.emplace(m_root->id(), m_root);
+        }
+        ~OcclusionScene()
+        {
+            QueryDispatcher::unsubscribe(typeid(QuerySpatial), m_querySpatial);
+        }
+
+        const std::shared_ptr<Node>& root() const { return m_root; }
+        std::shared_ptr<Pawn> attachPawn(const std::string& name, const Matrix4& mx_local)
+        {
+            auto pawn = std::make_shared<OccludeeTestPawn>(SpatialId(name, Pawn::TYPE_RTTI));
+            m_spatials.emplace(pawn->id(), pawn);
+            m_root->attachChild(pawn, mx_local);
+            return pawn;
+        }
+
+    protected:
+        ServiceManager m_manager;
+        QuerySubscriberPtr m_querySpatial;
+        std::unordered_map<SpatialId, std::shared_ptr<Spatial>, SpatialId::hash> m_spatials;
+        std::shared_ptr<Node> m_root;
+    };
+
+    TEST_CLASS(OcclusionCullerTest)
+    {
+    public:
+        static constexpr unsigned BUFFER_WIDTH = 256;
+        static constexpr unsigned BUFFER_HEIGHT = 128;
+
+        TEST_METHOD(TestWallOccludesObjectsBehindIt)
+        {
+            OcclusionScene scene;
+            auto camera = makeCamera();
+            // camera 在 z = -20 往 +z 看, 牆在 z = 10
+            auto wall = scene.attachPawn("wall", wallTransform(0.0f));
+            wall->addSpatialFlag(Spatial::Spatial_Occluder);
+            std::vector<std::shared_ptr<Pawn>> hidden;
+            for (int i = -2; i <= 2; i++)
+            {
+                hidden.emplace_back(scene.attachPawn("hidden" + std::to_string(i + 2), Matrix4::MakeTranslateTransform(2.0f * static_cast<float>(i), 0.0f, 30.0f)));
+            }
+            auto in_front = scene.attachPawn("in_front", Matrix4::MakeTranslateTransform(0.0f, 0.0f, 5.0f));
+            auto aside = scene.attachPawn("aside", Matrix4::MakeTranslateTransform(20.0f, 0.0f, 30.0f));
+            auto behind_camera = scene.attachPawn("behind_camera", Matrix4::MakeTranslateTransform(0.0f, 0.0f, -40.0f));
+
+            Culler culler(camera);
+            Assert::IsTrue(culler.ComputeVisibleSet(scene.root()) == ErrorCode::ok);
+            for (const auto& pawn : hidden) Assert::IsTrue(isVisible(culler, pawn));
+            Assert::IsFalse(isVisible(culler, behind_camera));
+
+            culler.occlusionCuller(std::make_shared<OcclusionCuller>(BUFFER_WIDTH, BUFFER_HEIGHT, nullptr));
+            Assert::IsTrue(culler.ComputeVisibleSet(scene.root()) == ErrorCode::ok);
+            Assert::IsTrue(isVisible(culler, wall));
+            Assert::IsTrue(isVisible(culler, in_front));
+            Assert::IsTrue(isVisible(culler, aside));
+            for (const auto& pawn : hidden) Assert::IsFalse(isVisible(culler, pawn));
+            const auto& stat = culler.occlusionCuller()->statistics();
+            Assert::AreEqual(1u, stat.m_occluderCount);
+            Assert::AreEqual(static_cast<unsigned>(hidden.size()), stat.m_occludedCount);
+
+            // 牆移開後不再遮蔽
+            wall->setLocalTransform(wallTransform(40.0f));
+            Assert::IsTrue(culler.ComputeVisibleSet(scene.root()) == ErrorCode::ok);
+            for (const auto& pawn : hidden) Assert::IsTrue(isVisible(culler, pawn));
+            Assert::AreEqual(0u, culler.occlusionCuller()->statistics().m_occludedCount);
+        }
+
+        TEST_METHOD(TestOccluderAroundCameraOrAcrossNearPlaneIsSkipped)
+        {
+            OcclusionScene scene;
+            auto camera = makeCamera();
+            // camera 在 z = -20, 包住 camera 的 occluder 畫出來會蓋住整個畫面
+            auto enclosing = scene.attachPawn("enclosing", Matrix4::MakeTranslateTransform(0.0f, 0.0f, -20.0f) * Matrix4::MakeScaleTransform(4.0f, 4.0f, 4.0f));
+            enclosing->addSpatialFlag(Spatial::Spatial_Occluder);
+            std::vector<std::shared_ptr<Pawn>> targets;
+            for (int i = -2; i <= 2; i++)
+            {
+                targets.emplace_back(scene.attachPawn("target" + std::to_string(i + 2), Matrix4::MakeTranslateTransform(2.0f * static_cast<float>(i), 0.0f, 30.0f)));
+            }
+            Culler culler(camera);
+            culler.occlusionCuller(std::make_shared<OcclusionCuller>(BUFFER_WIDTH, BUFFER_HEIGHT, nullptr));
+            Assert::IsTrue(culler.ComputeVisibleSet(scene.root()) == ErrorCode::ok);
+            for (const auto& pawn : targets) Assert::IsTrue(isVisible(culler, pawn));
+            Assert::AreEqual(0u, culler.occlusionCuller()->statistics().m_occluderCount);
+            Assert::AreEqual(0u, culler.occlusionCuller()->statistics().m_occludedCount);
+
+            // camera 在 occluder 外面, 但 occluder 的前緣 (z = -19.5) 在 near plane (z = -19.55 + 0.1) 之前
+            enclosing->setLocalTransform(Matrix4::MakeTranslateTransform(0.0f, 0.0f, -19.0f) * Matrix4::MakeScaleTransform(4.0f, 4.0f, 0.5f));
+            camera->changeCameraFrame(Vector3(0.0f, 0.0f, -19.55f), std::nullopt, std::nullopt);
+            Assert::IsTrue(culler.ComputeVisibleSet(scene.root()) == ErrorCode::ok);
+            for (const auto& pawn : targets) Assert::IsTrue(isVisible(culler, pawn));
+            Assert::AreEqual(0u, culler.occlusionCuller()->statistics().m_occluderCount);
+
+            // 整個在 near plane 之後, 正常遮蔽
+            enclosing->setLocalTransform(wallTransform(0.0f));
+            camera->changeCameraFrame(Vector3(0.0f, 0.0f, -20.0f), std::nullopt, std::nullopt);
+            Assert::IsTrue(culler.ComputeVisibleSet(scene.root()) == ErrorCode::ok);
+            for (const auto& pawn : targets) Assert::IsFalse(isVisible(culler, pawn));
+            Assert::AreEqual(1u, culler.occlusionCuller()->statistics().m_occluderCount);
+        }
+
+        TEST_METHOD(TestCopiedCullersCullConcurrently)
+        {
+            OcclusionScene scene;
+            auto camera = makeCamera();
+            std::vector<std::shared_ptr<Pawn>> hidden;
+            for (unsigned i = 0; i < 16; i++)
+            {
+                hidden.emplace_back(scene.attachPawn("hidden" + std::to_string(i), Matrix4::MakeTranslateTransform(static_cast<float>(i % 4) * 2.0f - 3.0f, static_cast<float>(i / 4) * 2.0f - 3.0f, 30.0f)));
+            }
+            auto aside = scene.attachPawn("aside", Matrix4::MakeTranslateTransform(20.0f, 0.0f, 30.0f));
+            // static occluder : z = 10 的牆, 兩個三角形
+            const std::vector<Vector3> static_wall =
+            {
+                Vector3(-8.0f, -8.0f, 10.0f), Vector3(-8.0f, 8.0f, 10.0f), Vector3(8.0f, 8.0f, 10.0f),
+                Vector3(-8.0f, -8.0f, 10.0f), Vector3(8.0f, 8.0f, 10.0f), Vector3(8.0f, -8.0f, 10.0f),
+            };
+            Culler culler(camera);
+            culler.occlusionCuller(std::make_shared<OcclusionCuller>(BUFFER_WIDTH, BUFFER_HEIGHT, nullptr));
+            culler.occlusionCuller()->addStaticOccluder(static_wall);
+
+            // 複製的 culler 各有自己的 occlusion culler (depth buffer), static occluder 也一起複製
+            Culler copied(culler);
+            Culler assigned(camera);
+            assigned = culler;
+            Assert::IsTrue(copied.occlusionCuller() && (copied.occlusionCuller() != culler.occlusionCuller()));
+            Assert::IsTrue(assigned.occlusionCuller() && (assigned.occlusionCuller() != culler.occlusionCuller()));
+            Assert::IsTrue(assigned.occlusionCuller() != copied.occlusionCuller());
+
+            auto workers = std::make_shared<WorkerThreadPool>(3);
+            for (unsigned frame = 0; frame < 8; frame++)
+            {
+                const auto errors = Culler::computeVisibleSets({ &culler, &copied, &assigned }, scene.root(), workers);
+                for (const auto& er : errors) Assert::IsTrue(er == ErrorCode::ok);
+                for (const Culler* c : { &culler, &copied, &assigned })
+                {
+                    Assert::IsTrue(isVisible(*c, aside));
+                    for (const auto& pawn : hidden) Assert::IsFalse(isVisible(*c, pawn));
+                    Assert::AreEqual(static_cast<unsigned>(hidden.size()), c->occlusionCuller()->statistics().m_occludedCount);
+                }
+            }
+        }
+
+        TEST_METHOD(BenchmarkOcclusionCulling)
+        {
+            constexpr unsigned GRID = 64;
+            OcclusionScene scene;
+            auto camera = makeCamera();
+            // 一排 occluder 牆擋住後方部分的格點
+            for (unsigned i = 0; i < 8; i++)
+            {
+                auto wall = scene.attachPawn("wall" + std::to_string(i), Matrix4::MakeTranslateTransform(static_cast<float>(i) * 8.0f - 28.0f, 0.0f, 20.0f) * Matrix4::MakeScaleTransform(3.0f, 6.0f, 0.5f));
+                wall->addSpatialFlag(Spatial::Spatial_Occluder);
+            }
+            for (unsigned z = 0; z < GRID; z++)
+            {
+                for (unsigned x = 0; x < GRID; x++)
+                {
+                    scene.attachPawn("grid" + std::to_string(z * GRID + x), Matrix4::MakeTranslateTransform(static_cast<float>(x) * 1.5f - 48.0f, 0.0f, 30.0f + static_cast<float>(z) * 1.5f) * Matrix4::MakeScaleTransform(0.4f, 0.4f, 0.4f));
+                }
+            }
+            auto workers = std::make_shared<WorkerThreadPool>();
+            Culler culler(camera);
+            Assert::IsTrue(culler.ComputeVisibleSet(scene.root()) == ErrorCode::ok);
+            const size_t frustum_visible = culler.getVisibleSet().getCount();
+            culler.occlusionCuller(std::make_shared<OcclusionCuller>(BUFFER_WIDTH, BUFFER_HEIGHT, workers));
+            Assert::IsTrue(culler.ComputeVisibleSet(scene.root()) == ErrorCode::ok);
+            const auto stat = culler.occlusionCuller()->statistics();
+            Assert::IsTrue(stat.m_occludedCount > 0);
+            Assert::AreEqual(frustum_visible - stat.m_occludedCount, culler.getVisibleSet().getCount());
+
+            char report[256];
+            snprintf(report, sizeof(report), "occlusion: %zu frustum visible, %u occluders (%zu tris), %u tested, %u occluded; setup %.3f raster %.3f pyramid %.3f test %.3f ms\n",
+                frustum_visible, stat.m_occluderCount, stat.m_occluderTriangleCount, stat.m_testedCount, stat.m_occludedCount,
+                stat.m_setupMilliseconds, stat.m_rasterizeMilliseconds, stat.m_pyramidMilliseconds, stat.m_testMilliseconds);
+            Logger::WriteMessage(report);
+        }
+
+    private:
+        static std::shared_ptr<Camera> makeCamera()
+        {
+            auto camera = std::make_shared<Camera>(SpatialId("camera", Camera::TYPE_RTTI), GraphicCoordSys::LeftHand);
+            camera->cullingFrustum(Frustum::fromPerspective(GraphicCoordSys::LeftHand, Radian(Math::PI / 3.0f), 2.0f, 0.1f, 500.0f));
+            camera->changeCameraFrame(Vector3(0.0f, 0.0f, -20.0f), Vector3::UNIT_Z, Vector3::UNIT_Y);
+            return camera;
+        }
+
+        static Matrix4 wallTransform(float y)
+        {
+            return Matrix4::MakeTranslateTransform(0.0f, y, 10.0f) * Matrix4::MakeScaleTransform(8.0f, 8.0f, 0.5f);
+        }
+
+        static bool isVisible(const Culler& culler, const std::shared_ptr<Pawn>& pawn)
+        {
+            const auto& objects = culler.getVisibleSet().GetObjectSet();
+            return std::find(objects.begin(), objects.end(), pawn) != objects.end();
+        }
+    };
+}
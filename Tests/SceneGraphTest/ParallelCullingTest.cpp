@@ -0,0 +1,225 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "SceneGraph/Culler.h"
+#include "SceneGraph/Camera.h"
+#include "SceneGraph/Frustum.h"
+#include "SceneGraph/Node.h"
+#include "SceneGraph/Pawn.h"
+#include "SceneGraph/Portal.h"
+#include "SceneGraph/PortalAssembler.h"
+#include "SceneGraph/PortalZoneNode.h"
+#include "SceneGraph/PortalManagementNode.h"
+#include "SceneGraph/VisibleSet.h"
+#include "SceneGraph/SceneGraphErrors.h"
+#include "SceneGraph/SceneGraphQueries.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/CommandBus.h"
+#include "Frameworks/QueryDispatcher.h"
+#include "Frameworks/QuerySubscriber.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "Frameworks/LazyStatus.h"
+#include "MathLib/MathGlobal.h"
+#include "MathLib/Radian.h"
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::SceneGraph;
+using namespace Enigma::Frameworks;
+using namespace Enigma::MathLib;
+
+namespace SceneGraphTest
+{
+    /** spatial query 要查得到 parent 及 portal 的 zone */
+    class CullingScene
+    {
+    public:
+        CullingScene()
+        {
+            m_manager.registerSystemService(std::make_shared<EventPublisher>(&m_manager));
+            m_manager.registerSystemService(std::make_shared<CommandBus>(&m_manager));
+            m_manager.registerSystemService(std::make_shared<QueryDispatcher>(&m_manager));
+            m_manager.runToState(ServiceManager::ServiceState::Running);
+            m_querySpatial = std::make_shared<QuerySubscriber>([this](const IQueryPtr& q)
+                {
+                    auto query = std::dynamic_pointer_cast<QuerySpatial>(q);
+                    auto it = m_spatials.find(query->id());
+                    if (it != m_spatials.end()) query->setResult(it->second);
+                });
+            QueryDispatcher::subscribe(typeid(QuerySpatial), m_querySpatial);
+        }
+        ~CullingScene()
+        {
+            QueryDispatcher::unsubscribe(typeid(QuerySpatial), m_querySpatial);
+        }
+
+        template <class T> std::shared_ptr<T> create(const std::string& name, const Rtti& rtti)
+        {
+            auto spatial = std::make_shared<T>(SpatialId(name, rtti));
+            m_spatials.emplace(spatial->id(), spatial);
+            return spatial;
+        }
+        void add(const std::shared_ptr<Spatial>& spatial) { m_spatials.emplace(spatial->id(), spatial); }
+
+    protected:
+        ServiceManager m_manager;
+        QuerySubscriberPtr m_querySpatial;
+        std::unordered_map<SpatialId, std::shared_ptr<Spatial>, SpatialId::hash> m_spatials;
+    };
+
+    TEST_CLASS(ParallelCullingTest)
+    {
+    public:
+        TEST_METHOD(TestParallelCullingMatchesSerial)
+        {
+            CullingScene scene;
+            auto root = scene.create<Node>("root", Node::TYPE_RTTI);
+            // 8 x 4 個 group, 每個 group 8 個 pawn, 有一部分在 frustum 外
+            for (unsigned i = 0; i < 8; i++)
+            {
+                auto region = scene.create<Node>("region" + std::to_string(i), Node::TYPE_RTTI);
+                for (unsigned j = 0; j < 4; j++)
+                {
+                    auto group = scene.create<Node>("group" + std::to_string(i * 4 + j), Node::TYPE_RTTI);
+                    for (unsigned k = 0; k < 8; k++)
+                    {
+                        auto pawn = scene.create<Pawn>("pawn" + std::to_string((i * 4 + j) * 8 + k), Pawn::TYPE_RTTI);
+                        group->attachChild(pawn, Matrix4::MakeTranslateTransform(static_cast<float>(k) * 6.0f - 21.0f, static_cast<float>(j) * 6.0f - 9.0f, 0.0f));
+                    }
+                    region->attachChild(group, Matrix4::IDENTITY);
+                }
+                root->attachChild(region, Matrix4::MakeTranslateTransform(static_cast<float>(i) * 12.0f - 42.0f, 0.0f, static_cast<float>(i) * 8.0f));
+            }
+            std::vector<std::shared_ptr<Camera>> cameras =
+            {
+                makeCamera("front", Vector3(0.0f, 0.0f, -40.0f), Vector3::UNIT_Z),
+                makeCamera("left", Vector3(-80.0f, 0.0f, 20.0f), Vector3::UNIT_X),
+                makeCamera("back", Vector3(0.0f, 0.0f, 120.0f), -Vector3::UNIT_Z),
+            };
+            auto workers = std::make_shared<WorkerThreadPool>(3);
+            for (const auto& camera : cameras)
+            {
+                Culler serial(camera);
+                Assert::IsTrue(serial.ComputeVisibleSet(root) == ErrorCode::ok);
+                Assert::IsTrue(serial.getVisibleSet().getCount() > 1);
+                Culler parallel(camera);
+                parallel.enableParallelCulling(workers, 2, 2);
+                Assert::IsTrue(parallel.ComputeVisibleSet(root) == ErrorCode::ok);
+                assertSameVisibleSet(serial, parallel);
+            }
+
+            // 多個 camera 同時 culling, 每個 culler 也各自 fan out
+            std::vector<Culler> serial_cullers;
+            std::vector<Culler> parallel_cullers;
+            for (const auto& camera : cameras)
+            {
+                serial_cullers.emplace_back(camera);
+                parallel_cullers.emplace_back(camera);
+                parallel_cullers.back().enableParallelCulling(workers, 1, 2);
+            }
+            std::vector<Culler*> culler_ptrs;
+            for (auto& culler : parallel_cullers) culler_ptrs.push_back(&culler);
+            for (unsigned frame = 0; frame < 4; frame++)
+            {
+                const auto errors = Culler::computeVisibleSets(culler_ptrs, root, workers);
+                for (const auto& er : errors) Assert::IsTrue(er == ErrorCode::ok);
+                for (size_t i = 0; i < cameras.size(); i++)
+                {
+                    Assert::IsTrue(serial_cullers[i].ComputeVisibleSet(root) == ErrorCode::ok);
+                    assertSameVisibleSet(serial_cullers[i], parallel_cullers[i]);
+                }
+            }
+        }
+
+        TEST_METHOD(TestPortalZonesCullInParallel)
+        {
+            CullingScene scene;
+            auto root = scene.create<PortalManagementNode>("root", PortalManagementNode::TYPE_RTTI);
+            auto inner_zone = scene.create<PortalZoneNode>("inner_zone", PortalZoneNode::TYPE_RTTI);
+            inner_zone->lazyStatus().changeStatus(LazyStatus::Status::Ready);
+            auto outer_zone = scene.create<PortalZoneNode>("outer_zone", PortalZoneNode::TYPE_RTTI);
+            outer_zone->lazyStatus().changeStatus(LazyStatus::Status::Ready);
+
+            // portal 只有 zone id, 還沒連上 zone; culling 時不會去查詢
+            const SpatialId portal_id("portal", Portal::TYPE_RTTI);
+            PortalAssembler portal_assembler(portal_id);
+            portal_assembler.adjacentNodeId(outer_zone->id());
+            portal_assembler.isOpen(true);
+            auto portal = Portal::create(portal_id);
+            SpatialDisassembler::disassemble(portal, portal_assembler.assemble());
+            scene.add(portal);
+            Assert::IsTrue(portal->isOpen());
+            Assert::IsTrue(portal->adjacentZone() == nullptr);
+
+            // camera 在 inner zone 裡, 往 +z 看穿過 z = 10 的 portal
+            auto room = scene.create<Pawn>("room", Pawn::TYPE_RTTI);
+            inner_zone->attachChild(room, Matrix4::MakeScaleTransform(30.0f, 30.0f, 30.0f));
+            for (unsigned i = 0; i < 6; i++)
+            {
+                auto pawn = scene.create<Pawn>("inner" + std::to_string(i), Pawn::TYPE_RTTI);
+                inner_zone->attachChild(pawn, Matrix4::MakeTranslateTransform(static_cast<float>(i) * 4.0f - 10.0f, 0.0f, 0.0f));
+            }
+            inner_zone->attachChild(portal, Matrix4::MakeTranslateTransform(0.0f, 0.0f, 10.0f) * Matrix4::MakeScaleTransform(8.0f, 8.0f, 1.0f));
+            for (unsigned i = 0; i < 6; i++)
+            {
+                auto pawn = scene.create<Pawn>("outer" + std::to_string(i), Pawn::TYPE_RTTI);
+                outer_zone->attachChild(pawn, Matrix4::MakeTranslateTransform(static_cast<float>(i) * 4.0f - 10.0f, 0.0f, 60.0f));
+            }
+            root->attachChild(inner_zone, Matrix4::IDENTITY);
+
+            auto camera = makeCamera("camera", Vector3(0.0f, 0.0f, -20.0f), Vector3::UNIT_Z);
+            Culler unresolved(camera);
+            Assert::IsTrue(unresolved.ComputeVisibleSet(root) == ErrorCode::ok);
+            Assert::IsFalse(isVisible(unresolved, outer_zone));
+            Assert::IsTrue(portal->adjacentZone() == nullptr);
+
+            // main thread 上連上 zone 後, worker threads 上的 culling 只讀取
+            portal->resolveAdjacentZone();
+            Assert::IsTrue(portal->adjacentZone() == outer_zone);
+            Assert::IsTrue(outer_zone->parentPortal() && (outer_zone->parentPortal().value() == portal_id));
+            Culler serial(camera);
+            Assert::IsTrue(serial.ComputeVisibleSet(root) == ErrorCode::ok);
+            Assert::IsTrue(isVisible(serial, outer_zone));
+            auto workers = std::make_shared<WorkerThreadPool>(3);
+            Culler parallel(camera);
+            parallel.enableParallelCulling(workers, 2, 2);
+            Culler copied(parallel);
+            for (unsigned frame = 0; frame < 4; frame++)
+            {
+                const auto errors = Culler::computeVisibleSets({ &parallel, &copied }, root, workers);
+                for (const auto& er : errors) Assert::IsTrue(er == ErrorCode::ok);
+                assertSameVisibleSet(serial, parallel);
+                assertSameVisibleSet(serial, copied);
+            }
+        }
+
+    private:
+        static std::shared_ptr<Camera> makeCamera(const std::string& name, const Vector3& eye, const Vector3& dir)
+        {
+            auto camera = std::make_shared<Camera>(SpatialId(name, Camera::TYPE_RTTI), GraphicCoordSys::LeftHand);
+            camera->cullingFrustum(Frustum::fromPerspective(GraphicCoordSys::LeftHand, Radian(Math::PI / 3.0f), 4.0f / 3.0f, 0.1f, 150.0f));
+            camera->changeCameraFrame(eye, dir, Vector3::UNIT_Y);
+            return camera;
+        }
+
+        static bool isVisible(const Culler& culler, const std::shared_ptr<Spatial>& spatial)
+        {
+            const auto& objects = culler.getVisibleSet().GetObjectSet();
+            return std::find(objects.begin(), objects.end(), spatial) != objects.end();
+        }
+
+        /** fan out 後依 subtree 順序合併, 結果要和循序 culling 完全一樣 */
+        static void assertSameVisibleSet(const Culler& expected, const Culler& actual)
+        {
+            const auto& expected_objects = expected.getVisibleSet().GetObjectSet();
+            const auto& actual_objects = actual.getVisibleSet().GetObjectSet();
+            Assert::AreEqual(expected_objects.size(), actual_objects.size());
+            for (size_t i = 0; i < expected_objects.size(); i++)
+            {
+                Assert::IsTrue(expected_objects[i] == actual_objects[i]);
+            }
+        }
+    };
+}
@@ -0,0 +1,237 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "GameEngine/RenderBufferArena.h"
+#include "GameEngine/RenderBuffer.h"
+#include "GameEngine/RenderBufferSignature.h"
+#include "GameEngine/EngineErrors.h"
+#include "GraphicKernel/IGraphicAPI.h"
+#include "GraphicKernel/GraphicErrors.h"
+#include "GraphicKernel/IVertexBuffer.h"
+#include "GraphicKernel/IIndexBuffer.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/CommandBus.h"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Engine;
+using namespace Enigma::Graphics;
+using namespace Enigma::Frameworks;
+using namespace Enigma::MathLib;
+
+namespace SceneGraphTest
+{
+    /** 不建 device, 只讓 buffer 的 update 同步執行 */
+    class SynchronousGraphicAPI : public IGraphicAPI
+    {
+    public:
+        SynchronousGraphicAPI() : IGraphicAPI(AsyncType::NotAsyncDevice) {}
+
+        error createDevice(const DeviceRequiredBits&, void*) override { return error{}; }
+        error cleanupDevice() override { return error{}; }
+        error beginDrawingScene() override { return error{}; }
+        error endDrawingScene() override { return error{}; }
+        error drawPrimitive(unsigned int, unsigned int) override { return error{}; }
+        error drawIndexedPrimitive(unsigned int, unsigned int, unsigned int, int) override { return error{}; }
+        error flipBackSurface() override { return error{}; }
+        error CreatePrimaryBackSurface(const std::string&, const std::string&) override { return error{}; }
+        error CreateBackSurface(const std::string&, const Dimension<unsigned>&, const GraphicFormat&) override { return error{}; }
+        error CreateBackSurface(const std::string&, const Dimension<unsigned>&, unsigned int, const std::vector<GraphicFormat>&) override { return error{}; }
+        error CreateDepthStencilSurface(const std::string&, const Dimension<unsigned>&, const GraphicFormat&) override { return error{}; }
+        error ShareDepthStencilSurface(const std::string&, const IDepthStencilSurfacePtr&) override { return error{}; }
+        error ClearSurface(const IBackSurfacePtr&, const IDepthStencilSurfacePtr&, const ColorRGBA&, float, unsigned int) override { return error{}; }
+        error CreateVertexShader(const std::string&) override { return error{}; }
+        error CreatePixelShader(const std::string&) override { return error{}; }
+        error CreateShaderProgram(const std::string&, const IVertexShaderPtr&, const IPixelShaderPtr&, const IVertexDeclarationPtr&) override { return error{}; }
+        error CreateVertexDeclaration(const std::string&, const std::string&, const IVertexShaderPtr&) override { return error{}; }
+        error CreateVertexBuffer(const std::string&, unsigned int, unsigned int) override { return error{}; }
+        error CreateIndexBuffer(const std::string&, unsigned int) override { return error{}; }
+        error CreateSamplerState(const std::string&, const IDeviceSamplerState::SamplerStateData&) override { return error{}; }
+        error CreateRasterizerState(const std::string&, const IDeviceRasterizerState::RasterizerStateData&) override { return error{}; }
+        error CreateAlphaBlendState(const std::string&, const IDeviceAlphaBlendState::BlendStateData&) override { return error{}; }
+        error CreateDepthStencilState(const std::string&, const IDeviceDepthStencilState::DepthStencilData&) override { return error{}; }
+        error createTexture(const std::string&) override { return error{}; }
+        error createMultiTexture(const std::string&) override { return error{}; }
+        error BindBackSurface(const IBackSurfacePtr&, const IDepthStencilSurfacePtr&) override { return error{}; }
+        error bindViewPort(const TargetViewPort&) override { return error{}; }
+        error BindVertexShader(const IVertexShaderPtr&) override { return error{}; }
+        error BindPixelShader(const IPixelShaderPtr&) override { return error{}; }
+        error BindShaderProgram(const IShaderProgramPtr&) override { return error{}; }
+        error BindVertexDeclaration(const IVertexDeclarationPtr&) override { return error{}; }
+        error BindVertexBuffer(const IVertexBufferPtr&, PrimitiveTopology) override { return error{}; }
+        error BindIndexBuffer(const IIndexBufferPtr&) override { return error{}; }
+    };
+
+    /** 記錄 ranged update 收到的內容 */
+    class RecordingVertexBuffer : public IVertexBuffer
+    {
+    public:
+        RecordingVertexBuffer(unsigned sizeof_vertex, unsigned vtx_capacity) : IVertexBuffer("recording.vtx") { create(sizeof_vertex, sizeof_vertex * vtx_capacity); }
+        error create(unsigned int sizeofVertex, unsigned int sizeBuffer) override
+        {
+            m_sizeofVertex = sizeofVertex;
+            m_bufferSize = sizeBuffer;
+            return error{};
+        }
+        std::vector<ranged_buffer> m_updates;
+
+    protected:
+        error UpdateBuffer(const byte_buffer&) override { return error{}; }
+        error RangedUpdateBuffer(const ranged_buffer& buffer) override
+        {
+            m_updates.push_back(buffer);
+            return error{};
+        }
+    };
+    class RecordingIndexBuffer : public IIndexBuffer
+    {
+    public:
+        RecordingIndexBuffer(unsigned idx_capacity) : IIndexBuffer("recording.idx") { create(idx_capacity * static_cast<unsigned>(sizeof(unsigned))); }
+        error create(unsigned int sizeBuffer) override
+        {
+            m_bufferSize = sizeBuffer;
+            return error{};
+        }
+        std::vector<ranged_buffer> m_updates;
+
+    protected:
+        error UpdateBuffer(const uint_buffer&) override { return error{}; }
+        error RangedUpdateBuffer(const ranged_buffer& buffer) override
+        {
+            m_updates.push_back(buffer);
+            return error{};
+        }
+    };
+
+    TEST_CLASS(RenderBufferArenaTest)
+    {
+    public:
+        TEST_METHOD(TestBestFitPicksSmallestFittingRange)
+        {
+            ArenaRangeAllocator allocator(100);
+            const auto a = allocator.allocate(10);
+            const auto b = allocator.allocate(20);
+            const auto c = allocator.allocate(30);
+            const auto d = allocator.allocate(40);
+            Assert::IsTrue(a && b && c && d);
+            Assert::AreEqual(0u, a.value());
+            Assert::AreEqual(10u, b.value());
+            Assert::AreEqual(30u, c.value());
+            Assert::AreEqual(60u, d.value());
+            Assert::AreEqual(0u, allocator.freeCount());
+
+            // 空出 [10, 30) 及 [60, 100), 15 應該放進比較小的 [10, 30)
+            allocator.release(d.value(), 40);
+            allocator.release(b.value(), 20);
+            const auto e = allocator.allocate(15);
+            Assert::IsTrue(e.has_value());
+            Assert::AreEqual(10u, e.value());
+            Assert::AreEqual(40u, allocator.largestFreeRange());
+            // 剛好一樣大的優先
+            const auto f = allocator.allocate(5);
+            Assert::IsTrue(f.has_value());
+            Assert::AreEqual(25u, f.value());
+            Assert::AreEqual(40u, allocator.freeCount());
+            Assert::IsFalse(allocator.allocate(41).has_value());
+        }
+
+        TEST_METHOD(TestReleaseMergesAdjacentFreeRanges)
+        {
+            ArenaRangeAllocator allocator(100);
+            const auto a = allocator.allocate(10);
+            const auto b = allocator.allocate(20);
+            const auto c = allocator.allocate(30);
+            const auto d = allocator.allocate(40);
+            Assert::IsTrue(a && b && c && d);
+
+            allocator.release(a.value(), 10);
+            allocator.release(c.value(), 30);
+            // 兩段不相鄰
+            Assert::AreEqual(30u, allocator.largestFreeRange());
+            Assert::IsFalse(allocator.allocate(40).has_value());
+
+            // 放掉中間那段, 跟前後合併成 [0, 60)
+            allocator.release(b.value(), 20);
+            Assert::AreEqual(60u, allocator.largestFreeRange());
+            Assert::AreEqual(60u, allocator.freeCount());
+
+            // 再跟後面合併成整塊
+            allocator.release(d.value(), 40);
+            Assert::AreEqual(100u, allocator.largestFreeRange());
+            const auto whole = allocator.allocate(100);
+            Assert::IsTrue(whole.has_value());
+            Assert::AreEqual(0u, whole.value());
+        }
+
+        TEST_METHOD(TestReleasedRangeIsReused)
+        {
+            ArenaRangeAllocator allocator(64);
+            std::vector<unsigned> offsets;
+            while (auto offset = allocator.allocate(8)) offsets.push_back(offset.value());
+            Assert::AreEqual(size_t{ 8 }, offsets.size());
+            Assert::IsFalse(allocator.allocate(1).has_value());
+            Assert::IsFalse(allocator.allocate(0).has_value());
+
+            for (unsigned round = 0; round < 4; round++)
+            {
+                allocator.release(offsets[3], 8);
+                const auto reused = allocator.allocate(8);
+                Assert::IsTrue(reused.has_value());
+                Assert::AreEqual(offsets[3], reused.value());
+                Assert::AreEqual(0u, allocator.freeCount());
+            }
+            // 小的配置放進釋放的洞裡, 剩下的仍可用
+            allocator.release(offsets[5], 8);
+            const auto small = allocator.allocate(3);
+            Assert::IsTrue(small.has_value());
+            Assert::AreEqual(offsets[5], small.value());
+            const auto rest = allocator.allocate(5);
+            Assert::IsTrue(rest.has_value());
+            Assert::AreEqual(offsets[5] + 3, rest.value());
+        }
+
+        TEST_METHOD(TestRangedUpdateRebasesIndicesByVertexOffset)
+        {
+            ServiceManager manager;
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+            manager.registerSystemService(std::make_shared<CommandBus>(&manager));
+            manager.runToState(ServiceManager::ServiceState::Running);
+            SynchronousGraphicAPI graphic_api;
+
+            constexpr unsigned sizeof_vertex = 12;
+            auto vertex_buffer = std::make_shared<RecordingVertexBuffer>(sizeof_vertex, 1024);
+            auto index_buffer = std::make_shared<RecordingIndexBuffer>(1024);
+            RenderBufferArena::Range range;
+            range.m_sizeofVertex = sizeof_vertex;
+            range.m_vtxOffset = 100;
+            range.m_vtxCount = 8;
+            range.m_idxOffset = 40;
+            range.m_idxCount = 12;
+            RenderBuffer buffer(RenderBufferSignature{}, vertex_buffer, index_buffer, range, std::weak_ptr<RenderBufferArena>{});
+
+            const byte_buffer vertices(3 * sizeof_vertex, 0x5a);
+            const uint_buffer indices{ 0, 1, 2, 2, 1, 0 };
+            auto er = buffer.rangedUpdateVertex({ 2, 3, vertices }, IIndexBuffer::ranged_buffer{ 4, 6, indices });
+            Assert::IsTrue(er == Enigma::Engine::ErrorCode::ok);
+
+            Assert::AreEqual(size_t{ 1 }, vertex_buffer->m_updates.size());
+            Assert::AreEqual(range.m_vtxOffset + 2, vertex_buffer->m_updates[0].vtx_offset);
+            Assert::AreEqual(3u, vertex_buffer->m_updates[0].vtx_count);
+            Assert::IsTrue(vertex_buffer->m_updates[0].data == vertices);
+            Assert::AreEqual(size_t{ 1 }, index_buffer->m_updates.size());
+            Assert::AreEqual(range.m_idxOffset + 4, index_buffer->m_updates[0].idx_offset);
+            Assert::AreEqual(6u, index_buffer->m_updates[0].idx_count);
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                Assert::AreEqual(indices[i] + range.m_vtxOffset, index_buffer->m_updates[0].data[i]);
+            }
+
+            // 超出 range 的更新被拒絕, 不會寫到別人的區段
+            er = buffer.rangedUpdateVertex({ 6, 3, vertices }, std::nullopt);
+            Assert::IsTrue(er == Enigma::Graphics::ErrorCode::bufferSize);
+            Assert::AreEqual(size_t{ 1 }, vertex_buffer->m_updates.size());
+        }
+    };
+}
@@ -0,0 +1,300 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "SceneGraph/SceneBroadphase.h"
+#include "SceneGraph/SceneGraphQueries.h"
+#include "SceneGraph/Node.h"
+#include "SceneGraph/Pawn.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/QueryDispatcher.h"
+#include "Frameworks/QuerySubscriber.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "MathLib/Matrix4.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::SceneGraph;
+using namespace Enigma::Frameworks;
+using namespace Enigma::MathLib;
+
+namespace SceneGraphTest
+{
+    /** world bound 可以清成空的 pawn, 模擬還沒有 primitive bound 的狀態 */
+    class HollowPawn : public Pawn
+    {
+    public:
+        HollowPawn(const SpatialId& id) : Pawn(id) {}
+
+        /** 指定空的 BoundingVolume 不會清掉原本的 bound, 用 move 拿走 */
+        void clearWorldBound() { Enigma::Engine::BoundingVolume discarded{ std::move(m_worldBound) }; }
+    };
+
+    /** event publisher + spatial query, broadphase 需要的最少環境 */
+    class BroadphaseScene
+    {
+    public:
+        BroadphaseScene()
+        {
+            m_manager.registerSystemService(std::make_shared<EventPublisher>(&m_manager));
+            m_manager.registerSystemService(std::make_shared<QueryDispatcher>(&m_manager));
+            m_manager.runToState(ServiceManager::ServiceState::Running);
+            m_querySpatial = std::make_shared<QuerySubscriber>([this](const IQueryPtr& q)
+                {
+                    auto query = std::dynamic_pointer_cast<QuerySpatial>(q);
+                    auto it = m_spatials.find(query->id());
+                    if (it != m_spatials.end()) query->setResult(it->second);
+                });
+            QueryDispatcher::subscribe(typeid(QuerySpatial), m_querySpatial);
+        }
+        ~BroadphaseScene()
+        {
+            QueryDispatcher::unsubscribe(typeid(QuerySpatial), m_querySpatial);
+        }
+
+        template <class T> std::shared_ptr<T> create(const std::string& name, const Rtti& rtti)
+        {
+            auto spatial = std::make_shared<T>(SpatialId(name, rtti));
+            m_spatials.emplace(spatial->id(), spatial);
+            return spatial;
+        }
+        void publishEvents() { m_manager.runOnce(); }
+
+    protected:
+        ServiceManager m_manager;
+        QuerySubscriberPtr m_querySpatial;
+        std::unordered_map<SpatialId, std::shared_ptr<Spatial>, SpatialId::hash> m_spatials;
+    };
+
+    TEST_CLASS(SceneBroadphaseTest)
+    {
+    public:
+        TEST_METHOD(TestBroadphaseFollowsSceneGraph)
+        {
+            BroadphaseScene scene;
+            auto root = scene.create<Node>("root", Node::TYPE_RTTI);
+            SceneBroadphase broadphase(0.1f, nullptr);
+            broadphase.insertSpatial(root);
+
+            // bound 是空的 pawn 先追蹤, attach 後 bound 不是空的才放進 tree
+            auto hollow = scene.create<HollowPawn>("hollow", Pawn::TYPE_RTTI);
+            hollow->clearWorldBound();
+            broadphase.insertSpatial(hollow);
+            Assert::IsFalse(broadphase.contains(hollow->id()));
+            auto group = scene.create<Node>("group", Node::TYPE_RTTI);
+            std::vector<std::shared_ptr<Pawn>> pawns;
+            for (unsigned i = 0; i < 4; i++)
+            {
+                pawns.emplace_back(scene.create<Pawn>("pawn" + std::to_string(i), Pawn::TYPE_RTTI));
+                group->attachChild(pawns.back(), Matrix4::MakeTranslateTransform(4.0f * static_cast<float>(i), 0.0f, 0.0f));
+            }
+            root->attachChild(hollow, Matrix4::MakeTranslateTransform(-10.0f, 0.0f, 0.0f));
+            root->attachChild(group, Matrix4::IDENTITY);
+            scene.publishEvents();
+            Assert::IsTrue(broadphase.contains(hollow->id()));
+            for (const auto& pawn : pawns) Assert::IsTrue(broadphase.contains(pawn->id()));
+            const Ray3 ray_at_ground(Vector3(-20.0f, 0.0f, 0.0f), Vector3::UNIT_X);
+            Assert::AreEqual(static_cast<size_t>(5), broadphase.queryRay(ray_at_ground, 100.0f).size());
+            auto nearest = broadphase.raycastNearest(ray_at_ground, 100.0f, nullptr);
+            Assert::IsTrue(nearest.has_value() && (nearest->m_id == hollow->id()));
+
+            // bound 變成空的時候離開 tree, 恢復後放回去
+            hollow->clearWorldBound();
+            broadphase.refitSpatial(hollow->id());
+            Assert::IsFalse(broadphase.contains(hollow->id()));
+            Assert::IsTrue(broadphase.raycastNearest(ray_at_ground, 100.0f, nullptr)->m_id == pawns[0]->id());
+            hollow->setLocalTransform(Matrix4::MakeTranslateTransform(-10.0f, 0.0f, 0.0f));
+            scene.publishEvents();
+            Assert::IsTrue(broadphase.contains(hollow->id()));
+            Assert::IsTrue(broadphase.raycastNearest(ray_at_ground, 100.0f, nullptr)->m_id == hollow->id());
+
+            // node 移動只有 node 跟上層發 SpatialBoundChanged, 底下的 pawn 也要跟著 refit
+            group->setLocalTransform(Matrix4::MakeTranslateTransform(0.0f, 50.0f, 0.0f));
+            scene.publishEvents();
+            const auto ground_hits = broadphase.queryRay(ray_at_ground, 100.0f);
+            Assert::AreEqual(static_cast<size_t>(1), ground_hits.size());
+            Assert::IsTrue(ground_hits[0].m_id == hollow->id());
+            const Ray3 ray_above(Vector3(-20.0f, 50.0f, 0.0f), Vector3::UNIT_X);
+            const auto above_hits = broadphase.queryRay(ray_above, 100.0f);
+            Assert::AreEqual(static_cast<size_t>(4), above_hits.size());
+            Assert::IsTrue(above_hits[0].m_id == pawns[0]->id());
+            Assert::AreEqual(static_cast<size_t>(4), broadphase.querySphere(Sphere3(Vector3(6.0f, 50.0f, 0.0f), 8.0f)).size());
+
+            // pawn 自己移動時上層 node 的 transform 沒變, 其他 pawn 不受影響
+            pawns[3]->setLocalTransform(Matrix4::MakeTranslateTransform(12.0f, 0.0f, 30.0f));
+            scene.publishEvents();
+            Assert::AreEqual(static_cast<size_t>(3), broadphase.queryRay(ray_above, 100.0f).size());
+            Assert::AreEqual(static_cast<size_t>(1), broadphase.querySphere(Sphere3(Vector3(12.0f, 50.0f, 30.0f), 2.0f)).size());
+
+            group->detachChild(pawns[1]);
+            scene.publishEvents();
+            Assert::IsFalse(broadphase.contains(pawns[1]->id()));
+            Assert::AreEqual(static_cast<size_t>(2), broadphase.queryRay(ray_above, 100.0f).size());
+            root->detachChild(group);
+            scene.publishEvents();
+            for (const auto& pawn : pawns) Assert::IsFalse(broadphase.contains(pawn->id()));
+            Assert::AreEqual(1u, broadphase.statistics().m_proxyCount);
+        }
+
+        TEST_METHOD(TestOnlyAttachmentsUnderBoundRootAreTracked)
+        {
+            BroadphaseScene scene;
+            auto root = scene.create<Node>("root", Node::TYPE_RTTI);
+            auto zone = scene.create<Node>("zone", Node::TYPE_RTTI);
+            root->attachChild(zone, Matrix4::IDENTITY);
+            SceneBroadphase broadphase(0.1f, nullptr);
+            broadphase.bindSceneRoot(root);
+            scene.publishEvents();
+
+            // 另一棵 scene graph (ex. 組裝中的 prefab) 的 attach 不加入
+            auto prefab = scene.create<Node>("prefab", Node::TYPE_RTTI);
+            auto prefab_pawn = scene.create<Pawn>("prefab_pawn", Pawn::TYPE_RTTI);
+            prefab->attachChild(prefab_pawn, Matrix4::IDENTITY);
+            auto other_root = scene.create<Node>("other_root", Node::TYPE_RTTI);
+            auto other_pawn = scene.create<Pawn>("other_pawn", Pawn::TYPE_RTTI);
+            other_root->attachChild(other_pawn, Matrix4::IDENTITY);
+            scene.publishEvents();
+            Assert::IsFalse(broadphase.contains(prefab_pawn->id()));
+            Assert::IsFalse(broadphase.contains(other_pawn->id()));
+            Assert::AreEqual(0u, broadphase.statistics().m_proxyCount);
+
+            // root 底下任何深度的 attach 都加入, prefab 整個 attach 進來時其下的 pawn 一起加入
+            auto zone_pawn = scene.create<Pawn>("zone_pawn", Pawn::TYPE_RTTI);
+            zone->attachChild(zone_pawn, Matrix4::MakeTranslateTransform(5.0f, 0.0f, 0.0f));
+            zone->attachChild(prefab, Matrix4::MakeTranslateTransform(-5.0f, 0.0f, 0.0f));
+            scene.publishEvents();
+            Assert::IsTrue(broadphase.contains(zone_pawn->id()));
+            Assert::IsTrue(broadphase.contains(prefab_pawn->id()));
+            Assert::IsFalse(broadphase.contains(other_pawn->id()));
+            Assert::AreEqual(2u, broadphase.statistics().m_proxyCount);
+        }
+
+        TEST_METHOD(BenchmarkRaysOver50kPawns)
+        {
+            constexpr unsigned PAWN_COUNT = 50000;
+            constexpr unsigned RAY_COUNT = 10000;
+            constexpr unsigned GROUP_SIZE = 200;
+            constexpr unsigned MOVE_FRAMES = 4;
+            constexpr unsigned MOVE_STRIDE = 100;
+            constexpr unsigned VERIFY_RAY_COUNT = 500;
+            constexpr float MAX_T = 4000.0f;
+            BroadphaseScene scene;
+            auto root = scene.create<Node>("root", Node::TYPE_RTTI);
+            std::mt19937 random(7);
+            std::uniform_real_distribution<float> position(0.0f, 2000.0f);
+            std::uniform_real_distribution<float> height(0.0f, 50.0f);
+            std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+            // attach 時 node 會重算所有 child 的 bound, 分組避免 root 底下直接掛 50k 個 child
+            std::vector<std::shared_ptr<Pawn>> pawns;
+            pawns.reserve(PAWN_COUNT);
+            for (unsigned g = 0; g < PAWN_COUNT / GROUP_SIZE; g++)
+            {
+                auto group = scene.create<Node>("group" + std::to_string(g), Node::TYPE_RTTI);
+                for (unsigned i = 0; i < GROUP_SIZE; i++)
+                {
+                    pawns.emplace_back(scene.create<Pawn>("pawn" + std::to_string(pawns.size()), Pawn::TYPE_RTTI));
+                    group->attachChild(pawns.back(), Matrix4::MakeTranslateTransform(position(random), height(random), position(random)));
+                }
+                root->attachChild(group, Matrix4::IDENTITY);
+            }
+            auto workers = std::make_shared<WorkerThreadPool>();
+            SceneBroadphase broadphase(0.1f, workers);
+            auto start = std::chrono::high_resolution_clock::now();
+            broadphase.insertSpatial(root);
+            const double build_ms = elapsedMilliseconds(start);
+            scene.publishEvents();
+            Assert::AreEqual(PAWN_COUNT, broadphase.statistics().m_proxyCount);
+
+            std::vector<Ray3> rays;
+            rays.reserve(RAY_COUNT);
+            for (unsigned i = 0; i < RAY_COUNT; i++)
+            {
+                rays.emplace_back(Vector3(position(random), height(random), position(random)), Vector3(unit(random), unit(random) * 0.1f, unit(random)));
+            }
+            start = std::chrono::high_resolution_clock::now();
+            std::vector<std::optional<SceneBroadphase::RayHit>> serial_hits(RAY_COUNT);
+            for (unsigned i = 0; i < RAY_COUNT; i++) serial_hits[i] = broadphase.raycastNearest(rays[i], MAX_T, nullptr);
+            const double serial_ms = elapsedMilliseconds(start);
+            start = std::chrono::high_resolution_clock::now();
+            const auto batch_hits = broadphase.raycastNearest(rays, MAX_T, nullptr);
+            const double batch_ms = elapsedMilliseconds(start);
+
+            unsigned hit_count = 0;
+            auto bounds = worldAabbs(pawns);
+            for (unsigned i = 0; i < RAY_COUNT; i++)
+            {
+                Assert::IsTrue(serial_hits[i].has_value() == batch_hits[i].has_value());
+                if (serial_hits[i]) Assert::IsTrue(serial_hits[i]->m_t == batch_hits[i]->m_t);
+                if (i < VERIFY_RAY_COUNT) assertNearestMatchesBruteForce(bounds, rays[i], MAX_T, serial_hits[i]);
+                if (serial_hits[i]) hit_count++;
+            }
+            Assert::IsTrue(hit_count > RAY_COUNT / 4);
+
+            // 每個 frame 移動 1% 的 pawn, 只計 broadphase 處理 bound changed event 的時間
+            std::uniform_real_distribution<float> offset(-0.3f, 0.3f);
+            double refit_ms = 0.0;
+            for (unsigned frame = 0; frame < MOVE_FRAMES; frame++)
+            {
+                for (unsigned i = frame; i < PAWN_COUNT; i += MOVE_STRIDE)
+                {
+                    const Vector3 moved = pawns[i]->getLocalTransform().UnMatrixTranslate() + Vector3(offset(random), 0.0f, offset(random));
+                    pawns[i]->setLocalTransform(Matrix4::MakeTranslateTransform(moved));
+                }
+                start = std::chrono::high_resolution_clock::now();
+                scene.publishEvents();
+                refit_ms += elapsedMilliseconds(start);
+            }
+            bounds = worldAabbs(pawns);
+            for (unsigned i = 0; i < VERIFY_RAY_COUNT; i++)
+            {
+                assertNearestMatchesBruteForce(bounds, rays[i], MAX_T, broadphase.raycastNearest(rays[i], MAX_T, nullptr));
+            }
+
+            const auto stat = broadphase.statistics();
+            char report[256];
+            snprintf(report, sizeof(report), "50k pawns: build %.1f ms, height %u; 10k rays %.2f ms serial, %.2f ms on %u workers, %u hits; %u frames x %u moves refit %.2f ms, %u reinserts\n",
+                build_ms, stat.m_treeHeight, serial_ms, batch_ms, workers->threadCount(), hit_count, MOVE_FRAMES, PAWN_COUNT / MOVE_STRIDE, refit_ms, stat.m_reinsertCount);
+            Logger::WriteMessage(report);
+        }
+
+    private:
+        static double elapsedMilliseconds(const std::chrono::high_resolution_clock::time_point& start)
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+
+        static std::vector<DynamicBoundTree::Aabb> worldAabbs(const std::vector<std::shared_ptr<Pawn>>& pawns)
+        {
+            std::vector<DynamicBoundTree::Aabb> bounds;
+            bounds.reserve(pawns.size());
+            for (const auto& pawn : pawns)
+            {
+                if (auto aabb = SceneBroadphase::aabbOfBound(pawn->getWorldBound())) bounds.emplace_back(aabb.value());
+            }
+            return bounds;
+        }
+
+        static void assertNearestMatchesBruteForce(const std::vector<DynamicBoundTree::Aabb>& bounds, const Ray3& ray, float max_t,
+            const std::optional<SceneBroadphase::RayHit>& hit)
+        {
+            const std::array<float, 3> origin = { ray.origin().x(), ray.origin().y(), ray.origin().z() };
+            const std::array<float, 3> inv_direction = { 1.0f / ray.direction().x(), 1.0f / ray.direction().y(), 1.0f / ray.direction().z() };
+            std::optional<float> nearest_t;
+            for (const auto& bound : bounds)
+            {
+                float t_enter;
+                if (DynamicBoundTree::intersectRay(bound, origin, inv_direction, max_t, t_enter))
+                {
+                    if ((!nearest_t) || (t_enter < nearest_t.value())) nearest_t = t_enter;
+                }
+            }
+            Assert::IsTrue(nearest_t.has_value() == hit.has_value());
+            if (hit) Assert::IsTrue(nearest_t.value() == hit->m_t);
+        }
+    };
+}
@@ -0,0 +1,269 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/SystemService.h"
+#include "Frameworks/EventPublisher.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Frameworks;
+
+namespace Enigma::ServiceSchedulingTest
+{
+    /** 每次 tick 固定花 cost 毫秒 (busy wait), cost 可以改 */
+    class FixedCostService : public ISystemService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        FixedCostService(ServiceManager* manager, ServicePriority priority, float cost_milliseconds) : ISystemService(manager), m_costMilliseconds(cost_milliseconds)
+        {
+            m_needTick = true;
+            tickPriority(priority);
+        }
+        virtual ServiceResult onTick() override
+        {
+            m_tickCount++;
+            if (m_onTick) m_onTick(*this);
+            const auto end = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(m_costMilliseconds));
+            while (std::chrono::steady_clock::now() < end) {}
+            return ServiceResult::Pendding;
+        }
+
+        float m_costMilliseconds;
+        unsigned m_tickCount = 0;
+        std::function<void(FixedCostService&)> m_onTick;
+    };
+    class CriticalService : public FixedCostService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        CriticalService(ServiceManager* manager, float cost_milliseconds) : FixedCostService(manager, ServicePriority::Critical, cost_milliseconds) {}
+    };
+    class NormalService : public FixedCostService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        NormalService(ServiceManager* manager, float cost_milliseconds) : FixedCostService(manager, ServicePriority::Normal, cost_milliseconds) {}
+    };
+    class BackgroundService : public FixedCostService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        BackgroundService(ServiceManager* manager, float cost_milliseconds) : FixedCostService(manager, ServicePriority::Background, cost_milliseconds) {}
+    };
+    class OtherBackgroundService : public FixedCostService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        OtherBackgroundService(ServiceManager* manager, float cost_milliseconds) : FixedCostService(manager, ServicePriority::Background, cost_milliseconds) {}
+    };
+    /** 做到 time slice 用完才停下來 */
+    class TimeSlicedService : public ISystemService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        TimeSlicedService(ServiceManager* manager) : ISystemService(manager)
+        {
+            m_needTick = true;
+            tickPriority(ServicePriority::Background);
+        }
+        virtual ServiceResult onTick() override
+        {
+            m_wasExpiredOnEnter = isTimeSliceExpired();
+            const auto safety_end = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+            while ((!isTimeSliceExpired()) && (std::chrono::steady_clock::now() < safety_end)) {}
+            m_hasStoppedAtSlice = isTimeSliceExpired();
+            return ServiceResult::Pendding;
+        }
+
+        bool m_wasExpiredOnEnter = true;
+        bool m_hasStoppedAtSlice = false;
+    };
+}
+
+DEFINE_RTTI(ServiceSchedulingTest, FixedCostService, ISystemService);
+DEFINE_RTTI(ServiceSchedulingTest, CriticalService, FixedCostService);
+DEFINE_RTTI(ServiceSchedulingTest, NormalService, FixedCostService);
+DEFINE_RTTI(ServiceSchedulingTest, BackgroundService, FixedCostService);
+DEFINE_RTTI(ServiceSchedulingTest, OtherBackgroundService, FixedCostService);
+DEFINE_RTTI(ServiceSchedulingTest, TimeSlicedService, ISystemService);
+
+using namespace Enigma::ServiceSchedulingTest;
+
+namespace SceneGraphTest
+{
+    TEST_CLASS(ServiceSchedulingTest)
+    {
+    public:
+        static constexpr float FRAME_BUDGET = 4.0f;
+        /// critical service 每個 frame 都用光 budget
+        static constexpr float OVER_BUDGET_COST = 6.0f;
+
+        TEST_METHOD(TestNormalServiceIsDeferredAtMostTwoFrames)
+        {
+            ServiceManager manager;
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+            manager.registerSystemService(std::make_shared<CriticalService>(&manager, OVER_BUDGET_COST));
+            auto normal = std::make_shared<NormalService>(&manager, 0.1f);
+            manager.registerSystemService(normal);
+            manager.runToState(ServiceManager::ServiceState::Running);
+            manager.frameBudget(FRAME_BUDGET);
+
+            constexpr unsigned frames = (ServiceManager::MAX_NORMAL_DEFERRED_FRAMES + 1) * 3;
+            for (unsigned i = 0; i < frames; i++)
+            {
+                manager.runOnce();
+                Assert::IsTrue(tickStatistics(manager, NormalService::TYPE_RTTI).m_deferredFrames <= ServiceManager::MAX_NORMAL_DEFERRED_FRAMES);
+            }
+            // 延後兩個 frame 之後一定 tick
+            Assert::AreEqual(3u, normal->m_tickCount);
+            Assert::AreEqual(std::uint64_t{ frames - 3 }, tickStatistics(manager, NormalService::TYPE_RTTI).m_deferredCount);
+        }
+
+        TEST_METHOD(TestBackgroundServiceIsDeferredAtMostEightFrames)
+        {
+            ServiceManager manager;
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+            manager.registerSystemService(std::make_shared<CriticalService>(&manager, OVER_BUDGET_COST));
+            auto background = std::make_shared<BackgroundService>(&manager, 0.1f);
+            manager.registerSystemService(background);
+            manager.runToState(ServiceManager::ServiceState::Running);
+            manager.frameBudget(FRAME_BUDGET);
+
+            constexpr unsigned frames = (ServiceManager::MAX_BACKGROUND_DEFERRED_FRAMES + 1) * 2;
+            for (unsigned i = 0; i < frames; i++)
+            {
+                manager.runOnce();
+                Assert::IsTrue(tickStatistics(manager, BackgroundService::TYPE_RTTI).m_deferredFrames <= ServiceManager::MAX_BACKGROUND_DEFERRED_FRAMES);
+            }
+            Assert::AreEqual(2u, background->m_tickCount);
+        }
+
+        TEST_METHOD(TestLongestDeferredBackgroundTicksFirst)
+        {
+            // budget 只放得下一個 background service, 兩個應該輪流 tick
+            constexpr float budget = 20.0f;
+            constexpr float cost = 12.0f;
+            ServiceManager manager;
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+            auto first = std::make_shared<BackgroundService>(&manager, cost);
+            auto second = std::make_shared<OtherBackgroundService>(&manager, cost);
+            manager.registerSystemService(first);
+            manager.registerSystemService(second);
+            manager.runToState(ServiceManager::ServiceState::Running);
+            manager.frameBudget(budget);
+
+            // 第一個 frame 還沒有量到 tick 時間, 兩個都 tick
+            manager.runOnce();
+            Assert::AreEqual(1u, first->m_tickCount);
+            Assert::AreEqual(1u, second->m_tickCount);
+            unsigned last_first = first->m_tickCount;
+            unsigned last_second = second->m_tickCount;
+            bool is_first_ticked = false;
+            for (unsigned i = 0; i < 6; i++)
+            {
+                manager.runOnce();
+                const bool first_ticked = first->m_tickCount != last_first;
+                const bool second_ticked = second->m_tickCount != last_second;
+                Assert::IsTrue(first_ticked != second_ticked);
+                // 第二個 frame 兩個都沒延後, 照註冊順序; 之後是上個 frame 延後的那個
+                if (i == 0) Assert::IsTrue(first_ticked);
+                else Assert::IsTrue(first_ticked != is_first_ticked);
+                is_first_ticked = first_ticked;
+                last_first = first->m_tickCount;
+                last_second = second->m_tickCount;
+            }
+        }
+
+        TEST_METHOD(TestTimeSliceExpiresAtFrameDeadline)
+        {
+            ServiceManager manager;
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+            auto sliced = std::make_shared<TimeSlicedService>(&manager);
+            manager.registerSystemService(sliced);
+            manager.runToState(ServiceManager::ServiceState::Running);
+
+            // 沒有 budget 時 time slice 不會用完
+            Assert::IsFalse(sliced->isTimeSliceExpired());
+
+            manager.frameBudget(FRAME_BUDGET);
+            for (unsigned i = 0; i < 4; i++)
+            {
+                manager.runOnce();
+                Assert::IsFalse(sliced->m_wasExpiredOnEnter);
+                Assert::IsTrue(sliced->m_hasStoppedAtSlice);
+                const auto statistics = tickStatistics(manager, TimeSlicedService::TYPE_RTTI);
+                Assert::IsTrue(statistics.m_isTimeSliced);
+                // 準時在 frame deadline 停下來
+                Assert::IsTrue(statistics.m_lastTickMilliseconds <= FRAME_BUDGET + ServiceManager::MIN_TIME_SLICE_MILLISECONDS);
+                Assert::IsTrue(manager.frameTimeStatistics().m_serviceMilliseconds >= FRAME_BUDGET);
+            }
+        }
+
+        TEST_METHOD(TestForcedTickGetsMinimumTimeSlice)
+        {
+            ServiceManager manager;
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+            manager.registerSystemService(std::make_shared<CriticalService>(&manager, OVER_BUDGET_COST));
+            auto sliced = std::make_shared<TimeSlicedService>(&manager);
+            manager.registerSystemService(sliced);
+            manager.runToState(ServiceManager::ServiceState::Running);
+            manager.frameBudget(FRAME_BUDGET);
+
+            for (unsigned i = 0; i < ServiceManager::MAX_BACKGROUND_DEFERRED_FRAMES + 1; i++) manager.runOnce();
+            // budget 已經用完, 被強制 tick 時還有最小的 time slice
+            const auto statistics = tickStatistics(manager, TimeSlicedService::TYPE_RTTI);
+            Assert::AreEqual(std::uint64_t{ 1 }, statistics.m_tickCount);
+            Assert::IsFalse(sliced->m_wasExpiredOnEnter);
+            Assert::IsTrue(sliced->m_hasStoppedAtSlice);
+            Assert::IsTrue(statistics.m_lastTickMilliseconds >= ServiceManager::MIN_TIME_SLICE_MILLISECONDS);
+        }
+
+        TEST_METHOD(TestStutterIsReported)
+        {
+            constexpr float steady_cost = 5.0f;
+            constexpr float spike_cost = 40.0f;
+            ServiceManager manager;
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+            auto critical = std::make_shared<CriticalService>(&manager, steady_cost);
+            manager.registerSystemService(critical);
+            manager.runToState(ServiceManager::ServiceState::Running);
+            // runToState 的 frame 不 tick, 不要算進平均
+            manager.resetSchedulingStatistics();
+
+            for (unsigned i = 0; i < 6; i++)
+            {
+                manager.runOnce();
+                Assert::IsFalse(manager.frameTimeStatistics().m_isStutter);
+            }
+            Assert::AreEqual(std::uint64_t{ 0 }, manager.frameTimeStatistics().m_stutterCount);
+
+            // frame time 是兩次 runOnce 的間隔, spike 的 frame 在下一次 runOnce 才報
+            critical->m_costMilliseconds = spike_cost;
+            manager.runOnce();
+            critical->m_costMilliseconds = steady_cost;
+            manager.runOnce();
+            Assert::IsTrue(manager.frameTimeStatistics().m_isStutter);
+            Assert::AreEqual(std::uint64_t{ 1 }, manager.frameTimeStatistics().m_stutterCount);
+            Assert::IsTrue(manager.frameTimeStatistics().m_maxFrameMilliseconds >= spike_cost);
+
+            manager.runOnce();
+            Assert::IsFalse(manager.frameTimeStatistics().m_isStutter);
+            Assert::AreEqual(std::uint64_t{ 1 }, manager.frameTimeStatistics().m_stutterCount);
+        }
+
+    private:
+        static ServiceManager::ServiceTickStatistics tickStatistics(const ServiceManager& manager, const Enigma::Frameworks::Rtti& service_type)
+        {
+            const auto statistics = manager.serviceTickStatistics();
+            const auto it = std::find_if(statistics.begin(), statistics.end(),
+                [&](const ServiceManager::ServiceTickStatistics& s) { return s.m_name == service_type.getName(); });
+            Assert::IsTrue(it != statistics.end());
+            return *it;
+        }
+    };
+}
@@ -0,0 +1,355 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#define ENABLE_SERVICE_ACCESS_CHECK
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/SystemService.h"
+#include "Frameworks/SystemServiceEvents.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/EventSubscriber.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "Frameworks/ServiceAccessChecker.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Frameworks;
+
+namespace Enigma::ServiceTickingTest
+{
+    class TickingService : public ISystemService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        TickingService(ServiceManager* manager, const std::function<ServiceResult()>& tick) : ISystemService(manager), m_tick(tick) { m_needTick = true; }
+        virtual ServiceResult onTick() override { return m_tick(); }
+
+    protected:
+        std::function<ServiceResult()> m_tick;
+    };
+    class AlphaService : public TickingService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        using TickingService::TickingService;
+    };
+    class BetaService : public TickingService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        using TickingService::TickingService;
+    };
+    class GammaService : public TickingService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        using TickingService::TickingService;
+    };
+    class DeltaService : public TickingService
+    {
+        DECLARE_EN_RTTI;
+    public:
+        using TickingService::TickingService;
+    };
+}
+
+DEFINE_RTTI(ServiceTickingTest, TickingService, ISystemService);
+DEFINE_RTTI(ServiceTickingTest, AlphaService, TickingService);
+DEFINE_RTTI(ServiceTickingTest, BetaService, TickingService);
+DEFINE_RTTI(ServiceTickingTest, GammaService, TickingService);
+DEFINE_RTTI(ServiceTickingTest, DeltaService, TickingService);
+
+using namespace Enigma::ServiceTickingTest;
+
+namespace SceneGraphTest
+{
+    /** 在 tick 中進出時計數, 記錄同時在 tick 的最大數量 */
+    class InFlightCounter
+    {
+    public:
+        void enter()
+        {
+            const unsigned count = ++m_inFlight;
+            unsigned max_count = m_maxInFlight.load();
+            while ((count > max_count) && (!m_maxInFlight.compare_exchange_weak(max_count, count))) {}
+        }
+        void leave() { --m_inFlight; }
+        unsigned maxInFlight() const { return m_maxInFlight.load(); }
+
+    private:
+        std::atomic<unsigned> m_inFlight{ 0 };
+        std::atomic<unsigned> m_maxInFlight{ 0 };
+    };
+
+    /** 兩個 tick 互相等待對方抵達; 只有真的同時在 tick 才會會合, 序列執行時逾時返回 false */
+    class Rendezvous
+    {
+    public:
+        static constexpr std::chrono::seconds WAIT_TIMEOUT{ 2 };
+
+        bool arriveAndWait(unsigned parties)
+        {
+            std::unique_lock locker{ m_lock };
+            const unsigned generation = m_generation;
+            if (++m_arrived == parties)
+            {
+                m_arrived = 0;
+                m_generation++;
+                m_condition.notify_all();
+                return true;
+            }
+            if (m_condition.wait_for(locker, WAIT_TIMEOUT, [&]() { return m_generation != generation; })) return true;
+            m_arrived--;
+            return false;
+        }
+
+    private:
+        std::mutex m_lock;
+        std::condition_variable m_condition;
+        unsigned m_arrived = 0;
+        unsigned m_generation = 0;
+    };
+
+    TEST_CLASS(ServiceTickingTest)
+    {
+    public:
+        static constexpr unsigned TEST_FRAMES = 8;
+
+        TEST_METHOD(TestIndependentServicesTickConcurrently)
+        {
+            ServiceAccessChecker::clearViolations();
+            auto workers = std::make_shared<WorkerThreadPool>(3);
+            ServiceManager manager;
+            manager.enableConcurrentTicking(workers);
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+
+            InFlightCounter counter;
+            Rendezvous rendezvous;
+            std::atomic<unsigned> writers_in_flight{ 0 };
+            std::atomic<unsigned> met_count{ 0 };
+            std::atomic<bool> is_gamma_overlapped{ false };
+            auto writer_tick = [&]()
+            {
+                counter.enter();
+                ++writers_in_flight;
+                if (rendezvous.arriveAndWait(2)) ++met_count;
+                --writers_in_flight;
+                counter.leave();
+                return ServiceResult::Pendding;
+            };
+            auto alpha = std::make_shared<AlphaService>(&manager, writer_tick);
+            alpha->declareWriteAccess("A");
+            auto beta = std::make_shared<BetaService>(&manager, writer_tick);
+            beta->declareWriteAccess("B");
+            auto gamma = std::make_shared<GammaService>(&manager, [&]()
+                {
+                    counter.enter();
+                    if (writers_in_flight.load() != 0) is_gamma_overlapped = true;
+                    std::this_thread::yield();
+                    if (writers_in_flight.load() != 0) is_gamma_overlapped = true;
+                    counter.leave();
+                    return ServiceResult::Pendding;
+                });
+            gamma->declareReadAccess("A");
+            gamma->declareReadAccess("B");
+            manager.registerSystemService(alpha);
+            manager.registerSystemService(beta);
+            manager.registerSystemService(gamma);
+
+            manager.runToState(ServiceManager::ServiceState::Running);
+            for (unsigned i = 0; i < TEST_FRAMES; i++) manager.runOnce();
+
+            // alpha 跟 beta 同一個 wave, 每個 frame 都會合 (兩個 tick 都成功); gamma 讀 alpha / beta 寫的資源, 在下一個 wave
+            Assert::AreEqual(TEST_FRAMES * 2, met_count.load());
+            Assert::IsTrue(counter.maxInFlight() <= 2u);
+            Assert::IsFalse(is_gamma_overlapped.load());
+            Assert::AreEqual(static_cast<size_t>(0), ServiceAccessChecker::violationCount());
+        }
+
+        TEST_METHOD(TestConflictingServicesNeverOverlap)
+        {
+            ServiceAccessChecker::clearViolations();
+            auto workers = std::make_shared<WorkerThreadPool>(3);
+            ServiceManager manager;
+            manager.enableConcurrentTicking(workers);
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+
+            int shared_value = 0;  // 故意不同步, 只靠宣告的存取排程保護
+            std::atomic<bool> is_writing{ false };
+            std::atomic<bool> is_overlapped{ false };
+            InFlightCounter reader_counter;
+            Rendezvous reader_rendezvous;
+            std::atomic<unsigned> reader_met_count{ 0 };
+            std::vector<int> read_values;
+            std::mutex read_values_lock;
+            auto writer = std::make_shared<AlphaService>(&manager, [&]()
+                {
+                    SERVICE_WRITE_ACCESS("Shared");
+                    is_writing = true;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    shared_value++;
+                    is_writing = false;
+                    return ServiceResult::Pendding;
+                });
+            writer->declareWriteAccess("Shared");
+            auto reader = [&]()
+            {
+                SERVICE_READ_ACCESS("Shared");
+                reader_counter.enter();
+                if (is_writing) is_overlapped = true;
+                if (reader_rendezvous.arriveAndWait(2)) ++reader_met_count;
+                const int value = shared_value;
+                if (is_writing) is_overlapped = true;
+                reader_counter.leave();
+                std::lock_guard locker{ read_values_lock };
+                read_values.push_back(value);
+                return ServiceResult::Pendding;
+            };
+            auto beta = std::make_shared<BetaService>(&manager, reader);
+            beta->declareReadAccess("Shared");
+            auto gamma = std::make_shared<GammaService>(&manager, reader);
+            gamma->declareReadAccess("Shared");
+            manager.registerSystemService(writer);
+            manager.registerSystemService(beta);
+            manager.registerSystemService(gamma);
+
+            manager.runToState(ServiceManager::ServiceState::Running);
+            for (unsigned i = 0; i < TEST_FRAMES; i++) manager.runOnce();
+
+            Assert::IsFalse(is_overlapped.load());
+            Assert::AreEqual(TEST_FRAMES * 2, reader_met_count.load());
+            Assert::IsTrue(reader_counter.maxInFlight() <= 2u);
+            // writer 先註冊, 同一個 frame 的兩個 reader 都讀到這個 frame 寫入後的值
+            Assert::AreEqual(static_cast<int>(TEST_FRAMES), shared_value);
+            Assert::AreEqual(static_cast<size_t>(TEST_FRAMES * 2), read_values.size());
+            for (size_t i = 0; i < read_values.size(); i++)
+            {
+                Assert::AreEqual(static_cast<int>(i / 2) + 1, read_values[i]);
+            }
+            Assert::AreEqual(static_cast<size_t>(0), ServiceAccessChecker::violationCount());
+        }
+
+        TEST_METHOD(TestUndeclaredAccessIsDetected)
+        {
+            ServiceAccessChecker::clearViolations();
+            auto workers = std::make_shared<WorkerThreadPool>(3);
+            ServiceManager manager;
+            manager.enableConcurrentTicking(workers);
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+
+            // alpha 宣告只寫 "A", 實際上也寫了 beta 的 "B"
+            auto alpha = std::make_shared<AlphaService>(&manager, []()
+                {
+                    SERVICE_WRITE_ACCESS("A");
+                    SERVICE_WRITE_ACCESS("B");
+                    return ServiceResult::Pendding;
+                });
+            alpha->declareWriteAccess("A");
+            auto beta = std::make_shared<BetaService>(&manager, []()
+                {
+                    SERVICE_WRITE_ACCESS("B");
+                    return ServiceResult::Pendding;
+                });
+            beta->declareWriteAccess("B");
+            manager.registerSystemService(alpha);
+            manager.registerSystemService(beta);
+
+            manager.runToState(ServiceManager::ServiceState::Running);
+            for (unsigned i = 0; i < TEST_FRAMES; i++) manager.runOnce();
+
+            const auto violations = ServiceAccessChecker::violations();
+            Assert::AreEqual(static_cast<size_t>(2), violations.size());
+            const bool has_undeclared = std::any_of(violations.begin(), violations.end(), [](const ServiceAccessChecker::Violation& v)
+                { return (v.m_kind == ServiceAccessChecker::Violation::Kind::Undeclared) && (v.m_resource == "B") && (v.m_service == AlphaService::TYPE_RTTI.getName()); });
+            const bool has_race = std::any_of(violations.begin(), violations.end(), [](const ServiceAccessChecker::Violation& v)
+                { return (v.m_kind == ServiceAccessChecker::Violation::Kind::Race) && (v.m_resource == "B"); });
+            Assert::IsTrue(has_undeclared);
+            Assert::IsTrue(has_race);
+        }
+
+        TEST_METHOD(TestServiceStatesArePreserved)
+        {
+            ServiceAccessChecker::clearViolations();
+            auto workers = std::make_shared<WorkerThreadPool>(3);
+            ServiceManager manager;
+            manager.enableConcurrentTicking(workers);
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+
+            unsigned initialized_count = 0;
+            auto on_initialized = std::make_shared<EventSubscriber>([&](const IEventPtr&) { initialized_count++; });
+            EventPublisher::subscribe(typeid(AllServiceInitialized), on_initialized);
+
+            std::atomic<unsigned> alpha_ticks{ 0 };
+            auto alpha = std::make_shared<AlphaService>(&manager, [&]()
+                {
+                    // 第三次 tick 結束, 進入 shutdown
+                    return ++alpha_ticks >= 3 ? ServiceResult::Complete : ServiceResult::Pendding;
+                });
+            alpha->declareWriteAccess("A");
+            auto beta = std::make_shared<BetaService>(&manager, []() { return ServiceResult::Pendding; });
+            beta->declareWriteAccess("B");
+            manager.registerSystemService(alpha);
+            manager.registerSystemService(beta);
+
+            manager.runToState(ServiceManager::ServiceState::Running);
+            Assert::IsTrue(manager.checkServiceState(AlphaService::TYPE_RTTI) == ServiceManager::ServiceState::Running);
+            for (unsigned i = 0; i < TEST_FRAMES; i++) manager.runOnce();
+
+            Assert::AreEqual(1u, initialized_count);
+            Assert::AreEqual(3u, alpha_ticks.load());
+            Assert::IsTrue(manager.checkServiceState(BetaService::TYPE_RTTI) == ServiceManager::ServiceState::Running);
+            // alpha 走完 WaitingToShutdown -> ShuttingDown -> Complete, 被移除
+            Assert::IsTrue(manager.checkServiceState(AlphaService::TYPE_RTTI) == ServiceManager::ServiceState::Deleted);
+            EventPublisher::unsubscribe(typeid(AllServiceInitialized), on_initialized);
+        }
+
+        TEST_METHOD(TestRegistrationOrderIsKeptAroundUndeclaredServices)
+        {
+            ServiceAccessChecker::clearViolations();
+            auto workers = std::make_shared<WorkerThreadPool>(3);
+            ServiceManager manager;
+            manager.enableConcurrentTicking(workers);
+            manager.registerSystemService(std::make_shared<EventPublisher>(&manager));
+
+            std::mutex order_lock;
+            std::vector<char> order;
+            auto record = [&](char name)
+            {
+                return [&, name]()
+                {
+                    std::lock_guard locker{ order_lock };
+                    order.push_back(name);
+                    return ServiceResult::Pendding;
+                };
+            };
+            // alpha 有宣告, delta 沒有宣告, beta/gamma 有宣告; delta 把它們分成前後兩段
+            auto alpha = std::make_shared<AlphaService>(&manager, record('a'));
+            alpha->declareWriteAccess("A");
+            auto delta = std::make_shared<DeltaService>(&manager, record('d'));
+            auto beta = std::make_shared<BetaService>(&manager, record('b'));
+            beta->declareWriteAccess("B");
+            auto gamma = std::make_shared<GammaService>(&manager, record('c'));
+            gamma->declareWriteAccess("C");
+            manager.registerSystemService(alpha);
+            manager.registerSystemService(delta);
+            manager.registerSystemService(beta);
+            manager.registerSystemService(gamma);
+
+            manager.runToState(ServiceManager::ServiceState::Running);
+            for (unsigned i = 0; i < TEST_FRAMES; i++)
+            {
+                order.clear();
+                manager.runOnce();
+                Assert::AreEqual(size_t{ 4 }, order.size());
+                Assert::AreEqual('a', order[0]);
+                Assert::AreEqual('d', order[1]);
+                // beta, gamma 不衝突, 彼此順序不定
+                Assert::IsTrue(std::is_permutation(order.begin() + 2, order.end(), std::vector<char>{ 'b', 'c' }.begin()));
+            }
+        }
+    };
+}
@@ -0,0 +1,165 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "GraphicKernel/ShaderBinaryCache.h"
+#include "GraphicKernel/GraphicErrors.h"
+#include "FileSystem/FileSystem.h"
+#include "FileSystem/StdMountPath.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Graphics;
+
+namespace SceneGraphTest
+{
+    /** cache 目錄掛在 CACHE_PATH_ID 下, 每個 test 建自己的 file system, 結束時都清掉 */
+    class ShaderCacheScratch
+    {
+    public:
+        static inline const std::string CACHE_PATH_ID = "ShaderCacheTestPath";
+
+        explicit ShaderCacheScratch(const std::string& name) : m_dir(std::filesystem::temp_directory_path() / ("EnigmaShaderBinaryCacheTest_" + name))
+        {
+            std::filesystem::remove_all(m_dir);
+            std::filesystem::create_directories(m_dir);
+            m_fileSystem.reset(Enigma::FileSystem::FileSystem::create());
+            m_fileSystem->addMountPath(std::make_shared<Enigma::FileSystem::StdMountPath>(m_dir.generic_string(), CACHE_PATH_ID));
+        }
+        ~ShaderCacheScratch()
+        {
+            m_fileSystem = nullptr;
+            std::error_code er;
+            std::filesystem::remove_all(m_dir, er);
+        }
+        std::filesystem::path realPath(std::uint64_t key) const
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "%016llx.shbin", static_cast<unsigned long long>(key));
+            return m_dir / name;
+        }
+
+    private:
+        std::filesystem::path m_dir;
+        std::unique_ptr<Enigma::FileSystem::FileSystem> m_fileSystem;
+    };
+
+    TEST_CLASS(ShaderBinaryCacheTest)
+    {
+    public:
+        TEST_METHOD(TestStoreThenLoad)
+        {
+            ShaderCacheScratch scratch("StoreLoad");
+            ShaderBinaryCache cache(ShaderCacheScratch::CACHE_PATH_ID);
+            const auto key = ShaderBinaryCache::makeKey("float4 main() : SV_Target { return 1; }", "ps_5_0", "main", "dx11");
+            Assert::IsFalse(cache.load(key).has_value());
+            const auto binary = makeBinary(300);
+            Assert::IsTrue(cache.store(key, binary) == ErrorCode::ok);
+            auto loaded = cache.load(key);
+            Assert::IsTrue(loaded.has_value());
+            Assert::IsTrue(loaded.value() == binary);
+            Assert::IsTrue(cache.store(key, byte_buffer{}) == ErrorCode::nullMemoryBuffer);
+
+            // 另一個 cache 物件 (下次啟動) 讀得到同一份
+            ShaderBinaryCache warm_cache(ShaderCacheScratch::CACHE_PATH_ID);
+            Assert::IsTrue(warm_cache.load(key) == binary);
+            const auto statistics = cache.statistics();
+            Assert::AreEqual(1u, statistics.m_hits);
+            Assert::AreEqual(1u, statistics.m_misses);
+            Assert::AreEqual(1u, statistics.m_stores);
+        }
+
+        TEST_METHOD(TestKeyCoversEveryPart)
+        {
+            const auto key = ShaderBinaryCache::makeKey("code", "vs_5_0", "main", "dx11");
+            Assert::AreEqual(key, ShaderBinaryCache::makeKey("code", "vs_5_0", "main", "dx11"));
+            Assert::AreNotEqual(key, ShaderBinaryCache::makeKey("code ", "vs_5_0", "main", "dx11"));
+            Assert::AreNotEqual(key, ShaderBinaryCache::makeKey("code", "vs_4_0", "main", "dx11"));
+            Assert::AreNotEqual(key, ShaderBinaryCache::makeKey("code", "vs_5_0", "VSMain", "dx11"));
+            Assert::AreNotEqual(key, ShaderBinaryCache::makeKey("code", "vs_5_0", "main", "dx11 debug"));
+            // 字串邊界不同不能撞在一起
+            Assert::AreNotEqual(ShaderBinaryCache::makeKey("ab", "c", "main", "dx11"), ShaderBinaryCache::makeKey("a", "bc", "main", "dx11"));
+        }
+
+        TEST_METHOD(TestRejectsVersionMismatch)
+        {
+            ShaderCacheScratch scratch("Version");
+            ShaderBinaryCache cache(ShaderCacheScratch::CACHE_PATH_ID);
+            const auto key = ShaderBinaryCache::makeKey("code", "vs_5_0", "main", "dx11");
+            Assert::IsTrue(cache.store(key, makeBinary(64)) == ErrorCode::ok);
+            // header : magic(4) version(4) key(8) size(4)
+            auto content = readFile(scratch.realPath(key));
+            content[4] ^= 0x7f;
+            writeFile(scratch.realPath(key), content);
+            Assert::IsFalse(cache.load(key).has_value());
+            content[4] ^= 0x7f;
+            content[0] = 'X';
+            writeFile(scratch.realPath(key), content);
+            Assert::IsFalse(cache.load(key).has_value());
+            Assert::AreEqual(2u, cache.statistics().m_misses);
+        }
+
+        TEST_METHOD(TestRejectsKeyMismatch)
+        {
+            ShaderCacheScratch scratch("Key");
+            ShaderBinaryCache cache(ShaderCacheScratch::CACHE_PATH_ID);
+            const auto key = ShaderBinaryCache::makeKey("code", "vs_5_0", "main", "dx11");
+            const auto other_key = ShaderBinaryCache::makeKey("other code", "vs_5_0", "main", "dx11");
+            Assert::IsTrue(cache.store(key, makeBinary(64)) == ErrorCode::ok);
+            // 檔名對了但內容記錄的是別的 key (ex. 被改名或 hash 撞檔名)
+            std::filesystem::copy_file(scratch.realPath(key), scratch.realPath(other_key));
+            Assert::IsFalse(cache.load(other_key).has_value());
+            Assert::IsTrue(cache.load(key).has_value());
+        }
+
+        TEST_METHOD(TestRejectsSizeMismatch)
+        {
+            ShaderCacheScratch scratch("Size");
+            ShaderBinaryCache cache(ShaderCacheScratch::CACHE_PATH_ID);
+            const auto key = ShaderBinaryCache::makeKey("code", "ps_5_0", "main", "dx11");
+            Assert::IsTrue(cache.store(key, makeBinary(64)) == ErrorCode::ok);
+            const auto content = readFile(scratch.realPath(key));
+
+            // 寫到一半被截斷
+            writeFile(scratch.realPath(key), byte_buffer(content.begin(), content.end() - 1));
+            Assert::IsFalse(cache.load(key).has_value());
+            // 後面多了垃圾
+            auto padded = content;
+            padded.push_back(0);
+            writeFile(scratch.realPath(key), padded);
+            Assert::IsFalse(cache.load(key).has_value());
+            // 只剩 header
+            writeFile(scratch.realPath(key), byte_buffer(content.begin(), content.begin() + 20));
+            Assert::IsFalse(cache.load(key).has_value());
+
+            writeFile(scratch.realPath(key), content);
+            Assert::IsTrue(cache.load(key).has_value());
+        }
+
+    private:
+        static byte_buffer makeBinary(size_t size)
+        {
+            byte_buffer binary(size);
+            for (size_t i = 0; i < size; i++)
+            {
+                binary[i] = static_cast<unsigned char>(i * 31 + 7);
+            }
+            return binary;
+        }
+
+        static byte_buffer readFile(const std::filesystem::path& path)
+        {
+            std::ifstream file{ path, std::ios::binary };
+            return byte_buffer(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        static void writeFile(const std::filesystem::path& path, const byte_buffer& content)
+        {
+            std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+            file.write(reinterpret_cast<const char*>(content.data()), content.size());
+        }
+    };
+}
@@ -0,0 +1,199 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "Terrain/TerrainChunkLayout.h"
+#include "MathLib/MathAlgorithm.h"
+#include "MathLib/MathGlobal.h"
+#include "MathLib/Radian.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Terrain;
+using namespace Enigma::MathLib;
+
+namespace SceneGraphTest
+{
+    TEST_CLASS(TerrainChunkLayoutTest)
+    {
+    public:
+        static constexpr float FOV_Y = 1.0471976f;  // 60 度
+
+        TEST_METHOD(TestChunkPatternsAreCrackFree)
+        {
+            constexpr unsigned ROWS = 128;
+            constexpr unsigned COLS = 256;
+            constexpr unsigned CELLS = 16;
+            TerrainChunkLayout layout{ ROWS, COLS, CELLS };
+            Assert::IsTrue(layout.isValid());
+            const uint_buffer indices = layout.buildIndexPatterns();
+            Assert::IsTrue(indices.size() == layout.patternIndexCount());
+            const float_buffer heights = makeHeights(ROWS, COLS);
+            layout.calculateChunkBounds(heights, Vector3{ 0.0f, 0.0f, 0.0f }, Vector3{ static_cast<float>(COLS), 0.0f, static_cast<float>(ROWS) });
+
+            // 在角落往對角看, 近處細遠處粗, 各種 lod 差都會出現
+            const Vector3 eye{ 8.0f, 30.0f, 8.0f };
+            const auto selections = layout.selectChunks(eye, viewProjection(eye, Vector3{ 200.0f, 0.0f, 100.0f }), 16.0f);
+            Assert::IsFalse(selections.empty());
+            Assert::IsTrue(selections.size() < layout.chunkCount());
+            const auto& lods = layout.chunkLods();
+            std::set<unsigned> used_lods;
+            for (const auto& lod : lods) used_lods.insert(lod.m_lod);
+            Assert::IsTrue(used_lods.size() >= 3);
+            for (const auto& selection : selections)
+            {
+                Assert::IsTrue(selection.m_lod == lods[selection.m_chunk].m_lod);
+                Assert::IsTrue(selection.m_stitchMask == lods[selection.m_chunk].m_stitchMask);
+            }
+
+            // 每個 chunk (含被剔除的) 用自己的 pattern + base vertex: 頂點都在 chunk 內, 三角形剛好鋪滿 chunk
+            std::vector<std::set<unsigned>> chunk_vertices(layout.chunkCount());
+            for (unsigned chunk = 0; chunk < layout.chunkCount(); chunk++)
+            {
+                const auto segment = layout.chunkSegment(chunk, lods[chunk].m_lod, lods[chunk].m_stitchMask);
+                Assert::IsTrue(segment.m_idxCount == layout.patternTriangleCount(lods[chunk].m_lod, lods[chunk].m_stitchMask) * 3);
+                unsigned min_x, min_z, max_x, max_z;
+                layout.chunkVertexRange(chunk, min_x, min_z, max_x, max_z);
+                double area = 0.0;
+                for (unsigned i = segment.m_startIdx; i < segment.m_startIdx + segment.m_idxCount; i += 3)
+                {
+                    int xs[3], zs[3];
+                    for (unsigned k = 0; k < 3; k++)
+                    {
+                        const unsigned vertex = indices[i + k] + segment.m_startVtx;
+                        xs[k] = static_cast<int>(vertex % (COLS + 1));
+                        zs[k] = static_cast<int>(vertex / (COLS + 1));
+                        Assert::IsTrue((xs[k] >= static_cast<int>(min_x)) && (xs[k] <= static_cast<int>(max_x)));
+                        Assert::IsTrue((zs[k] >= static_cast<int>(min_z)) && (zs[k] <= static_cast<int>(max_z)));
+                        chunk_vertices[chunk].insert(vertex);
+                    }
+                    area += std::abs((xs[1] - xs[0]) * (zs[2] - zs[0]) - (xs[2] - xs[0]) * (zs[1] - zs[0])) * 0.5;
+                }
+                Assert::IsTrue(area == static_cast<double>(CELLS * CELLS));
+            }
+
+            // 相鄰 chunk 的 lod 差不超過 1, 共用邊上用到的頂點兩邊一致 (沒有 T 形接縫)
+            auto edge_vertices = [&](unsigned chunk, bool is_x_edge, unsigned coordinate)
+            {
+                std::set<unsigned> on_edge;
+                for (unsigned vertex : chunk_vertices[chunk])
+                {
+                    const unsigned value = is_x_edge ? vertex % (COLS + 1) : vertex / (COLS + 1);
+                    if (value == coordinate) on_edge.insert(vertex);
+                }
+                return on_edge;
+            };
+            unsigned stitched_edges = 0;
+            for (unsigned cz = 0; cz < layout.chunkCountZ(); cz++)
+            {
+                for (unsigned cx = 0; cx < layout.chunkCountX(); cx++)
+                {
+                    const unsigned chunk = cz * layout.chunkCountX() + cx;
+                    if (cx + 1 < layout.chunkCountX())
+                    {
+                        const unsigned right = chunk + 1;
+                        Assert::IsTrue(std::max(lods[chunk].m_lod, lods[right].m_lod) - std::min(lods[chunk].m_lod, lods[right].m_lod) <= 1);
+                        if (lods[chunk].m_lod != lods[right].m_lod) stitched_edges++;
+                        Assert::IsTrue(edge_vertices(chunk, true, (cx + 1) * CELLS) == edge_vertices(right, true, (cx + 1) * CELLS));
+                    }
+                    if (cz + 1 < layout.chunkCountZ())
+                    {
+                        const unsigned up = chunk + layout.chunkCountX();
+                        Assert::IsTrue(std::max(lods[chunk].m_lod, lods[up].m_lod) - std::min(lods[chunk].m_lod, lods[up].m_lod) <= 1);
+                        if (lods[chunk].m_lod != lods[up].m_lod) stitched_edges++;
+                        Assert::IsTrue(edge_vertices(chunk, false, (cz + 1) * CELLS) == edge_vertices(up, false, (cz + 1) * CELLS));
+                    }
+                }
+            }
+            Assert::IsTrue(stitched_edges > 0);
+        }
+
+        TEST_METHOD(TestChunksBehindCameraAreCulled)
+        {
+            constexpr unsigned SIZE = 256;
+            constexpr unsigned CELLS = 32;
+            TerrainChunkLayout layout{ SIZE, SIZE, CELLS };
+            layout.buildIndexPatterns();
+            layout.calculateChunkBounds(makeHeights(SIZE, SIZE), Vector3{ 0.0f, 0.0f, 0.0f }, Vector3{ static_cast<float>(SIZE), 0.0f, static_cast<float>(SIZE) });
+            const Vector3 eye{ 128.0f, 20.0f, 128.0f };
+            const auto selections = layout.selectChunks(eye, viewProjection(eye, Vector3{ 256.0f, 0.0f, 128.0f }), 32.0f);
+            Assert::IsFalse(selections.empty());
+            bool is_camera_chunk_visible = false;
+            for (const auto& selection : selections)
+            {
+                Assert::IsTrue(layout.chunkMaxCorner(selection.m_chunk).x() > eye.x() - 1.0f);
+                if ((layout.chunkMinCorner(selection.m_chunk).x() <= eye.x()) && (layout.chunkMaxCorner(selection.m_chunk).x() >= eye.x())
+                    && (layout.chunkMinCorner(selection.m_chunk).z() <= eye.z()) && (layout.chunkMaxCorner(selection.m_chunk).z() >= eye.z()))
+                {
+                    is_camera_chunk_visible = true;
+                }
+            }
+            Assert::IsTrue(is_camera_chunk_visible);
+        }
+
+        TEST_METHOD(BenchmarkSelect4kTerrain)
+        {
+            constexpr unsigned SIZE = 4096;
+            constexpr unsigned CELLS = 64;
+            constexpr unsigned FRAMES = 16;
+            TerrainChunkLayout layout{ SIZE, SIZE, CELLS };
+            const float_buffer heights = makeHeights(SIZE, SIZE);
+
+            auto start = std::chrono::steady_clock::now();
+            const uint_buffer indices = layout.buildIndexPatterns();
+            layout.calculateChunkBounds(heights, Vector3{ 0.0f, 0.0f, 0.0f }, Vector3{ static_cast<float>(SIZE), 0.0f, static_cast<float>(SIZE) });
+            const double setup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            // 在中心原地轉一圈
+            const Vector3 eye{ SIZE * 0.5f, 60.0f, SIZE * 0.5f };
+            size_t visible_chunks = 0;
+            size_t drawn_triangles = 0;
+            start = std::chrono::steady_clock::now();
+            for (unsigned frame = 0; frame < FRAMES; frame++)
+            {
+                const float yaw = Math::TWO_PI * static_cast<float>(frame) / static_cast<float>(FRAMES);
+                const Vector3 at{ eye.x() + std::cos(yaw) * 100.0f, 40.0f, eye.z() + std::sin(yaw) * 100.0f };
+                const auto selections = layout.selectChunks(eye, viewProjection(eye, at), 64.0f);
+                visible_chunks += selections.size();
+                for (const auto& selection : selections)
+                {
+                    drawn_triangles += layout.patternTriangleCount(selection.m_lod, selection.m_stitchMask);
+                }
+            }
+            const double select_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / FRAMES;
+            const size_t full_triangles = static_cast<size_t>(SIZE) * SIZE * 2;
+            Assert::IsTrue(visible_chunks / FRAMES < layout.chunkCount() / 2);
+            Assert::IsTrue(drawn_triangles / FRAMES < full_triangles / 100);
+
+            char report[320];
+            snprintf(report, sizeof(report), "%ux%u cells, %u-cell chunks: setup %.1f ms, pattern indices %zu (full mesh %zu); "
+                "per frame %zu / %u chunks visible, %zu triangles (full mesh %zu), select %.3f ms\n",
+                SIZE, SIZE, CELLS, setup_ms, indices.size(), full_triangles * 3, visible_chunks / FRAMES, layout.chunkCount(),
+                drawn_triangles / FRAMES, full_triangles, select_ms);
+            Logger::WriteMessage(report);
+        }
+
+    private:
+        static float_buffer makeHeights(unsigned rows, unsigned cols)
+        {
+            float_buffer heights(static_cast<size_t>(rows + 1) * (cols + 1));
+            for (unsigned z = 0; z <= rows; z++)
+            {
+                for (unsigned x = 0; x <= cols; x++)
+                {
+                    heights[static_cast<size_t>(z) * (cols + 1) + x] = 8.0f * std::sin(x * 0.05f) * std::cos(z * 0.03f);
+                }
+            }
+            return heights;
+        }
+
+        static Matrix4 viewProjection(const Vector3& eye, const Vector3& at)
+        {
+            const Matrix4 view = MathAlgorithm::MakeLookAtTransformLH(eye, at, Vector3{ 0.0f, 1.0f, 0.0f });
+            const Matrix4 projection = MathAlgorithm::MakePerspectiveProjectionFovLH(Radian{ FOV_Y }, 16.0f / 9.0f, 0.5f, 2000.0f);
+            return projection * view;
+        }
+    };
+}
@@ -0,0 +1,165 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "Terrain/TerrainGeometry.h"
+#include "Terrain/TerrainGeometryAssembler.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "MathLib/Vector3.h"
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Terrain;
+using namespace Enigma::MathLib;
+
+namespace SceneGraphTest
+{
+    TEST_CLASS(TerrainGeometryTest)
+    {
+    public:
+        TEST_METHOD(TestSimdNormalsMatchScalarRangedUpdate)
+        {
+            // 列數不是 SIMD 寬度的倍數, 尾端要走 scalar
+            constexpr unsigned rows = 13;
+            constexpr unsigned cols = 19;
+            const auto heights = makeHeights(rows, cols, 3);
+            auto simd_terrain = makeTerrain("simd_terrain", rows, cols, heights);
+            auto scalar_terrain = makeTerrain("scalar_terrain", rows, cols, heights);
+            auto parallel_terrain = makeTerrain("parallel_terrain", rows, cols, heights);
+
+            simd_terrain->updateVertexNormals();
+            // 一次一個頂點, 更新範圍只有三個頂點寬, 不會進 SIMD kernel
+            const unsigned vtx_count = (rows + 1) * (cols + 1);
+            for (unsigned vi = 0; vi < vtx_count; vi++)
+            {
+                scalar_terrain->rangedUpdateVertexNormals(vi, 1);
+            }
+            parallel_terrain->updateVertexNormals(std::make_shared<Enigma::Frameworks::WorkerThreadPool>(3));
+
+            unsigned tilted_count = 0;
+            for (unsigned vi = 0; vi < vtx_count; vi++)
+            {
+                const Vector3 simd_normal = simd_terrain->getVertexNormal(vi);
+                const Vector3 scalar_normal = scalar_terrain->getVertexNormal(vi);
+                const auto [ix, iz] = simd_terrain->revertVertexIndex(vi);
+                assertNormalNear(scalar_normal, simd_normal);
+                assertNormalNear(referenceNormal(*simd_terrain, ix, iz), simd_normal);
+                const Vector3 parallel_normal = parallel_terrain->getVertexNormal(vi);
+                Assert::IsTrue(parallel_normal == simd_normal);
+                if (simd_normal.y() < 0.99f) tilted_count++;
+            }
+            // 高度有起伏, 不是全部朝上
+            Assert::IsTrue(tilted_count > vtx_count / 2);
+        }
+
+        TEST_METHOD(TestDirtyRectUpdatesRectAndBorderOnly)
+        {
+            constexpr unsigned rows = 16;
+            constexpr unsigned cols = 16;
+            const Vector3 sentinel(0.0f, -1.0f, 0.0f);
+            const std::vector<TerrainGeometry::VertexRect> rects{ { 5, 4, 8, 6 }, { 0, 0, 1, 1 }, { 14, 15, 16, 16 }, { 9, 9, 9, 9 } };
+            for (const auto& rect : rects)
+            {
+                const auto heights = makeHeights(rows, cols, 7);
+                auto terrain = makeTerrain("dirty_rect_terrain", rows, cols, heights);
+                terrain->updateVertexNormals();
+                const unsigned vtx_count = (rows + 1) * (cols + 1);
+                for (unsigned vi = 0; vi < vtx_count; vi++)
+                {
+                    terrain->setVertexNormal(vi, sentinel);
+                }
+                // rect 內外都改高度, 只有 rect 內的寫入頂點
+                for (unsigned iz = 0; iz <= rows; iz++)
+                {
+                    for (unsigned ix = 0; ix <= cols; ix++)
+                    {
+                        terrain->changeHeight(ix, iz, terrain->getHeight(ix, iz) + 0.25f * static_cast<float>((ix * 3 + iz) % 5));
+                    }
+                }
+                terrain->rectUpdateHeightMapToVertexMemory(rect);
+                const auto affected = terrain->rectUpdateVertexNormals(rect);
+                Assert::AreEqual(rect.m_minX > 0 ? rect.m_minX - 1 : 0u, affected.m_minX);
+                Assert::AreEqual(rect.m_minZ > 0 ? rect.m_minZ - 1 : 0u, affected.m_minZ);
+                Assert::AreEqual(std::min(rect.m_maxX + 1, cols), affected.m_maxX);
+                Assert::AreEqual(std::min(rect.m_maxZ + 1, rows), affected.m_maxZ);
+
+                for (unsigned vi = 0; vi < vtx_count; vi++)
+                {
+                    const auto [ix, iz] = terrain->revertVertexIndex(vi);
+                    const bool in_rect = (ix >= rect.m_minX) && (ix <= rect.m_maxX) && (iz >= rect.m_minZ) && (iz <= rect.m_maxZ);
+                    const bool in_affected = (ix >= affected.m_minX) && (ix <= affected.m_maxX) && (iz >= affected.m_minZ) && (iz <= affected.m_maxZ);
+                    const float expected_y = in_rect ? terrain->getHeight(ix, iz) : heights[vi];
+                    Assert::AreEqual(expected_y, terrain->getPosition3(vi).y());
+                    if (in_affected)
+                    {
+                        assertNormalNear(referenceNormal(*terrain, ix, iz), terrain->getVertexNormal(vi));
+                    }
+                    else
+                    {
+                        Assert::IsTrue(terrain->getVertexNormal(vi) == sentinel);
+                    }
+                }
+            }
+        }
+
+    private:
+        /** 平滑起伏加一點高頻, 相鄰頂點的高度差不為 0 */
+        static std::vector<float> makeHeights(unsigned rows, unsigned cols, unsigned seed)
+        {
+            std::vector<float> heights((rows + 1) * (cols + 1));
+            for (unsigned iz = 0; iz <= rows; iz++)
+            {
+                for (unsigned ix = 0; ix <= cols; ix++)
+                {
+                    heights[iz * (cols + 1) + ix] = 2.0f * std::sin(0.7f * static_cast<float>(ix + seed)) * std::cos(0.45f * static_cast<float>(iz))
+                        + 0.1f * static_cast<float>((ix * 7 + iz * 13 + seed) % 11);
+                }
+            }
+            return heights;
+        }
+
+        static std::shared_ptr<TerrainGeometry> makeTerrain(const std::string& name, unsigned rows, unsigned cols, const std::vector<float>& heights)
+        {
+            TerrainGeometryAssembler assembler{ Enigma::Geometries::GeometryId(name) };
+            assembler.numRows(rows);
+            assembler.numCols(cols);
+            assembler.minPosition(Vector3(-10.0f, 0.0f, -6.0f));
+            assembler.maxPosition(Vector3(28.0f, 0.0f, 20.0f));
+            assembler.minTextureCoordinate(Vector2(0.0f, 0.0f));
+            assembler.maxTextureCoordinate(Vector2(1.0f, 1.0f));
+            assembler.heightMap(heights);
+            auto disassembler = std::make_shared<TerrainGeometryDisassembler>();
+            disassembler->disassemble(assembler.assemble());
+            auto terrain = TerrainGeometry::create(Enigma::Geometries::GeometryId(name));
+            terrain->disassemble(disassembler);
+            return terrain;
+        }
+
+        /** 原本 scalar 版本的算法 : 六個鄰邊正規化後兩兩外積加總 */
+        static Vector3 referenceNormal(const TerrainGeometry& terrain, unsigned ix, unsigned iz)
+        {
+            const unsigned cols = terrain.getNumCols();
+            const unsigned rows = terrain.getNumRows();
+            const auto dimension = terrain.getCellDimension();
+            const float h0 = terrain.getHeight(ix, iz);
+            auto height_diff = [&](bool exists, unsigned x, unsigned z) { return exists ? terrain.getHeight(x, z) - h0 : 0.0f; };
+            const Vector3 e1 = Vector3(dimension.m_width, height_diff(ix < cols, ix + 1, iz), 0.0f).normalize();
+            const Vector3 e2 = Vector3(0.0f, height_diff(iz > 0, ix, iz - 1), -dimension.m_height).normalize();
+            const Vector3 e3 = Vector3(-dimension.m_width, height_diff(ix > 0, ix - 1, iz), 0.0f).normalize();
+            const Vector3 e4 = Vector3(0.0f, height_diff(iz < rows, ix, iz + 1), dimension.m_height).normalize();
+            const Vector3 e5 = Vector3(dimension.m_width, height_diff((iz < rows) && (ix < cols), ix + 1, iz + 1), dimension.m_height).normalize();
+            const Vector3 e6 = Vector3(-dimension.m_width, height_diff((iz > 0) && (ix > 0), ix - 1, iz - 1), -dimension.m_height).normalize();
+            Vector3 normal = e1.cross(e2) + e2.cross(e6) + e6.cross(e3) + e3.cross(e4) + e4.cross(e5) + e5.cross(e1);
+            normal.normalizeSelf();
+            return normal;
+        }
+
+        static void assertNormalNear(const Vector3& expected, const Vector3& actual)
+        {
+            constexpr float tolerance = 1e-5f;
+            Assert::AreEqual(expected.x(), actual.x(), tolerance);
+            Assert::AreEqual(expected.y(), actual.y(), tolerance);
+            Assert::AreEqual(expected.z(), actual.z(), tolerance);
+        }
+    };
+}
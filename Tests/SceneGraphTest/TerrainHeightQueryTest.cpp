@@ -0,0 +1,361 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "Terrain/TerrainGeometry.h"
+#include "Terrain/TerrainGeometryAssembler.h"
+#include "Terrain/TerrainPrimitive.h"
+#include "Terrain/TerrainPrimitiveRay3IntersectionFinder.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "MathLib/Matrix4.h"
+#include "MathLib/Ray3.h"
+#include "MathLib/Vector3.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Terrain;
+using namespace Enigma::MathLib;
+
+namespace SceneGraphTest
+{
+    TEST_CLASS(TerrainHeightQueryTest)
+    {
+    public:
+        TEST_METHOD(TestPyramidRayMatchesBruteForce)
+        {
+            // 行列數不同且不是 2 的次方, pyramid 每層都有不完整的 node
+            constexpr unsigned rows = 21;
+            constexpr unsigned cols = 27;
+            auto terrain = makeTerrain("pyramid_terrain", rows, cols, makeHeights(rows, cols));
+            unsigned seed = 12345;
+            unsigned hit_count = 0;
+            for (unsigned i = 0; i < 600; i++)
+            {
+                const auto [origin, direction] = randomRay(seed, i);
+                const auto expected = bruteForceRay(meshTriangles(*terrain, Matrix4::IDENTITY), origin, direction);
+                const auto actual = terrain->intersectRay(origin, direction);
+                assertSameHit(expected, actual);
+                if (expected) hit_count++;
+            }
+            // 有打中也有打不中
+            Assert::IsTrue(hit_count > 200);
+            Assert::IsTrue(hit_count < 600);
+
+            // max_t 之外的交點不算
+            const Vector3 origin(0.0f, 20.0f, 0.0f);
+            const Vector3 direction(0.1f, -1.0f, 0.05f);
+            const auto hit = terrain->intersectRay(origin, direction);
+            Assert::IsTrue(hit.has_value());
+            Assert::IsFalse(terrain->intersectRay(origin, direction, hit.value() * 0.9f).has_value());
+            Assert::IsTrue(terrain->intersectRay(origin, direction, hit.value() * 1.01f).has_value());
+        }
+
+        TEST_METHOD(TestPyramidFollowsRectUpdate)
+        {
+            constexpr unsigned rows = 16;
+            constexpr unsigned cols = 16;
+            auto terrain = makeTerrain("pyramid_update_terrain", rows, cols, makeHeights(rows, cols));
+            // 貼著地面水平射過去, 原本的地形擋不到
+            const Vector3 origin(-20.0f, 6.0f, 9.5f);
+            const Vector3 direction(1.0f, 0.0f, 0.0f);
+            Assert::IsFalse(terrain->intersectRay(origin, direction).has_value());
+
+            const TerrainGeometry::VertexRect rect{ 9, 9, 11, 10 };
+            for (unsigned iz = rect.m_minZ; iz <= rect.m_maxZ; iz++)
+            {
+                for (unsigned ix = rect.m_minX; ix <= rect.m_maxX; ix++)
+                {
+                    terrain->changeHeight(ix, iz, 12.0f);
+                }
+            }
+            terrain->rectUpdateHeightMapToVertexMemory(rect);
+            const auto expected = bruteForceRay(meshTriangles(*terrain, Matrix4::IDENTITY), origin, direction);
+            Assert::IsTrue(expected.has_value());
+            assertSameHit(expected, terrain->intersectRay(origin, direction));
+
+            unsigned seed = 777;
+            for (unsigned i = 0; i < 200; i++)
+            {
+                const auto [ray_origin, ray_direction] = randomRay(seed, i);
+                assertSameHit(bruteForceRay(meshTriangles(*terrain, Matrix4::IDENTITY), ray_origin, ray_direction),
+                    terrain->intersectRay(ray_origin, ray_direction));
+            }
+        }
+
+        TEST_METHOD(TestFinderUsesPrimitiveWorldTransform)
+        {
+            constexpr unsigned rows = 12;
+            constexpr unsigned cols = 10;
+            auto terrain = makeTerrain("finder_terrain", rows, cols, makeHeights(rows, cols));
+            auto primitive = TerrainPrimitive::create(Enigma::Primitives::PrimitiveId("finder_terrain", TerrainPrimitive::TYPE_RTTI));
+            primitive->linkGeometryData(terrain, nullptr);
+            const Matrix4 world = Matrix4::MakeTranslateTransform(50.0f, -3.0f, 12.0f) * Matrix4::MakeScaleTransform(2.0f, 1.5f, 2.0f);
+            primitive->updateWorldTransform(world);
+            const auto triangles = meshTriangles(*terrain, world);
+            std::unique_ptr<Enigma::Primitives::PrimitiveRay3IntersectionFinder> finder(TerrainPrimitiveRay3IntersectionFinder::create());
+
+            unsigned seed = 4242;
+            unsigned hit_count = 0;
+            for (unsigned i = 0; i < 200; i++)
+            {
+                auto [local_origin, local_direction] = randomRay(seed, i);
+                // world ray 的 direction 是單位向量, t 是 world 距離
+                const Ray3 ray(world.TransformCoord(local_origin), world.TransformVector(local_direction).normalize());
+                const auto expected = bruteForceRay(triangles, ray.origin(), ray.direction());
+                auto [records, result] = finder->find(primitive, ray, nullptr);
+                Assert::AreEqual(expected.has_value(), result.m_hasIntersect);
+                Assert::AreEqual(expected.has_value(), finder->test(primitive, ray, nullptr).m_hasIntersect);
+                if (!expected)
+                {
+                    Assert::IsTrue(records.empty());
+                    continue;
+                }
+                hit_count++;
+                Assert::AreEqual(static_cast<size_t>(1), records.size());
+                const float tolerance = 1e-3f * std::max(1.0f, expected.value());
+                Assert::AreEqual(expected.value(), records[0].m_tParam, tolerance);
+                const Vector3 point = ray.origin() + ray.direction() * expected.value();
+                Assert::AreEqual(point.x(), records[0].m_vecPoint.x(), tolerance);
+                Assert::AreEqual(point.y(), records[0].m_vecPoint.y(), tolerance);
+                Assert::AreEqual(point.z(), records[0].m_vecPoint.z(), tolerance);
+                Assert::IsTrue(records[0].m_primitive.lock() == primitive);
+            }
+            Assert::IsTrue(hit_count > 50);
+        }
+
+        TEST_METHOD(TestHeightAtIsBilinear)
+        {
+            constexpr unsigned rows = 9;
+            constexpr unsigned cols = 14;
+            const Vector3 min_pos = minPosition();
+            const Vector3 max_pos = maxPosition();
+            const float cell_w = (max_pos.x() - min_pos.x()) / static_cast<float>(cols);
+            const float cell_h = (max_pos.z() - min_pos.z()) / static_cast<float>(rows);
+            // 平面上 bilinear 內插是精確的
+            auto plane = [](float x, float z) { return 0.3f * x - 0.2f * z + 1.0f; };
+            std::vector<float> plane_heights((rows + 1) * (cols + 1));
+            for (unsigned iz = 0; iz <= rows; iz++)
+            {
+                for (unsigned ix = 0; ix <= cols; ix++)
+                {
+                    plane_heights[iz * (cols + 1) + ix] = plane(min_pos.x() + static_cast<float>(ix) * cell_w, min_pos.z() + static_cast<float>(iz) * cell_h);
+                }
+            }
+            auto plane_terrain = makeTerrain("plane_terrain", rows, cols, plane_heights);
+            unsigned seed = 99;
+            for (unsigned i = 0; i < 500; i++)
+            {
+                const float x = min_pos.x() + (max_pos.x() - min_pos.x()) * nextUnit(seed);
+                const float z = min_pos.z() + (max_pos.z() - min_pos.z()) * nextUnit(seed);
+                Assert::AreEqual(plane(x, z), plane_terrain->heightAt(x, z), 1e-4f);
+            }
+
+            auto terrain = makeTerrain("bilinear_terrain", rows, cols, makeHeights(rows, cols));
+            for (unsigned iz = 0; iz <= rows; iz++)
+            {
+                for (unsigned ix = 0; ix <= cols; ix++)
+                {
+                    const float x = min_pos.x() + static_cast<float>(ix) * cell_w;
+                    const float z = min_pos.z() + static_cast<float>(iz) * cell_h;
+                    Assert::AreEqual(terrain->getHeight(ix, iz), terrain->heightAt(x, z), 1e-4f);
+                    if ((ix == cols) || (iz == rows)) continue;
+                    // 格子中心是四角平均, 邊的中點是兩端平均
+                    const float center = 0.25f * (terrain->getHeight(ix, iz) + terrain->getHeight(ix + 1, iz)
+                        + terrain->getHeight(ix, iz + 1) + terrain->getHeight(ix + 1, iz + 1));
+                    Assert::AreEqual(center, terrain->heightAt(x + 0.5f * cell_w, z + 0.5f * cell_h), 1e-4f);
+                    const float edge = 0.5f * (terrain->getHeight(ix, iz) + terrain->getHeight(ix + 1, iz));
+                    Assert::AreEqual(edge, terrain->heightAt(x + 0.5f * cell_w, z), 1e-4f);
+                    // 1/4 處的權重是 3 : 1
+                    const float quarter = 0.75f * terrain->getHeight(ix, iz + 1) + 0.25f * terrain->getHeight(ix + 1, iz + 1);
+                    Assert::AreEqual(quarter, terrain->heightAt(x + 0.25f * cell_w, z + cell_h), 1e-4f);
+                }
+            }
+            // 範圍外夾到邊上
+            Assert::AreEqual(terrain->getHeight(0, 0), terrain->heightAt(min_pos.x() - 100.0f, min_pos.z() - 100.0f), 1e-4f);
+            Assert::AreEqual(terrain->getHeight(cols, rows), terrain->heightAt(max_pos.x() + 100.0f, max_pos.z() + 100.0f), 1e-4f);
+            Assert::AreEqual(terrain->heightAt(min_pos.x(), min_pos.z() + 2.5f * cell_h), terrain->heightAt(min_pos.x() - 3.0f, min_pos.z() + 2.5f * cell_h), 1e-4f);
+        }
+
+        TEST_METHOD(TestHeightsAtBatchMatchesSingleQueries)
+        {
+            constexpr unsigned rows = 32;
+            constexpr unsigned cols = 24;
+            auto terrain = makeTerrain("batch_terrain", rows, cols, makeHeights(rows, cols));
+            const Vector3 min_pos = minPosition();
+            const Vector3 max_pos = maxPosition();
+            unsigned seed = 2024;
+            // 超過平行門檻, 也包含範圍外的點
+            std::vector<Vector3> positions(3000);
+            for (auto& position : positions)
+            {
+                position = Vector3(min_pos.x() - 4.0f + (max_pos.x() - min_pos.x() + 8.0f) * nextUnit(seed), 100.0f,
+                    min_pos.z() - 4.0f + (max_pos.z() - min_pos.z() + 8.0f) * nextUnit(seed));
+            }
+            float_buffer serial_heights;
+            terrain->heightsAt(positions, serial_heights);
+            float_buffer parallel_heights{ 1.0f, 2.0f };
+            terrain->heightsAt(positions, parallel_heights, std::make_shared<Enigma::Frameworks::WorkerThreadPool>(4));
+            Assert::AreEqual(positions.size(), serial_heights.size());
+            Assert::AreEqual(positions.size(), parallel_heights.size());
+            for (size_t i = 0; i < positions.size(); i++)
+            {
+                const float expected = terrain->heightAt(positions[i].x(), positions[i].z());
+                Assert::AreEqual(expected, serial_heights[i]);
+                Assert::AreEqual(expected, parallel_heights[i]);
+            }
+
+            float_buffer empty_heights{ 3.0f };
+            terrain->heightsAt({}, empty_heights);
+            Assert::IsTrue(empty_heights.empty());
+        }
+
+        TEST_METHOD(TestVertexPlacementMatchesCellDimension)
+        {
+            // 頂點放在 min + index * cell, 最後一個頂點在 max; locateCell 找回同一個頂點格位
+            const std::vector<std::tuple<unsigned, unsigned>> sizes{ { 1, 1 }, { 8, 8 }, { 7, 13 }, { 16, 5 } };
+            for (const auto& [rows, cols] : sizes)
+            {
+                auto terrain = makeTerrain("placement_terrain", rows, cols, makeHeights(rows, cols));
+                const Vector3 min_pos = minPosition();
+                const Vector3 max_pos = maxPosition();
+                const auto dimension = terrain->getCellDimension();
+                Assert::AreEqual(max_pos.x() - min_pos.x(), dimension.m_width * static_cast<float>(cols), 1e-4f);
+                Assert::AreEqual(max_pos.z() - min_pos.z(), dimension.m_height * static_cast<float>(rows), 1e-4f);
+                for (unsigned iz = 0; iz <= rows; iz++)
+                {
+                    for (unsigned ix = 0; ix <= cols; ix++)
+                    {
+                        const unsigned vi = terrain->convertVertexIndex(ix, iz);
+                        const Vector3 position = terrain->getPosition3(vi);
+                        Assert::AreEqual(min_pos.x() + static_cast<float>(ix) * dimension.m_width, position.x(), 1e-4f);
+                        Assert::AreEqual(min_pos.z() + static_cast<float>(iz) * dimension.m_height, position.z(), 1e-4f);
+                        Assert::AreEqual(terrain->getHeight(ix, iz), position.y());
+                        Assert::IsTrue(terrain->locateCell(position) == std::make_tuple(ix, iz));
+                        // 偏離不到半格, 還是同一個格位
+                        const Vector3 nudged(position.x() + 0.4f * dimension.m_width, position.y(), position.z() - 0.4f * dimension.m_height);
+                        Assert::IsTrue(terrain->locateCell(nudged) == std::make_tuple(ix, iz));
+                    }
+                }
+                const Vector3 last = terrain->getPosition3(terrain->convertVertexIndex(cols, rows));
+                Assert::AreEqual(max_pos.x(), last.x(), 1e-4f);
+                Assert::AreEqual(max_pos.z(), last.z(), 1e-4f);
+            }
+        }
+
+    private:
+        struct Triangle
+        {
+            Vector3 m_v0;
+            Vector3 m_v1;
+            Vector3 m_v2;
+        };
+
+        static Vector3 minPosition() { return Vector3(-10.0f, 0.0f, -6.0f); }
+        static Vector3 maxPosition() { return Vector3(28.0f, 0.0f, 20.0f); }
+
+        static std::vector<float> makeHeights(unsigned rows, unsigned cols)
+        {
+            std::vector<float> heights((rows + 1) * (cols + 1));
+            for (unsigned iz = 0; iz <= rows; iz++)
+            {
+                for (unsigned ix = 0; ix <= cols; ix++)
+                {
+                    heights[iz * (cols + 1) + ix] = 3.0f * std::sin(0.6f * static_cast<float>(ix)) * std::cos(0.5f * static_cast<float>(iz))
+                        + 0.2f * static_cast<float>((ix * 5 + iz * 11) % 7);
+                }
+            }
+            return heights;
+        }
+
+        static std::shared_ptr<TerrainGeometry> makeTerrain(const std::string& name, unsigned rows, unsigned cols, const std::vector<float>& heights)
+        {
+            TerrainGeometryAssembler assembler{ Enigma::Geometries::GeometryId(name) };
+            assembler.numRows(rows);
+            assembler.numCols(cols);
+            assembler.minPosition(minPosition());
+            assembler.maxPosition(maxPosition());
+            assembler.minTextureCoordinate(Vector2(0.0f, 0.0f));
+            assembler.maxTextureCoordinate(Vector2(1.0f, 1.0f));
+            assembler.heightMap(heights);
+            auto disassembler = std::make_shared<TerrainGeometryDisassembler>();
+            disassembler->disassemble(assembler.assemble());
+            auto terrain = TerrainGeometry::create(Enigma::Geometries::GeometryId(name));
+            terrain->disassemble(disassembler);
+            return terrain;
+        }
+
+        static float nextUnit(unsigned& seed)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        }
+
+        /** 由上往下打, 部分斜射到範圍外, 部分幾乎水平, 部分往上; direction 不是單位向量 */
+        static std::tuple<Vector3, Vector3> randomRay(unsigned& seed, unsigned i)
+        {
+            const Vector3 min_pos = minPosition();
+            const Vector3 max_pos = maxPosition();
+            const float span_x = max_pos.x() - min_pos.x();
+            const float span_z = max_pos.z() - min_pos.z();
+            const Vector3 origin(min_pos.x() - 8.0f + (span_x + 16.0f) * nextUnit(seed), 2.0f + 10.0f * nextUnit(seed),
+                min_pos.z() - 8.0f + (span_z + 16.0f) * nextUnit(seed));
+            if (i % 7 == 0) return { origin, Vector3(nextUnit(seed) - 0.5f, 0.2f + nextUnit(seed), nextUnit(seed) - 0.5f) };
+            if (i % 5 == 0) return { origin, Vector3(2.0f * nextUnit(seed) - 1.0f, -0.05f * nextUnit(seed), 2.0f * nextUnit(seed) - 1.0f) };
+            const Vector3 target(min_pos.x() - 4.0f + (span_x + 8.0f) * nextUnit(seed), -4.0f + 8.0f * nextUnit(seed),
+                min_pos.z() - 4.0f + (span_z + 8.0f) * nextUnit(seed));
+            return { origin, (target - origin) * (0.5f + nextUnit(seed)) };
+        }
+
+        /** 直接讀 vertex memory 的格子三角形, 對角線與 disassembler 的 index 一致 */
+        static std::vector<Triangle> meshTriangles(TerrainGeometry& terrain, const Matrix4& world)
+        {
+            std::vector<Triangle> triangles;
+            for (unsigned iz = 0; iz < terrain.getNumRows(); iz++)
+            {
+                for (unsigned ix = 0; ix < terrain.getNumCols(); ix++)
+                {
+                    const Vector3 v00 = world.TransformCoord(terrain.getPosition3(terrain.convertVertexIndex(ix, iz)));
+                    const Vector3 v01 = world.TransformCoord(terrain.getPosition3(terrain.convertVertexIndex(ix, iz + 1)));
+                    const Vector3 v11 = world.TransformCoord(terrain.getPosition3(terrain.convertVertexIndex(ix + 1, iz + 1)));
+                    const Vector3 v10 = world.TransformCoord(terrain.getPosition3(terrain.convertVertexIndex(ix + 1, iz)));
+                    triangles.push_back({ v00, v01, v11 });
+                    triangles.push_back({ v00, v11, v10 });
+                }
+            }
+            return triangles;
+        }
+
+        static std::optional<float> bruteForceRay(const std::vector<Triangle>& triangles, const Vector3& origin, const Vector3& direction)
+        {
+            std::optional<float> nearest;
+            for (const auto& tri : triangles)
+            {
+                const Vector3 edge1 = tri.m_v1 - tri.m_v0;
+                const Vector3 edge2 = tri.m_v2 - tri.m_v0;
+                const Vector3 p = direction.cross(edge2);
+                const float det = edge1.dot(p);
+                if (std::fabs(det) < 1e-12f) continue;
+                const Vector3 s = origin - tri.m_v0;
+                const float u = s.dot(p) / det;
+                if ((u < 0.0f) || (u > 1.0f)) continue;
+                const Vector3 q = s.cross(edge1);
+                const float v = direction.dot(q) / det;
+                if ((v < 0.0f) || (u + v > 1.0f)) continue;
+                const float t = edge2.dot(q) / det;
+                if (t < 0.0f) continue;
+                if ((!nearest) || (t < nearest.value())) nearest = t;
+            }
+            return nearest;
+        }
+
+        static void assertSameHit(const std::optional<float>& expected, const std::optional<float>& actual)
+        {
+            Assert::AreEqual(expected.has_value(), actual.has_value());
+            if (!expected) return;
+            Assert::AreEqual(expected.value(), actual.value(), 1e-3f * std::max(1.0f, expected.value()));
+        }
+    };
+}
@@ -0,0 +1,396 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "GraphicKernel/TextureContainer.h"
+#include "GraphicKernel/GraphicErrors.h"
+#include "GameEngine/TextureMipChain.h"
+#include "../../Toolset/TextureConverter/TextureConverter/TextureBlockEncoder.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Graphics;
+using namespace Enigma::MathLib;
+
+namespace SceneGraphTest
+{
+    TEST_CLASS(TextureContainerTest)
+    {
+    public:
+        TEST_METHOD(TestWriteAndReadContainer)
+        {
+            const Dimension<unsigned> dimension{ 13, 7 };
+            const std::vector<TextureContainer::PayloadSource> sources{ makeSource(GraphicFormat::FMT_DXT1, dimension, 3, 1),
+                makeSource(GraphicFormat::FMT_A8B8G8R8, dimension, 3, 2) };
+            const byte_buffer buff = TextureContainer::serialize(dimension, true, sources);
+            Assert::IsFalse(buff.empty());
+            Assert::IsTrue(TextureContainer::isContainerContent(buff.data(), buff.size()));
+
+            // header 不用 parse payload 就讀得到
+            const auto header_only = TextureContainer::readHeader(buff.data(), buff.size());
+            Assert::IsTrue(header_only.has_value());
+            Assert::AreEqual(13u, header_only->m_dimension.m_width);
+            Assert::AreEqual(7u, header_only->m_dimension.m_height);
+            Assert::AreEqual(3u, header_only->m_mipCount);
+            Assert::AreEqual(2u, header_only->m_payloadCount);
+            Assert::IsTrue(header_only->m_hasAlpha);
+
+            TextureContainer::Header header;
+            std::vector<TextureContainer::PayloadView> payloads;
+            Assert::IsTrue(TextureContainer::parse(buff.data(), buff.size(), header, payloads) == ErrorCode::ok);
+            Assert::AreEqual(sources.size(), payloads.size());
+            for (size_t i = 0; i < payloads.size(); i++)
+            {
+                Assert::AreEqual(sources[i].m_format.fmt, payloads[i].m_format.fmt);
+                Assert::AreEqual(sources[i].m_levels.size(), payloads[i].m_levels.size());
+                for (size_t lv = 0; lv < payloads[i].m_levels.size(); lv++)
+                {
+                    const auto& level = payloads[i].m_levels[lv];
+                    // view 指到 container buffer 裡面, 16 bytes 對齊, 內容跟來源一樣
+                    Assert::IsTrue((level.m_data >= buff.data()) && (level.m_data + level.m_size <= buff.data() + buff.size()));
+                    Assert::AreEqual(static_cast<std::ptrdiff_t>(0), (level.m_data - buff.data()) % 16);
+                    Assert::AreEqual(sources[i].m_levels[lv].size(), level.m_size);
+                    Assert::AreEqual(0, memcmp(sources[i].m_levels[lv].data(), level.m_data, level.m_size));
+                }
+            }
+
+            // 沒有 alpha 的 flag
+            const byte_buffer opaque = TextureContainer::serialize(dimension, false, sources);
+            Assert::IsFalse(TextureContainer::readHeader(opaque.data(), opaque.size())->m_hasAlpha);
+        }
+
+        TEST_METHOD(TestMipChainLayout)
+        {
+            // 非 2 的次方, 寬高不同, 最後幾層只剩一邊在縮
+            const Dimension<unsigned> dimension{ 37, 10 };
+            byte_buffer pixels(static_cast<size_t>(dimension.m_width) * dimension.m_height * 4);
+            for (size_t i = 0; i < pixels.size(); i++)
+            {
+                pixels[i] = static_cast<unsigned char>((i * 37 + i / 5) & 0xff);
+            }
+            const Enigma::Engine::TextureMipChain chain(dimension, std::move(pixels));
+            Assert::AreEqual(6u, chain.levelCount());
+            // 跟 TextureConverter 一樣的組法: 每個 level 壓成 DXT1, 再加 raw fallback
+            std::vector<TextureContainer::PayloadSource> sources{ { GraphicFormat::FMT_DXT1, {} }, { GraphicFormat::FMT_A8B8G8R8, {} } };
+            for (unsigned lv = 0; lv < chain.levelCount(); lv++)
+            {
+                const auto& level = chain.level(lv);
+                sources[0].m_levels.emplace_back(TextureBlockEncoder::encode(GraphicFormat::FMT_DXT1, level.m_dimension, level.m_pixels));
+                sources[1].m_levels.emplace_back(level.m_pixels);
+            }
+            const byte_buffer buff = TextureContainer::serialize(dimension, false, sources);
+            TextureContainer::Header header;
+            std::vector<TextureContainer::PayloadView> payloads;
+            Assert::IsTrue(TextureContainer::parse(buff.data(), buff.size(), header, payloads) == ErrorCode::ok);
+            Assert::AreEqual(chain.levelCount(), header.m_mipCount);
+
+            const std::array<Dimension<unsigned>, 6> expected_dimensions{ { { 37, 10 }, { 18, 5 }, { 9, 2 }, { 4, 1 }, { 2, 1 }, { 1, 1 } } };
+            const unsigned char* previous_end = buff.data();
+            for (unsigned lv = 0; lv < header.m_mipCount; lv++)
+            {
+                const Dimension<unsigned> expected = expected_dimensions[lv];
+                Assert::IsTrue(TextureContainer::levelDimension(dimension, lv) == expected);
+                Assert::IsTrue(Enigma::Engine::TextureMipChain::levelDimension(dimension, lv) == expected);
+                Assert::IsTrue(chain.level(lv).m_dimension == expected);
+
+                // block 格式不足 4 的邊補成一個 block
+                const auto& bc_level = payloads[0].m_levels[lv];
+                const unsigned blocks_x = (expected.m_width + 3) / 4;
+                const unsigned blocks_y = (expected.m_height + 3) / 4;
+                Assert::IsTrue(bc_level.m_dimension == expected);
+                Assert::AreEqual(blocks_x * 8, bc_level.m_rowPitch);
+                Assert::AreEqual(static_cast<size_t>(blocks_x) * blocks_y * 8, bc_level.m_size);
+
+                const auto& raw_level = payloads[1].m_levels[lv];
+                Assert::IsTrue(raw_level.m_dimension == expected);
+                Assert::AreEqual(expected.m_width * 4, raw_level.m_rowPitch);
+                Assert::AreEqual(static_cast<size_t>(expected.m_width) * expected.m_height * 4, raw_level.m_size);
+                Assert::AreEqual(0, memcmp(chain.level(lv).m_pixels.data(), raw_level.m_data, raw_level.m_size));
+
+                // 同一個 payload 的 level 由大到小依序排列, 不重疊
+                Assert::IsTrue(bc_level.m_data >= previous_end);
+                previous_end = bc_level.m_data + bc_level.m_size;
+            }
+            Assert::IsTrue(payloads[1].m_levels[0].m_data >= previous_end);
+        }
+
+        TEST_METHOD(TestSelectPayloadAndRejectBrokenContainers)
+        {
+            const Dimension<unsigned> dimension{ 8, 8 };
+            const std::vector<TextureContainer::PayloadSource> sources{ makeSource(GraphicFormat::FMT_DXT5, dimension, 4, 1),
+                makeSource(GraphicFormat::FMT_ETC2_RGBA8, dimension, 4, 2), makeSource(GraphicFormat::FMT_A8B8G8R8, dimension, 4, 3) };
+            const byte_buffer buff = TextureContainer::serialize(dimension, true, sources);
+            TextureContainer::Header header;
+            std::vector<TextureContainer::PayloadView> payloads;
+            Assert::IsTrue(TextureContainer::parse(buff.data(), buff.size(), header, payloads) == ErrorCode::ok);
+
+            // 依 device 支援的順序挑, 都不支援時用 raw
+            const GraphicFormat etc2 = GraphicFormat::FMT_ETC2_RGBA8;
+            const GraphicFormat dxt5 = GraphicFormat::FMT_DXT5;
+            const GraphicFormat dxt1 = GraphicFormat::FMT_DXT1;
+            Assert::IsTrue(TextureContainer::selectPayload(payloads, { etc2, dxt5 }) == &payloads[1]);
+            Assert::IsTrue(TextureContainer::selectPayload(payloads, { dxt1, dxt5 }) == &payloads[0]);
+            Assert::IsTrue(TextureContainer::selectPayload(payloads, { dxt1 }) == &payloads[2]);
+            payloads.pop_back();
+            Assert::IsTrue(TextureContainer::selectPayload(payloads, { dxt1 }) == nullptr);
+
+            // 截斷, magic, version, level 大小不符都要拒絕
+            byte_buffer truncated(buff.begin(), buff.begin() + buff.size() / 2);
+            Assert::IsTrue(TextureContainer::parse(truncated.data(), truncated.size(), header, payloads) == ErrorCode::textureContainerFormat);
+            byte_buffer bad_magic = buff;
+            bad_magic[0] = 'X';
+            Assert::IsFalse(TextureContainer::isContainerContent(bad_magic.data(), bad_magic.size()));
+            Assert::IsTrue(TextureContainer::parse(bad_magic.data(), bad_magic.size(), header, payloads) == ErrorCode::textureContainerFormat);
+            byte_buffer bad_version = buff;
+            bad_version[4] = 2;
+            Assert::IsFalse(TextureContainer::readHeader(bad_version.data(), bad_version.size()).has_value());
+            byte_buffer bad_level = buff;
+            // 第一個 payload 的 level 0 大小欄位 : header 32 bytes, format 4 bytes, offset 4 bytes
+            std::uint32_t level_size;
+            memcpy(&level_size, &bad_level[32 + 8 + 4], sizeof(level_size));
+            level_size -= 8;
+            memcpy(&bad_level[32 + 8 + 4], &level_size, sizeof(level_size));
+            Assert::IsTrue(TextureContainer::parse(bad_level.data(), bad_level.size(), header, payloads) == ErrorCode::textureContainerFormat);
+
+            // 來源不一致時不產生 container
+            auto short_chain = sources;
+            short_chain[1].m_levels.pop_back();
+            Assert::IsTrue(TextureContainer::serialize(dimension, true, short_chain).empty());
+            auto wrong_size = sources;
+            wrong_size[0].m_levels[1].push_back(0);
+            Assert::IsTrue(TextureContainer::serialize(dimension, true, wrong_size).empty());
+            Assert::IsTrue(TextureContainer::serialize(dimension, true, {}).empty());
+        }
+
+        TEST_METHOD(TestBC1BlockEncoding)
+        {
+            // 單色 block : 565 可以精確表示的顏色要完全還原
+            unsigned char block[64];
+            fillBlock(block, [](unsigned, unsigned, unsigned char* px) { px[0] = 255; px[1] = 0; px[2] = 132; px[3] = 255; });
+            unsigned char bc1[8];
+            TextureBlockEncoder::encodeBC1Block(block, bc1);
+            unsigned char decoded[64];
+            decodeBC1(bc1, decoded);
+            for (unsigned i = 0; i < 16; i++)
+            {
+                Assert::AreEqual(255, static_cast<int>(decoded[i * 4]));
+                Assert::AreEqual(0, static_cast<int>(decoded[i * 4 + 1]));
+                Assert::AreEqual(132, static_cast<int>(decoded[i * 4 + 2]));
+            }
+
+            // 漸層 block, green 跟 red / blue 反向 : 一定是 4 色模式 (c0 > c1), 誤差在量化範圍內
+            fillBlock(block, [](unsigned x, unsigned y, unsigned char* px)
+                {
+                    const unsigned t = y * 4 + x;
+                    px[0] = static_cast<unsigned char>(40 + t * 12); px[1] = static_cast<unsigned char>(220 - t * 10); px[2] = static_cast<unsigned char>(30 + t * 6); px[3] = 255;
+                });
+            TextureBlockEncoder::encodeBC1Block(block, bc1);
+            Assert::IsTrue(readU16(bc1) > readU16(bc1 + 2));
+            decodeBC1(bc1, decoded);
+            // 4 色 palette 在這條漸層上的 rmse 約 12, 對角線選錯會超過 40
+            Assert::IsTrue(colorRmse(block, decoded) < 14.0);
+
+            // 兩色 block : 每個像素落在比較近的端點那一側
+            fillBlock(block, [](unsigned x, unsigned, unsigned char* px) { const unsigned char v = x < 2 ? 0 : 255; px[0] = px[1] = px[2] = v; px[3] = 255; });
+            TextureBlockEncoder::encodeBC1Block(block, bc1);
+            decodeBC1(bc1, decoded);
+            for (unsigned i = 0; i < 16; i++)
+            {
+                Assert::IsTrue(std::abs(static_cast<int>(decoded[i * 4]) - static_cast<int>(block[i * 4])) < 48);
+            }
+        }
+
+        TEST_METHOD(TestBC3BlockEncoding)
+        {
+            // alpha 取 8 階模式的 palette 值, 端點是 block 的最大/最小 alpha, 要完全還原
+            const std::array<unsigned char, 8> alphas{ 255, 0, 218, 182, 145, 109, 72, 36 };
+            unsigned char block[64];
+            fillBlock(block, [&alphas](unsigned x, unsigned y, unsigned char* px)
+                { px[0] = static_cast<unsigned char>(x * 60); px[1] = static_cast<unsigned char>(y * 60); px[2] = 90; px[3] = alphas[(x + y * 3) % 8]; });
+            unsigned char bc3[16];
+            TextureBlockEncoder::encodeBC3Block(block, bc3);
+            Assert::AreEqual(255, static_cast<int>(bc3[0]));
+            Assert::AreEqual(0, static_cast<int>(bc3[1]));
+            unsigned char decoded[64];
+            decodeBC3(bc3, decoded);
+            for (unsigned i = 0; i < 16; i++)
+            {
+                Assert::AreEqual(static_cast<int>(block[i * 4 + 3]), static_cast<int>(decoded[i * 4 + 3]));
+            }
+            // color 部分就是同一個 block 的 BC1 編碼
+            unsigned char bc1[8];
+            TextureBlockEncoder::encodeBC1Block(block, bc1);
+            Assert::AreEqual(0, memcmp(bc1, bc3 + 8, 8));
+
+            // 任意 alpha 誤差不超過半個 palette 間距
+            fillBlock(block, [](unsigned x, unsigned y, unsigned char* px) { px[0] = px[1] = px[2] = 128; px[3] = static_cast<unsigned char>(30 + x * 37 + y * 13); });
+            TextureBlockEncoder::encodeBC3Block(block, bc3);
+            decodeBC3(bc3, decoded);
+            const int step = (bc3[0] - bc3[1]) / 7 + 1;
+            for (unsigned i = 0; i < 16; i++)
+            {
+                Assert::IsTrue(std::abs(static_cast<int>(decoded[i * 4 + 3]) - static_cast<int>(block[i * 4 + 3])) <= step / 2 + 1);
+            }
+
+            // alpha 全部相同時所有 index 都是 0
+            fillBlock(block, [](unsigned, unsigned, unsigned char* px) { px[0] = px[1] = px[2] = 10; px[3] = 77; });
+            TextureBlockEncoder::encodeBC3Block(block, bc3);
+            decodeBC3(bc3, decoded);
+            for (unsigned i = 0; i < 16; i++)
+            {
+                Assert::AreEqual(77, static_cast<int>(decoded[i * 4 + 3]));
+            }
+        }
+
+        TEST_METHOD(TestImageEncodingPadsPartialBlocks)
+        {
+            const Dimension<unsigned> dimension{ 6, 5 };
+            byte_buffer pixels(static_cast<size_t>(dimension.m_width) * dimension.m_height * 4);
+            for (unsigned y = 0; y < dimension.m_height; y++)
+            {
+                for (unsigned x = 0; x < dimension.m_width; x++)
+                {
+                    unsigned char* px = &pixels[(y * dimension.m_width + x) * 4];
+                    px[0] = static_cast<unsigned char>(x * 40);
+                    px[1] = static_cast<unsigned char>(y * 50);
+                    px[2] = static_cast<unsigned char>((x + y) * 20);
+                    px[3] = static_cast<unsigned char>(255 - x * y * 8);
+                }
+            }
+            Assert::IsTrue(TextureBlockEncoder::hasAlpha(pixels));
+            const byte_buffer dxt5 = TextureBlockEncoder::encode(GraphicFormat::FMT_DXT5, dimension, pixels);
+            Assert::AreEqual(TextureContainer::levelBytes(GraphicFormat::FMT_DXT5, dimension), dxt5.size());
+            Assert::AreEqual(static_cast<size_t>(2 * 2 * 16), dxt5.size());
+
+            // 右下角的 block 用邊緣像素補齊, 跟自己組的 block 編出來一樣
+            for (unsigned by = 0; by < 2; by++)
+            {
+                for (unsigned bx = 0; bx < 2; bx++)
+                {
+                    unsigned char block[64];
+                    fillBlock(block, [&](unsigned x, unsigned y, unsigned char* px)
+                        {
+                            const unsigned sx = std::min(bx * 4 + x, dimension.m_width - 1);
+                            const unsigned sy = std::min(by * 4 + y, dimension.m_height - 1);
+                            memcpy(px, &pixels[(sy * dimension.m_width + sx) * 4], 4);
+                        });
+                    unsigned char expected[16];
+                    TextureBlockEncoder::encodeBC3Block(block, expected);
+                    Assert::AreEqual(0, memcmp(expected, &dxt5[(by * 2 + bx) * 16], 16));
+                }
+            }
+
+            // 不是 block 格式或像素數量不對時回傳空的
+            Assert::IsTrue(TextureBlockEncoder::encode(GraphicFormat::FMT_A8B8G8R8, dimension, pixels).empty());
+            Assert::IsTrue(TextureBlockEncoder::encode(GraphicFormat::FMT_DXT1, { 6, 4 }, pixels).empty());
+            byte_buffer opaque(pixels.size(), 255);
+            Assert::IsFalse(TextureBlockEncoder::hasAlpha(opaque));
+        }
+
+    private:
+        static TextureContainer::PayloadSource makeSource(const GraphicFormat& fmt, const Dimension<unsigned>& dimension, unsigned mip_count, unsigned seed)
+        {
+            TextureContainer::PayloadSource source{ fmt, {} };
+            for (unsigned lv = 0; lv < mip_count; lv++)
+            {
+                byte_buffer level(TextureContainer::levelBytes(fmt, TextureContainer::levelDimension(dimension, lv)));
+                for (size_t i = 0; i < level.size(); i++)
+                {
+                    level[i] = static_cast<unsigned char>(i * 13 + lv * 7 + seed);
+                }
+                source.m_levels.emplace_back(std::move(level));
+            }
+            return source;
+        }
+
+        template <class Fill> static void fillBlock(unsigned char block[64], Fill fill)
+        {
+            for (unsigned y = 0; y < 4; y++)
+            {
+                for (unsigned x = 0; x < 4; x++)
+                {
+                    fill(x, y, &block[(y * 4 + x) * 4]);
+                }
+            }
+        }
+
+        static unsigned readU16(const unsigned char* p)
+        {
+            return static_cast<unsigned>(p[0]) | (static_cast<unsigned>(p[1]) << 8);
+        }
+
+        static void unpack565(unsigned c, int rgb[3])
+        {
+            const int r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+            rgb[0] = (r << 3) | (r >> 2);
+            rgb[1] = (g << 2) | (g >> 4);
+            rgb[2] = (b << 3) | (b >> 2);
+        }
+
+        /** 依 BC1 規格解碼, c0 > c1 是 4 色模式, 否則 3 色加透明 */
+        static void decodeBC1(const unsigned char* bc1, unsigned char decoded[64])
+        {
+            const unsigned c0 = readU16(bc1);
+            const unsigned c1 = readU16(bc1 + 2);
+            int palette[4][3];
+            unpack565(c0, palette[0]);
+            unpack565(c1, palette[1]);
+            for (unsigned c = 0; c < 3; c++)
+            {
+                if (c0 > c1)
+                {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+                else
+                {
+                    palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                    palette[3][c] = 0;
+                }
+            }
+            std::uint32_t indices;
+            memcpy(&indices, bc1 + 4, sizeof(indices));
+            for (unsigned i = 0; i < 16; i++)
+            {
+                const unsigned p = (indices >> (i * 2)) & 0x3;
+                for (unsigned c = 0; c < 3; c++) decoded[i * 4 + c] = static_cast<unsigned char>(palette[p][c]);
+                decoded[i * 4 + 3] = ((c0 <= c1) && (p == 3)) ? 0 : 255;
+            }
+        }
+
+        static void decodeBC3(const unsigned char* bc3, unsigned char decoded[64])
+        {
+            decodeBC1(bc3 + 8, decoded);
+            const int a0 = bc3[0];
+            const int a1 = bc3[1];
+            int palette[8] = { a0, a1 };
+            for (int k = 1; k <= 6; k++)
+            {
+                palette[k + 1] = a0 > a1 ? ((7 - k) * a0 + k * a1) / 7 : (k <= 4 ? ((5 - k) * a0 + k * a1) / 5 : (k == 5 ? 0 : 255));
+            }
+            std::uint64_t indices = 0;
+            for (unsigned i = 0; i < 6; i++) indices |= static_cast<std::uint64_t>(bc3[2 + i]) << (i * 8);
+            for (unsigned i = 0; i < 16; i++)
+            {
+                decoded[i * 4 + 3] = static_cast<unsigned char>(palette[(indices >> (i * 3)) & 0x7]);
+            }
+        }
+
+        static double colorRmse(const unsigned char a[64], const unsigned char b[64])
+        {
+            double sum = 0.0;
+            for (unsigned i = 0; i < 16; i++)
+            {
+                for (unsigned c = 0; c < 3; c++)
+                {
+                    const double d = static_cast<double>(a[i * 4 + c]) - static_cast<double>(b[i * 4 + c]);
+                    sum += d * d;
+                }
+            }
+            return std::sqrt(sum / 48.0);
+        }
+    };
+}
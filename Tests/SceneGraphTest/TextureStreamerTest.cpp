@@ -0,0 +1,159 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "GameEngine/TextureStreamer.h"
+#include "GameEngine/TextureMipChain.h"
+#include "GameEngine/Texture.h"
+#include "GraphicKernel/ITexture.h"
+#include <string>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Engine;
+using namespace Enigma::Graphics;
+using namespace Enigma::MathLib;
+
+namespace SceneGraphTest
+{
+    /** 不經過 graphic api, 只記錄每次上傳的 level 大小 */
+    class UploadRecordingTexture : public ITexture
+    {
+    public:
+        UploadRecordingTexture(const std::string& name, std::vector<std::pair<std::string, unsigned>>& uploads)
+            : ITexture(name), m_uploads(uploads) {}
+
+        void create(const Dimension<unsigned>& dimension, const byte_buffer& buff) override
+        {
+            Assert::AreEqual(static_cast<size_t>(dimension.m_width) * dimension.m_height * 4, buff.size());
+            m_dimension = dimension;
+            m_uploads.emplace_back(m_name, dimension.m_width);
+        }
+
+    protected:
+        error loadTextureImage(const byte_buffer&) override { return error{}; }
+        error createFromSystemMemory(const Dimension<unsigned>&, const byte_buffer&) override { return error{}; }
+        error saveTextureImage(const Enigma::FileSystem::IFilePtr&) override { return error{}; }
+        error retrieveTextureImage(const Rect&) override { return error{}; }
+        error updateTextureImage(const Rect&, const byte_buffer&) override { return error{}; }
+        error useAsBackSurface(const IBackSurfacePtr&, const std::vector<RenderTextureUsage>&) override { return error{}; }
+
+    protected:
+        std::vector<std::pair<std::string, unsigned>>& m_uploads;
+    };
+
+    TEST_CLASS(TextureStreamerTest)
+    {
+    public:
+        static constexpr unsigned EXTENT = 256;
+        static constexpr unsigned TAIL_EXTENT = 64;
+
+        TEST_METHOD(TestMipTailFirstThenNearestRefinedFirst)
+        {
+            std::vector<std::pair<std::string, unsigned>> uploads;
+            TextureStreamer::Config config;
+            config.m_tailExtent = TAIL_EXTENT;
+            config.m_fullResolutionDistance = 10.0f;
+            config.m_maxUploadsPerUpdate = 1;
+            auto streamer = std::make_shared<TextureStreamer>(nullptr, config);
+            StreamedTexture near_tex = loadTexture(streamer, "near", uploads);
+            StreamedTexture middle_tex = loadTexture(streamer, "middle", uploads);
+            StreamedTexture far_tex = loadTexture(streamer, "far", uploads);
+            // loader 先上傳 mip tail, 登錄時 resident 就是 mip tail
+            Assert::AreEqual(static_cast<size_t>(3), uploads.size());
+            for (const auto& upload : uploads) Assert::AreEqual(TAIL_EXTENT, upload.second);
+            Assert::AreEqual(3 * TextureMipChain::levelBytes({ EXTENT, EXTENT }, 2), streamer->statistics().m_residentBytes);
+
+            // 由近到遠, 每次 update 上傳一個
+            far_tex.m_texture->streamingPriority(80.0f);
+            middle_tex.m_texture->streamingPriority(15.0f);
+            near_tex.m_texture->streamingPriority(40.0f);
+            near_tex.m_texture->streamingPriority(5.0f);  // 同一個 update 內取最近的
+            uploads.clear();
+            Assert::IsTrue(streamer->update());
+            Assert::AreEqual(static_cast<size_t>(1), uploads.size());
+            Assert::AreEqual(std::string("near"), uploads[0].first);
+            Assert::AreEqual(EXTENT, uploads[0].second);
+            Assert::IsFalse(streamer->update());
+            Assert::AreEqual(static_cast<size_t>(2), uploads.size());
+            Assert::AreEqual(std::string("middle"), uploads[1].first);
+            Assert::AreEqual(EXTENT / 2, uploads[1].second);
+            // far 要的 level 比 mip tail 粗, 停在 mip tail
+            Assert::IsFalse(streamer->update());
+            Assert::AreEqual(static_cast<size_t>(2), uploads.size());
+            const auto stat = streamer->statistics();
+            Assert::AreEqual(3u, stat.m_streamingTextures);
+            Assert::AreEqual(2u, stat.m_uploads);
+            Assert::AreEqual(0u, stat.m_evictions);
+            Assert::AreEqual(TextureMipChain::levelBytes({ EXTENT, EXTENT }, 0) + TextureMipChain::levelBytes({ EXTENT, EXTENT }, 1)
+                + TextureMipChain::levelBytes({ EXTENT, EXTENT }, 2), stat.m_residentBytes);
+
+            // texture 釋放後不再計算
+            far_tex = StreamedTexture{};
+            streamer->update();
+            Assert::AreEqual(2u, streamer->statistics().m_streamingTextures);
+        }
+
+        TEST_METHOD(TestBudgetEvictsFarthestToMipTail)
+        {
+            std::vector<std::pair<std::string, unsigned>> uploads;
+            const size_t tail_bytes = TextureMipChain::levelBytes({ EXTENT, EXTENT }, 2);
+            const size_t full_bytes = TextureMipChain::levelBytes({ EXTENT, EXTENT }, 0);
+            TextureStreamer::Config config;
+            config.m_tailExtent = TAIL_EXTENT;
+            config.m_fullResolutionDistance = 10.0f;
+            config.m_maxUploadsPerUpdate = 2;
+            // 只放得下一個 level 0 及另一個的 mip tail
+            config.m_memoryBudget = full_bytes + tail_bytes;
+            auto streamer = std::make_shared<TextureStreamer>(nullptr, config);
+            StreamedTexture first = loadTexture(streamer, "first", uploads);
+            StreamedTexture second = loadTexture(streamer, "second", uploads);
+            uploads.clear();
+
+            // second 比較近, 先拿到 level 0; first 放不下, 也不能擠掉比它近的
+            first.m_texture->streamingPriority(15.0f);
+            second.m_texture->streamingPriority(5.0f);
+            streamer->update();
+            Assert::AreEqual(static_cast<size_t>(1), uploads.size());
+            Assert::AreEqual(std::string("second"), uploads[0].first);
+            Assert::AreEqual(EXTENT, uploads[0].second);
+            Assert::AreEqual(0u, streamer->statistics().m_evictions);
+            Assert::IsTrue(streamer->statistics().m_residentBytes <= config.m_memoryBudget);
+
+            // 距離交換後, 較遠的 second 退回 mip tail, 讓出空間給 first
+            first.m_texture->streamingPriority(5.0f);
+            second.m_texture->streamingPriority(100.0f);
+            uploads.clear();
+            streamer->update();
+            Assert::AreEqual(static_cast<size_t>(2), uploads.size());
+            Assert::AreEqual(std::string("second"), uploads[0].first);
+            Assert::AreEqual(TAIL_EXTENT, uploads[0].second);
+            Assert::AreEqual(std::string("first"), uploads[1].first);
+            Assert::AreEqual(EXTENT, uploads[1].second);
+            const auto stat = streamer->statistics();
+            Assert::AreEqual(1u, stat.m_evictions);
+            Assert::AreEqual(full_bytes + tail_bytes, stat.m_residentBytes);
+        }
+
+    private:
+        struct StreamedTexture
+        {
+            std::shared_ptr<Texture> m_texture;
+            ITexturePtr m_deviceTexture;
+        };
+
+        /** 跟 TextureLoader 一樣: 先上傳 mip tail, 再把完整的 chain 交給 streamer */
+        static StreamedTexture loadTexture(const std::shared_ptr<TextureStreamer>& streamer, const std::string& name,
+            std::vector<std::pair<std::string, unsigned>>& uploads)
+        {
+            byte_buffer pixels(static_cast<size_t>(EXTENT) * EXTENT * 4);
+            for (size_t i = 0; i < pixels.size(); i++) pixels[i] = static_cast<unsigned char>(i * 7 + name.size());
+            TextureMipChain chain({ EXTENT, EXTENT }, std::move(pixels));
+            const unsigned tail_level = chain.tailLevel(streamer->config().m_tailExtent);
+            StreamedTexture streamed;
+            streamed.m_deviceTexture = std::make_shared<UploadRecordingTexture>(name, uploads);
+            const auto& tail = chain.level(tail_level);
+            streamed.m_deviceTexture->create(tail.m_dimension, tail.m_pixels);
+            streamed.m_texture = std::make_shared<Texture>(TextureId(name), streamed.m_deviceTexture);
+            streamer->registerTexture(streamed.m_texture, streamed.m_deviceTexture, "", std::move(chain), tail_level);
+            return streamed;
+        }
+    };
+}
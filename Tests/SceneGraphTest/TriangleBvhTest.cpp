@@ -0,0 +1,287 @@
+﻿#include "pch.h"
+#include "CppUnitTest.h"
+#include "Geometries/TriangleBvh.h"
+#include "MathLib/Vector3.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <vector>
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Enigma::Geometries;
+using namespace Enigma::MathLib;
+
+namespace SceneGraphTest
+{
+    /** 逐一測每個三角形的 double Moller-Trumbore, 當作對照組; 落在邊上或 max_t 附近的交點 float 跟 double 可能不一致, 歸類成 ambiguous 不比對 */
+    class BruteForceRayQuery
+    {
+    public:
+        enum class Touch { Miss, Hit, Ambiguous };
+        static constexpr double EDGE_MARGIN = 1.0e-4;
+        static constexpr double T_MARGIN = 1.0e-3;
+
+        struct Ray
+        {
+            Vector3 m_origin;
+            Vector3 m_direction;
+            float m_maxT;
+        };
+
+        explicit BruteForceRayQuery(const std::vector<Vector3>& positions) : m_positions(positions) {}
+
+        /** t 只有在 Hit 時保證有意義 */
+        Touch touch(const Ray& ray, unsigned triangle, double& t) const
+        {
+            t = -1.0;
+            const Vector3& p0 = m_positions[triangle * 3];
+            const Vector3& p1 = m_positions[triangle * 3 + 1];
+            const Vector3& p2 = m_positions[triangle * 3 + 2];
+            const double e1[3] = { p1.x() - p0.x(), p1.y() - p0.y(), p1.z() - p0.z() };
+            const double e2[3] = { p2.x() - p0.x(), p2.y() - p0.y(), p2.z() - p0.z() };
+            const double d[3] = { ray.m_direction.x(), ray.m_direction.y(), ray.m_direction.z() };
+            const double s[3] = { ray.m_origin.x() - p0.x(), ray.m_origin.y() - p0.y(), ray.m_origin.z() - p0.z() };
+            const double p[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+            const double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+            const double scale = std::sqrt(e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2]) * std::sqrt(e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2])
+                * std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            // 跟 ray 幾乎平行的三角形 float 算不準
+            if (std::fabs(det) <= scale * EDGE_MARGIN) return Touch::Ambiguous;
+            const double q[3] = { s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0] };
+            const double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) / det;
+            const double v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) / det;
+            t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+            const double inside = std::min({ u, v, 1.0 - u - v });
+            const double t_inside = std::min(t, static_cast<double>(ray.m_maxT) - t);
+            if ((inside < -EDGE_MARGIN) || (t_inside < -T_MARGIN)) return Touch::Miss;
+            if ((inside > EDGE_MARGIN) && (t_inside > T_MARGIN)) return Touch::Hit;
+            return Touch::Ambiguous;
+        }
+
+        unsigned triangleCount() const { return static_cast<unsigned>(m_positions.size() / 3); }
+
+    private:
+        const std::vector<Vector3>& m_positions;
+    };
+
+    TEST_CLASS(TriangleBvhTest)
+    {
+    public:
+        TEST_METHOD(TestMatchesBruteForceOnTriangleSoup)
+        {
+            std::mt19937 random{ 38 };
+            std::uniform_real_distribution<float> center(-50.0f, 50.0f);
+            std::uniform_real_distribution<float> extent(-4.0f, 4.0f);
+            std::vector<Vector3> positions;
+            for (unsigned i = 0; i < 3000; i++)
+            {
+                const Vector3 c{ center(random), center(random) * 0.2f, center(random) };
+                for (unsigned k = 0; k < 3; k++)
+                {
+                    positions.emplace_back(c.x() + extent(random), c.y() + extent(random), c.z() + extent(random));
+                }
+            }
+            // 共用頂點與邊的網格, 有很多 ray 會打在邊上
+            appendBumpySphere(positions, Vector3{ 0.0f, 0.0f, 0.0f }, 20.0f, 48);
+            assertMatchesBruteForce(positions, makeRays(random, 600, 60.0f));
+        }
+
+        TEST_METHOD(TestMatchesBruteForceOnAxisAlignedRays)
+        {
+            std::mt19937 random{ 380 };
+            std::vector<Vector3> positions;
+            appendBumpySphere(positions, Vector3{ 1.0f, -2.0f, 3.0f }, 10.0f, 32);
+            std::vector<BruteForceRayQuery::Ray> rays;
+            std::uniform_real_distribution<float> offset(-12.0f, 12.0f);
+            for (unsigned i = 0; i < 300; i++)
+            {
+                // direction 有 0 分量, inverse direction 是無限大
+                const unsigned axis = i % 3;
+                const float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+                Vector3 origin{ 1.0f + offset(random), -2.0f + offset(random), 3.0f + offset(random) };
+                Vector3 direction{ 0.0f, 0.0f, 0.0f };
+                if (axis == 0) { origin.x() = 1.0f - sign * 30.0f; direction.x() = sign; }
+                else if (axis == 1) { origin.y() = -2.0f - sign * 30.0f; direction.y() = sign; }
+                else { origin.z() = 3.0f - sign * 30.0f; direction.z() = sign; }
+                rays.push_back({ origin, direction, (i % 5 == 0) ? 25.0f : 100.0f });
+            }
+            assertMatchesBruteForce(positions, rays);
+        }
+
+        TEST_METHOD(TestEmptyAndSingleTriangle)
+        {
+            TriangleBvh empty{ std::vector<Vector3>{} };
+            Assert::IsTrue(empty.triangleCount() == 0);
+            Assert::IsFalse(empty.testRay(Vector3{ 0.0f, 0.0f, -1.0f }, Vector3{ 0.0f, 0.0f, 1.0f }, 10.0f));
+            Assert::IsFalse(empty.findNearest(Vector3{ 0.0f, 0.0f, -1.0f }, Vector3{ 0.0f, 0.0f, 1.0f }, 10.0f).has_value());
+            Assert::IsTrue(empty.findAll(Vector3{ 0.0f, 0.0f, -1.0f }, Vector3{ 0.0f, 0.0f, 1.0f }, 10.0f).empty());
+
+            TriangleBvh single{ { Vector3{ -1.0f, -1.0f, 0.0f }, Vector3{ 1.0f, -1.0f, 0.0f }, Vector3{ 0.0f, 1.0f, 0.0f } } };
+            // direction 不用單位長度, t 以 direction 為單位; 背面也算
+            const auto front = single.findNearest(Vector3{ 0.0f, 0.0f, -4.0f }, Vector3{ 0.0f, 0.0f, 2.0f }, 10.0f);
+            Assert::IsTrue(front.has_value());
+            Assert::IsTrue(std::fabs(front->m_t - 2.0f) < 1.0e-5f);
+            Assert::IsTrue(front->m_triangle == 0);
+            Assert::IsTrue(single.testRay(Vector3{ 0.0f, 0.0f, 4.0f }, Vector3{ 0.0f, 0.0f, -1.0f }, 10.0f));
+            Assert::IsFalse(single.testRay(Vector3{ 0.0f, 0.0f, -4.0f }, Vector3{ 0.0f, 0.0f, 1.0f }, 3.0f));
+            Assert::IsFalse(single.testRay(Vector3{ 0.0f, 0.0f, 4.0f }, Vector3{ 0.0f, 0.0f, 1.0f }, 10.0f));
+            Assert::IsFalse(single.testRay(Vector3{ 3.0f, 0.0f, -4.0f }, Vector3{ 0.0f, 0.0f, 1.0f }, 10.0f));
+        }
+
+        TEST_METHOD(BenchmarkPickingAgainstBruteForce)
+        {
+            std::mt19937 random{ 3800 };
+            std::vector<Vector3> positions;
+            appendBumpySphere(positions, Vector3{ 0.0f, 0.0f, 0.0f }, 20.0f, 256);
+            const auto rays = makeRays(random, 300, 40.0f);
+            BruteForceRayQuery brute_force{ positions };
+
+            auto start = std::chrono::steady_clock::now();
+            TriangleBvh bvh{ positions };
+            const double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            unsigned bvh_hits = 0;
+            for (const auto& ray : rays)
+            {
+                if (bvh.findNearest(ray.m_origin, ray.m_direction, ray.m_maxT)) bvh_hits++;
+            }
+            const double bvh_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            unsigned brute_hits = 0;
+            for (const auto& ray : rays)
+            {
+                double nearest = ray.m_maxT;
+                bool is_hit = false;
+                for (unsigned i = 0; i < brute_force.triangleCount(); i++)
+                {
+                    double t;
+                    if ((brute_force.touch(ray, i, t) == BruteForceRayQuery::Touch::Hit) && (t < nearest)) { nearest = t; is_hit = true; }
+                }
+                if (is_hit) brute_hits++;
+            }
+            const double brute_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            // BVH 另外可能打到落在邊上的 ambiguous 三角形
+            Assert::IsTrue((bvh_hits >= brute_hits) && (brute_hits > 0));
+
+            char report[256];
+            snprintf(report, sizeof(report), "%u triangles, %zu nodes, depth %u: build %.1f ms; nearest per ray BVH %.2f us, brute force %.1f us\n",
+                bvh.triangleCount(), bvh.nodeCount(), bvh.depth(), build_ms, bvh_ms * 1000.0 / rays.size(), brute_ms * 1000.0 / rays.size());
+            Logger::WriteMessage(report);
+        }
+
+    private:
+        /** 經緯切割的球, 半徑加上起伏, 每格兩個三角形 */
+        static void appendBumpySphere(std::vector<Vector3>& positions, const Vector3& center, float radius, unsigned slices)
+        {
+            constexpr float PI = 3.14159265f;
+            auto point = [&](unsigned stack, unsigned slice)
+            {
+                const float theta = PI * static_cast<float>(stack) / static_cast<float>(slices);
+                const float phi = 2.0f * PI * static_cast<float>(slice % slices) / static_cast<float>(slices);
+                const float r = radius * (1.0f + 0.05f * std::sin(7.0f * theta) * std::cos(5.0f * phi));
+                return Vector3{ center.x() + r * std::sin(theta) * std::cos(phi), center.y() + r * std::cos(theta), center.z() + r * std::sin(theta) * std::sin(phi) };
+            };
+            for (unsigned stack = 0; stack < slices; stack++)
+            {
+                for (unsigned slice = 0; slice < slices; slice++)
+                {
+                    positions.push_back(point(stack, slice));
+                    positions.push_back(point(stack + 1, slice));
+                    positions.push_back(point(stack + 1, slice + 1));
+                    positions.push_back(point(stack, slice));
+                    positions.push_back(point(stack + 1, slice + 1));
+                    positions.push_back(point(stack, slice + 1));
+                }
+            }
+        }
+
+        /** 原點散在 [-range, range] 的立方體內 (有些在模型裡面), 方向隨機且不是單位長度, 部分 ray 有較短的 max_t */
+        static std::vector<BruteForceRayQuery::Ray> makeRays(std::mt19937& random, unsigned count, float range)
+        {
+            std::uniform_real_distribution<float> origin(-range, range);
+            std::uniform_real_distribution<float> direction(-2.0f, 2.0f);
+            std::vector<BruteForceRayQuery::Ray> rays;
+            while (rays.size() < count)
+            {
+                const Vector3 d{ direction(random), direction(random), direction(random) };
+                if (d.squaredLength() < 0.01f) continue;
+                const float max_t = (rays.size() % 4 == 0) ? range * 0.25f : range * 4.0f;
+                rays.push_back({ Vector3{ origin(random), origin(random), origin(random) }, d, max_t });
+            }
+            return rays;
+        }
+
+        static void assertMatchesBruteForce(const std::vector<Vector3>& positions, const std::vector<BruteForceRayQuery::Ray>& rays)
+        {
+            TriangleBvh bvh{ positions };
+            BruteForceRayQuery brute_force{ positions };
+            Assert::IsTrue(bvh.triangleCount() == brute_force.triangleCount());
+            unsigned hit_rays = 0;
+            for (const auto& ray : rays)
+            {
+                std::vector<BruteForceRayQuery::Touch> touches(brute_force.triangleCount());
+                std::vector<double> ts(brute_force.triangleCount(), 0.0);
+                std::optional<double> nearest_hit;
+                bool has_ambiguous = false;
+                for (unsigned i = 0; i < brute_force.triangleCount(); i++)
+                {
+                    touches[i] = brute_force.touch(ray, i, ts[i]);
+                    if (touches[i] == BruteForceRayQuery::Touch::Hit)
+                    {
+                        if ((!nearest_hit) || (ts[i] < *nearest_hit)) nearest_hit = ts[i];
+                    }
+                    else if (touches[i] == BruteForceRayQuery::Touch::Ambiguous)
+                    {
+                        has_ambiguous = true;
+                    }
+                }
+                if (nearest_hit) hit_rays++;
+
+                // findAll : 每個確定的交點都要在, 不能有確定沒交到的, 依 t 排序
+                const auto all = bvh.findAll(ray.m_origin, ray.m_direction, ray.m_maxT);
+                std::vector<bool> is_reported(brute_force.triangleCount(), false);
+                for (size_t k = 0; k < all.size(); k++)
+                {
+                    Assert::IsTrue(all[k].m_triangle < brute_force.triangleCount());
+                    Assert::IsTrue(touches[all[k].m_triangle] != BruteForceRayQuery::Touch::Miss);
+                    if (touches[all[k].m_triangle] == BruteForceRayQuery::Touch::Hit)
+                    {
+                        Assert::IsTrue(std::fabs(all[k].m_t - ts[all[k].m_triangle]) <= BruteForceRayQuery::T_MARGIN * (1.0 + ts[all[k].m_triangle]));
+                    }
+                    if (k > 0) Assert::IsTrue(all[k - 1].m_t <= all[k].m_t);
+                    is_reported[all[k].m_triangle] = true;
+                }
+                for (unsigned i = 0; i < brute_force.triangleCount(); i++)
+                {
+                    if (touches[i] == BruteForceRayQuery::Touch::Hit) Assert::IsTrue(is_reported[i]);
+                }
+
+                // findNearest / testRay
+                const auto nearest = bvh.findNearest(ray.m_origin, ray.m_direction, ray.m_maxT);
+                const bool is_any = bvh.testRay(ray.m_origin, ray.m_direction, ray.m_maxT);
+                Assert::IsTrue(nearest.has_value() == is_any);
+                if (nearest_hit)
+                {
+                    Assert::IsTrue(nearest.has_value());
+                    Assert::IsTrue(nearest->m_t <= *nearest_hit + BruteForceRayQuery::T_MARGIN * (1.0 + *nearest_hit));
+                }
+                if (nearest)
+                {
+                    Assert::IsTrue(touches[nearest->m_triangle] != BruteForceRayQuery::Touch::Miss);
+                    Assert::IsTrue((!all.empty()) && (all.front().m_t == nearest->m_t));
+                }
+                else
+                {
+                    Assert::IsTrue(all.empty());
+                }
+                if ((!nearest_hit) && (!has_ambiguous)) Assert::IsFalse(is_any);
+            }
+            // 確保 ray 真的有打到東西, 不是全部 miss 而通過
+            Assert::IsTrue(hit_rays > rays.size() / 8);
+        }
+    };
+}
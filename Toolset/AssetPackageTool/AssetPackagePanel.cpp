@@ -45,6 +45,7 @@ AssetPackageTool::AssetPackagePanel::AssetPackagePanel(nana::window wd, AssetPac
     m_assetListbox = nullptr;
     m_addFilesButton = nullptr;
     m_addDirButton = nullptr;
+    m_lz4Checkbox = nullptr;
     m_rootDirPrompt = nullptr;
     m_assetSelectedMenu = nullptr;
 }
@@ -57,6 +58,7 @@ AssetPackageTool::AssetPackagePanel::~AssetPackagePanel()
     delete m_assetListbox;
     delete m_addFilesButton;
     delete m_addDirButton;
+    delete m_lz4Checkbox;
     delete m_rootDirPrompt;
     delete m_packageFile;
     delete m_assetSelectedMenu;
@@ -84,7 +86,9 @@ void AssetPackageTool::AssetPackagePanel::Initialize()
     UISchemeColors::ApplySchemaColors(m_addDirButton->scheme());
     m_addDirButton->events().click([=] (const nana::arg_click& a)
         { this->OnAddDirectoryButton(a); });  // a 的 type 用 auto 會編譯失敗， why??
-    (*m_place)["row_two"] << *m_addDirButton << *m_addFilesButton;
+    m_lz4Checkbox = new nana::checkbox{ *this, "LZ4 (fast)" };
+    UISchemeColors::ApplySchemaColors(m_lz4Checkbox->scheme());
+    (*m_place)["row_two"] << *m_addDirButton << *m_addFilesButton << *m_lz4Checkbox;
     m_assetListbox = new nana::listbox{ *this };
     UISchemeColors::ApplySchemaColors(m_assetListbox->scheme());
     m_assetListbox->scheme().header_bgcolor = UISchemeColors::BACKGROUND;
@@ -103,6 +107,8 @@ void AssetPackageTool::AssetPackagePanel::Initialize()
     m_assetSelectedMenu = new nana::menu{};
     m_assetSelectedMenu->append("Extract", [=] (auto item) { this->OnExtractSelectedAsset(item); });
     m_assetSelectedMenu->append("Remove", [=](auto item) { this->OnDeleteSelectedAsset(item); });
+    m_assetSelectedMenu->append_splitter();
+    m_assetSelectedMenu->append("Compact Package", [=](auto item) { this->OnCompactPackage(item); });
     m_assetListbox->events().mouse_down(menu_popuper(*m_assetSelectedMenu));
 
     RefreshAssetsList();
@@ -170,7 +176,18 @@ void AssetPackageTool::AssetPackagePanel::OnDeleteSelectedAsset(nana::menu::item
     if (selected_item.empty()) return;
     std::string asset_key = m_assetListbox->at(selected_item[0].cat).at(selected_item[0].item).text(0);
     if (!m_packageFile) return;
-    error er = m_packageFile->RemoveAsset(asset_key);
+    error er = m_packageFile->removeAsset(asset_key);
+    if (er)
+    {
+        PopupErrorMessage(er);
+    }
+    RefreshAssetsList();
+}
+
+void AssetPackageTool::AssetPackagePanel::OnCompactPackage(nana::menu::item_proxy& menu_item)
+{
+    if (!m_packageFile) return;
+    error er = m_packageFile->compact();
     if (er)
     {
         PopupErrorMessage(er);
@@ -182,7 +199,8 @@ void AssetPackageTool::AssetPackagePanel::AddPackageFile(const std::string& file
 {
     if (filepath.empty()) return;
     std::string asset_key = SplitAssetKeyName(filepath);
-    error er = m_packageFile->AddAssetFile(filepath, asset_key, AssetPackageFile::VERSION_USE_FILE_TIME);
+    const AssetCodec codec = ((m_lz4Checkbox) && (m_lz4Checkbox->checked())) ? AssetCodec::lz4 : AssetCodec::zlib;
+    error er = m_packageFile->addAssetFile(filepath, asset_key, AssetPackageFile::VERSION_USE_FILE_TIME, codec);
     if (er)
     {
         PopupErrorMessage(er);
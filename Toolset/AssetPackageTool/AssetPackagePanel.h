@@ -5,6 +5,7 @@
 #include "nana/gui/place.hpp"
 #include "nana/gui/widgets/label.hpp"
 #include "nana/gui/widgets/button.hpp"
+#include "nana/gui/widgets/checkbox.hpp"
 #include "nana/gui/widgets/listbox.hpp"
 #include "nana/gui/widgets/menu.hpp"
 #include "AssetPackageFile.h"
@@ -25,6 +26,7 @@ namespace AssetPackageTool
         void OnAddDirectoryButton(const nana::arg_click& ev);
         void OnExtractSelectedAsset(nana::menu::item_proxy& menu_item);
         void OnDeleteSelectedAsset(nana::menu::item_proxy& menu_item);
+        void OnCompactPackage(nana::menu::item_proxy& menu_item);
 
         void AddPackageFile(const std::string& filepath);
         std::string SplitAssetKeyName(const std::string& filepath);
@@ -38,6 +40,7 @@ namespace AssetPackageTool
         nana::listbox* m_assetListbox;
         nana::button* m_addFilesButton;
         nana::button* m_addDirButton;
+        nana::checkbox* m_lz4Checkbox;
         nana::label* m_rootDirPrompt;
 
         nana::menu* m_assetSelectedMenu;
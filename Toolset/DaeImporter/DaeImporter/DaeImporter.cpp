@@ -0,0 +1,334 @@
+﻿// DaeImporter.cpp : headless dae 匯入工具, 不開 viewer 直接把 dae 轉成 geometry/primitive/animation dto
+//
+// DaeImporter <dae files or dirs...> [-o output dir] [-j threads]
+//                  多個 dae 檔平行解析 (每個檔案一個 task), geometry 做 weld / vertex cache / vertex fetch 最佳化,
+//                  dto 依 factory desc 的檔名寫到 output dir (預設目前目錄), 最後列出每個 pass 的時間跟 ACMR
+//                  跟 viewer 一樣, 預設 effect 名稱從目前目錄的 DaeParser.cfg 讀取
+
+#include "DaeParser.h"
+#include "DaeParserErrors.h"
+#include "DaeSchema.h"
+#include "ViewerCommands.h"
+#include "Frameworks/ServiceManager.h"
+#include "Frameworks/CommandBus.h"
+#include "Frameworks/EventPublisher.h"
+#include "Frameworks/QueryDispatcher.h"
+#include "Frameworks/QuerySubscriber.h"
+#include "GameEngine/EffectMaterial.h"
+#include "GameEngine/EffectQueries.h"
+#include "Frameworks/WorkerThreadPool.h"
+#include "FileSystem/FileSystem.h"
+#include "Gateways/DtoJsonGateway.h"
+#include "Gateways/DtoGatewaySelector.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <optional>
+#include <chrono>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <cctype>
+
+using namespace EnigmaViewer;
+using namespace Enigma::Frameworks;
+using namespace Enigma::Gateways;
+using namespace Enigma::Engine;
+using namespace Enigma::Geometries;
+namespace stdfs = std::filesystem;
+
+using clock_type = std::chrono::high_resolution_clock;
+using milliseconds_float = std::chrono::duration<float, std::milli>;
+
+struct ImportResult
+{
+    stdfs::path m_path;
+    std::error_code m_error;
+    std::vector<std::string> m_logs;
+    std::vector<MeshOptimizer::Report> m_reports;
+    float m_readMilliseconds = 0.0f;
+    float m_parseMilliseconds = 0.0f;
+};
+
+static std::optional<std::string> readContent(const stdfs::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return std::nullopt;
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+static bool writeContent(const stdfs::path& path, const std::string& content)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return file.good();
+}
+
+/** 跟 file store mapper 的規則相同 : deferred filename, resource filename, 或是 id name + ".json", 去掉 "@PathId" */
+static std::string extractFilename(const std::string& id_name, const FactoryDesc& factory_desc)
+{
+    std::string filename;
+    if (!factory_desc.deferredFilename().empty())
+    {
+        filename = factory_desc.deferredFilename();
+    }
+    else if (!factory_desc.resourceFilename().empty())
+    {
+        filename = factory_desc.resourceFilename();
+    }
+    else
+    {
+        filename = id_name + ".json";
+    }
+    if (const auto at = filename.find('@'); at != std::string::npos) filename.erase(at);
+    return filename;
+}
+
+/** persist command 的 handler 會在 parser 的 worker thread 上同步執行, 寫檔本身互不相干, 只有 console 輸出要鎖 */
+class DtoFileWriter
+{
+public:
+    DtoFileWriter(const stdfs::path& output_path) : m_outputPath(output_path), m_selector(std::make_shared<DtoJsonGateway>()) {}
+
+    void subscribeHandlers()
+    {
+        m_persistGeometryDto = std::make_shared<CommandSubscriber>([=](const ICommandPtr& c) { this->persistDto<EnigmaViewer::PersistGeometryDto>(c); });
+        CommandBus::subscribe(typeid(EnigmaViewer::PersistGeometryDto), m_persistGeometryDto);
+        m_persistPrimitiveDto = std::make_shared<CommandSubscriber>([=](const ICommandPtr& c) { this->persistDto<EnigmaViewer::PersistPrimitiveDto>(c); });
+        CommandBus::subscribe(typeid(EnigmaViewer::PersistPrimitiveDto), m_persistPrimitiveDto);
+        m_persistAnimationAssetDto = std::make_shared<CommandSubscriber>([=](const ICommandPtr& c) { this->persistDto<EnigmaViewer::PersistAnimationAssetDto>(c); });
+        CommandBus::subscribe(typeid(EnigmaViewer::PersistAnimationAssetDto), m_persistAnimationAssetDto);
+        m_persistAnimatorDto = std::make_shared<CommandSubscriber>([=](const ICommandPtr& c) { this->persistDto<EnigmaViewer::PersistAnimatorDto>(c); });
+        CommandBus::subscribe(typeid(EnigmaViewer::PersistAnimatorDto), m_persistAnimatorDto);
+    }
+    void unsubscribeHandlers()
+    {
+        CommandBus::unsubscribe(typeid(EnigmaViewer::PersistGeometryDto), m_persistGeometryDto);
+        m_persistGeometryDto = nullptr;
+        CommandBus::unsubscribe(typeid(EnigmaViewer::PersistPrimitiveDto), m_persistPrimitiveDto);
+        m_persistPrimitiveDto = nullptr;
+        CommandBus::unsubscribe(typeid(EnigmaViewer::PersistAnimationAssetDto), m_persistAnimationAssetDto);
+        m_persistAnimationAssetDto = nullptr;
+        CommandBus::unsubscribe(typeid(EnigmaViewer::PersistAnimatorDto), m_persistAnimatorDto);
+        m_persistAnimatorDto = nullptr;
+    }
+    unsigned writtenCount() const { return m_writtenCount; }
+
+private:
+    template <class T> void persistDto(const ICommandPtr& c)
+    {
+        if (!c) return;
+        auto cmd = std::dynamic_pointer_cast<T, ICommand>(c);
+        if (!cmd) return;
+        const stdfs::path path = m_outputPath / extractFilename(cmd->id().name(), cmd->dto().getRtti());
+        std::error_code ec;
+        stdfs::create_directories(path.parent_path(), ec);
+        const bool is_written = writeContent(path, m_selector.selectGateway(path.string())->serialize({ cmd->dto() }));
+        std::lock_guard locker{ m_outputLock };
+        if (is_written)
+        {
+            m_writtenCount++;
+        }
+        else
+        {
+            std::cout << "write " << path.string() << " fail" << std::endl;
+        }
+    }
+
+private:
+    stdfs::path m_outputPath;
+    DtoGatewaySelector m_selector;
+    std::mutex m_outputLock;
+    unsigned m_writtenCount = 0;
+    CommandSubscriberPtr m_persistGeometryDto;
+    CommandSubscriberPtr m_persistPrimitiveDto;
+    CommandSubscriberPtr m_persistAnimationAssetDto;
+    CommandSubscriberPtr m_persistAnimatorDto;
+};
+
+static std::vector<stdfs::path> collectDaeFiles(const std::vector<stdfs::path>& inputs)
+{
+    std::vector<stdfs::path> files;
+    for (const auto& input : inputs)
+    {
+        if (!stdfs::is_directory(input))
+        {
+            files.emplace_back(input);
+            continue;
+        }
+        for (const auto& entry : stdfs::recursive_directory_iterator(input))
+        {
+            if (!entry.is_regular_file()) continue;
+            std::string ext = entry.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (ext == ".dae") files.emplace_back(entry.path());
+        }
+    }
+    return files;
+}
+
+static ImportResult importDaeFile(const stdfs::path& path)
+{
+    ImportResult result;
+    result.m_path = path;
+    auto time_point = clock_type::now();
+    auto content = readContent(path);
+    result.m_readMilliseconds = milliseconds_float(clock_type::now() - time_point).count();
+    if (!content)
+    {
+        result.m_error = std::make_error_code(std::errc::no_such_file_or_directory);
+        return result;
+    }
+    time_point = clock_type::now();
+    DaeParser parser([&result](const std::string& s) { result.m_logs.emplace_back(s); });
+    result.m_error = parser.parseDaeContent(path.filename().string(), content->data(), content->size());
+    // 靜態模型沒有 animation library, 不算錯誤
+    if (result.m_error == ParserError::noAnimationsLib) result.m_error.clear();
+    result.m_parseMilliseconds = milliseconds_float(clock_type::now() - time_point).count();
+    // DaeSchema 是 thread_local, 報告要在同一個 thread 上取走
+    result.m_reports = DaeSchema::getMeshOptimizeReports();
+    DaeSchema::clear();
+    return result;
+}
+
+static void printResult(const ImportResult& result)
+{
+    std::cout << result.m_path.string() << (result.m_error ? " fail : " + result.m_error.message() : " ok")
+        << ", read " << result.m_readMilliseconds << " ms, parse " << result.m_parseMilliseconds << " ms" << std::endl;
+    if (result.m_error)
+    {
+        for (const auto& log : result.m_logs)
+        {
+            std::cout << "    " << log << std::endl;
+        }
+    }
+    for (const auto& report : result.m_reports)
+    {
+        std::cout << "    " << report.m_geometryName << " : vertices " << report.m_originalVertexCount << " -> " << report.m_weldedVertexCount
+            << ", ACMR " << report.m_acmrBefore << " -> " << report.m_acmrAfter
+            << ", weld " << report.m_weldMilliseconds << " ms, cache " << report.m_vertexCacheMilliseconds << " ms, fetch " << report.m_vertexFetchMilliseconds << " ms" << std::endl;
+    }
+}
+
+static void printSummary(const std::vector<ImportResult>& results, float wall_ms, unsigned written_count)
+{
+    unsigned fail_count = 0;
+    float read_ms = 0.0f, parse_ms = 0.0f, weld_ms = 0.0f, cache_ms = 0.0f, fetch_ms = 0.0f;
+    size_t vertices_before = 0, vertices_after = 0, triangle_count = 0;
+    double transformed_before = 0.0, transformed_after = 0.0;
+    for (const auto& result : results)
+    {
+        if (result.m_error) fail_count++;
+        read_ms += result.m_readMilliseconds;
+        parse_ms += result.m_parseMilliseconds;
+        for (const auto& report : result.m_reports)
+        {
+            weld_ms += report.m_weldMilliseconds;
+            cache_ms += report.m_vertexCacheMilliseconds;
+            fetch_ms += report.m_vertexFetchMilliseconds;
+            vertices_before += report.m_originalVertexCount;
+            vertices_after += report.m_weldedVertexCount;
+            const size_t triangles = report.m_indexCount / 3;
+            triangle_count += triangles;
+            transformed_before += static_cast<double>(report.m_acmrBefore) * static_cast<double>(triangles);
+            transformed_after += static_cast<double>(report.m_acmrAfter) * static_cast<double>(triangles);
+        }
+    }
+    std::cout << "files " << results.size() << ", fail " << fail_count << ", dto written " << written_count << ", wall time " << wall_ms << " ms" << std::endl;
+    std::cout << "total (all threads) : read " << read_ms << " ms, parse " << parse_ms << " ms, weld " << weld_ms
+        << " ms, vertex cache " << cache_ms << " ms, vertex fetch " << fetch_ms << " ms" << std::endl;
+    if (triangle_count == 0) return;
+    std::cout << "vertices " << vertices_before << " -> " << vertices_after << ", triangles " << triangle_count
+        << ", ACMR " << transformed_before / static_cast<double>(triangle_count) << " -> " << transformed_after / static_cast<double>(triangle_count) << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<stdfs::path> inputs;
+    stdfs::path output_path = stdfs::current_path();
+    unsigned thread_count = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if ((arg == "-o") && (i + 1 < argc))
+        {
+            output_path = argv[++i];
+        }
+        else if ((arg == "-j") && (i + 1 < argc))
+        {
+            thread_count = static_cast<unsigned>(std::max(1, std::stoi(argv[++i])));
+        }
+        else
+        {
+            inputs.emplace_back(arg);
+        }
+    }
+    if (inputs.empty())
+    {
+        std::cout << "usage : DaeImporter <dae files or dirs...> [-o output dir] [-j threads]" << std::endl;
+        return -1;
+    }
+    const auto files = collectDaeFiles(inputs);
+    if (files.empty())
+    {
+        std::cout << "no dae file found" << std::endl;
+        return -1;
+    }
+    if (!stdfs::exists("DaeParser.cfg"))
+    {
+        std::cout << "DaeParser.cfg not found in working directory" << std::endl;
+        return -1;
+    }
+
+    // scene node parser 透過 file system 讀 DaeParser.cfg
+    Enigma::FileSystem::FileSystem::create();
+
+    ServiceManager service_manager;
+    CommandBus command_bus(&service_manager);
+    // assembler / parser 會發 event, 沒有人 tick, 只是讓 enqueue 有地方放
+    EventPublisher event_publisher(&service_manager);
+    // material 會 query effect / texture repository, 這裡沒有 repository; texture 查不到沒關係, dto 只記 texture id,
+    // effect material 則回一個只有 id 的空殼, primitive dto 只用到它的 id
+    QueryDispatcher query_dispatcher(&service_manager);
+    const auto query_effect_material = std::make_shared<QuerySubscriber>([](const IQueryPtr& q)
+        {
+            if (auto query = std::dynamic_pointer_cast<QueryEffectMaterial, IQuery>(q)) query->setResult(std::make_shared<EffectMaterial>(query->id()));
+        });
+    QueryDispatcher::subscribe(typeid(QueryEffectMaterial), query_effect_material);
+    DtoFileWriter writer(output_path);
+    // handler 要在平行解析前訂閱好, command bus 的 subscriber 表不會在解析中途變動
+    writer.subscribeHandlers();
+
+    const auto time_point = clock_type::now();
+    std::vector<ImportResult> results(files.size());
+    {
+        // 檔案大小差很多, 每個檔案一個 task 讓閒下來的 worker 自己去拿
+        WorkerThreadPool workers(thread_count);
+        std::vector<std::future<void>> futures;
+        futures.reserve(files.size());
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            futures.emplace_back(workers.pushTask([&results, &files, i]() { results[i] = importDaeFile(files[i]); }));
+        }
+        for (auto& f : futures)
+        {
+            workers.waitFor(f);
+        }
+    }
+    const float wall_ms = milliseconds_float(clock_type::now() - time_point).count();
+    writer.unsubscribeHandlers();
+    QueryDispatcher::unsubscribe(typeid(QueryEffectMaterial), query_effect_material);
+
+    for (const auto& result : results)
+    {
+        printResult(result);
+    }
+    printSummary(results, wall_ms, writer.writtenCount());
+    delete Enigma::FileSystem::FileSystem::instance();
+    const bool has_fail = std::any_of(results.begin(), results.end(), [](const ImportResult& r) { return static_cast<bool>(r.m_error); });
+    return has_fail ? 1 : 0;
+}
@@ -0,0 +1,32 @@
+﻿// pch.h: linux (cmake) build 的 forced include, 對應各模組 Win32 / Android 專案的 pch.h.
+// MSVC 的標準標頭會互相帶進來, gcc/clang 不會, 這裡補上引擎程式碼用到的.
+
+#ifndef PCH_H
+#define PCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdarg>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <string>
+#include <vector>
+#include <array>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <optional>
+#include <any>
+#include <stdexcept>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include "Platforms/MemoryMacro.h"
+
+#endif //PCH_H
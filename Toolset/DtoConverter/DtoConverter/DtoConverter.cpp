@@ -0,0 +1,224 @@
+﻿// DtoConverter.cpp : json dto <-> binary dto 轉換工具, 以及 Media 資產讀取時間的比較
+//
+// DtoConverter <file>                  json -> <file>.bdto, .bdto -> json (去掉 .bdto)
+// DtoConverter <input> <output>        依 output 副檔名決定轉換方向
+// DtoConverter --verify <files...>     json -> binary -> json, 檢查內容完全一致
+// DtoConverter --benchmark <dir> [n]   比較目錄下所有 json dto 跟 binary dto 的讀取時間, 重複 n 次
+
+#include "Gateways/DtoJsonGateway.h"
+#include "Gateways/DtoBinaryGateway.h"
+#include "Gateways/DtoGatewaySelector.h"
+#include "rapidjson/document.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <optional>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+using namespace Enigma::Gateways;
+using namespace Enigma::Engine;
+namespace stdfs = std::filesystem;
+
+using clock_type = std::chrono::high_resolution_clock;
+using milliseconds_float = std::chrono::duration<float, std::milli>;
+
+static std::optional<std::string> readContent(const stdfs::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return std::nullopt;
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+static bool writeContent(const stdfs::path& path, const std::string& content)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return file.good();
+}
+
+/** json dto 檔案是 object 的 array, 其他 json (ex. effect profile) 跳過 */
+static bool isJsonDtoContent(const std::string& content)
+{
+    const auto pos = content.find_first_not_of(" \t\r\n\xef\xbb\xbf");
+    if ((pos == std::string::npos) || (content[pos] != '[')) return false;
+    rapidjson::Document doc;
+    doc.Parse(content.c_str());
+    if ((doc.HasParseError()) || (!doc.IsArray())) return false;
+    for (auto it = doc.Begin(); it != doc.End(); ++it)
+    {
+        if (!it->IsObject()) return false;
+    }
+    return true;
+}
+
+static GenericDtoCollection deserializeContent(const std::string& content)
+{
+    if (DtoBinaryGateway::isBinaryContent(content.data(), content.size())) return DtoBinaryGateway().deserialize(content);
+    return DtoJsonGateway().deserialize(content);
+}
+
+static int convertFile(const stdfs::path& input, const stdfs::path& output)
+{
+    auto content = readContent(input);
+    if (!content)
+    {
+        std::cout << "read " << input << " fail" << std::endl;
+        return -1;
+    }
+    if ((!DtoBinaryGateway::isBinaryContent(content->data(), content->size())) && (!isJsonDtoContent(content.value())))
+    {
+        std::cout << input << " is not a dto file" << std::endl;
+        return -1;
+    }
+    auto dtos = deserializeContent(content.value());
+    if (dtos.empty())
+    {
+        std::cout << input << " has no dto" << std::endl;
+        return -1;
+    }
+    DtoGatewaySelector selector(std::make_shared<DtoJsonGateway>());
+    auto converted = selector.selectGateway(output.string())->serialize(dtos);
+    if (!writeContent(output, converted))
+    {
+        std::cout << "write " << output << " fail" << std::endl;
+        return -1;
+    }
+    std::cout << input << " (" << content->size() << " bytes) -> " << output << " (" << converted.size() << " bytes)" << std::endl;
+    return 0;
+}
+
+/** json -> binary -> json, 比較兩份 json 的 DOM (object member 不計順序, 數值要完全相同) */
+static bool verifyRoundTrip(const stdfs::path& path)
+{
+    auto content = readContent(path);
+    if ((!content) || (!isJsonDtoContent(content.value()))) return false;
+    DtoJsonGateway json_gateway;
+    DtoBinaryGateway binary_gateway;
+    auto dtos = json_gateway.deserialize(content.value());
+    auto binary = binary_gateway.serialize(dtos);
+    auto round_trip_dtos = binary_gateway.deserialize(binary);
+    rapidjson::Document expected;
+    rapidjson::Document actual;
+    expected.Parse(json_gateway.serialize(dtos).c_str());
+    actual.Parse(json_gateway.serialize(round_trip_dtos).c_str());
+    return (!expected.HasParseError()) && (!actual.HasParseError()) && (expected == actual);
+}
+
+static int verifyFiles(const std::vector<stdfs::path>& paths)
+{
+    int fail_count = 0;
+    for (auto& path : paths)
+    {
+        const bool is_ok = verifyRoundTrip(path);
+        if (!is_ok) fail_count++;
+        std::cout << (is_ok ? "ok   " : "FAIL ") << path << std::endl;
+    }
+    return fail_count == 0 ? 0 : -1;
+}
+
+static int benchmark(const stdfs::path& media_path, unsigned repeat)
+{
+    struct Asset
+    {
+        stdfs::path m_path;
+        std::string m_json;
+        std::string m_binary;
+    };
+    std::vector<Asset> assets;
+    DtoJsonGateway json_gateway;
+    DtoBinaryGateway binary_gateway;
+    for (auto& entry : stdfs::recursive_directory_iterator(media_path))
+    {
+        if (!entry.is_regular_file()) continue;
+        auto content = readContent(entry.path());
+        if ((!content) || (!isJsonDtoContent(content.value()))) continue;
+        auto dtos = json_gateway.deserialize(content.value());
+        if (dtos.empty()) continue;
+        assets.push_back({ entry.path(), std::move(content.value()), binary_gateway.serialize(dtos) });
+    }
+    if (assets.empty())
+    {
+        std::cout << "no json dto under " << media_path << std::endl;
+        return -1;
+    }
+
+    size_t json_bytes = 0;
+    size_t binary_bytes = 0;
+    float json_ms = 0.0f;
+    float binary_ms = 0.0f;
+    size_t dto_count = 0;
+    for (auto& asset : assets)
+    {
+        json_bytes += asset.m_json.size();
+        binary_bytes += asset.m_binary.size();
+        auto time_point = clock_type::now();
+        for (unsigned i = 0; i < repeat; i++)
+        {
+            dto_count += json_gateway.deserialize(asset.m_json).size();
+        }
+        const float asset_json_ms = milliseconds_float(clock_type::now() - time_point).count();
+        time_point = clock_type::now();
+        for (unsigned i = 0; i < repeat; i++)
+        {
+            dto_count += binary_gateway.deserializeBuffer(asset.m_binary.data(), asset.m_binary.size()).size();
+        }
+        const float asset_binary_ms = milliseconds_float(clock_type::now() - time_point).count();
+        json_ms += asset_json_ms;
+        binary_ms += asset_binary_ms;
+        std::cout << asset.m_path.filename().string() << " : json " << asset.m_json.size() << " bytes " << asset_json_ms / repeat
+            << " ms, binary " << asset.m_binary.size() << " bytes " << asset_binary_ms / repeat << " ms" << std::endl;
+    }
+    std::cout << assets.size() << " assets, " << dto_count << " dtos deserialized, repeat " << repeat << std::endl;
+    std::cout << "json   : " << json_bytes << " bytes, " << json_ms / repeat << " ms per pass" << std::endl;
+    std::cout << "binary : " << binary_bytes << " bytes, " << binary_ms / repeat << " ms per pass" << std::endl;
+    if (binary_ms > 0.0f) std::cout << "speed up x" << json_ms / binary_ms << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "usage : DtoConverter <file> [output]" << std::endl;
+        std::cout << "        DtoConverter --verify <files...>" << std::endl;
+        std::cout << "        DtoConverter --benchmark <media dir> [repeat]" << std::endl;
+        return -1;
+    }
+    const std::string command = argv[1];
+    if (command == "--verify")
+    {
+        std::vector<stdfs::path> paths;
+        for (int i = 2; i < argc; i++)
+        {
+            paths.emplace_back(argv[i]);
+        }
+        return verifyFiles(paths);
+    }
+    if (command == "--benchmark")
+    {
+        const stdfs::path media_path = argc > 2 ? stdfs::path(argv[2]) : stdfs::current_path() / "Media";
+        const unsigned repeat = argc > 3 ? static_cast<unsigned>(std::max(1, std::stoi(argv[3]))) : 10;
+        return benchmark(media_path, repeat);
+    }
+    const stdfs::path input = argv[1];
+    stdfs::path output;
+    if (argc > 2)
+    {
+        output = argv[2];
+    }
+    else if (DtoGatewaySelector::extensionOf(input.string()) == DtoBinaryGateway::FILE_EXTENSION)
+    {
+        output = input.parent_path() / input.stem();
+    }
+    else
+    {
+        output = input.string() + DtoBinaryGateway::FILE_EXTENSION;
+    }
+    return convertFile(input, output);
+}
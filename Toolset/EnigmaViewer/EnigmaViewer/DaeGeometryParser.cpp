@@ -100,6 +100,7 @@ std::error_code DaeGeometryParser::parseSingleGeometry(const pugi::xml_node& geo
         m_outputPipe("  Error organizing geometry vertices!!");
         return err;
     }
+    vertices_parser.optimizeVertices(weights_parser, m_geometryName);
     vertices_parser.persistSingleGeometry(m_geometryId, weights_parser);
     return ParserError::ok;
 }
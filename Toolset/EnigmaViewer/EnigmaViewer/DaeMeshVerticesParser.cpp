@@ -4,10 +4,17 @@
 #include "DaeSchema.h"
 #include "ViewerCommands.h"
 #include "Geometries/TriangleListAssembler.h"
+#include "Geometries/MeshOptimizer.h"
 #include <cassert>
 #include <sstream>
+#include <chrono>
+#include <cstring>
 
 using namespace EnigmaViewer;
+using namespace Enigma::Geometries;
+
+using clock_type = std::chrono::high_resolution_clock;
+using milliseconds_float = std::chrono::duration<float, std::milli>;
 
 #define TOKEN_TRIANGLES "triangles"
 #define TOKEN_COUNT "count"
@@ -160,6 +167,85 @@ std::error_code DaeMeshVerticesParser::organizeVertices(const std::shared_ptr<Da
     return er;
 }
 
+void DaeMeshVerticesParser::optimizeVertices(const std::shared_ptr<DaeVertexWeightsParser>& weights_parser, const std::string& geometry_name)
+{
+    const unsigned vertex_count = static_cast<unsigned>(m_splitedPositions.size());
+    if ((vertex_count == 0) || (m_collapsedIndices.size() < 3)) return;
+    const bool has_normal = m_collapsedNormals.size() == vertex_count;
+    const bool has_texcoord = m_splitedTexCoord[0].size() == vertex_count;
+    const bool has_weight = (weights_parser) && (weights_parser->getSplitedWeightIndices().size() == vertex_count)
+        && (weights_parser->getSplitedVertexWeights().size() == vertex_count * 4);
+    // 有 stream 的數量跟 vertex 數對不上時不做, 維持原樣
+    if (((!m_collapsedNormals.empty()) && (!has_normal)) || ((!m_splitedTexCoord[0].empty()) && (!has_texcoord))
+        || ((weights_parser) && (!has_weight))) return;
+    for (const auto index : m_collapsedIndices)
+    {
+        if (index >= vertex_count) return;
+    }
+
+    MeshOptimizer::Report report;
+    report.m_geometryName = geometry_name;
+    report.m_originalVertexCount = vertex_count;
+    report.m_indexCount = static_cast<unsigned>(m_collapsedIndices.size());
+    report.m_acmrBefore = MeshOptimizer::calculateAcmr(m_collapsedIndices, vertex_count);
+
+    auto time_point = clock_type::now();
+    const unsigned floats_per_vertex = 3 + (has_normal ? 3 : 0) + (has_texcoord ? 2 : 0) + (has_weight ? 8 : 0);
+    std::vector<float> attributes;
+    attributes.reserve(static_cast<size_t>(vertex_count) * floats_per_vertex);
+    for (unsigned i = 0; i < vertex_count; i++)
+    {
+        attributes.insert(attributes.end(), { m_splitedPositions[i].x(), m_splitedPositions[i].y(), m_splitedPositions[i].z() });
+        if (has_normal) attributes.insert(attributes.end(), { m_collapsedNormals[i].x(), m_collapsedNormals[i].y(), m_collapsedNormals[i].z() });
+        if (has_texcoord) attributes.insert(attributes.end(), { m_splitedTexCoord[0][i].x(), m_splitedTexCoord[0][i].y() });
+        if (has_weight)
+        {
+            // palette index 拆成 4 個 byte, 用 float 表示才能精確比較
+            const unsigned palette = weights_parser->getSplitedWeightIndices()[i];
+            for (unsigned b = 0; b < 4; b++)
+            {
+                attributes.emplace_back(static_cast<float>((palette >> (b * 8)) & 0xff));
+            }
+            const float* weights = &weights_parser->getSplitedVertexWeights()[static_cast<size_t>(i) * 4];
+            attributes.insert(attributes.end(), weights, weights + 4);
+        }
+    }
+    std::vector<unsigned> remap;
+    const unsigned welded_count = MeshOptimizer::weldVertices(attributes, floats_per_vertex, remap);
+    if (welded_count < vertex_count)
+    {
+        MeshOptimizer::remapIndices(m_collapsedIndices, remap);
+        remapOrganizedVertices(remap, welded_count, weights_parser);
+    }
+    report.m_weldedVertexCount = welded_count;
+    report.m_weldMilliseconds = milliseconds_float(clock_type::now() - time_point).count();
+
+    time_point = clock_type::now();
+    MeshOptimizer::optimizeVertexCache(m_collapsedIndices, welded_count);
+    report.m_vertexCacheMilliseconds = milliseconds_float(clock_type::now() - time_point).count();
+
+    time_point = clock_type::now();
+    const unsigned fetched_count = MeshOptimizer::optimizeVertexFetch(m_collapsedIndices, welded_count, remap);
+    remapOrganizedVertices(remap, fetched_count, weights_parser);
+    report.m_vertexFetchMilliseconds = milliseconds_float(clock_type::now() - time_point).count();
+    report.m_acmrAfter = MeshOptimizer::calculateAcmr(m_collapsedIndices, fetched_count);
+
+    m_outputPipe("    Optimize " + geometry_name + " : vertices " + std::to_string(vertex_count) + " -> " + std::to_string(fetched_count)
+        + ", ACMR " + std::to_string(report.m_acmrBefore) + " -> " + std::to_string(report.m_acmrAfter));
+    DaeSchema::addMeshOptimizeReport(report);
+}
+
+void DaeMeshVerticesParser::remapOrganizedVertices(const std::vector<unsigned>& remap, unsigned new_vertex_count, const std::shared_ptr<DaeVertexWeightsParser>& weights_parser)
+{
+    m_splitedPositions = MeshOptimizer::remapVertices(m_splitedPositions, remap, new_vertex_count);
+    if (!m_collapsedNormals.empty()) m_collapsedNormals = MeshOptimizer::remapVertices(m_collapsedNormals, remap, new_vertex_count);
+    for (auto& texcoords : m_splitedTexCoord)
+    {
+        if (texcoords.size() == remap.size()) texcoords = MeshOptimizer::remapVertices(texcoords, remap, new_vertex_count);
+    }
+    if (weights_parser) weights_parser->remapSplitedVertices(remap, new_vertex_count);
+}
+
 void DaeMeshVerticesParser::persistSingleGeometry(const Enigma::Geometries::GeometryId& geo_id, const std::shared_ptr<DaeVertexWeightsParser>& weights_parser)
 {
     Enigma::Geometries::TriangleListAssembler geo_assembler(geo_id);
@@ -315,22 +401,25 @@ std::error_code DaeMeshVerticesParser::collapseVertexNormals(int pos_offset, int
     int vertex_count = static_cast<int>(m_splitedPositions.size());
     m_collapsedNormals.resize(vertex_count);
     int prim_set_count = static_cast<int>(m_primitiveIndices.size()) / 3;
+    // 每個頂點用到的 normal, 依 primitive 順序加入, 要去除掉共平面的normal計算
+    std::vector<std::vector<Enigma::MathLib::Vector3>> used_normals(vertex_count);
+    for (int p = 0; p < prim_set_count; p++)
+    {
+        const unsigned vertex_index = m_primitiveIndices[p * 3 + pos_offset];
+        if (vertex_index >= static_cast<unsigned>(vertex_count)) continue;
+        const Enigma::MathLib::Vector3& current_nor = m_normals[m_primitiveIndices[p * 3 + nor_offset]];
+        auto& used_normal = used_normals[vertex_index];
+        if (std::find(used_normal.begin(), used_normal.end(), current_nor) == used_normal.end())
+        {
+            used_normal.push_back(current_nor);
+        }
+    }
     for (int i = 0; i < vertex_count; i++)
     {
         Enigma::MathLib::Vector3 nor = Enigma::MathLib::Vector3::ZERO;
-        std::list<Enigma::MathLib::Vector3> used_normal;  // 要去除掉共平面的normal計算
-        for (int p = 0; p < prim_set_count; p++)
+        for (const auto& used_nor : used_normals[i])
         {
-            if (m_primitiveIndices[p * 3 + pos_offset] == i) // 對應到頂點
-            {
-                Enigma::MathLib::Vector3 current_nor = m_normals[m_primitiveIndices[p * 3 + nor_offset]];
-                if (std::find_if(used_normal.begin(), used_normal.end(),
-                    [=](Enigma::MathLib::Vector3 vec) -> bool { return vec == current_nor; }) == used_normal.end())
-                {
-                    nor += current_nor;
-                    used_normal.push_back(current_nor);
-                }
-            }
+            nor += used_nor;
         }
         m_collapsedNormals[i] = nor.normalize();
     }
@@ -30,6 +30,8 @@ namespace EnigmaViewer
 
         std::error_code parseVertices(const pugi::xml_node& vertices_xml_node);
         std::error_code organizeVertices(const std::shared_ptr<DaeVertexWeightsParser>& weights_parser);
+        /** weld, vertex cache & vertex fetch 重排, 結果記錄在 DaeSchema 的 mesh optimize reports */
+        void optimizeVertices(const std::shared_ptr<DaeVertexWeightsParser>& weights_parser, const std::string& geometry_name);
         void persistSingleGeometry(const Enigma::Geometries::GeometryId& geo_id, const std::shared_ptr<DaeVertexWeightsParser>& weights_parser);
 
         [[nodiscard]] const std::string& getMaterialId() const { return m_meshMaterialId; }
@@ -42,6 +44,7 @@ namespace EnigmaViewer
         std::error_code splitVertexPositions(int pos_offset, int tex_set, int tex_offset, bool is_split_vertex, const std::shared_ptr<DaeVertexWeightsParser>& weights_parser);
         std::error_code collapseVertexNormals(int pos_offset, int nor_offset, bool is_split_vertex);
         std::error_code collapseIndexArray(int pos_offset, bool is_split_vertex);
+        void remapOrganizedVertices(const std::vector<unsigned>& remap, unsigned new_vertex_count, const std::shared_ptr<DaeVertexWeightsParser>& weights_parser);
 
     protected:
         struct GeometryValueOffsets
@@ -4,12 +4,24 @@
 #include "DaeSceneParser.h"
 #include "FileSystem/FileSystem.h"
 #include "FileSystem/IFile.h"
+#include "DaeParserErrors.h"
 #include "ViewerCommands.h"
+#include <cassert>
 
 using namespace EnigmaViewer;
 using namespace Enigma::FileSystem;
 
 
+DaeParser::DaeParser()
+{
+    m_outputPipe = [](const std::string& msg) { std::make_shared<OutputMessage>(msg)->enqueue(); };
+}
+
+DaeParser::DaeParser(const std::function<void(const std::string&)>& output_pipe) : m_outputPipe(output_pipe)
+{
+    assert(m_outputPipe);
+}
+
 void DaeParser::loadDaeFile(const std::string& filename)
 {
     IFilePtr file = FileSystem::instance()->openFile(filename, read | binary, "");
@@ -22,12 +34,17 @@ void DaeParser::loadDaeFile(const std::string& filename)
         outputLog(filename + " read fail!!");
         return;
     }
+    parseDaeContent(filename, &((read_buf.value())[0]), file_size);
+}
+
+std::error_code DaeParser::parseDaeContent(const std::string& filename, const void* content, size_t size)
+{
     pugi::xml_document dae_doc;
-    pugi::xml_parse_result res = dae_doc.load_buffer(&((read_buf.value())[0]), file_size);
+    pugi::xml_parse_result res = dae_doc.load_buffer(content, size);
     if (res.status != pugi::xml_parse_status::status_ok)
     {
         outputLog(filename + " parse error!!");
-        return;
+        return ParserError::parseXmlFail;
     }
     else
     {
@@ -45,7 +62,7 @@ void DaeParser::loadDaeFile(const std::string& filename)
     if (er)
     {
         outputLog("parse scene error!!");
-        return;
+        return er;
     }
     //parseScene(collada_root);
     DaeAnimationParser animation_parser([=](auto s) { outputLog(s); });
@@ -56,9 +73,10 @@ void DaeParser::loadDaeFile(const std::string& filename)
         animation_parser.persistAnimator(scene_parser.getModelId());
         scene_parser.persistModel(animation_parser.getAnimatorId());
     }
+    return er;
 }
 
 void DaeParser::outputLog(const std::string& msg)
 {
-    std::make_shared<OutputMessage>(msg)->enqueue();
+    m_outputPipe(msg);
 }
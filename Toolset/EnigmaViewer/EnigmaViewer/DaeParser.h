@@ -9,20 +9,29 @@
 #define _DAE_PARSER_H
 
 #include <string>
+#include <functional>
+#include <system_error>
 
 namespace EnigmaViewer
 {
     class DaeParser
     {
     public:
-        DaeParser() = default;
+        /** log 送到 viewer 的 output panel */
+        DaeParser();
+        /** headless 用 (ex. DaeImporter), log 送到 output_pipe */
+        DaeParser(const std::function<void(const std::string&)>& output_pipe);
 
         void loadDaeFile(const std::string& filename);
+        /** 解析已讀入的 dae 內容, geometry/primitive/animation dto 以 persist 命令送出.
+         同一執行緒內一次只能解析一個檔案 (DaeSchema 是 thread local) */
+        std::error_code parseDaeContent(const std::string& filename, const void* content, size_t size);
 
     private:
         void outputLog(const std::string& msg);
 
     private:
+        std::function<void(const std::string&)> m_outputPipe;
         std::string m_filename;
     };
 }
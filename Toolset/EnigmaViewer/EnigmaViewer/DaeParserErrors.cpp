@@ -14,6 +14,7 @@ std::string ParserErrorCategory::message(int err) const
     case ParserError::noInstanceScene: return "No instance scene";
     case ParserError::instanceSceneUrlError: return "Instance scene url error";
     case ParserError::noModelSceneNode: return "No model scene node";
+    case ParserError::parseXmlFail: return "Parse xml fail";
     case ParserError::noAnimationsLib: return "No animations library";
     case ParserError::noAnimationNode: return "No animation node";
     case ParserError::noAnimationNameNode: return "No animation name node";
@@ -20,6 +20,7 @@ namespace EnigmaViewer
         noInstanceScene,
         instanceSceneUrlError,
         noModelSceneNode,
+        parseXmlFail,
 
         noAnimationsLib = 101,
         noAnimationNode,
@@ -201,7 +201,7 @@ void DaeSceneNodeParser::persistMesh(const Enigma::Primitives::PrimitiveId& mesh
     mesh_assembler.asNative(mesh_id.name() + ".mesh@APK_PATH");
     if ((texture_id) && (tex_semantic))
     {
-        mesh_assembler.addMaterial(std::make_shared<Enigma::Renderables::PrimitiveMaterial>(effect_id, Enigma::Engine::EffectTextureMap({ {texture_id.value(), std::nullopt, tex_semantic.value()} })));
+        mesh_assembler.addMaterial(std::make_shared<Enigma::Renderables::PrimitiveMaterial>(effect_id, Enigma::Engine::EffectTextureMap(Enigma::Engine::EffectSemanticTexture(texture_id.value(), std::nullopt, tex_semantic.value()))));
     }
     else
     {
@@ -4,10 +4,11 @@ using namespace EnigmaViewer;
 
 #define TOKEN_ID "id"
 
-std::unordered_map<std::string, std::string> DaeSchema::m_nodeIdNameMapping;
-std::unordered_map<std::string, std::string> DaeSchema::m_nodeJointIdMapping;
-std::unordered_map<std::string, Enigma::Primitives::PrimitiveId> DaeSchema::m_meshIdInMeshNode;
-std::unordered_map<std::string, std::vector<std::string>> DaeSchema::m_skinBoneNames;
+thread_local std::unordered_map<std::string, std::string> DaeSchema::m_nodeIdNameMapping;
+thread_local std::unordered_map<std::string, std::string> DaeSchema::m_nodeJointIdMapping;
+thread_local std::unordered_map<std::string, Enigma::Primitives::PrimitiveId> DaeSchema::m_meshIdInMeshNode;
+thread_local std::unordered_map<std::string, std::vector<std::string>> DaeSchema::m_skinBoneNames;
+thread_local std::vector<Enigma::Geometries::MeshOptimizer::Report> DaeSchema::m_meshOptimizeReports;
 
 pugi::xml_node DaeSchema::findChildNodeWithId(const pugi::xml_node& node_root, const std::string& token_name, const std::string& id)
 {
@@ -25,6 +26,7 @@ void DaeSchema::clear()
     clearNodeJointIdMapping();
     clearMeshIdInMeshNode();
     clearSkinBoneNames();
+    clearMeshOptimizeReports();
 }
 
 void DaeSchema::clearNodeIdNameMapping()
@@ -90,3 +92,18 @@ const std::unordered_map<std::string, std::vector<std::string>>& DaeSchema::getS
 {
     return m_skinBoneNames;
 }
+
+void DaeSchema::clearMeshOptimizeReports()
+{
+    m_meshOptimizeReports.clear();
+}
+
+void DaeSchema::addMeshOptimizeReport(const Enigma::Geometries::MeshOptimizer::Report& report)
+{
+    m_meshOptimizeReports.emplace_back(report);
+}
+
+const std::vector<Enigma::Geometries::MeshOptimizer::Report>& DaeSchema::getMeshOptimizeReports()
+{
+    return m_meshOptimizeReports;
+}
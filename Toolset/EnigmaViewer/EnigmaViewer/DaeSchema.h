@@ -9,12 +9,14 @@
 #define DAE_SCHEMA_H
 
 #include "Primitives/PrimitiveId.h"
+#include "Geometries/MeshOptimizer.h"
 #include "pugixml.hpp"
 #include <unordered_map>
 #include <optional>
 
 namespace EnigmaViewer
 {
+    /** 一個 dae 檔解析過程中的對應表. 每個執行緒各自一份, 不同執行緒可以同時解析不同的檔案 */
     class DaeSchema
     {
     public:
@@ -37,11 +39,16 @@ namespace EnigmaViewer
         static void addSkinBoneNames(const std::string& skin_name, const std::vector<std::string>& bone_names);
         static const std::unordered_map<std::string, std::vector<std::string>>& getSkinBoneNames();
 
+        static void clearMeshOptimizeReports();
+        static void addMeshOptimizeReport(const Enigma::Geometries::MeshOptimizer::Report& report);
+        static const std::vector<Enigma::Geometries::MeshOptimizer::Report>& getMeshOptimizeReports();
+
     private:
-        static std::unordered_map<std::string, std::string> m_nodeIdNameMapping;
-        static std::unordered_map<std::string, std::string> m_nodeJointIdMapping;
-        static std::unordered_map<std::string, Enigma::Primitives::PrimitiveId> m_meshIdInMeshNode;
-        static std::unordered_map<std::string, std::vector<std::string>> m_skinBoneNames;
+        static thread_local std::unordered_map<std::string, std::string> m_nodeIdNameMapping;
+        static thread_local std::unordered_map<std::string, std::string> m_nodeJointIdMapping;
+        static thread_local std::unordered_map<std::string, Enigma::Primitives::PrimitiveId> m_meshIdInMeshNode;
+        static thread_local std::unordered_map<std::string, std::vector<std::string>> m_skinBoneNames;
+        static thread_local std::vector<Enigma::Geometries::MeshOptimizer::Report> m_meshOptimizeReports;
     };
 }
 
@@ -1,6 +1,7 @@
 ﻿#include "DaeVertexWeightsParser.h"
 #include "DaeParserErrors.h"
 #include "DaeSchema.h"
+#include "Geometries/MeshOptimizer.h"
 #include <cassert>
 #include <sstream>
 
@@ -117,6 +118,13 @@ void DaeVertexWeightsParser::pushSplitedVertexIndex(unsigned index)
     m_splitedVertexWeights.push_back(m_vertexWeights[index * MAX_WEIGHT_COUNT + 3]);
 }
 
+void DaeVertexWeightsParser::remapSplitedVertices(const std::vector<unsigned>& remap, unsigned new_vertex_count)
+{
+    using Enigma::Geometries::MeshOptimizer;
+    m_splitedWeightIndices = MeshOptimizer::remapVertices(m_splitedWeightIndices, remap, new_vertex_count);
+    m_splitedVertexWeights = MeshOptimizer::remapVertices(m_splitedVertexWeights, remap, new_vertex_count, MAX_WEIGHT_COUNT);
+}
+
 std::error_code DaeVertexWeightsParser::parseJointNameSource(const pugi::xml_node& bone_names_xml)
 {
     pugi::xml_node name_array_xml = bone_names_xml.child(TOKEN_NAME_ARRAY);
@@ -24,6 +24,8 @@ namespace EnigmaViewer
 
         void clearSplitedVertexWeights();
         void pushSplitedVertexIndex(unsigned index);
+        /** mesh 最佳化後, 依 remap (舊 vertex -> 新 vertex) 重排 splited weights */
+        void remapSplitedVertices(const std::vector<unsigned>& remap, unsigned new_vertex_count);
 
         [[nodiscard]] const std::vector<std::string>& getSkinBoneNames() const { return m_skinBoneNames; }
         [[nodiscard]] const std::vector<unsigned int>& getSplitedWeightIndices() const { return m_splitedWeightIndices; }
@@ -50,8 +50,6 @@ const std::string ALPHA_TEXTURE_SEMANTIC = "AlphaLayer";
 TerrainEditService::TerrainEditService(ServiceManager* srv_mngr, const std::shared_ptr<Enigma::FileStorage::TextureFileStoreMapper>& texture_file_store_mapper) : ISystemService(srv_mngr), m_textureFileStoreMapper(texture_file_store_mapper)
 {
     m_isHeightMapDirty = false;
-    m_dirtyVtxMaxIndex = std::numeric_limits<unsigned int>::min();
-    m_dirtyVtxMinIndex = std::numeric_limits<unsigned int>::max();
     m_dirtyAlphaRect.Left() = std::numeric_limits<int>::max();
     m_dirtyAlphaRect.Right() = std::numeric_limits<int>::min();
     m_dirtyAlphaRect.Top() = std::numeric_limits<int>::max();
@@ -175,9 +173,17 @@ void TerrainEditService::moveUpTerrainVertex(const std::shared_ptr<TerrainGeomet
     auto [cell_x, cell_z] = terrain_geometry->locateCell(local_pick_pos);
 
     terrain_geometry->changeHeight(cell_x, cell_z, terrain_geometry->getHeight(cell_x, cell_z) + height);
-    auto vtx_idx = terrain_geometry->convertVertexIndex(cell_x, cell_z);
-    if (m_dirtyVtxMinIndex > vtx_idx) m_dirtyVtxMinIndex = vtx_idx;
-    if (m_dirtyVtxMaxIndex < vtx_idx) m_dirtyVtxMaxIndex = vtx_idx;
+    if (!m_dirtyVtxRect)
+    {
+        m_dirtyVtxRect = TerrainGeometry::VertexRect{ cell_x, cell_z, cell_x, cell_z };
+    }
+    else
+    {
+        if (m_dirtyVtxRect->m_minX > cell_x) m_dirtyVtxRect->m_minX = cell_x;
+        if (m_dirtyVtxRect->m_minZ > cell_z) m_dirtyVtxRect->m_minZ = cell_z;
+        if (m_dirtyVtxRect->m_maxX < cell_x) m_dirtyVtxRect->m_maxX = cell_x;
+        if (m_dirtyVtxRect->m_maxZ < cell_z) m_dirtyVtxRect->m_maxZ = cell_z;
+    }
 }
 
 void TerrainEditService::commitHeightMapUpdated(const std::shared_ptr<TerrainPrimitive>& terrain_primitive,
@@ -186,13 +192,15 @@ void TerrainEditService::commitHeightMapUpdated(const std::shared_ptr<TerrainPri
     if (terrain_primitive == nullptr) return;
     if (terrain_geometry == nullptr) return;
 
-    if (m_dirtyVtxMaxIndex < m_dirtyVtxMinIndex) return;
+    if (!m_dirtyVtxRect) return;
 
-    terrain_geometry->rangedUpdateHeightMapToVertexMemory(m_dirtyVtxMinIndex, m_dirtyVtxMaxIndex - m_dirtyVtxMinIndex + 1);
-    terrain_geometry->rangedUpdateVertexNormals(m_dirtyVtxMinIndex, m_dirtyVtxMaxIndex - m_dirtyVtxMinIndex + 1);
-    terrain_primitive->rangedUpdateRenderBuffer(m_dirtyVtxMinIndex, m_dirtyVtxMaxIndex - m_dirtyVtxMinIndex + 1, std::nullopt, std::nullopt);
-    m_dirtyVtxMaxIndex = std::numeric_limits<unsigned int>::min();
-    m_dirtyVtxMinIndex = std::numeric_limits<unsigned int>::max();
+    terrain_geometry->rectUpdateHeightMapToVertexMemory(m_dirtyVtxRect.value());
+    // 周圍一圈的 normal 也會變, render buffer 要更新到實際重算的範圍
+    const auto normal_rect = terrain_geometry->rectUpdateVertexNormals(m_dirtyVtxRect.value());
+    const unsigned first_vtx = terrain_geometry->convertVertexIndex(normal_rect.m_minX, normal_rect.m_minZ);
+    const unsigned last_vtx = terrain_geometry->convertVertexIndex(normal_rect.m_maxX, normal_rect.m_maxZ);
+    terrain_primitive->rangedUpdateRenderBuffer(first_vtx, last_vtx - first_vtx + 1, std::nullopt, std::nullopt);
+    m_dirtyVtxRect = std::nullopt;
 }
 
 void TerrainEditService::paintTerrainLayerByBrush(const Vector3& brush_pos, float brush_size, unsigned layer_idx, float density)
@@ -17,6 +17,7 @@
 #include "Terrain/TerrainPrimitive.h"
 #include "MathLib/Rect.h"
 #include "FileSystem/IFile.h"
+#include <optional>
 
 namespace LevelEditor
 {
@@ -92,8 +93,7 @@ namespace LevelEditor
         std::string m_terrainPathId;
 
         bool m_isHeightMapDirty;
-        unsigned m_dirtyVtxMinIndex;
-        unsigned m_dirtyVtxMaxIndex;
+        std::optional<Enigma::Terrain::TerrainGeometry::VertexRect> m_dirtyVtxRect;
         byte_buffer m_alphaTexels;
         Enigma::MathLib::Rect m_alphaRect;
         Enigma::Frameworks::Ruid m_retrieveTextureImageRuid;
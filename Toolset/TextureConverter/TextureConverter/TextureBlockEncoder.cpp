@@ -0,0 +1,412 @@
+﻿#include "TextureBlockEncoder.h"
+#include "GraphicKernel/TextureContainer.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+
+using namespace Enigma::Graphics;
+using namespace Enigma::MathLib;
+
+// block 像素是 row-major, index = y * 4 + x
+static constexpr unsigned BLOCK_PIXELS = 16;
+
+static const int ETC_MODIFIERS[8][4] =
+{
+    { 2, 8, -2, -8 }, { 5, 17, -5, -17 }, { 9, 29, -9, -29 }, { 13, 42, -13, -42 },
+    { 18, 60, -18, -60 }, { 24, 80, -24, -80 }, { 33, 106, -33, -106 }, { 47, 183, -47, -183 },
+};
+
+static const int EAC_MODIFIERS[16][8] =
+{
+    { -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 }, { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 }, { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 }, { -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 }, { -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 },
+};
+
+static int clampByte(int v)
+{
+    return std::clamp(v, 0, 255);
+}
+
+static int colorDistance(const int a[3], const int b[3])
+{
+    const int dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+    return dr * dr + dg * dg + db * db;
+}
+
+static void writeBigEndian64(std::uint64_t bits, unsigned char* out)
+{
+    for (unsigned i = 0; i < 8; i++)
+    {
+        out[i] = static_cast<unsigned char>(bits >> (56 - i * 8));
+    }
+}
+
+//------------------------------- BC1 / BC3 -------------------------------
+static std::uint16_t packRgb565(const int rgb[3])
+{
+    return static_cast<std::uint16_t>(((rgb[0] * 31 + 127) / 255 << 11) | ((rgb[1] * 63 + 127) / 255 << 5) | ((rgb[2] * 31 + 127) / 255));
+}
+
+static void unpackRgb565(std::uint16_t c, int rgb[3])
+{
+    const int r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+void TextureBlockEncoder::encodeBC1Block(const unsigned char block_rgba[64], unsigned char* out)
+{
+    // bounding box 兩端往內縮 1/16, 減少極端值造成的誤差
+    int min_rgb[3] = { 255, 255, 255 }, max_rgb[3] = { 0, 0, 0 };
+    for (unsigned i = 0; i < BLOCK_PIXELS; i++)
+    {
+        for (unsigned c = 0; c < 3; c++)
+        {
+            min_rgb[c] = std::min<int>(min_rgb[c], block_rgba[i * 4 + c]);
+            max_rgb[c] = std::max<int>(max_rgb[c], block_rgba[i * 4 + c]);
+        }
+    }
+    for (unsigned c = 0; c < 3; c++)
+    {
+        const int inset = (max_rgb[c] - min_rgb[c]) / 16;
+        min_rgb[c] += inset;
+        max_rgb[c] -= inset;
+    }
+    // bounding box 有四條對角線, 以 green 為準看 red / blue 是正相關還是負相關, 負相關就對調兩端
+    int cov_rg = 0, cov_bg = 0;
+    for (unsigned i = 0; i < BLOCK_PIXELS; i++)
+    {
+        const int g = block_rgba[i * 4 + 1] * 2 - (min_rgb[1] + max_rgb[1]);
+        cov_rg += (block_rgba[i * 4] * 2 - (min_rgb[0] + max_rgb[0])) * g;
+        cov_bg += (block_rgba[i * 4 + 2] * 2 - (min_rgb[2] + max_rgb[2])) * g;
+    }
+    if (cov_rg < 0) std::swap(min_rgb[0], max_rgb[0]);
+    if (cov_bg < 0) std::swap(min_rgb[2], max_rgb[2]);
+    std::uint16_t c0 = packRgb565(max_rgb);
+    std::uint16_t c1 = packRgb565(min_rgb);
+    if (c0 < c1) std::swap(c0, c1);
+
+    std::uint32_t indices = 0;
+    if (c0 != c1)
+    {
+        // c0 > c1 : 4 色模式, palette 0, 1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+        int palette[4][3];
+        unpackRgb565(c0, palette[0]);
+        unpackRgb565(c1, palette[1]);
+        for (unsigned c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (unsigned i = 0; i < BLOCK_PIXELS; i++)
+        {
+            const int rgb[3] = { block_rgba[i * 4], block_rgba[i * 4 + 1], block_rgba[i * 4 + 2] };
+            unsigned best = 0;
+            int best_distance = INT_MAX;
+            for (unsigned p = 0; p < 4; p++)
+            {
+                const int distance = colorDistance(rgb, palette[p]);
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+    out[0] = static_cast<unsigned char>(c0 & 0xff);
+    out[1] = static_cast<unsigned char>(c0 >> 8);
+    out[2] = static_cast<unsigned char>(c1 & 0xff);
+    out[3] = static_cast<unsigned char>(c1 >> 8);
+    memcpy(out + 4, &indices, sizeof(indices));
+}
+
+void TextureBlockEncoder::encodeBC3Block(const unsigned char block_rgba[64], unsigned char* out)
+{
+    int a0 = 0, a1 = 255;
+    for (unsigned i = 0; i < BLOCK_PIXELS; i++)
+    {
+        a0 = std::max<int>(a0, block_rgba[i * 4 + 3]);
+        a1 = std::min<int>(a1, block_rgba[i * 4 + 3]);
+    }
+    std::uint64_t indices = 0;
+    if (a0 != a1)
+    {
+        // a0 > a1 : 8 階模式, index 0, 1 是兩端, 2~7 是內插
+        int palette[8] = { a0, a1 };
+        for (int k = 1; k <= 6; k++)
+        {
+            palette[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+        }
+        for (unsigned i = 0; i < BLOCK_PIXELS; i++)
+        {
+            const int alpha = block_rgba[i * 4 + 3];
+            std::uint64_t best = 0;
+            int best_distance = INT_MAX;
+            for (unsigned p = 0; p < 8; p++)
+            {
+                const int distance = std::abs(alpha - palette[p]);
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 3);
+        }
+    }
+    out[0] = static_cast<unsigned char>(a0);
+    out[1] = static_cast<unsigned char>(a1);
+    for (unsigned i = 0; i < 6; i++)
+    {
+        out[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+    }
+    encodeBC1Block(block_rgba, out + 8);
+}
+
+//------------------------------- ETC2 -------------------------------
+struct EtcSubBlockFit
+{
+    unsigned m_table = 0;
+    unsigned m_indices[8] = {};
+    int m_error = INT_MAX;
+};
+
+/** pixel_ids : 子區塊 8 個像素在 block 中的 index */
+static EtcSubBlockFit fitEtcSubBlock(const unsigned char block_rgba[64], const unsigned pixel_ids[8], const int base[3])
+{
+    EtcSubBlockFit best_fit;
+    for (unsigned table = 0; table < 8; table++)
+    {
+        EtcSubBlockFit fit;
+        fit.m_table = table;
+        fit.m_error = 0;
+        for (unsigned i = 0; i < 8; i++)
+        {
+            const unsigned char* px = &block_rgba[pixel_ids[i] * 4];
+            const int rgb[3] = { px[0], px[1], px[2] };
+            int best_distance = INT_MAX;
+            for (unsigned m = 0; m < 4; m++)
+            {
+                const int modifier = ETC_MODIFIERS[table][m];
+                const int candidate[3] = { clampByte(base[0] + modifier), clampByte(base[1] + modifier), clampByte(base[2] + modifier) };
+                const int distance = colorDistance(rgb, candidate);
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    fit.m_indices[i] = m;
+                }
+            }
+            fit.m_error += best_distance;
+        }
+        if (fit.m_error < best_fit.m_error) best_fit = fit;
+    }
+    return best_fit;
+}
+
+static void averageSubBlock(const unsigned char block_rgba[64], const unsigned pixel_ids[8], int avg[3])
+{
+    int sum[3] = { 0, 0, 0 };
+    for (unsigned i = 0; i < 8; i++)
+    {
+        for (unsigned c = 0; c < 3; c++) sum[c] += block_rgba[pixel_ids[i] * 4 + c];
+    }
+    for (unsigned c = 0; c < 3; c++) avg[c] = (sum[c] + 4) / 8;
+}
+
+/** 只用 ETC1 相容的 individual/differential 模式; differential 的和不會溢位, 所以不會被解讀成 ETC2 的 T/H/planar 模式 */
+static std::uint64_t encodeEtcBlock(const unsigned char block_rgba[64], int& total_error)
+{
+    std::uint64_t best_bits = 0;
+    total_error = INT_MAX;
+    for (unsigned flip = 0; flip < 2; flip++)
+    {
+        unsigned pixel_ids[2][8];
+        unsigned counts[2] = { 0, 0 };
+        for (unsigned y = 0; y < 4; y++)
+        {
+            for (unsigned x = 0; x < 4; x++)
+            {
+                const unsigned sub = flip ? (y >= 2) : (x >= 2);
+                pixel_ids[sub][counts[sub]++] = y * 4 + x;
+            }
+        }
+        int avg[2][3];
+        averageSubBlock(block_rgba, pixel_ids[0], avg[0]);
+        averageSubBlock(block_rgba, pixel_ids[1], avg[1]);
+
+        int q5[2][3];
+        bool is_differential = true;
+        for (unsigned c = 0; c < 3; c++)
+        {
+            q5[0][c] = (avg[0][c] * 31 + 127) / 255;
+            q5[1][c] = (avg[1][c] * 31 + 127) / 255;
+            const int diff = q5[1][c] - q5[0][c];
+            if ((diff < -4) || (diff > 3)) is_differential = false;
+        }
+        int base[2][3];
+        std::uint64_t bits = 0;
+        if (is_differential)
+        {
+            for (unsigned c = 0; c < 3; c++)
+            {
+                base[0][c] = (q5[0][c] << 3) | (q5[0][c] >> 2);
+                base[1][c] = (q5[1][c] << 3) | (q5[1][c] >> 2);
+                const std::uint64_t diff = static_cast<std::uint64_t>(q5[1][c] - q5[0][c]) & 0x7;
+                bits |= static_cast<std::uint64_t>(q5[0][c]) << (59 - c * 8);
+                bits |= diff << (56 - c * 8);
+            }
+            bits |= 1ull << 33;
+        }
+        else
+        {
+            for (unsigned c = 0; c < 3; c++)
+            {
+                const int q0 = (avg[0][c] * 15 + 127) / 255;
+                const int q1 = (avg[1][c] * 15 + 127) / 255;
+                base[0][c] = (q0 << 4) | q0;
+                base[1][c] = (q1 << 4) | q1;
+                bits |= static_cast<std::uint64_t>(q0) << (60 - c * 8);
+                bits |= static_cast<std::uint64_t>(q1) << (56 - c * 8);
+            }
+        }
+        bits |= static_cast<std::uint64_t>(flip) << 32;
+
+        int error = 0;
+        for (unsigned sub = 0; sub < 2; sub++)
+        {
+            const EtcSubBlockFit fit = fitEtcSubBlock(block_rgba, pixel_ids[sub], base[sub]);
+            error += fit.m_error;
+            bits |= static_cast<std::uint64_t>(fit.m_table) << (sub == 0 ? 37 : 34);
+            for (unsigned i = 0; i < 8; i++)
+            {
+                // pixel index 是 column-major : x * 4 + y, msb 在 bit 16 之後, lsb 在 bit 0 之後
+                const unsigned id = pixel_ids[sub][i];
+                const unsigned j = (id % 4) * 4 + id / 4;
+                bits |= static_cast<std::uint64_t>(fit.m_indices[i] >> 1) << (16 + j);
+                bits |= static_cast<std::uint64_t>(fit.m_indices[i] & 1) << j;
+            }
+        }
+        if (error < total_error)
+        {
+            total_error = error;
+            best_bits = bits;
+        }
+    }
+    return best_bits;
+}
+
+void TextureBlockEncoder::encodeEtc2RgbBlock(const unsigned char block_rgba[64], unsigned char* out)
+{
+    int error;
+    writeBigEndian64(encodeEtcBlock(block_rgba, error), out);
+}
+
+void TextureBlockEncoder::encodeEtc2RgbaBlock(const unsigned char block_rgba[64], unsigned char* out)
+{
+    // EAC alpha : base + modifier * multiplier, 窮舉 16 個 table 跟 multiplier
+    int min_alpha = 255, max_alpha = 0;
+    for (unsigned i = 0; i < BLOCK_PIXELS; i++)
+    {
+        min_alpha = std::min<int>(min_alpha, block_rgba[i * 4 + 3]);
+        max_alpha = std::max<int>(max_alpha, block_rgba[i * 4 + 3]);
+    }
+    const int base = (min_alpha + max_alpha + 1) / 2;
+    int best_error = INT_MAX;
+    unsigned best_table = 0, best_multiplier = 1;
+    unsigned best_indices[BLOCK_PIXELS] = {};
+    for (unsigned table = 0; (table < 16) && (best_error > 0); table++)
+    {
+        for (unsigned multiplier = 1; multiplier < 16; multiplier++)
+        {
+            int error = 0;
+            unsigned indices[BLOCK_PIXELS];
+            for (unsigned i = 0; (i < BLOCK_PIXELS) && (error < best_error); i++)
+            {
+                const int alpha = block_rgba[i * 4 + 3];
+                int best_distance = INT_MAX;
+                for (unsigned m = 0; m < 8; m++)
+                {
+                    const int distance = std::abs(alpha - clampByte(base + EAC_MODIFIERS[table][m] * static_cast<int>(multiplier)));
+                    if (distance < best_distance)
+                    {
+                        best_distance = distance;
+                        indices[i] = m;
+                    }
+                }
+                error += best_distance * best_distance;
+            }
+            if (error < best_error)
+            {
+                best_error = error;
+                best_table = table;
+                best_multiplier = multiplier;
+                std::copy(std::begin(indices), std::end(indices), std::begin(best_indices));
+            }
+        }
+    }
+    std::uint64_t bits = static_cast<std::uint64_t>(base) << 56;
+    bits |= static_cast<std::uint64_t>(best_multiplier) << 52;
+    bits |= static_cast<std::uint64_t>(best_table) << 48;
+    for (unsigned x = 0; x < 4; x++)
+    {
+        for (unsigned y = 0; y < 4; y++)
+        {
+            const unsigned j = x * 4 + y;
+            bits |= static_cast<std::uint64_t>(best_indices[y * 4 + x]) << (45 - j * 3);
+        }
+    }
+    writeBigEndian64(bits, out);
+    encodeEtc2RgbBlock(block_rgba, out + 8);
+}
+
+//------------------------------- image -------------------------------
+byte_buffer TextureBlockEncoder::encode(const GraphicFormat& fmt, const Dimension<unsigned>& dimension, const byte_buffer& rgba_pixels)
+{
+    const unsigned block_bytes = TextureContainer::blockBytes(fmt);
+    if ((block_bytes == 0) || (rgba_pixels.size() != static_cast<size_t>(dimension.m_width) * dimension.m_height * 4)) return {};
+    void (*encode_block)(const unsigned char*, unsigned char*) = nullptr;
+    switch (fmt.fmt)
+    {
+    case GraphicFormat::FMT_DXT1: encode_block = &encodeBC1Block; break;
+    case GraphicFormat::FMT_DXT5: encode_block = &encodeBC3Block; break;
+    case GraphicFormat::FMT_ETC2_RGB8: encode_block = &encodeEtc2RgbBlock; break;
+    case GraphicFormat::FMT_ETC2_RGBA8: encode_block = &encodeEtc2RgbaBlock; break;
+    default: return {};
+    }
+    const unsigned blocks_x = (dimension.m_width + 3) / 4;
+    const unsigned blocks_y = (dimension.m_height + 3) / 4;
+    byte_buffer blocks(static_cast<size_t>(blocks_x) * blocks_y * block_bytes);
+    unsigned char block_rgba[64];
+    for (unsigned by = 0; by < blocks_y; by++)
+    {
+        for (unsigned bx = 0; bx < blocks_x; bx++)
+        {
+            for (unsigned y = 0; y < 4; y++)
+            {
+                const unsigned sy = std::min(by * 4 + y, dimension.m_height - 1);
+                for (unsigned x = 0; x < 4; x++)
+                {
+                    const unsigned sx = std::min(bx * 4 + x, dimension.m_width - 1);
+                    memcpy(&block_rgba[(y * 4 + x) * 4], &rgba_pixels[(static_cast<size_t>(sy) * dimension.m_width + sx) * 4], 4);
+                }
+            }
+            encode_block(block_rgba, &blocks[(static_cast<size_t>(by) * blocks_x + bx) * block_bytes]);
+        }
+    }
+    return blocks;
+}
+
+bool TextureBlockEncoder::hasAlpha(const byte_buffer& rgba_pixels)
+{
+    for (size_t i = 3; i < rgba_pixels.size(); i += 4)
+    {
+        if (rgba_pixels[i] != 255) return true;
+    }
+    return false;
+}
@@ -0,0 +1,31 @@
+﻿/*********************************************************************
+ * \file   TextureBlockEncoder.h
+ * \brief  offline 4x4 block compressors (BC1/BC3/ETC2) for texture container payloads
+ *
+ * \author Lancelot 'Robin' Chen
+ * \date   October 2026
+ *********************************************************************/
+#ifndef TEXTURE_BLOCK_ENCODER_H
+#define TEXTURE_BLOCK_ENCODER_H
+
+#include "GraphicKernel/GraphicAPITypes.h"
+#include "MathLib/AlgebraBasicTypes.h"
+#include "Frameworks/ExtentTypesDefine.h"
+
+/** 輸入都是 RGBA8 像素, 不是 4 倍數的邊用邊緣像素補齊.
+ *  encoder 求的是轉檔速度跟品質的平衡 (bounding box / 窮舉 table), 不是最佳品質 */
+class TextureBlockEncoder
+{
+public:
+    /** fmt : FMT_DXT1, FMT_DXT5, FMT_ETC2_RGB8, FMT_ETC2_RGBA8 */
+    static byte_buffer encode(const Enigma::Graphics::GraphicFormat& fmt, const Enigma::MathLib::Dimension<unsigned>& dimension, const byte_buffer& rgba_pixels);
+
+    static void encodeBC1Block(const unsigned char block_rgba[64], unsigned char* out);
+    static void encodeBC3Block(const unsigned char block_rgba[64], unsigned char* out);
+    static void encodeEtc2RgbBlock(const unsigned char block_rgba[64], unsigned char* out);
+    static void encodeEtc2RgbaBlock(const unsigned char block_rgba[64], unsigned char* out);
+
+    static bool hasAlpha(const byte_buffer& rgba_pixels);
+};
+
+#endif // TEXTURE_BLOCK_ENCODER_H
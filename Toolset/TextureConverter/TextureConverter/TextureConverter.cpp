@@ -0,0 +1,240 @@
+﻿// TextureConverter.cpp : image (png/jpg/bmp...) -> texture container (.etex) 轉換工具, 以及 decode 時間的比較
+//
+// TextureConverter <image> [output] [--no-bc] [--no-etc2] [--no-raw]
+//                                      預設輸出 <image 去掉副檔名>.etex, 包含完整 mip chain,
+//                                      payload : BC3/BC1 (dx11), ETC2 RGBA8/RGB8 (gles), raw RGBA8 (fallback)
+// TextureConverter --benchmark <dir> [n]   比較目錄下所有 png 的 decode 時間跟 container parse 時間, 重複 n 次
+
+#include "TextureBlockEncoder.h"
+#include "GraphicKernel/TextureContainer.h"
+#include "GameEngine/TextureMipChain.h"
+#include <windows.h>
+#include <wincodec.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <optional>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Enigma::Graphics;
+using namespace Enigma::MathLib;
+namespace stdfs = std::filesystem;
+
+using clock_type = std::chrono::high_resolution_clock;
+using milliseconds_float = std::chrono::duration<float, std::milli>;
+
+struct ConvertOptions
+{
+    bool m_hasBlockCompressed = true;
+    bool m_hasEtc2 = true;
+    bool m_hasRaw = true;
+};
+
+static std::optional<byte_buffer> readContent(const stdfs::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return std::nullopt;
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    const std::string content = ss.str();
+    return byte_buffer(content.begin(), content.end());
+}
+
+static bool writeContent(const stdfs::path& path, const byte_buffer& content)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+    return file.good();
+}
+
+/** 用 WIC decode 成 RGBA8, 跟 dx11 device 載入 png 的路徑相同 */
+static std::optional<byte_buffer> decodeImage(const byte_buffer& content, Dimension<unsigned>& dimension)
+{
+    static IWICImagingFactory* factory = nullptr;
+    if (!factory)
+    {
+        if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory)))) return std::nullopt;
+    }
+    IWICStream* stream = nullptr;
+    IWICBitmapDecoder* decoder = nullptr;
+    IWICBitmapFrameDecode* frame = nullptr;
+    IWICFormatConverter* converter = nullptr;
+    std::optional<byte_buffer> pixels;
+    UINT width = 0, height = 0;
+    if ((SUCCEEDED(factory->CreateStream(&stream)))
+        && (SUCCEEDED(stream->InitializeFromMemory(const_cast<BYTE*>(content.data()), static_cast<DWORD>(content.size()))))
+        && (SUCCEEDED(factory->CreateDecoderFromStream(stream, nullptr, WICDecodeMetadataCacheOnDemand, &decoder)))
+        && (SUCCEEDED(decoder->GetFrame(0, &frame)))
+        && (SUCCEEDED(factory->CreateFormatConverter(&converter)))
+        && (SUCCEEDED(converter->Initialize(frame, GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom)))
+        && (SUCCEEDED(converter->GetSize(&width, &height))))
+    {
+        byte_buffer buff(static_cast<size_t>(width) * height * 4);
+        if (SUCCEEDED(converter->CopyPixels(nullptr, width * 4, static_cast<UINT>(buff.size()), buff.data())))
+        {
+            dimension = { width, height };
+            pixels = std::move(buff);
+        }
+    }
+    if (converter) converter->Release();
+    if (frame) frame->Release();
+    if (decoder) decoder->Release();
+    if (stream) stream->Release();
+    return pixels;
+}
+
+static byte_buffer buildContainer(const Dimension<unsigned>& dimension, byte_buffer&& rgba_pixels, const ConvertOptions& options)
+{
+    const bool has_alpha = TextureBlockEncoder::hasAlpha(rgba_pixels);
+    const Enigma::Engine::TextureMipChain chain(dimension, std::move(rgba_pixels));
+    std::vector<GraphicFormat> formats;
+    if (options.m_hasBlockCompressed) formats.emplace_back(has_alpha ? GraphicFormat::FMT_DXT5 : GraphicFormat::FMT_DXT1);
+    if (options.m_hasEtc2) formats.emplace_back(has_alpha ? GraphicFormat::FMT_ETC2_RGBA8 : GraphicFormat::FMT_ETC2_RGB8);
+    if (options.m_hasRaw) formats.emplace_back(GraphicFormat::FMT_A8B8G8R8);
+
+    std::vector<TextureContainer::PayloadSource> payloads;
+    for (const auto& fmt : formats)
+    {
+        TextureContainer::PayloadSource payload{ fmt, {} };
+        for (unsigned i = 0; i < chain.levelCount(); i++)
+        {
+            const auto& level = chain.level(i);
+            payload.m_levels.emplace_back(TextureContainer::isBlockCompressed(fmt) ? TextureBlockEncoder::encode(fmt, level.m_dimension, level.m_pixels) : level.m_pixels);
+        }
+        payloads.emplace_back(std::move(payload));
+    }
+    return TextureContainer::serialize(dimension, has_alpha, payloads);
+}
+
+static int convertFile(const stdfs::path& input, const stdfs::path& output, const ConvertOptions& options)
+{
+    auto content = readContent(input);
+    if (!content)
+    {
+        std::cout << "read " << input << " fail" << std::endl;
+        return -1;
+    }
+    Dimension<unsigned> dimension{ 0, 0 };
+    auto pixels = decodeImage(content.value(), dimension);
+    if (!pixels)
+    {
+        std::cout << input << " decode image fail" << std::endl;
+        return -1;
+    }
+    auto time_point = clock_type::now();
+    byte_buffer container = buildContainer(dimension, std::move(pixels.value()), options);
+    const float encode_ms = milliseconds_float(clock_type::now() - time_point).count();
+    if (container.empty())
+    {
+        std::cout << input << " build container fail" << std::endl;
+        return -1;
+    }
+    if (!writeContent(output, container))
+    {
+        std::cout << "write " << output << " fail" << std::endl;
+        return -1;
+    }
+    std::cout << input << " (" << dimension.m_width << "x" << dimension.m_height << ", " << content->size() << " bytes) -> "
+        << output << " (" << container.size() << " bytes, " << encode_ms << " ms)" << std::endl;
+    return 0;
+}
+
+static int benchmark(const stdfs::path& dir, unsigned repeat)
+{
+    std::vector<std::pair<stdfs::path, byte_buffer>> images;
+    std::vector<byte_buffer> containers;
+    for (const auto& entry : stdfs::recursive_directory_iterator(dir))
+    {
+        if ((!entry.is_regular_file()) || (entry.path().extension() != ".png")) continue;
+        auto content = readContent(entry.path());
+        if (!content) continue;
+        Dimension<unsigned> dimension{ 0, 0 };
+        auto pixels = decodeImage(content.value(), dimension);
+        if (!pixels) continue;
+        containers.emplace_back(buildContainer(dimension, std::move(pixels.value()), ConvertOptions{}));
+        images.emplace_back(entry.path(), std::move(content.value()));
+    }
+    if (images.empty())
+    {
+        std::cout << "no png in " << dir << std::endl;
+        return -1;
+    }
+
+    float png_ms = 0.0f;
+    float container_ms = 0.0f;
+    size_t png_bytes = 0;
+    size_t container_bytes = 0;
+    for (unsigned r = 0; r < repeat; r++)
+    {
+        for (size_t i = 0; i < images.size(); i++)
+        {
+            auto time_point = clock_type::now();
+            Dimension<unsigned> dimension{ 0, 0 };
+            auto pixels = decodeImage(images[i].second, dimension);
+            png_ms += milliseconds_float(clock_type::now() - time_point).count();
+
+            // container 只要 parse level table, 上傳時直接用 buffer 內的 level data
+            time_point = clock_type::now();
+            TextureContainer::Header header;
+            std::vector<TextureContainer::PayloadView> payloads;
+            const auto er = TextureContainer::parse(containers[i].data(), containers[i].size(), header, payloads);
+            const auto* payload = er ? nullptr : TextureContainer::selectPayload(payloads, { GraphicFormat::FMT_DXT5, GraphicFormat::FMT_DXT1 });
+            container_ms += milliseconds_float(clock_type::now() - time_point).count();
+            if ((!pixels) || (!payload))
+            {
+                std::cout << images[i].first << " benchmark fail" << std::endl;
+                return -1;
+            }
+            if (r == 0)
+            {
+                png_bytes += images[i].second.size();
+                container_bytes += containers[i].size();
+            }
+        }
+    }
+    std::cout << images.size() << " images, " << repeat << " times" << std::endl;
+    std::cout << "png decode : " << png_ms << " ms, " << png_bytes << " bytes" << std::endl;
+    std::cout << "container  : " << container_ms << " ms, " << container_bytes << " bytes (with mips, all payloads)" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "usage : TextureConverter <image> [output] [--no-bc] [--no-etc2] [--no-raw]" << std::endl;
+        std::cout << "        TextureConverter --benchmark <dir> [n]" << std::endl;
+        return -1;
+    }
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    const std::string command = argv[1];
+    if (command == "--benchmark")
+    {
+        if (argc < 3) return -1;
+        const unsigned repeat = argc > 3 ? static_cast<unsigned>(std::max(1, std::atoi(argv[3]))) : 10;
+        return benchmark(argv[2], repeat);
+    }
+
+    ConvertOptions options;
+    std::vector<stdfs::path> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--no-bc") options.m_hasBlockCompressed = false;
+        else if (arg == "--no-etc2") options.m_hasEtc2 = false;
+        else if (arg == "--no-raw") options.m_hasRaw = false;
+        else paths.emplace_back(arg);
+    }
+    if ((paths.empty()) || ((!options.m_hasBlockCompressed) && (!options.m_hasEtc2) && (!options.m_hasRaw)))
+    {
+        std::cout << "nothing to convert" << std::endl;
+        return -1;
+    }
+    const stdfs::path output = paths.size() > 1 ? paths[1] : stdfs::path(paths[0]).replace_extension(TextureContainer::FILE_EXTENSION);
+    return convertFile(paths[0], output, options);
+}